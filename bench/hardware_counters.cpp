@@ -0,0 +1,49 @@
+/**
+ * @file hardware_counters.cpp
+ * @brief Implementation of hardware counters around benchmark loops
+ */
+
+#include "hardware_counters.h"
+#include <cstdlib>
+#include <cstring>
+
+namespace suzume {
+namespace bench {
+
+namespace {
+
+bool countersRequested() {
+    const char* value = std::getenv("SUZUME_BENCH_COUNTERS");
+    return value != nullptr && std::strcmp(value, "1") == 0;
+}
+
+} // namespace
+
+HardwareCounterRegion::HardwareCounterRegion() {
+    if (countersRequested()) {
+        counters_ = std::make_unique<core::HardwareCounterSet>();
+        begin_ = counters_->read();
+    }
+}
+
+void HardwareCounterRegion::report(benchmark::State& state) {
+    if (!counters_) {
+        return;
+    }
+    HardwareCounters counts = core::hardwareCountersBetween(begin_, counters_->read());
+    counters_.reset();
+    if (!counts.available) {
+        return;
+    }
+    const auto perIteration = benchmark::Counter::kAvgIterations;
+    state.counters["cycles"] = benchmark::Counter(static_cast<double>(counts.cycles), perIteration);
+    state.counters["instructions"] = benchmark::Counter(static_cast<double>(counts.instructions), perIteration);
+    state.counters["cache_misses"] = benchmark::Counter(static_cast<double>(counts.cacheMisses), perIteration);
+    state.counters["branch_misses"] = benchmark::Counter(static_cast<double>(counts.branchMisses), perIteration);
+    state.counters["IPC"] = counts.ipc;
+    state.counters["cache_miss_rate"] = counts.cacheMissRate;
+    state.counters["branch_miss_rate"] = counts.branchMissRate;
+}
+
+} // namespace bench
+} // namespace suzume
@@ -0,0 +1,47 @@
+/**
+ * @file hardware_counters.h
+ * @brief Hardware counters around the timed loop of a benchmark
+ */
+
+#ifndef SUZUME_BENCH_HARDWARE_COUNTERS_H_
+#define SUZUME_BENCH_HARDWARE_COUNTERS_H_
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include "core/hardware_counters.h"
+
+namespace suzume {
+namespace bench {
+
+/**
+ * @brief Counts hardware events over the timed loop when SUZUME_BENCH_COUNTERS=1
+ *
+ * Create it right before the loop and call report() right after it; the
+ * counts then cover the iterations and little else. Reported as user
+ * counters next to the timings: cycles, instructions, cache_misses and
+ * branch_misses per iteration, and IPC, cache_miss_rate and
+ * branch_miss_rate. Without the environment variable, or where the kernel
+ * refuses perf events, nothing is opened and nothing is reported.
+ */
+class HardwareCounterRegion {
+public:
+    /**
+     * @brief Constructor; starts counting if enabled
+     */
+    HardwareCounterRegion();
+
+    /**
+     * @brief Stop counting and add the counts to the benchmark's counters
+     * @param state State of the benchmark
+     */
+    void report(benchmark::State& state);
+
+private:
+    std::unique_ptr<core::HardwareCounterSet> counters_;
+    HardwareCounters begin_;
+};
+
+} // namespace bench
+} // namespace suzume
+
+#endif // SUZUME_BENCH_HARDWARE_COUNTERS_H_
@@ -0,0 +1,234 @@
+#!/usr/bin/env node
+/**
+ * Reference-corpus performance regression test for suzume-feedmill
+ *
+ * Runs normalize, pmi and word-extract end to end on fixed-size reference
+ * corpora (Japanese and mixed-script), records the throughput and peak RSS
+ * of every step from --stats-json, and compares them with a stored
+ * baseline. A step fails when its throughput drops, or its peak RSS grows,
+ * by more than the tolerance. Without a baseline, or with --update-baseline,
+ * the measurements are written as the new baseline instead.
+ *
+ * Corpora are generated by suzume_feedmill_corpus and kept in the work
+ * directory, so later runs reuse them; --corpus LANG=PATH uses a fetched
+ * file instead of generating one. Baselines only compare on the machine
+ * and with the settings they were recorded with.
+ *
+ * Usage:
+ *   node perf_regression.js --cli PATH --corpus-tool PATH --work-dir DIR
+ *     [--baseline FILE] [--size-mb N] [--tolerance FRACTION] [--threads N]
+ *     [--corpus LANG=PATH]... [--update-baseline]
+ */
+
+const fs = require("fs");
+const os = require("os");
+const path = require("path");
+const { execFileSync } = require("child_process");
+
+const LANGUAGES = ["ja", "mixed"];
+
+function parseArguments(argv) {
+  const args = {
+    cli: null,
+    corpusTool: null,
+    workDir: null,
+    baseline: path.join(__dirname, "perf_baseline.json"),
+    sizeMb: 1024,
+    tolerance: 0.1,
+    threads: 0,
+    corpora: {},
+    updateBaseline: false,
+  };
+  for (let i = 2; i < argv.length; ++i) {
+    const flag = argv[i];
+    const value = () => {
+      if (i + 1 >= argv.length) {
+        throw new Error(`${flag} needs a value`);
+      }
+      return argv[++i];
+    };
+    switch (flag) {
+      case "--cli":
+        args.cli = value();
+        break;
+      case "--corpus-tool":
+        args.corpusTool = value();
+        break;
+      case "--work-dir":
+        args.workDir = value();
+        break;
+      case "--baseline":
+        args.baseline = value();
+        break;
+      case "--size-mb":
+        args.sizeMb = Number(value());
+        break;
+      case "--tolerance":
+        args.tolerance = Number(value());
+        break;
+      case "--threads":
+        args.threads = Number(value());
+        break;
+      case "--corpus": {
+        const [language, file] = value().split("=", 2);
+        if (!LANGUAGES.includes(language) || !file) {
+          throw new Error(`--corpus takes LANG=PATH with LANG one of ${LANGUAGES.join(", ")}`);
+        }
+        args.corpora[language] = file;
+        break;
+      }
+      case "--update-baseline":
+        args.updateBaseline = true;
+        break;
+      default:
+        throw new Error(`Unknown option: ${flag}`);
+    }
+  }
+  if (!args.cli || !args.workDir) {
+    throw new Error("--cli and --work-dir are required");
+  }
+  if (!(args.sizeMb > 0) || !(args.tolerance >= 0) || !(args.threads >= 0)) {
+    throw new Error("--size-mb must be positive, --tolerance and --threads must not be negative");
+  }
+  return args;
+}
+
+// Path of a reference corpus, generated on first use
+function referenceCorpus(args, language) {
+  if (args.corpora[language]) {
+    return args.corpora[language];
+  }
+  const file = path.join(args.workDir, `reference-${language}-${args.sizeMb}mb.txt`);
+  if (!fs.existsSync(file)) {
+    if (!args.corpusTool) {
+      throw new Error(`No ${language} corpus: pass --corpus-tool or --corpus ${language}=PATH`);
+    }
+    console.log(`Generating ${args.sizeMb} MB ${language} corpus...`);
+    const partial = `${file}.partial`;
+    execFileSync(args.corpusTool, [language, String(args.sizeMb), partial], { stdio: "inherit" });
+    fs.renameSync(partial, file);
+  }
+  return file;
+}
+
+// Run one command with --stats-json and return its statistics
+function runCommand(args, command, operands, options) {
+  const argv = [command, ...operands, ...options, "--progress", "none", "--stats-json"];
+  if (args.threads > 0) {
+    argv.push("--threads", String(args.threads));
+  }
+  const output = execFileSync(args.cli, argv, { encoding: "utf8", maxBuffer: 64 * 1024 * 1024 });
+  const lines = output.trim().split("\n");
+  return JSON.parse(lines[lines.length - 1]);
+}
+
+// Throughput over the text a step read, and its peak RSS
+function measurement(stats, inputPath) {
+  const bytes = fs.statSync(inputPath).size;
+  const seconds = Math.max(stats.metrics.elapsed_ms, 1) / 1000;
+  return {
+    mb_per_sec: bytes / (1024 * 1024) / seconds,
+    peak_rss_bytes: stats.memory.peak_resident_bytes,
+    elapsed_ms: stats.metrics.elapsed_ms,
+  };
+}
+
+function measure(args) {
+  const results = {};
+  for (const language of LANGUAGES) {
+    const corpus = referenceCorpus(args, language);
+    const normalized = path.join(args.workDir, `${language}-normalized.txt`);
+    const pmi = path.join(args.workDir, `${language}-pmi.tsv`);
+    const words = path.join(args.workDir, `${language}-words.tsv`);
+
+    console.log(`Running ${language} corpus...`);
+    results[`${language}/normalize`] = measurement(
+      runCommand(args, "normalize", [corpus, normalized], []), corpus);
+    results[`${language}/pmi`] = measurement(
+      runCommand(args, "pmi", [normalized, pmi], ["--n", "2", "--top", "10000"]), normalized);
+    results[`${language}/word-extract`] = measurement(
+      runCommand(args, "word-extract", [pmi, normalized, words], []), normalized);
+  }
+  return results;
+}
+
+function machine() {
+  const cpus = os.cpus();
+  return `${os.platform()} ${os.arch()}, ${cpus.length} x ${cpus.length > 0 ? cpus[0].model : "unknown"}`;
+}
+
+function formatMb(bytes) {
+  return `${(bytes / (1024 * 1024)).toFixed(1)} MB`;
+}
+
+// Compare with the baseline; returns the descriptions of the regressions
+function compare(args, baseline, results) {
+  const regressions = [];
+  for (const [step, current] of Object.entries(results)) {
+    const reference = baseline.results[step];
+    if (!reference) {
+      console.log(`${step}: not in the baseline`);
+      continue;
+    }
+    const minThroughput = reference.mb_per_sec * (1 - args.tolerance);
+    const maxRss = reference.peak_rss_bytes * (1 + args.tolerance);
+    const throughputChange = (current.mb_per_sec / reference.mb_per_sec - 1) * 100;
+    const rssChange = (current.peak_rss_bytes / reference.peak_rss_bytes - 1) * 100;
+    console.log(
+      `${step}: ${current.mb_per_sec.toFixed(2)} MB/s (${throughputChange.toFixed(1)}%), ` +
+        `peak RSS ${formatMb(current.peak_rss_bytes)} (${rssChange.toFixed(1)}%)`);
+    if (current.mb_per_sec < minThroughput) {
+      regressions.push(`${step}: throughput ${current.mb_per_sec.toFixed(2)} MB/s is below ` +
+        `${minThroughput.toFixed(2)} MB/s (baseline ${reference.mb_per_sec.toFixed(2)} MB/s)`);
+    }
+    if (current.peak_rss_bytes > maxRss) {
+      regressions.push(`${step}: peak RSS ${formatMb(current.peak_rss_bytes)} is above ` +
+        `${formatMb(maxRss)} (baseline ${formatMb(reference.peak_rss_bytes)})`);
+    }
+  }
+  return regressions;
+}
+
+function main() {
+  const args = parseArguments(process.argv);
+  fs.mkdirSync(args.workDir, { recursive: true });
+
+  const settings = { size_mb: args.sizeMb, threads: args.threads, machine: machine() };
+  const results = measure(args);
+  const report = { ...settings, results };
+  fs.writeFileSync(path.join(args.workDir, "perf_results.json"), JSON.stringify(report, null, 2) + "\n");
+
+  if (args.updateBaseline || !fs.existsSync(args.baseline)) {
+    fs.writeFileSync(args.baseline, JSON.stringify(report, null, 2) + "\n");
+    console.log(`Baseline written to ${args.baseline}`);
+    return 0;
+  }
+
+  const baseline = JSON.parse(fs.readFileSync(args.baseline, "utf8"));
+  if (baseline.size_mb !== settings.size_mb || baseline.threads !== settings.threads) {
+    console.error(`Error: The baseline was recorded with ${baseline.size_mb} MB corpora and ` +
+      `${baseline.threads} threads; rerun with the same settings or --update-baseline`);
+    return 1;
+  }
+  if (baseline.machine !== settings.machine) {
+    console.warn(`Warning: The baseline was recorded on ${baseline.machine}, not ${settings.machine}`);
+  }
+
+  const regressions = compare(args, baseline, results);
+  if (regressions.length > 0) {
+    console.error(`Performance regressions (tolerance ${(args.tolerance * 100).toFixed(0)}%):`);
+    for (const regression of regressions) {
+      console.error(`  ${regression}`);
+    }
+    return 1;
+  }
+  console.log("No performance regressions");
+  return 0;
+}
+
+try {
+  process.exitCode = main();
+} catch (e) {
+  console.error(`Error: ${e.message}`);
+  process.exitCode = 1;
+}
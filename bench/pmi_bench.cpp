@@ -0,0 +1,76 @@
+/**
+ * @file pmi_bench.cpp
+ * @brief Benchmarks of n-gram counting and PMI scoring
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <unordered_map>
+#include "core/packed_ngram.h"
+#include "core/pmi.h"
+#include "hardware_counters.h"
+#include "synthetic_corpus.h"
+
+namespace suzume {
+namespace bench {
+
+// Arguments: language, number of lines, n-gram size
+void BM_CountNgrams(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const std::string& text = corpusText(language, static_cast<size_t>(state.range(1)));
+    const auto n = static_cast<uint32_t>(state.range(2));
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(core::countNgrams(text, n));
+    }
+    counters.report(state);
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * text.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_CountNgrams)
+    ->ArgNames({"lang", "lines", "n"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}, {2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+// Arguments: language, number of lines, n-gram size
+void BM_CalculatePmiScores(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const std::string& text = corpusText(language, static_cast<size_t>(state.range(1)));
+    const auto n = static_cast<uint32_t>(state.range(2));
+    const std::unordered_map<std::string, uint32_t> counts = core::countNgrams(text, n);
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(core::calculatePmiScores(counts, n, 2));
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * counts.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_CalculatePmiScores)
+    ->ArgNames({"lang", "lines", "n"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}, {2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+// Scoring straight from the packed table the pipeline counts into, keeping the top K
+// Arguments: language, number of lines, n-gram size
+void BM_CalculatePmiScoresPacked(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const std::string& text = corpusText(language, static_cast<size_t>(state.range(1)));
+    const auto n = static_cast<uint32_t>(state.range(2));
+    core::PackedNgramCounter counts(n);
+    counts.addText(text);
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(core::calculatePmiScores(counts, 2, 2500));
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * counts.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_CalculatePmiScoresPacked)
+    ->ArgNames({"lang", "lines", "n"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}, {2, 3}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace bench
+} // namespace suzume
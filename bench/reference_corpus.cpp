@@ -0,0 +1,54 @@
+/**
+ * @file reference_corpus.cpp
+ * @brief Writes the fixed-size reference corpora of the performance regression test
+ *
+ * Usage: suzume_feedmill_corpus <ja|en|mixed> <megabytes> <output>
+ */
+
+#include "synthetic_corpus.h"
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+
+int main(int argc, char* argv[]) {
+    using suzume::bench::Language;
+
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <ja|en|mixed> <megabytes> <output>" << std::endl;
+        return 1;
+    }
+
+    const std::string name = argv[1];
+    Language language;
+    if (name == "ja") {
+        language = Language::Japanese;
+    } else if (name == "en") {
+        language = Language::English;
+    } else if (name == "mixed") {
+        language = Language::Mixed;
+    } else {
+        std::cerr << "Error: Unknown corpus language: " << name << std::endl;
+        return 1;
+    }
+
+    char* end = nullptr;
+    unsigned long long megabytes = std::strtoull(argv[2], &end, 10);
+    if (end == argv[2] || *end != '\0' || megabytes == 0) {
+        std::cerr << "Error: Invalid size: " << argv[2] << std::endl;
+        return 1;
+    }
+
+    std::ofstream out(argv[3], std::ios::binary | std::ios::trunc);
+    if (!out) {
+        std::cerr << "Error: Failed to open output file: " << argv[3] << std::endl;
+        return 1;
+    }
+    suzume::bench::writeCorpus(out, language, static_cast<uint64_t>(megabytes) * 1024 * 1024);
+    out.close();
+    if (!out) {
+        std::cerr << "Error: Failed to write output file: " << argv[3] << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,220 @@
+/**
+ * @file synthetic_corpus.cpp
+ * @brief Implementation of the synthetic corpora
+ */
+
+#include "synthetic_corpus.h"
+#include <map>
+#include <mutex>
+#include <random>
+#include <utility>
+
+namespace suzume {
+namespace bench {
+
+namespace {
+
+const std::vector<std::string> kJapaneseWords = {
+    "東京", "大阪", "京都", "人工知能", "機械学習", "自然言語処理", "研究", "開発", "技術", "データ",
+    "今日", "明日", "天気", "会議", "資料", "報告", "確認", "予定", "時間", "問題",
+    "スマートフォン", "アプリ", "サービス", "ユーザー", "コンピュータ", "ネットワーク", "クラウド", "セキュリティ",
+    "ＡＩ", "ＳＮＳ", "１２３", "ｶﾀｶﾅ", "深層学習", "形態素解析", "辞書", "単語", "文章", "言語",
+};
+
+const std::vector<std::string> kJapaneseParticles = {
+    "は", "が", "を", "に", "で", "と", "の", "も", "から", "まで", "です", "ます", "でした", "します",
+};
+
+const std::vector<std::string> kJapanesePunctuation = {"、", "。", "！", "？", "　"};
+
+const std::vector<std::string> kEnglishWords = {
+    "the", "of", "and", "to", "in", "is", "for", "that", "with", "on",
+    "Data", "model", "Learning", "machine", "language", "network", "cloud", "service", "user", "system",
+    "Tokyo", "Osaka", "research", "development", "technology", "report", "meeting", "schedule", "problem", "time",
+    "smartphone", "application", "security", "dictionary", "word", "sentence", "analysis", "ＦＵＬＬ", "café", "naïve",
+};
+
+const std::vector<std::string> kEnglishPunctuation = {",", ".", "!", "?", ";"};
+
+// Draws indices with probability proportional to 1 / (rank + 1)
+class ZipfDistribution {
+public:
+    explicit ZipfDistribution(size_t size) : cumulative_(size) {
+        double sum = 0.0;
+        for (size_t i = 0; i < size; ++i) {
+            sum += 1.0 / static_cast<double>(i + 1);
+            cumulative_[i] = sum;
+        }
+    }
+
+    size_t operator()(std::mt19937& rng) const {
+        std::uniform_real_distribution<double> uniform(0.0, cumulative_.back());
+        double x = uniform(rng);
+        size_t low = 0;
+        size_t high = cumulative_.size() - 1;
+        while (low < high) {
+            size_t mid = (low + high) / 2;
+            if (cumulative_[mid] < x) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low;
+    }
+
+private:
+    std::vector<double> cumulative_;
+};
+
+std::string japaneseLine(std::mt19937& rng, const ZipfDistribution& words) {
+    std::uniform_int_distribution<int> phrases(2, 6);
+    std::uniform_int_distribution<size_t> particle(0, kJapaneseParticles.size() - 1);
+    std::uniform_int_distribution<size_t> punctuation(0, kJapanesePunctuation.size() - 1);
+    std::string line;
+    int count = phrases(rng);
+    for (int i = 0; i < count; ++i) {
+        line += kJapaneseWords[words(rng)];
+        line += kJapaneseParticles[particle(rng)];
+        if (i + 1 < count && rng() % 3 == 0) {
+            line += kJapanesePunctuation[punctuation(rng)];
+        }
+    }
+    line += "。";
+    return line;
+}
+
+std::string englishLine(std::mt19937& rng, const ZipfDistribution& words) {
+    std::uniform_int_distribution<int> wordCount(4, 14);
+    std::uniform_int_distribution<size_t> punctuation(0, kEnglishPunctuation.size() - 1);
+    std::string line;
+    int count = wordCount(rng);
+    for (int i = 0; i < count; ++i) {
+        if (i > 0) {
+            line += rng() % 10 == 0 ? "  " : " ";
+        }
+        line += kEnglishWords[words(rng)];
+        if (i + 1 < count && rng() % 6 == 0) {
+            line += kEnglishPunctuation[punctuation(rng)];
+        }
+    }
+    line += ".";
+    return line;
+}
+
+// Japanese phrases where some words are Latin or numbers, as in product and tech text
+std::string mixedLine(std::mt19937& rng, const ZipfDistribution& japanese, const ZipfDistribution& english) {
+    std::uniform_int_distribution<int> phrases(2, 6);
+    std::uniform_int_distribution<size_t> particle(0, kJapaneseParticles.size() - 1);
+    std::string line;
+    int count = phrases(rng);
+    for (int i = 0; i < count; ++i) {
+        switch (rng() % 5) {
+            case 0:
+                line += kEnglishWords[english(rng)];
+                break;
+            case 1:
+                line += std::to_string(rng() % 2025);
+                break;
+            default:
+                line += kJapaneseWords[japanese(rng)];
+                break;
+        }
+        line += kJapaneseParticles[particle(rng)];
+    }
+    line += "。";
+    return line;
+}
+
+std::string nextLine(std::mt19937& rng, Language language) {
+    static const ZipfDistribution japanese(kJapaneseWords.size());
+    static const ZipfDistribution english(kEnglishWords.size());
+    switch (language) {
+        case Language::Japanese:
+            return japaneseLine(rng, japanese);
+        case Language::English:
+            return englishLine(rng, english);
+        case Language::Mixed:
+            return rng() % 4 == 0 ? englishLine(rng, english) : mixedLine(rng, japanese, english);
+    }
+    return std::string();
+}
+
+std::mutex g_corpusMutex;
+
+} // namespace
+
+const char* languageName(Language language) {
+    switch (language) {
+        case Language::Japanese: return "ja";
+        case Language::English: return "en";
+        case Language::Mixed: return "mixed";
+    }
+    return "unknown";
+}
+
+const std::vector<std::string>& corpusLines(Language language, size_t lines) {
+    static std::map<std::pair<int, size_t>, std::vector<std::string>> corpora;
+    std::lock_guard<std::mutex> lock(g_corpusMutex);
+    auto key = std::make_pair(static_cast<int>(language), lines);
+    auto found = corpora.find(key);
+    if (found != corpora.end()) {
+        return found->second;
+    }
+
+    // A fixed seed per corpus keeps runs comparable
+    std::mt19937 rng(static_cast<uint32_t>(lines * 2 + static_cast<size_t>(language)));
+    std::vector<std::string> result;
+    result.reserve(lines);
+    for (size_t i = 0; i < lines; ++i) {
+        result.push_back(nextLine(rng, language));
+    }
+    return corpora.emplace(key, std::move(result)).first->second;
+}
+
+const std::string& corpusText(Language language, size_t lines) {
+    static std::map<std::pair<int, size_t>, std::string> texts;
+    const std::vector<std::string>& source = corpusLines(language, lines);
+    std::lock_guard<std::mutex> lock(g_corpusMutex);
+    auto key = std::make_pair(static_cast<int>(language), lines);
+    auto found = texts.find(key);
+    if (found != texts.end()) {
+        return found->second;
+    }
+
+    std::string text;
+    for (const auto& line : source) {
+        text += line;
+        text += '\n';
+    }
+    return texts.emplace(key, std::move(text)).first->second;
+}
+
+uint64_t writeCorpus(std::ostream& out, Language language, uint64_t bytes) {
+    // Recent lines that get repeated, about one line in eight
+    constexpr size_t kRecentLines = 4096;
+    std::mt19937 rng(static_cast<uint32_t>(0x5eed + static_cast<size_t>(language)));
+    std::vector<std::string> recent;
+    recent.reserve(kRecentLines);
+    uint64_t written = 0;
+    while (written < bytes) {
+        std::string line;
+        if (!recent.empty() && rng() % 8 == 0) {
+            line = recent[rng() % recent.size()];
+        } else {
+            line = nextLine(rng, language);
+            if (recent.size() < kRecentLines) {
+                recent.push_back(line);
+            } else {
+                recent[rng() % kRecentLines] = line;
+            }
+        }
+        line += '\n';
+        out.write(line.data(), static_cast<std::streamsize>(line.size()));
+        written += line.size();
+    }
+    return written;
+}
+
+} // namespace bench
+} // namespace suzume
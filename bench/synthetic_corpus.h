@@ -0,0 +1,74 @@
+/**
+ * @file synthetic_corpus.h
+ * @brief Reproducible synthetic corpora for the benchmarks
+ */
+
+#ifndef SUZUME_BENCH_SYNTHETIC_CORPUS_H_
+#define SUZUME_BENCH_SYNTHETIC_CORPUS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace bench {
+
+/**
+ * @brief Language of a synthetic corpus
+ */
+enum class Language {
+    Japanese = 0,   ///< Kanji, kana and particles without spaces, some full-width forms
+    English = 1,    ///< Space-separated words, mixed case and punctuation
+    Mixed = 2       ///< Japanese sentences with Latin words and digits, interleaved with English lines
+};
+
+/**
+ * @brief Name of a language for benchmark labels
+ * @param language Language
+ * @return const char* "ja", "en" or "mixed"
+ */
+const char* languageName(Language language);
+
+/**
+ * @brief Lines of a synthetic corpus
+ *
+ * Words are drawn from a fixed vocabulary with Zipf-like frequencies, so
+ * n-gram counts, duplicates and PMI scores behave like those of real text.
+ * The same arguments always give the same lines; corpora are built once
+ * per process and shared by every benchmark that asks for them.
+ *
+ * @param language Language
+ * @param lines Number of lines
+ * @return const std::vector<std::string>& Lines without newlines
+ */
+const std::vector<std::string>& corpusLines(Language language, size_t lines);
+
+/**
+ * @brief A synthetic corpus as one newline-terminated text
+ * @param language Language
+ * @param lines Number of lines
+ * @return const std::string& Text
+ */
+const std::string& corpusText(Language language, size_t lines);
+
+/**
+ * @brief Stream a synthetic corpus of a given size
+ *
+ * Unlike corpusLines(), nothing is kept in memory, so corpora of any size
+ * can be written. A share of the lines repeats recent ones, as scraped
+ * feeds do, which gives normalize duplicates to remove. The same arguments
+ * always write the same bytes.
+ *
+ * @param out Output stream
+ * @param language Language
+ * @param bytes Size to reach; the last line may end a little past it
+ * @return uint64_t Bytes written
+ */
+uint64_t writeCorpus(std::ostream& out, Language language, uint64_t bytes);
+
+} // namespace bench
+} // namespace suzume
+
+#endif // SUZUME_BENCH_SYNTHETIC_CORPUS_H_
@@ -0,0 +1,70 @@
+/**
+ * @file text_bench.cpp
+ * @brief Benchmarks of line normalization and n-gram generation
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <vector>
+#include "core/text_utils.h"
+#include "hardware_counters.h"
+#include "synthetic_corpus.h"
+
+namespace suzume {
+namespace bench {
+
+namespace {
+
+size_t totalBytes(const std::vector<std::string>& lines) {
+    size_t bytes = 0;
+    for (const auto& line : lines) {
+        bytes += line.size();
+    }
+    return bytes;
+}
+
+} // namespace
+
+// Arguments: language, number of lines, normalization form
+void BM_NormalizeLine(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto& lines = corpusLines(language, static_cast<size_t>(state.range(1)));
+    const auto form = static_cast<NormalizationForm>(state.range(2));
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            benchmark::DoNotOptimize(core::normalizeLine(line, form));
+        }
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lines.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * totalBytes(lines)));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_NormalizeLine)
+    ->ArgNames({"lang", "lines", "form"})
+    ->ArgsProduct({{0, 1}, {1000, 10000},
+                   {static_cast<int64_t>(NormalizationForm::NFC), static_cast<int64_t>(NormalizationForm::NFKC)}});
+
+// Arguments: language, number of lines, n-gram size
+void BM_GenerateNgrams(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto& lines = corpusLines(language, static_cast<size_t>(state.range(1)));
+    const int n = static_cast<int>(state.range(2));
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        for (const auto& line : lines) {
+            benchmark::DoNotOptimize(core::generateNgrams(line, n));
+        }
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * lines.size()));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * totalBytes(lines)));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_GenerateNgrams)
+    ->ArgNames({"lang", "lines", "n"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}, {2, 3}});
+
+} // namespace bench
+} // namespace suzume
@@ -0,0 +1,157 @@
+/**
+ * @file word_extraction_bench.cpp
+ * @brief Benchmarks of the word extraction kernels
+ */
+
+#include <benchmark/benchmark.h>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "core/pmi.h"
+#include "core/suffix_array.h"
+#include "core/word_extraction/candidate_store.h"
+#include "core/word_extraction/filter.h"
+#include "core/word_extraction/trie.h"
+#include "hardware_counters.h"
+#include "synthetic_corpus.h"
+
+namespace suzume {
+namespace bench {
+
+namespace {
+
+// PMI results of a corpus, as word extraction reads them
+std::vector<core::PmiItem> pmiItems(Language language, size_t lines) {
+    const std::string& text = corpusText(language, lines);
+    std::vector<core::PmiItem> items;
+    for (uint32_t n = 2; n <= 4; ++n) {
+        auto scores = core::calculatePmiScores(core::countNgrams(text, n), n, 1);
+        items.insert(items.end(), scores.begin(), scores.end());
+    }
+    return items;
+}
+
+// The first code points of a string
+std::string_view leadingCodePoints(std::string_view text, size_t count) {
+    size_t end = 0;
+    while (end < text.size() && count > 0) {
+        ++end;
+        while (end < text.size() && (static_cast<unsigned char>(text[end]) & 0xC0) == 0x80) {
+            ++end;
+        }
+        --count;
+    }
+    return text.substr(0, end);
+}
+
+} // namespace
+
+// Arguments: language, number of lines
+void BM_NGramTrieAdd(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto items = pmiItems(language, static_cast<size_t>(state.range(1)));
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        core::NGramTrie trie;
+        for (const auto& item : items) {
+            trie.add(item.ngram, item.score, item.frequency);
+        }
+        benchmark::DoNotOptimize(trie.getNodeCount());
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * items.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_NGramTrieAdd)
+    ->ArgNames({"lang", "lines"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}});
+
+// Arguments: language, number of lines
+void BM_NGramTrieFindByPrefix(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto items = pmiItems(language, static_cast<size_t>(state.range(1)));
+    core::NGramTrie trie;
+    std::vector<std::string> prefixes;
+    for (size_t i = 0; i < items.size(); ++i) {
+        trie.add(items[i].ngram, items[i].score, items[i].frequency);
+        if (i % 10 == 0) {
+            prefixes.emplace_back(leadingCodePoints(items[i].ngram, 1));
+        }
+    }
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        for (const auto& prefix : prefixes) {
+            benchmark::DoNotOptimize(trie.findByPrefix(prefix));
+        }
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * prefixes.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_NGramTrieFindByPrefix)
+    ->ArgNames({"lang", "lines"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}});
+
+// The suffix array search behind CandidateVerifier::TextIndex::findAll()
+// Arguments: language, number of lines
+void BM_TextIndexFindAll(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto lines = static_cast<size_t>(state.range(1));
+    const std::string& text = corpusText(language, lines);
+    core::SuffixArray index(text);
+    std::vector<std::string_view> patterns;
+    const auto& corpus = corpusLines(language, lines);
+    for (size_t i = 0; i < corpus.size(); i += 10) {
+        patterns.push_back(leadingCodePoints(corpus[i], language == Language::Japanese ? 3 : 6));
+    }
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        for (std::string_view pattern : patterns) {
+            benchmark::DoNotOptimize(index.positions(pattern));
+        }
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * patterns.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_TextIndexFindAll)
+    ->ArgNames({"lang", "lines"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}});
+
+// Substring removal through CandidateFilter, with overlap removal off
+// Arguments: language, number of lines
+void BM_RemoveSubstringCandidates(benchmark::State& state) {
+    const auto language = static_cast<Language>(state.range(0));
+    const auto items = pmiItems(language, static_cast<size_t>(state.range(1)));
+    core::CandidateStore store;
+    std::vector<core::CandidateStore::Id> ids;
+    for (const auto& item : items) {
+        ids.push_back(store.add(item.ngram, item.score, item.frequency));
+    }
+
+    WordExtractionOptions options;
+    options.minLength = 1;
+    options.minScore = -1e9;
+    options.removeSubstrings = true;
+    options.removeOverlapping = false;
+    options.useLanguageSpecificRules = false;
+    options.progressFormat = ProgressFormat::NONE;
+    core::CandidateFilter filter(options);
+    HardwareCounterRegion counters;
+    for (auto _ : state) {
+        std::vector<core::CandidateStore::Id> selection = ids;
+        filter.filterCandidates(store, selection);
+        benchmark::DoNotOptimize(selection.data());
+    }
+    counters.report(state);
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * ids.size()));
+    state.SetLabel(languageName(language));
+}
+BENCHMARK(BM_RemoveSubstringCandidates)
+    ->ArgNames({"lang", "lines"})
+    ->ArgsProduct({{0, 1}, {1000, 10000}})
+    ->Unit(benchmark::kMillisecond);
+
+} // namespace bench
+} // namespace suzume
@@ -26,6 +26,10 @@ enum class NormalizationForm {
 
 /**
  * @brief Progress information structure
+ *
+ * Hot loops only count their work; a reporter thread samples the counts and
+ * calls the callbacks, so callbacks may run on a thread other than the
+ * caller's, though never two at a time.
  */
 struct ProgressInfo {
   /**
@@ -61,6 +65,14 @@ enum class ProgressFormat {
 
 // 重複した定義を削除
 
+/**
+ * @brief How sharded output assigns lines to shard files
+ */
+enum class ShardRouting {
+  Hash,      ///< By content hash, so equal lines always share a shard
+  RoundRobin ///< In turn, so shards stay the same size
+};
+
 /**
  * @brief Options for text normalization
  */
@@ -72,6 +84,26 @@ struct NormalizeOptions {
   double progressStep = 0.05;                       ///< Progress reporting granularity (0.0-1.0)
   uint32_t minLength = 0;                           ///< Minimum line length (0 = no minimum)
   uint32_t maxLength = 0;                           ///< Maximum line length (0 = no maximum)
+  bool streaming = false;                           ///< Process input in bounded batches instead of loading it whole
+  uint64_t maxMemoryUsage = 0;                      ///< Line buffer budget for streaming mode in bytes (0 = default)
+  std::string dedupIndexPath;                       ///< Persisted dedup index to skip lines from earlier runs and update (empty = none)
+  bool preserveOrder = false;                       ///< Write unique lines in input order (first occurrence wins) with any thread count
+  bool externalDedup = false;                       ///< Spill fingerprint partitions to disk for more unique lines than fit in memory
+  bool sortedOutput = false;                        ///< Write the unique lines sorted by their bytes, merging sorted runs spilled to disk
+  std::string tempDir;                              ///< Directory for spill files (empty = /tmp)
+  uint32_t nearDupDistance = 0;                     ///< Drop lines whose SimHash is within this many bits of a kept line (0 = off, max 31)
+  uint64_t nearDupMaxLines = 0;                     ///< Cap on lines indexed for near-duplicate detection (0 = unlimited)
+  uint64_t sampleSize = 0;                          ///< Normalize a uniform random sample of this many input lines (0 = all lines)
+  uint32_t sampleSeed = 0;                          ///< Random seed for sampling (0 = time-based)
+  bool numaAware = false;                           ///< Pin worker threads to CPUs node by node
+  bool compressOutput = false;                      ///< Write the output as zstd frames (implied by a ".zst" output path)
+  uint32_t outputShards = 0;                        ///< Split the output into this many "out-00000-of-00064" files (0 or 1 = one file)
+  ShardRouting shardRouting = ShardRouting::Hash;   ///< How lines are assigned to shards
+  std::string checkpointPath;                       ///< Checkpoint the run here as it goes (empty = none; needs a plain input file)
+  uint64_t checkpointInterval = 256ull << 20;       ///< Input bytes between checkpoints
+  bool resume = false;                              ///< Continue from the checkpoint an interrupted run left
+  std::vector<uint32_t> normalizeColumns;           ///< 1-based TSV columns to normalize; the others pass through byte for byte (empty = all)
+  std::vector<uint32_t> dedupColumns;               ///< 1-based TSV columns that identify a line for dedup (empty = the whole line)
 
   /**
    * @brief Callback function for progress updates
@@ -86,6 +118,31 @@ struct NormalizeOptions {
   std::function<void(const ProgressInfo& info)> structuredProgressCallback = nullptr;
 };
 
+/**
+ * @brief What exact PMI counting does when its tables cross PmiOptions::memoryBudget
+ */
+enum class MemoryBudgetStrategy {
+  None,  ///< Nothing (reported when the budget was never crossed)
+  Prune, ///< Drop low counts (lossy counting; frequencies may be underestimated)
+  Spill  ///< Spill sorted runs to disk and merge them before scoring (exact)
+};
+
+/**
+ * @brief Units paired by co-occurrence PMI
+ */
+enum class CooccurrenceUnit {
+  Character, ///< Code points, whitespace skipped
+  Token      ///< Runs of non-space characters separated by spaces or tabs
+};
+
+/**
+ * @brief Hardware exact PMI counting runs on
+ */
+enum class CountingBackend {
+  Cpu, ///< Worker threads on the CPU
+  Gpu  ///< A CUDA device (builds configured with ENABLE_CUDA; fails where there is none)
+};
+
 /**
  * @brief Options for PMI calculation
  */
@@ -97,6 +154,28 @@ struct PmiOptions {
   ProgressFormat progressFormat = ProgressFormat::TTY; ///< Progress output format
   double progressStep = 0.05;                      ///< Progress reporting granularity (0.0-1.0)
   bool verbose = false;                            ///< Enable verbose logging to stderr
+  bool allOrders = false;                          ///< Count every order 1..n in one pass, one output per order
+  bool approximate = false;                        ///< Count in a fixed-size sketch instead of exact tables
+  uint32_t sketchWidth = 1 << 20;                  ///< Counters per sketch row (approximate mode)
+  uint32_t sketchDepth = 4;                        ///< Sketch rows (approximate mode, 1-16)
+  uint32_t heavyHitters = 0;                       ///< Candidate n-grams tracked (approximate mode, 0 = 4 x topK)
+  std::string snapshotPath;                        ///< Also write the counts as a binary snapshot here (empty = none)
+  uint32_t snapshotPartitions = 1;                 ///< Hash partitions of the snapshot (>1 = one file per partition plus marginals)
+  std::string binaryOutputPath;                    ///< Also write the results in the binary format read by extractWords (empty = none)
+  uint64_t memoryBudget = 0;                       ///< Bytes the exact counting tables may use (0 = unlimited)
+  MemoryBudgetStrategy budgetStrategy = MemoryBudgetStrategy::Prune; ///< What to do when the budget is crossed
+  std::string tempDir;                             ///< Directory for spilled runs (empty = /tmp)
+  bool numaAware = false;                          ///< Pin workers to CPUs node by node and merge counts per node first
+  bool compressOutput = false;                     ///< Write the text output as zstd frames (implied by a ".zst" output path)
+  uint32_t outputShards = 0;                       ///< Split the text output into this many "out-00000-of-00064" files (0 or 1 = one file)
+  ShardRouting shardRouting = ShardRouting::Hash;  ///< How result rows are assigned to shards
+  std::string checkpointPath;                      ///< Checkpoint counting here as it goes (empty = none; needs a plain input file)
+  uint64_t checkpointInterval = 256ull << 20;      ///< Input bytes between checkpoints
+  bool resume = false;                             ///< Continue from the checkpoint an interrupted run left
+  uint32_t window = 0;                             ///< Score ordered pairs of units at most this far apart instead of n-grams (0 = n-grams)
+  CooccurrenceUnit cooccurrenceUnit = CooccurrenceUnit::Character; ///< Units paired when window is set
+  std::string statsOutputPath;                     ///< Also write occurrence statistics of the results here, for WordExtractionOptions::pmiStatsPath (empty = none)
+  CountingBackend countingBackend = CountingBackend::Cpu; ///< Where exact n-gram counts are gathered
 
   /**
    * @brief Callback function for progress updates
@@ -111,6 +190,109 @@ struct PmiOptions {
   std::function<void(const ProgressInfo& info)> structuredProgressCallback = nullptr;
 };
 
+/**
+ * @brief Memory measured over one phase of an operation
+ */
+struct PhaseMemory {
+  std::string phase;              ///< Phase name
+  uint64_t peakBytes = 0;         ///< Most heap bytes in use above the start of the operation
+  uint64_t peakResidentBytes = 0; ///< Highest resident set size sampled during the phase
+};
+
+/**
+ * @brief Most memory held by one kind of large structure during an operation
+ */
+struct SubsystemMemory {
+  std::string subsystem;          ///< "lines", "dedup", "ngram_tables", "tries" or "text_index"
+  uint64_t peakBytes = 0;         ///< Most bytes the structures of this kind held at once
+};
+
+/**
+ * @brief Memory measured over an operation
+ *
+ * Heap bytes come from the allocator's statistics and include its overhead.
+ * Subsystem bytes are the sizes of the accounted structures themselves.
+ * All figures are process-wide, so allocations of other threads running at
+ * the same time are counted too.
+ */
+struct MemoryStats {
+  uint64_t peakBytes = 0;           ///< Most heap bytes in use above the start of the operation
+  uint64_t peakResidentBytes = 0;   ///< Highest resident set size sampled during the operation
+  std::vector<PhaseMemory> phases;  ///< Per-phase measurements, in order
+  std::vector<SubsystemMemory> subsystems; ///< Peak of each accounted subsystem, always all five
+  uint64_t limitBytes = 0;          ///< Memory limit the operation planned its modes for (0 = none)
+};
+
+/**
+ * @brief Hardware performance counters over a stretch of an operation
+ *
+ * Counted with perf_event_open on Linux, in user mode, over every thread
+ * of the process. Counters the CPU or the kernel settings do not allow
+ * stay 0; available is false when none could be counted.
+ */
+struct HardwareCounters {
+  bool available = false;           ///< At least one counter was counted
+  uint64_t cycles = 0;              ///< CPU cycles
+  uint64_t instructions = 0;        ///< Instructions retired
+  uint64_t cacheReferences = 0;     ///< Last-level cache references
+  uint64_t cacheMisses = 0;         ///< Last-level cache misses
+  uint64_t branches = 0;            ///< Branch instructions retired
+  uint64_t branchMisses = 0;        ///< Mispredicted branches
+  double ipc = 0.0;                 ///< Instructions per cycle
+  double cacheMissRate = 0.0;       ///< Cache misses over cache references
+  double branchMissRate = 0.0;      ///< Branch misses over branches
+};
+
+/**
+ * @brief Time and output measured over one phase of an operation
+ */
+struct PhaseMetrics {
+  std::string phase;              ///< Phase name, as in MemoryStats::phases
+  uint64_t elapsedMs = 0;         ///< Wall-clock time of the phase in milliseconds
+  uint64_t cpuMs = 0;             ///< CPU time of the process during the phase in milliseconds
+  uint64_t bytesOut = 0;          ///< Bytes written to output files and stdout during the phase
+  double threadUtilization = 0.0; ///< CPU time over wall-clock time of all threads (1.0: every thread busy)
+  HardwareCounters counters;      ///< Hardware counters of the phase, when enabled
+};
+
+/**
+ * @brief How an operation sized its work for the input and the machine
+ *
+ * With threads = 0 the thread count is chosen from the input size, the
+ * CPUs the process may run on (affinity mask and cgroup CPU quota) and the
+ * memory available to extra workers; an explicit thread count is kept.
+ */
+struct TuningChoice {
+  uint32_t threads = 0;        ///< Worker threads chosen
+  uint32_t availableCpus = 0;  ///< CPUs the process may use
+  uint64_t chunkBytes = 0;     ///< Input bytes per work chunk (0 = not chunked by bytes)
+  std::string variant;         ///< Code path taken ("serial", "parallel", "sharded", "approximate"; empty = not tuned)
+  std::string reason;          ///< What bounded the threads ("requested", "input size", "cpus", "memory")
+};
+
+/**
+ * @brief Time, throughput and thread utilization of an operation
+ *
+ * Phases are the same as those of MemoryStats. CPU time and output bytes
+ * are process-wide, like the memory figures, so work of other threads
+ * running at the same time is counted too. So are the hardware counters,
+ * which are only read when core::setHardwareCounters() turned them on.
+ */
+struct OperationMetrics {
+  uint64_t elapsedMs = 0;           ///< Wall-clock time of the operation in milliseconds
+  uint64_t cpuMs = 0;               ///< CPU time of the process during the operation in milliseconds
+  uint64_t bytesIn = 0;             ///< Input bytes read (0 when the size is not known)
+  uint64_t bytesOut = 0;            ///< Bytes written to output files and stdout
+  uint64_t lines = 0;               ///< Input lines processed (0 for operations that do not keep lines)
+  double linesPerSec = 0.0;         ///< Input lines per second
+  double mbPerSec = 0.0;            ///< Input MB per second
+  uint32_t threads = 0;             ///< Worker threads of the operation
+  double threadUtilization = 0.0;   ///< CPU time over wall-clock time of all threads (1.0: every thread busy)
+  HardwareCounters counters;        ///< Hardware counters of the operation, when enabled
+  TuningChoice tuning;              ///< How the threads and chunks were chosen
+  std::vector<PhaseMetrics> phases; ///< Per-phase measurements, in order
+};
+
 /**
  * @brief Result of normalization operation
  */
@@ -120,6 +302,18 @@ struct NormalizeResult {
   uint64_t duplicates = 0;   ///< Number of duplicate rows removed
   uint64_t elapsedMs = 0;    ///< Processing time in milliseconds
   double mbPerSec = 0.0;     ///< Processing speed in MB/sec
+  MemoryStats memory;        ///< Measured memory use
+  OperationMetrics metrics;  ///< Measured time and throughput, per phase
+};
+
+/**
+ * @brief Result of one n-gram order of a PMI calculation
+ */
+struct PmiOrderResult {
+  uint32_t n = 0;                ///< N-gram size
+  uint64_t grams = 0;            ///< Number of distinct n-grams counted
+  uint64_t distinctNgrams = 0;   ///< Number of n-grams written
+  std::string outputPath;        ///< Where this order was written
 };
 
 /**
@@ -130,6 +324,12 @@ struct PmiResult {
   uint64_t distinctNgrams = 0;   ///< Number of distinct n-grams found
   uint64_t elapsedMs = 0;        ///< Processing time in milliseconds
   double mbPerSec = 0.0;         ///< Processing speed in MB/sec
+  std::vector<PmiOrderResult> orders; ///< Per-order results when PmiOptions::allOrders is set
+  uint64_t countErrorBound = 0;  ///< Approximate mode: most a frequency may be overestimated by; pruned runs: underestimated by
+  double errorProbability = 0.0; ///< Approximate mode: chance per n-gram of exceeding that bound
+  MemoryBudgetStrategy budgetStrategy = MemoryBudgetStrategy::None; ///< Strategy used to stay within PmiOptions::memoryBudget
+  MemoryStats memory;            ///< Measured memory use
+  OperationMetrics metrics;      ///< Measured time and throughput, per phase
 };
 
 /**
@@ -147,6 +347,13 @@ struct WordExtractionOptions {
   bool useStatisticalValidation = true;  ///< Use statistical validation
   bool useDictionaryLookup = false;      ///< Use dictionary lookup
   std::string dictionaryPath = "";       ///< Dictionary path
+  bool batchVerification = false;        ///< Count all candidates in one Aho-Corasick pass over the text
+  bool streamingVerification = false;    ///< Scan the original text block by block instead of holding it whole
+  uint64_t verificationBlockSize = 64ULL * 1024 * 1024; ///< Block size of streaming verification in bytes
+  std::string textIndexPath = "";        ///< Suffix array file of the original text, mapped if it matches and rewritten if not ("" = build in memory)
+  std::string pmiStatsPath = "";         ///< Statistics written by PmiOptions::statsOutputPath, looked up instead of searching the text ("" = search)
+  std::string incrementalStatePath = ""; ///< Evidence of the previous run's candidates, reused instead of searching the text and rewritten ("" = none)
+  double incrementalTolerance = 0.05;    ///< Relative PMI score and frequency change that keeps a candidate's evidence over a changed text
 
   // フィルタリングオプション
   uint32_t minLength = 2;                ///< Minimum length
@@ -164,6 +371,7 @@ struct WordExtractionOptions {
   double lengthWeight = 0.2;             ///< Length weight
   double contextWeight = 0.2;            ///< Context weight
   double statisticalWeight = 0.2;        ///< Statistical weight
+  bool lazyEvaluation = false;           ///< Verify candidates best bound first and stop once none left can enter the top K
 
   // 並列処理オプション
   bool useParallelProcessing = true;     ///< Use parallel processing
@@ -194,8 +402,45 @@ struct WordExtractionResult {
   std::vector<double> scores;          ///< Scores
   std::vector<uint32_t> frequencies;   ///< Frequencies
   std::vector<std::string> contexts;   ///< Contexts (optional)
+  uint64_t reusedCandidates = 0;       ///< Candidates verified from WordExtractionOptions::incrementalStatePath instead of the text
   uint64_t processingTimeMs = 0;       ///< Processing time in milliseconds
-  uint64_t memoryUsageBytes = 0;       ///< Memory usage in bytes
+  uint64_t memoryUsageBytes = 0;       ///< Peak heap bytes in use, the same as memory.peakBytes
+  MemoryStats memory;                  ///< Measured memory use, per stage
+  OperationMetrics metrics;            ///< Measured time and throughput, per stage
+};
+
+/**
+ * @brief Options for the in-memory normalize, PMI and word extraction pipeline
+ *
+ * Progress callbacks of the stage options are not used; the pipeline
+ * reports its overall progress through its own callbacks.
+ */
+struct PipelineOptions {
+  NormalizeOptions normalize;             ///< Normalization stage options (streaming and external dedup are not supported)
+  PmiOptions pmi;                         ///< PMI stage options (all orders, snapshots and spilling are not supported)
+  WordExtractionOptions wordExtraction;   ///< Word extraction stage options
+
+  /**
+   * @brief Callback function for progress updates
+   * @param ratio Progress ratio from 0.0 to 1.0
+   */
+  std::function<void(double ratio)> progressCallback = nullptr;
+
+  /**
+   * @brief Structured callback function for detailed progress updates
+   * @param info Detailed progress information
+   */
+  std::function<void(const ProgressInfo& info)> structuredProgressCallback = nullptr;
+};
+
+/**
+ * @brief Result of the in-memory pipeline
+ */
+struct PipelineResult {
+  NormalizeResult normalize;      ///< Normalization stage results
+  PmiResult pmi;                  ///< PMI stage results
+  WordExtractionResult words;     ///< Extracted words
+  uint64_t elapsedMs = 0;         ///< Processing time of the whole pipeline in milliseconds
 };
 
 /**
@@ -212,6 +457,20 @@ NormalizeResult normalize(
   const NormalizeOptions& options = NormalizeOptions()
 );
 
+/**
+ * @brief Normalize several input files with one shared dedup state
+ *
+ * @param inputPaths Input files, directories or globs
+ * @param outputPath Path to output TSV file
+ * @param options Normalization options
+ * @return NormalizeResult Results of the normalization operation
+ */
+NormalizeResult normalizeFiles(
+  const std::vector<std::string>& inputPaths,
+  const std::string& outputPath,
+  const NormalizeOptions& options = NormalizeOptions()
+);
+
 /**
  * @brief Calculate PMI (Pointwise Mutual Information)
  *
@@ -226,10 +485,54 @@ PmiResult calculatePmi(
   const PmiOptions& options = PmiOptions()
 );
 
+/**
+ * @brief Calculate PMI over several input files with one shared count table
+ *
+ * @param inputPaths Input files, directories or globs
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFiles(
+  const std::vector<std::string>& inputPaths,
+  const std::string& outputPath,
+  const PmiOptions& options = PmiOptions()
+);
+
+/**
+ * @brief Calculate PMI from merged binary n-gram count snapshots
+ *
+ * @param snapshotPaths Snapshots written with PmiOptions::snapshotPath
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFromSnapshots(
+  const std::vector<std::string>& snapshotPaths,
+  const std::string& outputPath,
+  const PmiOptions& options = PmiOptions()
+);
+
+/**
+ * @brief Calculate PMI for hash partitions counted on several machines
+ *
+ * @param partitionPaths Partition snapshots written with PmiOptions::snapshotPartitions
+ * @param marginalPaths Marginal snapshots of every machine
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFromPartitions(
+  const std::vector<std::string>& partitionPaths,
+  const std::vector<std::string>& marginalPaths,
+  const std::string& outputPath,
+  const PmiOptions& options = PmiOptions()
+);
+
 /**
  * @brief Extract unknown words from PMI results
  *
- * @param pmiResultsPath Path to PMI results file
+ * @param pmiResultsPath Path to PMI results file (TSV, or binary from PmiOptions::binaryOutputPath)
  * @param originalTextPath Path to original text file
  * @param options Word extraction options
  * @return WordExtractionResult Results of the word extraction operation
@@ -240,6 +543,22 @@ WordExtractionResult extractWords(
   const WordExtractionOptions& options = WordExtractionOptions()
 );
 
+/**
+ * @brief Normalize, calculate PMI and extract unknown words in one run
+ *
+ * The normalized corpus and the PMI results stay in memory and are handed
+ * from stage to stage; nothing is written or parsed between them, and the
+ * verifier indexes the corpus already loaded.
+ *
+ * @param inputPath Path to input text file ("-" for stdin)
+ * @param options Pipeline options
+ * @return PipelineResult Results of every stage
+ */
+PipelineResult runPipeline(
+  const std::string& inputPath,
+  const PipelineOptions& options = PipelineOptions()
+);
+
 } // namespace suzume
 
 #endif // SUZUME_FEEDMILL_H_
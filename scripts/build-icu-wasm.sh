@@ -0,0 +1,78 @@
+#!/bin/bash
+# Build ICU for WebAssembly without embedded data, plus the trimmed data file
+#
+# The libraries use --with-data-packaging=archive, so their libicudata is a
+# stub; the module loads suzume-feedmill-icu.dat at runtime instead. The data
+# is cut down by src/wasm/icu-data-filter.json to what normalization uses:
+# NFKC (NFC and the case and character properties are compiled into
+# libicuuc), emoji properties and the converter aliases u_init() opens.
+#
+# Usage: scripts/build-icu-wasm.sh [install-dir]   (default: build-icu-wasm/install)
+# Set ICU_VERSION to build another release (default: 74.2).
+
+set -e
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+PROJECT_ROOT="$( cd "$SCRIPT_DIR/.." && pwd )"
+
+if ! command -v emconfigure &> /dev/null; then
+    echo "Error: Emscripten (emconfigure) not found."
+    exit 1
+fi
+
+ICU_VERSION="${ICU_VERSION:-74.2}"
+ICU_UNDERSCORE="${ICU_VERSION//./_}"
+ICU_DASH="${ICU_VERSION//./-}"
+ICU_URL="https://github.com/unicode-org/icu/releases/download/release-$ICU_DASH"
+
+WORK_DIR="$PROJECT_ROOT/build-icu-wasm"
+PREFIX="${1:-$WORK_DIR/install}"
+FILTER="$PROJECT_ROOT/src/wasm/icu-data-filter.json"
+JOBS=$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 2)
+
+mkdir -p "$WORK_DIR"
+cd "$WORK_DIR"
+
+# Sources; filtering works on the data sources, not on the prebuilt .dat
+if [ ! -d icu/source ]; then
+    echo "Downloading ICU $ICU_VERSION..."
+    curl -fsSL -o icu4c-src.tgz "$ICU_URL/icu4c-$ICU_UNDERSCORE-src.tgz"
+    curl -fsSL -o icu4c-data.zip "$ICU_URL/icu4c-$ICU_UNDERSCORE-data.zip"
+    tar xzf icu4c-src.tgz
+    rm -rf icu/source/data
+    unzip -q icu4c-data.zip -d icu/source
+fi
+
+# Host build: cross compilation and the data build run its tools
+if [ ! -f host/bin/icupkg ]; then
+    echo "Building host ICU tools..."
+    mkdir -p host
+    (cd host && "$WORK_DIR/icu/source/configure" --disable-tests --disable-samples --disable-extras \
+        && make -j"$JOBS")
+fi
+
+echo "Building ICU for WebAssembly..."
+rm -rf wasm
+mkdir -p wasm
+(
+    cd wasm
+    ICU_DATA_FILTER_FILE="$FILTER" emconfigure "$WORK_DIR/icu/source/configure" \
+        --host=wasm32-unknown-emscripten \
+        --with-cross-build="$WORK_DIR/host" \
+        --prefix="$PREFIX" \
+        --enable-static --disable-shared \
+        --with-data-packaging=archive \
+        --disable-tools --disable-tests --disable-samples --disable-extras
+    emmake make -j"$JOBS"
+    emmake make install
+)
+
+DATA_FILE=$(find "$WORK_DIR/wasm/data/out" -maxdepth 1 -name "icudt*l.dat" | head -n 1)
+if [ -z "$DATA_FILE" ]; then
+    echo "Error: ICU data file not found."
+    exit 1
+fi
+mkdir -p "$PREFIX/share"
+cp "$DATA_FILE" "$PREFIX/share/suzume-feedmill-icu.dat"
+echo "ICU installed to $PREFIX"
+echo "  $PREFIX/share/suzume-feedmill-icu.dat ($(wc -c < "$DATA_FILE") bytes)"
@@ -1,5 +1,10 @@
 #!/bin/bash
 # WebAssembly build script
+#
+# Usage: scripts/build-wasm.sh [--icu-data-file]
+#   --icu-data-file  Link data-less ICU (scripts/build-icu-wasm.sh) and ship the
+#                    trimmed ICU data as suzume-feedmill-icu.dat, fetched on the
+#                    first normalization instead of embedded in every module
 
 set -e
 
@@ -20,35 +25,72 @@ if ! command -v emcc &> /dev/null; then
     exit 1
 fi
 
-# Create build directory
-BUILD_DIR="$PROJECT_ROOT/build-wasm"
-mkdir -p "$BUILD_DIR"
-cd "$BUILD_DIR"
-
-# Configure project with CMake
-echo "Configuring WebAssembly build..."
-emcmake cmake .. -DBUILD_WASM=ON -DCMAKE_BUILD_TYPE=Release
-
-# Build
-echo "Building WebAssembly module..."
-emmake make -j$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 2)
-
-# Check output files
-if [ -f "$BUILD_DIR/suzume-feedmill.js" ] && [ -f "$BUILD_DIR/suzume-feedmill.wasm" ]; then
-    echo "Build successful!"
-    echo "Output files:"
-    echo "  $BUILD_DIR/suzume-feedmill.js"
-    echo "  $BUILD_DIR/suzume-feedmill.wasm"
-
-    # Copy to output directory
-    OUTPUT_DIR="$PROJECT_ROOT/wasm"
-    mkdir -p "$OUTPUT_DIR"
-    cp "$BUILD_DIR/suzume-feedmill.js" "$OUTPUT_DIR/"
-    cp "$BUILD_DIR/suzume-feedmill.wasm" "$OUTPUT_DIR/"
-    echo "Files copied to $OUTPUT_DIR"
+ICU_DATA_FILE=OFF
+for arg in "$@"; do
+    case "$arg" in
+        --icu-data-file) ICU_DATA_FILE=ON ;;
+        *) echo "Unknown option: $arg"; exit 1 ;;
+    esac
+done
+
+JOBS=$(nproc 2>/dev/null || sysctl -n hw.ncpu 2>/dev/null || echo 2)
+OUTPUT_DIR="$PROJECT_ROOT/wasm"
+mkdir -p "$OUTPUT_DIR"
+
+ICU_WASM_ROOT="$PROJECT_ROOT/build-icu-wasm/install"
+if [ "$ICU_DATA_FILE" = ON ] && [ ! -f "$ICU_WASM_ROOT/lib/libicuuc.a" ]; then
+    "$SCRIPT_DIR/build-icu-wasm.sh" "$ICU_WASM_ROOT"
+fi
+
+# Build the scalar module, the SIMD variant and the threaded SIMD variant;
+# the loader picks one at runtime
+build_variant() {
+    local name="$1"
+    local build_dir="$2"
+    local simd="$3"
+    local threads="$4"
+
+    mkdir -p "$build_dir"
+    cd "$build_dir"
+
+    # Configure project with CMake
+    echo "Configuring WebAssembly build ($name)..."
+    emcmake cmake "$PROJECT_ROOT" -DBUILD_WASM=ON -DWASM_SIMD="$simd" -DWASM_THREADS="$threads" \
+        -DWASM_ICU_DATA_FILE="$ICU_DATA_FILE" -DICU_WASM_ROOT="$ICU_WASM_ROOT" \
+        -DCMAKE_BUILD_TYPE=Release
+
+    # Build
+    echo "Building WebAssembly module ($name)..."
+    emmake make -j"$JOBS"
+
+    # Check output file (the binary is embedded with SINGLE_FILE=1)
+    if [ ! -f "$build_dir/$name.js" ]; then
+        echo "Error: Build failed or $name.js not found."
+        exit 1
+    fi
+    cp "$build_dir/$name.js" "$OUTPUT_DIR/"
+    echo "  $OUTPUT_DIR/$name.js"
+
+    # Emscripten releases before 3.1.58 write the pthread worker script separately
+    if [ -f "$build_dir/$name.worker.js" ]; then
+        cp "$build_dir/$name.worker.js" "$OUTPUT_DIR/"
+        echo "  $OUTPUT_DIR/$name.worker.js"
+    fi
+}
+
+build_variant suzume-feedmill "$PROJECT_ROOT/build-wasm" OFF OFF
+build_variant suzume-feedmill-simd "$PROJECT_ROOT/build-wasm-simd" ON OFF
+build_variant suzume-feedmill-simd-threads "$PROJECT_ROOT/build-wasm-simd-threads" ON ON
+
+cp "$PROJECT_ROOT/src/wasm/suzume-feedmill-loader.js" "$OUTPUT_DIR/"
+echo "  $OUTPUT_DIR/suzume-feedmill-loader.js"
+if [ "$ICU_DATA_FILE" = ON ]; then
+    cp "$ICU_WASM_ROOT/share/suzume-feedmill-icu.dat" "$OUTPUT_DIR/"
+    echo "  $OUTPUT_DIR/suzume-feedmill-icu.dat"
 else
-    echo "Error: Build failed or output files not found."
-    exit 1
+    # Modules built now embed their ICU data; a stale data file would mislead
+    rm -f "$OUTPUT_DIR/suzume-feedmill-icu.dat"
 fi
+echo "Files copied to $OUTPUT_DIR"
 
 echo "WebAssembly build completed!"
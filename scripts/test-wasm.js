@@ -3,7 +3,10 @@
  * WebAssembly test script for suzume-feedmill
  *
  * This script tests the basic functionality of the WebAssembly module
- * by running normalize, calculatePmi, and extractWords functions.
+ * by running normalize, calculatePmi, and extractWords functions and the
+ * streaming sessions.
+ * Pass --simd to test the SIMD build instead of the scalar one, or
+ * --threads to test the threaded SIMD build.
  */
 
 const fs = require("fs");
@@ -12,7 +15,16 @@ const path = require("path");
 // Get project root directory
 const projectRoot = path.resolve(__dirname, "..");
 const wasmDir = path.join(projectRoot, "wasm");
-const wasmModule = path.join(wasmDir, "suzume-feedmill.js");
+const threads = process.argv.includes("--threads");
+const simd = threads || process.argv.includes("--simd");
+const wasmModule = path.join(
+  wasmDir,
+  threads
+    ? "suzume-feedmill-simd-threads.js"
+    : simd
+      ? "suzume-feedmill-simd.js"
+      : "suzume-feedmill.js"
+);
 
 // Check if WASM module exists
 if (!fs.existsSync(wasmModule)) {
@@ -40,6 +52,19 @@ async function runTests() {
     const module = await SuzumeFeedmill();
     console.log("WASM module loaded successfully.");
 
+    // Modules built with --icu-data-file need their ICU data before normalizing
+    if (module.icuDataFile) {
+      const icuData = fs.readFileSync(path.join(wasmDir, "suzume-feedmill-icu.dat"));
+      if (module.normalize("x", {}).error === undefined) {
+        throw new Error("normalize ran without ICU data");
+      }
+      const loaded = module.setIcuData(new Uint8Array(icuData));
+      if (loaded.error) {
+        throw new Error(`Loading ICU data failed: ${loaded.error}`);
+      }
+      console.log(`Loaded ${icuData.length} bytes of ICU data.`);
+    }
+
     // Simple function existence check to detect early binding issues
     console.log("\n=== Checking function existence ===");
     if (typeof module.normalize !== "function") {
@@ -126,6 +151,61 @@ async function runTests() {
     console.log(`Extracted ${wordResult.words.length} words`);
     console.log("Test 3 passed!");
 
+    // Test 4: Feed the text in small chunks, splitting lines and characters
+    console.log("\n=== Test 4: Streaming sessions ===");
+    const bytes = new TextEncoder().encode(sampleText);
+    const normSession = module.createNormalizeSession({ form: "NFKC" });
+    const pmiSession = module.createPmiSession({ n: 2, topK: 10 });
+    let streamedText = "";
+    for (let offset = 0; offset < bytes.length; offset += 7) {
+      const chunk = bytes.subarray(offset, offset + 7);
+      const fed = normSession.feed(chunk);
+      if (fed.error) {
+        throw new Error(`Normalize session failed: ${fed.error}`);
+      }
+      streamedText += fed.text;
+    }
+    const normFinished = normSession.finish();
+    streamedText += normFinished.text;
+    normSession.delete();
+    if (streamedText !== normResult.text || normFinished.uniques !== normResult.uniques) {
+      throw new Error("Normalize session differs from normalize");
+    }
+
+    const normBytes = new TextEncoder().encode(normResult.text);
+    for (let offset = 0; offset < normBytes.length; offset += 5) {
+      pmiSession.feed(normBytes.subarray(offset, offset + 5));
+    }
+    const pmiFinished = pmiSession.finish();
+    pmiSession.delete();
+    if (JSON.stringify(pmiFinished.results) !== JSON.stringify(pmiResult.results)) {
+      throw new Error("PMI session differs from calculatePmi");
+    }
+    console.log("Test 4 passed!");
+
+    // Test 5: PMI results as typed-array columns
+    console.log("\n=== Test 5: PMI columns ===");
+    const columns = module.calculatePmiColumns(normResult.text, { n: 2, topK: 10 });
+    if (columns.error) {
+      throw new Error(`PMI columns failed: ${columns.error}`);
+    }
+    const scores = columns.scores();
+    const offsets = columns.ngramOffsets();
+    const ngramBytes = columns.ngramBytes();
+    const decoder = new TextDecoder();
+    if (columns.length !== pmiResult.results.length || offsets.length !== columns.length + 1) {
+      throw new Error("PMI columns have the wrong length");
+    }
+    for (let i = 0; i < columns.length; i++) {
+      const ngram = decoder.decode(ngramBytes.slice(offsets[i], offsets[i + 1]));
+      if (ngram !== pmiResult.results[i].ngram || ngram !== columns.ngram(i) ||
+          scores[i] !== pmiResult.results[i].score) {
+        throw new Error(`PMI columns differ from calculatePmi at row ${i}`);
+      }
+    }
+    columns.delete();
+    console.log("Test 5 passed!");
+
     console.log("\nAll tests passed!");
     return true;
   } catch (error) {
@@ -0,0 +1,251 @@
+/**
+ * @file batch.cpp
+ * @brief Implementation of batch runs
+ */
+
+#include "batch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include "commands.h"
+#include "options.h"
+#include "core/auto_tune.h"
+#include "core/warm_cache.h"
+
+// For convenience
+using json = nlohmann::json;
+
+namespace suzume {
+namespace cli {
+
+namespace {
+
+bool endsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// One job of a manifest entry; its position names it if it has no id
+BatchJob parseJobEntry(const json& entry, size_t position, const std::string& path) {
+    BatchJob job;
+    job.id = position;
+    try {
+        if (entry.is_array()) {
+            job.args = entry.get<std::vector<std::string>>();
+        } else if (entry.is_object()) {
+            job.args = entry.at("args").get<std::vector<std::string>>();
+            if (entry.contains("id")) {
+                job.id = entry["id"];
+            }
+        } else {
+            throw std::runtime_error("expected an object or an array");
+        }
+    } catch (const std::exception& e) {
+        throw std::runtime_error("Invalid job " + std::to_string(position) + " in manifest " + path + ": " + e.what());
+    }
+    return job;
+}
+
+std::vector<BatchJob> readTsvManifest(std::istream& input) {
+    std::vector<BatchJob> jobs;
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(input, line)) {
+        lineNumber++;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        BatchJob job;
+        job.id = lineNumber;
+        std::istringstream fields(line);
+        std::string field;
+        while (std::getline(fields, field, '\t')) {
+            job.args.push_back(field);
+        }
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
+
+std::vector<BatchJob> readJsonManifest(const std::string& text, const std::string& path) {
+    std::vector<BatchJob> jobs;
+    json whole = json::parse(text, nullptr, false);
+    // An array of strings is one job on one line, not a list of jobs
+    if (!whole.is_discarded() && whole.is_array()
+        && !std::all_of(whole.begin(), whole.end(), [](const json& entry) { return entry.is_string(); })) {
+        for (size_t i = 0; i < whole.size(); ++i) {
+            jobs.push_back(parseJobEntry(whole[i], i + 1, path));
+        }
+        return jobs;
+    }
+
+    // JSON Lines: one job per non-blank line
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos) {
+            continue;
+        }
+        json entry;
+        try {
+            entry = json::parse(line);
+        } catch (const json::parse_error& e) {
+            throw std::runtime_error("Invalid job " + std::to_string(jobs.size() + 1) + " in manifest " + path
+                                     + ": " + e.what());
+        }
+        jobs.push_back(parseJobEntry(entry, jobs.size() + 1, path));
+    }
+    return jobs;
+}
+
+uint64_t fileBytes(const std::string& path) {
+    std::error_code error;
+    uint64_t bytes = std::filesystem::file_size(path, error);
+    return error ? 0 : bytes;
+}
+
+// Bytes a job reads, to schedule the largest first
+uint64_t jobInputBytes(const OptionsParser& options) {
+    if (options.isMergeCommand()) {
+        uint64_t bytes = 0;
+        for (const auto& partition : options.getMergeInputPaths()) {
+            bytes += fileBytes(partition);
+        }
+        return bytes;
+    }
+    uint64_t bytes = fileBytes(options.getInputPath());
+    if (options.isWordExtractCommand()) {
+        bytes += fileBytes(options.getOriginalTextPath());
+    }
+    return bytes;
+}
+
+/**
+ * @brief A manifest job, parsed, with its place in the schedule
+ */
+struct ScheduledJob {
+    size_t index = 0;             ///< Position in the manifest
+    OptionsParser options;        ///< Parsed arguments
+    std::string parseError;       ///< Why the arguments were refused (empty = runnable)
+    uint64_t inputBytes = 0;      ///< Bytes the job reads
+};
+
+} // namespace
+
+std::vector<BatchJob> readBatchManifest(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open manifest: " + path);
+    }
+    if (endsWith(path, ".tsv")) {
+        return readTsvManifest(input);
+    }
+    std::string text((std::istreambuf_iterator<char>(input)), std::istreambuf_iterator<char>());
+    return readJsonManifest(text, path);
+}
+
+int runBatch(const BatchOptions& options) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    std::vector<BatchJob> jobs = readBatchManifest(options.manifestPath);
+
+    // Parse everything first, so malformed jobs are reported without running
+    std::vector<ScheduledJob> scheduled(jobs.size());
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        scheduled[i].index = i;
+        try {
+            scheduled[i].options.parseJob(jobs[i].args);
+            scheduled[i].inputBytes = jobInputBytes(scheduled[i].options);
+        } catch (const std::invalid_argument& e) {
+            scheduled[i].parseError = e.what();
+        }
+    }
+
+    const unsigned int cpus = core::availableCpus();
+    const size_t maxJobs = std::max<size_t>(1, std::min(options.maxJobs > 0 ? options.maxJobs : cpus, jobs.size()));
+    const uint32_t threadsPerJob = static_cast<uint32_t>(std::max<size_t>(1, cpus / maxJobs));
+
+    // Largest first: the long jobs overlap the short ones instead of running alone at the end
+    std::vector<size_t> order(jobs.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&scheduled](size_t a, size_t b) {
+        return scheduled[a].inputBytes > scheduled[b].inputBytes;
+    });
+
+    warmUpProcess();
+    core::setWarmCacheLimit(options.cacheEntries);
+
+    std::vector<json> results(jobs.size());
+    std::atomic<size_t> next{0};
+    std::atomic<size_t> failed{0};
+    std::mutex outputMutex;
+    auto work = [&]() {
+        for (size_t slot = next.fetch_add(1); slot < order.size(); slot = next.fetch_add(1)) {
+            ScheduledJob& job = scheduled[order[slot]];
+            json result = {{"id", jobs[job.index].id}, {"input_bytes", job.inputBytes}};
+            if (job.parseError.empty()) {
+                job.options.setDefaultThreads(threadsPerJob);
+                try {
+                    result["stats"] = runCommand(job.options);
+                    result["ok"] = true;
+                } catch (const std::exception& e) {
+                    result["ok"] = false;
+                    result["error"] = e.what();
+                }
+            } else {
+                result["ok"] = false;
+                result["error"] = job.parseError;
+            }
+
+            if (!result["ok"].get<bool>()) {
+                failed.fetch_add(1);
+                std::lock_guard<std::mutex> lock(outputMutex);
+                std::cerr << "Job " << result["id"].dump() << " failed: " << result["error"].get<std::string>()
+                          << std::endl;
+            }
+            results[job.index] = std::move(result);
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (size_t i = 1; i < maxJobs; ++i) {
+        workers.emplace_back(work);
+    }
+    work();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    core::setWarmCacheLimit(0);
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+    if (options.statsJson) {
+        json stats = {
+            {"command", "batch"},
+            {"manifest", options.manifestPath},
+            {"jobs", jobs.size()},
+            {"failed", failed.load()},
+            {"max_jobs", maxJobs},
+            {"threads_per_job", threadsPerJob},
+            {"elapsed_ms", elapsedMs},
+            {"results", results}
+        };
+        std::cout << stats.dump() << std::endl;
+    } else if (!options.quiet) {
+        std::cout << "Ran " << jobs.size() << " jobs, " << failed.load() << " failed" << std::endl;
+    }
+    return failed.load() == 0 ? 0 : 1;
+}
+
+} // namespace cli
+} // namespace suzume
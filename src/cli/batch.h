@@ -0,0 +1,71 @@
+/**
+ * @file batch.h
+ * @brief Runs the jobs of a manifest concurrently in one process
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace suzume {
+namespace cli {
+
+/**
+ * @brief Settings of a batch run
+ */
+struct BatchOptions {
+    std::string manifestPath;  ///< JSON, JSON Lines or TSV list of jobs
+    size_t maxJobs = 0;        ///< Jobs run at the same time (0 = one per available CPU)
+    size_t cacheEntries = 4;   ///< Dictionaries and text indexes shared by the jobs, per kind (0 = none)
+    bool statsJson = false;    ///< Print the statistics of every job as one JSON object
+    bool quiet = false;        ///< Print nothing but errors
+};
+
+/**
+ * @brief One job of a manifest
+ */
+struct BatchJob {
+    nlohmann::json id;              ///< Identifier echoed in the results
+    std::vector<std::string> args;  ///< Command arguments without the program name
+};
+
+/**
+ * @brief Read the jobs of a manifest
+ *
+ * A manifest ending in .tsv holds one job per line, its arguments separated
+ * by tabs; blank lines and lines starting with '#' are skipped, and a job's
+ * id is its line number. Any other manifest is JSON: an array of jobs or
+ * one job per line, each either {"id": any, "args": [...]} or an array of
+ * arguments; a job without an id gets its 1-based position.
+ *
+ *   [{"id": "shop-1", "args": ["pipeline", "shop-1.txt", "shop-1.words.tsv"]},
+ *    ["pmi", "shop-2.txt", "shop-2.tsv", "--n", "2"]]
+ *
+ * @param path Manifest path
+ * @return std::vector<BatchJob> Jobs in manifest order
+ * @throws std::runtime_error If the manifest cannot be read or is malformed
+ */
+std::vector<BatchJob> readBatchManifest(const std::string& path);
+
+/**
+ * @brief Run every job of a manifest and report each one's result
+ *
+ * The jobs are the normalize, pmi, merge, word-extract, pipeline and
+ * dict-build commands, with the restrictions of serve jobs (see
+ * OptionsParser::parseJob()). They run maxJobs at a time on one process,
+ * sharing its thread pool, ICU normalizers and warm dictionaries, largest
+ * input first so the long jobs do not start last and leave cores idle at
+ * the end. Jobs that leave --threads on auto split the available CPUs
+ * among the jobs running at once. A failing job does not stop the others.
+ *
+ * @param options Batch settings
+ * @return int Exit code: 0 if every job succeeded, 1 otherwise
+ * @throws std::runtime_error If the manifest cannot be read
+ */
+int runBatch(const BatchOptions& options);
+
+} // namespace cli
+} // namespace suzume
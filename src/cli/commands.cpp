@@ -0,0 +1,300 @@
+/**
+ * @file commands.cpp
+ * @brief Implementation of command execution
+ */
+
+#include "commands.h"
+#include <chrono>
+#include <sstream>
+#include <stdexcept>
+#include "core/normalize.h"
+#include "core/pipeline.h"
+#include "core/pmi.h"
+#include "core/static_dictionary.h"
+#include "core/text_utils.h"
+#include "core/word_extraction.h"
+#include "parallel/thread_pool.h"
+
+// For convenience
+using json = nlohmann::json;
+
+namespace suzume {
+namespace cli {
+
+namespace {
+
+// Measured memory of one operation, as reported by --stats-json
+json memoryJson(const suzume::MemoryStats& memory) {
+    json phases = json::array();
+    for (const auto& phase : memory.phases) {
+        phases.push_back({
+            {"phase", phase.phase},
+            {"peak_bytes", phase.peakBytes},
+            {"peak_resident_bytes", phase.peakResidentBytes}
+        });
+    }
+    json subsystems = json::object();
+    for (const auto& subsystem : memory.subsystems) {
+        subsystems[subsystem.subsystem] = subsystem.peakBytes;
+    }
+    return {
+        {"peak_bytes", memory.peakBytes},
+        {"peak_resident_bytes", memory.peakResidentBytes},
+        {"phases", phases},
+        {"subsystem_peak_bytes", subsystems},
+        {"limit_bytes", memory.limitBytes}
+    };
+}
+
+// Hardware counters of an operation or phase, as reported by --stats-json --perf-counters
+json countersJson(const suzume::HardwareCounters& counters) {
+    return {
+        {"cycles", counters.cycles},
+        {"instructions", counters.instructions},
+        {"ipc", counters.ipc},
+        {"cache_references", counters.cacheReferences},
+        {"cache_misses", counters.cacheMisses},
+        {"cache_miss_rate", counters.cacheMissRate},
+        {"branches", counters.branches},
+        {"branch_misses", counters.branchMisses},
+        {"branch_miss_rate", counters.branchMissRate}
+    };
+}
+
+// Measured time and throughput of one operation, as reported by --stats-json
+json metricsJson(const suzume::OperationMetrics& metrics) {
+    json phases = json::array();
+    for (const auto& phase : metrics.phases) {
+        json entry = {
+            {"phase", phase.phase},
+            {"elapsed_ms", phase.elapsedMs},
+            {"cpu_ms", phase.cpuMs},
+            {"bytes_out", phase.bytesOut},
+            {"thread_utilization", phase.threadUtilization}
+        };
+        if (phase.counters.available) {
+            entry["hardware_counters"] = countersJson(phase.counters);
+        }
+        phases.push_back(entry);
+    }
+    json result = {
+        {"elapsed_ms", metrics.elapsedMs},
+        {"cpu_ms", metrics.cpuMs},
+        {"bytes_in", metrics.bytesIn},
+        {"bytes_out", metrics.bytesOut},
+        {"lines", metrics.lines},
+        {"lines_per_sec", metrics.linesPerSec},
+        {"mb_per_sec", metrics.mbPerSec},
+        {"threads", metrics.threads},
+        {"thread_utilization", metrics.threadUtilization},
+        {"phases", phases}
+    };
+    if (metrics.counters.available) {
+        result["hardware_counters"] = countersJson(metrics.counters);
+    }
+    if (!metrics.tuning.variant.empty()) {
+        result["tuning"] = {
+            {"threads", metrics.tuning.threads},
+            {"available_cpus", metrics.tuning.availableCpus},
+            {"chunk_bytes", metrics.tuning.chunkBytes},
+            {"variant", metrics.tuning.variant},
+            {"reason", metrics.tuning.reason}
+        };
+    }
+    return result;
+}
+
+} // namespace
+
+json runCommand(const OptionsParser& options) {
+    if (options.isNormalizeCommand()) {
+        // Sampling, if requested, happens inside normalize
+        suzume::NormalizeResult result = suzume::core::normalize(
+            options.getInputPath(),
+            options.getOutputPath(),
+            options.getNormalizeOptions()
+        );
+
+        return {
+            {"command", "normalize"},
+            {"input", options.getInputPath()},
+            {"output", options.getOutputPath()},
+            {"sampled", options.getSampleSize() > 0},
+            {"sample_size", options.getSampleSize()},
+            {"rows", result.rows},
+            {"uniques", result.uniques},
+            {"duplicates", result.duplicates},
+            {"elapsed_ms", result.elapsedMs},
+            {"mb_per_sec", result.mbPerSec},
+            {"memory", memoryJson(result.memory)},
+            {"metrics", metricsJson(result.metrics)}
+        };
+    } else if (options.isPmiCommand()) {
+        // Run PMI calculation
+        suzume::PmiResult result = suzume::core::calculatePmi(
+            options.getInputPath(),
+            options.getOutputPath(),
+            options.getPmiOptions()
+        );
+
+        json stats = {
+            {"command", "pmi"},
+            {"input", options.getInputPath()},
+            {"output", options.getOutputPath()},
+            {"n", options.getPmiOptions().n},
+            {"grams", result.grams},
+            {"distinct_ngrams", result.distinctNgrams},
+            {"elapsed_ms", result.elapsedMs},
+            {"mb_per_sec", result.mbPerSec},
+            {"memory", memoryJson(result.memory)},
+            {"metrics", metricsJson(result.metrics)}
+        };
+        if (!result.orders.empty()) {
+            json orders = json::array();
+            for (const auto& order : result.orders) {
+                orders.push_back({
+                    {"n", order.n},
+                    {"grams", order.grams},
+                    {"distinct_ngrams", order.distinctNgrams},
+                    {"output", order.outputPath}
+                });
+            }
+            stats["orders"] = orders;
+        }
+        if (options.getPmiOptions().approximate) {
+            stats["count_error_bound"] = result.countErrorBound;
+            stats["error_probability"] = result.errorProbability;
+        }
+        if (options.getPmiOptions().memoryBudget > 0 || result.memory.limitBytes > 0) {
+            const char* strategy = result.budgetStrategy == suzume::MemoryBudgetStrategy::Prune ? "prune"
+                : result.budgetStrategy == suzume::MemoryBudgetStrategy::Spill ? "spill" : "none";
+            stats["budget_strategy"] = strategy;
+            if (result.budgetStrategy == suzume::MemoryBudgetStrategy::Prune) {
+                stats["count_error_bound"] = result.countErrorBound;
+            }
+        }
+        return stats;
+    } else if (options.isMergeCommand()) {
+        // Reduce partition snapshots against the global marginals
+        suzume::PmiResult result = suzume::core::calculatePmiFromPartitions(
+            options.getMergeInputPaths(),
+            options.getMarginalPaths(),
+            options.getOutputPath(),
+            options.getPmiOptions()
+        );
+
+        return {
+            {"command", "merge"},
+            {"partitions", options.getMergeInputPaths()},
+            {"marginals", options.getMarginalPaths()},
+            {"output", options.getOutputPath()},
+            {"grams", result.grams},
+            {"distinct_ngrams", result.distinctNgrams},
+            {"elapsed_ms", result.elapsedMs},
+            {"mb_per_sec", result.mbPerSec},
+            {"memory", memoryJson(result.memory)},
+            {"metrics", metricsJson(result.metrics)}
+        };
+    } else if (options.isWordExtractCommand()) {
+        // Run word extraction
+        suzume::WordExtractionResult result = suzume::core::extractWords(
+            options.getInputPath(),
+            options.getOriginalTextPath(),
+            options.getWordExtractionOptions()
+        );
+        suzume::core::writeWordList(result, options.getOutputPath());
+
+        return {
+            {"command", "word-extract"},
+            {"pmi_input", options.getInputPath()},
+            {"original_text", options.getOriginalTextPath()},
+            {"output", options.getOutputPath()},
+            {"words_count", result.words.size()},
+            {"reused_candidates", result.reusedCandidates},
+            {"processing_time_ms", result.processingTimeMs},
+            {"memory_usage_bytes", result.memoryUsageBytes},
+            {"memory", memoryJson(result.memory)},
+            {"metrics", metricsJson(result.metrics)}
+        };
+    } else if (options.isPipelineCommand()) {
+        // Run every stage in memory and write only the words
+        suzume::PipelineResult result = suzume::core::runPipeline(
+            options.getInputPath(),
+            options.getPipelineOptions()
+        );
+        suzume::core::writeWordList(result.words, options.getOutputPath());
+
+        return {
+            {"command", "pipeline"},
+            {"input", options.getInputPath()},
+            {"output", options.getOutputPath()},
+            {"rows", result.normalize.rows},
+            {"uniques", result.normalize.uniques},
+            {"grams", result.pmi.grams},
+            {"distinct_ngrams", result.pmi.distinctNgrams},
+            {"words_count", result.words.words.size()},
+            {"elapsed_ms", result.elapsedMs},
+            {"memory", {
+                {"normalize", memoryJson(result.normalize.memory)},
+                {"pmi", memoryJson(result.pmi.memory)},
+                {"word_extract", memoryJson(result.words.memory)}
+            }},
+            {"metrics", {
+                {"normalize", metricsJson(result.normalize.metrics)},
+                {"pmi", metricsJson(result.pmi.metrics)},
+                {"word_extract", metricsJson(result.words.metrics)}
+            }}
+        };
+    } else if (options.isDictBuildCommand()) {
+        // Build the dictionary once; word-extract maps it at startup
+        auto startTime = std::chrono::high_resolution_clock::now();
+        size_t entries = suzume::core::buildStaticDictionary(options.getInputPath(), options.getOutputPath());
+        auto endTime = std::chrono::high_resolution_clock::now();
+        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+        return {
+            {"command", "dict-build"},
+            {"input", options.getInputPath()},
+            {"output", options.getOutputPath()},
+            {"entries", entries},
+            {"elapsed_ms", elapsedMs}
+        };
+    }
+
+    // This should not happen due to CLI11's requirement for a subcommand
+    throw std::invalid_argument("No command selected");
+}
+
+std::string commandSummary(const OptionsParser& options, const json& stats) {
+    std::ostringstream summary;
+    if (options.isNormalizeCommand() && options.getNormalizeOptions().progressCallback) {
+        if (options.getSampleSize() > 0) {
+            summary << "Sampled " << options.getSampleSize() << " lines, processed "
+                    << stats["rows"].get<uint64_t>() << " rows, " << stats["uniques"].get<uint64_t>() << " unique";
+        } else {
+            summary << "Processed " << stats["rows"].get<uint64_t>() << " rows, "
+                    << stats["uniques"].get<uint64_t>() << " unique";
+        }
+    } else if (options.isPmiCommand() && options.getPmiOptions().progressCallback) {
+        summary << "Processed " << stats["grams"].get<uint64_t>() << " n-grams";
+    } else if (options.isMergeCommand() && options.getPmiOptions().progressCallback) {
+        summary << "Merged " << stats["grams"].get<uint64_t>() << " n-grams";
+    } else if (options.isWordExtractCommand() && options.getWordExtractionOptions().progressCallback) {
+        summary << "Extracted " << stats["words_count"].get<uint64_t>() << " unknown words";
+    } else if (options.isPipelineCommand() && options.getPipelineOptions().progressCallback) {
+        summary << "Processed " << stats["rows"].get<uint64_t>() << " rows, " << stats["grams"].get<uint64_t>()
+                << " n-grams, extracted " << stats["words_count"].get<uint64_t>() << " unknown words";
+    } else if (options.isDictBuildCommand() && !options.isQuiet()) {
+        summary << "Built dictionary with " << stats["entries"].get<uint64_t>() << " words";
+    }
+    return summary.str();
+}
+
+void warmUpProcess() {
+    parallel::ThreadPool::global();
+    core::normalizeLine("warm-up", NormalizationForm::NFKC);
+    core::normalizeLine("warm-up", NormalizationForm::NFC);
+}
+
+} // namespace cli
+} // namespace suzume
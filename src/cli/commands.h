@@ -0,0 +1,43 @@
+/**
+ * @file commands.h
+ * @brief Execution of the parsed commands, shared by the CLI and the serve daemon
+ */
+
+#pragma once
+
+#include <string>
+#include <nlohmann/json.hpp>
+#include "options.h"
+
+namespace suzume {
+namespace cli {
+
+/**
+ * @brief Run the command the options select
+ *
+ * @param options Parsed options of normalize, pmi, merge, word-extract, pipeline or dict-build
+ * @return nlohmann::json Statistics of the run, as printed by --stats-json
+ * @throws std::invalid_argument If no runnable command was selected
+ * @throws std::runtime_error If the command fails
+ */
+nlohmann::json runCommand(const OptionsParser& options);
+
+/**
+ * @brief Get the one-line summary printed after a command without --stats-json
+ *
+ * @param options Options the command ran with
+ * @param stats Statistics returned by runCommand()
+ * @return std::string Summary, or empty if the command prints none (no progress output, quiet)
+ */
+std::string commandSummary(const OptionsParser& options, const nlohmann::json& stats);
+
+/**
+ * @brief Pay the one-time setup of a fresh process before the first job
+ *
+ * Starts the thread pool and loads the ICU normalizers, so processes that
+ * run many jobs (serve, batch) do not charge it to whichever job runs first.
+ */
+void warmUpProcess();
+
+} // namespace cli
+} // namespace suzume
@@ -5,9 +5,14 @@
 
 #include "options.h"
 #include "src/cli/version.h"
+#include "core/async_io.h"
+#include "core/hardware_counters.h"
+#include "core/input_files.h"
+#include "core/memory_accounting.h"
 #include <iostream>
 #include <chrono>
 #include <sstream>
+#include <stdexcept>
 
 namespace suzume {
 namespace cli {
@@ -130,7 +135,12 @@ OptionsParser::OptionsParser() {
     // Setup commands and options
     setupNormalizeCommand();
     setupPmiCommand();
+    setupMergeCommand();
     setupWordExtractCommand();
+    setupPipelineCommand();
+    setupDictBuildCommand();
+    setupServeCommand();
+    setupBatchCommand();
     setupGlobalOptions();
 }
 
@@ -139,11 +149,13 @@ void OptionsParser::setupNormalizeCommand() {
     normalizeCommand = app.add_subcommand("normalize", "Normalize and deduplicate text data");
 
     // Add input/output options
-    normalizeCommand->add_option("input", inputPath, "Input file path (use - for stdin)")
+    normalizeCommand->add_option("input", inputPath, "Input file, directory or quoted glob (use - for stdin)")
         ->required()
         ->check([](const std::string& path) {
             // Allow "-" for stdin
             if (path == "-") return std::string();
+            // Directories and globs are expanded by the library
+            if (suzume::core::isInputPattern(path)) return std::string();
             // Otherwise check if file exists
             return CLI::ExistingFile(path);
         });
@@ -169,7 +181,7 @@ void OptionsParser::setupNormalizeCommand() {
                                "Number of threads (0 = auto)");
 
     // Add sample option
-    normalizeCommand->add_option("--sample", sampleSize,
+    normalizeCommand->add_option("--sample", normalizeOptions.sampleSize,
                                "Sample N lines randomly from input")
         ->check(CLI::PositiveNumber);
 
@@ -182,6 +194,80 @@ void OptionsParser::setupNormalizeCommand() {
                                "Maximum line length (0 = no maximum)")
         ->check(CLI::NonNegativeNumber);
 
+    // Add streaming options
+    normalizeCommand->add_flag("--stream", normalizeOptions.streaming,
+                             "Process input in bounded batches (constant memory)");
+
+    normalizeCommand->add_option_function<uint64_t>("--max-memory",
+        [this](const uint64_t& megabytes) {
+            normalizeOptions.maxMemoryUsage = megabytes * 1024 * 1024;
+        },
+        "Line buffer budget for --stream in MB (default: 100)")
+        ->check(CLI::PositiveNumber);
+
+    normalizeCommand->add_option("--dedup-index", normalizeOptions.dedupIndexPath,
+                               "Dedup index from earlier runs; lines in it are skipped and it is updated");
+
+    normalizeCommand->add_flag("--preserve-order", normalizeOptions.preserveOrder,
+                             "Write unique lines in input order at any thread count");
+
+    normalizeCommand->add_flag("--external-dedup", normalizeOptions.externalDedup,
+                             "Dedup on disk for more unique lines than fit in memory");
+
+    normalizeCommand->add_flag("--sort", normalizeOptions.sortedOutput,
+                             "Write unique lines sorted (as LC_ALL=C sort -u), spilling sorted runs to disk");
+
+    normalizeCommand->add_option("--temp-dir", normalizeOptions.tempDir,
+                               "Directory for --external-dedup and --sort spill files (default: /tmp)");
+
+    normalizeCommand->add_option("--near-dup", normalizeOptions.nearDupDistance,
+                               "Drop lines within BITS SimHash bits of a kept line (default: off)")
+        ->check(CLI::Range(1, 31));
+
+    normalizeCommand->add_option("--near-dup-max-lines", normalizeOptions.nearDupMaxLines,
+                               "Cap on lines indexed by --near-dup (default: unlimited)");
+
+    normalizeCommand->add_option("--columns", normalizeOptions.normalizeColumns,
+                               "Normalize only these 1-based TSV columns, e.g. 2,5; others pass through unchanged")
+        ->delimiter(',')
+        ->check(CLI::PositiveNumber);
+
+    normalizeCommand->add_option("--dedup-key", normalizeOptions.dedupColumns,
+                               "Dedup on these 1-based TSV columns instead of the whole line, e.g. 1 or 1,3")
+        ->delimiter(',')
+        ->check(CLI::PositiveNumber);
+
+    normalizeCommand->add_flag("--numa", normalizeOptions.numaAware,
+                             "Pin worker threads to CPUs node by node");
+
+    normalizeCommand->add_flag("--compress", normalizeOptions.compressOutput,
+                             "Write zstd output (implied by a .zst output path)");
+
+    normalizeCommand->add_option("--checkpoint", normalizeOptions.checkpointPath,
+                               "Checkpoint the input and output offsets and the dedup state here as the run goes");
+
+    normalizeCommand->add_option_function<uint64_t>("--checkpoint-interval",
+        [this](const uint64_t& megabytes) {
+            normalizeOptions.checkpointInterval = megabytes * 1024 * 1024;
+        },
+        "Input MB between checkpoints (default: 256)")
+        ->check(CLI::PositiveNumber);
+
+    normalizeCommand->add_flag("--resume", normalizeOptions.resume,
+                             "Continue from the --checkpoint an interrupted run left");
+
+    std::vector<std::pair<std::string, ShardRouting>> shard_map = {
+        {"hash", ShardRouting::Hash},
+        {"round-robin", ShardRouting::RoundRobin}
+    };
+    normalizeCommand->add_option("--shards", normalizeOptions.outputShards,
+                               "Split the output into N files out-00000-of-0000N... (default: one file)")
+        ->check(CLI::Range(1, 99999));
+
+    normalizeCommand->add_option("--shard-by", normalizeOptions.shardRouting,
+                               "Assign lines to shards by content hash or round robin (default: hash)")
+        ->transform(CLI::CheckedTransformer(shard_map, CLI::ignore_case));
+
     // Store progress format as an enum directly
     normalizeProgressFormat = ProgressFormat::TTY; // Default value
     std::vector<std::pair<std::string, ProgressFormat>> progress_map = {
@@ -215,11 +301,13 @@ void OptionsParser::setupPmiCommand() {
     pmiCommand = app.add_subcommand("pmi", "Calculate PMI (Pointwise Mutual Information)");
 
     // Add input/output options
-    pmiCommand->add_option("input", inputPath, "Input file path (use - for stdin)")
+    pmiCommand->add_option("input", inputPath, "Input file, directory or quoted glob (use - for stdin)")
         ->required()
         ->check([](const std::string& path) {
             // Allow "-" for stdin
             if (path == "-") return std::string();
+            // Directories and globs are expanded by the library
+            if (suzume::core::isInputPattern(path)) return std::string();
             // Otherwise check if file exists
             return CLI::ExistingFile(path);
         });
@@ -239,6 +327,103 @@ void OptionsParser::setupPmiCommand() {
 
     pmiCommand->add_option("--threads", pmiOptions.threads, "Number of threads (0 = auto)");
 
+    pmiCommand->add_flag("--all-orders", pmiOptions.allOrders,
+                         "Count every order from 1 to --n in one pass (writes OUTPUT.<k>gram.<ext> per order)");
+
+    pmiCommand->add_flag("--approximate", pmiOptions.approximate,
+                         "Count in a fixed-size Count-Min sketch and score only the heavy hitters");
+
+    pmiCommand->add_option("--sketch-width", pmiOptions.sketchWidth, "Counters per sketch row (approximate mode)")
+        ->check(CLI::Range(1u, 1u << 30));
+
+    pmiCommand->add_option("--sketch-depth", pmiOptions.sketchDepth, "Sketch rows (approximate mode)")
+        ->check(CLI::Range(1, 16));
+
+    pmiCommand->add_option("--heavy-hitters", pmiOptions.heavyHitters,
+                           "Candidate n-grams tracked (approximate mode, 0 = 4 x --top)");
+
+    pmiCommand->add_option("--window", pmiOptions.window,
+                           "Score ordered pairs of units at most K apart instead of n-grams (ignores --n)")
+        ->check(CLI::Range(1, 32));
+
+    std::vector<std::pair<std::string, CooccurrenceUnit>> unit_map = {
+        {"char", CooccurrenceUnit::Character},
+        {"token", CooccurrenceUnit::Token}
+    };
+    pmiCommand->add_option("--unit", pmiOptions.cooccurrenceUnit,
+                           "Units paired by --window: characters or space-separated tokens (default: char)")
+        ->transform(CLI::CheckedTransformer(unit_map, CLI::ignore_case));
+
+    pmiCommand->add_option("--snapshot", pmiOptions.snapshotPath,
+                           "Also write the n-gram counts as a binary snapshot (inputs may be snapshots too)");
+
+    pmiCommand->add_option("--snapshot-partitions", pmiOptions.snapshotPartitions,
+                           "Split the snapshot into N key-hash partitions plus marginals, for the merge command")
+        ->check(CLI::Range(1, 4096));
+
+    pmiCommand->add_option("--binary-output", pmiOptions.binaryOutputPath,
+                           "Also write the results in the binary format read by word-extract");
+
+    pmiCommand->add_option("--stats-output", pmiOptions.statsOutputPath,
+                           "Also write occurrence statistics of the results, read by word-extract --pmi-stats");
+
+    pmiCommand->add_option_function<uint64_t>("--memory-budget",
+        [this](const uint64_t& megabytes) {
+            pmiOptions.memoryBudget = megabytes * 1024 * 1024;
+        },
+        "Memory for the exact counting tables in MB (default: unlimited)")
+        ->check(CLI::PositiveNumber);
+
+    std::vector<std::pair<std::string, MemoryBudgetStrategy>> budget_map = {
+        {"prune", MemoryBudgetStrategy::Prune},
+        {"spill", MemoryBudgetStrategy::Spill}
+    };
+    pmiCommand->add_option("--budget-strategy", pmiOptions.budgetStrategy,
+                           "On crossing --memory-budget: prune low counts or spill sorted runs (default: prune)")
+        ->transform(CLI::CheckedTransformer(budget_map, CLI::ignore_case));
+
+    std::vector<std::pair<std::string, CountingBackend>> backend_map = {
+        {"cpu", CountingBackend::Cpu},
+        {"gpu", CountingBackend::Gpu}
+    };
+    pmiCommand->add_option("--count-backend", pmiOptions.countingBackend,
+                           "Count exact n-grams on CPU threads or a CUDA GPU (default: cpu)")
+        ->transform(CLI::CheckedTransformer(backend_map, CLI::ignore_case));
+
+    pmiCommand->add_option("--temp-dir", pmiOptions.tempDir,
+                           "Directory for spilled runs (default: /tmp)");
+
+    pmiCommand->add_flag("--numa", pmiOptions.numaAware,
+                         "Pin workers node by node, keep their tables on their node and merge per node first");
+
+    pmiCommand->add_flag("--compress", pmiOptions.compressOutput,
+                         "Write zstd output (implied by a .zst output path)");
+
+    pmiCommand->add_option("--checkpoint", pmiOptions.checkpointPath,
+                           "Checkpoint the input offset and the counts so far here as counting goes");
+
+    pmiCommand->add_option_function<uint64_t>("--checkpoint-interval",
+        [this](const uint64_t& megabytes) {
+            pmiOptions.checkpointInterval = megabytes * 1024 * 1024;
+        },
+        "Input MB between checkpoints (default: 256)")
+        ->check(CLI::PositiveNumber);
+
+    pmiCommand->add_flag("--resume", pmiOptions.resume,
+                         "Continue from the --checkpoint an interrupted run left");
+
+    std::vector<std::pair<std::string, ShardRouting>> shard_map = {
+        {"hash", ShardRouting::Hash},
+        {"round-robin", ShardRouting::RoundRobin}
+    };
+    pmiCommand->add_option("--shards", pmiOptions.outputShards,
+                           "Split the results into N files, each with the header (default: one file)")
+        ->check(CLI::Range(1, 99999));
+
+    pmiCommand->add_option("--shard-by", pmiOptions.shardRouting,
+                           "Assign rows to shards by n-gram hash or round robin (default: hash)")
+        ->transform(CLI::CheckedTransformer(shard_map, CLI::ignore_case));
+
     // Store progress format as an enum directly
     pmiProgressFormat = ProgressFormat::TTY; // Default value
     std::vector<std::pair<std::string, ProgressFormat>> progress_map = {
@@ -267,6 +452,60 @@ void OptionsParser::setupPmiCommand() {
     });
 }
 
+void OptionsParser::setupMergeCommand() {
+    // Add merge command
+    mergeCommand = app.add_subcommand("merge", "Reduce partition snapshots from several machines to PMI");
+
+    // Add input/output options
+    mergeCommand->add_option("partitions", mergeInputPaths, "Partition snapshots written with --snapshot-partitions")
+        ->required()
+        ->check(CLI::ExistingFile);
+
+    mergeCommand->add_option("output", outputPath, "Output file path (use - for stdout)")
+        ->required();
+
+    mergeCommand->add_option("--marginals", marginalPaths, "Marginal snapshots of every counting machine")
+        ->required()
+        ->check(CLI::ExistingFile);
+
+    // Scoring options apply as in the pmi command
+    mergeCommand->add_option("--top", pmiOptions.topK, "Number of top results")
+        ->check(CLI::Range(1, 100000));
+
+    mergeCommand->add_option("--min-freq", pmiOptions.minFreq, "Minimum frequency threshold")
+        ->check(CLI::Range(1, 1000));
+
+    mergeCommand->add_option("--snapshot", pmiOptions.snapshotPath,
+                             "Also write the merged counts as a binary snapshot");
+
+    // Store progress format as an enum directly
+    mergeProgressFormat = ProgressFormat::TTY; // Default value
+    std::vector<std::pair<std::string, ProgressFormat>> progress_map = {
+        {"tty", ProgressFormat::TTY},
+        {"json", ProgressFormat::JSON},
+        {"none", ProgressFormat::NONE}
+    };
+    mergeCommand->add_option("--progress", mergeProgressFormat,
+                             "Progress display mode (tty, json, or none)")
+        ->transform(CLI::CheckedTransformer(progress_map, CLI::ignore_case));
+
+    // Add callbacks for post-processing - using direct enum values
+    mergeCommand->callback([this]() {
+        // Set progress callback based on format
+        switch (mergeProgressFormat) {
+            case ProgressFormat::TTY:
+                pmiOptions.progressCallback = ttyProgressCallbackWithEta;
+                break;
+            case ProgressFormat::JSON:
+                pmiOptions.progressCallback = jsonProgressCallbackWithEta;
+                break;
+            case ProgressFormat::NONE:
+                pmiOptions.progressCallback = nullptr;
+                break;
+        }
+    });
+}
+
 void OptionsParser::setupWordExtractCommand() {
     // Add word-extract command
     wordExtractCommand = app.add_subcommand("word-extract", "Extract unknown words from PMI results");
@@ -309,6 +548,35 @@ void OptionsParser::setupWordExtractCommand() {
     };
     wordExtractCommand->add_flag("--no-verify", noVerifyCallback, "Disable verification in original text");
 
+    wordExtractCommand->add_flag("--batch-verify", wordExtractionOptions.batchVerification,
+                                "Count all candidates in one pass over the original text");
+
+    wordExtractCommand->add_flag("--stream-verify", wordExtractionOptions.streamingVerification,
+                                "Scan the original text block by block, for texts larger than memory");
+
+    wordExtractCommand->add_option_function<uint64_t>("--verify-block-size",
+        [this](const uint64_t& megabytes) {
+            wordExtractionOptions.verificationBlockSize = megabytes * 1024 * 1024;
+        },
+        "Block size of --stream-verify in MB (default: 64)")
+        ->check(CLI::PositiveNumber);
+
+    wordExtractCommand->add_option("--index-cache", wordExtractionOptions.textIndexPath,
+                                  "Keep the suffix array of the original text in this file and reuse it");
+
+    wordExtractCommand->add_option("--pmi-stats", wordExtractionOptions.pmiStatsPath,
+                                  "Look candidates up in statistics written by pmi --stats-output instead of searching the original text");
+
+    wordExtractCommand->add_option("--incremental-state", wordExtractionOptions.incrementalStatePath,
+                                  "Reuse the evidence of the previous run's candidates kept in this file, and rewrite it");
+
+    wordExtractCommand->add_option("--incremental-tolerance", wordExtractionOptions.incrementalTolerance,
+                                  "Relative PMI score and frequency change that keeps a candidate's evidence over a changed text (default: 0.05)")
+        ->check(CLI::NonNegativeNumber);
+
+    wordExtractCommand->add_flag("--lazy", wordExtractionOptions.lazyEvaluation,
+                                "Stop verifying once no candidate left can enter the top results");
+
     auto noContextCallback = [this](int count) {
         if (count > 0) wordExtractionOptions.useContextualAnalysis = false;
     };
@@ -373,6 +641,138 @@ void OptionsParser::setupWordExtractCommand() {
     });
 }
 
+void OptionsParser::setupPipelineCommand() {
+    // Add pipeline command
+    pipelineCommand = app.add_subcommand("pipeline",
+                                         "Normalize, calculate PMI and extract unknown words without intermediate files");
+
+    // Add input/output options
+    pipelineCommand->add_option("input", inputPath, "Input file path (use - for stdin)")
+        ->required()
+        ->check([](const std::string& path) {
+            // Allow "-" for stdin
+            if (path == "-") return std::string();
+            return CLI::ExistingFile(path);
+        });
+
+    pipelineCommand->add_option("output", outputPath, "Output file path for the extracted words (use - for stdout)")
+        ->required();
+
+    // Normalization options
+    std::vector<std::pair<std::string, suzume::NormalizationForm>> form_map = {
+        {"NFKC", suzume::NormalizationForm::NFKC},
+        {"NFC", suzume::NormalizationForm::NFC}
+    };
+    pipelineCommand->add_option("--form", pipelineOptions.normalize.form, "Normalization form (NFKC or NFC)")
+        ->transform(CLI::CheckedTransformer(form_map, CLI::ignore_case));
+
+    // PMI options
+    pipelineCommand->add_option("--n", pipelineOptions.pmi.n, "N-gram size (1, 2, or 3)")
+        ->check(CLI::Range(1, 3));
+
+    pipelineCommand->add_option("--pmi-top", pipelineOptions.pmi.topK, "Number of top PMI results passed on")
+        ->check(CLI::Range(1, 100000));
+
+    pipelineCommand->add_option("--min-freq", pipelineOptions.pmi.minFreq, "Minimum frequency threshold")
+        ->check(CLI::Range(1, 1000));
+
+    // Word extraction options
+    pipelineCommand->add_option("--min-pmi", pipelineOptions.wordExtraction.minPmiScore, "Minimum PMI score")
+        ->check(CLI::Range(0.0, 100.0));
+
+    pipelineCommand->add_option("--top", pipelineOptions.wordExtraction.topK, "Number of top words")
+        ->check(CLI::Range(1, 100000));
+
+    pipelineCommand->add_flag("--batch-verify", pipelineOptions.wordExtraction.batchVerification,
+                              "Count all candidates in one pass over the corpus");
+
+    pipelineCommand->add_flag("--lazy", pipelineOptions.wordExtraction.lazyEvaluation,
+                              "Stop verifying once no candidate left can enter the top words");
+
+    // Threads apply to every stage
+    pipelineCommand->add_option_function<uint32_t>("--threads", [this](const uint32_t& threads) {
+        pipelineOptions.normalize.threads = threads;
+        pipelineOptions.pmi.threads = threads;
+        pipelineOptions.wordExtraction.threads = threads;
+    }, "Number of threads (0 = auto)");
+
+    // Store progress format as an enum directly
+    pipelineProgressFormat = ProgressFormat::TTY; // Default value
+    std::vector<std::pair<std::string, ProgressFormat>> progress_map = {
+        {"tty", ProgressFormat::TTY},
+        {"json", ProgressFormat::JSON},
+        {"none", ProgressFormat::NONE}
+    };
+    pipelineCommand->add_option("--progress", pipelineProgressFormat,
+                                "Progress display mode (tty, json, or none)")
+        ->transform(CLI::CheckedTransformer(progress_map, CLI::ignore_case));
+
+    // Add callbacks for post-processing - using direct enum values
+    pipelineCommand->callback([this]() {
+        // Set progress callback based on format
+        switch (pipelineProgressFormat) {
+            case ProgressFormat::TTY:
+                pipelineOptions.progressCallback = ttyProgressCallbackWithEta;
+                break;
+            case ProgressFormat::JSON:
+                pipelineOptions.progressCallback = jsonProgressCallbackWithEta;
+                break;
+            case ProgressFormat::NONE:
+                pipelineOptions.progressCallback = nullptr;
+                break;
+        }
+    });
+}
+
+void OptionsParser::setupDictBuildCommand() {
+    // Add dict-build command
+    dictBuildCommand = app.add_subcommand("dict-build", "Build a static dictionary for --dictionary");
+
+    // Add input/output options
+    dictBuildCommand->add_option("input", inputPath, "Word list, one word per line")
+        ->required()
+        ->check(CLI::ExistingFile);
+
+    dictBuildCommand->add_option("output", outputPath, "Output dictionary path")
+        ->required();
+}
+
+void OptionsParser::setupServeCommand() {
+    // Add serve command
+    serveCommand = app.add_subcommand("serve", "Run jobs sent as JSON over a Unix domain socket, keeping state warm");
+
+    serveCommand->add_option("--socket", serveOptions.socketPath, "Unix domain socket to listen on")
+        ->required();
+
+    serveCommand->add_option("--max-jobs", serveOptions.maxJobs, "Jobs run at the same time")
+        ->check(CLI::PositiveNumber);
+
+    serveCommand->add_option("--queue", serveOptions.queueLimit,
+                             "Jobs waiting for a slot before new ones are turned away as busy")
+        ->check(CLI::NonNegativeNumber);
+
+    serveCommand->add_option("--cache-entries", serveOptions.cacheEntries,
+                             "Dictionaries and text indexes kept loaded between jobs, per kind (0 = none)")
+        ->check(CLI::NonNegativeNumber);
+}
+
+void OptionsParser::setupBatchCommand() {
+    // Add batch command
+    batchCommand = app.add_subcommand("batch", "Run the jobs of a manifest concurrently in one process");
+
+    batchCommand->add_option("manifest", batchOptions.manifestPath,
+                             "Jobs as JSON (an array or one per line) or TSV (one per line, tab-separated arguments)")
+        ->required()
+        ->check(CLI::ExistingFile);
+
+    batchCommand->add_option("--max-jobs", batchOptions.maxJobs, "Jobs run at the same time (0 = one per CPU)")
+        ->check(CLI::NonNegativeNumber);
+
+    batchCommand->add_option("--cache-entries", batchOptions.cacheEntries,
+                             "Dictionaries and text indexes shared by the jobs, per kind (0 = none)")
+        ->check(CLI::NonNegativeNumber);
+}
+
 void OptionsParser::setupGlobalOptions() {
     // Set custom exit callback to handle help properly
     app.set_help_flag("-h,--help", "Print this help message and exit");
@@ -389,20 +789,58 @@ void OptionsParser::setupGlobalOptions() {
         normalizeOptions.progressCallback = nullptr;
         pmiOptions.progressCallback = nullptr;
         wordExtractionOptions.progressCallback = nullptr;
+        pipelineOptions.progressCallback = nullptr;
         normalizeProgressFormat = ProgressFormat::NONE;
         pmiProgressFormat = ProgressFormat::NONE;
+        mergeProgressFormat = ProgressFormat::NONE;
         wordExtractProgressFormat = ProgressFormat::NONE;
+        pipelineProgressFormat = ProgressFormat::NONE;
+        serveOptions.quiet = true;
+        batchOptions.quiet = true;
+        quiet = true;
     }, "Suppress all output (same as --progress none)");
 
     // Add stats-json flag to each subcommand instead of as a global option
     // This ensures the option is recognized by each subcommand
     normalizeCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
     pmiCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
+    mergeCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
     wordExtractCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
+    pipelineCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
+    dictBuildCommand->add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
+    batchCommand->add_flag("--stats-json", batchOptions.statsJson,
+                           "Output the statistics of every job as JSON to stdout");
 
     // Also add it as a global option for help display
     app.add_flag("--stats-json", statsJson, "Output statistics as JSON to stdout");
 
+    // The I/O backend is process-wide, so every command takes the same flag
+    auto useIoUring = []() {
+        core::setIoBackend(core::IoBackend::IoUring);
+    };
+    const char* ioUringHelp = "Read and write plain files through io_uring (pread/pwrite where unavailable)";
+    auto useMemoryLimit = [](const uint64_t& megabytes) {
+        core::setMemoryLimit(megabytes * 1024 * 1024);
+    };
+    const char* memoryLimitHelp = "Memory to stay within in MB: stream, spill or prune before reaching it";
+    auto usePerfCounters = []() {
+        core::setHardwareCounters(true);
+        if (!core::HardwareCounterSet().available()) {
+            std::cerr << "Warning: Hardware counters are not available (perf_event_open refused them); "
+                      << "metrics are reported without them" << std::endl;
+        }
+    };
+    const char* perfCountersHelp = "Count cycles, instructions, cache and branch misses per phase (Linux perf events)";
+    for (CLI::App* command : {normalizeCommand, pmiCommand, mergeCommand, wordExtractCommand, pipelineCommand,
+                              dictBuildCommand, serveCommand, batchCommand}) {
+        command->add_flag_callback("--io-uring", useIoUring, ioUringHelp);
+        command->add_option_function<uint64_t>("--memory-limit", useMemoryLimit, memoryLimitHelp)
+            ->check(CLI::PositiveNumber);
+        command->add_flag_callback("--perf-counters", usePerfCounters, perfCountersHelp);
+        command->add_option("--trace", tracePath,
+                            "Write a Chrome trace of the phases and worker tasks (chrome://tracing, Perfetto)");
+    }
+
     // Allow 0 or 1 subcommand (0 for help/version, 1 for normal operation)
     app.require_subcommand(0, 1);
 }
@@ -424,6 +862,49 @@ int OptionsParser::parse(int argc, char* argv[]) {
     }
 }
 
+void OptionsParser::parseJob(const std::vector<std::string>& args) {
+    // These act on the whole daemon, not on one job
+    static const char* const processWide[] = {"--io-uring", "--memory-limit", "--perf-counters", "--trace"};
+    static const char* const interactive[] = {"-h", "--help", "--help-all", "-v", "--version"};
+    for (const std::string& arg : args) {
+        std::string flag = arg.substr(0, arg.find('='));
+        for (const char* option : processWide) {
+            if (flag == option) {
+                throw std::invalid_argument(flag + " applies to the whole server; pass it to serve instead");
+            }
+        }
+        for (const char* option : interactive) {
+            if (flag == option) {
+                throw std::invalid_argument(flag + " is not available to jobs");
+            }
+        }
+        if (arg == "-") {
+            throw std::invalid_argument("Jobs cannot read stdin; pass a file path");
+        }
+    }
+    if (!args.empty() && (args.front() == "serve" || args.front() == "batch")) {
+        throw std::invalid_argument(args.front() + " cannot run as a job");
+    }
+
+    // CLI11 takes the arguments in reverse order
+    std::vector<std::string> reversed(args.rbegin(), args.rend());
+    try {
+        app.parse(reversed);
+    } catch (const CLI::Error& e) {
+        throw std::invalid_argument(e.what());
+    }
+    if (!isNormalizeCommand() && !isPmiCommand() && !isMergeCommand() && !isWordExtractCommand()
+        && !isPipelineCommand() && !isDictBuildCommand()) {
+        throw std::invalid_argument("No command given");
+    }
+
+    // Jobs answer with their statistics, never on the daemon's terminal
+    normalizeOptions.progressCallback = nullptr;
+    pmiOptions.progressCallback = nullptr;
+    wordExtractionOptions.progressCallback = nullptr;
+    pipelineOptions.progressCallback = nullptr;
+}
+
 const std::string& OptionsParser::getInputPath() const {
     return inputPath;
 }
@@ -437,7 +918,7 @@ const suzume::NormalizeOptions& OptionsParser::getNormalizeOptions() const {
 }
 
 size_t OptionsParser::getSampleSize() const {
-    return sampleSize;
+    return static_cast<size_t>(normalizeOptions.sampleSize);
 }
 
 const suzume::PmiOptions& OptionsParser::getPmiOptions() const {
@@ -452,6 +933,18 @@ bool OptionsParser::isPmiCommand() const {
     return pmiCommand && pmiCommand->parsed();
 }
 
+bool OptionsParser::isMergeCommand() const {
+    return mergeCommand && mergeCommand->parsed();
+}
+
+const std::vector<std::string>& OptionsParser::getMergeInputPaths() const {
+    return mergeInputPaths;
+}
+
+const std::vector<std::string>& OptionsParser::getMarginalPaths() const {
+    return marginalPaths;
+}
+
 std::string OptionsParser::getVersion() {
     return suzume::cli::getVersion();
 }
@@ -460,14 +953,60 @@ const suzume::WordExtractionOptions& OptionsParser::getWordExtractionOptions() c
     return wordExtractionOptions;
 }
 
+const suzume::PipelineOptions& OptionsParser::getPipelineOptions() const {
+    return pipelineOptions;
+}
+
 bool OptionsParser::isWordExtractCommand() const {
     return wordExtractCommand && wordExtractCommand->parsed();
 }
 
+bool OptionsParser::isPipelineCommand() const {
+    return pipelineCommand && pipelineCommand->parsed();
+}
+
+bool OptionsParser::isDictBuildCommand() const {
+    return dictBuildCommand && dictBuildCommand->parsed();
+}
+
+bool OptionsParser::isServeCommand() const {
+    return serveCommand && serveCommand->parsed();
+}
+
+const ServeOptions& OptionsParser::getServeOptions() const {
+    return serveOptions;
+}
+
+bool OptionsParser::isBatchCommand() const {
+    return batchCommand && batchCommand->parsed();
+}
+
+const BatchOptions& OptionsParser::getBatchOptions() const {
+    return batchOptions;
+}
+
+void OptionsParser::setDefaultThreads(uint32_t threads) {
+    for (uint32_t* stageThreads : {&normalizeOptions.threads, &pmiOptions.threads, &wordExtractionOptions.threads,
+                                   &pipelineOptions.normalize.threads, &pipelineOptions.pmi.threads,
+                                   &pipelineOptions.wordExtraction.threads}) {
+        if (*stageThreads == 0) {
+            *stageThreads = threads;
+        }
+    }
+}
+
+bool OptionsParser::isQuiet() const {
+    return quiet;
+}
+
 bool OptionsParser::isStatsJsonEnabled() const {
     return statsJson;
 }
 
+const std::string& OptionsParser::getTracePath() const {
+    return tracePath;
+}
+
 const std::string& OptionsParser::getOriginalTextPath() const {
     return originalTextPath;
 }
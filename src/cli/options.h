@@ -6,11 +6,15 @@
 #pragma once
 
 #include <string>
+#include <vector>
 #include <functional>
 #include <CLI/CLI.hpp>
 #include "core/normalize.h"
+#include "core/pipeline.h"
 #include "core/pmi.h"
 #include "core/word_extraction.h"
+#include "batch.h"
+#include "serve.h"
 
 namespace suzume {
 namespace cli {
@@ -43,6 +47,20 @@ public:
      */
     int parse(int argc, char* argv[]);
 
+    /**
+     * @brief Parse the arguments of a job sent to the serve daemon
+     *
+     * Takes the arguments of one command without the program name. Options
+     * that act on the whole process (--io-uring, --memory-limit,
+     * --perf-counters, --trace), help, version and stdin ("-") are refused;
+     * the daemon takes the process-wide ones itself. Jobs never report
+     * progress, so no progress callback is set.
+     *
+     * @param args Arguments, e.g. {"pmi", "in.txt", "out.tsv", "--n", "2"}
+     * @throws std::invalid_argument If the arguments are invalid or not allowed in a job
+     */
+    void parseJob(const std::vector<std::string>& args);
+
     /**
      * @brief Get the input file path
      *
@@ -64,6 +82,20 @@ public:
      */
     const std::string& getOriginalTextPath() const;
 
+    /**
+     * @brief Get the partition snapshot paths (for merge)
+     *
+     * @return const std::vector<std::string>& Partition snapshot paths
+     */
+    const std::vector<std::string>& getMergeInputPaths() const;
+
+    /**
+     * @brief Get the marginal snapshot paths (for merge)
+     *
+     * @return const std::vector<std::string>& Marginal snapshot paths
+     */
+    const std::vector<std::string>& getMarginalPaths() const;
+
     /**
      * @brief Get the normalize options
      *
@@ -92,6 +124,13 @@ public:
      */
     const suzume::WordExtractionOptions& getWordExtractionOptions() const;
 
+    /**
+     * @brief Get the pipeline options
+     *
+     * @return const suzume::PipelineOptions& Pipeline options
+     */
+    const suzume::PipelineOptions& getPipelineOptions() const;
+
     /**
      * @brief Check if normalize command was selected
      *
@@ -108,6 +147,14 @@ public:
      */
     bool isPmiCommand() const;
 
+    /**
+     * @brief Check if merge command was selected
+     *
+     * @return true If merge command was selected
+     * @return false Otherwise
+     */
+    bool isMergeCommand() const;
+
     /**
      * @brief Check if word-extract command was selected
      *
@@ -116,6 +163,70 @@ public:
      */
     bool isWordExtractCommand() const;
 
+    /**
+     * @brief Check if pipeline command was selected
+     *
+     * @return true If pipeline command was selected
+     * @return false Otherwise
+     */
+    bool isPipelineCommand() const;
+
+    /**
+     * @brief Check if dict-build command was selected
+     *
+     * @return true If dict-build command was selected
+     * @return false Otherwise
+     */
+    bool isDictBuildCommand() const;
+
+    /**
+     * @brief Check if serve command was selected
+     *
+     * @return true If serve command was selected
+     * @return false Otherwise
+     */
+    bool isServeCommand() const;
+
+    /**
+     * @brief Get the serve options
+     *
+     * @return const ServeOptions& Serve daemon settings
+     */
+    const ServeOptions& getServeOptions() const;
+
+    /**
+     * @brief Check if batch command was selected
+     *
+     * @return true If batch command was selected
+     * @return false Otherwise
+     */
+    bool isBatchCommand() const;
+
+    /**
+     * @brief Get the batch options
+     *
+     * @return const BatchOptions& Batch run settings
+     */
+    const BatchOptions& getBatchOptions() const;
+
+    /**
+     * @brief Give a thread count to every stage left on auto (--threads 0)
+     *
+     * Lets a process that runs several jobs at once split the CPUs among
+     * them; thread counts the job set itself are kept.
+     *
+     * @param threads Threads per stage
+     */
+    void setDefaultThreads(uint32_t threads);
+
+    /**
+     * @brief Check if the quiet flag was given
+     *
+     * @return true If all output is suppressed
+     * @return false Otherwise
+     */
+    bool isQuiet() const;
+
     /**
      * @brief Check if stats-json option was enabled
      *
@@ -124,6 +235,13 @@ public:
      */
     bool isStatsJsonEnabled() const;
 
+    /**
+     * @brief Get the trace output path
+     *
+     * @return const std::string& Chrome trace file path (empty if not tracing)
+     */
+    const std::string& getTracePath() const;
+
     /**
      * @brief Get the version string
      *
@@ -138,33 +256,53 @@ private:
     // Subcommands
     CLI::App* normalizeCommand{nullptr};
     CLI::App* pmiCommand{nullptr};
+    CLI::App* mergeCommand{nullptr};
     CLI::App* wordExtractCommand{nullptr};
+    CLI::App* pipelineCommand{nullptr};
+    CLI::App* dictBuildCommand{nullptr};
+    CLI::App* serveCommand{nullptr};
+    CLI::App* batchCommand{nullptr};
 
     // Input/output paths
     std::string inputPath;
     std::string outputPath;
     std::string originalTextPath;
+    std::vector<std::string> mergeInputPaths;
+    std::vector<std::string> marginalPaths;
 
     // Options
     suzume::NormalizeOptions normalizeOptions;
     suzume::PmiOptions pmiOptions;
     suzume::WordExtractionOptions wordExtractionOptions;
+    suzume::PipelineOptions pipelineOptions;
+    ServeOptions serveOptions;
+    BatchOptions batchOptions;
 
     // Progress format
     ProgressFormat normalizeProgressFormat{ProgressFormat::TTY};
     ProgressFormat pmiProgressFormat{ProgressFormat::TTY};
+    ProgressFormat mergeProgressFormat{ProgressFormat::TTY};
     ProgressFormat wordExtractProgressFormat{ProgressFormat::TTY};
+    ProgressFormat pipelineProgressFormat{ProgressFormat::TTY};
 
     // Stats JSON output
     bool statsJson{false};
 
-    // Sample size for normalize command
-    size_t sampleSize{0};
+    // Chrome trace output
+    std::string tracePath;
+
+    // Quiet flag
+    bool quiet{false};
 
     // Setup methods
     void setupNormalizeCommand();
     void setupPmiCommand();
+    void setupMergeCommand();
     void setupWordExtractCommand();
+    void setupPipelineCommand();
+    void setupDictBuildCommand();
+    void setupServeCommand();
+    void setupBatchCommand();
     void setupGlobalOptions();
 
     // Progress callback functions
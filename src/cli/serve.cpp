@@ -0,0 +1,365 @@
+/**
+ * @file serve.cpp
+ * @brief Implementation of the serve daemon
+ */
+
+#include "serve.h"
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <nlohmann/json.hpp>
+#include "commands.h"
+#include "options.h"
+#include "core/warm_cache.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#define SUZUME_HAVE_UNIX_SOCKETS 1
+#endif
+
+// For convenience
+using json = nlohmann::json;
+
+namespace suzume {
+namespace cli {
+
+#ifdef SUZUME_HAVE_UNIX_SOCKETS
+
+namespace {
+
+// Longest request line accepted; anything longer is not a job description
+constexpr size_t kMaxRequestBytes = 1024 * 1024;
+
+// Time between checks for shutdown while waiting on a socket
+constexpr int kPollIntervalMs = 200;
+
+std::atomic<bool> stopRequested{false};
+
+extern "C" void requestStop(int) {
+    stopRequested.store(true);
+}
+
+std::string systemError(const std::string& what) {
+    return what + ": " + std::strerror(errno);
+}
+
+/**
+ * @brief Limits the jobs that run at once and those that wait for a slot
+ */
+class AdmissionControl {
+public:
+    AdmissionControl(size_t maxJobs, size_t queueLimit)
+        : maxJobs_(std::max<size_t>(maxJobs, 1))
+        , queueLimit_(queueLimit)
+    {
+    }
+
+    // Wait for a slot; false if the queue is full and the job is turned away
+    bool enter() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (running_ >= maxJobs_) {
+            if (waiting_ >= queueLimit_) {
+                return false;
+            }
+            waiting_++;
+            slotFree_.wait(lock, [this]() { return running_ < maxJobs_; });
+            waiting_--;
+        }
+        running_++;
+        return true;
+    }
+
+    void leave() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            running_--;
+        }
+        slotFree_.notify_one();
+    }
+
+    json status() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return {{"running", running_}, {"waiting", waiting_}, {"max_jobs", maxJobs_}, {"queue_limit", queueLimit_}};
+    }
+
+private:
+    size_t maxJobs_;
+    size_t queueLimit_;
+    std::mutex mutex_;
+    std::condition_variable slotFree_;
+    size_t running_ = 0;
+    size_t waiting_ = 0;
+};
+
+// Connection threads still alive; the daemon waits for them before it returns
+class ConnectionCount {
+public:
+    void add() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count_++;
+    }
+
+    void remove() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        count_--;
+        // Notify under the lock: the waiter may destroy this object right after
+        idle_.notify_all();
+    }
+
+    void waitIdle() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        idle_.wait(lock, [this]() { return count_ == 0; });
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable idle_;
+    size_t count_ = 0;
+};
+
+// Answer one request line
+json handleRequest(const std::string& line, AdmissionControl& admission, bool quiet) {
+    json request;
+    try {
+        request = json::parse(line);
+    } catch (const json::parse_error& e) {
+        return {{"ok", false}, {"error", std::string("Invalid request: ") + e.what()}};
+    }
+    if (!request.is_object()) {
+        return {{"ok", false}, {"error", "Invalid request: expected a JSON object"}};
+    }
+
+    json response = json::object();
+    if (request.contains("id")) {
+        response["id"] = request["id"];
+    }
+
+    if (request.value("status", false)) {
+        core::WarmCacheStats cache = core::warmCacheStats();
+        response["ok"] = true;
+        response.update(admission.status());
+        response["cache"] = {{"entries", cache.entries}, {"hits", cache.hits}, {"misses", cache.misses}};
+        return response;
+    }
+
+    std::vector<std::string> args;
+    try {
+        args = request.at("args").get<std::vector<std::string>>();
+    } catch (const json::exception&) {
+        response["ok"] = false;
+        response["error"] = "Invalid request: \"args\" must be an array of strings";
+        return response;
+    }
+
+    // Parse before taking a slot, so malformed jobs are answered at once
+    OptionsParser options;
+    try {
+        options.parseJob(args);
+    } catch (const std::invalid_argument& e) {
+        response["ok"] = false;
+        response["error"] = e.what();
+        return response;
+    }
+
+    if (!admission.enter()) {
+        response["ok"] = false;
+        response["busy"] = true;
+        response["error"] = "Server busy: job queue is full";
+        return response;
+    }
+    try {
+        response["stats"] = runCommand(options);
+        response["ok"] = true;
+    } catch (const std::exception& e) {
+        response["ok"] = false;
+        response["error"] = e.what();
+        if (!quiet) {
+            std::cerr << "Job failed: " << e.what() << std::endl;
+        }
+    }
+    admission.leave();
+    return response;
+}
+
+bool sendAll(int fd, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t written = ::send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        sent += static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Answer the requests of one client until it disconnects or the daemon stops
+void serveConnection(int fd, AdmissionControl& admission, bool quiet) {
+    std::string buffer;
+    char chunk[64 * 1024];
+    bool open = true;
+    while (open && !stopRequested.load()) {
+        pollfd pending{fd, POLLIN, 0};
+        int ready = ::poll(&pending, 1, kPollIntervalMs);
+        if (ready < 0 && errno != EINTR) {
+            break;
+        }
+        if (ready <= 0) {
+            continue;
+        }
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            break;
+        }
+        buffer.append(chunk, static_cast<size_t>(received));
+
+        size_t newline;
+        while (open && (newline = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, newline);
+            buffer.erase(0, newline + 1);
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            open = sendAll(fd, handleRequest(line, admission, quiet).dump() + "\n");
+        }
+        if (open && buffer.size() > kMaxRequestBytes) {
+            json response = {{"ok", false}, {"error", "Request line too long"}};
+            sendAll(fd, response.dump() + "\n");
+            open = false;
+        }
+    }
+    ::close(fd);
+}
+
+// Replace a socket file no daemon listens on; refuse one a live daemon does
+void removeStaleSocket(const std::string& path) {
+    struct stat info;
+    if (::lstat(path.c_str(), &info) != 0) {
+        return;
+    }
+    if (!S_ISSOCK(info.st_mode)) {
+        throw std::runtime_error("Socket path exists and is not a socket: " + path);
+    }
+
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (probe < 0) {
+        throw std::runtime_error(systemError("Failed to create socket"));
+    }
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    bool live = ::connect(probe, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == 0;
+    ::close(probe);
+    if (live) {
+        throw std::runtime_error("Another server is listening on " + path);
+    }
+    ::unlink(path.c_str());
+}
+
+int listenOn(const std::string& path) {
+    sockaddr_un address{};
+    if (path.empty() || path.size() >= sizeof(address.sun_path)) {
+        throw std::invalid_argument("Socket path must be 1 to " + std::to_string(sizeof(address.sun_path) - 1)
+                                    + " bytes long: " + path);
+    }
+    removeStaleSocket(path);
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        throw std::runtime_error(systemError("Failed to create socket"));
+    }
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || ::listen(fd, SOMAXCONN) != 0) {
+        std::string error = systemError("Failed to listen on " + path);
+        ::close(fd);
+        throw std::runtime_error(error);
+    }
+    return fd;
+}
+
+} // namespace
+
+int serve(const ServeOptions& options) {
+    warmUpProcess();
+    core::setWarmCacheLimit(options.cacheEntries);
+
+    int listener = listenOn(options.socketPath);
+    stopRequested.store(false);
+    struct sigaction action{};
+    action.sa_handler = requestStop;
+    sigemptyset(&action.sa_mask);
+    struct sigaction previousInt{};
+    struct sigaction previousTerm{};
+    ::sigaction(SIGINT, &action, &previousInt);
+    ::sigaction(SIGTERM, &action, &previousTerm);
+
+    if (!options.quiet) {
+        std::cerr << "Serving on " << options.socketPath << " (" << options.maxJobs << " jobs at once, "
+                  << options.queueLimit << " queued)" << std::endl;
+    }
+
+    AdmissionControl admission(options.maxJobs, options.queueLimit);
+    ConnectionCount connections;
+    while (!stopRequested.load()) {
+        pollfd pending{listener, POLLIN, 0};
+        int ready = ::poll(&pending, 1, kPollIntervalMs);
+        if (ready <= 0) {
+            continue;
+        }
+        int client = ::accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            continue;
+        }
+        connections.add();
+        try {
+            std::thread([client, &admission, &connections, &options]() {
+                serveConnection(client, admission, options.quiet);
+                connections.remove();
+            }).detach();
+        } catch (const std::system_error&) {
+            ::close(client);
+            connections.remove();
+        }
+    }
+
+    // Stop accepting, let accepted jobs finish, then clean up
+    ::close(listener);
+    ::unlink(options.socketPath.c_str());
+    connections.waitIdle();
+    ::sigaction(SIGINT, &previousInt, nullptr);
+    ::sigaction(SIGTERM, &previousTerm, nullptr);
+    core::setWarmCacheLimit(0);
+    if (!options.quiet) {
+        std::cerr << "Server stopped" << std::endl;
+    }
+    return 0;
+}
+
+#else
+
+int serve(const ServeOptions&) {
+    throw std::runtime_error("serve needs Unix domain sockets, which this platform does not provide");
+}
+
+#endif
+
+} // namespace cli
+} // namespace suzume
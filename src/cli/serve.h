@@ -0,0 +1,53 @@
+/**
+ * @file serve.h
+ * @brief Long-running daemon that runs jobs sent over a Unix domain socket
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace suzume {
+namespace cli {
+
+/**
+ * @brief Settings of the serve daemon
+ */
+struct ServeOptions {
+    std::string socketPath;   ///< Unix domain socket to listen on
+    size_t maxJobs = 2;       ///< Jobs run at the same time
+    size_t queueLimit = 16;   ///< Jobs waiting for a slot before new ones are turned away
+    size_t cacheEntries = 4;  ///< Dictionaries and text indexes kept warm per kind (0 = none)
+    bool quiet = false;       ///< Do not log to stderr
+};
+
+/**
+ * @brief Serve jobs until SIGINT or SIGTERM
+ *
+ * Listens on a Unix domain socket for newline-delimited JSON requests,
+ * one per line, each answered with one line:
+ *
+ *   {"id": any, "args": ["pmi", "in.txt", "out.tsv", "--n", "2"]}
+ *   -> {"id": any, "ok": true, "stats": {... as --stats-json prints ...}}
+ *   -> {"id": any, "ok": false, "error": "..."}         (the job failed)
+ *   -> {"id": any, "ok": false, "busy": true, ...}      (queue full, retry later)
+ *   {"status": true} -> {"ok": true, "running": n, "waiting": n, "cache": {...}}
+ *
+ * The args are those of the normalize, pmi, merge, word-extract, pipeline
+ * and dict-build commands, without the program name. Paths resolve against
+ * the daemon's working directory. The thread pool and the ICU normalizers
+ * are set up once at start, and dictionaries and verifier text indexes
+ * stay loaded between jobs (see core::setWarmCacheLimit()), so repeated
+ * small jobs skip the setup a fresh process pays. A socket file left by
+ * a daemon that died is replaced; one a live daemon listens on is not.
+ * On shutdown, running jobs finish and the socket file is removed.
+ *
+ * @param options Daemon settings
+ * @return int Exit code
+ * @throws std::runtime_error If the socket cannot be set up, or on platforms without Unix domain sockets
+ */
+int serve(const ServeOptions& options);
+
+} // namespace cli
+} // namespace suzume
@@ -0,0 +1,63 @@
+/**
+ * @file aho_corasick.cpp
+ * @brief Implementation of the Aho-Corasick automaton
+ */
+
+#include "core/aho_corasick.h"
+#include <utility>
+
+namespace suzume {
+namespace core {
+
+AhoCorasick::AhoCorasick(const std::vector<std::string>& patterns)
+    : AhoCorasick(std::vector<std::string_view>(patterns.begin(), patterns.end()))
+{
+}
+
+AhoCorasick::AhoCorasick(const std::vector<std::string_view>& patterns) {
+    // Children of each state, kept only while the links are computed
+    std::vector<std::vector<std::pair<unsigned char, uint32_t>>> children(1);
+    terminal_.push_back(kNone);
+    depth_.push_back(0);
+    canonical_.reserve(patterns.size());
+
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        uint32_t state = 0;
+        for (char ch : patterns[p]) {
+            unsigned char byte = static_cast<unsigned char>(ch);
+            auto [it, inserted] = edges_.try_emplace(edgeKey(state, byte), static_cast<uint32_t>(depth_.size()));
+            if (inserted) {
+                children[state].emplace_back(byte, it->second);
+                children.emplace_back();
+                terminal_.push_back(kNone);
+                depth_.push_back(depth_[state] + 1);
+            }
+            state = it->second;
+        }
+        if (state != 0 && terminal_[state] == kNone) {
+            terminal_[state] = static_cast<uint32_t>(p);
+        }
+        canonical_.push_back(state != 0 ? terminal_[state] : p);
+    }
+
+    // Breadth-first, so every failure target is finished before it is used
+    fail_.assign(depth_.size(), 0);
+    outLink_.assign(depth_.size(), kNone);
+    std::vector<uint32_t> queue;
+    queue.reserve(depth_.size());
+    for (const auto& [byte, child] : children[0]) {
+        queue.push_back(child);
+    }
+    for (size_t head = 0; head < queue.size(); ++head) {
+        uint32_t state = queue[head];
+        for (const auto& [byte, child] : children[state]) {
+            uint32_t target = next(fail_[state], byte);
+            fail_[child] = target;
+            outLink_[child] = terminal_[target] != kNone ? target : outLink_[target];
+            queue.push_back(child);
+        }
+    }
+}
+
+} // namespace core
+} // namespace suzume
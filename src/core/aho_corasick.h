@@ -0,0 +1,110 @@
+/**
+ * @file aho_corasick.h
+ * @brief Aho-Corasick automaton for matching many patterns in one pass
+ */
+
+#ifndef SUZUME_CORE_AHO_CORASICK_H_
+#define SUZUME_CORE_AHO_CORASICK_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Byte-level Aho-Corasick automaton
+ *
+ * The trie edges live in one flat hash map keyed by (state, byte), which
+ * keeps the automaton compact for large sparse pattern sets. Each state
+ * has a failure link (longest proper suffix that is also a trie prefix)
+ * and an output link (nearest state on the failure chain that ends a
+ * pattern), so a scan costs O(text length + matches).
+ *
+ * Duplicate patterns share a state and are reported under the index of
+ * the first one; empty patterns are never reported.
+ */
+class AhoCorasick {
+public:
+    /**
+     * @brief Build the automaton
+     * @param patterns Patterns to match
+     */
+    explicit AhoCorasick(const std::vector<std::string>& patterns);
+
+    /**
+     * @brief Build the automaton from views, without copying the patterns
+     * @param patterns Patterns to match
+     */
+    explicit AhoCorasick(const std::vector<std::string_view>& patterns);
+
+    /**
+     * @brief Report every (possibly overlapping) match in a text
+     *
+     * Matches are reported in order of their end position; matches that
+     * end at the same byte are reported longest first.
+     *
+     * @tparam Callback Called as onMatch(patternIndex, startPosition)
+     * @param text Text to scan
+     * @param onMatch Match callback
+     */
+    template <typename Callback>
+    void scan(std::string_view text, Callback&& onMatch) const {
+        uint32_t state = 0;
+        for (size_t i = 0; i < text.size(); ++i) {
+            state = next(state, static_cast<unsigned char>(text[i]));
+            for (uint32_t s = terminal_[state] != kNone ? state : outLink_[state]; s != kNone; s = outLink_[s]) {
+                onMatch(static_cast<size_t>(terminal_[s]), i + 1 - depth_[s]);
+            }
+        }
+    }
+
+    /**
+     * @brief Get the index a pattern is reported under
+     * @param pattern Pattern index
+     * @return size_t Index of the first pattern with the same text
+     */
+    size_t canonical(size_t pattern) const { return canonical_[pattern]; }
+
+    /**
+     * @brief Get the number of states
+     * @return size_t State count, including the root
+     */
+    size_t stateCount() const { return depth_.size(); }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    static uint64_t edgeKey(uint32_t state, unsigned char byte) {
+        return (static_cast<uint64_t>(state) << 8) | byte;
+    }
+
+    uint32_t next(uint32_t state, unsigned char byte) const {
+        while (true) {
+            auto it = edges_.find(edgeKey(state, byte));
+            if (it != edges_.end()) {
+                return it->second;
+            }
+            if (state == 0) {
+                return 0;
+            }
+            state = fail_[state];
+        }
+    }
+
+    robin_hood::unordered_flat_map<uint64_t, uint32_t> edges_;
+    std::vector<uint32_t> fail_;
+    std::vector<uint32_t> outLink_;
+    std::vector<uint32_t> terminal_;    // Pattern ending at the state, or kNone
+    std::vector<uint32_t> depth_;
+    std::vector<size_t> canonical_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_AHO_CORASICK_H_
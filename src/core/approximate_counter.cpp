@@ -0,0 +1,281 @@
+/**
+ * @file approximate_counter.cpp
+ * @brief Implementation of fixed-memory approximate n-gram counting
+ */
+
+#include "core/approximate_counter.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Largest sketch depth accepted
+constexpr uint32_t kMaxSketchDepth = 16;
+
+// Finalizer from SplitMix64
+inline uint64_t mixKey(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline size_t roundUpToPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+CountMinSketch::CountMinSketch(size_t width, uint32_t depth)
+    : width_(roundUpToPowerOfTwo(width))
+    , depth_(depth)
+    , total_(0)
+{
+    if (width == 0) {
+        throw std::invalid_argument("Sketch width must be at least 1");
+    }
+    if (depth < 1 || depth > kMaxSketchDepth) {
+        throw std::invalid_argument("Invalid sketch depth: " + std::to_string(depth) +
+                                    " (must be 1-" + std::to_string(kMaxSketchDepth) + ")");
+    }
+    cells_.assign(width_ * depth_, 0);
+}
+
+size_t CountMinSketch::cellIndex(uint64_t hash, uint32_t row) const {
+    // Row hashes h1 + row * h2 from the two halves of one mixed key
+    uint64_t h1 = hash & 0xFFFFFFFFULL;
+    uint64_t h2 = (hash >> 32) | 1;
+    return row * width_ + static_cast<size_t>((h1 + row * h2) & (width_ - 1));
+}
+
+uint32_t CountMinSketch::add(uint64_t key, uint32_t count) {
+    const uint64_t hash = mixKey(key);
+    uint32_t current = std::numeric_limits<uint32_t>::max();
+    for (uint32_t row = 0; row < depth_; ++row) {
+        current = std::min(current, cells_[cellIndex(hash, row)]);
+    }
+
+    // Conservative update: raise each counter only as far as the new estimate
+    uint32_t updated = current > std::numeric_limits<uint32_t>::max() - count
+        ? std::numeric_limits<uint32_t>::max()
+        : current + count;
+    for (uint32_t row = 0; row < depth_; ++row) {
+        uint32_t& cell = cells_[cellIndex(hash, row)];
+        cell = std::max(cell, updated);
+    }
+    total_ += count;
+    return updated;
+}
+
+uint32_t CountMinSketch::estimate(uint64_t key) const {
+    const uint64_t hash = mixKey(key);
+    uint32_t result = std::numeric_limits<uint32_t>::max();
+    for (uint32_t row = 0; row < depth_; ++row) {
+        result = std::min(result, cells_[cellIndex(hash, row)]);
+    }
+    return result;
+}
+
+void CountMinSketch::merge(const CountMinSketch& other) {
+    if (other.width_ != width_ || other.depth_ != depth_) {
+        throw std::invalid_argument("Cannot merge sketches of different shapes");
+    }
+    for (size_t i = 0; i < cells_.size(); ++i) {
+        uint64_t sum = static_cast<uint64_t>(cells_[i]) + other.cells_[i];
+        cells_[i] = static_cast<uint32_t>(std::min<uint64_t>(sum, std::numeric_limits<uint32_t>::max()));
+    }
+    total_ += other.total_;
+}
+
+double CountMinSketch::epsilon() const {
+    return std::exp(1.0) / static_cast<double>(width_);
+}
+
+double CountMinSketch::delta() const {
+    return std::exp(-static_cast<double>(depth_));
+}
+
+uint64_t CountMinSketch::errorBound() const {
+    return static_cast<uint64_t>(std::ceil(epsilon() * static_cast<double>(total_)));
+}
+
+HeavyHitterTable::HeavyHitterTable(size_t capacity)
+    : capacity_(capacity)
+{
+    heap_.reserve(capacity);
+    positions_.reserve(capacity);
+}
+
+void HeavyHitterTable::place(size_t index, const Entry& entry) {
+    heap_[index] = entry;
+    positions_[entry.key] = index;
+}
+
+void HeavyHitterTable::siftUp(size_t index) {
+    Entry entry = heap_[index];
+    while (index > 0) {
+        size_t parent = (index - 1) / 2;
+        if (heap_[parent].count <= entry.count) {
+            break;
+        }
+        place(index, heap_[parent]);
+        index = parent;
+    }
+    place(index, entry);
+}
+
+void HeavyHitterTable::siftDown(size_t index) {
+    Entry entry = heap_[index];
+    const size_t size = heap_.size();
+    while (true) {
+        size_t child = 2 * index + 1;
+        if (child >= size) {
+            break;
+        }
+        if (child + 1 < size && heap_[child + 1].count < heap_[child].count) {
+            child++;
+        }
+        if (entry.count <= heap_[child].count) {
+            break;
+        }
+        place(index, heap_[child]);
+        index = child;
+    }
+    place(index, entry);
+}
+
+void HeavyHitterTable::offer(uint64_t key, uint32_t count) {
+    if (capacity_ == 0) {
+        return;
+    }
+
+    auto it = positions_.find(key);
+    if (it != positions_.end()) {
+        // Counts only grow, so a held key can only move away from the root
+        size_t index = it->second;
+        if (count > heap_[index].count) {
+            heap_[index].count = count;
+            siftDown(index);
+        }
+        return;
+    }
+
+    if (heap_.size() < capacity_) {
+        heap_.push_back({key, count});
+        siftUp(heap_.size() - 1);
+    } else if (count > heap_.front().count) {
+        // Evict the least frequent key
+        positions_.erase(heap_.front().key);
+        heap_.front() = {key, count};
+        siftDown(0);
+    }
+}
+
+uint32_t HeavyHitterTable::minCount() const {
+    return heap_.size() < capacity_ || heap_.empty() ? 0 : heap_.front().count;
+}
+
+size_t HeavyHitterTable::memoryUsage() const {
+    return heap_.capacity() * sizeof(Entry) +
+           positions_.size() * (sizeof(uint64_t) + sizeof(size_t) + 1);
+}
+
+ApproximateNgramCounter::ApproximateNgramCounter(
+    uint32_t n,
+    size_t sketchWidth,
+    uint32_t sketchDepth,
+    size_t heavyHitters
+)
+    : n_(n)
+    // Unigrams are counted exactly, so a unigram run needs no sketch
+    , sketch_(n == 1 ? 1 : sketchWidth, n == 1 ? 1 : sketchDepth)
+    , heavyHitters_(n == 1 ? 0 : heavyHitters)
+    , unigrams_(1)
+{
+    if (n < 1 || n > PackedNgramCounter::kMaxN) {
+        throw std::invalid_argument("Invalid n-gram size: " + std::to_string(n) + " (must be 1, 2, or 3)");
+    }
+}
+
+void ApproximateNgramCounter::addText(std::string_view text) {
+    forEachLine(text, [this](std::string_view line) {
+        PackedNgramCounter::forEachKey(line, 1, n_, [this](uint32_t order, uint64_t key) {
+            if (order == 1) {
+                unigrams_.add(key);
+            }
+            if (order == n_ && n_ > 1) {
+                heavyHitters_.offer(key, sketch_.add(key));
+            }
+        });
+    });
+}
+
+ApproximateNgramCounter ApproximateNgramCounter::mergeAll(
+    std::vector<ApproximateNgramCounter>&& counters,
+    unsigned int /*threads*/
+) {
+    if (counters.empty()) {
+        throw std::invalid_argument("No n-gram counters to merge");
+    }
+
+    ApproximateNgramCounter result = std::move(counters.front());
+    for (size_t i = 1; i < counters.size(); ++i) {
+        if (counters[i].n_ != result.n_ || counters[i].heavyHitters_.capacity() != result.heavyHitters_.capacity()) {
+            throw std::invalid_argument("Cannot merge n-gram counters with different configurations");
+        }
+        result.sketch_.merge(counters[i].sketch_);
+        result.unigrams_.merge(counters[i].unigrams_);
+    }
+
+    // Re-rank every worker's candidates by their merged estimates
+    HeavyHitterTable merged(result.heavyHitters_.capacity());
+    auto offerMerged = [&](uint64_t key, uint32_t) { merged.offer(key, result.sketch_.estimate(key)); };
+    result.heavyHitters_.forEach(offerMerged);
+    for (size_t i = 1; i < counters.size(); ++i) {
+        counters[i].heavyHitters_.forEach(offerMerged);
+    }
+    result.heavyHitters_ = std::move(merged);
+
+    counters.clear();
+    return result;
+}
+
+uint32_t ApproximateNgramCounter::estimate(uint64_t key) const {
+    return n_ == 1 ? unigrams_.count(key) : sketch_.estimate(key);
+}
+
+uint64_t ApproximateNgramCounter::total() const {
+    if (n_ == 1) {
+        uint64_t total = 0;
+        unigrams_.forEach([&](uint64_t, uint32_t count) { total += count; });
+        return total;
+    }
+    return sketch_.total();
+}
+
+uint64_t ApproximateNgramCounter::errorBound() const {
+    return n_ == 1 ? 0 : sketch_.errorBound();
+}
+
+double ApproximateNgramCounter::errorProbability() const {
+    return n_ == 1 ? 0.0 : sketch_.delta();
+}
+
+size_t ApproximateNgramCounter::memoryUsage() const {
+    return sketch_.memoryUsage() + heavyHitters_.memoryUsage() + unigrams_.memoryUsage();
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,264 @@
+/**
+ * @file approximate_counter.h
+ * @brief Fixed-memory approximate n-gram counting
+ */
+
+#ifndef SUZUME_CORE_APPROXIMATE_COUNTER_H_
+#define SUZUME_CORE_APPROXIMATE_COUNTER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Count-Min sketch of packed n-gram counts with conservative update
+ *
+ * depth rows of width counters; a key is counted in one counter per row and
+ * its estimate is the smallest of them. Estimates never undercount, and
+ * overcount by more than epsilon() * total() only with probability delta().
+ * Conservative update raises only the counters that hold the minimum, which
+ * keeps the overestimate well below the bound on skewed text.
+ */
+class CountMinSketch {
+public:
+    /**
+     * @brief Constructor
+     * @param width Counters per row (rounded up to a power of two)
+     * @param depth Number of rows (1-16)
+     * @throws std::invalid_argument If width or depth is out of range
+     */
+    CountMinSketch(size_t width, uint32_t depth);
+
+    /**
+     * @brief Count a key
+     * @param key Packed n-gram
+     * @param count Occurrences to add
+     * @return uint32_t Estimated count of the key after adding
+     */
+    uint32_t add(uint64_t key, uint32_t count = 1);
+
+    /**
+     * @brief Estimate the count of a key
+     * @param key Packed n-gram
+     * @return uint32_t Estimated count (never below the true count)
+     */
+    uint32_t estimate(uint64_t key) const;
+
+    /**
+     * @brief Add every counter of a sketch with the same shape
+     * @param other Sketch to merge
+     * @throws std::invalid_argument If the shapes differ
+     */
+    void merge(const CountMinSketch& other);
+
+    /**
+     * @brief Get the number of occurrences counted
+     * @return uint64_t Total count
+     */
+    uint64_t total() const { return total_; }
+
+    /**
+     * @brief Get the relative error bound
+     * @return double e / width
+     */
+    double epsilon() const;
+
+    /**
+     * @brief Get the probability of exceeding the error bound for one key
+     * @return double e^-depth
+     */
+    double delta() const;
+
+    /**
+     * @brief Get the largest overestimate expected for any key
+     * @return uint64_t ceil(epsilon() * total())
+     */
+    uint64_t errorBound() const;
+
+    size_t width() const { return width_; }
+    uint32_t depth() const { return depth_; }
+
+    /**
+     * @brief Get memory usage of the counters
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const { return cells_.size() * sizeof(uint32_t); }
+
+private:
+    size_t cellIndex(uint64_t hash, uint32_t row) const;
+
+    size_t width_;
+    uint32_t depth_;
+    std::vector<uint32_t> cells_;
+    uint64_t total_;
+};
+
+/**
+ * @brief Fixed-size table of the most frequent keys (Space-Saving)
+ *
+ * Holds up to capacity keys in an indexed min-heap ordered by count. A key
+ * that is not held replaces the least frequent one when its count is larger,
+ * so the table converges on the heavy hitters of the stream whatever its
+ * length.
+ */
+class HeavyHitterTable {
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Maximum number of keys held
+     */
+    explicit HeavyHitterTable(size_t capacity);
+
+    /**
+     * @brief Offer a key with its current count
+     * @param key Packed n-gram
+     * @param count Count of the key so far
+     */
+    void offer(uint64_t key, uint32_t count);
+
+    /**
+     * @brief Call fn(key, count) for every key held
+     * @param fn Visitor
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& entry : heap_) {
+            fn(entry.key, entry.count);
+        }
+    }
+
+    /**
+     * @brief Get the smallest count held
+     * @return uint32_t Count of the least frequent key (0 if not full)
+     */
+    uint32_t minCount() const;
+
+    size_t size() const { return heap_.size(); }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Get memory usage of the table
+     * @return size_t Bytes used (approximate)
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Entry {
+        uint64_t key;
+        uint32_t count;
+    };
+
+    void siftUp(size_t index);
+    void siftDown(size_t index);
+    void place(size_t index, const Entry& entry);
+
+    size_t capacity_;
+    std::vector<Entry> heap_;
+    robin_hood::unordered_flat_map<uint64_t, size_t> positions_;
+};
+
+/**
+ * @brief Approximate n-gram counts in memory fixed up front
+ *
+ * N-grams are counted in a CountMinSketch and the most frequent ones are
+ * tracked in a HeavyHitterTable, so memory does not grow with the corpus.
+ * Unigrams are counted exactly (they are bounded by the script) and serve
+ * as PMI marginals. With n = 1 the exact unigram counts are all there is.
+ */
+class ApproximateNgramCounter {
+public:
+    /**
+     * @brief Constructor
+     * @param n N-gram size (1-3)
+     * @param sketchWidth Counters per sketch row
+     * @param sketchDepth Sketch rows
+     * @param heavyHitters Number of candidate n-grams tracked
+     * @throws std::invalid_argument If a size is out of range
+     */
+    ApproximateNgramCounter(uint32_t n, size_t sketchWidth, uint32_t sketchDepth, size_t heavyHitters);
+
+    /**
+     * @brief Count the n-grams of every line in a text
+     * @param text UTF-8 text, lines separated by '\n'
+     */
+    void addText(std::string_view text);
+
+    /**
+     * @brief Merge worker counters
+     *
+     * Sketches and unigrams are summed; the candidates of every worker are
+     * re-ranked by their merged estimates.
+     *
+     * @param counters Worker counters with the same configuration (consumed)
+     * @param threads Unused; merging is sequential and bounded by the table sizes
+     * @return ApproximateNgramCounter Merged counter
+     * @throws std::invalid_argument If the counters are empty or do not match
+     */
+    static ApproximateNgramCounter mergeAll(std::vector<ApproximateNgramCounter>&& counters, unsigned int threads);
+
+    /**
+     * @brief Get the estimated count of a packed n-gram
+     * @param key Packed n-gram
+     * @return uint32_t Estimated count (exact for n = 1)
+     */
+    uint32_t estimate(uint64_t key) const;
+
+    /**
+     * @brief Call fn(key, estimatedCount) for every candidate n-gram
+     * @param fn Visitor
+     */
+    template <typename Fn>
+    void forEachCandidate(Fn&& fn) const {
+        if (n_ == 1) {
+            unigrams_.forEach(fn);
+        } else {
+            heavyHitters_.forEach([&](uint64_t key, uint32_t) { fn(key, sketch_.estimate(key)); });
+        }
+    }
+
+    /**
+     * @brief Get the number of n-grams counted
+     * @return uint64_t Total occurrences
+     */
+    uint64_t total() const;
+
+    /**
+     * @brief Get the largest overestimate of any candidate's count
+     * @return uint64_t Error bound (0 for n = 1)
+     */
+    uint64_t errorBound() const;
+
+    /**
+     * @brief Get the probability that a count exceeds the error bound
+     * @return double Failure probability per n-gram (0 for n = 1)
+     */
+    double errorProbability() const;
+
+    const PackedNgramCounter& unigrams() const { return unigrams_; }
+    const CountMinSketch& sketch() const { return sketch_; }
+    const HeavyHitterTable& heavyHitters() const { return heavyHitters_; }
+    uint32_t n() const { return n_; }
+
+    /**
+     * @brief Get memory usage of all tables
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+private:
+    uint32_t n_;
+    CountMinSketch sketch_;
+    HeavyHitterTable heavyHitters_;
+    PackedNgramCounter unigrams_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_APPROXIMATE_COUNTER_H_
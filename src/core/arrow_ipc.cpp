@@ -0,0 +1,441 @@
+/**
+ * @file arrow_ipc.cpp
+ * @brief Implementation of the Arrow IPC file writer
+ */
+
+#include "core/arrow_ipc.h"
+#include "core/output_writer.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+const char kArrowMagic[] = "ARROW1";
+
+// Enumerations of the Arrow schema (Schema.fbs, Message.fbs)
+constexpr int16_t kMetadataVersionV5 = 4;
+constexpr uint8_t kHeaderSchema = 1;
+constexpr uint8_t kHeaderRecordBatch = 3;
+constexpr uint8_t kTypeInt = 2;
+constexpr uint8_t kTypeFloatingPoint = 3;
+constexpr uint8_t kTypeUtf8 = 5;
+constexpr int16_t kPrecisionDouble = 2;
+
+// A batch is cut early before its string data outgrows 32-bit offsets
+constexpr size_t kMaxBatchStringBytes = size_t{1} << 30;
+
+size_t alignUp(size_t size, size_t alignment) {
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+template<typename T>
+void appendScalar(std::string& out, T value) {
+    char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    out.append(bytes, sizeof(T));
+}
+
+/**
+ * @brief One FlatBuffers object: a table, a string or a vector
+ */
+struct FlatNode {
+    enum class Kind { Table, String, TableVector, StructVector };
+
+    /// Table field: an inline scalar, or an offset to a child when child is set
+    struct Field {
+        uint16_t id;
+        size_t size;
+        std::string bytes;
+        std::unique_ptr<FlatNode> child;
+    };
+
+    explicit FlatNode(Kind kind) : kind(kind) {}
+
+    template<typename T>
+    FlatNode& scalar(uint16_t id, T value) {
+        std::string bytes;
+        appendScalar(bytes, value);
+        fields.push_back({id, sizeof(T), std::move(bytes), nullptr});
+        return *this;
+    }
+
+    FlatNode& child(uint16_t id, FlatNode node) {
+        fields.push_back({id, sizeof(uint32_t), std::string(), std::make_unique<FlatNode>(std::move(node))});
+        return *this;
+    }
+
+    static FlatNode string(std::string_view text) {
+        FlatNode node(Kind::String);
+        node.bytes.assign(text);
+        return node;
+    }
+
+    /// Vector of structs whose elements are 8-byte aligned
+    static FlatNode structs(std::string bytes, size_t count) {
+        FlatNode node(Kind::StructVector);
+        node.bytes = std::move(bytes);
+        node.count = count;
+        return node;
+    }
+
+    static FlatNode tables(std::vector<FlatNode> items) {
+        FlatNode node(Kind::TableVector);
+        node.items = std::move(items);
+        return node;
+    }
+
+    Kind kind;
+    std::vector<Field> fields;
+    std::string bytes;
+    size_t count = 0;
+    std::vector<FlatNode> items;
+};
+
+/**
+ * @brief Serializes FlatNodes front to back
+ *
+ * FlatBuffers offsets are unsigned and point forward, so every object is
+ * written before the objects it refers to and the offsets are patched
+ * once those land. A table's vtable is written just before the table.
+ */
+class FlatWriter {
+public:
+    std::string finish(const FlatNode& root) {
+        appendScalar<uint32_t>(out_, 0);
+        patch(0, write(root));
+        pad(8);
+        return std::move(out_);
+    }
+
+private:
+    void pad(size_t alignment) {
+        out_.resize(alignUp(out_.size(), alignment), '\0');
+    }
+
+    void patch(size_t position, size_t target) {
+        uint32_t offset = static_cast<uint32_t>(target - position);
+        std::memcpy(&out_[position], &offset, sizeof(offset));
+    }
+
+    size_t write(const FlatNode& node) {
+        switch (node.kind) {
+            case FlatNode::Kind::Table:
+                return writeTable(node);
+            case FlatNode::Kind::String: {
+                pad(4);
+                size_t position = out_.size();
+                appendScalar(out_, static_cast<uint32_t>(node.bytes.size()));
+                out_ += node.bytes;
+                out_ += '\0';
+                return position;
+            }
+            case FlatNode::Kind::StructVector: {
+                pad(4);
+                if ((out_.size() + sizeof(uint32_t)) % 8 != 0) {
+                    appendScalar<uint32_t>(out_, 0);
+                }
+                size_t position = out_.size();
+                appendScalar(out_, static_cast<uint32_t>(node.count));
+                out_ += node.bytes;
+                return position;
+            }
+            case FlatNode::Kind::TableVector: {
+                pad(4);
+                size_t position = out_.size();
+                appendScalar(out_, static_cast<uint32_t>(node.items.size()));
+                size_t slots = out_.size();
+                out_.resize(slots + node.items.size() * sizeof(uint32_t), '\0');
+                for (size_t i = 0; i < node.items.size(); ++i) {
+                    patch(slots + i * sizeof(uint32_t), write(node.items[i]));
+                }
+                return position;
+            }
+        }
+        return 0;
+    }
+
+    size_t writeTable(const FlatNode& node) {
+        // Lay out the fields largest first after the vtable offset, so each
+        // is aligned to its size in a table that starts 8-byte aligned
+        std::vector<const FlatNode::Field*> order;
+        uint16_t slots = 0;
+        for (const FlatNode::Field& field : node.fields) {
+            order.push_back(&field);
+            slots = std::max<uint16_t>(slots, static_cast<uint16_t>(field.id + 1));
+        }
+        std::stable_sort(order.begin(), order.end(), [](const FlatNode::Field* a, const FlatNode::Field* b) {
+            return a->size > b->size;
+        });
+        std::vector<uint16_t> offsets(slots, 0);
+        std::vector<size_t> placement(order.size());
+        size_t tableSize = sizeof(int32_t);
+        for (size_t i = 0; i < order.size(); ++i) {
+            tableSize = alignUp(tableSize, order[i]->size);
+            placement[i] = tableSize;
+            offsets[order[i]->id] = static_cast<uint16_t>(tableSize);
+            tableSize += order[i]->size;
+        }
+
+        pad(2);
+        size_t vtable = out_.size();
+        appendScalar(out_, static_cast<uint16_t>(sizeof(uint16_t) * (2 + slots)));
+        appendScalar(out_, static_cast<uint16_t>(tableSize));
+        for (uint16_t offset : offsets) {
+            appendScalar(out_, offset);
+        }
+
+        pad(8);
+        size_t table = out_.size();
+        appendScalar(out_, static_cast<int32_t>(table - vtable));
+        out_.resize(table + tableSize, '\0');
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (!order[i]->child) {
+                std::memcpy(&out_[table + placement[i]], order[i]->bytes.data(), order[i]->size);
+            }
+        }
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (order[i]->child) {
+                patch(table + placement[i], write(*order[i]->child));
+            }
+        }
+        return table;
+    }
+
+    std::string out_;
+};
+
+FlatNode fieldNode(const ArrowField& field) {
+    FlatNode type(FlatNode::Kind::Table);
+    uint8_t typeId = kTypeUtf8;
+    switch (field.type) {
+        case ArrowType::Utf8:
+            break;
+        case ArrowType::Float64:
+            typeId = kTypeFloatingPoint;
+            type.scalar<int16_t>(0, kPrecisionDouble);
+            break;
+        case ArrowType::UInt32:
+            typeId = kTypeInt;
+            type.scalar<int32_t>(0, 32).scalar<uint8_t>(1, 0);
+            break;
+    }
+
+    FlatNode node(FlatNode::Kind::Table);
+    node.child(0, FlatNode::string(field.name))
+        .scalar<uint8_t>(1, 0)
+        .scalar<uint8_t>(2, typeId)
+        .child(3, std::move(type))
+        .child(5, FlatNode::tables({}));
+    return node;
+}
+
+FlatNode schemaNode(const std::vector<ArrowField>& fields) {
+    std::vector<FlatNode> items;
+    for (const ArrowField& field : fields) {
+        items.push_back(fieldNode(field));
+    }
+    FlatNode schema(FlatNode::Kind::Table);
+    schema.scalar<int16_t>(0, 0).child(1, FlatNode::tables(std::move(items)));
+    return schema;
+}
+
+std::string messageMetadata(uint8_t headerType, FlatNode header, uint64_t bodyLength) {
+    FlatNode message(FlatNode::Kind::Table);
+    message.scalar<int16_t>(0, kMetadataVersionV5)
+        .scalar<uint8_t>(1, headerType)
+        .child(2, std::move(header))
+        .scalar<int64_t>(3, static_cast<int64_t>(bodyLength));
+    return FlatWriter().finish(message);
+}
+
+} // namespace
+
+/**
+ * @brief Values of one column in the current batch
+ */
+struct ArrowFileWriter::Column {
+    ArrowType type;
+    std::vector<int32_t> offsets;  ///< Utf8 only: start of each value, plus the end
+    std::string data;              ///< Utf8 bytes, or the fixed-width values
+    size_t count = 0;
+};
+
+bool isArrowOutputPath(const std::string& path) {
+    const std::string extension = ".arrow";
+    return path.size() > extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+ArrowFileWriter::ArrowFileWriter(const std::string& path, std::vector<ArrowField> fields, size_t batchRows)
+    : fields_(std::move(fields))
+    , batchRows_(std::max<size_t>(batchRows, 1))
+    , rows_(0)
+    , position_(0)
+{
+    if (fields_.empty()) {
+        throw std::invalid_argument("Arrow output needs at least one column");
+    }
+    for (const ArrowField& field : fields_) {
+        Column column;
+        column.type = field.type;
+        if (field.type == ArrowType::Utf8) {
+            column.offsets.push_back(0);
+        }
+        columns_.push_back(std::move(column));
+    }
+
+    output_ = std::make_unique<OutputWriter>(path);
+    char magic[8] = {};
+    std::memcpy(magic, kArrowMagic, 6);
+    writeBytes(magic, sizeof(magic));
+    writeMessage(messageMetadata(kHeaderSchema, schemaNode(fields_), 0), std::string());
+}
+
+ArrowFileWriter::~ArrowFileWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw
+    }
+}
+
+ArrowFileWriter::Column& ArrowFileWriter::column(size_t index, ArrowType type) {
+    if (index >= columns_.size() || columns_[index].type != type) {
+        throw std::invalid_argument("Arrow column " + std::to_string(index) + " has a different type");
+    }
+    return columns_[index];
+}
+
+void ArrowFileWriter::append(size_t index, std::string_view value) {
+    Column& target = column(index, ArrowType::Utf8);
+    target.data.append(value);
+    target.offsets.push_back(static_cast<int32_t>(target.data.size()));
+    target.count++;
+}
+
+void ArrowFileWriter::append(size_t index, double value) {
+    Column& target = column(index, ArrowType::Float64);
+    appendScalar(target.data, value);
+    target.count++;
+}
+
+void ArrowFileWriter::append(size_t index, uint32_t value) {
+    Column& target = column(index, ArrowType::UInt32);
+    appendScalar(target.data, value);
+    target.count++;
+}
+
+void ArrowFileWriter::endRow() {
+    rows_++;
+    size_t stringBytes = 0;
+    for (const Column& column : columns_) {
+        if (column.count != rows_) {
+            throw std::logic_error("Every Arrow column must be set once per row");
+        }
+        if (column.type == ArrowType::Utf8) {
+            stringBytes = std::max(stringBytes, column.data.size());
+        }
+    }
+    if (rows_ >= batchRows_ || stringBytes >= kMaxBatchStringBytes) {
+        writeBatch();
+    }
+}
+
+void ArrowFileWriter::close() {
+    if (!output_) {
+        return;
+    }
+    if (rows_ > 0) {
+        writeBatch();
+    }
+
+    // End-of-stream marker, then the footer locating the schema and batches
+    std::string tail;
+    appendScalar<uint32_t>(tail, 0xFFFFFFFFu);
+    appendScalar<uint32_t>(tail, 0);
+    writeBytes(tail.data(), tail.size());
+
+    std::string blocks;
+    for (const Block& block : blocks_) {
+        appendScalar(blocks, static_cast<int64_t>(block.offset));
+        appendScalar(blocks, static_cast<int32_t>(block.metadataLength));
+        appendScalar<int32_t>(blocks, 0);
+        appendScalar(blocks, static_cast<int64_t>(block.bodyLength));
+    }
+    FlatNode footer(FlatNode::Kind::Table);
+    footer.scalar<int16_t>(0, kMetadataVersionV5)
+        .child(1, schemaNode(fields_))
+        .child(2, FlatNode::structs(std::string(), 0))
+        .child(3, FlatNode::structs(std::move(blocks), blocks_.size()));
+    std::string encoded = FlatWriter().finish(footer);
+    appendScalar(encoded, static_cast<int32_t>(encoded.size()));
+    encoded.append(kArrowMagic, 6);
+    writeBytes(encoded.data(), encoded.size());
+
+    std::unique_ptr<OutputWriter> output = std::move(output_);
+    output->close();
+}
+
+void ArrowFileWriter::writeBatch() {
+    // Body: per column an empty validity buffer and its value buffers, 8-byte aligned
+    std::string body;
+    std::string nodes;
+    std::string buffers;
+    auto addBuffer = [&](const char* data, size_t size) {
+        appendScalar(buffers, static_cast<int64_t>(body.size()));
+        appendScalar(buffers, static_cast<int64_t>(size));
+        body.append(data, size);
+        body.resize(alignUp(body.size(), 8), '\0');
+    };
+    size_t bufferCount = 0;
+    for (Column& column : columns_) {
+        appendScalar(nodes, static_cast<int64_t>(rows_));
+        appendScalar<int64_t>(nodes, 0);
+        addBuffer(nullptr, 0);
+        if (column.type == ArrowType::Utf8) {
+            addBuffer(reinterpret_cast<const char*>(column.offsets.data()), column.offsets.size() * sizeof(int32_t));
+            bufferCount++;
+        }
+        addBuffer(column.data.data(), column.data.size());
+        bufferCount += 2;
+    }
+
+    FlatNode batch(FlatNode::Kind::Table);
+    batch.scalar<int64_t>(0, static_cast<int64_t>(rows_))
+        .child(1, FlatNode::structs(std::move(nodes), columns_.size()))
+        .child(2, FlatNode::structs(std::move(buffers), bufferCount));
+    blocks_.push_back(writeMessage(messageMetadata(kHeaderRecordBatch, std::move(batch), body.size()), body));
+
+    for (Column& column : columns_) {
+        column.data.clear();
+        column.count = 0;
+        if (column.type == ArrowType::Utf8) {
+            column.offsets.assign(1, 0);
+        }
+    }
+    rows_ = 0;
+}
+
+ArrowFileWriter::Block ArrowFileWriter::writeMessage(const std::string& metadata, const std::string& body) {
+    // Encapsulated message: continuation marker, padded metadata length, metadata, body
+    std::string prefix;
+    appendScalar<uint32_t>(prefix, 0xFFFFFFFFu);
+    appendScalar(prefix, static_cast<int32_t>(metadata.size()));
+    Block block{position_, prefix.size() + metadata.size(), body.size()};
+    writeBytes(prefix.data(), prefix.size());
+    writeBytes(metadata.data(), metadata.size());
+    writeBytes(body.data(), body.size());
+    return block;
+}
+
+void ArrowFileWriter::writeBytes(const char* data, size_t size) {
+    output_->write(std::string_view(data, size));
+    position_ += size;
+}
+
+} // namespace core
+} // namespace suzume
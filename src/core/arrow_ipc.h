@@ -0,0 +1,147 @@
+/**
+ * @file arrow_ipc.h
+ * @brief Tables written in the Arrow IPC file format
+ */
+
+#ifndef SUZUME_CORE_ARROW_IPC_H_
+#define SUZUME_CORE_ARROW_IPC_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+class OutputWriter;
+
+/**
+ * @brief Column types an ArrowFileWriter can write
+ */
+enum class ArrowType {
+    Utf8,    ///< Variable-length UTF-8 strings (32-bit offsets)
+    Float64, ///< IEEE 754 doubles
+    UInt32   ///< Unsigned 32-bit integers
+};
+
+/**
+ * @brief Name and type of a column
+ */
+struct ArrowField {
+    std::string name;
+    ArrowType type;
+};
+
+/**
+ * @brief Check whether an output path asks for Arrow IPC by its extension
+ *
+ * @param path Output file path
+ * @return bool True if the path ends in ".arrow"
+ */
+bool isArrowOutputPath(const std::string& path);
+
+/**
+ * @brief Writes rows as an Arrow IPC file (Feather v2) without the Arrow library
+ *
+ * Rows are gathered column by column and written as a record batch every
+ * batchRows rows, each column as one contiguous little-endian buffer
+ * aligned to 8 bytes. The schema, the batches and the footer locating them
+ * follow the Arrow columnar format, so Arrow, DuckDB and pandas map the
+ * file and use the columns in place; doubles keep every bit.
+ *
+ * The metadata is encoded with a small FlatBuffers writer covering just the
+ * tables the file needs. Columns are not nullable and the body is not
+ * compressed.
+ */
+class ArrowFileWriter {
+public:
+    /// Default rows per record batch
+    static constexpr size_t kDefaultBatchRows = 64 * 1024;
+
+    /**
+     * @brief Open an output file and write the schema
+     * @param path Output path ("-" for stdout)
+     * @param fields Columns of every row
+     * @param batchRows Rows per record batch (at least 1)
+     * @throws std::invalid_argument If there are no columns
+     * @throws std::runtime_error If the file cannot be opened
+     */
+    ArrowFileWriter(const std::string& path, std::vector<ArrowField> fields,
+                    size_t batchRows = kDefaultBatchRows);
+
+    /**
+     * @brief Destructor; closes the file if close() was not called, ignoring errors
+     */
+    ~ArrowFileWriter();
+
+    ArrowFileWriter(const ArrowFileWriter&) = delete;
+    ArrowFileWriter& operator=(const ArrowFileWriter&) = delete;
+
+    /**
+     * @brief Set a Utf8 column of the current row
+     * @param column Column index
+     * @param value Value
+     * @throws std::invalid_argument If the column is not Utf8
+     */
+    void append(size_t column, std::string_view value);
+
+    /**
+     * @brief Set a Float64 column of the current row
+     * @param column Column index
+     * @param value Value
+     * @throws std::invalid_argument If the column is not Float64
+     */
+    void append(size_t column, double value);
+
+    /**
+     * @brief Set a UInt32 column of the current row
+     * @param column Column index
+     * @param value Value
+     * @throws std::invalid_argument If the column is not UInt32
+     */
+    void append(size_t column, uint32_t value);
+
+    /**
+     * @brief Finish the current row, writing a record batch once it is full
+     * @throws std::logic_error If a column of the row was not set exactly once
+     * @throws std::runtime_error If the file cannot be written
+     */
+    void endRow();
+
+    /**
+     * @brief Write the last record batch and the footer, and close the file
+     * @throws std::runtime_error If the file cannot be written
+     */
+    void close();
+
+private:
+    struct Column;
+
+    /// Location of a record batch, as listed in the footer
+    struct Block {
+        uint64_t offset;
+        uint64_t metadataLength;
+        uint64_t bodyLength;
+    };
+
+    Column& column(size_t index, ArrowType type);
+    void writeBatch();
+    Block writeMessage(const std::string& metadata, const std::string& body);
+    void writeBytes(const char* data, size_t size);
+
+    std::vector<ArrowField> fields_;
+    std::vector<Column> columns_;
+    size_t batchRows_;
+    size_t rows_;                    ///< Rows in the current batch
+    std::unique_ptr<OutputWriter> output_;
+    uint64_t position_;              ///< Bytes written so far
+    std::vector<Block> blocks_;      ///< Record batches written so far
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_ARROW_IPC_H_
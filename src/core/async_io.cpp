@@ -0,0 +1,541 @@
+/**
+ * @file async_io.cpp
+ * @brief Implementation of asynchronous file I/O through io_uring
+ */
+
+#include "core/async_io.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef SUZUME_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+std::atomic<IoBackend> selectedBackend{IoBackend::Sync};
+
+/**
+ * @brief Read exactly size bytes at offset, or fewer at the end of the file
+ *
+ * @param fd File descriptor
+ * @param data Destination
+ * @param size Bytes wanted
+ * @param offset File offset
+ * @param path File path, for error messages
+ * @return size_t Bytes read
+ * @throws std::runtime_error If a read fails
+ */
+size_t preadFully(int fd, char* data, size_t size, uint64_t offset, const std::string& path) {
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = ::pread(fd, data + done, size - done, static_cast<off_t>(offset + done));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to read input file: " + path + ": " + std::strerror(errno));
+        }
+        if (got == 0) {
+            break;
+        }
+        done += static_cast<size_t>(got);
+    }
+    return done;
+}
+
+} // namespace
+
+#ifdef SUZUME_HAVE_IO_URING
+
+/**
+ * @brief Minimal io_uring submission and completion ring
+ *
+ * Talks to the kernel through the raw system calls, so no liburing is
+ * needed. Buffers are registered once when the kernel allows it and used
+ * with the fixed-buffer opcodes; otherwise the vectored opcodes are used
+ * on the same buffers. One thread drives a ring.
+ */
+class IoRing {
+public:
+    /// A finished request
+    struct Completion {
+        size_t slot;    ///< Buffer the request used
+        int64_t result; ///< Bytes transferred, or -errno
+    };
+
+    explicit IoRing(unsigned entries) {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd_ = static_cast<int>(::syscall(__NR_io_uring_setup, entries, &params));
+        if (fd_ < 0) {
+            throw std::runtime_error(std::string("io_uring_setup failed: ") + std::strerror(errno));
+        }
+
+        sqRingSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMap = false;
+#ifdef IORING_FEAT_SINGLE_MMAP
+        singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+#endif
+        if (singleMap) {
+            sqRingSize_ = cqRingSize_ = std::max(sqRingSize_, cqRingSize_);
+        }
+
+        sqRing_ = ::mmap(nullptr, sqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                         IORING_OFF_SQ_RING);
+        if (sqRing_ == MAP_FAILED) {
+            sqRing_ = nullptr;
+            release();
+            throw std::runtime_error("Failed to map the io_uring submission ring");
+        }
+        if (singleMap) {
+            cqRing_ = sqRing_;
+        } else {
+            cqRing_ = ::mmap(nullptr, cqRingSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                             IORING_OFF_CQ_RING);
+            if (cqRing_ == MAP_FAILED) {
+                cqRing_ = nullptr;
+                release();
+                throw std::runtime_error("Failed to map the io_uring completion ring");
+            }
+        }
+        sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqes = ::mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_,
+                            IORING_OFF_SQES);
+        if (sqes == MAP_FAILED) {
+            release();
+            throw std::runtime_error("Failed to map the io_uring submission entries");
+        }
+        sqes_ = static_cast<io_uring_sqe*>(sqes);
+
+        char* sq = static_cast<char*>(sqRing_);
+        sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        char* cq = static_cast<char*>(cqRing_);
+        cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    }
+
+    ~IoRing() {
+        release();
+    }
+
+    IoRing(const IoRing&) = delete;
+    IoRing& operator=(const IoRing&) = delete;
+
+    /**
+     * @brief Set up count buffers of blockSize bytes laid out from data
+     *
+     * Registration pins the buffers in the kernel; when the memory lock
+     * limit refuses it, requests fall back to the vectored opcodes.
+     */
+    void registerBuffers(char* data, size_t blockSize, size_t count) {
+        iovecs_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            iovecs_[i].iov_base = data + i * blockSize;
+            iovecs_[i].iov_len = blockSize;
+        }
+        fixed_ = ::syscall(__NR_io_uring_register, fd_, IORING_REGISTER_BUFFERS, iovecs_.data(),
+                           static_cast<unsigned>(count)) == 0;
+    }
+
+    /**
+     * @brief Queue a read or write of length bytes of a slot's buffer
+     */
+    void queue(bool write, int fd, size_t slot, size_t length, uint64_t offset) {
+        unsigned tail = *sqTail_;
+        unsigned index = tail & sqMask_;
+        io_uring_sqe& sqe = sqes_[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        sqe.fd = fd;
+        sqe.off = offset;
+        sqe.user_data = slot;
+        if (fixed_) {
+            sqe.opcode = write ? IORING_OP_WRITE_FIXED : IORING_OP_READ_FIXED;
+            sqe.addr = reinterpret_cast<uint64_t>(iovecs_[slot].iov_base);
+            sqe.len = static_cast<uint32_t>(length);
+            sqe.buf_index = static_cast<uint16_t>(slot);
+        } else {
+            // The iovec must stay put until the request completes; only its length changes
+            iovecs_[slot].iov_len = length;
+            sqe.opcode = write ? IORING_OP_WRITEV : IORING_OP_READV;
+            sqe.addr = reinterpret_cast<uint64_t>(&iovecs_[slot]);
+            sqe.len = 1;
+        }
+        sqArray_[index] = index;
+        __atomic_store_n(sqTail_, tail + 1, __ATOMIC_RELEASE);
+        pending_++;
+    }
+
+    /**
+     * @brief Hand every queued request to the kernel
+     */
+    void submit() {
+        while (pending_ > 0) {
+            long submitted = ::syscall(__NR_io_uring_enter, fd_, pending_, 0, 0, nullptr, 0);
+            if (submitted < 0) {
+                if (errno == EINTR || errno == EAGAIN) {
+                    continue;
+                }
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+            pending_ -= static_cast<unsigned>(submitted);
+        }
+    }
+
+    /**
+     * @brief Wait for the next request to finish
+     */
+    Completion wait() {
+        while (true) {
+            unsigned head = *cqHead_;
+            if (head != __atomic_load_n(cqTail_, __ATOMIC_ACQUIRE)) {
+                const io_uring_cqe& cqe = cqes_[head & cqMask_];
+                Completion completion{static_cast<size_t>(cqe.user_data), cqe.res};
+                __atomic_store_n(cqHead_, head + 1, __ATOMIC_RELEASE);
+                return completion;
+            }
+            long result = ::syscall(__NR_io_uring_enter, fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (result < 0 && errno != EINTR && errno != EAGAIN) {
+                throw std::runtime_error(std::string("io_uring_enter failed: ") + std::strerror(errno));
+            }
+        }
+    }
+
+private:
+    void release() {
+        if (sqes_) {
+            ::munmap(sqes_, sqesSize_);
+        }
+        if (cqRing_ && cqRing_ != sqRing_) {
+            ::munmap(cqRing_, cqRingSize_);
+        }
+        if (sqRing_) {
+            ::munmap(sqRing_, sqRingSize_);
+        }
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    int fd_ = -1;
+    void* sqRing_ = nullptr;
+    void* cqRing_ = nullptr;
+    size_t sqRingSize_ = 0;
+    size_t cqRingSize_ = 0;
+    io_uring_sqe* sqes_ = nullptr;
+    size_t sqesSize_ = 0;
+    unsigned* sqTail_ = nullptr;
+    unsigned sqMask_ = 0;
+    unsigned* sqArray_ = nullptr;
+    unsigned* cqHead_ = nullptr;
+    unsigned* cqTail_ = nullptr;
+    unsigned cqMask_ = 0;
+    io_uring_cqe* cqes_ = nullptr;
+    std::vector<iovec> iovecs_;
+    unsigned pending_ = 0;
+    bool fixed_ = false;
+};
+
+#else
+
+// Builds without io_uring never create a ring (isIoUringAvailable() is false)
+class IoRing {
+public:
+    struct Completion {
+        size_t slot;
+        int64_t result;
+    };
+
+    explicit IoRing(unsigned) {
+        throw std::runtime_error("io_uring support is not built in");
+    }
+
+    void registerBuffers(char*, size_t, size_t) {}
+    void queue(bool, int, size_t, size_t, uint64_t) {}
+    void submit() {}
+    Completion wait() { return Completion{0, -EINVAL}; }
+};
+
+#endif
+
+void setIoBackend(IoBackend backend) {
+    selectedBackend.store(backend);
+}
+
+IoBackend ioBackend() {
+    return selectedBackend.load();
+}
+
+bool isIoUringAvailable() {
+    static const bool available = [] {
+        try {
+            IoRing ring(2);
+            return true;
+        } catch (const std::exception&) {
+            return false;
+        }
+    }();
+    return available;
+}
+
+// AsyncFileReader implementation
+
+AsyncFileReader::AsyncFileReader(const std::string& path, IoBackend backend, size_t blockSize, size_t depth)
+    : path_(path)
+    , fd_(-1)
+    , fileSize_(0)
+    , blockSize_(std::max<size_t>(blockSize, 1))
+    , submitOffset_(0)
+    , deliverOffset_(0)
+    , deliverSlot_(0)
+    , inFlight_(0)
+    , returnedSlot_(false)
+{
+    fd_ = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ < 0) {
+        throw std::runtime_error("Failed to open input file: " + path);
+    }
+    struct stat sb;
+    if (::fstat(fd_, &sb) != 0) {
+        ::close(fd_);
+        throw std::runtime_error("Failed to open input file: " + path);
+    }
+    fileSize_ = static_cast<uint64_t>(sb.st_size);
+
+    // Small files need neither full-size blocks nor more buffers than blocks
+    blockSize_ = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(blockSize_, fileSize_)));
+    uint64_t blocks = (fileSize_ + blockSize_ - 1) / blockSize_;
+    size_t slots = static_cast<size_t>(std::max<uint64_t>(1, std::min<uint64_t>(std::max<size_t>(depth, 1), blocks)));
+
+    if (backend == IoBackend::IoUring && blocks > 0 && isIoUringAvailable()) {
+        try {
+            ring_ = std::make_unique<IoRing>(static_cast<unsigned>(slots));
+        } catch (const std::exception&) {
+            ring_.reset();
+        }
+    }
+    if (!ring_) {
+        slots = 1;
+    }
+
+    buffers_.resize(slots * blockSize_);
+    results_.assign(slots, 0);
+    if (ring_) {
+        ring_->registerBuffers(buffers_.data(), blockSize_, slots);
+        for (size_t slot = 0; slot < slots && submitOffset_ < fileSize_; ++slot) {
+            submit(slot);
+        }
+        ring_->submit();
+    }
+}
+
+AsyncFileReader::~AsyncFileReader() {
+    // The kernel may still be writing into the buffers
+    try {
+        while (ring_ && inFlight_ > 0) {
+            ring_->wait();
+            inFlight_--;
+        }
+    } catch (const std::exception&) {
+        // Destructors must not throw
+    }
+    ring_.reset();
+    ::close(fd_);
+}
+
+bool AsyncFileReader::next(std::string_view& block) {
+    size_t slots = results_.size();
+    if (returnedSlot_) {
+        // The buffer just returned is free again; read ahead into it
+        if (ring_ && submitOffset_ < fileSize_) {
+            submit(deliverSlot_);
+            ring_->submit();
+        }
+        deliverSlot_ = (deliverSlot_ + 1) % slots;
+        returnedSlot_ = false;
+    }
+    if (deliverOffset_ >= fileSize_) {
+        return false;
+    }
+
+    size_t length = static_cast<size_t>(std::min<uint64_t>(blockSize_, fileSize_ - deliverOffset_));
+    char* data = buffers_.data() + deliverSlot_ * blockSize_;
+    size_t got = 0;
+    if (ring_) {
+        while (results_[deliverSlot_] < 0) {
+            IoRing::Completion completion = ring_->wait();
+            inFlight_--;
+            if (completion.result < 0) {
+                results_[completion.slot] = 0;
+                throw std::runtime_error("Failed to read input file: " + path_ + ": " +
+                                         std::strerror(static_cast<int>(-completion.result)));
+            }
+            results_[completion.slot] = completion.result;
+        }
+        got = static_cast<size_t>(results_[deliverSlot_]);
+        if (got < length) {
+            // Short reads are finished here rather than resubmitted
+            got += preadFully(fd_, data + got, length - got, deliverOffset_ + got, path_);
+        }
+    } else {
+        got = preadFully(fd_, data, length, deliverOffset_, path_);
+    }
+
+    block = std::string_view(data, got);
+    deliverOffset_ += length;
+    returnedSlot_ = true;
+    return true;
+}
+
+void AsyncFileReader::submit(size_t slot) {
+    size_t length = static_cast<size_t>(std::min<uint64_t>(blockSize_, fileSize_ - submitOffset_));
+    results_[slot] = -1;
+    ring_->queue(false, fd_, slot, length, submitOffset_);
+    submitOffset_ += length;
+    inFlight_++;
+}
+
+// AsyncFileWriter implementation
+
+AsyncFileWriter::AsyncFileWriter(int fd, const std::string& path, IoBackend backend, size_t blockSize, size_t depth)
+    : fd_(fd)
+    , path_(path)
+    , blockSize_(std::max<size_t>(blockSize, 1))
+    , offset_(0)
+    , inFlight_(0)
+{
+    if (backend != IoBackend::IoUring || !isIoUringAvailable()) {
+        return;
+    }
+    size_t slots = std::max<size_t>(depth, 1);
+    try {
+        ring_ = std::make_unique<IoRing>(static_cast<unsigned>(slots));
+    } catch (const std::exception&) {
+        return;
+    }
+    buffers_.resize(slots * blockSize_);
+    offsets_.assign(slots, 0);
+    lengths_.assign(slots, 0);
+    ring_->registerBuffers(buffers_.data(), blockSize_, slots);
+}
+
+AsyncFileWriter::~AsyncFileWriter() {
+    try {
+        finish();
+    } catch (const std::exception&) {
+        // Destructors must not throw
+    }
+}
+
+void AsyncFileWriter::write(const char* data, size_t size) {
+    if (!ring_) {
+        writeAt(data, size, offset_);
+        offset_ += size;
+        return;
+    }
+    while (size > 0) {
+        size_t slot = acquireSlot();
+        size_t length = std::min(size, blockSize_);
+        std::memcpy(buffers_.data() + slot * blockSize_, data, length);
+        offsets_[slot] = offset_;
+        lengths_[slot] = length;
+        ring_->queue(true, fd_, slot, length, offset_);
+        ring_->submit();
+        inFlight_++;
+        offset_ += length;
+        data += length;
+        size -= length;
+    }
+}
+
+void AsyncFileWriter::finish() {
+    while (inFlight_ > 0) {
+        reap();
+    }
+}
+
+size_t AsyncFileWriter::acquireSlot() {
+    while (true) {
+        for (size_t slot = 0; slot < lengths_.size(); ++slot) {
+            if (lengths_[slot] == 0) {
+                return slot;
+            }
+        }
+        reap();
+    }
+}
+
+void AsyncFileWriter::reap() {
+    IoRing::Completion completion = ring_->wait();
+    inFlight_--;
+    size_t slot = completion.slot;
+    size_t length = lengths_[slot];
+    lengths_[slot] = 0;
+    if (completion.result < 0) {
+        throw std::runtime_error("Failed to write output file: " + path_ + ": " +
+                                 std::strerror(static_cast<int>(-completion.result)));
+    }
+    size_t written = static_cast<size_t>(completion.result);
+    if (written < length) {
+        // Short writes are finished here rather than resubmitted
+        writeAt(buffers_.data() + slot * blockSize_ + written, length - written, offsets_[slot] + written);
+    }
+}
+
+void AsyncFileWriter::writeAt(const char* data, size_t size, uint64_t offset) {
+    while (size > 0) {
+        ssize_t written = ::pwrite(fd_, data, size, static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write output file: " + path_);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+        offset += static_cast<uint64_t>(written);
+    }
+}
+
+// AsyncInputStream implementation
+
+AsyncInputStream::AsyncInputStream(const std::string& path, IoBackend backend)
+    : std::istream(nullptr)
+    , buffer_(path, backend)
+{
+    rdbuf(&buffer_);
+    // Read errors reach the caller instead of only setting badbit
+    exceptions(std::ios::badbit);
+}
+
+AsyncInputStream::StreamBuf::int_type AsyncInputStream::StreamBuf::underflow() {
+    std::string_view block;
+    do {
+        if (!reader_.next(block)) {
+            return traits_type::eof();
+        }
+    } while (block.empty());
+    char* data = const_cast<char*>(block.data());
+    setg(data, data, data + block.size());
+    return traits_type::to_int_type(*data);
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,227 @@
+/**
+ * @file async_io.h
+ * @brief Asynchronous file reads and writes through io_uring on Linux
+ */
+
+#ifndef SUZUME_CORE_ASYNC_IO_H_
+#define SUZUME_CORE_ASYNC_IO_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief How plain input files are read and output files written
+ */
+enum class IoBackend {
+    Sync,    ///< std::ifstream and write(2), one request at a time (default)
+    IoUring  ///< Several requests in flight through io_uring, pread/pwrite where unavailable
+};
+
+/**
+ * @brief Select the backend used by openInputStream() and OutputWriter
+ *
+ * The setting is process-wide and read when a file is opened, so files
+ * already open keep the backend they started with.
+ *
+ * @param backend Backend for files opened from now on
+ */
+void setIoBackend(IoBackend backend);
+
+/**
+ * @brief Get the selected backend
+ * @return IoBackend Backend set with setIoBackend()
+ */
+IoBackend ioBackend();
+
+/**
+ * @brief Check whether io_uring rings can be created
+ *
+ * Needs a build with SUZUME_HAVE_IO_URING and a kernel that permits
+ * io_uring_setup(2); the answer is probed once and cached.
+ *
+ * @return bool True if io_uring is usable
+ */
+bool isIoUringAvailable();
+
+class IoRing;
+
+/**
+ * @brief Reads a regular file front to back with several reads in flight
+ *
+ * The file is read into a ring of depth buffers of blockSize bytes each,
+ * registered with the kernel once. While the caller works on one block the
+ * following ones are already being read, so a fast device sees depth
+ * requests at a time instead of one. Blocks are returned in file order.
+ * Without io_uring each block is read with pread(2) when it is asked for.
+ */
+class AsyncFileReader {
+public:
+    /// Default bytes per read
+    static constexpr size_t kDefaultBlockSize = 4 * 1024 * 1024;
+
+    /// Default number of reads in flight
+    static constexpr size_t kDefaultDepth = 4;
+
+    /**
+     * @brief Open a file
+     * @param path File path
+     * @param backend IoUring to read ahead, Sync to read with pread only
+     * @param blockSize Bytes per read (at least 1)
+     * @param depth Reads in flight (at least 1)
+     * @throws std::runtime_error If the file cannot be opened
+     */
+    AsyncFileReader(const std::string& path, IoBackend backend, size_t blockSize = kDefaultBlockSize,
+                    size_t depth = kDefaultDepth);
+
+    /**
+     * @brief Destructor; waits for reads still in flight
+     */
+    ~AsyncFileReader();
+
+    AsyncFileReader(const AsyncFileReader&) = delete;
+    AsyncFileReader& operator=(const AsyncFileReader&) = delete;
+
+    /**
+     * @brief Get the next block of the file
+     * @param block Receives the block, valid until the next call
+     * @return bool False once the whole file has been returned
+     * @throws std::runtime_error If a read fails
+     */
+    bool next(std::string_view& block);
+
+    /**
+     * @brief Check whether reads go through io_uring
+     * @return bool True if a ring is in use
+     */
+    bool usesIoUring() const { return ring_ != nullptr; }
+
+private:
+    void submit(size_t slot);
+    void complete(size_t slot, size_t length);
+
+    std::string path_;
+    int fd_;
+    uint64_t fileSize_;
+    size_t blockSize_;
+    std::vector<char> buffers_;
+    std::vector<int64_t> results_;   ///< Bytes read per slot (-1 while in flight)
+    std::unique_ptr<IoRing> ring_;
+    uint64_t submitOffset_;          ///< Offset of the next read to submit
+    uint64_t deliverOffset_;         ///< Offset of the next block to return
+    size_t deliverSlot_;
+    size_t inFlight_;
+    bool returnedSlot_;              ///< The last block returned still has to be resubmitted
+};
+
+/**
+ * @brief Writes blocks to a file with several writes in flight
+ *
+ * Every block is copied into one of depth registered buffers and submitted
+ * at its offset, so the caller goes on producing while earlier blocks are
+ * written. A write waits only when every buffer is still in flight. Without
+ * io_uring blocks are written with pwrite(2) at once.
+ */
+class AsyncFileWriter {
+public:
+    /// Default bytes per write
+    static constexpr size_t kDefaultBlockSize = 1024 * 1024;
+
+    /// Default number of writes in flight
+    static constexpr size_t kDefaultDepth = 4;
+
+    /**
+     * @brief Constructor
+     * @param fd Open file descriptor of a regular file, written from its start (not owned)
+     * @param path File path, for error messages
+     * @param backend IoUring to write asynchronously, Sync to write with pwrite only
+     * @param blockSize Bytes per write (at least 1)
+     * @param depth Writes in flight (at least 1)
+     */
+    AsyncFileWriter(int fd, const std::string& path, IoBackend backend, size_t blockSize = kDefaultBlockSize,
+                    size_t depth = kDefaultDepth);
+
+    /**
+     * @brief Destructor; waits for writes still in flight, ignoring errors (call finish() to see them)
+     */
+    ~AsyncFileWriter();
+
+    AsyncFileWriter(const AsyncFileWriter&) = delete;
+    AsyncFileWriter& operator=(const AsyncFileWriter&) = delete;
+
+    /**
+     * @brief Append bytes to the file
+     * @param data Bytes to write (may be reused once the call returns)
+     * @param size Number of bytes
+     * @throws std::runtime_error If an earlier or this write fails
+     */
+    void write(const char* data, size_t size);
+
+    /**
+     * @brief Wait until everything written so far is in the file
+     * @throws std::runtime_error If a write failed
+     */
+    void finish();
+
+    /**
+     * @brief Check whether writes go through io_uring
+     * @return bool True if a ring is in use
+     */
+    bool usesIoUring() const { return ring_ != nullptr; }
+
+private:
+    size_t acquireSlot();
+    void reap();
+    void writeAt(const char* data, size_t size, uint64_t offset);
+
+    int fd_;
+    std::string path_;
+    size_t blockSize_;
+    std::vector<char> buffers_;
+    std::vector<uint64_t> offsets_;  ///< File offset per slot
+    std::vector<size_t> lengths_;    ///< Bytes per slot (0 when free)
+    std::unique_ptr<IoRing> ring_;
+    uint64_t offset_;
+    size_t inFlight_;
+};
+
+/**
+ * @brief Input stream over an AsyncFileReader
+ */
+class AsyncInputStream : public std::istream {
+public:
+    /**
+     * @brief Open a file for reading ahead
+     * @param path File path
+     * @param backend Backend passed to the reader
+     * @throws std::runtime_error If the file cannot be opened
+     */
+    AsyncInputStream(const std::string& path, IoBackend backend);
+
+private:
+    class StreamBuf : public std::streambuf {
+    public:
+        StreamBuf(const std::string& path, IoBackend backend) : reader_(path, backend) {}
+
+    protected:
+        int_type underflow() override;
+
+    private:
+        AsyncFileReader reader_;
+    };
+
+    StreamBuf buffer_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_ASYNC_IO_H_
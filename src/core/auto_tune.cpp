@@ -0,0 +1,185 @@
+/**
+ * @file auto_tune.cpp
+ * @brief Implementation of input-aware tuning of workers and chunks
+ */
+
+#include "core/auto_tune.h"
+#include "core/memory_accounting.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/// Work chunks aimed at per worker, so fast workers take over from slow ones
+constexpr uint64_t kChunksPerThread = 4;
+constexpr uint64_t kMinChunkBytes = 16 * 1024;
+constexpr uint64_t kMaxChunkBytes = 64 * 1024 * 1024;
+
+/**
+ * @brief Read the first line of a file
+ * @param path File path
+ * @param line Receives the line
+ * @return bool True if the file was read
+ */
+bool readFirstLine(const char* path, std::string& line) {
+    std::ifstream file(path);
+    return file && std::getline(file, line);
+}
+
+/**
+ * @brief Read a byte count of a cgroup file ("max" and absurd values mean none)
+ * @param path File path
+ * @return uint64_t Bytes, 0 if the file is missing or sets no limit
+ */
+uint64_t readCgroupBytes(const char* path) {
+    std::string line;
+    if (!readFirstLine(path, line) || line == "max") {
+        return 0;
+    }
+    try {
+        uint64_t bytes = std::stoull(line);
+        // cgroup v1 reports "no limit" as a page-aligned maximum
+        return bytes >= (uint64_t{1} << 62) ? 0 : bytes;
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned int detectCpus() {
+    unsigned int cpus = std::max(1u, std::thread::hardware_concurrency());
+
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        cpus = std::min(cpus, static_cast<unsigned int>(std::max(1, CPU_COUNT(&set))));
+    }
+
+    // cgroup v2 keeps quota and period on one line; v1 in two files
+    unsigned int quotaCpus = 0;
+    std::string line;
+    if (readFirstLine("/sys/fs/cgroup/cpu.max", line)) {
+        std::istringstream fields(line);
+        std::string quota;
+        std::string period;
+        fields >> quota >> period;
+        quotaCpus = cgroupCpuLimit(quota, period);
+    } else {
+        std::string quota;
+        std::string period;
+        if (readFirstLine("/sys/fs/cgroup/cpu/cpu.cfs_quota_us", quota) &&
+            readFirstLine("/sys/fs/cgroup/cpu/cpu.cfs_period_us", period)) {
+            quotaCpus = cgroupCpuLimit(quota, period);
+        }
+    }
+    if (quotaCpus > 0) {
+        cpus = std::min(cpus, quotaCpus);
+    }
+#endif
+
+    return cpus;
+}
+
+} // namespace
+
+unsigned int cgroupCpuLimit(const std::string& quota, const std::string& period) {
+    try {
+        if (quota.empty() || quota == "max" || quota[0] == '-') {
+            return 0;
+        }
+        uint64_t quotaMicros = std::stoull(quota);
+        uint64_t periodMicros = period.empty() ? 100000 : std::stoull(period);
+        if (quotaMicros == 0 || periodMicros == 0) {
+            return 0;
+        }
+        return static_cast<unsigned int>(std::max<uint64_t>(1, (quotaMicros + periodMicros - 1) / periodMicros));
+    } catch (const std::exception&) {
+        return 0;
+    }
+}
+
+unsigned int availableCpus() {
+    static const unsigned int cpus = detectCpus();
+    return cpus;
+}
+
+uint64_t tuningMemory() {
+    if (memoryLimit() > 0) {
+        return memoryLimit() / 2;
+    }
+
+    uint64_t available = 0;
+    std::ifstream meminfo("/proc/meminfo");
+    std::string key;
+    uint64_t kilobytes = 0;
+    std::string unit;
+    while (meminfo >> key >> kilobytes >> unit) {
+        if (key == "MemAvailable:") {
+            available = kilobytes * 1024;
+            break;
+        }
+    }
+
+    uint64_t cgroupLimit = readCgroupBytes("/sys/fs/cgroup/memory.max");
+    if (cgroupLimit == 0) {
+        cgroupLimit = readCgroupBytes("/sys/fs/cgroup/memory/memory.limit_in_bytes");
+    }
+    if (cgroupLimit > 0) {
+        available = available > 0 ? std::min(available, cgroupLimit) : cgroupLimit;
+    }
+    return available / 2;
+}
+
+TuningChoice tuneWorkers(uint32_t requestedThreads, const WorkloadShape& shape) {
+    TuningChoice choice;
+    choice.availableCpus = availableCpus();
+
+    uint64_t threads = choice.availableCpus;
+    choice.reason = "cpus";
+    if (requestedThreads > 0) {
+        threads = requestedThreads;
+        choice.reason = "requested";
+    } else {
+        // Workers without their minimum share cost more to start than they save
+        uint64_t bySize = threads;
+        if (shape.inputBytes > 0 && shape.minBytesPerThread > 0) {
+            bySize = std::min(bySize, shape.inputBytes / shape.minBytesPerThread);
+        }
+        if (shape.items > 0 && shape.minItemsPerThread > 0) {
+            bySize = std::min(bySize, shape.items / shape.minItemsPerThread);
+        }
+        if (bySize < threads) {
+            threads = std::max<uint64_t>(1, bySize);
+            choice.reason = "input size";
+        }
+        uint64_t memory = shape.memoryPerThread > 0 ? tuningMemory() : 0;
+        if (memory > 0 && memory / shape.memoryPerThread < threads) {
+            threads = std::max<uint64_t>(1, memory / shape.memoryPerThread);
+            choice.reason = "memory";
+        }
+    }
+    choice.threads = static_cast<uint32_t>(threads);
+    choice.variant = threads > 1 ? "parallel" : "serial";
+
+    if (shape.inputBytes > 0) {
+        uint64_t chunk = shape.inputBytes / (threads * kChunksPerThread);
+        choice.chunkBytes = std::min(std::max(chunk, kMinChunkBytes), kMaxChunkBytes);
+    }
+    return choice;
+}
+
+unsigned int resolveThreads(uint32_t requestedThreads) {
+    return requestedThreads > 0 ? requestedThreads : availableCpus();
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,80 @@
+/**
+ * @file auto_tune.h
+ * @brief Thread count, chunk size and code path chosen from the input and the machine
+ */
+
+#ifndef SUZUME_CORE_AUTO_TUNE_H_
+#define SUZUME_CORE_AUTO_TUNE_H_
+
+#include <cstdint>
+#include <string>
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Shape of the work an operation is about to parallelize
+ */
+struct WorkloadShape {
+    uint64_t inputBytes = 0;         ///< Bytes of input (0 = unknown)
+    uint64_t items = 0;              ///< Lines or records of input (0 = unknown)
+    uint64_t minBytesPerThread = 0;  ///< Least input per worker that pays for the worker (0 = no minimum)
+    uint64_t minItemsPerThread = 0;  ///< Least items per worker that pays for the worker (0 = no minimum)
+    uint64_t memoryPerThread = 0;    ///< Memory each extra worker holds on its own (0 = negligible)
+};
+
+/**
+ * @brief Get the number of CPUs the process may run on
+ *
+ * The smallest of the hardware threads, the CPUs in the affinity mask and
+ * the cgroup CPU quota (cgroup v2 cpu.max, or v1 cfs_quota_us over
+ * cfs_period_us) rounded up. Read once and cached.
+ *
+ * @return unsigned int CPUs, at least 1
+ */
+unsigned int availableCpus();
+
+/**
+ * @brief Parse a cgroup CPU quota
+ *
+ * @param quota Quota in microseconds per period ("max" or negative = none)
+ * @param period Period in microseconds
+ * @return unsigned int CPUs the quota allows, rounded up (0 = no quota)
+ */
+unsigned int cgroupCpuLimit(const std::string& quota, const std::string& period);
+
+/**
+ * @brief Get the memory extra workers may use
+ * @return uint64_t Half of the memory limit (setMemoryLimit()), or of the
+ *         available memory of the machine and the cgroup; 0 if unknown
+ */
+uint64_t tuningMemory();
+
+/**
+ * @brief Choose the worker threads and chunk size of an operation
+ *
+ * An explicit thread count is kept. Otherwise the available CPUs are used,
+ * unless the input is too small to give every worker its minimum share or
+ * the workers' own memory would not fit in tuningMemory(). Chunks aim at
+ * four per worker, between 16 KiB and 64 MiB. The variant is "serial" for
+ * one thread and "parallel" otherwise; callers with other code paths set
+ * their own.
+ *
+ * @param requestedThreads Threads asked for (0 = auto)
+ * @param shape Shape of the work
+ * @return TuningChoice Threads, chunk size, variant and the reason for the thread count
+ */
+TuningChoice tuneWorkers(uint32_t requestedThreads, const WorkloadShape& shape);
+
+/**
+ * @brief Resolve a thread count without input to size it by (0 = every available CPU)
+ * @param requestedThreads Threads asked for (0 = auto)
+ * @return unsigned int Threads, at least 1
+ */
+unsigned int resolveThreads(uint32_t requestedThreads);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_AUTO_TUNE_H_
@@ -0,0 +1,79 @@
+/**
+ * @file background_writer.cpp
+ * @brief Implementation of the background writer thread
+ */
+
+#include "core/background_writer.h"
+#include <algorithm>
+
+namespace suzume {
+namespace core {
+
+BackgroundWriter::BackgroundWriter(size_t depth)
+    : depth_(std::max<size_t>(depth, 1))
+    , closing_(false)
+{
+    thread_ = std::thread(&BackgroundWriter::run, this);
+}
+
+BackgroundWriter::~BackgroundWriter() {
+    try {
+        finish();
+    } catch (...) {
+        // Destructors must not throw
+    }
+}
+
+void BackgroundWriter::submit(std::function<void()> job) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    space_.wait(lock, [this] { return jobs_.size() < depth_ || error_; });
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+    jobs_.push_back(std::move(job));
+    ready_.notify_one();
+}
+
+void BackgroundWriter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        closing_ = true;
+    }
+    ready_.notify_one();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (error_) {
+        std::rethrow_exception(error_);
+    }
+}
+
+void BackgroundWriter::run() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            ready_.wait(lock, [this] { return !jobs_.empty() || closing_; });
+            if (jobs_.empty()) {
+                return;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+        }
+        space_.notify_one();
+
+        try {
+            job();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            error_ = std::current_exception();
+            jobs_.clear();
+            space_.notify_all();
+            return;
+        }
+    }
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,80 @@
+/**
+ * @file background_writer.h
+ * @brief Output written on a dedicated thread while results are still being computed
+ */
+
+#ifndef SUZUME_CORE_BACKGROUND_WRITER_H_
+#define SUZUME_CORE_BACKGROUND_WRITER_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Runs write jobs in submission order on one writer thread
+ *
+ * Producers hand over each finished piece of output (a batch of lines, the
+ * results of one order) as a job and go back to computing the next one.
+ * At most depth jobs wait at a time, so with the job being written this is
+ * a double or triple buffer: a producer that runs ahead of the disk blocks
+ * instead of piling up output in memory.
+ *
+ * The first job that throws stops the writer; its exception is rethrown by
+ * every later submit() and finish(), and the jobs still queued are dropped.
+ */
+class BackgroundWriter {
+public:
+    /// Default number of jobs waiting to be written
+    static constexpr size_t kDefaultDepth = 2;
+
+    /**
+     * @brief Constructor; starts the writer thread
+     * @param depth Jobs that may wait while one is written (at least 1)
+     */
+    explicit BackgroundWriter(size_t depth = kDefaultDepth);
+
+    /**
+     * @brief Destructor; writes what was submitted, ignoring errors (call finish() to see them)
+     */
+    ~BackgroundWriter();
+
+    BackgroundWriter(const BackgroundWriter&) = delete;
+    BackgroundWriter& operator=(const BackgroundWriter&) = delete;
+
+    /**
+     * @brief Queue a write job, waiting while depth jobs are already queued
+     * @param job Job that writes one piece of output (must not be submitted after finish())
+     * @throws Any exception thrown by an earlier job
+     */
+    void submit(std::function<void()> job);
+
+    /**
+     * @brief Wait until every submitted job has run and stop the thread
+     * @throws Any exception thrown by a job
+     */
+    void finish();
+
+private:
+    void run();
+
+    size_t depth_;
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<std::function<void()>> jobs_;
+    bool closing_;
+    std::exception_ptr error_;
+    std::thread thread_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_BACKGROUND_WRITER_H_
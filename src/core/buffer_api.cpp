@@ -6,40 +6,40 @@
 #include "buffer_api.h"
 #include "normalize.h"
 #include "pmi.h"
+#include "counting_map.h"
+#include "dedup.h"
+#include "mapped_text.h"
+#include "word_extraction.h"
 #include "text_utils.h"
 #include "progress_buffer.h"
 #include "managed_buffer.h"
+#include "line_scan.h"
+#include "packed_ngram.h"
 #include <vector>
 #include <string>
+#include <string_view>
 #include <sstream>
 #include <atomic>
 #include <memory>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <stdexcept>
 
 namespace suzume {
 namespace core {
 
-// Helper function to convert buffer to lines
-std::vector<std::string> bufferToLines(const uint8_t* data, size_t length) {
-    std::vector<std::string> lines;
-    std::string currentLine;
-
-    for (size_t i = 0; i < length; ++i) {
-        char c = static_cast<char>(data[i]);
-        if (c == '\n') {
-            lines.push_back(currentLine);
-            currentLine.clear();
-        } else {
-            currentLine += c;
-        }
+// Helper function to split a buffer into lines viewing the caller's memory
+std::vector<std::string_view> bufferToLines(const uint8_t* data, size_t length) {
+    std::vector<std::string_view> lines;
+    if (length == 0) {
+        return lines;
     }
-
-    // Add the last line if it doesn't end with a newline
-    if (!currentLine.empty()) {
-        lines.push_back(currentLine);
+    std::string_view text(reinterpret_cast<const char*>(data), length);
+    lines.reserve(static_cast<size_t>(std::count(text.begin(), text.end(), '\n')) + 1);
+    for (std::string_view line : LineRange(text)) {
+        lines.push_back(line);
     }
-
     return lines;
 }
 
@@ -69,15 +69,160 @@ void linesToBuffer(const std::vector<std::string>& lines, uint8_t** outputData,
     }
 }
 
+namespace {
+
+// Hand the complete lines of carry + chunk to fn, keeping the unterminated tail in carry
+template <typename Fn>
+void forEachCompleteText(std::string& carry, std::string_view chunk, Fn&& fn) {
+    const char* newline = findNewline(chunk.data(), chunk.data() + chunk.size());
+    if (newline == nullptr) {
+        carry.append(chunk);
+        return;
+    }
+
+    // The first line of the chunk completes the tail of the previous one
+    std::string_view rest = chunk;
+    if (!carry.empty()) {
+        size_t head = static_cast<size_t>(newline - chunk.data()) + 1;
+        carry.append(chunk.substr(0, head));
+        fn(std::string_view(carry));
+        carry.clear();
+        rest = chunk.substr(head);
+    }
+
+    size_t last = rest.rfind('\n');
+    if (last != std::string_view::npos) {
+        fn(rest.substr(0, last + 1));
+        rest = rest.substr(last + 1);
+    }
+    carry.assign(rest);
+}
+
+double megabytesPerSecond(uint64_t bytes, uint64_t elapsedMs) {
+    return elapsedMs > 0 ? (bytes / 1024.0 / 1024.0) / (elapsedMs / 1000.0) : 0.0;
+}
+
+// Move PMI scores into columns
+void pmiScoresToColumns(std::vector<PmiItem>&& pmiScores, PmiColumns& columns) {
+    size_t bytes = 0;
+    for (const auto& item : pmiScores) {
+        bytes += item.ngram.size();
+    }
+    columns.ngrams.clear();
+    columns.ngrams.reserve(bytes);
+    columns.offsets.assign(1, 0);
+    columns.offsets.reserve(pmiScores.size() + 1);
+    columns.scores.clear();
+    columns.scores.reserve(pmiScores.size());
+    columns.frequencies.clear();
+    columns.frequencies.reserve(pmiScores.size());
+    for (const auto& item : pmiScores) {
+        columns.ngrams += item.ngram;
+        columns.offsets.push_back(static_cast<uint32_t>(columns.ngrams.size()));
+        columns.scores.push_back(item.score);
+        columns.frequencies.push_back(item.frequency);
+    }
+}
+
+// Format PMI columns as TSV lines in a buffer owned by the caller
+void pmiColumnsToBuffer(const PmiColumns& columns, uint8_t** outputData, size_t* outputLength) {
+    std::stringstream ss;
+    for (size_t i = 0; i < columns.size(); ++i) {
+        ss.write(columns.ngrams.data() + columns.offsets[i], columns.offsets[i + 1] - columns.offsets[i]);
+        ss << "\t" << columns.scores[i] << "\t" << columns.frequencies[i] << "\n";
+    }
+
+    // Convert to buffer using RAII
+    std::string output = ss.str();
+    *outputLength = output.size();
+
+    ManagedBuffer buffer(*outputLength);
+    if (!buffer.valid()) {
+        throw std::bad_alloc();
+    }
+
+    std::memcpy(buffer.get(), output.c_str(), *outputLength);
+    *outputData = buffer.release(); // Transfer ownership to caller
+}
+
+// Count and score a buffer, reporting phases 0 to 2
+PmiResult scorePmiBuffer(
+    const uint8_t* inputData,
+    size_t inputLength,
+    PmiColumns& columns,
+    const PmiOptions& options,
+    uint32_t* progressBuffer
+) {
+    PmiResult result;
+
+    // Initialize progress
+    if (progressBuffer) {
+        updateProgress(progressBuffer, 0, 0, 100); // Phase 0: Reading
+    }
+
+    // N-grams are counted straight from the caller's buffer
+    std::string_view text(reinterpret_cast<const char*>(inputData), inputLength);
+
+    // Update progress
+    if (progressBuffer) {
+        updateProgress(progressBuffer, 1, 0, 100); // Phase 1: Processing
+    }
+
+    // Create a copy of options for internal use
+    PmiOptions internalOptions = options;
+
+    // Replace progress callback with our own
+    if (progressBuffer) {
+        internalOptions.progressCallback = [progressBuffer](double ratio) {
+            updateProgress(progressBuffer, 1, static_cast<uint32_t>(ratio * 100), 100);
+        };
+    }
+
+    // Count n-grams, in line-aligned slices when someone watches the progress
+    PackedNgramCounter ngramCounts(internalOptions.n, estimateDistinctNgrams(inputLength, internalOptions.n));
+    if (progressBuffer) {
+        const size_t sliceSize = 4 * 1024 * 1024;
+        size_t offset = 0;
+        while (offset < text.size()) {
+            size_t end = std::min(offset + sliceSize, text.size());
+            if (end < text.size()) {
+                const char* newline = findNewline(text.data() + end, text.data() + text.size());
+                end = newline ? static_cast<size_t>(newline - text.data()) + 1 : text.size();
+            }
+            ngramCounts.addText(text.substr(offset, end - offset));
+            offset = end;
+            updateProgress(progressBuffer, 1, static_cast<uint32_t>(offset * 100 / text.size()), 100);
+        }
+    } else {
+        ngramCounts.addText(text);
+    }
+
+    // Update progress
+    if (progressBuffer) {
+        updateProgress(progressBuffer, 2, 0, 100); // Phase 2: Calculating
+    }
+
+    // Calculate PMI scores, keeping the top K highest first
+    auto pmiScores = calculatePmiScores(ngramCounts, internalOptions.minFreq, internalOptions.topK);
+
+    // Update result statistics
+    result.grams = ngramCounts.size();
+    result.distinctNgrams = pmiScores.size();
+    pmiScoresToColumns(std::move(pmiScores), columns);
+    return result;
+}
+
+} // namespace
+
 void updateProgress(uint32_t* progressBuffer, uint32_t phase, uint32_t current, uint32_t total) {
     if (!progressBuffer) {
         return;
     }
 
-    // Create thread-safe progress buffer and copy values
+    // Store atomically: the buffer may be shared with a thread watching it
     ProgressBuffer safeBuffer;
     safeBuffer.updateProgress(phase, current, total);
-    safeBuffer.copyToLegacyBuffer(progressBuffer);
+    safeBuffer.copyToSharedBuffer(progressBuffer);
 }
 
 NormalizeResult normalizeBuffer(
@@ -95,8 +240,8 @@ NormalizeResult normalizeBuffer(
         updateProgress(progressBuffer, 0, 0, 100); // Phase 0: Reading
     }
 
-    // Convert buffer to lines
-    std::vector<std::string> lines = bufferToLines(inputData, inputLength);
+    // Lines are views into the input buffer; only normalized lines are copied
+    std::vector<std::string_view> lines = bufferToLines(inputData, inputLength);
 
     // Update progress
     if (progressBuffer) {
@@ -117,16 +262,18 @@ NormalizeResult normalizeBuffer(
         };
     }
 
-    // Process lines in batches
+    // Process lines in batches against one filter, so duplicates across batches are dropped too
+    ConcurrentDedupFilter uniqueFilter(internalOptions.bloomFalsePositiveRate, lines.size(), 1);
     const size_t batchSize = 1000;
     for (size_t i = 0; i < lines.size(); i += batchSize) {
-        size_t end = std::min(i + batchSize, lines.size());
-        std::vector<std::string> batch(lines.begin() + i, lines.begin() + end);
+        size_t count = std::min(batchSize, lines.size() - i);
 
-        auto batchResult = processBatch(batch, internalOptions.form, internalOptions.bloomFalsePositiveRate);
-        normalizedLines.insert(normalizedLines.end(), batchResult.begin(), batchResult.end());
+        auto batchResult = processBatch(lines.data() + i, count, internalOptions, uniqueFilter);
+        normalizedLines.insert(normalizedLines.end(),
+                               std::make_move_iterator(batchResult.begin()),
+                               std::make_move_iterator(batchResult.end()));
 
-        processedLines += batch.size();
+        processedLines += count;
 
         // Update progress
         if (progressBuffer) {
@@ -163,84 +310,187 @@ PmiResult calculatePmiFromBuffer(
     const PmiOptions& options,
     uint32_t* progressBuffer
 ) {
-    PmiResult result;
+    PmiColumns columns;
+    PmiResult result = scorePmiBuffer(inputData, inputLength, columns, options, progressBuffer);
 
-    // Initialize progress
+    // Update progress
     if (progressBuffer) {
-        updateProgress(progressBuffer, 0, 0, 100); // Phase 0: Reading
+        updateProgress(progressBuffer, 3, 0, 100); // Phase 3: Writing
     }
 
-    // Convert buffer to a single string
-    std::string text(reinterpret_cast<const char*>(inputData), inputLength);
+    // Convert PMI scores to TSV format
+    pmiColumnsToBuffer(columns, outputData, outputLength);
 
-    // Update progress
+    // Update progress to complete
     if (progressBuffer) {
-        updateProgress(progressBuffer, 1, 0, 100); // Phase 1: Processing
+        updateProgress(progressBuffer, 4, 100, 100); // Phase 4: Complete
     }
 
-    // Create a copy of options for internal use
-    PmiOptions internalOptions = options;
+    return result;
+}
 
-    // Replace progress callback with our own
+PmiResult calculatePmiFromBuffer(
+    const uint8_t* inputData,
+    size_t inputLength,
+    PmiColumns& columns,
+    const PmiOptions& options,
+    uint32_t* progressBuffer
+) {
+    PmiResult result = scorePmiBuffer(inputData, inputLength, columns, options, progressBuffer);
+
+    // Update progress to complete
     if (progressBuffer) {
-        internalOptions.progressCallback = [progressBuffer](double ratio) {
-            updateProgress(progressBuffer, 1, static_cast<uint32_t>(ratio * 100), 100);
-        };
+        updateProgress(progressBuffer, 4, 100, 100); // Phase 4: Complete
     }
 
-    // Count n-grams
-    auto ngramCounts = countNgrams(text, internalOptions.n);
+    return result;
+}
 
-    // Update progress
+WordExtractionResult extractWordsFromBuffer(
+    const uint8_t* pmiData,
+    size_t pmiLength,
+    const uint8_t* textData,
+    size_t textLength,
+    const WordExtractionOptions& options,
+    uint32_t* progressBuffer
+) {
+    // Initialize progress
     if (progressBuffer) {
-        updateProgress(progressBuffer, 2, 0, 100); // Phase 2: Calculating
+        updateProgress(progressBuffer, 0, 0, 100); // Phase 0: Reading
     }
 
-    // Calculate PMI scores
-    auto pmiScores = calculatePmiScores(ngramCounts, internalOptions.n, internalOptions.minFreq);
-
-    // Sort by score (descending)
-    std::sort(pmiScores.begin(), pmiScores.end(), [](const PmiItem& a, const PmiItem& b) {
-        return a.score > b.score;
-    });
+    // Both inputs are read where they lie
+    std::string_view pmiText(reinterpret_cast<const char*>(pmiData), pmiLength);
+    std::string_view originalText(reinterpret_cast<const char*>(textData), textLength);
 
-    // Take top K
-    if (pmiScores.size() > internalOptions.topK) {
-        pmiScores.resize(internalOptions.topK);
+    std::function<void(double)> progressCallback;
+    if (progressBuffer) {
+        progressCallback = [progressBuffer](double ratio) {
+            updateProgress(progressBuffer, 1, static_cast<uint32_t>(ratio * 100), 100); // Phase 1: Processing
+        };
     }
+    WordExtractionResult result = extractWordsFromText(pmiText, originalText, options, progressCallback);
 
-    // Update progress
+    // Update progress to complete
     if (progressBuffer) {
-        updateProgress(progressBuffer, 3, 0, 100); // Phase 3: Writing
+        updateProgress(progressBuffer, 4, 100, 100); // Phase 4: Complete
     }
 
-    // Convert PMI scores to TSV format
-    std::stringstream ss;
-    for (const auto& item : pmiScores) {
-        ss << item.ngram << "\t" << item.score << "\t" << item.frequency << "\n";
+    return result;
+}
+
+NormalizeSession::NormalizeSession(const NormalizeOptions& options, size_t expectedLines)
+    : options_(options)
+    , uniqueFilter_(std::make_unique<ConcurrentDedupFilter>(options.bloomFalsePositiveRate, expectedLines, 1))
+    , start_(std::chrono::steady_clock::now())
+{
+}
+
+NormalizeSession::~NormalizeSession() = default;
+
+void NormalizeSession::feed(const uint8_t* data, size_t length, uint8_t** outputData, size_t* outputLength) {
+    if (finished_) {
+        throw std::logic_error("Normalize session is already finished");
     }
+    *outputData = nullptr;
+    *outputLength = 0;
+    bytes_ += length;
 
-    // Convert to buffer using RAII
-    std::string output = ss.str();
-    *outputLength = output.size();
-    
-    ManagedBuffer buffer(*outputLength);
-    if (!buffer.valid()) {
-        throw std::bad_alloc();
+    // The completed tail of the previous chunk comes first, so the output keeps the text order
+    std::vector<std::string> normalizedLines;
+    forEachCompleteText(carry_, std::string_view(reinterpret_cast<const char*>(data), length),
+                        [this, &normalizedLines](std::string_view text) { processText(text, normalizedLines); });
+    if (!normalizedLines.empty()) {
+        linesToBuffer(normalizedLines, outputData, outputLength);
     }
-    
-    std::memcpy(buffer.get(), output.c_str(), *outputLength);
-    *outputData = buffer.release(); // Transfer ownership to caller
+}
 
-    // Update result statistics
-    result.grams = ngramCounts.size();
-    result.distinctNgrams = pmiScores.size();
+NormalizeResult NormalizeSession::finish(uint8_t** outputData, size_t* outputLength) {
+    if (finished_) {
+        throw std::logic_error("Normalize session is already finished");
+    }
+    *outputData = nullptr;
+    *outputLength = 0;
+    if (!carry_.empty()) {
+        std::vector<std::string> normalizedLines;
+        processText(carry_, normalizedLines);
+        if (!normalizedLines.empty()) {
+            linesToBuffer(normalizedLines, outputData, outputLength);
+        }
+        carry_.clear();
+        carry_.shrink_to_fit();
+    }
+    finished_ = true;
 
-    // Update progress to complete
-    if (progressBuffer) {
-        updateProgress(progressBuffer, 4, 100, 100); // Phase 4: Complete
+    result_.duplicates = result_.rows - result_.uniques;
+    result_.elapsedMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    result_.mbPerSec = megabytesPerSecond(bytes_, result_.elapsedMs);
+    return result_;
+}
+
+void NormalizeSession::processText(std::string_view text, std::vector<std::string>& normalizedLines) {
+    std::vector<std::string_view> lines = bufferToLines(reinterpret_cast<const uint8_t*>(text.data()), text.size());
+    size_t before = normalizedLines.size();
+    const size_t batchSize = 1000;
+    for (size_t i = 0; i < lines.size(); i += batchSize) {
+        size_t count = std::min(batchSize, lines.size() - i);
+        auto batchResult = processBatch(lines.data() + i, count, options_, *uniqueFilter_);
+        normalizedLines.insert(normalizedLines.end(),
+                               std::make_move_iterator(batchResult.begin()),
+                               std::make_move_iterator(batchResult.end()));
     }
 
+    result_.rows += lines.size();
+    result_.uniques += normalizedLines.size() - before;
+}
+
+PmiSession::PmiSession(const PmiOptions& options, size_t expectedBytes)
+    : options_(options)
+    , counts_(std::make_unique<PackedNgramCounter>(options.n, estimateDistinctNgrams(expectedBytes, options.n)))
+    , start_(std::chrono::steady_clock::now())
+{
+}
+
+PmiSession::~PmiSession() = default;
+
+void PmiSession::feed(const uint8_t* data, size_t length) {
+    if (finished_) {
+        throw std::logic_error("PMI session is already finished");
+    }
+    bytes_ += length;
+    forEachCompleteText(carry_, std::string_view(reinterpret_cast<const char*>(data), length),
+                        [this](std::string_view text) { counts_->addText(text); });
+}
+
+PmiResult PmiSession::finish(uint8_t** outputData, size_t* outputLength) {
+    PmiColumns columns;
+    PmiResult result = finish(columns);
+    pmiColumnsToBuffer(columns, outputData, outputLength);
+    return result;
+}
+
+PmiResult PmiSession::finish(PmiColumns& columns) {
+    if (finished_) {
+        throw std::logic_error("PMI session is already finished");
+    }
+    if (!carry_.empty()) {
+        counts_->addText(carry_);
+        carry_.clear();
+        carry_.shrink_to_fit();
+    }
+    finished_ = true;
+
+    auto pmiScores = calculatePmiScores(*counts_, options_.minFreq, options_.topK);
+
+    PmiResult result;
+    result.grams = counts_->size();
+    result.distinctNgrams = pmiScores.size();
+    pmiScoresToColumns(std::move(pmiScores), columns);
+    counts_.reset();
+    result.elapsedMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start_).count());
+    result.mbPerSec = megabytesPerSecond(bytes_, result.elapsedMs);
     return result;
 }
 
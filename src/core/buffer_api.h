@@ -6,13 +6,21 @@
 #ifndef SUZUME_CORE_BUFFER_API_H_
 #define SUZUME_CORE_BUFFER_API_H_
 
+#include <chrono>
 #include <cstdint>
 #include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 #include "suzume_feedmill.h"
 
 namespace suzume {
 namespace core {
 
+class ConcurrentDedupFilter;
+class PackedNgramCounter;
+
 /**
  * @brief Normalize text data from buffer
  *
@@ -53,6 +61,187 @@ PmiResult calculatePmiFromBuffer(
     uint32_t* progressBuffer = nullptr
 );
 
+/**
+ * @brief PMI results as columns, for callers that read them without parsing
+ *
+ * The n-gram of row i is the bytes of ngrams from offsets[i] to
+ * offsets[i + 1]. Each column is one contiguous array, so bindings can hand
+ * them out as views instead of converting row by row.
+ */
+struct PmiColumns {
+    std::string ngrams;                ///< UTF-8 n-grams back to back
+    std::vector<uint32_t> offsets;     ///< Start of each n-gram in ngrams, then the end of the last (rows + 1)
+    std::vector<double> scores;        ///< PMI scores, highest first
+    std::vector<uint32_t> frequencies; ///< N-gram frequencies
+
+    /**
+     * @brief Number of rows
+     * @return size_t Row count
+     */
+    size_t size() const { return scores.size(); }
+};
+
+/**
+ * @brief Calculate PMI from buffer into columns
+ *
+ * Same as the other overload, without formatting the results as text.
+ *
+ * @param inputData Input buffer data
+ * @param inputLength Input buffer length
+ * @param columns Results, replacing any previous content
+ * @param options PMI calculation options
+ * @param progressBuffer Optional shared memory buffer for progress updates
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFromBuffer(
+    const uint8_t* inputData,
+    size_t inputLength,
+    PmiColumns& columns,
+    const PmiOptions& options,
+    uint32_t* progressBuffer = nullptr
+);
+
+/**
+ * @brief Extract unknown words from PMI results and an original text in buffers
+ *
+ * Both buffers are used in place for the whole run: the PMI results are
+ * parsed where they lie and the verifier indexes the text without a copy.
+ *
+ * @param pmiData PMI results as "ngram<TAB>pmi<TAB>frequency" lines (header optional)
+ * @param pmiLength PMI results length
+ * @param textData Original text data
+ * @param textLength Original text length
+ * @param options Word extraction options
+ * @param progressBuffer Optional shared memory buffer for progress updates
+ * @return WordExtractionResult Results of the word extraction operation
+ * @throws std::invalid_argument If the options are invalid
+ * @throws std::runtime_error If the PMI results are empty or hold no valid line
+ */
+WordExtractionResult extractWordsFromBuffer(
+    const uint8_t* pmiData,
+    size_t pmiLength,
+    const uint8_t* textData,
+    size_t textLength,
+    const WordExtractionOptions& options,
+    uint32_t* progressBuffer = nullptr
+);
+
+/**
+ * @brief Normalization of a text handed over in chunks
+ *
+ * Chunks may end anywhere, even inside a line or a UTF-8 sequence: the
+ * unterminated tail of a chunk is kept until the next one completes it,
+ * and every complete line is normalized and deduplicated where it lies.
+ * Only that tail and the dedup filter stay in memory between chunks, so a
+ * text of any size normalizes in memory bounded by its unique lines.
+ * Feeding a text in any split gives the output of normalizeBuffer().
+ */
+class NormalizeSession {
+public:
+    /**
+     * @brief Constructor
+     * @param options Normalization options
+     * @param expectedLines Size hint for the dedup filter (0 = grow as needed)
+     */
+    explicit NormalizeSession(const NormalizeOptions& options, size_t expectedLines = 0);
+
+    ~NormalizeSession();
+
+    NormalizeSession(const NormalizeSession&) = delete;
+    NormalizeSession& operator=(const NormalizeSession&) = delete;
+
+    /**
+     * @brief Process the next chunk of the text
+     *
+     * @param data Chunk data (only read during the call)
+     * @param length Chunk length
+     * @param outputData Unique lines completed by this chunk (will be allocated by the function)
+     * @param outputLength Output buffer length (0 if no line was completed)
+     * @throws std::logic_error If the session is finished
+     */
+    void feed(const uint8_t* data, size_t length, uint8_t** outputData, size_t* outputLength);
+
+    /**
+     * @brief Process the last, unterminated line and end the session
+     *
+     * @param outputData The last unique line, if any (will be allocated by the function)
+     * @param outputLength Output buffer length
+     * @return NormalizeResult Results over every chunk fed
+     * @throws std::logic_error If the session is finished
+     */
+    NormalizeResult finish(uint8_t** outputData, size_t* outputLength);
+
+private:
+    void processText(std::string_view text, std::vector<std::string>& normalizedLines);
+
+    NormalizeOptions options_;
+    std::unique_ptr<ConcurrentDedupFilter> uniqueFilter_;
+    std::string carry_;            ///< Unterminated tail of the chunks so far
+    NormalizeResult result_;
+    uint64_t bytes_ = 0;
+    bool finished_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
+/**
+ * @brief PMI calculation over a text handed over in chunks
+ *
+ * N-grams of the complete lines of each chunk are counted where they lie;
+ * only the unterminated tail is kept for the next chunk, so memory is
+ * bounded by the distinct n-grams rather than by the text. Feeding a text
+ * in any split gives the output of calculatePmiFromBuffer().
+ */
+class PmiSession {
+public:
+    /**
+     * @brief Constructor
+     * @param options PMI calculation options
+     * @param expectedBytes Size hint for the n-gram table (0 = grow as needed)
+     */
+    explicit PmiSession(const PmiOptions& options, size_t expectedBytes = 0);
+
+    ~PmiSession();
+
+    PmiSession(const PmiSession&) = delete;
+    PmiSession& operator=(const PmiSession&) = delete;
+
+    /**
+     * @brief Count the n-grams of the next chunk of the text
+     *
+     * @param data Chunk data (only read during the call)
+     * @param length Chunk length
+     * @throws std::logic_error If the session is finished
+     */
+    void feed(const uint8_t* data, size_t length);
+
+    /**
+     * @brief Count the last line, score the n-grams and end the session
+     *
+     * @param outputData "ngram<TAB>pmi<TAB>frequency" lines, highest first (will be allocated by the function)
+     * @param outputLength Output buffer length
+     * @return PmiResult Results over every chunk fed
+     * @throws std::logic_error If the session is finished
+     */
+    PmiResult finish(uint8_t** outputData, size_t* outputLength);
+
+    /**
+     * @brief Count the last line, score the n-grams into columns and end the session
+     *
+     * @param columns Results, replacing any previous content
+     * @return PmiResult Results over every chunk fed
+     * @throws std::logic_error If the session is finished
+     */
+    PmiResult finish(PmiColumns& columns);
+
+private:
+    PmiOptions options_;
+    std::unique_ptr<PackedNgramCounter> counts_;
+    std::string carry_;            ///< Unterminated tail of the chunks so far
+    uint64_t bytes_ = 0;
+    bool finished_ = false;
+    std::chrono::steady_clock::time_point start_;
+};
+
 /**
  * @brief Update progress in shared memory buffer
  *
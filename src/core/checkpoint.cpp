@@ -0,0 +1,197 @@
+/**
+ * @file checkpoint.cpp
+ * @brief Implementation of job checkpoints
+ */
+
+#include "core/checkpoint.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/// First line of every checkpoint, with the format version
+constexpr const char* kCheckpointHeader = "SZFMCKPT 1";
+
+/**
+ * @brief Get the identity of an input file: its size and modification time
+ *
+ * @param inputPath Input file
+ * @param checkpoint Receives the size and time
+ * @throws std::runtime_error If the file cannot be inspected
+ */
+void identifyInput(const std::string& inputPath, Checkpoint& checkpoint) {
+    try {
+        checkpoint.inputSize = std::filesystem::file_size(inputPath);
+        checkpoint.inputModified = static_cast<int64_t>(
+            std::filesystem::last_write_time(inputPath).time_since_epoch().count());
+    } catch (const std::filesystem::filesystem_error&) {
+        throw std::runtime_error("Failed to inspect input file: " + inputPath);
+    }
+}
+
+/**
+ * @brief Read a checkpoint file
+ *
+ * @param path Checkpoint path
+ * @return Checkpoint Checkpoint read
+ * @throws std::runtime_error If the file cannot be read or is not a checkpoint
+ */
+Checkpoint loadCheckpoint(const std::string& path) {
+    std::ifstream input(path);
+    std::string line;
+    if (!input || !std::getline(input, line) || line != kCheckpointHeader) {
+        throw std::runtime_error("Not a valid checkpoint: " + path);
+    }
+
+    // One "key value" line per field; segments repeat
+    Checkpoint checkpoint;
+    while (std::getline(input, line)) {
+        size_t space = line.find(' ');
+        std::string key = line.substr(0, space);
+        std::string value = space == std::string::npos ? std::string() : line.substr(space + 1);
+        try {
+            if (key == "operation") {
+                checkpoint.operation = value;
+            } else if (key == "settings") {
+                checkpoint.settings = value;
+            } else if (key == "input_size") {
+                checkpoint.inputSize = std::stoull(value);
+            } else if (key == "input_modified") {
+                checkpoint.inputModified = std::stoll(value);
+            } else if (key == "input_offset") {
+                checkpoint.inputOffset = std::stoull(value);
+            } else if (key == "output_offset") {
+                checkpoint.outputOffset = std::stoull(value);
+            } else if (key == "rows") {
+                checkpoint.rows = std::stoull(value);
+            } else if (key == "uniques") {
+                checkpoint.uniques = std::stoull(value);
+            } else if (key == "segment") {
+                checkpoint.segments.push_back(value);
+            } else if (key == "dedup") {
+                checkpoint.dedupPath = value;
+            }
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Not a valid checkpoint: " + path + " (bad " + key + ")");
+        }
+    }
+    return checkpoint;
+}
+
+} // namespace
+
+Checkpoint openCheckpoint(const std::string& path, const std::string& operation, const std::string& inputPath,
+                          const std::string& settings, bool resume) {
+    Checkpoint fresh;
+    fresh.operation = operation;
+    fresh.settings = settings;
+    identifyInput(inputPath, fresh);
+
+    if (!std::filesystem::exists(path)) {
+        return fresh;
+    }
+    if (!resume) {
+        // Files of a checkpoint that cannot be read are left alone
+        try {
+            removeCheckpoint(path, loadCheckpoint(path));
+        } catch (const std::runtime_error&) {
+            std::filesystem::remove(path);
+        }
+        return fresh;
+    }
+
+    Checkpoint checkpoint = loadCheckpoint(path);
+    if (checkpoint.operation != operation || checkpoint.settings != settings) {
+        throw std::runtime_error("Checkpoint " + path + " was written by a " + checkpoint.operation +
+                                 " job with other settings; remove it or run without resuming");
+    }
+    if (checkpoint.inputSize != fresh.inputSize || checkpoint.inputModified != fresh.inputModified ||
+        checkpoint.inputOffset > fresh.inputSize) {
+        throw std::runtime_error("Input file changed since checkpoint " + path + " was written: " + inputPath);
+    }
+    for (const auto& segment : checkpoint.segments) {
+        if (!std::filesystem::exists(segment)) {
+            throw std::runtime_error("Checkpoint " + path + " names a missing file: " + segment);
+        }
+    }
+    if (!checkpoint.dedupPath.empty() && !std::filesystem::exists(checkpoint.dedupPath)) {
+        throw std::runtime_error("Checkpoint " + path + " names a missing file: " + checkpoint.dedupPath);
+    }
+    return checkpoint;
+}
+
+void saveCheckpoint(const std::string& path, const Checkpoint& checkpoint) {
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream output(tempPath, std::ios::trunc);
+        if (!output) {
+            throw std::runtime_error("Failed to write checkpoint: " + tempPath);
+        }
+        output << kCheckpointHeader << '\n'
+               << "operation " << checkpoint.operation << '\n'
+               << "settings " << checkpoint.settings << '\n'
+               << "input_size " << checkpoint.inputSize << '\n'
+               << "input_modified " << checkpoint.inputModified << '\n'
+               << "input_offset " << checkpoint.inputOffset << '\n'
+               << "output_offset " << checkpoint.outputOffset << '\n'
+               << "rows " << checkpoint.rows << '\n'
+               << "uniques " << checkpoint.uniques << '\n';
+        for (const auto& segment : checkpoint.segments) {
+            output << "segment " << segment << '\n';
+        }
+        if (!checkpoint.dedupPath.empty()) {
+            output << "dedup " << checkpoint.dedupPath << '\n';
+        }
+        output.close();
+        if (!output) {
+            std::filesystem::remove(tempPath);
+            throw std::runtime_error("Failed to write checkpoint: " + tempPath);
+        }
+    }
+
+    // The files it names were synced before; the checkpoint itself follows them
+    syncFile(tempPath);
+    std::filesystem::rename(tempPath, path);
+}
+
+void removeCheckpoint(const std::string& path, const Checkpoint& checkpoint) {
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    for (const auto& segment : checkpoint.segments) {
+        std::filesystem::remove(segment, error);
+    }
+    if (!checkpoint.dedupPath.empty()) {
+        std::filesystem::remove(checkpoint.dedupPath, error);
+    }
+}
+
+void syncFile(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file to sync: " + path);
+    }
+    int result = ::fsync(fd);
+    ::close(fd);
+    if (result != 0) {
+        throw std::runtime_error("Failed to sync file: " + path);
+    }
+}
+
+size_t checkpointSegmentEnd(std::string_view text, size_t begin, uint64_t interval) {
+    uint64_t reach = std::max<uint64_t>(interval, 1);
+    if (reach >= text.size() - begin) {
+        return text.size();
+    }
+    size_t newline = text.find('\n', begin + static_cast<size_t>(reach) - 1);
+    return newline == std::string_view::npos ? text.size() : newline + 1;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,100 @@
+/**
+ * @file checkpoint.h
+ * @brief Checkpoints that let long-running jobs resume after an interruption
+ */
+
+#ifndef SUZUME_CORE_CHECKPOINT_H_
+#define SUZUME_CORE_CHECKPOINT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Progress of a job at its last consistent point
+ *
+ * A job works through its input in line-aligned segments and, after each
+ * one, makes the files the segment produced durable and then replaces the
+ * checkpoint. Everything a checkpoint names is complete on disk, so a
+ * resumed job continues after inputOffset and drops whatever the
+ * interrupted job wrote later.
+ */
+struct Checkpoint {
+    std::string operation;              ///< Operation that wrote it ("normalize", "pmi")
+    std::string settings;               ///< Options that shape the results; a resumed job must match them
+    uint64_t inputSize = 0;             ///< Size of the input file
+    int64_t inputModified = 0;          ///< Modification time of the input file
+    uint64_t inputOffset = 0;           ///< Input bytes done, at a line boundary
+    uint64_t outputOffset = 0;          ///< Output bytes complete
+    uint64_t rows = 0;                  ///< Input lines done
+    uint64_t uniques = 0;               ///< Lines written
+    std::vector<std::string> segments;  ///< Count snapshots of the segments done
+    std::string dedupPath;              ///< Dedup index of the lines done (empty = none)
+};
+
+/**
+ * @brief Start a job's checkpoint, or pick up the one an interrupted run left
+ *
+ * Without @p resume, a checkpoint left at @p path is discarded with its
+ * files and the job starts from the beginning. With it, the job continues
+ * from the checkpoint, provided it was written by the same operation with
+ * the same settings over the same input; a missing checkpoint starts from
+ * the beginning, so restart scripts may always pass it.
+ *
+ * @param path Checkpoint path
+ * @param operation Operation of the job
+ * @param inputPath Input file of the job
+ * @param settings Options that shape the results, as one line of text
+ * @param resume Continue from an existing checkpoint
+ * @return Checkpoint Checkpoint to continue from
+ * @throws std::runtime_error If the checkpoint cannot be read, does not match
+ *         the job, or names files that are gone
+ */
+Checkpoint openCheckpoint(const std::string& path, const std::string& operation, const std::string& inputPath,
+                          const std::string& settings, bool resume);
+
+/**
+ * @brief Replace the checkpoint in one step
+ *
+ * The checkpoint is written to a temporary file, synced to disk and renamed
+ * over @p path, so an interruption leaves either the old or the new one.
+ *
+ * @param path Checkpoint path
+ * @param checkpoint Checkpoint to save
+ * @throws std::runtime_error If the file cannot be written
+ */
+void saveCheckpoint(const std::string& path, const Checkpoint& checkpoint);
+
+/**
+ * @brief Remove a checkpoint and the files it names, once its job is done
+ * @param path Checkpoint path
+ * @param checkpoint Checkpoint whose files are removed
+ */
+void removeCheckpoint(const std::string& path, const Checkpoint& checkpoint);
+
+/**
+ * @brief Wait until a written file's data is on disk
+ * @param path File path
+ * @throws std::runtime_error If the file cannot be opened or synced
+ */
+void syncFile(const std::string& path);
+
+/**
+ * @brief End of the input segment processed before the next checkpoint
+ *
+ * @param text Input text
+ * @param begin Start of the segment, at a line boundary
+ * @param interval Input bytes between checkpoints
+ * @return size_t End of the line that reaches @p interval bytes, or the end of the text
+ */
+size_t checkpointSegmentEnd(std::string_view text, size_t begin, uint64_t interval);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_CHECKPOINT_H_
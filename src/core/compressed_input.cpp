@@ -0,0 +1,501 @@
+/**
+ * @file compressed_input.cpp
+ * @brief Implementation of transparent gzip/zstd input decompression
+ */
+
+#include "core/compressed_input.h"
+#include "core/async_io.h"
+#include "core/standard_streams.h"
+#include "parallel/thread_pool.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+#include <unistd.h>
+
+#ifdef SUZUME_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef SUZUME_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Compressed bytes read from the source at a time
+constexpr size_t kInputBlockSize = 1024 * 1024;
+
+// Decompressed bytes handed to the reader at a time
+constexpr size_t kOutputBlockSize = 1024 * 1024;
+
+// Decompressed blocks buffered ahead of the reader
+constexpr size_t kMaxQueuedBlocks = 8;
+
+// Frames larger than this are streamed instead of decoded whole
+constexpr size_t kMaxParallelFrameBytes = 64 * 1024 * 1024;
+
+/**
+ * @brief Input stream owning its source and decompressing stream buffer
+ */
+class DecompressingInputStream : public std::istream {
+public:
+    DecompressingInputStream(std::unique_ptr<std::istream> file, std::istream& source,
+                             Compression compression, std::string prefix, unsigned int threads)
+        : std::istream(nullptr)
+        , file_(std::move(file))
+        , buffer_(source, compression, std::move(prefix), threads)
+    {
+        rdbuf(&buffer_);
+        // Let decoding errors propagate instead of just ending the input
+        exceptions(std::ios::badbit);
+    }
+
+private:
+    std::unique_ptr<std::istream> file_;
+    DecompressingStreamBuf buffer_;
+};
+
+} // namespace
+
+Compression detectCompression(const char* data, size_t size) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    if (size >= 2 && bytes[0] == 0x1F && bytes[1] == 0x8B) {
+        return Compression::Gzip;
+    }
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xB5 && bytes[2] == 0x2F && bytes[3] == 0xFD) {
+        return Compression::Zstd;
+    }
+    return Compression::None;
+}
+
+Compression detectFileCompression(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return Compression::None;
+    }
+    char header[4];
+    file.read(header, sizeof(header));
+    return detectCompression(header, static_cast<size_t>(file.gcount()));
+}
+
+bool isCompressionSupported(Compression compression) {
+    switch (compression) {
+        case Compression::None:
+            return true;
+        case Compression::Gzip:
+#ifdef SUZUME_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case Compression::Zstd:
+#ifdef SUZUME_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* compressionName(Compression compression) {
+    switch (compression) {
+        case Compression::Gzip:
+            return "gzip";
+        case Compression::Zstd:
+            return "zstd";
+        case Compression::None:
+            break;
+    }
+    return "none";
+}
+
+DecompressingStreamBuf::DecompressingStreamBuf(
+    std::istream& source,
+    Compression compression,
+    std::string prefix,
+    unsigned int threads
+)
+    : source_(source)
+    , compression_(compression)
+    , prefix_(std::move(prefix))
+    , threads_(std::max(1u, threads))
+    , finished_(false)
+    , stopping_(false)
+{
+    if (!isCompressionSupported(compression)) {
+        throw std::runtime_error(std::string("Input is ") + compressionName(compression) +
+                                 "-compressed but this build has no " + compressionName(compression) +
+                                 " support");
+    }
+    thread_ = std::thread(&DecompressingStreamBuf::produce, this);
+}
+
+DecompressingStreamBuf::~DecompressingStreamBuf() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    space_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+DecompressingStreamBuf::int_type DecompressingStreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+
+    std::unique_lock<std::mutex> lock(mutex_);
+    ready_.wait(lock, [this]() { return !queue_.empty() || finished_; });
+    if (queue_.empty()) {
+        if (error_) {
+            std::exception_ptr error = error_;
+            error_ = nullptr;
+            std::rethrow_exception(error);
+        }
+        return traits_type::eof();
+    }
+
+    current_ = std::move(queue_.front());
+    queue_.pop_front();
+    lock.unlock();
+    space_.notify_one();
+
+    char* data = &current_[0];
+    setg(data, data, data + current_.size());
+    return traits_type::to_int_type(*gptr());
+}
+
+void DecompressingStreamBuf::produce() {
+    try {
+        switch (compression_) {
+            case Compression::None:
+                copyThrough();
+                break;
+            case Compression::Gzip:
+                inflateGzip();
+                break;
+            case Compression::Zstd:
+                decodeZstd();
+                break;
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        error_ = std::current_exception();
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+    }
+    ready_.notify_all();
+}
+
+size_t DecompressingStreamBuf::readSource(char* buffer, size_t capacity) {
+    size_t count = 0;
+    if (!prefix_.empty()) {
+        count = std::min(capacity, prefix_.size());
+        std::memcpy(buffer, prefix_.data(), count);
+        prefix_.erase(0, count);
+    }
+    if (count < capacity && source_) {
+        source_.read(buffer + count, static_cast<std::streamsize>(capacity - count));
+        count += static_cast<size_t>(source_.gcount());
+    }
+    return count;
+}
+
+bool DecompressingStreamBuf::push(std::string&& block) {
+    if (block.empty()) {
+        return true;
+    }
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        space_.wait(lock, [this]() { return queue_.size() < kMaxQueuedBlocks || stopping_; });
+        if (stopping_) {
+            return false;
+        }
+        queue_.push_back(std::move(block));
+    }
+    ready_.notify_one();
+    return true;
+}
+
+void DecompressingStreamBuf::copyThrough() {
+    while (true) {
+        std::string block(kInputBlockSize, '\0');
+        size_t count = readSource(&block[0], block.size());
+        if (count == 0) {
+            return;
+        }
+        block.resize(count);
+        if (!push(std::move(block))) {
+            return;
+        }
+    }
+}
+
+void DecompressingStreamBuf::inflateGzip() {
+#ifdef SUZUME_HAVE_ZLIB
+    z_stream stream;
+    std::memset(&stream, 0, sizeof(stream));
+    // 15 window bits + 32: accept gzip and zlib headers
+    if (inflateInit2(&stream, 15 + 32) != Z_OK) {
+        throw std::runtime_error("Failed to initialize gzip decoder");
+    }
+
+    std::vector<char> input(kInputBlockSize);
+    std::string output;
+    bool midMember = false;
+    bool outputFull = false;
+
+    try {
+        while (true) {
+            // A full output block may leave decoded bytes pending in zlib
+            if (stream.avail_in == 0 && !outputFull) {
+                size_t count = readSource(input.data(), input.size());
+                if (count == 0) {
+                    break;
+                }
+                stream.next_in = reinterpret_cast<Bytef*>(input.data());
+                stream.avail_in = static_cast<uInt>(count);
+            }
+
+            output.resize(kOutputBlockSize);
+            stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+            stream.avail_out = static_cast<uInt>(output.size());
+
+            uInt availableBefore = stream.avail_in;
+            int status = inflate(&stream, Z_NO_FLUSH);
+            if (stream.avail_in != availableBefore) {
+                midMember = true;
+            }
+
+            if (status == Z_STREAM_END) {
+                // Concatenated members (as written by pigz or cat) continue here
+                midMember = false;
+                inflateReset(&stream);
+            } else if (status != Z_OK && status != Z_BUF_ERROR) {
+                throw std::runtime_error(std::string("Corrupt gzip input: ") +
+                                         (stream.msg ? stream.msg : "inflate failed"));
+            }
+
+            outputFull = stream.avail_out == 0;
+            output.resize(output.size() - stream.avail_out);
+            if (!push(std::move(output))) {
+                break;
+            }
+        }
+
+        if (midMember) {
+            throw std::runtime_error("Truncated gzip input");
+        }
+    } catch (...) {
+        inflateEnd(&stream);
+        throw;
+    }
+    inflateEnd(&stream);
+#endif
+}
+
+void DecompressingStreamBuf::decodeZstd() {
+#ifdef SUZUME_HAVE_ZSTD
+    if (threads_ <= 1) {
+        decodeZstdStream();
+        return;
+    }
+
+    // Collect complete frames and decode up to threads_ of them at once
+    std::string window;
+    bool endOfInput = false;
+
+    while (true) {
+        std::vector<std::pair<size_t, size_t>> frames; // Offset and compressed size
+        std::vector<size_t> contentSizes;
+        size_t offset = 0;
+        bool stream = false;
+
+        while (frames.size() < threads_) {
+            size_t available = window.size() - offset;
+            size_t frameSize = available > 0
+                ? ZSTD_findFrameCompressedSize(window.data() + offset, available)
+                : 0;
+
+            if (available == 0 || ZSTD_isError(frameSize)) {
+                if (endOfInput) {
+                    break;
+                }
+                if (available > kMaxParallelFrameBytes) {
+                    stream = true;
+                    break;
+                }
+                size_t previous = window.size();
+                window.resize(previous + kInputBlockSize);
+                size_t count = readSource(&window[previous], kInputBlockSize);
+                window.resize(previous + count);
+                endOfInput = count == 0;
+                continue;
+            }
+
+            unsigned long long contentSize = ZSTD_getFrameContentSize(window.data() + offset, frameSize);
+            if (contentSize == ZSTD_CONTENTSIZE_UNKNOWN || contentSize == ZSTD_CONTENTSIZE_ERROR ||
+                contentSize > kMaxParallelFrameBytes) {
+                stream = true;
+                break;
+            }
+            frames.emplace_back(offset, frameSize);
+            contentSizes.push_back(static_cast<size_t>(contentSize));
+            offset += frameSize;
+        }
+
+        std::vector<std::string> outputs(frames.size());
+        std::vector<std::exception_ptr> errors(frames.size());
+        auto decodeFrame = [&](size_t i) {
+            try {
+                outputs[i].resize(contentSizes[i]);
+                size_t written = ZSTD_decompress(outputs[i].empty() ? nullptr : &outputs[i][0], outputs[i].size(),
+                                                 window.data() + frames[i].first, frames[i].second);
+                if (ZSTD_isError(written)) {
+                    throw std::runtime_error(std::string("Corrupt zstd input: ") + ZSTD_getErrorName(written));
+                }
+                outputs[i].resize(written);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+        };
+
+        parallel::TaskGroup group("decompress");
+        for (size_t i = 0; i < frames.size(); ++i) {
+            group.run([&decodeFrame, i]() { decodeFrame(i); });
+        }
+        group.wait();
+
+        for (size_t i = 0; i < frames.size(); ++i) {
+            if (errors[i]) {
+                std::rethrow_exception(errors[i]);
+            }
+            if (!push(std::move(outputs[i]))) {
+                return;
+            }
+        }
+        window.erase(0, offset);
+
+        if (stream) {
+            // Hand what is left to the streaming decoder
+            prefix_ = window + prefix_;
+            decodeZstdStream();
+            return;
+        }
+        if (frames.empty() && endOfInput) {
+            if (!window.empty()) {
+                throw std::runtime_error("Truncated zstd input");
+            }
+            return;
+        }
+    }
+#endif
+}
+
+void DecompressingStreamBuf::decodeZstdStream() {
+#ifdef SUZUME_HAVE_ZSTD
+    std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> context(ZSTD_createDCtx(), ZSTD_freeDCtx);
+    if (!context) {
+        throw std::runtime_error("Failed to initialize zstd decoder");
+    }
+
+    std::vector<char> input(ZSTD_DStreamInSize());
+    std::vector<char> chunk(ZSTD_DStreamOutSize());
+    std::string output;
+    size_t lastResult = 0;
+
+    while (true) {
+        size_t count = readSource(input.data(), input.size());
+        if (count == 0) {
+            break;
+        }
+
+        ZSTD_inBuffer in = {input.data(), count, 0};
+        while (in.pos < in.size) {
+            ZSTD_outBuffer out = {chunk.data(), chunk.size(), 0};
+            lastResult = ZSTD_decompressStream(context.get(), &out, &in);
+            if (ZSTD_isError(lastResult)) {
+                throw std::runtime_error(std::string("Corrupt zstd input: ") + ZSTD_getErrorName(lastResult));
+            }
+            output.append(chunk.data(), out.pos);
+            if (output.size() >= kOutputBlockSize) {
+                if (!push(std::move(output))) {
+                    return;
+                }
+                output.clear();
+            }
+        }
+    }
+
+    // Flush whatever the decoder still holds for the last frame
+    while (lastResult != 0) {
+        ZSTD_inBuffer in = {nullptr, 0, 0};
+        ZSTD_outBuffer out = {chunk.data(), chunk.size(), 0};
+        lastResult = ZSTD_decompressStream(context.get(), &out, &in);
+        if (ZSTD_isError(lastResult)) {
+            throw std::runtime_error(std::string("Corrupt zstd input: ") + ZSTD_getErrorName(lastResult));
+        }
+        if (out.pos == 0) {
+            break;
+        }
+        output.append(chunk.data(), out.pos);
+    }
+    push(std::move(output));
+
+    if (lastResult != 0) {
+        throw std::runtime_error("Truncated zstd input");
+    }
+#endif
+}
+
+std::unique_ptr<std::istream> openInputStream(const std::string& path, unsigned int threads) {
+    if (path == "-") {
+        // The process's stdin is read in large blocks with read(2); a
+        // redirected std::cin has to be read through its stream buffer
+        std::unique_ptr<std::istream> stdinStream;
+        if (isProcessStdin()) {
+            stdinStream = std::make_unique<DescriptorInputStream>(STDIN_FILENO);
+        }
+        std::istream& source = stdinStream ? *stdinStream : std::cin;
+
+        // Bytes used for detection cannot be put back, so they go to the decoder first
+        char header[4];
+        source.read(header, sizeof(header));
+        size_t count = static_cast<size_t>(source.gcount());
+        Compression compression = detectCompression(header, count);
+        return std::make_unique<DecompressingInputStream>(
+            std::move(stdinStream), source, compression, std::string(header, count), threads);
+    }
+
+    Compression compression = detectFileCompression(path);
+    if (compression == Compression::None && ioBackend() == IoBackend::IoUring &&
+        std::filesystem::is_regular_file(path)) {
+        return std::make_unique<AsyncInputStream>(path, IoBackend::IoUring);
+    }
+    auto file = std::make_unique<std::ifstream>(path, std::ios::binary);
+    if (!*file) {
+        throw std::runtime_error("Failed to open input file: " + path);
+    }
+    if (compression == Compression::None) {
+        return file;
+    }
+
+    std::istream& source = *file;
+    return std::make_unique<DecompressingInputStream>(std::move(file), source, compression, std::string(), threads);
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,147 @@
+/**
+ * @file compressed_input.h
+ * @brief Transparent gzip/zstd decompression of input files and stdin
+ */
+
+#ifndef SUZUME_CORE_COMPRESSED_INPUT_H_
+#define SUZUME_CORE_COMPRESSED_INPUT_H_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Compression format of an input
+ */
+enum class Compression {
+    None, ///< Plain text
+    Gzip, ///< gzip (RFC 1952), possibly several concatenated members
+    Zstd  ///< Zstandard, possibly several concatenated frames
+};
+
+/**
+ * @brief Detect the compression format from the first bytes of an input
+ *
+ * @param data First bytes of the input
+ * @param size Number of bytes available (4 are enough)
+ * @return Compression Detected format (None if no magic number matches)
+ */
+Compression detectCompression(const char* data, size_t size);
+
+/**
+ * @brief Detect the compression format of a file by its magic bytes
+ *
+ * @param path File path
+ * @return Compression Detected format (None if unreadable or plain)
+ */
+Compression detectFileCompression(const std::string& path);
+
+/**
+ * @brief Check whether this build can decode a format
+ *
+ * gzip needs zlib (SUZUME_HAVE_ZLIB) and zstd needs libzstd
+ * (SUZUME_HAVE_ZSTD) at build time.
+ *
+ * @param compression Compression format
+ * @return bool True if inputs in this format can be read
+ */
+bool isCompressionSupported(Compression compression);
+
+/**
+ * @brief Get the name of a compression format
+ * @param compression Compression format
+ * @return const char* "none", "gzip" or "zstd"
+ */
+const char* compressionName(Compression compression);
+
+/**
+ * @brief Stream buffer that decompresses its source on a pipeline thread
+ *
+ * A producer thread reads the source, decodes it and hands blocks of
+ * decompressed text to the reader through a small bounded queue, so
+ * decompression overlaps with whatever consumes the lines. Concatenated
+ * zstd frames with a known content size are decoded several at a time when
+ * more than one thread is allowed.
+ *
+ * Decoding errors are rethrown from underflow(), after every block decoded
+ * before the error has been consumed.
+ */
+class DecompressingStreamBuf : public std::streambuf {
+public:
+    /**
+     * @brief Constructor; starts the pipeline thread
+     * @param source Compressed source (read only by the pipeline thread)
+     * @param compression Source format (None copies the source through)
+     * @param prefix Bytes already taken from the source, decoded first
+     * @param threads Maximum number of zstd frames decoded at once
+     */
+    DecompressingStreamBuf(std::istream& source, Compression compression,
+                           std::string prefix = std::string(), unsigned int threads = 1);
+
+    /**
+     * @brief Destructor; stops and joins the pipeline thread
+     */
+    ~DecompressingStreamBuf() override;
+
+    DecompressingStreamBuf(const DecompressingStreamBuf&) = delete;
+    DecompressingStreamBuf& operator=(const DecompressingStreamBuf&) = delete;
+
+protected:
+    int_type underflow() override;
+
+private:
+    void produce();
+    void copyThrough();
+    void inflateGzip();
+    void decodeZstd();
+    void decodeZstdStream();
+    size_t readSource(char* buffer, size_t capacity);
+    bool push(std::string&& block);
+
+    std::istream& source_;
+    Compression compression_;
+    std::string prefix_;
+    unsigned int threads_;
+
+    std::mutex mutex_;
+    std::condition_variable ready_;
+    std::condition_variable space_;
+    std::deque<std::string> queue_;
+    bool finished_;
+    bool stopping_;
+    std::exception_ptr error_;
+
+    std::string current_;
+    std::thread thread_;
+};
+
+/**
+ * @brief Open an input file or stdin, decompressing it if needed
+ *
+ * The format is detected from magic bytes, not the file name. Plain files
+ * are returned as an ordinary std::ifstream, or read ahead through an
+ * AsyncInputStream when the io_uring backend is selected; compressed files
+ * and stdin are decoded on a pipeline thread. Decoding errors surface as exceptions
+ * from the returned stream.
+ *
+ * @param path File path ("-" for stdin)
+ * @param threads Maximum number of zstd frames decoded at once
+ * @return std::unique_ptr<std::istream> Stream of decompressed text
+ * @throws std::runtime_error If the file cannot be opened or its format is not supported
+ */
+std::unique_ptr<std::istream> openInputStream(const std::string& path, unsigned int threads = 1);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_COMPRESSED_INPUT_H_
@@ -0,0 +1,333 @@
+/**
+ * @file cooccurrence.cpp
+ * @brief Implementation of co-occurrence counting and scoring
+ */
+
+#include "core/cooccurrence.h"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <stdexcept>
+#include "core/ngram_window.h"
+#include "core/pmi_scoring.h"
+#include "parallel/thread_pool.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Tables smaller than this are merged and scored on the calling thread
+constexpr size_t kParallelEntries = 1 << 16;
+
+// Scoring packs two units into a packed bigram key of 21 bits each; ID 0 is unscored
+constexpr uint32_t kMaxScoredTokens = (1u << 21) - 1;
+
+bool isUnitSeparator(uint32_t c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == 0x3000;
+}
+
+uint64_t pairKey(uint32_t first, uint32_t second) {
+    return (static_cast<uint64_t>(first) << 32) | second;
+}
+
+// Run fn(index) for every index below count, claimed one at a time by up to threads workers
+template <typename Fn>
+void forEachIndex(size_t count, unsigned int threads, const char* name, Fn&& fn) {
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(threads, count));
+    std::atomic<size_t> next(0);
+    auto worker = [&]() {
+        for (size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+            fn(index);
+        }
+    };
+    if (threadCount == 1) {
+        worker();
+        return;
+    }
+    parallel::TaskGroup group(name);
+    for (size_t i = 0; i < threadCount; ++i) {
+        group.run(worker);
+    }
+    group.wait();
+}
+
+} // namespace
+
+CooccurrenceCounter::CooccurrenceCounter(
+    uint32_t window,
+    CooccurrenceUnit unit,
+    size_t partitions,
+    size_t expectedPairs
+)
+    : window_(window)
+    , unit_(unit)
+    , units_(1)
+{
+    if (window < 1 || window > kMaxWindow) {
+        throw std::invalid_argument("Invalid co-occurrence window: " + std::to_string(window) + " (must be 1-" +
+                                    std::to_string(kMaxWindow) + ")");
+    }
+    if (partitions == 0) {
+        throw std::invalid_argument("Partition count must be at least 1");
+    }
+    if (unit_ == CooccurrenceUnit::Token) {
+        // ID 0 is never a token
+        tokenHashes_.push_back(0);
+    }
+    partitions_.reserve(partitions);
+    for (size_t i = 0; i < partitions; ++i) {
+        partitions_.emplace_back(2, expectedPairs / partitions);
+    }
+}
+
+void CooccurrenceCounter::addText(std::string_view text) {
+    forEachLine(text, [this](std::string_view line) { addLine(line); });
+}
+
+uint32_t CooccurrenceCounter::tokenId(std::string_view token) {
+    auto it = vocabulary_.find(token);
+    if (it != vocabulary_.end()) {
+        return it->second;
+    }
+    uint32_t id = static_cast<uint32_t>(tokenHashes_.size());
+    vocabulary_.emplace(std::string(token), id);
+    tokenHashes_.push_back(Utf8KeyHash()(token));
+    return id;
+}
+
+size_t CooccurrenceCounter::partitionOf(uint32_t first, uint32_t second) const {
+    uint64_t hash = unitHash(first) * 0xff51afd7ed558ccdULL + unitHash(second);
+    return PartitionedNgramCounter::partitionIndex(hash, partitions_.size());
+}
+
+void CooccurrenceCounter::addLine(std::string_view line) {
+    // The last window units of the line, in a ring
+    std::array<uint32_t, kMaxWindow> recent;
+    size_t seen = 0;
+    auto addUnit = [&](uint32_t id) {
+        units_.add(id);
+        unitTotal_++;
+        size_t previous = std::min<size_t>(seen, window_);
+        for (size_t back = 1; back <= previous; ++back) {
+            uint32_t first = recent[(seen - back) % window_];
+            partitions_[partitionOf(first, id)].add(pairKey(first, id));
+        }
+        pairTotal_ += previous;
+        recent[seen % window_] = id;
+        seen++;
+    };
+
+    if (unit_ == CooccurrenceUnit::Character) {
+        forEachCodePoint(line, [&](uint32_t c) {
+            if (!isUnitSeparator(c)) {
+                addUnit(c);
+            }
+        });
+        return;
+    }
+
+    size_t start = 0;
+    while (start < line.size()) {
+        size_t end = line.find_first_of(" \t\r", start);
+        if (end == std::string_view::npos) {
+            end = line.size();
+        }
+        if (end > start) {
+            addUnit(tokenId(line.substr(start, end - start)));
+        }
+        start = end + 1;
+    }
+}
+
+CooccurrenceCounter CooccurrenceCounter::mergeAll(std::vector<CooccurrenceCounter>&& tables, unsigned int threads) {
+    if (tables.empty()) {
+        throw std::invalid_argument("No co-occurrence tables to merge");
+    }
+    const size_t partitions = tables.front().partitions_.size();
+    for (const auto& table : tables) {
+        if (table.window_ != tables.front().window_ || table.unit_ != tables.front().unit_ ||
+            table.partitions_.size() != partitions) {
+            throw std::invalid_argument("Cannot merge co-occurrence tables with different layouts");
+        }
+    }
+
+    CooccurrenceCounter result = std::move(tables.front());
+    const bool tokens = result.unit_ == CooccurrenceUnit::Token;
+
+    // Token IDs of every other table, translated to the merged vocabulary
+    std::vector<std::vector<uint32_t>> remap(tables.size());
+    for (size_t t = 1; t < tables.size(); ++t) {
+        CooccurrenceCounter& table = tables[t];
+        if (tokens) {
+            remap[t].assign(table.tokenHashes_.size(), 0);
+            for (const auto& entry : table.vocabulary_) {
+                remap[t][entry.second] = result.tokenId(entry.first);
+            }
+            table.vocabulary_ = Vocabulary();
+            table.units_.forEach([&](uint64_t id, uint32_t count) { result.units_.add(remap[t][id], count); });
+        } else {
+            result.units_.merge(table.units_);
+        }
+        table.units_ = PackedNgramCounter(1);
+        result.unitTotal_ += table.unitTotal_;
+        result.pairTotal_ += table.pairTotal_;
+    }
+
+    size_t entries = 0;
+    for (const auto& table : tables) {
+        entries += table.size();
+    }
+    forEachIndex(partitions, entries >= kParallelEntries ? threads : 1, "merge", [&](size_t index) {
+        PackedNgramCounter& merged = result.partitions_[index];
+        for (size_t t = 1; t < tables.size(); ++t) {
+            PackedNgramCounter& piece = tables[t].partitions_[index];
+            if (tokens) {
+                const std::vector<uint32_t>& ids = remap[t];
+                piece.forEach([&](uint64_t key, uint32_t count) {
+                    merged.add(pairKey(ids[key >> 32], ids[static_cast<uint32_t>(key)]), count);
+                });
+            } else {
+                merged.merge(piece);
+            }
+            // Release the merged piece right away
+            piece = PackedNgramCounter(2);
+        }
+    });
+    return result;
+}
+
+void CooccurrenceCounter::unitNames(std::unordered_map<uint32_t, std::string>& ids) const {
+    if (unit_ == CooccurrenceUnit::Character) {
+        for (auto& entry : ids) {
+            entry.second.clear();
+            appendUtf8(entry.second, entry.first);
+        }
+        return;
+    }
+    forEachToken([&ids](const std::string& token, uint32_t id) {
+        auto it = ids.find(id);
+        if (it != ids.end()) {
+            it->second = token;
+        }
+    });
+}
+
+size_t CooccurrenceCounter::size() const {
+    size_t pairs = 0;
+    for (const auto& partition : partitions_) {
+        pairs += partition.size();
+    }
+    return pairs;
+}
+
+std::unordered_map<std::string, uint32_t> countCooccurrences(
+    const std::string& text,
+    uint32_t window,
+    CooccurrenceUnit unit
+) {
+    CooccurrenceCounter counts(window, unit, 1);
+    counts.addText(text);
+
+    std::unordered_map<uint32_t, std::string> names;
+    counts.unitCounts().forEach([&names](uint64_t id, uint32_t) {
+        names.emplace(static_cast<uint32_t>(id), std::string());
+    });
+    counts.unitNames(names);
+
+    std::unordered_map<std::string, uint32_t> pairs;
+    counts.forEachPair([&](uint32_t first, uint32_t second, uint32_t count) {
+        pairs[names[first] + " " + names[second]] += count;
+    });
+    return pairs;
+}
+
+std::vector<PmiItem> calculateCooccurrenceScores(
+    const CooccurrenceCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+) {
+    if (counts.pairTotal() == 0) {
+        return {};
+    }
+    const bool tokens = counts.unit() == CooccurrenceUnit::Token;
+
+    // Scoring IDs: code points as they are, tokens ranked by frequency from 1
+    std::vector<uint32_t> scoreIds;
+    std::vector<uint32_t> rankedTokens(1, 0);
+    if (tokens) {
+        counts.unitCounts().forEach([&](uint64_t id, uint32_t) { rankedTokens.push_back(static_cast<uint32_t>(id)); });
+        std::sort(rankedTokens.begin() + 1, rankedTokens.end(), [&counts](uint32_t a, uint32_t b) {
+            uint32_t countA = counts.unitCounts().count(a);
+            uint32_t countB = counts.unitCounts().count(b);
+            return countA != countB ? countA > countB : a < b;
+        });
+        if (rankedTokens.size() > kMaxScoredTokens + 1) {
+            rankedTokens.resize(kMaxScoredTokens + 1);
+        }
+        scoreIds.assign(counts.unitCounts().size() + 1, 0);
+        for (uint32_t rank = 1; rank < rankedTokens.size(); ++rank) {
+            scoreIds[rankedTokens[rank]] = rank;
+        }
+    }
+    auto scoreId = [&](uint32_t id) { return tokens ? scoreIds[id] : id; };
+
+    // Marginals are the shares of the units among all units
+    MarginalTable marginals;
+    counts.unitCounts().forEach([&](uint64_t id, uint32_t count) {
+        uint32_t scored = scoreId(static_cast<uint32_t>(id));
+        if (!tokens || scored != 0) {
+            marginals.add(scored, count);
+        }
+    });
+    marginals.finish(counts.unitTotal());
+
+    // Pairs are scored as packed bigrams of their scoring IDs
+    auto scorePartition = [&](const PackedNgramCounter& table, ScoredKeySelector& selector) {
+        PmiBlockScorer<2> scorer(marginals, counts.pairTotal(), selector);
+        table.forEach([&](uint64_t key, uint32_t count) {
+            if (count < minFreq) {
+                return;
+            }
+            uint32_t first = scoreId(static_cast<uint32_t>(key >> 32));
+            uint32_t second = scoreId(static_cast<uint32_t>(key));
+            if (tokens && (first == 0 || second == 0)) {
+                return;
+            }
+            scorer.add((static_cast<uint64_t>(first) << 21) | second, count);
+        });
+        scorer.finish();
+    };
+
+    const size_t pieces = counts.partitionCount();
+    std::vector<ScoredKeySelector> selectors(pieces, ScoredKeySelector(topK));
+    forEachIndex(pieces, counts.size() >= kParallelEntries ? pieces : 1, "score", [&](size_t index) {
+        scorePartition(counts.partition(index), selectors[index]);
+    });
+    for (size_t i = 1; i < pieces; ++i) {
+        selectors[0].merge(std::move(selectors[i]));
+    }
+
+    // Only the kept pairs are decoded, their units named in one pass
+    std::vector<ScoredKey> best = selectors[0].take();
+    std::unordered_map<uint32_t, std::string> names;
+    auto unitId = [&](uint32_t scored) { return tokens ? rankedTokens[scored] : scored; };
+    for (const auto& item : best) {
+        for (uint32_t i = 0; i < 2; ++i) {
+            names.emplace(unitId(PackedNgramCounter::codePoint(item.key, 2, i)), std::string());
+        }
+    }
+    counts.unitNames(names);
+
+    std::vector<PmiItem> results;
+    results.reserve(best.size());
+    for (const auto& item : best) {
+        const std::string& first = names[unitId(PackedNgramCounter::codePoint(item.key, 2, 0))];
+        const std::string& second = names[unitId(PackedNgramCounter::codePoint(item.key, 2, 1))];
+        results.push_back({first + " " + second, item.score, item.frequency});
+    }
+    return results;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,218 @@
+/**
+ * @file cooccurrence.h
+ * @brief Counting and scoring of unit pairs that co-occur within a window
+ */
+
+#ifndef SUZUME_CORE_COOCCURRENCE_H_
+#define SUZUME_CORE_COOCCURRENCE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "suzume_feedmill.h"
+#include "core/counting_map.h"
+#include "core/packed_ngram.h"
+#include "core/pmi.h"
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Sparse counts of ordered unit pairs within a sliding window
+ *
+ * Every line is split into units, code points or space-separated tokens,
+ * and each unit is paired with each of the window units that follow it on
+ * the same line: with a window of 1 the pairs are the bigrams of the units.
+ * Pairs are ordered, so (a, b) and (b, a) are counted apart. The count of
+ * each unit is kept as well, for the marginals.
+ *
+ * Units have integer IDs: a code point is its own ID, and tokens get IDs
+ * from 1 in the order this table first saw them. A pair is packed into one
+ * uint64_t key, first ID in the high half, and counted in a flat table of
+ * its hash partition. The partition depends on the units themselves (the
+ * code points, or the hashes of the token bytes), never on the IDs, so
+ * tables counted on separate threads merge partition by partition in
+ * parallel, with token IDs translated to the merged vocabulary on the way.
+ *
+ * Not thread-safe: count into one table per thread and mergeAll().
+ */
+class CooccurrenceCounter {
+public:
+    /// Widest window accepted
+    static constexpr uint32_t kMaxWindow = 32;
+
+    /**
+     * @brief Constructor
+     * @param window Units after each unit it is paired with (1 to kMaxWindow)
+     * @param unit Units paired
+     * @param partitions Number of hash partitions (at least 1)
+     * @param expectedPairs Distinct pairs expected across all partitions
+     * @throws std::invalid_argument If window or partitions is out of range
+     */
+    CooccurrenceCounter(uint32_t window, CooccurrenceUnit unit, size_t partitions, size_t expectedPairs = 0);
+
+    /**
+     * @brief Count the pairs of every line in a text
+     * @param text UTF-8 text, lines separated by '\n'
+     */
+    void addText(std::string_view text);
+
+    /**
+     * @brief Merge worker tables partition by partition on several threads
+     *
+     * Token vocabularies are merged into the first table's, then each
+     * partition is summed by one thread. Merged pieces are released right
+     * away.
+     *
+     * @param tables Worker tables with the same window, unit and partition count (consumed)
+     * @param threads Maximum number of merging threads
+     * @return CooccurrenceCounter Summed counts
+     * @throws std::invalid_argument If the tables are empty or do not match
+     */
+    static CooccurrenceCounter mergeAll(std::vector<CooccurrenceCounter>&& tables, unsigned int threads);
+
+    /**
+     * @brief Call fn(first, second, count) for every counted pair
+     * @param fn Visitor taking two unit IDs and a uint32_t count
+     */
+    template <typename Fn>
+    void forEachPair(Fn&& fn) const {
+        for (const auto& partition : partitions_) {
+            partition.forEach([&fn](uint64_t key, uint32_t count) {
+                fn(static_cast<uint32_t>(key >> 32), static_cast<uint32_t>(key), count);
+            });
+        }
+    }
+
+    /**
+     * @brief Call fn(token, id) for every token seen (token mode)
+     * @param fn Visitor taking a const std::string& and a uint32_t ID
+     */
+    template <typename Fn>
+    void forEachToken(Fn&& fn) const {
+        for (const auto& entry : vocabulary_) {
+            fn(entry.first, entry.second);
+        }
+    }
+
+    /**
+     * @brief Get the UTF-8 text of every unit ID, looked up in one pass
+     * @param ids Unit IDs to name (the mapped strings are filled in)
+     */
+    void unitNames(std::unordered_map<uint32_t, std::string>& ids) const;
+
+    /**
+     * @brief Get the window
+     * @return uint32_t Units after each unit it is paired with
+     */
+    uint32_t window() const { return window_; }
+
+    /**
+     * @brief Get the units paired
+     * @return CooccurrenceUnit Unit kind
+     */
+    CooccurrenceUnit unit() const { return unit_; }
+
+    /**
+     * @brief Get the number of distinct pairs
+     * @return size_t Pair count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the number of units counted
+     * @return uint64_t Units over all lines
+     */
+    uint64_t unitTotal() const { return unitTotal_; }
+
+    /**
+     * @brief Get the number of pairs counted
+     * @return uint64_t Pair occurrences over all lines
+     */
+    uint64_t pairTotal() const { return pairTotal_; }
+
+    /**
+     * @brief Get the count of every unit
+     * @return const PackedNgramCounter& Unit counts keyed by unit ID
+     */
+    const PackedNgramCounter& unitCounts() const { return units_; }
+
+    /**
+     * @brief Get the number of hash partitions
+     * @return size_t Partition count
+     */
+    size_t partitionCount() const { return partitions_.size(); }
+
+    /**
+     * @brief Get one partition of the pair counts
+     * @param index Partition index
+     * @return const PackedNgramCounter& Pair counts keyed (first << 32) | second
+     */
+    const PackedNgramCounter& partition(size_t index) const { return partitions_[index]; }
+
+private:
+    using Vocabulary = robin_hood::unordered_flat_map<std::string, uint32_t, Utf8KeyHash, Utf8KeyEqual>;
+
+    void addLine(std::string_view line);
+    uint32_t tokenId(std::string_view token);
+    uint64_t unitHash(uint32_t id) const { return unit_ == CooccurrenceUnit::Token ? tokenHashes_[id] : id; }
+    size_t partitionOf(uint32_t first, uint32_t second) const;
+
+    uint32_t window_;
+    CooccurrenceUnit unit_;
+    Vocabulary vocabulary_;
+    std::vector<uint64_t> tokenHashes_;
+    PackedNgramCounter units_;
+    std::vector<PackedNgramCounter> partitions_;
+    uint64_t unitTotal_ = 0;
+    uint64_t pairTotal_ = 0;
+};
+
+/**
+ * @brief Count the co-occurring pairs of a text
+ *
+ * The string-keyed counterpart of countNgrams(); a pair is written as its
+ * two units joined by a space.
+ *
+ * @param text Input text
+ * @param window Units after each unit it is paired with (1-32)
+ * @param unit Units paired
+ * @return std::unordered_map<std::string, uint32_t> Pair counts
+ * @throws std::invalid_argument If window is out of range
+ */
+std::unordered_map<std::string, uint32_t> countCooccurrences(
+    const std::string& text,
+    uint32_t window,
+    CooccurrenceUnit unit
+);
+
+/**
+ * @brief Calculate PMI scores for co-occurring pairs and keep the best
+ *
+ * PMI(a, b) = log2(P(a, b) / (P(a) P(b))), with P(a, b) the share of the
+ * pair among all pairs counted and P(a) the share of the unit among all
+ * units. Scoring reuses the marginal table, block scorer and bounded top-K
+ * selectors of n-gram PMI; tokens are scored under dense IDs given by
+ * frequency, so only the 2,097,151 most frequent tokens can pair (the
+ * rest are far below any useful minimum frequency). Items are the two
+ * units joined by a space.
+ *
+ * @param counts Merged pair counts
+ * @param minFreq Minimum pair frequency
+ * @param topK Maximum number of items returned
+ * @return std::vector<PmiItem> Best PMI scores, highest first
+ */
+std::vector<PmiItem> calculateCooccurrenceScores(
+    const CooccurrenceCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_COOCCURRENCE_H_
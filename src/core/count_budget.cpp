@@ -0,0 +1,110 @@
+/**
+ * @file count_budget.cpp
+ * @brief Implementation of the counting memory budget
+ */
+
+#include "core/count_budget.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <unistd.h>
+#include "core/ngram_snapshot.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Budgets alive in this process, to keep their run names apart
+std::atomic<uint64_t> nextBudgetId{0};
+
+} // namespace
+
+CountBudget::CountBudget(
+    uint64_t budgetBytes,
+    unsigned int workers,
+    MemoryBudgetStrategy strategy,
+    const std::string& tempDir
+)
+    : share_(std::max<uint64_t>(1, budgetBytes / std::max(1u, workers)))
+    , strategy_(strategy)
+    , crossed_(false)
+    , errorBound_(0)
+{
+    if (strategy_ == MemoryBudgetStrategy::None) {
+        throw std::invalid_argument("A memory budget needs the Prune or Spill strategy");
+    }
+    std::filesystem::path directory = tempDir.empty() ? std::filesystem::path("/tmp") : std::filesystem::path(tempDir);
+    runPrefix_ = (directory / ("suzume-pmi-" + std::to_string(::getpid()) + "-" +
+                               std::to_string(nextBudgetId.fetch_add(1)) + "-run-")).string();
+}
+
+CountBudget::~CountBudget() {
+    std::error_code error;
+    for (const auto& run : runs_) {
+        std::filesystem::remove(run, error);
+    }
+}
+
+void CountBudget::addText(MultiOrderNgramCounter& counts, std::string_view text) {
+    while (!text.empty()) {
+        // Slices end on line boundaries; a longer line is counted whole
+        size_t cut = text.size();
+        if (cut > kSliceBytes) {
+            size_t newline = text.find('\n', kSliceBytes);
+            cut = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        counts.addText(text.substr(0, cut));
+        text.remove_prefix(cut);
+
+        if (counts.memoryUsage() > share_) {
+            enforce(counts);
+        }
+    }
+}
+
+void CountBudget::spill(const MultiOrderNgramCounter& counts) {
+    if (counts.minOrder() != counts.maxOrder()) {
+        throw std::invalid_argument("Only tables of a single order can be spilled");
+    }
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(runsMutex_);
+        path = runPrefix_ + std::to_string(runs_.size()) + ".snap";
+        runs_.push_back(path);
+    }
+    writeSnapshot(path, counts.order(counts.maxOrder()));
+}
+
+std::vector<std::string> CountBudget::runs() const {
+    std::lock_guard<std::mutex> lock(runsMutex_);
+    return runs_;
+}
+
+void CountBudget::enforce(MultiOrderNgramCounter& counts) {
+    crossed_ = true;
+
+    if (strategy_ == MemoryBudgetStrategy::Spill) {
+        spill(counts);
+        size_t partitions = counts.order(counts.minOrder()).partitionCount();
+        counts = MultiOrderNgramCounter(counts.minOrder(), counts.maxOrder(), partitions);
+        return;
+    }
+
+    // Each n-gram is dropped at most once here, so it loses at most the last threshold that dropped anything
+    uint32_t threshold = 1;
+    uint32_t applied = 0;
+    while (counts.size() > 0 && counts.memoryUsage() > share_ / 4 * 3) {
+        if (counts.prune(threshold) > 0) {
+            applied = threshold;
+        }
+        if (threshold > UINT32_MAX / 2) {
+            break;
+        }
+        threshold *= 2;
+    }
+    errorBound_ += applied;
+}
+
+} // namespace core
+} // namespace suzume
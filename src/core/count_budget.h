@@ -0,0 +1,117 @@
+/**
+ * @file count_budget.h
+ * @brief Memory budget for exact n-gram counting tables
+ */
+
+#ifndef SUZUME_CORE_COUNT_BUDGET_H_
+#define SUZUME_CORE_COUNT_BUDGET_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Keeps exact counting tables within a memory budget
+ *
+ * Every worker gets an equal share of the budget. Text is counted in
+ * slices of about kSliceBytes, and a table that ends a slice over its share
+ * is brought back under it with the configured strategy:
+ *
+ * - Prune drops the n-grams seen at most t times, doubling t until the
+ *   table fits in three quarters of its share. An n-gram loses at most t
+ *   counts to one prune, so no frequency is underestimated by more than the
+ *   sum of those thresholds over all prunes (errorBound()), as in lossy
+ *   counting.
+ * - Spill writes the table out as a sorted snapshot run and starts an empty
+ *   one. The runs are merged before scoring, so counts stay exact. Spilling
+ *   needs a single order. Runs are deleted with the budget.
+ *
+ * Workers may call addText() concurrently on their own tables.
+ */
+class CountBudget {
+public:
+    /// Text counted between two checks of the table size
+    static constexpr size_t kSliceBytes = 1024 * 1024;
+
+    /**
+     * @brief Constructor
+     * @param budgetBytes Bytes all counting tables together may use
+     * @param workers Number of tables counted concurrently
+     * @param strategy Prune or Spill
+     * @param tempDir Directory for spilled runs (empty = /tmp)
+     * @throws std::invalid_argument If the strategy is None
+     */
+    CountBudget(uint64_t budgetBytes, unsigned int workers, MemoryBudgetStrategy strategy, const std::string& tempDir);
+
+    /**
+     * @brief Destructor; removes the spilled runs
+     */
+    ~CountBudget();
+
+    CountBudget(const CountBudget&) = delete;
+    CountBudget& operator=(const CountBudget&) = delete;
+
+    /**
+     * @brief Count a text into a worker's table, keeping the table within its share
+     * @param counts Worker table
+     * @param text UTF-8 text, lines separated by '\n'
+     * @throws std::runtime_error If a run cannot be written
+     */
+    void addText(MultiOrderNgramCounter& counts, std::string_view text);
+
+    /**
+     * @brief Write a table out as one more sorted run
+     * @param counts Table of a single order
+     * @throws std::runtime_error If the run cannot be written
+     */
+    void spill(const MultiOrderNgramCounter& counts);
+
+    /**
+     * @brief Get the strategy applied so far
+     * @return MemoryBudgetStrategy None until a table crosses its share
+     */
+    MemoryBudgetStrategy used() const { return crossed_ ? strategy_ : MemoryBudgetStrategy::None; }
+
+    /**
+     * @brief Get the most any frequency may be underestimated by (Prune)
+     * @return uint64_t Sum of the prune thresholds applied by all workers
+     */
+    uint64_t errorBound() const { return errorBound_; }
+
+    /**
+     * @brief Get the spilled runs (Spill)
+     * @return std::vector<std::string> Snapshot paths, in the order written
+     */
+    std::vector<std::string> runs() const;
+
+    /**
+     * @brief Get the bytes each worker table may use
+     * @return uint64_t Share of the budget
+     */
+    uint64_t share() const { return share_; }
+
+private:
+    void enforce(MultiOrderNgramCounter& counts);
+
+    uint64_t share_;
+    MemoryBudgetStrategy strategy_;
+    std::string runPrefix_;
+    std::atomic<bool> crossed_;
+    std::atomic<uint64_t> errorBound_;
+    mutable std::mutex runsMutex_;
+    std::vector<std::string> runs_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_COUNT_BUDGET_H_
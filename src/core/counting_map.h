@@ -0,0 +1,203 @@
+/**
+ * @file counting_map.h
+ * @brief Flat hash map specialized for counting keys
+ */
+
+#ifndef SUZUME_CORE_COUNTING_MAP_H_
+#define SUZUME_CORE_COUNTING_MAP_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include "robin_hood.h"
+#include "xxhash.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Hash for short UTF-8 keys
+ *
+ * Most n-grams are a few bytes long (a CJK bigram is 6), so keys of up to
+ * 8 bytes are loaded into one word and mixed without a byte loop; longer keys
+ * go through XXH3. Transparent, so std::string maps accept string_view keys.
+ */
+struct Utf8KeyHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const noexcept {
+        if (key.size() <= 8) {
+            uint64_t word = 0;
+            std::memcpy(&word, key.data(), key.size());
+            // Length in the top byte keeps keys with trailing NULs apart
+            word ^= static_cast<uint64_t>(key.size()) << 56;
+            word ^= word >> 33;
+            word *= 0xff51afd7ed558ccdULL;
+            word ^= word >> 33;
+            word *= 0xc4ceb9fe1a85ec53ULL;
+            word ^= word >> 33;
+            return static_cast<size_t>(word);
+        }
+        return static_cast<size_t>(XXH3_64bits(key.data(), key.size()));
+    }
+};
+
+/**
+ * @brief Equality for string keys that also compares against string_view
+ */
+struct Utf8KeyEqual {
+    using is_transparent = void;
+
+    bool operator()(std::string_view a, std::string_view b) const noexcept {
+        return a == b;
+    }
+};
+
+/**
+ * @brief Hash and equality used by CountingMap for a key type
+ */
+template <typename Key>
+struct CountingMapTraits {
+    using Hash = robin_hood::hash<Key>;
+    using Equal = std::equal_to<Key>;
+};
+
+template <>
+struct CountingMapTraits<std::string> {
+    using Hash = Utf8KeyHash;
+    using Equal = Utf8KeyEqual;
+};
+
+/**
+ * @brief Estimate how many distinct n-grams an input holds
+ *
+ * Vocabulary grows sublinearly with corpus size (Heaps' law), so sizing a
+ * table for the byte count would waste most of it. The estimate is only a
+ * pre-sizing hint; tables still grow past it.
+ *
+ * @param inputBytes Input size in bytes
+ * @param n N-gram size
+ * @return size_t Expected number of distinct n-grams
+ */
+inline size_t estimateDistinctNgrams(size_t inputBytes, uint32_t n) {
+    // About 3 bytes per code point in CJK text
+    double codePoints = static_cast<double>(inputBytes) / 3.0;
+    double estimate = 10.0 * n * std::pow(codePoints, 0.6);
+    // Unigrams are bounded by the script, and no table is pre-sized past 16M entries
+    double cap = n == 1 ? 65536.0 : 16.0 * 1024 * 1024;
+    return static_cast<size_t>(std::min({codePoints, estimate, cap}));
+}
+
+/**
+ * @brief Counter keyed by Key, stored in a flat robin_hood table
+ *
+ * Entries live in one contiguous array instead of a node per key, so
+ * counting and merging touch far fewer cache lines than std::unordered_map.
+ *
+ * @tparam Key Key type
+ * @tparam Count Counter type
+ */
+template <typename Key, typename Count = uint32_t>
+class CountingMap {
+public:
+    using Map = robin_hood::unordered_flat_map<Key, Count, typename CountingMapTraits<Key>::Hash,
+                                               typename CountingMapTraits<Key>::Equal>;
+    using const_iterator = typename Map::const_iterator;
+
+    CountingMap() = default;
+
+    /**
+     * @brief Constructor
+     * @param expectedKeys Distinct keys to size the table for
+     */
+    explicit CountingMap(size_t expectedKeys) {
+        map_.reserve(expectedKeys);
+    }
+
+    /**
+     * @brief Add to the count of a key
+     * @param key Key (or a view of it, for string keys)
+     * @param count Occurrences to add
+     */
+    template <typename K>
+    void add(const K& key, Count count = 1) {
+        auto it = map_.find(key);
+        if (it != map_.end()) {
+            it->second += count;
+        } else {
+            map_.emplace(Key(key), count);
+        }
+    }
+
+    /**
+     * @brief Get the count of a key
+     * @param key Key (or a view of it, for string keys)
+     * @return Count Count (0 if never added)
+     */
+    template <typename K>
+    Count get(const K& key) const {
+        auto it = map_.find(key);
+        return it != map_.end() ? it->second : Count(0);
+    }
+
+    /**
+     * @brief Add every count of another map
+     * @param other Map to merge
+     */
+    void merge(const CountingMap& other) {
+        map_.reserve(map_.size() + other.map_.size());
+        for (const auto& entry : other.map_) {
+            map_[entry.first] += entry.second;
+        }
+    }
+
+    /**
+     * @brief Add every count of another map, reusing the larger table
+     * @param other Map to merge (left empty)
+     */
+    void merge(CountingMap&& other) {
+        if (other.map_.size() > map_.size()) {
+            std::swap(map_, other.map_);
+        }
+        merge(static_cast<const CountingMap&>(other));
+        other.map_.clear();
+    }
+
+    /**
+     * @brief Reserve room for a number of keys
+     * @param keys Distinct keys expected
+     */
+    void reserve(size_t keys) { map_.reserve(keys); }
+
+    /**
+     * @brief Convert to a std::unordered_map
+     * @return std::unordered_map<Key, Count> Copy of the counts
+     */
+    std::unordered_map<Key, Count> toUnorderedMap() const {
+        std::unordered_map<Key, Count> counts;
+        counts.reserve(map_.size());
+        for (const auto& entry : map_) {
+            counts.emplace(entry.first, entry.second);
+        }
+        return counts;
+    }
+
+    size_t size() const { return map_.size(); }
+    bool empty() const { return map_.empty(); }
+    const_iterator begin() const { return map_.begin(); }
+    const_iterator end() const { return map_.end(); }
+
+private:
+    Map map_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_COUNTING_MAP_H_
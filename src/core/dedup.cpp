@@ -0,0 +1,381 @@
+/**
+ * @file dedup.cpp
+ * @brief Implementation of compact duplicate detection
+ */
+
+#include "core/dedup.h"
+#include "core/text_utils.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Minimum number of elements the structures are sized for
+constexpr size_t kMinCapacity = 1024;
+
+// Finalizer from SplitMix64, used to derive bits independent of the raw hash
+inline uint64_t mixHash(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Dedup index file layout
+constexpr char kIndexMagic[8] = {'S', 'Z', 'F', 'M', 'D', 'I', 'D', 'X'};
+constexpr uint32_t kIndexVersion = 1;
+constexpr size_t kIndexHeaderSize = 24;
+constexpr size_t kIndexChunkEntries = 65536;
+
+inline void storeLittleEndian(unsigned char* out, uint64_t value, size_t bytes) {
+    for (size_t i = 0; i < bytes; ++i) {
+        out[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+}
+
+inline uint64_t loadLittleEndian(const unsigned char* in, size_t bytes) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < bytes; ++i) {
+        value |= static_cast<uint64_t>(in[i]) << (8 * i);
+    }
+    return value;
+}
+
+inline size_t nextPowerOfTwo(size_t value) {
+    size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+// BlockedBloomFilter implementation
+
+BlockedBloomFilter::BlockedBloomFilter(size_t expectedElements, double falsePositiveRate)
+    : blockCount_(0)
+    , capacity_(std::max(expectedElements, kMinCapacity))
+    , hashCount_(1)
+{
+    if (falsePositiveRate <= 0.0 || falsePositiveRate >= 1.0) {
+        throw std::invalid_argument("Invalid bloomFalsePositiveRate: " +
+                                   std::to_string(falsePositiveRate) +
+                                   " (must be between 0.0 and 1.0)");
+    }
+
+    // Optimal sizing: m/n = -ln(p) / ln(2)^2 and k = (m/n) * ln(2)
+    const double ln2 = std::log(2.0);
+    double bitsPerElement = -std::log(falsePositiveRate) / (ln2 * ln2);
+    hashCount_ = static_cast<uint32_t>(std::clamp(std::lround(bitsPerElement * ln2), 1L, 16L));
+
+    double totalBits = bitsPerElement * static_cast<double>(capacity_);
+    size_t blocks = static_cast<size_t>(std::ceil(totalBits / (kWordsPerBlock * 64)));
+    blockCount_ = nextPowerOfTwo(std::max<size_t>(blocks, 1));
+    blocks_.assign(blockCount_ * kWordsPerBlock, 0);
+    charge_.set(memoryUsage());
+}
+
+bool BlockedBloomFilter::mayContain(uint64_t hash) const {
+    const uint64_t* block = &blocks_[(mixHash(hash) & (blockCount_ - 1)) * kWordsPerBlock];
+    uint32_t a = static_cast<uint32_t>(hash);
+    uint32_t b = static_cast<uint32_t>(hash >> 32) | 1;
+    for (uint32_t i = 0; i < hashCount_; ++i) {
+        uint32_t bit = (a + i * b) & 511;
+        if ((block[bit >> 6] & (uint64_t{1} << (bit & 63))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void BlockedBloomFilter::insert(uint64_t hash) {
+    uint64_t* block = &blocks_[(mixHash(hash) & (blockCount_ - 1)) * kWordsPerBlock];
+    uint32_t a = static_cast<uint32_t>(hash);
+    uint32_t b = static_cast<uint32_t>(hash >> 32) | 1;
+    for (uint32_t i = 0; i < hashCount_; ++i) {
+        uint32_t bit = (a + i * b) & 511;
+        block[bit >> 6] |= uint64_t{1} << (bit & 63);
+    }
+}
+
+void BlockedBloomFilter::clear() {
+    std::fill(blocks_.begin(), blocks_.end(), 0);
+}
+
+// FingerprintSet implementation
+
+FingerprintSet::FingerprintSet(size_t expectedElements)
+    : mask_(0)
+    , size_(0)
+{
+    reserve(std::max(expectedElements, kMinCapacity));
+}
+
+bool FingerprintSet::insert(uint64_t fingerprint) {
+    uint64_t key = (fingerprint == kEmpty) ? kZeroKey : fingerprint;
+
+    // Keep the load factor at or below 0.75
+    if ((size_ + 1) * 4 > slots_.size() * 3) {
+        rehash(slots_.size() * 2);
+    }
+
+    size_t index = static_cast<size_t>(key) & mask_;
+    while (true) {
+        uint64_t slot = slots_[index];
+        if (slot == kEmpty) {
+            slots_[index] = key;
+            size_++;
+            return true;
+        }
+        if (slot == key) {
+            return false;
+        }
+        index = (index + 1) & mask_;
+    }
+}
+
+bool FingerprintSet::contains(uint64_t fingerprint) const {
+    uint64_t key = (fingerprint == kEmpty) ? kZeroKey : fingerprint;
+    size_t index = static_cast<size_t>(key) & mask_;
+    while (true) {
+        uint64_t slot = slots_[index];
+        if (slot == kEmpty) {
+            return false;
+        }
+        if (slot == key) {
+            return true;
+        }
+        index = (index + 1) & mask_;
+    }
+}
+
+void FingerprintSet::reserve(size_t elements) {
+    size_t required = nextPowerOfTwo((elements * 4 + 2) / 3 + 1);
+    if (required > slots_.size()) {
+        rehash(required);
+    }
+}
+
+void FingerprintSet::rehash(size_t newSlotCount) {
+    std::vector<uint64_t> oldSlots;
+    oldSlots.swap(slots_);
+
+    slots_.assign(newSlotCount, kEmpty);
+    mask_ = newSlotCount - 1;
+    // Both arrays are held until the keys are moved over
+    charge_.set((slots_.size() + oldSlots.size()) * sizeof(uint64_t));
+
+    for (uint64_t key : oldSlots) {
+        if (key == kEmpty) {
+            continue;
+        }
+        size_t index = static_cast<size_t>(key) & mask_;
+        while (slots_[index] != kEmpty) {
+            index = (index + 1) & mask_;
+        }
+        slots_[index] = key;
+    }
+    charge_.set(memoryUsage());
+}
+
+// DedupFilter implementation
+
+DedupFilter::DedupFilter(double falsePositiveRate, size_t expectedElements)
+    : falsePositiveRate_(falsePositiveRate)
+    , bloom_(expectedElements, falsePositiveRate)
+    , fingerprints_(expectedElements)
+    , probes_(0)
+{
+}
+
+bool DedupFilter::insert(const std::string& str) {
+    return insertFingerprint(calculateHash(str));
+}
+
+bool DedupFilter::insertFingerprint(uint64_t fingerprint) {
+    if (bloom_.mayContain(fingerprint)) {
+        // Possible duplicate: confirm against the exact fingerprint table
+        probes_++;
+        if (!fingerprints_.insert(fingerprint)) {
+            return false;
+        }
+    } else {
+        // Definitely new
+        fingerprints_.insert(fingerprint);
+    }
+
+    bloom_.insert(fingerprint);
+    if (fingerprints_.size() > bloom_.capacity()) {
+        growBloom();
+    }
+    return true;
+}
+
+bool DedupFilter::containsFingerprint(uint64_t fingerprint) const {
+    return bloom_.mayContain(fingerprint) && fingerprints_.contains(fingerprint);
+}
+
+void DedupFilter::growBloom() {
+    BlockedBloomFilter grown(bloom_.capacity() * 2, falsePositiveRate_);
+    fingerprints_.forEach([&grown](uint64_t fingerprint) {
+        grown.insert(fingerprint);
+    });
+    bloom_ = std::move(grown);
+}
+
+// ConcurrentDedupFilter implementation
+
+ConcurrentDedupFilter::ConcurrentDedupFilter(
+    double falsePositiveRate,
+    size_t expectedElements,
+    size_t shardCount
+) : shardShift_(64)
+{
+    size_t shards = nextPowerOfTwo(shardCount == 0 ? 64 : shardCount);
+    uint32_t shardBits = 0;
+    while ((size_t{1} << shardBits) < shards) {
+        shardBits++;
+    }
+    shardShift_ = 64 - shardBits;
+
+    size_t perShard = expectedElements / shards;
+    shards_.reserve(shards);
+    for (size_t i = 0; i < shards; ++i) {
+        shards_.push_back(std::make_unique<Shard>(falsePositiveRate, perShard));
+    }
+}
+
+bool ConcurrentDedupFilter::insert(std::string_view str) {
+    return insertFingerprint(calculateHash(str));
+}
+
+bool ConcurrentDedupFilter::insertFingerprint(uint64_t fingerprint) {
+    // A single shard keeps every fingerprint (shift of 64 is undefined)
+    Shard& shard = shards_.size() == 1 ? *shards_[0] : shardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.filter.insertFingerprint(fingerprint);
+}
+
+bool ConcurrentDedupFilter::containsFingerprint(uint64_t fingerprint) const {
+    Shard& shard = shards_.size() == 1 ? *shards_[0] : shardFor(fingerprint);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return shard.filter.containsFingerprint(fingerprint);
+}
+
+size_t ConcurrentDedupFilter::size() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->filter.size();
+    }
+    return total;
+}
+
+size_t ConcurrentDedupFilter::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        total += shard->filter.memoryUsage();
+    }
+    return total;
+}
+
+// Dedup index persistence
+
+size_t loadDedupIndex(const std::string& path, ConcurrentDedupFilter& filter) {
+    if (!std::filesystem::exists(path)) {
+        return 0;
+    }
+
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open dedup index: " + path);
+    }
+
+    unsigned char header[kIndexHeaderSize];
+    if (!input.read(reinterpret_cast<char*>(header), kIndexHeaderSize) ||
+        std::memcmp(header, kIndexMagic, sizeof(kIndexMagic)) != 0) {
+        throw std::runtime_error("Invalid dedup index: " + path);
+    }
+
+    uint32_t version = static_cast<uint32_t>(loadLittleEndian(header + 8, 4));
+    if (version != kIndexVersion) {
+        throw std::runtime_error("Unsupported dedup index version " +
+                                std::to_string(version) + ": " + path);
+    }
+
+    uint64_t count = loadLittleEndian(header + 16, 8);
+    std::vector<unsigned char> chunk(kIndexChunkEntries * sizeof(uint64_t));
+    uint64_t remaining = count;
+    while (remaining > 0) {
+        size_t entries = static_cast<size_t>(std::min<uint64_t>(remaining, kIndexChunkEntries));
+        if (!input.read(reinterpret_cast<char*>(chunk.data()), entries * sizeof(uint64_t))) {
+            throw std::runtime_error("Truncated dedup index: " + path);
+        }
+        for (size_t i = 0; i < entries; ++i) {
+            filter.insertFingerprint(loadLittleEndian(&chunk[i * sizeof(uint64_t)], 8));
+        }
+        remaining -= entries;
+    }
+
+    return static_cast<size_t>(count);
+}
+
+void saveDedupIndex(const std::string& path, const ConcurrentDedupFilter& filter) {
+    std::filesystem::path indexPath(path);
+    if (indexPath.has_parent_path()) {
+        std::filesystem::create_directories(indexPath.parent_path());
+    }
+
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream output(tempPath, std::ios::binary | std::ios::trunc);
+        if (!output) {
+            throw std::runtime_error("Failed to write dedup index: " + tempPath);
+        }
+
+        unsigned char header[kIndexHeaderSize] = {};
+        std::memcpy(header, kIndexMagic, sizeof(kIndexMagic));
+        storeLittleEndian(header + 8, kIndexVersion, 4);
+        storeLittleEndian(header + 16, filter.size(), 8);
+        output.write(reinterpret_cast<const char*>(header), kIndexHeaderSize);
+
+        std::vector<unsigned char> chunk;
+        chunk.reserve(kIndexChunkEntries * sizeof(uint64_t));
+        auto flush = [&output, &chunk]() {
+            output.write(reinterpret_cast<const char*>(chunk.data()), chunk.size());
+            chunk.clear();
+        };
+        filter.forEach([&chunk, &flush](uint64_t fingerprint) {
+            unsigned char bytes[sizeof(uint64_t)];
+            storeLittleEndian(bytes, fingerprint, sizeof(uint64_t));
+            chunk.insert(chunk.end(), bytes, bytes + sizeof(uint64_t));
+            if (chunk.size() == chunk.capacity()) {
+                flush();
+            }
+        });
+        flush();
+
+        output.close();
+        if (!output) {
+            std::filesystem::remove(tempPath);
+            throw std::runtime_error("Failed to write dedup index: " + tempPath);
+        }
+    }
+
+    // Replace the previous index in one step
+    std::filesystem::rename(tempPath, indexPath);
+}
+
+} // namespace core
+} // namespace suzume
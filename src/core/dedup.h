@@ -0,0 +1,344 @@
+/**
+ * @file dedup.h
+ * @brief Compact duplicate detection with a blocked Bloom filter and 64-bit fingerprints
+ */
+
+#ifndef SUZUME_CORE_DEDUP_H_
+#define SUZUME_CORE_DEDUP_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/memory_accounting.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Cache-line blocked Bloom filter over 64-bit hashes
+ *
+ * Every key sets all of its bits inside a single 512-bit block, so a lookup
+ * touches one cache line regardless of the number of hash functions.
+ */
+class BlockedBloomFilter {
+public:
+    /**
+     * @brief Constructor
+     * @param expectedElements Number of elements the filter is sized for
+     * @param falsePositiveRate Target false positive rate (0.0-1.0, exclusive)
+     */
+    BlockedBloomFilter(size_t expectedElements, double falsePositiveRate);
+
+    /**
+     * @brief Check whether a hash may have been inserted
+     * @param hash 64-bit hash
+     * @return bool False if the hash was definitely never inserted
+     */
+    bool mayContain(uint64_t hash) const;
+
+    /**
+     * @brief Insert a hash
+     * @param hash 64-bit hash
+     */
+    void insert(uint64_t hash);
+
+    /**
+     * @brief Remove all elements, keeping the allocation
+     */
+    void clear();
+
+    /**
+     * @brief Get number of elements the filter was sized for
+     * @return size_t Capacity
+     */
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief Get number of hash functions
+     * @return uint32_t Bits set per element
+     */
+    uint32_t hashCount() const { return hashCount_; }
+
+    /**
+     * @brief Get memory usage
+     * @return size_t Bytes used by the bit array
+     */
+    size_t memoryUsage() const { return blocks_.size() * sizeof(uint64_t); }
+
+private:
+    static constexpr size_t kWordsPerBlock = 8; // 512 bits = one cache line
+
+    std::vector<uint64_t> blocks_;
+    size_t blockCount_;
+    size_t capacity_;
+    uint32_t hashCount_;
+    MemoryCharge charge_{MemorySubsystem::Dedup};
+};
+
+/**
+ * @brief Open-addressing set of 64-bit fingerprints
+ *
+ * Stores each element in 8 bytes with linear probing and a load factor of at
+ * most 0.75.
+ */
+class FingerprintSet {
+public:
+    /**
+     * @brief Constructor
+     * @param expectedElements Initial size hint
+     */
+    explicit FingerprintSet(size_t expectedElements = 0);
+
+    /**
+     * @brief Insert a fingerprint
+     * @param fingerprint 64-bit fingerprint
+     * @return bool True if the fingerprint was not present before
+     */
+    bool insert(uint64_t fingerprint);
+
+    /**
+     * @brief Check whether a fingerprint is present
+     * @param fingerprint 64-bit fingerprint
+     * @return bool True if present
+     */
+    bool contains(uint64_t fingerprint) const;
+
+    /**
+     * @brief Reserve space for a number of elements
+     * @param elements Number of elements
+     */
+    void reserve(size_t elements);
+
+    /**
+     * @brief Get number of stored fingerprints
+     * @return size_t Element count
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Get memory usage
+     * @return size_t Bytes used by the slot array
+     */
+    size_t memoryUsage() const { return slots_.size() * sizeof(uint64_t); }
+
+    /**
+     * @brief Call a function for every stored fingerprint
+     * @param fn Function receiving each fingerprint
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (uint64_t slot : slots_) {
+            if (slot != kEmpty) {
+                fn(slot == kZeroKey ? 0 : slot);
+            }
+        }
+    }
+
+private:
+    static constexpr uint64_t kEmpty = 0;
+    static constexpr uint64_t kZeroKey = ~uint64_t{0}; // Stand-in for fingerprint 0
+
+    void rehash(size_t newSlotCount);
+
+    std::vector<uint64_t> slots_;
+    size_t mask_;
+    size_t size_;
+    MemoryCharge charge_{MemorySubsystem::Dedup};
+};
+
+/**
+ * @brief Exact-by-fingerprint duplicate filter
+ *
+ * A blocked Bloom filter answers most "never seen" lookups from one cache
+ * line, and only keys it flags are confirmed against the fingerprint table.
+ * Lines are identified by their XXH64 hash, so a unique line is dropped only
+ * on a 64-bit hash collision. The Bloom filter is rebuilt at twice the size
+ * whenever the number of elements outgrows it, keeping its false positive
+ * rate close to the configured value.
+ */
+class DedupFilter {
+public:
+    /**
+     * @brief Constructor
+     * @param falsePositiveRate Bloom filter false positive rate
+     * @param expectedElements Initial size hint (0 = small default)
+     */
+    explicit DedupFilter(double falsePositiveRate = 0.000001, size_t expectedElements = 0);
+
+    /**
+     * @brief Insert a string
+     * @param str Input string
+     * @return bool True if the string was not seen before
+     */
+    bool insert(const std::string& str);
+
+    /**
+     * @brief Insert a precomputed fingerprint
+     * @param fingerprint XXH64 fingerprint
+     * @return bool True if the fingerprint was not seen before
+     */
+    bool insertFingerprint(uint64_t fingerprint);
+
+    /**
+     * @brief Check whether a fingerprint was inserted
+     * @param fingerprint XXH64 fingerprint
+     * @return bool True if present
+     */
+    bool containsFingerprint(uint64_t fingerprint) const;
+
+    /**
+     * @brief Get number of unique elements
+     * @return size_t Element count
+     */
+    size_t size() const { return fingerprints_.size(); }
+
+    /**
+     * @brief Get memory usage of the Bloom filter and fingerprint table
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const { return bloom_.memoryUsage() + fingerprints_.memoryUsage(); }
+
+    /**
+     * @brief Get number of lookups the Bloom filter could not reject
+     * @return uint64_t Lookups that had to probe the fingerprint table
+     */
+    uint64_t probeCount() const { return probes_; }
+
+    /**
+     * @brief Access the fingerprint table
+     * @return const FingerprintSet& Fingerprints
+     */
+    const FingerprintSet& fingerprints() const { return fingerprints_; }
+
+private:
+    void growBloom();
+
+    double falsePositiveRate_;
+    BlockedBloomFilter bloom_;
+    FingerprintSet fingerprints_;
+    uint64_t probes_;
+};
+
+/**
+ * @brief Hash-sharded DedupFilter safe for concurrent inserts
+ *
+ * Fingerprints are routed to shards by their top bits and each shard is
+ * guarded by its own mutex, so workers inserting different lines rarely
+ * contend. All workers can share one instance and drop cross-batch
+ * duplicates as they go.
+ */
+class ConcurrentDedupFilter {
+public:
+    /**
+     * @brief Constructor
+     * @param falsePositiveRate Bloom filter false positive rate
+     * @param expectedElements Total size hint across all shards (0 = small default)
+     * @param shardCount Number of shards, rounded up to a power of two (0 = 64)
+     */
+    explicit ConcurrentDedupFilter(
+        double falsePositiveRate = 0.000001,
+        size_t expectedElements = 0,
+        size_t shardCount = 0
+    );
+
+    /**
+     * @brief Insert a string
+     * @param str Input string
+     * @return bool True if the string was not seen before
+     */
+    bool insert(std::string_view str);
+
+    /**
+     * @brief Insert a precomputed fingerprint
+     * @param fingerprint XXH64 fingerprint
+     * @return bool True if the fingerprint was not seen before
+     */
+    bool insertFingerprint(uint64_t fingerprint);
+
+    /**
+     * @brief Check whether a fingerprint was inserted
+     * @param fingerprint XXH64 fingerprint
+     * @return bool True if present
+     */
+    bool containsFingerprint(uint64_t fingerprint) const;
+
+    /**
+     * @brief Get number of unique elements across all shards
+     * @return size_t Element count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get memory usage across all shards
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Get number of shards
+     * @return size_t Shard count
+     */
+    size_t shardCount() const { return shards_.size(); }
+
+    /**
+     * @brief Call a function for every stored fingerprint (not thread-safe with inserts)
+     * @param fn Function receiving each fingerprint
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& shard : shards_) {
+            shard->filter.fingerprints().forEach(fn);
+        }
+    }
+
+private:
+    struct alignas(64) Shard {
+        Shard(double falsePositiveRate, size_t expectedElements)
+            : filter(falsePositiveRate, expectedElements) {}
+
+        mutable std::mutex mutex;
+        DedupFilter filter;
+    };
+
+    Shard& shardFor(uint64_t fingerprint) const {
+        return *shards_[static_cast<size_t>(fingerprint >> shardShift_)];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    uint32_t shardShift_;
+};
+
+/**
+ * @brief Load a persisted dedup index into a filter
+ *
+ * The index is a little-endian binary file: an 8-byte magic "SZFMDIDX", a
+ * 32-bit version, 32 reserved bits, a 64-bit fingerprint count and then the
+ * XXH64 fingerprints themselves, 8 bytes each.
+ *
+ * @param path Index file path
+ * @param filter Filter receiving the fingerprints
+ * @return size_t Number of fingerprints loaded (0 if the file does not exist yet)
+ * @throws std::runtime_error If the file cannot be read or is not a valid index
+ */
+size_t loadDedupIndex(const std::string& path, ConcurrentDedupFilter& filter);
+
+/**
+ * @brief Persist every fingerprint of a filter as a dedup index
+ *
+ * The index is written to a temporary file next to @p path and renamed over
+ * it, so an interrupted run never leaves a truncated index behind.
+ *
+ * @param path Index file path
+ * @param filter Filter whose fingerprints are written
+ * @throws std::runtime_error If the file cannot be written
+ */
+void saveDedupIndex(const std::string& path, const ConcurrentDedupFilter& filter);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_DEDUP_H_
@@ -0,0 +1,236 @@
+/**
+ * @file external_dedup.cpp
+ * @brief Implementation of spill-to-disk deduplication
+ */
+
+#include "core/external_dedup.h"
+#include "core/dedup.h"
+#include "core/text_utils.h"
+#include <algorithm>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Approximate dedup memory per unique line (fingerprint slot plus Bloom bits)
+constexpr uint64_t kBytesPerLine = 24;
+
+// Average line length assumed when sizing partitions from the input size
+constexpr uint64_t kAssumedLineBytes = 32;
+
+// Top-level partition count limits (each partition holds one open file)
+constexpr uint32_t kMinPartitionBits = 4;
+constexpr uint32_t kMaxPartitionBits = 8;
+
+// Oversized partitions are split into 2^kSplitBits children, at most kMaxSplitDepth times
+constexpr uint32_t kSplitBits = 4;
+constexpr uint32_t kMaxSplitDepth = 3;
+
+// Write buffer size limits per partition
+constexpr size_t kMinFlushThreshold = 4 * 1024;
+constexpr size_t kMaxFlushThreshold = 1024 * 1024;
+
+void writeSpill(std::ofstream& file, const std::string& data, const std::string& path) {
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+    if (!file) {
+        throw std::runtime_error("Failed to write spill file: " + path);
+    }
+}
+
+} // namespace
+
+ExternalDedup::ExternalDedup(
+    const std::string& tempDir,
+    size_t memoryBudget,
+    uint64_t expectedBytes,
+    double falsePositiveRate
+) : memoryBudget_(std::max<size_t>(memoryBudget, 64 * 1024))
+  , falsePositiveRate_(falsePositiveRate)
+  , partitionBits_(6)
+  , flushThreshold_(kMinFlushThreshold)
+  , spilledBytes_(0)
+{
+    // Size partitions so that half the budget holds one partition's dedup state
+    if (expectedBytes > 0) {
+        uint64_t estimatedBytes = expectedBytes / kAssumedLineBytes * kBytesPerLine;
+        uint64_t wanted = estimatedBytes / (memoryBudget_ / 2) + 1;
+        partitionBits_ = kMinPartitionBits;
+        while (partitionBits_ < kMaxPartitionBits && (uint64_t{1} << partitionBits_) < wanted) {
+            partitionBits_++;
+        }
+    }
+
+    size_t partitionCount = size_t{1} << partitionBits_;
+    flushThreshold_ = std::clamp(memoryBudget_ / (4 * partitionCount), kMinFlushThreshold, kMaxFlushThreshold);
+
+    // Private spill directory so concurrent runs never share files
+    std::filesystem::path base = tempDir.empty() ? std::filesystem::temp_directory_path()
+                                                 : std::filesystem::path(tempDir);
+    std::error_code ec;
+    if (!std::filesystem::is_directory(base, ec)) {
+        throw std::runtime_error("Temporary directory does not exist: " + base.string());
+    }
+
+    std::random_device random;
+    bool created = false;
+    for (int attempt = 0; attempt < 16 && !created; ++attempt) {
+        std::filesystem::path candidate = base / ("suzume-dedup-" + std::to_string(random()));
+        created = std::filesystem::create_directory(candidate, ec);
+        if (created) {
+            spillDir_ = candidate.string();
+        }
+    }
+    if (!created) {
+        throw std::runtime_error("Failed to create spill directory in: " + base.string());
+    }
+
+    partitions_.reserve(partitionCount);
+    for (size_t i = 0; i < partitionCount; ++i) {
+        auto partition = std::make_unique<Partition>();
+        partition->path = (std::filesystem::path(spillDir_) / ("part-" + std::to_string(i))).string();
+        partitions_.push_back(std::move(partition));
+    }
+}
+
+ExternalDedup::~ExternalDedup() {
+    partitions_.clear();
+    std::error_code ec;
+    std::filesystem::remove_all(spillDir_, ec);
+}
+
+void ExternalDedup::add(const std::vector<std::string>& lines) {
+    uint32_t shift = 64 - partitionBits_;
+    for (const auto& line : lines) {
+        Partition& partition = *partitions_[static_cast<size_t>(calculateHash(line) >> shift)];
+        std::lock_guard<std::mutex> lock(partition.mutex);
+        partition.buffer += line;
+        partition.buffer += '\n';
+        partition.lines++;
+        if (partition.buffer.size() >= flushThreshold_) {
+            flushPartition(partition);
+        }
+    }
+}
+
+void ExternalDedup::flushPartition(Partition& partition) {
+    if (partition.buffer.empty()) {
+        return;
+    }
+    if (!partition.file.is_open()) {
+        partition.file.open(partition.path, std::ios::binary | std::ios::trunc);
+        if (!partition.file) {
+            throw std::runtime_error("Failed to create spill file: " + partition.path);
+        }
+    }
+    writeSpill(partition.file, partition.buffer, partition.path);
+    spilledBytes_ += partition.buffer.size();
+    partition.buffer.clear();
+}
+
+size_t ExternalDedup::finish(std::ostream* output) {
+    size_t uniques = 0;
+    for (auto& partition : partitions_) {
+        {
+            std::lock_guard<std::mutex> lock(partition->mutex);
+            flushPartition(*partition);
+            std::string().swap(partition->buffer);
+            if (partition->file.is_open()) {
+                partition->file.close();
+            }
+        }
+        if (partition->lines > 0) {
+            uniques += dedupPartition(partition->path, partition->lines, 0, output);
+        }
+    }
+    return uniques;
+}
+
+size_t ExternalDedup::dedupPartition(
+    const std::string& path,
+    uint64_t lines,
+    uint32_t depth,
+    std::ostream* output
+) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open spill file: " + path);
+    }
+
+    // Too many lines for the budget: split by further fingerprint bits first
+    if (lines * kBytesPerLine > memoryBudget_ && depth < kMaxSplitDepth) {
+        const size_t childCount = size_t{1} << kSplitBits;
+        uint32_t shift = 64 - partitionBits_ - kSplitBits * (depth + 1);
+
+        std::vector<std::string> childPaths(childCount);
+        std::vector<std::ofstream> children(childCount);
+        std::vector<std::string> buffers(childCount);
+        std::vector<uint64_t> childLines(childCount, 0);
+        for (size_t i = 0; i < childCount; ++i) {
+            childPaths[i] = path + "." + std::to_string(i);
+            children[i].open(childPaths[i], std::ios::binary | std::ios::trunc);
+            if (!children[i]) {
+                throw std::runtime_error("Failed to create spill file: " + childPaths[i]);
+            }
+        }
+
+        std::string line;
+        while (std::getline(input, line)) {
+            size_t child = static_cast<size_t>(calculateHash(line) >> shift) & (childCount - 1);
+            buffers[child] += line;
+            buffers[child] += '\n';
+            childLines[child]++;
+            if (buffers[child].size() >= flushThreshold_) {
+                writeSpill(children[child], buffers[child], childPaths[child]);
+                spilledBytes_ += buffers[child].size();
+                buffers[child].clear();
+            }
+        }
+        input.close();
+        std::filesystem::remove(path);
+
+        for (size_t i = 0; i < childCount; ++i) {
+            writeSpill(children[i], buffers[i], childPaths[i]);
+            spilledBytes_ += buffers[i].size();
+            std::string().swap(buffers[i]);
+            children[i].close();
+        }
+
+        size_t uniques = 0;
+        for (size_t i = 0; i < childCount; ++i) {
+            if (childLines[i] > 0) {
+                uniques += dedupPartition(childPaths[i], childLines[i], depth + 1, output);
+            } else {
+                std::filesystem::remove(childPaths[i]);
+            }
+        }
+        return uniques;
+    }
+
+    // Partition fits: deduplicate it in memory, keeping first occurrences
+    DedupFilter filter(falsePositiveRate_, static_cast<size_t>(lines));
+    size_t uniques = 0;
+    std::string line;
+    while (std::getline(input, line)) {
+        if (filter.insert(line)) {
+            uniques++;
+            if (output) {
+                *output << line << '\n';
+            }
+        }
+    }
+    input.close();
+    std::filesystem::remove(path);
+
+    if (output && !*output) {
+        throw std::runtime_error("Failed to write deduplicated output");
+    }
+    return uniques;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,119 @@
+/**
+ * @file external_dedup.h
+ * @brief Spill-to-disk deduplication for inputs with more unique lines than fit in memory
+ */
+
+#ifndef SUZUME_CORE_EXTERNAL_DEDUP_H_
+#define SUZUME_CORE_EXTERNAL_DEDUP_H_
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief External-memory duplicate filter
+ *
+ * Lines are partitioned by their XXH64 fingerprint into spill files under a
+ * private temporary directory. Identical lines always land in the same
+ * partition, so once all input has been added each partition can be
+ * deduplicated on its own with an in-memory DedupFilter. Partitions whose
+ * line count would exceed the memory budget are split again by further
+ * fingerprint bits before being deduplicated, so memory stays bounded no
+ * matter how many unique lines the input holds.
+ *
+ * Unique lines are written partition by partition, each in the order it was
+ * spilled.
+ */
+class ExternalDedup {
+public:
+    /**
+     * @brief Constructor
+     * @param tempDir Directory that receives the spill directory
+     * @param memoryBudget Memory available for write buffers and per-partition dedup in bytes
+     * @param expectedBytes Expected input size in bytes, used to pick the partition count (0 = unknown)
+     * @param falsePositiveRate Bloom filter false positive rate for per-partition dedup
+     * @throws std::runtime_error If the spill directory cannot be created
+     */
+    ExternalDedup(
+        const std::string& tempDir,
+        size_t memoryBudget,
+        uint64_t expectedBytes,
+        double falsePositiveRate
+    );
+
+    /**
+     * @brief Destructor; removes all spill files
+     */
+    ~ExternalDedup();
+
+    ExternalDedup(const ExternalDedup&) = delete;
+    ExternalDedup& operator=(const ExternalDedup&) = delete;
+
+    /**
+     * @brief Spill normalized lines (safe to call from several threads)
+     * @param lines Normalized lines
+     */
+    void add(const std::vector<std::string>& lines);
+
+    /**
+     * @brief Deduplicate every partition and write the unique lines
+     *
+     * Must be called once, after all add() calls have returned.
+     *
+     * @param output Output stream (nullptr = count only)
+     * @return size_t Number of unique lines
+     */
+    size_t finish(std::ostream* output);
+
+    /**
+     * @brief Get number of top-level partitions
+     * @return size_t Partition count
+     */
+    size_t partitionCount() const { return partitions_.size(); }
+
+    /**
+     * @brief Get total number of bytes written to spill files
+     * @return uint64_t Spilled bytes, including re-partitioning passes
+     */
+    uint64_t spilledBytes() const { return spilledBytes_; }
+
+    /**
+     * @brief Get the spill directory
+     * @return const std::string& Directory path
+     */
+    const std::string& spillDirectory() const { return spillDir_; }
+
+private:
+    struct Partition {
+        std::mutex mutex;
+        std::string path;
+        std::string buffer;
+        std::ofstream file;
+        uint64_t lines = 0;
+    };
+
+    void flushPartition(Partition& partition);
+    size_t dedupPartition(const std::string& path, uint64_t lines, uint32_t depth, std::ostream* output);
+
+    std::string spillDir_;
+    size_t memoryBudget_;
+    double falsePositiveRate_;
+    uint32_t partitionBits_;
+    size_t flushThreshold_;
+    std::vector<std::unique_ptr<Partition>> partitions_;
+    std::atomic<uint64_t> spilledBytes_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_EXTERNAL_DEDUP_H_
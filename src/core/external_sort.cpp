@@ -0,0 +1,272 @@
+/**
+ * @file external_sort.cpp
+ * @brief Implementation of spill-to-disk sort-unique
+ */
+
+#include "core/external_sort.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Run files merged at once; more are merged in groups first
+constexpr size_t kMaxMergeFanIn = 64;
+
+// Read buffer per run file during a merge
+constexpr size_t kRunReadBuffer = 256 * 1024;
+
+/**
+ * @brief Position in one sorted run, in memory or in a run file
+ */
+class RunCursor {
+public:
+    explicit RunCursor(const std::vector<std::string>* run) : run_(run) {}
+
+    explicit RunCursor(const std::string& path)
+        : path_(path)
+        , buffer_(kRunReadBuffer)
+        , file_(std::make_unique<std::ifstream>())
+    {
+        file_->rdbuf()->pubsetbuf(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+        file_->open(path, std::ios::binary);
+        if (!*file_) {
+            throw std::runtime_error("Failed to open run file: " + path);
+        }
+    }
+
+    // Move to the next line; false at the end of the run
+    bool next() {
+        if (run_) {
+            if (index_ >= run_->size()) {
+                return false;
+            }
+            index_++;
+            return true;
+        }
+        if (!std::getline(*file_, line_)) {
+            if (file_->bad()) {
+                throw std::runtime_error("Failed to read run file: " + path_);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    const std::string& current() const { return run_ ? (*run_)[index_ - 1] : line_; }
+
+private:
+    const std::vector<std::string>* run_ = nullptr;
+    size_t index_ = 0;
+    std::string path_;
+    std::vector<char> buffer_;
+    std::unique_ptr<std::ifstream> file_;
+    std::string line_;
+};
+
+/**
+ * @brief Merge sorted runs, handing each distinct line on once, in order
+ *
+ * @param cursors Runs to merge
+ * @param emit Called with each distinct line
+ * @return size_t Distinct lines emitted
+ */
+template <typename Emit>
+size_t mergeRuns(std::vector<RunCursor>& cursors, Emit&& emit) {
+    auto after = [&cursors](size_t a, size_t b) { return cursors[b].current() < cursors[a].current(); };
+    std::priority_queue<size_t, std::vector<size_t>, decltype(after)> heap(after);
+    for (size_t i = 0; i < cursors.size(); ++i) {
+        if (cursors[i].next()) {
+            heap.push(i);
+        }
+    }
+
+    // Runs are unique on their own, so a repeat can only follow from another run
+    size_t distinct = 0;
+    std::string last;
+    while (!heap.empty()) {
+        size_t top = heap.top();
+        heap.pop();
+        const std::string& line = cursors[top].current();
+        if (distinct == 0 || line != last) {
+            emit(line);
+            last = line;
+            distinct++;
+        }
+        if (cursors[top].next()) {
+            heap.push(top);
+        }
+    }
+    return distinct;
+}
+
+void writeLine(std::ostream& output, const std::string& line) {
+    output.write(line.data(), static_cast<std::streamsize>(line.size()));
+    output.put('\n');
+}
+
+} // namespace
+
+ExternalSort::ExternalSort(const std::string& tempDir, size_t memoryBudget)
+    : memoryBudget_(std::max<size_t>(memoryBudget, 64 * 1024))
+{
+    // Private spill directory so concurrent runs never share files
+    std::filesystem::path base = tempDir.empty() ? std::filesystem::temp_directory_path()
+                                                 : std::filesystem::path(tempDir);
+    std::error_code ec;
+    if (!std::filesystem::is_directory(base, ec)) {
+        throw std::runtime_error("Temporary directory does not exist: " + base.string());
+    }
+
+    std::random_device random;
+    bool created = false;
+    for (int attempt = 0; attempt < 16 && !created; ++attempt) {
+        std::filesystem::path candidate = base / ("suzume-sort-" + std::to_string(random()));
+        created = std::filesystem::create_directory(candidate, ec);
+        if (created) {
+            spillDir_ = candidate.string();
+        }
+    }
+    if (!created) {
+        throw std::runtime_error("Failed to create spill directory in: " + base.string());
+    }
+}
+
+ExternalSort::~ExternalSort() {
+    std::error_code ec;
+    std::filesystem::remove_all(spillDir_, ec);
+}
+
+void ExternalSort::add(std::vector<std::string>&& lines) {
+    if (lines.empty()) {
+        return;
+    }
+    std::sort(lines.begin(), lines.end());
+    lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+    size_t bytes = 0;
+    for (const auto& line : lines) {
+        bytes += line.size() + sizeof(std::string);
+    }
+
+    // The thread whose run crosses the budget spills all runs; the others keep adding
+    std::vector<Run> full;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        runs_.push_back(std::move(lines));
+        runBytes_ += bytes;
+        if (runBytes_ > memoryBudget_ / 2) {
+            full.swap(runs_);
+            runBytes_ = 0;
+        }
+    }
+    if (!full.empty()) {
+        spill(std::move(full));
+    }
+}
+
+std::string ExternalSort::nextRunPath() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (std::filesystem::path(spillDir_) / ("run-" + std::to_string(spilledRuns_++))).string();
+}
+
+void ExternalSort::spill(std::vector<Run>&& runs) {
+    std::vector<RunCursor> cursors;
+    cursors.reserve(runs.size());
+    for (const auto& run : runs) {
+        cursors.emplace_back(&run);
+    }
+
+    std::string path = nextRunPath();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to create run file: " + path);
+    }
+    uint64_t bytes = 0;
+    mergeRuns(cursors, [&](const std::string& line) {
+        writeLine(file, line);
+        bytes += line.size() + 1;
+    });
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write run file: " + path);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    runFiles_.push_back(path);
+    spilledBytes_ += bytes;
+}
+
+std::string ExternalSort::mergeFiles(const std::vector<std::string>& paths) {
+    std::vector<RunCursor> cursors;
+    cursors.reserve(paths.size());
+    for (const auto& path : paths) {
+        cursors.emplace_back(path);
+    }
+
+    std::string merged = nextRunPath();
+    std::ofstream file(merged, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        throw std::runtime_error("Failed to create run file: " + merged);
+    }
+    mergeRuns(cursors, [&](const std::string& line) {
+        writeLine(file, line);
+        spilledBytes_ += line.size() + 1;
+    });
+    file.close();
+    if (!file) {
+        throw std::runtime_error("Failed to write run file: " + merged);
+    }
+
+    cursors.clear();
+    for (const auto& path : paths) {
+        std::filesystem::remove(path);
+    }
+    return merged;
+}
+
+size_t ExternalSort::finish(std::ostream* output) {
+    // Keep the final merge within kMaxMergeFanIn open files
+    while (runFiles_.size() > kMaxMergeFanIn) {
+        std::vector<std::string> group(runFiles_.begin(), runFiles_.begin() + kMaxMergeFanIn);
+        runFiles_.erase(runFiles_.begin(), runFiles_.begin() + kMaxMergeFanIn);
+        runFiles_.push_back(mergeFiles(group));
+    }
+
+    std::vector<RunCursor> cursors;
+    cursors.reserve(runFiles_.size() + runs_.size());
+    for (const auto& path : runFiles_) {
+        cursors.emplace_back(path);
+    }
+    for (const auto& run : runs_) {
+        cursors.emplace_back(&run);
+    }
+
+    size_t uniques = mergeRuns(cursors, [output](const std::string& line) {
+        if (output) {
+            writeLine(*output, line);
+        }
+    });
+    if (output && !*output) {
+        throw std::runtime_error("Failed to write sorted output");
+    }
+
+    cursors.clear();
+    std::vector<Run>().swap(runs_);
+    for (const auto& path : runFiles_) {
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+    }
+    runFiles_.clear();
+    return uniques;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,107 @@
+/**
+ * @file external_sort.h
+ * @brief Spill-to-disk sort-unique of normalized lines
+ */
+
+#ifndef SUZUME_CORE_EXTERNAL_SORT_H_
+#define SUZUME_CORE_EXTERNAL_SORT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief External-memory sort with duplicate removal
+ *
+ * Every batch handed to add() is sorted and deduplicated on the calling
+ * thread, so workers sort their own batches in parallel, and is kept as an
+ * in-memory run. Once the runs held exceed half the memory budget they are
+ * merged into one run file under a private temporary directory. finish()
+ * k-way merges the run files and the runs still in memory, dropping a line
+ * equal to the one written before it, so the output is sorted and unique
+ * after a single pass over the spilled data. More run files than can be
+ * merged at once are first merged in groups.
+ *
+ * Lines are ordered by their bytes, as `LC_ALL=C sort -u` orders them.
+ */
+class ExternalSort {
+public:
+    /**
+     * @brief Constructor
+     * @param tempDir Directory that receives the spill directory
+     * @param memoryBudget Memory for in-memory runs in bytes
+     * @throws std::runtime_error If the spill directory cannot be created
+     */
+    ExternalSort(const std::string& tempDir, size_t memoryBudget);
+
+    /**
+     * @brief Destructor; removes all run files
+     */
+    ~ExternalSort();
+
+    ExternalSort(const ExternalSort&) = delete;
+    ExternalSort& operator=(const ExternalSort&) = delete;
+
+    /**
+     * @brief Sort a batch of normalized lines into a run (safe to call from several threads)
+     * @param lines Normalized lines; taken over
+     * @throws std::runtime_error If a run file cannot be written
+     */
+    void add(std::vector<std::string>&& lines);
+
+    /**
+     * @brief Merge every run and write the sorted unique lines
+     *
+     * Must be called once, after all add() calls have returned.
+     *
+     * @param output Output stream (nullptr = count only)
+     * @return size_t Number of unique lines
+     * @throws std::runtime_error If a run file cannot be read or the output fails
+     */
+    size_t finish(std::ostream* output);
+
+    /**
+     * @brief Get the number of run files written
+     * @return size_t Run files, including those of intermediate merges
+     */
+    size_t spilledRuns() const { return spilledRuns_; }
+
+    /**
+     * @brief Get total number of bytes written to run files
+     * @return uint64_t Spilled bytes, including intermediate merges
+     */
+    uint64_t spilledBytes() const { return spilledBytes_; }
+
+    /**
+     * @brief Get the spill directory
+     * @return const std::string& Directory path
+     */
+    const std::string& spillDirectory() const { return spillDir_; }
+
+private:
+    using Run = std::vector<std::string>;
+
+    std::string nextRunPath();
+    void spill(std::vector<Run>&& runs);
+    std::string mergeFiles(const std::vector<std::string>& paths);
+
+    std::string spillDir_;
+    size_t memoryBudget_;
+    std::mutex mutex_;
+    std::vector<Run> runs_;
+    size_t runBytes_ = 0;
+    std::vector<std::string> runFiles_;
+    size_t spilledRuns_ = 0;
+    uint64_t spilledBytes_ = 0;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_EXTERNAL_SORT_H_
@@ -0,0 +1,81 @@
+/**
+ * @file gpu_counter.cpp
+ * @brief Implementation of exact n-gram counting on a CUDA device
+ */
+
+#include "core/gpu_counter.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#ifdef SUZUME_HAVE_CUDA
+#include "core/gpu_kernels.h"
+#endif
+
+namespace suzume {
+namespace core {
+
+#ifdef SUZUME_HAVE_CUDA
+
+namespace {
+
+// Blocks are at least this large, so small free memory does not mean many tiny uploads
+constexpr size_t kMinBlockBytes = size_t{1} << 20;
+
+// Larger blocks no longer shorten the run, and keep device sorts within 32-bit sizes
+constexpr size_t kMaxBlockBytes = size_t{256} << 20;
+
+} // namespace
+
+bool gpuCountingAvailable() {
+    return gpu::deviceCount() > 0;
+}
+
+void countNgramsOnGpu(std::string_view text, MultiOrderNgramCounter& counts) {
+    if (gpu::deviceCount() == 0) {
+        throw std::runtime_error("GPU counting is not available: no CUDA device was found");
+    }
+    const size_t blockBytes = std::clamp(gpu::freeDeviceBytes() / gpu::kDeviceBytesPerTextByte, kMinBlockBytes,
+                                         kMaxBlockBytes);
+
+    std::vector<gpu::OrderCounts> orders;
+    size_t start = 0;
+    while (start < text.size()) {
+        // End each block after its last newline, so no n-gram straddles two
+        size_t end = text.size();
+        if (end - start > blockBytes) {
+            size_t newline = text.rfind('\n', start + blockBytes - 1);
+            if (newline == std::string_view::npos || newline < start) {
+                newline = text.find('\n', start + blockBytes);
+            }
+            end = newline == std::string_view::npos ? text.size() : newline + 1;
+        }
+        std::string_view block = text.substr(start, end - start);
+        start = end;
+
+        if (block.size() > blockBytes || !gpu::countBlock(block, counts.minOrder(), counts.maxOrder(), orders)) {
+            counts.addText(block);
+            continue;
+        }
+        for (uint32_t n = counts.minOrder(); n <= counts.maxOrder(); ++n) {
+            const gpu::OrderCounts& order = orders[n - counts.minOrder()];
+            for (size_t i = 0; i < order.keys.size(); ++i) {
+                counts.add(n, order.keys[i], order.counts[i]);
+            }
+        }
+    }
+}
+
+#else
+
+bool gpuCountingAvailable() {
+    return false;
+}
+
+void countNgramsOnGpu(std::string_view, MultiOrderNgramCounter&) {
+    throw std::runtime_error("GPU counting is not available: this build was configured without ENABLE_CUDA");
+}
+
+#endif
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,44 @@
+/**
+ * @file gpu_counter.h
+ * @brief Exact n-gram counting on a CUDA device
+ */
+
+#ifndef SUZUME_CORE_GPU_COUNTER_H_
+#define SUZUME_CORE_GPU_COUNTER_H_
+
+#include <string_view>
+#include "core/packed_ngram.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Check whether n-grams can be counted on a GPU
+ * @return bool True if the build has the CUDA backend and a device is present
+ */
+bool gpuCountingAvailable();
+
+/**
+ * @brief Count the n-grams of every order of a counter in a text on the GPU
+ *
+ * The text is uploaded in line-aligned blocks sized to the free device
+ * memory. On the device each byte is decoded by its own thread, the code
+ * points are compacted, every window of each order is packed into the key
+ * PackedNgramCounter uses, and the keys are sorted and reduced; only the
+ * distinct keys and their counts come back and are added to counts.
+ *
+ * Decoding every byte on its own needs well-formed UTF-8, whereas the CPU
+ * decodes ill-formed sequences to U+FFFD one maximal subpart at a time. A
+ * block holding an ill-formed sequence, or a line too long for one block,
+ * is counted on the CPU instead, so the counts always equal addText().
+ *
+ * @param text UTF-8 text, lines separated by '\n'
+ * @param counts Counter the n-grams are added to
+ * @throws std::runtime_error If the build has no CUDA backend, there is no device or the device fails
+ */
+void countNgramsOnGpu(std::string_view text, MultiOrderNgramCounter& counts);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_GPU_COUNTER_H_
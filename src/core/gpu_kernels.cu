@@ -0,0 +1,208 @@
+/**
+ * @file gpu_kernels.cu
+ * @brief Device side of GPU n-gram counting
+ */
+
+#include "core/gpu_kernels.h"
+#include <cuda_runtime.h>
+#include <thrust/copy.h>
+#include <thrust/device_vector.h>
+#include <thrust/functional.h>
+#include <thrust/iterator/constant_iterator.h>
+#include <thrust/reduce.h>
+#include <thrust/remove.h>
+#include <thrust/sort.h>
+#include <stdexcept>
+#include <string>
+
+namespace suzume {
+namespace core {
+namespace gpu {
+
+namespace {
+
+// Code point standing for a newline; windows holding it are not counted
+constexpr uint32_t kLineBreak = 0xFFFFFFFFu;
+
+// Key of a window that is not counted; packed n-grams use at most 63 bits
+constexpr uint64_t kNoKey = ~uint64_t{0};
+
+// Bits per code point in a packed key, as in PackedNgramCounter
+constexpr uint32_t kBitsPerCodePoint = 21;
+
+constexpr unsigned int kThreadsPerBlock = 256;
+
+void check(cudaError_t status, const char* what) {
+    if (status != cudaSuccess) {
+        throw std::runtime_error(std::string("CUDA ") + what + " failed: " + cudaGetErrorString(status));
+    }
+}
+
+unsigned int gridSize(size_t items) {
+    return static_cast<unsigned int>((items + kThreadsPerBlock - 1) / kThreadsPerBlock);
+}
+
+__device__ bool isTrail(unsigned char byte) {
+    return (byte & 0xC0) == 0x80;
+}
+
+/**
+ * Decode the code point starting at pos as nextCodePoint() does, for
+ * well-formed UTF-8 only: false if the sequence is ill-formed, or is
+ * followed by a trail byte no sequence takes.
+ */
+__device__ bool decodeAt(const unsigned char* text, size_t size, size_t pos, uint32_t& codePoint) {
+    unsigned char lead = text[pos];
+    size_t length = 1;
+    unsigned char low = 0x80;
+    unsigned char high = 0xBF;
+    if (lead < 0x80) {
+        codePoint = lead == '\n' ? kLineBreak : lead;
+    } else if (lead >= 0xC2 && lead <= 0xDF) {
+        length = 2;
+        codePoint = lead & 0x1F;
+    } else if (lead >= 0xE0 && lead <= 0xEF) {
+        // Second byte excludes overlongs (E0) and surrogates (ED)
+        length = 3;
+        codePoint = lead & 0x0F;
+        low = lead == 0xE0 ? 0xA0 : 0x80;
+        high = lead == 0xED ? 0x9F : 0xBF;
+    } else if (lead >= 0xF0 && lead <= 0xF4) {
+        // Second byte excludes overlongs (F0) and code points past U+10FFFF (F4)
+        length = 4;
+        codePoint = lead & 0x07;
+        low = lead == 0xF0 ? 0x90 : 0x80;
+        high = lead == 0xF4 ? 0x8F : 0xBF;
+    } else {
+        return false;
+    }
+    if (pos + length > size) {
+        return false;
+    }
+    for (size_t i = 1; i < length; ++i) {
+        unsigned char byte = text[pos + i];
+        if (i == 1 ? (byte < low || byte > high) : !isTrail(byte)) {
+            return false;
+        }
+        codePoint = (codePoint << 6) | (byte & 0x3F);
+    }
+    return pos + length == size || !isTrail(text[pos + length]);
+}
+
+// One thread per byte: flag code point starts and decode them in place
+__global__ void decodeKernel(const unsigned char* text, size_t size, uint32_t* codePoints, unsigned char* starts,
+                             int* illFormed) {
+    size_t pos = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (pos >= size) {
+        return;
+    }
+    bool start = !isTrail(text[pos]);
+    starts[pos] = start;
+    if (!start) {
+        if (pos == 0) {
+            *illFormed = 1;
+        }
+        return;
+    }
+    uint32_t codePoint = 0;
+    if (!decodeAt(text, size, pos, codePoint)) {
+        *illFormed = 1;
+    }
+    codePoints[pos] = codePoint;
+}
+
+// One thread per code point: pack the window of n code points it starts
+__global__ void packKernel(const uint32_t* codePoints, size_t count, uint32_t n, uint64_t* keys) {
+    size_t index = static_cast<size_t>(blockIdx.x) * blockDim.x + threadIdx.x;
+    if (index >= count) {
+        return;
+    }
+    if (index + n > count) {
+        keys[index] = kNoKey;
+        return;
+    }
+    uint64_t key = 0;
+    for (uint32_t i = 0; i < n; ++i) {
+        uint32_t codePoint = codePoints[index + i];
+        if (codePoint == kLineBreak) {
+            keys[index] = kNoKey;
+            return;
+        }
+        key = (key << kBitsPerCodePoint) | codePoint;
+    }
+    keys[index] = key;
+}
+
+} // namespace
+
+int deviceCount() {
+    int count = 0;
+    if (cudaGetDeviceCount(&count) != cudaSuccess) {
+        // No driver or no device; clear the error so later calls start clean
+        cudaGetLastError();
+        return 0;
+    }
+    return count;
+}
+
+size_t freeDeviceBytes() {
+    size_t freeBytes = 0;
+    size_t totalBytes = 0;
+    check(cudaMemGetInfo(&freeBytes, &totalBytes), "memory query");
+    return freeBytes;
+}
+
+bool countBlock(std::string_view block, uint32_t minN, uint32_t maxN, std::vector<OrderCounts>& orders) {
+    orders.assign(maxN - minN + 1, OrderCounts());
+    const size_t size = block.size();
+    if (size == 0) {
+        return true;
+    }
+
+    // Decode every byte, then keep the code points of the bytes that start one
+    thrust::device_vector<uint32_t> codePoints;
+    {
+        thrust::device_vector<unsigned char> text(block.begin(), block.end());
+        thrust::device_vector<uint32_t> decoded(size);
+        thrust::device_vector<unsigned char> starts(size);
+        thrust::device_vector<int> illFormed(1, 0);
+        decodeKernel<<<gridSize(size), kThreadsPerBlock>>>(
+            thrust::raw_pointer_cast(text.data()), size, thrust::raw_pointer_cast(decoded.data()),
+            thrust::raw_pointer_cast(starts.data()), thrust::raw_pointer_cast(illFormed.data()));
+        check(cudaGetLastError(), "decoding");
+        if (illFormed[0] != 0) {
+            return false;
+        }
+        codePoints.resize(size);
+        auto end = thrust::copy_if(decoded.begin(), decoded.end(), starts.begin(), codePoints.begin(),
+                                   thrust::identity<unsigned char>());
+        codePoints.resize(end - codePoints.begin());
+    }
+
+    // Sort the packed windows of each order and count runs of equal keys
+    const size_t count = codePoints.size();
+    thrust::device_vector<uint64_t> keys(count);
+    thrust::device_vector<uint64_t> distinct(count);
+    thrust::device_vector<uint32_t> tallies(count);
+    for (uint32_t n = minN; n <= maxN; ++n) {
+        packKernel<<<gridSize(count), kThreadsPerBlock>>>(
+            thrust::raw_pointer_cast(codePoints.data()), count, n, thrust::raw_pointer_cast(keys.data()));
+        check(cudaGetLastError(), "packing");
+        auto last = thrust::remove(keys.begin(), keys.end(), kNoKey);
+        thrust::sort(keys.begin(), last);
+        auto reduced = thrust::reduce_by_key(keys.begin(), last, thrust::constant_iterator<uint32_t>(1),
+                                             distinct.begin(), tallies.begin());
+
+        OrderCounts& order = orders[n - minN];
+        size_t found = reduced.first - distinct.begin();
+        order.keys.resize(found);
+        order.counts.resize(found);
+        thrust::copy(distinct.begin(), reduced.first, order.keys.begin());
+        thrust::copy(tallies.begin(), reduced.second, order.counts.begin());
+    }
+    return true;
+}
+
+} // namespace gpu
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,58 @@
+/**
+ * @file gpu_kernels.h
+ * @brief Device side of GPU n-gram counting (built only with ENABLE_CUDA)
+ */
+
+#ifndef SUZUME_CORE_GPU_KERNELS_H_
+#define SUZUME_CORE_GPU_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+namespace gpu {
+
+/// Device bytes needed per text byte: text, start flags, code points, keys and sort buffers
+constexpr size_t kDeviceBytesPerTextByte = 48;
+
+/**
+ * @brief Distinct packed n-grams of one order and their counts
+ */
+struct OrderCounts {
+    std::vector<uint64_t> keys;     ///< Packed n-grams, ascending
+    std::vector<uint32_t> counts;   ///< Count of each key
+};
+
+/**
+ * @brief Get the number of usable CUDA devices
+ * @return int Device count (0 without a driver or device)
+ */
+int deviceCount();
+
+/**
+ * @brief Get the free memory of the current device
+ * @return size_t Free bytes
+ * @throws std::runtime_error If the device cannot be queried
+ */
+size_t freeDeviceBytes();
+
+/**
+ * @brief Count the n-grams of orders minN..maxN of one block on the device
+ *
+ * @param block Line-aligned UTF-8 text
+ * @param minN Smallest n-gram size (1-3)
+ * @param maxN Largest n-gram size (minN-3)
+ * @param orders Counts of each order, from minN (resized and overwritten)
+ * @return bool False if the block holds ill-formed UTF-8 (nothing is counted)
+ * @throws std::runtime_error If the device fails
+ */
+bool countBlock(std::string_view block, uint32_t minN, uint32_t maxN, std::vector<OrderCounts>& orders);
+
+} // namespace gpu
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_GPU_KERNELS_H_
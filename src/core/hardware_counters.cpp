@@ -0,0 +1,184 @@
+/**
+ * @file hardware_counters.cpp
+ * @brief Implementation of hardware performance counters
+ */
+
+#include "core/hardware_counters.h"
+#include <atomic>
+
+#ifdef __linux__
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+std::atomic<bool> countersEnabled{false};
+
+// Events in the order of the HardwareCounters fields
+constexpr size_t kEvents = 6;
+
+constexpr uint64_t HardwareCounters::*kEventFields[kEvents] = {
+    &HardwareCounters::cycles,
+    &HardwareCounters::instructions,
+    &HardwareCounters::cacheReferences,
+    &HardwareCounters::cacheMisses,
+    &HardwareCounters::branches,
+    &HardwareCounters::branchMisses,
+};
+
+double ratio(uint64_t numerator, uint64_t denominator) {
+    return denominator > 0 ? static_cast<double>(numerator) / static_cast<double>(denominator) : 0.0;
+}
+
+#ifdef __linux__
+
+constexpr uint64_t kEventConfigs[kEvents] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_REFERENCES,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_INSTRUCTIONS,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+// Thread IDs of the process
+std::vector<pid_t> processThreads() {
+    std::vector<pid_t> threads;
+    std::error_code error;
+    std::filesystem::directory_iterator it("/proc/self/task", error);
+    if (error) {
+        return {static_cast<pid_t>(syscall(SYS_gettid))};
+    }
+    for (; it != std::filesystem::directory_iterator(); it.increment(error)) {
+        if (error) {
+            break;
+        }
+        threads.push_back(static_cast<pid_t>(std::atoi(it->path().filename().c_str())));
+    }
+    return threads;
+}
+
+// Open one event for the given threads; empty if any thread refuses it
+std::vector<int> openEvent(uint64_t config, const std::vector<pid_t>& threads) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.inherit = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    std::vector<int> fds;
+    for (pid_t thread : threads) {
+        int fd = static_cast<int>(syscall(SYS_perf_event_open, &attr, thread, -1, -1, PERF_FLAG_FD_CLOEXEC));
+        if (fd >= 0) {
+            fds.push_back(fd);
+        } else if (errno != ESRCH) {
+            // Threads that exited meanwhile are skipped; anything else leaves the event out
+            for (int opened : fds) {
+                close(opened);
+            }
+            return {};
+        }
+    }
+    return fds;
+}
+
+// Count of one descriptor, scaled up for the time the kernel multiplexed it out
+uint64_t readScaled(int fd) {
+    uint64_t values[3] = {0, 0, 0};  // value, time enabled, time running
+    if (::read(fd, values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) {
+        return 0;
+    }
+    if (values[2] >= values[1]) {
+        return values[0];
+    }
+    return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] / values[2]);
+}
+
+#endif
+
+} // namespace
+
+void setHardwareCounters(bool enabled) {
+    countersEnabled.store(enabled);
+}
+
+bool hardwareCountersEnabled() {
+    return countersEnabled.load();
+}
+
+HardwareCounters hardwareCountersBetween(const HardwareCounters& begin, const HardwareCounters& end) {
+    HardwareCounters counters;
+    if (!begin.available || !end.available) {
+        return counters;
+    }
+    counters.available = true;
+    for (size_t event = 0; event < kEvents; ++event) {
+        uint64_t from = begin.*kEventFields[event];
+        uint64_t to = end.*kEventFields[event];
+        counters.*kEventFields[event] = to > from ? to - from : 0;
+    }
+    counters.ipc = ratio(counters.instructions, counters.cycles);
+    counters.cacheMissRate = ratio(counters.cacheMisses, counters.cacheReferences);
+    counters.branchMissRate = ratio(counters.branchMisses, counters.branches);
+    return counters;
+}
+
+HardwareCounterSet::HardwareCounterSet()
+    : events_(kEvents)
+{
+#ifdef __linux__
+    std::vector<pid_t> threads = processThreads();
+    for (size_t event = 0; event < kEvents; ++event) {
+        events_[event] = openEvent(kEventConfigs[event], threads);
+    }
+#endif
+}
+
+HardwareCounterSet::~HardwareCounterSet() {
+#ifdef __linux__
+    for (const std::vector<int>& fds : events_) {
+        for (int fd : fds) {
+            close(fd);
+        }
+    }
+#endif
+}
+
+bool HardwareCounterSet::available() const {
+    for (const std::vector<int>& fds : events_) {
+        if (!fds.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+HardwareCounters HardwareCounterSet::read() const {
+    HardwareCounters counters;
+    counters.available = available();
+#ifdef __linux__
+    // Inherited counters include the threads started since, running or exited
+    for (size_t event = 0; event < kEvents; ++event) {
+        for (int fd : events_[event]) {
+            counters.*kEventFields[event] += readScaled(fd);
+        }
+    }
+#endif
+    return counters;
+}
+
+} // namespace core
+} // namespace suzume
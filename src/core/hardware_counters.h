@@ -0,0 +1,90 @@
+/**
+ * @file hardware_counters.h
+ * @brief Hardware performance counters through perf_event_open on Linux
+ */
+
+#ifndef SUZUME_CORE_HARDWARE_COUNTERS_H_
+#define SUZUME_CORE_HARDWARE_COUNTERS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Turn hardware counters of the operations on or off
+ *
+ * When on, every operation counts cycles, instructions, cache and branch
+ * events over its run and each phase, reported in its
+ * OperationMetrics::counters. The setting is process-wide and read when an
+ * operation starts. Off by default: opening the counters costs a few
+ * system calls per thread, and the kernel may not allow them
+ * (perf_event_paranoid, containers without CAP_PERFMON).
+ *
+ * @param enabled True to count
+ */
+void setHardwareCounters(bool enabled);
+
+/**
+ * @brief Check whether operations count hardware events
+ * @return bool Setting of setHardwareCounters()
+ */
+bool hardwareCountersEnabled();
+
+/**
+ * @brief Get the counts between two readings, with the derived ratios
+ * @param begin Reading at the start
+ * @param end Reading at the end
+ * @return HardwareCounters Differences, IPC and miss rates (not available if either reading is not)
+ */
+HardwareCounters hardwareCountersBetween(const HardwareCounters& begin, const HardwareCounters& end);
+
+/**
+ * @brief Counters of the whole process, counting from construction
+ *
+ * Each event is opened for every thread alive at construction, in user
+ * mode, and inherited by the threads they start later, so pool workers
+ * are counted whether they exist already or not. Counts are scaled when
+ * the kernel multiplexed the counters. Events that cannot be opened for
+ * every thread are left out and read as 0; elsewhere than on Linux
+ * nothing is counted.
+ */
+class HardwareCounterSet {
+public:
+    /**
+     * @brief Constructor; opens the counters and starts counting
+     */
+    HardwareCounterSet();
+
+    /**
+     * @brief Destructor; closes the counters
+     */
+    ~HardwareCounterSet();
+
+    HardwareCounterSet(const HardwareCounterSet&) = delete;
+    HardwareCounterSet& operator=(const HardwareCounterSet&) = delete;
+
+    /**
+     * @brief Check whether any event is counted
+     * @return bool True if at least one event was opened
+     */
+    bool available() const;
+
+    /**
+     * @brief Read the counts since construction
+     * @return HardwareCounters Counts, without the ratios (see hardwareCountersBetween())
+     */
+    HardwareCounters read() const;
+
+private:
+    /// File descriptors of each event, one per thread; empty if the event is not counted
+    std::vector<std::vector<int>> events_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_HARDWARE_COUNTERS_H_
@@ -0,0 +1,157 @@
+/**
+ * @file input_files.cpp
+ * @brief Implementation of input file expansion
+ */
+
+#include "core/input_files.h"
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+bool hasWildcard(const std::string& text) {
+    return text.find_first_of("*?") != std::string::npos;
+}
+
+bool isHidden(const std::filesystem::path& path) {
+    std::string name = path.filename().string();
+    return !name.empty() && name[0] == '.';
+}
+
+/**
+ * @brief Collect the files an entry names, in expansion order
+ */
+void collectFiles(const std::string& inputPath, std::vector<std::filesystem::path>& files) {
+    namespace fs = std::filesystem;
+    fs::path path(inputPath);
+
+    if (hasWildcard(path.filename().string())) {
+        fs::path directory = path.parent_path().empty() ? fs::path(".") : path.parent_path();
+        if (hasWildcard(directory.string())) {
+            throw std::runtime_error("Wildcards are only supported in the file name: " + inputPath);
+        }
+        if (!fs::is_directory(directory)) {
+            throw std::runtime_error("Input directory does not exist: " + directory.string());
+        }
+
+        std::vector<fs::path> matches;
+        std::string pattern = path.filename().string();
+        for (const auto& entry : fs::directory_iterator(directory)) {
+            if (entry.is_regular_file() && matchGlob(pattern, entry.path().filename().string())) {
+                matches.push_back(path.parent_path().empty() ? entry.path().filename() : entry.path());
+            }
+        }
+        if (matches.empty()) {
+            throw std::runtime_error("No input files match: " + inputPath);
+        }
+        std::sort(matches.begin(), matches.end());
+        files.insert(files.end(), matches.begin(), matches.end());
+        return;
+    }
+
+    if (fs::is_directory(path)) {
+        std::vector<fs::path> matches;
+        for (auto it = fs::recursive_directory_iterator(path); it != fs::recursive_directory_iterator(); ++it) {
+            if (isHidden(it->path())) {
+                if (it->is_directory()) {
+                    it.disable_recursion_pending();
+                }
+                continue;
+            }
+            if (it->is_regular_file()) {
+                matches.push_back(it->path());
+            }
+        }
+        if (matches.empty()) {
+            throw std::runtime_error("No input files in directory: " + inputPath);
+        }
+        std::sort(matches.begin(), matches.end());
+        files.insert(files.end(), matches.begin(), matches.end());
+        return;
+    }
+
+    if (!fs::exists(path)) {
+        throw std::runtime_error("Input file does not exist: " + inputPath);
+    }
+    files.push_back(path);
+}
+
+} // namespace
+
+bool isInputPattern(const std::string& inputPath) {
+    if (inputPath == "-") {
+        return false;
+    }
+    if (hasWildcard(std::filesystem::path(inputPath).filename().string())) {
+        return !std::filesystem::exists(inputPath);
+    }
+    return std::filesystem::is_directory(inputPath);
+}
+
+bool matchGlob(const std::string& pattern, const std::string& name) {
+    // Iterative matcher; backtracks only to the most recent '*'
+    size_t p = 0;
+    size_t n = 0;
+    size_t starPattern = std::string::npos;
+    size_t starName = 0;
+
+    while (n < name.size()) {
+        if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == name[n])) {
+            p++;
+            n++;
+        } else if (p < pattern.size() && pattern[p] == '*') {
+            starPattern = p++;
+            starName = n;
+        } else if (starPattern != std::string::npos) {
+            p = starPattern + 1;
+            n = ++starName;
+        } else {
+            return false;
+        }
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        p++;
+    }
+    return p == pattern.size();
+}
+
+std::vector<InputFile> expandInputPaths(const std::vector<std::string>& inputPaths) {
+    std::vector<std::filesystem::path> paths;
+    for (const auto& inputPath : inputPaths) {
+        if (inputPath == "-") {
+            throw std::invalid_argument("Standard input cannot be combined with other inputs");
+        }
+        collectFiles(inputPath, paths);
+    }
+
+    std::vector<InputFile> files;
+    std::unordered_set<std::string> seen;
+    for (const auto& path : paths) {
+        std::error_code error;
+        std::string key = std::filesystem::weakly_canonical(path, error).string();
+        if (!seen.insert(error ? path.string() : key).second) {
+            continue;
+        }
+
+        InputFile file;
+        file.path = path.string();
+        file.size = std::filesystem::file_size(path, error);
+        if (error) {
+            file.size = 0;
+        }
+        file.order = files.size();
+        files.push_back(std::move(file));
+    }
+
+    std::stable_sort(files.begin(), files.end(),
+                     [](const InputFile& a, const InputFile& b) { return a.size > b.size; });
+    return files;
+}
+
+} // namespace core
+} // namespace suzume
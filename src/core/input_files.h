@@ -0,0 +1,64 @@
+/**
+ * @file input_files.h
+ * @brief Expansion of file lists, directories and globs into scheduled input files
+ */
+
+#ifndef SUZUME_CORE_INPUT_FILES_H_
+#define SUZUME_CORE_INPUT_FILES_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief One input file of a multi-file run
+ */
+struct InputFile {
+    std::string path;  ///< File path
+    uint64_t size = 0; ///< File size in bytes
+    size_t order = 0;  ///< Position in expansion order (used to preserve input order)
+};
+
+/**
+ * @brief Check whether an input path names more than one file
+ *
+ * @param inputPath Input path
+ * @return bool True for directories and paths with '*' or '?' wildcards
+ */
+bool isInputPattern(const std::string& inputPath);
+
+/**
+ * @brief Check whether a file name matches a glob pattern
+ *
+ * '*' matches any run of characters and '?' matches one character.
+ *
+ * @param pattern Glob pattern
+ * @param name File name
+ * @return bool True if the name matches
+ */
+bool matchGlob(const std::string& pattern, const std::string& name);
+
+/**
+ * @brief Expand input paths into the files to read, largest first
+ *
+ * Each entry may be a file, a directory (all regular files below it, hidden
+ * files skipped) or a glob whose wildcards are in the last path component.
+ * Files named more than once are read once. Expansion order is the order of
+ * the entries, with directory and glob matches sorted by path; it is kept in
+ * InputFile::order while the returned list is sorted by size, largest first,
+ * so that the biggest files start early and workers finish together.
+ *
+ * @param inputPaths Files, directories or globs
+ * @return std::vector<InputFile> Files to read, largest first
+ * @throws std::runtime_error If an entry does not exist or matches no files
+ */
+std::vector<InputFile> expandInputPaths(const std::vector<std::string>& inputPaths);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_INPUT_FILES_H_
@@ -0,0 +1,44 @@
+/**
+ * @file line_blocks.cpp
+ * @brief Implementation of line-aligned block reading
+ */
+
+#include "core/line_blocks.h"
+#include <algorithm>
+
+namespace suzume {
+namespace core {
+
+LineBlockReader::LineBlockReader(std::istream& input, size_t blockSize)
+    : input_(input)
+    , blockSize_(std::max<size_t>(blockSize, 1))
+    , bytesRead_(0)
+{
+}
+
+bool LineBlockReader::next(std::string& block) {
+    // Start from the partial line left by the previous block
+    block.assign(carry_);
+    carry_.clear();
+
+    while (input_) {
+        size_t offset = block.size();
+        block.resize(offset + blockSize_);
+        input_.read(&block[offset], static_cast<std::streamsize>(blockSize_));
+        size_t got = static_cast<size_t>(input_.gcount());
+        block.resize(offset + got);
+        bytesRead_ += got;
+
+        // Cut after the last newline and keep the partial line for the next block
+        size_t newline = block.rfind('\n');
+        if (newline != std::string::npos) {
+            carry_.assign(block, newline + 1, std::string::npos);
+            block.resize(newline + 1);
+            return true;
+        }
+    }
+    return !block.empty();
+}
+
+} // namespace core
+} // namespace suzume
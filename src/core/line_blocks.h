@@ -0,0 +1,61 @@
+/**
+ * @file line_blocks.h
+ * @brief Reading a stream in large blocks that end on line boundaries
+ */
+
+#ifndef SUZUME_CORE_LINE_BLOCKS_H_
+#define SUZUME_CORE_LINE_BLOCKS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <string>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Reads a stream in fixed-size blocks of complete lines
+ *
+ * Every read asks the stream for blockSize bytes. The bytes after the last
+ * newline are carried over to the front of the next block, so each block
+ * holds whole lines only and can be processed independently of the others.
+ * A line longer than a block makes that block grow until the line ends.
+ * Only the last block may lack a trailing newline.
+ */
+class LineBlockReader {
+public:
+    /// Default bytes per read
+    static constexpr size_t kDefaultBlockSize = 16 * 1024 * 1024;
+
+    /**
+     * @brief Constructor
+     * @param input Input stream, read until EOF
+     * @param blockSize Bytes per read (at least 1)
+     */
+    explicit LineBlockReader(std::istream& input, size_t blockSize = kDefaultBlockSize);
+
+    /**
+     * @brief Read the next block
+     * @param block Receives the block, replacing its contents (its capacity is reused)
+     * @return bool False once the stream is exhausted
+     */
+    bool next(std::string& block);
+
+    /**
+     * @brief Get the number of bytes read from the stream so far
+     * @return uint64_t Bytes read
+     */
+    uint64_t bytesRead() const { return bytesRead_; }
+
+private:
+    std::istream& input_;
+    size_t blockSize_;
+    std::string carry_;
+    uint64_t bytesRead_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_LINE_BLOCKS_H_
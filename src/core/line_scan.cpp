@@ -0,0 +1,535 @@
+/**
+ * @file line_scan.cpp
+ * @brief Implementation of vectorized line classification
+ */
+
+#include "core/line_scan.h"
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__)) && !defined(EMSCRIPTEN)
+#include <immintrin.h>
+#define SUZUME_LINE_SCAN_X86 1
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define SUZUME_LINE_SCAN_NEON 1
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+#define SUZUME_LINE_SCAN_WASM 1
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+inline bool isAsciiSpace(unsigned char c) {
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+inline bool isContinuation(unsigned char c) {
+    return (c & 0xC0) == 0x80;
+}
+
+// Scalar kernel: classify bytes from pos until at least stop, finishing any
+// multi-byte sequence that straddles stop. Returns the new position.
+size_t scanScalarRange(const unsigned char* data, size_t pos, size_t length, size_t stop, LineScan& scan) {
+    while (pos < stop) {
+        unsigned char c = data[pos];
+        if (c < 0x80) {
+            scan.hasTab = scan.hasTab || c == '\t';
+            scan.whitespaceOnly = scan.whitespaceOnly && isAsciiSpace(c);
+            scan.codePoints++;
+            pos++;
+            continue;
+        }
+
+        scan.ascii = false;
+        scan.whitespaceOnly = false;
+        scan.codePoints++;
+
+        // Well-formed sequences per the Unicode table of valid UTF-8 byte ranges
+        size_t sequenceLength = 0;
+        unsigned char low = 0x80;
+        unsigned char high = 0xBF;
+        if (c >= 0xC2 && c <= 0xDF) {
+            sequenceLength = 2;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            sequenceLength = 3;
+            low = (c == 0xE0) ? 0xA0 : 0x80;
+            high = (c == 0xED) ? 0x9F : 0xBF;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            sequenceLength = 4;
+            low = (c == 0xF0) ? 0x90 : 0x80;
+            high = (c == 0xF4) ? 0x8F : 0xBF;
+        }
+
+        bool valid = sequenceLength != 0 && pos + sequenceLength <= length &&
+                     data[pos + 1] >= low && data[pos + 1] <= high;
+        for (size_t i = 2; valid && i < sequenceLength; ++i) {
+            valid = isContinuation(data[pos + i]);
+        }
+
+        if (!valid) {
+            scan.validUtf8 = false;
+            pos++;
+            continue;
+        }
+        pos += sequenceLength;
+    }
+    return pos;
+}
+
+LineScan scanScalar(const unsigned char* data, size_t length) {
+    LineScan scan;
+    scanScalarRange(data, 0, length, length, scan);
+    return scan;
+}
+
+#if defined(SUZUME_LINE_SCAN_X86) || defined(SUZUME_LINE_SCAN_NEON) || defined(SUZUME_LINE_SCAN_WASM)
+// UTF-8 validation by nibble lookup (Keiser & Lemire, "Validating UTF-8 In Less
+// Than One Instruction Per Byte"). Each table maps a nibble of the previous or
+// current byte to the error classes it may take part in; a byte pair is
+// invalid when all three lookups share a class.
+constexpr uint8_t kTooShort = 1 << 0;
+constexpr uint8_t kTooLong = 1 << 1;
+constexpr uint8_t kOverlong3 = 1 << 2;
+constexpr uint8_t kTooLarge = 1 << 3;
+constexpr uint8_t kSurrogate = 1 << 4;
+constexpr uint8_t kOverlong2 = 1 << 5;
+constexpr uint8_t kTooLarge1000 = 1 << 6;
+constexpr uint8_t kOverlong4 = 1 << 6;
+constexpr uint8_t kTwoConts = 1 << 7;
+constexpr uint8_t kCarry = kTooShort | kTooLong | kTwoConts;
+
+alignas(16) constexpr uint8_t kByte1High[16] = {
+    kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong, kTooLong,
+    kTwoConts, kTwoConts, kTwoConts, kTwoConts,
+    kTooShort | kOverlong2,
+    kTooShort,
+    kTooShort | kOverlong3 | kSurrogate,
+    kTooShort | kTooLarge | kTooLarge1000 | kOverlong4
+};
+
+alignas(16) constexpr uint8_t kByte1Low[16] = {
+    kCarry | kOverlong3 | kOverlong2 | kOverlong4,
+    kCarry | kOverlong2,
+    kCarry,
+    kCarry,
+    kCarry | kTooLarge,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000 | kSurrogate,
+    kCarry | kTooLarge | kTooLarge1000,
+    kCarry | kTooLarge | kTooLarge1000
+};
+
+alignas(16) constexpr uint8_t kByte2High[16] = {
+    kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort, kTooShort,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge1000 | kOverlong4,
+    kTooLong | kOverlong2 | kTwoConts | kOverlong3 | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooLong | kOverlong2 | kTwoConts | kSurrogate | kTooLarge,
+    kTooShort, kTooShort, kTooShort, kTooShort
+};
+#endif
+
+#ifdef SUZUME_LINE_SCAN_X86
+// All SIMD kernels walk the line in blocks. A block that is entirely ASCII
+// and follows an ASCII block skips validation; the final partial block is
+// zero padded, so a truncated sequence at the end of the line shows up as
+// a missing continuation byte.
+
+struct Avx2State {
+    __m256i previous;
+    __m256i error;
+    bool previousNonAscii;
+};
+
+__attribute__((target("avx2"), always_inline))
+inline __m256i checkUtf8Avx2(__m256i input, __m256i previous) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    const __m256i byte1HighTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte1High)));
+    const __m256i byte1LowTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte1Low)));
+    const __m256i byte2HighTable = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(kByte2High)));
+
+    __m256i carried = _mm256_permute2x128_si256(previous, input, 0x21);
+    __m256i prev1 = _mm256_alignr_epi8(input, carried, 15);
+    __m256i prev2 = _mm256_alignr_epi8(input, carried, 14);
+    __m256i prev3 = _mm256_alignr_epi8(input, carried, 13);
+
+    __m256i byte1High = _mm256_shuffle_epi8(byte1HighTable, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte1Low = _mm256_shuffle_epi8(byte1LowTable, _mm256_and_si256(prev1, nibble));
+    __m256i byte2High = _mm256_shuffle_epi8(byte2HighTable, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte1High, byte1Low), byte2High);
+
+    // Third and fourth bytes of 3- and 4-byte sequences must be continuations
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m256i must23 = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8(static_cast<char>(0x80)));
+    return _mm256_xor_si256(must23, special);
+}
+
+__attribute__((target("avx2"), always_inline))
+inline void scanBlockAvx2(__m256i input, size_t count, Avx2State& state, LineScan& scan) {
+    const uint32_t padding = count == 32 ? 0 : ~((uint32_t{1} << count) - 1);
+
+    scan.hasTab = scan.hasTab || _mm256_movemask_epi8(_mm256_cmpeq_epi8(input, _mm256_set1_epi8('\t'))) != 0;
+
+    if (_mm256_movemask_epi8(input) == 0) {
+        if (scan.whitespaceOnly) {
+            // '\t'..'\r' map to 0..4 after subtracting '\t'
+            __m256i shifted = _mm256_sub_epi8(input, _mm256_set1_epi8('\t'));
+            __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8(4)), shifted);
+            __m256i whitespace = _mm256_or_si256(control, _mm256_cmpeq_epi8(input, _mm256_set1_epi8(' ')));
+            scan.whitespaceOnly = (static_cast<uint32_t>(_mm256_movemask_epi8(whitespace)) | padding) == 0xFFFFFFFFu;
+        }
+        scan.codePoints += count;
+        if (state.previousNonAscii) {
+            state.error = _mm256_or_si256(state.error, checkUtf8Avx2(input, state.previous));
+        }
+        state.previousNonAscii = false;
+    } else {
+        scan.ascii = false;
+        scan.whitespaceOnly = false;
+
+        // Every byte except a continuation (0x80-0xBF, i.e. below -64 signed) starts a code point
+        uint32_t leads = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpgt_epi8(input, _mm256_set1_epi8(-65))));
+        scan.codePoints += static_cast<size_t>(__builtin_popcount(leads & ~padding));
+        state.error = _mm256_or_si256(state.error, checkUtf8Avx2(input, state.previous));
+        state.previousNonAscii = true;
+    }
+    state.previous = input;
+}
+
+__attribute__((target("avx2")))
+LineScan scanAvx2(const unsigned char* data, size_t length) {
+    LineScan scan;
+    Avx2State state{_mm256_setzero_si256(), _mm256_setzero_si256(), false};
+
+    size_t pos = 0;
+    for (; pos + 32 <= length; pos += 32) {
+        scanBlockAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + pos)), 32, state, scan);
+    }
+    if (pos < length) {
+        alignas(32) unsigned char tail[32] = {};
+        std::memcpy(tail, data + pos, length - pos);
+        scanBlockAvx2(_mm256_load_si256(reinterpret_cast<const __m256i*>(tail)), length - pos, state, scan);
+    }
+    if (state.previousNonAscii) {
+        state.error = _mm256_or_si256(state.error, checkUtf8Avx2(_mm256_setzero_si256(), state.previous));
+    }
+
+    scan.validUtf8 = _mm256_testz_si256(state.error, state.error) != 0;
+    return scan;
+}
+
+struct Ssse3State {
+    __m128i previous;
+    __m128i error;
+    bool previousNonAscii;
+};
+
+__attribute__((target("ssse3"), always_inline))
+inline __m128i checkUtf8Ssse3(__m128i input, __m128i previous) {
+    const __m128i nibble = _mm_set1_epi8(0x0F);
+    const __m128i byte1HighTable = _mm_load_si128(reinterpret_cast<const __m128i*>(kByte1High));
+    const __m128i byte1LowTable = _mm_load_si128(reinterpret_cast<const __m128i*>(kByte1Low));
+    const __m128i byte2HighTable = _mm_load_si128(reinterpret_cast<const __m128i*>(kByte2High));
+
+    __m128i prev1 = _mm_alignr_epi8(input, previous, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, previous, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous, 13);
+
+    __m128i byte1High = _mm_shuffle_epi8(byte1HighTable, _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble));
+    __m128i byte1Low = _mm_shuffle_epi8(byte1LowTable, _mm_and_si128(prev1, nibble));
+    __m128i byte2High = _mm_shuffle_epi8(byte2HighTable, _mm_and_si128(_mm_srli_epi16(input, 4), nibble));
+    __m128i special = _mm_and_si128(_mm_and_si128(byte1High, byte1Low), byte2High);
+
+    __m128i third = _mm_subs_epu8(prev2, _mm_set1_epi8(static_cast<char>(0xE0 - 0x80)));
+    __m128i fourth = _mm_subs_epu8(prev3, _mm_set1_epi8(static_cast<char>(0xF0 - 0x80)));
+    __m128i must23 = _mm_and_si128(_mm_or_si128(third, fourth), _mm_set1_epi8(static_cast<char>(0x80)));
+    return _mm_xor_si128(must23, special);
+}
+
+__attribute__((target("ssse3,popcnt"), always_inline))
+inline void scanBlockSsse3(__m128i input, size_t count, Ssse3State& state, LineScan& scan) {
+    const uint32_t padding = 0xFFFFu & ~((uint32_t{1} << count) - 1);
+
+    scan.hasTab = scan.hasTab || _mm_movemask_epi8(_mm_cmpeq_epi8(input, _mm_set1_epi8('\t'))) != 0;
+
+    if (_mm_movemask_epi8(input) == 0) {
+        if (scan.whitespaceOnly) {
+            __m128i shifted = _mm_sub_epi8(input, _mm_set1_epi8('\t'));
+            __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8(4)), shifted);
+            __m128i whitespace = _mm_or_si128(control, _mm_cmpeq_epi8(input, _mm_set1_epi8(' ')));
+            scan.whitespaceOnly = (static_cast<uint32_t>(_mm_movemask_epi8(whitespace)) | padding) == 0xFFFFu;
+        }
+        scan.codePoints += count;
+        if (state.previousNonAscii) {
+            state.error = _mm_or_si128(state.error, checkUtf8Ssse3(input, state.previous));
+        }
+        state.previousNonAscii = false;
+    } else {
+        scan.ascii = false;
+        scan.whitespaceOnly = false;
+
+        uint32_t leads = static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(input, _mm_set1_epi8(-65))));
+        scan.codePoints += static_cast<size_t>(__builtin_popcount(leads & ~padding));
+        state.error = _mm_or_si128(state.error, checkUtf8Ssse3(input, state.previous));
+        state.previousNonAscii = true;
+    }
+    state.previous = input;
+}
+
+__attribute__((target("ssse3,popcnt")))
+LineScan scanSsse3(const unsigned char* data, size_t length) {
+    LineScan scan;
+    Ssse3State state{_mm_setzero_si128(), _mm_setzero_si128(), false};
+
+    size_t pos = 0;
+    for (; pos + 16 <= length; pos += 16) {
+        scanBlockSsse3(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + pos)), 16, state, scan);
+    }
+    if (pos < length) {
+        alignas(16) unsigned char tail[16] = {};
+        std::memcpy(tail, data + pos, length - pos);
+        scanBlockSsse3(_mm_load_si128(reinterpret_cast<const __m128i*>(tail)), length - pos, state, scan);
+    }
+    if (state.previousNonAscii) {
+        state.error = _mm_or_si128(state.error, checkUtf8Ssse3(_mm_setzero_si128(), state.previous));
+    }
+
+    scan.validUtf8 = _mm_movemask_epi8(_mm_cmpeq_epi8(state.error, _mm_setzero_si128())) == 0xFFFF;
+    return scan;
+}
+#endif
+
+#ifdef SUZUME_LINE_SCAN_NEON
+struct NeonState {
+    uint8x16_t previous;
+    uint8x16_t error;
+    bool previousNonAscii;
+};
+
+inline uint8x16_t checkUtf8Neon(uint8x16_t input, uint8x16_t previous) {
+    const uint8x16_t nibble = vdupq_n_u8(0x0F);
+
+    uint8x16_t prev1 = vextq_u8(previous, input, 15);
+    uint8x16_t prev2 = vextq_u8(previous, input, 14);
+    uint8x16_t prev3 = vextq_u8(previous, input, 13);
+
+    uint8x16_t byte1High = vqtbl1q_u8(vld1q_u8(kByte1High), vshrq_n_u8(prev1, 4));
+    uint8x16_t byte1Low = vqtbl1q_u8(vld1q_u8(kByte1Low), vandq_u8(prev1, nibble));
+    uint8x16_t byte2High = vqtbl1q_u8(vld1q_u8(kByte2High), vshrq_n_u8(input, 4));
+    uint8x16_t special = vandq_u8(vandq_u8(byte1High, byte1Low), byte2High);
+
+    uint8x16_t third = vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80));
+    uint8x16_t fourth = vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80));
+    uint8x16_t must23 = vandq_u8(vorrq_u8(third, fourth), vdupq_n_u8(0x80));
+    return veorq_u8(must23, special);
+}
+
+inline void scanBlockNeon(uint8x16_t input, size_t count, NeonState& state, LineScan& scan) {
+    static const uint8_t kLaneIndex[16] = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15};
+    uint8x16_t padding = vcgeq_u8(vld1q_u8(kLaneIndex), vdupq_n_u8(static_cast<uint8_t>(count)));
+
+    scan.hasTab = scan.hasTab || vmaxvq_u8(vceqq_u8(input, vdupq_n_u8('\t'))) != 0;
+
+    if (vmaxvq_u8(input) < 0x80) {
+        if (scan.whitespaceOnly) {
+            uint8x16_t control = vcleq_u8(vsubq_u8(input, vdupq_n_u8('\t')), vdupq_n_u8(4));
+            uint8x16_t whitespace = vorrq_u8(control, vceqq_u8(input, vdupq_n_u8(' ')));
+            scan.whitespaceOnly = vminvq_u8(vorrq_u8(whitespace, padding)) == 0xFF;
+        }
+        scan.codePoints += count;
+        if (state.previousNonAscii) {
+            state.error = vorrq_u8(state.error, checkUtf8Neon(input, state.previous));
+        }
+        state.previousNonAscii = false;
+    } else {
+        scan.ascii = false;
+        scan.whitespaceOnly = false;
+
+        uint8x16_t leads = vcgtq_s8(vreinterpretq_s8_u8(input), vdupq_n_s8(-65));
+        leads = vbicq_u8(leads, padding);
+        scan.codePoints += vaddvq_u8(vshrq_n_u8(leads, 7));
+        state.error = vorrq_u8(state.error, checkUtf8Neon(input, state.previous));
+        state.previousNonAscii = true;
+    }
+    state.previous = input;
+}
+
+LineScan scanNeon(const unsigned char* data, size_t length) {
+    LineScan scan;
+    NeonState state{vdupq_n_u8(0), vdupq_n_u8(0), false};
+
+    size_t pos = 0;
+    for (; pos + 16 <= length; pos += 16) {
+        scanBlockNeon(vld1q_u8(data + pos), 16, state, scan);
+    }
+    if (pos < length) {
+        unsigned char tail[16] = {};
+        std::memcpy(tail, data + pos, length - pos);
+        scanBlockNeon(vld1q_u8(tail), length - pos, state, scan);
+    }
+    if (state.previousNonAscii) {
+        state.error = vorrq_u8(state.error, checkUtf8Neon(vdupq_n_u8(0), state.previous));
+    }
+
+    scan.validUtf8 = vmaxvq_u8(state.error) == 0;
+    return scan;
+}
+#endif
+
+#ifdef SUZUME_LINE_SCAN_WASM
+// WebAssembly has no runtime feature detection inside a module; this kernel is
+// compiled into the -msimd128 build, and the JS loader picks that build only
+// on engines that validate SIMD code.
+struct WasmState {
+    v128_t previous;
+    v128_t error;
+    bool previousNonAscii;
+};
+
+inline v128_t checkUtf8Wasm(v128_t input, v128_t previous) {
+    const v128_t nibble = wasm_u8x16_splat(0x0F);
+
+    // The last one, two and three bytes of the previous block ahead of this one
+    v128_t prev1 = wasm_i8x16_shuffle(previous, input, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30);
+    v128_t prev2 = wasm_i8x16_shuffle(previous, input, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29);
+    v128_t prev3 = wasm_i8x16_shuffle(previous, input, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28);
+
+    v128_t byte1High = wasm_i8x16_swizzle(wasm_v128_load(kByte1High), wasm_u8x16_shr(prev1, 4));
+    v128_t byte1Low = wasm_i8x16_swizzle(wasm_v128_load(kByte1Low), wasm_v128_and(prev1, nibble));
+    v128_t byte2High = wasm_i8x16_swizzle(wasm_v128_load(kByte2High), wasm_u8x16_shr(input, 4));
+    v128_t special = wasm_v128_and(wasm_v128_and(byte1High, byte1Low), byte2High);
+
+    v128_t third = wasm_u8x16_sub_sat(prev2, wasm_u8x16_splat(0xE0 - 0x80));
+    v128_t fourth = wasm_u8x16_sub_sat(prev3, wasm_u8x16_splat(0xF0 - 0x80));
+    v128_t must23 = wasm_v128_and(wasm_v128_or(third, fourth), wasm_u8x16_splat(0x80));
+    return wasm_v128_xor(must23, special);
+}
+
+inline void scanBlockWasm(v128_t input, size_t count, WasmState& state, LineScan& scan) {
+    const uint32_t padding = 0xFFFFu & ~((uint32_t{1} << count) - 1);
+
+    scan.hasTab = scan.hasTab || wasm_v128_any_true(wasm_i8x16_eq(input, wasm_i8x16_splat('\t')));
+
+    if (wasm_i8x16_bitmask(input) == 0) {
+        if (scan.whitespaceOnly) {
+            v128_t control = wasm_u8x16_le(wasm_i8x16_sub(input, wasm_i8x16_splat('\t')), wasm_u8x16_splat(4));
+            v128_t whitespace = wasm_v128_or(control, wasm_i8x16_eq(input, wasm_i8x16_splat(' ')));
+            scan.whitespaceOnly = (static_cast<uint32_t>(wasm_i8x16_bitmask(whitespace)) | padding) == 0xFFFFu;
+        }
+        scan.codePoints += count;
+        if (state.previousNonAscii) {
+            state.error = wasm_v128_or(state.error, checkUtf8Wasm(input, state.previous));
+        }
+        state.previousNonAscii = false;
+    } else {
+        scan.ascii = false;
+        scan.whitespaceOnly = false;
+
+        uint32_t leads = static_cast<uint32_t>(wasm_i8x16_bitmask(wasm_i8x16_gt(input, wasm_i8x16_splat(-65))));
+        scan.codePoints += static_cast<size_t>(__builtin_popcount(leads & ~padding));
+        state.error = wasm_v128_or(state.error, checkUtf8Wasm(input, state.previous));
+        state.previousNonAscii = true;
+    }
+    state.previous = input;
+}
+
+LineScan scanWasm(const unsigned char* data, size_t length) {
+    LineScan scan;
+    WasmState state{wasm_i64x2_splat(0), wasm_i64x2_splat(0), false};
+
+    size_t pos = 0;
+    for (; pos + 16 <= length; pos += 16) {
+        scanBlockWasm(wasm_v128_load(data + pos), 16, state, scan);
+    }
+    if (pos < length) {
+        unsigned char tail[16] = {};
+        std::memcpy(tail, data + pos, length - pos);
+        scanBlockWasm(wasm_v128_load(tail), length - pos, state, scan);
+    }
+    if (state.previousNonAscii) {
+        state.error = wasm_v128_or(state.error, checkUtf8Wasm(wasm_i64x2_splat(0), state.previous));
+    }
+
+    scan.validUtf8 = !wasm_v128_any_true(state.error);
+    return scan;
+}
+#endif
+
+using ScanKernel = LineScan (*)(const unsigned char*, size_t);
+
+struct KernelChoice {
+    ScanKernel kernel;
+    const char* name;
+};
+
+KernelChoice selectKernel() {
+#if defined(SUZUME_LINE_SCAN_X86)
+    if (__builtin_cpu_supports("avx2")) {
+        return {scanAvx2, "avx2"};
+    }
+    if (__builtin_cpu_supports("ssse3") && __builtin_cpu_supports("popcnt")) {
+        return {scanSsse3, "ssse3"};
+    }
+    return {scanScalar, "scalar"};
+#elif defined(SUZUME_LINE_SCAN_NEON)
+    return {scanNeon, "neon"};
+#elif defined(SUZUME_LINE_SCAN_WASM)
+    return {scanWasm, "simd128"};
+#else
+    return {scanScalar, "scalar"};
+#endif
+}
+
+const KernelChoice& kernelChoice() {
+    static const KernelChoice choice = selectKernel();
+    return choice;
+}
+
+} // namespace
+
+LineScan scanLine(std::string_view line) {
+    return kernelChoice().kernel(reinterpret_cast<const unsigned char*>(line.data()), line.size());
+}
+
+LineScan scanLineScalar(std::string_view line) {
+    return scanScalar(reinterpret_cast<const unsigned char*>(line.data()), line.size());
+}
+
+const char* lineScanKernel() {
+    return kernelChoice().name;
+}
+
+const char* findNewline(const char* begin, const char* end) {
+#ifdef SUZUME_LINE_SCAN_WASM
+    const v128_t newline = wasm_i8x16_splat('\n');
+    for (; end - begin >= 16; begin += 16) {
+        uint32_t mask = static_cast<uint32_t>(wasm_i8x16_bitmask(wasm_i8x16_eq(wasm_v128_load(begin), newline)));
+        if (mask != 0) {
+            return begin + __builtin_ctz(mask);
+        }
+    }
+    for (; begin < end; ++begin) {
+        if (*begin == '\n') {
+            return begin;
+        }
+    }
+    return nullptr;
+#else
+    return static_cast<const char*>(std::memchr(begin, '\n', static_cast<size_t>(end - begin)));
+#endif
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,70 @@
+/**
+ * @file line_scan.h
+ * @brief Single-pass vectorized line classification used to screen lines before ICU
+ */
+
+#ifndef SUZUME_CORE_LINE_SCAN_H_
+#define SUZUME_CORE_LINE_SCAN_H_
+
+#include <cstddef>
+#include <string_view>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Properties of a line gathered in one pass over its bytes
+ */
+struct LineScan {
+    bool validUtf8 = true;       ///< Line is well-formed UTF-8
+    bool ascii = true;           ///< Every byte is below 0x80
+    bool whitespaceOnly = true;  ///< Every byte is ASCII whitespace (true for empty lines)
+    bool hasTab = false;         ///< Line contains a tab (field separator)
+    size_t codePoints = 0;       ///< Number of code points (only exact when validUtf8)
+};
+
+/**
+ * @brief Classify a line
+ *
+ * Bytes are classified 16 or 32 at a time with AVX2, SSSE3 or NEON,
+ * whichever the CPU offers, or with WebAssembly SIMD in a -msimd128 build,
+ * falling back to a scalar kernel. UTF-8 is
+ * validated in the same pass with nibble lookup tables, and blocks of pure
+ * ASCII skip validation entirely.
+ *
+ * @param line Input line
+ * @return LineScan Line properties
+ */
+LineScan scanLine(std::string_view line);
+
+/**
+ * @brief Classify a line with the portable scalar kernel only
+ *
+ * @param line Input line
+ * @return LineScan Line properties, identical to scanLine()
+ */
+LineScan scanLineScalar(std::string_view line);
+
+/**
+ * @brief Get the name of the kernel scanLine() dispatches to
+ * @return const char* "avx2", "ssse3", "neon", "simd128" or "scalar"
+ */
+const char* lineScanKernel();
+
+/**
+ * @brief Find the next newline in a range
+ *
+ * This is memchr, whose C library versions are vectorized, except in
+ * WebAssembly SIMD builds: the Emscripten memchr scans a word at a time, so
+ * 16 bytes are compared per step there instead.
+ *
+ * @param begin Start of the range
+ * @param end End of the range
+ * @return const char* First '\n' in the range, or nullptr if there is none
+ */
+const char* findNewline(const char* begin, const char* end);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_LINE_SCAN_H_
@@ -0,0 +1,108 @@
+/**
+ * @file mapped_text.cpp
+ * @brief Implementation of mapped text files and their line ranges
+ */
+
+#include "core/mapped_text.h"
+#include "core/line_scan.h"
+#include "core/streaming_processor.h"
+#include <fstream>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+LineRange::iterator::iterator(const char* begin, const char* end, bool stripCarriageReturn)
+    : begin_(begin)
+    , end_(end)
+    , next_(begin)
+    , strip_(stripCarriageReturn)
+{
+    advance();
+}
+
+void LineRange::iterator::advance() {
+    if (next_ == nullptr || next_ == end_) {
+        next_ = nullptr;
+        line_ = std::string_view();
+        return;
+    }
+
+    const char* newline = findNewline(next_, end_);
+    const char* lineEnd = newline ? newline : end_;
+    size_t length = static_cast<size_t>(lineEnd - next_);
+    if (strip_ && length > 0 && next_[length - 1] == '\r') {
+        length--;
+    }
+    line_ = std::string_view(next_, length);
+    next_ = newline ? newline + 1 : end_;
+}
+
+LineRange::iterator LineRange::begin() const {
+    return iterator(text_.data(), text_.data() + text_.size(), strip_);
+}
+
+LineRange::iterator LineRange::end() const {
+    return iterator();
+}
+
+void forEachLine(
+    std::istream& input,
+    const std::function<void(std::string_view)>& lineProcessor,
+    bool stripCarriageReturn
+) {
+    constexpr size_t kReadBlockSize = 4 * 1024 * 1024;
+
+    std::string buffer;
+    size_t kept = 0;  // Bytes of an unfinished line carried over from the last block
+    while (true) {
+        buffer.resize(kept + kReadBlockSize);
+        input.read(&buffer[kept], kReadBlockSize);
+        size_t count = static_cast<size_t>(input.gcount());
+        buffer.resize(kept + count);
+        bool atEnd = !input || count == 0;
+
+        // Split up to the last newline; the rest waits for the next block
+        size_t complete = buffer.size();
+        if (!atEnd) {
+            // The carried bytes hold no newline, so only the new ones are searched
+            size_t newline = std::string_view(buffer).substr(kept).rfind('\n');
+            if (newline == std::string_view::npos) {
+                kept = buffer.size();
+                continue;
+            }
+            complete = kept + newline + 1;
+        }
+
+        for (std::string_view line : LineRange(std::string_view(buffer.data(), complete), stripCarriageReturn)) {
+            lineProcessor(line);
+        }
+        if (atEnd) {
+            return;
+        }
+        buffer.erase(0, complete);
+        kept = buffer.size();
+    }
+}
+
+MappedText::MappedText(const std::string& path) {
+    auto mapping = std::make_unique<MemoryMappedProcessor>(path);
+    if (mapping->isMapped()) {
+        mapping->adviseSequential();
+        text_ = std::string_view(mapping->data(), mapping->getFileSize());
+        mapping_ = std::move(mapping);
+        return;
+    }
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Failed to open file: " + path);
+    }
+    buffer_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    text_ = buffer_;
+}
+
+MappedText::~MappedText() = default;
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,165 @@
+/**
+ * @file mapped_text.h
+ * @brief Zero-copy access to the lines of a memory-mapped text file
+ */
+
+#ifndef SUZUME_CORE_MAPPED_TEXT_H_
+#define SUZUME_CORE_MAPPED_TEXT_H_
+
+#include <cstddef>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace suzume {
+namespace core {
+
+class MemoryMappedProcessor;
+
+/**
+ * @brief Lines of a text, as views into it
+ *
+ * Lines follow std::getline: a final newline does not start another line,
+ * and an empty text has no lines. Newlines are found with findNewline(),
+ * which is vectorized, so iterating costs a scan of the text and no copies.
+ */
+class LineRange {
+public:
+    /**
+     * @brief Forward iterator over the lines of a range
+     */
+    class iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+
+        reference operator*() const { return line_; }
+        pointer operator->() const { return &line_; }
+
+        iterator& operator++() {
+            advance();
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            advance();
+            return previous;
+        }
+
+        bool operator==(const iterator& other) const { return next_ == other.next_; }
+        bool operator!=(const iterator& other) const { return next_ != other.next_; }
+
+        /**
+         * @brief Get the offset just past the current line and its newline
+         * @return size_t Bytes of the text consumed so far
+         */
+        size_t offset() const { return static_cast<size_t>(next_ - begin_); }
+
+    private:
+        friend class LineRange;
+
+        iterator(const char* begin, const char* end, bool stripCarriageReturn);
+
+        void advance();
+
+        const char* begin_ = nullptr;
+        const char* end_ = nullptr;
+        const char* next_ = nullptr;   ///< Start of the next line (nullptr once exhausted)
+        std::string_view line_;
+        bool strip_ = false;
+    };
+
+    /**
+     * @brief Constructor
+     * @param text Text to split (must outlive the range and its lines)
+     * @param stripCarriageReturn Drop a '\r' ending a line (CRLF input)
+     */
+    explicit LineRange(std::string_view text, bool stripCarriageReturn = false)
+        : text_(text), strip_(stripCarriageReturn) {}
+
+    iterator begin() const;
+    iterator end() const;
+
+private:
+    std::string_view text_;
+    bool strip_;
+};
+
+/**
+ * @brief Split a stream into lines, reading it in large blocks
+ *
+ * Lines are cut exactly as LineRange cuts a mapped file, so a pipe or a
+ * decompressed stream yields the same lines as the file would. Only a line
+ * that spans two blocks is moved; the others are views into the block.
+ *
+ * @param input Stream to read to its end
+ * @param lineProcessor Called with each line (the view is valid during the call)
+ * @param stripCarriageReturn Drop a '\r' ending a line (CRLF input)
+ */
+void forEachLine(
+    std::istream& input,
+    const std::function<void(std::string_view)>& lineProcessor,
+    bool stripCarriageReturn = false
+);
+
+/**
+ * @brief Contents of a text file, mapped where possible
+ *
+ * Regular files are mapped read-only and advised for sequential access,
+ * with transparent huge pages requested where the kernel offers them. Files
+ * that cannot be mapped (empty files, platforms without mmap) are read into
+ * a buffer instead, so text() is valid either way. Compressed files are not
+ * decompressed here; callers stream those.
+ */
+class MappedText {
+public:
+    /**
+     * @brief Map or read a file
+     * @param path File path
+     * @throws std::runtime_error If the file cannot be opened
+     */
+    explicit MappedText(const std::string& path);
+
+    ~MappedText();
+
+    MappedText(const MappedText&) = delete;
+    MappedText& operator=(const MappedText&) = delete;
+
+    /**
+     * @brief Get the file contents
+     * @return std::string_view Contents, valid while this object lives
+     */
+    std::string_view text() const { return text_; }
+
+    /**
+     * @brief Get the lines of the file
+     * @param stripCarriageReturn Drop a '\r' ending a line
+     * @return LineRange Lines as views into text()
+     */
+    LineRange lines(bool stripCarriageReturn = false) const { return LineRange(text_, stripCarriageReturn); }
+
+    /**
+     * @brief Check whether the contents are mapped rather than read
+     * @return bool True if mapped
+     */
+    bool isMapped() const { return mapping_ != nullptr; }
+
+private:
+    std::unique_ptr<MemoryMappedProcessor> mapping_;
+    std::string buffer_;
+    std::string_view text_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_MAPPED_TEXT_H_
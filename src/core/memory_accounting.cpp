@@ -0,0 +1,151 @@
+/**
+ * @file memory_accounting.cpp
+ * @brief Implementation of per-subsystem memory accounting
+ */
+
+#include "core/memory_accounting.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+std::atomic<uint64_t> charged[kMemorySubsystems];
+std::atomic<uint64_t> limitBytes{0};
+
+// Live peak trackers; charges that grow a subsystem are rare enough for one lock
+struct TrackerRegistry {
+    std::mutex mutex;
+    std::vector<MemoryPeakTracker*> trackers;
+};
+
+TrackerRegistry& trackerRegistry() {
+    static TrackerRegistry registry;
+    return registry;
+}
+
+size_t indexOf(MemorySubsystem subsystem) {
+    return static_cast<size_t>(subsystem);
+}
+
+} // namespace
+
+const char* memorySubsystemName(MemorySubsystem subsystem) {
+    switch (subsystem) {
+        case MemorySubsystem::Lines: return "lines";
+        case MemorySubsystem::Dedup: return "dedup";
+        case MemorySubsystem::NgramTables: return "ngram_tables";
+        case MemorySubsystem::Tries: return "tries";
+        case MemorySubsystem::TextIndex: return "text_index";
+    }
+    return "unknown";
+}
+
+SubsystemBytes chargedMemory() {
+    SubsystemBytes bytes;
+    for (size_t i = 0; i < kMemorySubsystems; ++i) {
+        bytes[i] = charged[i].load(std::memory_order_relaxed);
+    }
+    return bytes;
+}
+
+MemoryCharge::MemoryCharge(MemorySubsystem subsystem, uint64_t bytes)
+    : subsystem_(subsystem)
+    , bytes_(0)
+{
+    set(bytes);
+}
+
+MemoryCharge::~MemoryCharge() {
+    set(0);
+}
+
+MemoryCharge::MemoryCharge(const MemoryCharge& other)
+    : MemoryCharge(other.subsystem_, other.bytes_)
+{
+}
+
+MemoryCharge::MemoryCharge(MemoryCharge&& other) noexcept
+    : subsystem_(other.subsystem_)
+    , bytes_(other.bytes_)
+{
+    other.bytes_ = 0;
+}
+
+MemoryCharge& MemoryCharge::operator=(const MemoryCharge& other) {
+    if (this != &other) {
+        set(0);
+        subsystem_ = other.subsystem_;
+        set(other.bytes_);
+    }
+    return *this;
+}
+
+MemoryCharge& MemoryCharge::operator=(MemoryCharge&& other) noexcept {
+    if (this != &other) {
+        set(0);
+        subsystem_ = other.subsystem_;
+        bytes_ = other.bytes_;
+        other.bytes_ = 0;
+    }
+    return *this;
+}
+
+void MemoryCharge::set(uint64_t bytes) {
+    if (bytes == bytes_) {
+        return;
+    }
+    std::atomic<uint64_t>& total = charged[indexOf(subsystem_)];
+    if (bytes < bytes_) {
+        total.fetch_sub(bytes_ - bytes, std::memory_order_relaxed);
+        bytes_ = bytes;
+        return;
+    }
+    uint64_t now = total.fetch_add(bytes - bytes_, std::memory_order_relaxed) + (bytes - bytes_);
+    bytes_ = bytes;
+    MemoryPeakTracker::raise(subsystem_, now);
+}
+
+MemoryPeakTracker::MemoryPeakTracker()
+    : peaks_(chargedMemory())
+{
+    TrackerRegistry& registry = trackerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.trackers.push_back(this);
+}
+
+MemoryPeakTracker::~MemoryPeakTracker() {
+    TrackerRegistry& registry = trackerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.trackers.erase(std::find(registry.trackers.begin(), registry.trackers.end(), this));
+}
+
+SubsystemBytes MemoryPeakTracker::peaks() const {
+    TrackerRegistry& registry = trackerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return peaks_;
+}
+
+void MemoryPeakTracker::raise(MemorySubsystem subsystem, uint64_t total) {
+    TrackerRegistry& registry = trackerRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (MemoryPeakTracker* tracker : registry.trackers) {
+        uint64_t& peak = tracker->peaks_[indexOf(subsystem)];
+        peak = std::max(peak, total);
+    }
+}
+
+void setMemoryLimit(uint64_t bytes) {
+    limitBytes.store(bytes);
+}
+
+uint64_t memoryLimit() {
+    return limitBytes.load();
+}
+
+} // namespace core
+} // namespace suzume
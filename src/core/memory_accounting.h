@@ -0,0 +1,150 @@
+/**
+ * @file memory_accounting.h
+ * @brief Process-wide accounting of the memory held by each subsystem, and the memory limit
+ */
+
+#ifndef SUZUME_CORE_MEMORY_ACCOUNTING_H_
+#define SUZUME_CORE_MEMORY_ACCOUNTING_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Large structures whose memory is accounted for
+ */
+enum class MemorySubsystem {
+    Lines,        ///< Input lines held for processing (line vectors, streaming batches)
+    Dedup,        ///< Dedup filters (fingerprint sets, Bloom filters, near-duplicate index)
+    NgramTables,  ///< Exact n-gram counting tables
+    Tries,        ///< Candidate tries of word extraction
+    TextIndex     ///< Suffix arrays over the original text
+};
+
+/// Number of MemorySubsystem values
+constexpr size_t kMemorySubsystems = 5;
+
+/// Bytes per subsystem, indexed by MemorySubsystem
+using SubsystemBytes = std::array<uint64_t, kMemorySubsystems>;
+
+/**
+ * @brief Get the name of a subsystem as reported in MemoryStats
+ * @param subsystem Subsystem
+ * @return const char* Name ("lines", "dedup", "ngram_tables", "tries", "text_index")
+ */
+const char* memorySubsystemName(MemorySubsystem subsystem);
+
+/**
+ * @brief Get the bytes the subsystems hold right now, over all operations
+ * @return SubsystemBytes Current bytes per subsystem
+ */
+SubsystemBytes chargedMemory();
+
+/**
+ * @brief Bytes of one structure charged to a subsystem while it lives
+ *
+ * Structures hold a charge and set() it when they grow or shrink, at the
+ * points where they reallocate anyway; the shared counters are only
+ * touched then. Copies charge the same bytes again and moves hand the
+ * charge over, so the charge follows the structure that owns it.
+ */
+class MemoryCharge {
+public:
+    /**
+     * @brief Constructor
+     * @param subsystem Subsystem the bytes are charged to
+     * @param bytes Bytes charged initially
+     */
+    explicit MemoryCharge(MemorySubsystem subsystem, uint64_t bytes = 0);
+
+    /**
+     * @brief Destructor; releases the charge
+     */
+    ~MemoryCharge();
+
+    MemoryCharge(const MemoryCharge& other);
+    MemoryCharge(MemoryCharge&& other) noexcept;
+    MemoryCharge& operator=(const MemoryCharge& other);
+    MemoryCharge& operator=(MemoryCharge&& other) noexcept;
+
+    /**
+     * @brief Change the bytes charged
+     * @param bytes Bytes the structure holds now
+     */
+    void set(uint64_t bytes);
+
+    /**
+     * @brief Get the bytes charged
+     * @return uint64_t Bytes
+     */
+    uint64_t bytes() const { return bytes_; }
+
+private:
+    MemorySubsystem subsystem_;
+    uint64_t bytes_;
+};
+
+/**
+ * @brief Records the most bytes each subsystem held while it lives
+ *
+ * Every charge that grows a subsystem updates the peaks of the trackers
+ * alive at the time, so short-lived peaks are not missed between samples.
+ */
+class MemoryPeakTracker {
+public:
+    /**
+     * @brief Constructor; starts from the bytes held now
+     */
+    MemoryPeakTracker();
+
+    /**
+     * @brief Destructor; stops tracking
+     */
+    ~MemoryPeakTracker();
+
+    MemoryPeakTracker(const MemoryPeakTracker&) = delete;
+    MemoryPeakTracker& operator=(const MemoryPeakTracker&) = delete;
+
+    /**
+     * @brief Get the peaks so far
+     * @return SubsystemBytes Most bytes held per subsystem since construction
+     */
+    SubsystemBytes peaks() const;
+
+private:
+    friend class MemoryCharge;
+
+    // Raise the peaks of every live tracker to a subsystem's new total
+    static void raise(MemorySubsystem subsystem, uint64_t total);
+
+    SubsystemBytes peaks_;  ///< Guarded by the tracker registry's lock
+};
+
+/**
+ * @brief Set the memory limit operations plan for
+ *
+ * With a limit, each operation picks the modes that keep its largest
+ * structures within a share of it before it starts: normalize streams its
+ * input and, for large inputs, dedups externally; exact PMI counting gets
+ * a table budget (PmiOptions::memoryBudget) and prunes or spills; word
+ * extraction verifies against the text block by block. Explicit options
+ * are kept where they already bound memory more tightly. The setting is
+ * process-wide and read when an operation starts.
+ *
+ * @param bytes Limit in bytes (0 = no limit)
+ */
+void setMemoryLimit(uint64_t bytes);
+
+/**
+ * @brief Get the memory limit
+ * @return uint64_t Limit set with setMemoryLimit(), 0 if none
+ */
+uint64_t memoryLimit();
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_MEMORY_ACCOUNTING_H_
@@ -0,0 +1,279 @@
+/**
+ * @file memory_monitor.cpp
+ * @brief Implementation of memory measurement
+ */
+
+#include "core/memory_monitor.h"
+#include "core/output_writer.h"
+#include "parallel/trace.h"
+#include <algorithm>
+#include <fstream>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#include <unistd.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#include <malloc/malloc.h>
+#elif defined(__linux__)
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+const char* phaseName(ProgressInfo::Phase phase) {
+    switch (phase) {
+        case ProgressInfo::Phase::Reading: return "reading";
+        case ProgressInfo::Phase::Processing: return "processing";
+        case ProgressInfo::Phase::Calculating: return "calculating";
+        case ProgressInfo::Phase::Writing: return "writing";
+        case ProgressInfo::Phase::Complete: return "complete";
+    }
+    return "unknown";
+}
+
+// No phase is tracked yet; any reported phase starts one
+constexpr int kNoTrackedPhase = -1;
+
+uint64_t microsBetween(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point end) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count());
+}
+
+// CPU time over the wall-clock time of all threads
+double utilization(uint64_t cpuMicros, uint64_t wallMicros, uint32_t threads) {
+    return wallMicros > 0 ? static_cast<double>(cpuMicros) / (static_cast<double>(wallMicros) * threads) : 0.0;
+}
+
+} // namespace
+
+uint64_t heapBytesInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    // Small chunks in the arenas plus chunks mapped on their own
+    struct mallinfo2 info = mallinfo2();
+    return static_cast<uint64_t>(info.uordblks) + static_cast<uint64_t>(info.hblkhd);
+#elif defined(__APPLE__)
+    malloc_statistics_t stats;
+    malloc_zone_statistics(nullptr, &stats);
+    return stats.size_in_use;
+#else
+    return 0;
+#endif
+}
+
+uint64_t residentBytes() {
+#if defined(__linux__)
+    // Second field of statm: resident pages
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size = 0;
+    uint64_t resident = 0;
+    if (!(statm >> size >> resident)) {
+        return 0;
+    }
+    return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#elif defined(__APPLE__)
+    mach_task_basic_info info;
+    mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+    if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, reinterpret_cast<task_info_t>(&info), &count) != KERN_SUCCESS) {
+        return 0;
+    }
+    return info.resident_size;
+#else
+    return 0;
+#endif
+}
+
+uint64_t processCpuMicros() {
+#if defined(__linux__) || defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return 0;
+    }
+    auto micros = [](const timeval& time) {
+        return static_cast<uint64_t>(time.tv_sec) * 1000000 + static_cast<uint64_t>(time.tv_usec);
+    };
+    return micros(usage.ru_utime) + micros(usage.ru_stime);
+#else
+    return 0;
+#endif
+}
+
+MemoryMonitor::Snapshot MemoryMonitor::takeSnapshot() const {
+    Snapshot snapshot;
+    snapshot.heap = heapBytesInUse();
+    snapshot.resident = residentBytes();
+    snapshot.time = std::chrono::steady_clock::now();
+    snapshot.cpuMicros = processCpuMicros();
+    snapshot.bytesOut = outputBytesWritten();
+    if (hardwareCounters_) {
+        snapshot.counters = hardwareCounters_->read();
+    }
+    return snapshot;
+}
+
+MemoryMonitor::MemoryMonitor(std::chrono::milliseconds interval)
+    : interval_(interval)
+    , hardwareCounters_(hardwareCountersEnabled() ? std::make_unique<HardwareCounterSet>() : nullptr)
+    , start_(takeSnapshot())
+    , end_(start_)
+    , phaseStart_(start_)
+    , baseHeap_(start_.heap)
+    , stopping_(false)
+    , inPhase_(false)
+    , trackedPhase_(kNoTrackedPhase)
+{
+    sampler_ = std::thread([this]() {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!wake_.wait_for(lock, interval_, [this]() { return stopping_; })) {
+            lock.unlock();
+            sample();
+            lock.lock();
+        }
+    });
+}
+
+MemoryMonitor::~MemoryMonitor() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    if (sampler_.joinable()) {
+        sampler_.join();
+    }
+}
+
+void MemoryMonitor::sample() {
+    // Read outside the lock; the statistics calls take their own locks
+    uint64_t heap = heapBytesInUse();
+    uint64_t resident = residentBytes();
+    uint64_t growth = heap > baseHeap_ ? heap - baseHeap_ : 0;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.peakBytes = std::max(stats_.peakBytes, growth);
+    stats_.peakResidentBytes = std::max(stats_.peakResidentBytes, resident);
+    if (inPhase_) {
+        phase_.peakBytes = std::max(phase_.peakBytes, growth);
+        phase_.peakResidentBytes = std::max(phase_.peakResidentBytes, resident);
+    }
+}
+
+void MemoryMonitor::closePhase(const Snapshot& now) {
+    uint64_t growth = now.heap > baseHeap_ ? now.heap - baseHeap_ : 0;
+    stats_.peakBytes = std::max(stats_.peakBytes, growth);
+    stats_.peakResidentBytes = std::max(stats_.peakResidentBytes, now.resident);
+    if (inPhase_) {
+        phase_.peakBytes = std::max(phase_.peakBytes, growth);
+        phase_.peakResidentBytes = std::max(phase_.peakResidentBytes, now.resident);
+        stats_.phases.push_back(phase_);
+
+        PhaseTime time;
+        time.phase = phase_.phase;
+        time.wallMicros = microsBetween(phaseStart_.time, now.time);
+        time.cpuMicros = now.cpuMicros - std::min(now.cpuMicros, phaseStart_.cpuMicros);
+        time.bytesOut = now.bytesOut - phaseStart_.bytesOut;
+        time.counters = hardwareCountersBetween(phaseStart_.counters, now.counters);
+        phaseTimes_.push_back(time);
+        parallel::traceSpan(phase_.phase, "phase", phaseStart_.time, now.time, true);
+        inPhase_ = false;
+    }
+}
+
+void MemoryMonitor::beginPhase(const std::string& name) {
+    Snapshot now = takeSnapshot();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    closePhase(now);
+    phase_ = PhaseMemory();
+    phase_.phase = name;
+    phaseStart_ = now;
+    inPhase_ = true;
+}
+
+std::function<void(const ProgressInfo&)> MemoryMonitor::track(
+    const std::function<void(const ProgressInfo&)>& progressCallback
+) {
+    return [this, progressCallback](const ProgressInfo& info) {
+        int phase = static_cast<int>(info.phase);
+        int previous = trackedPhase_.load();
+        // Phases only move forward; the thread that moves them starts the next one
+        while (phase > previous && !trackedPhase_.compare_exchange_weak(previous, phase)) {
+        }
+        if (phase > previous) {
+            if (info.phase == ProgressInfo::Phase::Complete) {
+                Snapshot now = takeSnapshot();
+                std::lock_guard<std::mutex> lock(mutex_);
+                closePhase(now);
+            } else {
+                beginPhase(phaseName(info.phase));
+            }
+        }
+        if (progressCallback) {
+            progressCallback(info);
+        }
+    };
+}
+
+MemoryStats MemoryMonitor::finish() {
+    Snapshot now = takeSnapshot();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        closePhase(now);
+        end_ = now;
+    }
+    wake_.notify_all();
+    if (sampler_.joinable()) {
+        sampler_.join();
+    }
+
+    SubsystemBytes peaks = subsystemPeaks_.peaks();
+    stats_.subsystems.clear();
+    for (size_t i = 0; i < kMemorySubsystems; ++i) {
+        SubsystemMemory subsystem;
+        subsystem.subsystem = memorySubsystemName(static_cast<MemorySubsystem>(i));
+        subsystem.peakBytes = peaks[i];
+        stats_.subsystems.push_back(subsystem);
+    }
+    stats_.limitBytes = memoryLimit();
+    return stats_;
+}
+
+MemoryStats MemoryMonitor::finish(OperationMetrics& metrics) {
+    MemoryStats stats = finish();
+
+    const uint32_t threads = std::max(1u, metrics.threads);
+    const uint64_t wallMicros = microsBetween(start_.time, end_.time);
+    const uint64_t cpuMicros = end_.cpuMicros - std::min(end_.cpuMicros, start_.cpuMicros);
+    const double seconds = static_cast<double>(wallMicros) / 1e6;
+    metrics.elapsedMs = wallMicros / 1000;
+    metrics.cpuMs = cpuMicros / 1000;
+    metrics.bytesOut = end_.bytesOut - start_.bytesOut;
+    metrics.linesPerSec = seconds > 0 ? static_cast<double>(metrics.lines) / seconds : 0.0;
+    metrics.mbPerSec = seconds > 0 ? static_cast<double>(metrics.bytesIn) / (1024 * 1024) / seconds : 0.0;
+    metrics.threadUtilization = utilization(cpuMicros, wallMicros, threads);
+    metrics.counters = hardwareCountersBetween(start_.counters, end_.counters);
+
+    metrics.phases.clear();
+    for (const auto& time : phaseTimes_) {
+        PhaseMetrics phase;
+        phase.phase = time.phase;
+        phase.elapsedMs = time.wallMicros / 1000;
+        phase.cpuMs = time.cpuMicros / 1000;
+        phase.bytesOut = time.bytesOut;
+        phase.threadUtilization = utilization(time.cpuMicros, time.wallMicros, threads);
+        phase.counters = time.counters;
+        metrics.phases.push_back(phase);
+    }
+    return stats;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,177 @@
+/**
+ * @file memory_monitor.h
+ * @brief Measured memory and time of an operation, phase by phase
+ */
+
+#ifndef SUZUME_CORE_MEMORY_MONITOR_H_
+#define SUZUME_CORE_MEMORY_MONITOR_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/hardware_counters.h"
+#include "core/memory_accounting.h"
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Get the heap bytes the allocator has handed out and not yet freed
+ *
+ * Read from the allocator's own statistics (mallinfo2 on glibc, the
+ * default zone on macOS), so it includes per-allocation overhead.
+ *
+ * @return uint64_t Bytes in use, or 0 where the allocator gives no statistics
+ */
+uint64_t heapBytesInUse();
+
+/**
+ * @brief Get the resident set size of the process
+ * @return uint64_t Resident bytes, or 0 where the platform gives no figure
+ */
+uint64_t residentBytes();
+
+/**
+ * @brief Get the CPU time all threads of the process have used, user and system
+ * @return uint64_t CPU time in microseconds, or 0 where the platform gives no figure
+ */
+uint64_t processCpuMicros();
+
+/**
+ * @brief Samples memory while an operation runs
+ *
+ * A background thread samples heap bytes in use and the resident set size
+ * at a fixed interval; every phase boundary and finish() sample as well, so
+ * short phases are measured too. Heap figures are relative to the heap in
+ * use when the monitor was created, so they cover what the operation
+ * allocates: tables, tries, text copies and allocator overhead alike.
+ *
+ * Phase boundaries also take the time: wall clock, CPU time of the process
+ * and the bytes output writers have written (outputBytesWritten()), which
+ * finish(OperationMetrics&) turns into per-phase time, throughput and
+ * thread utilization. With hardwareCountersEnabled(), they read the
+ * hardware counters as well, opened when the monitor is created.
+ */
+class MemoryMonitor {
+public:
+    /**
+     * @brief Constructor; starts sampling
+     * @param interval Time between samples
+     */
+    explicit MemoryMonitor(std::chrono::milliseconds interval = std::chrono::milliseconds(10));
+
+    /**
+     * @brief Destructor; stops sampling
+     */
+    ~MemoryMonitor();
+
+    MemoryMonitor(const MemoryMonitor&) = delete;
+    MemoryMonitor& operator=(const MemoryMonitor&) = delete;
+
+    /**
+     * @brief End the current phase, if any, and start a new one
+     * @param name Phase name
+     */
+    void beginPhase(const std::string& name);
+
+    /**
+     * @brief Wrap a progress callback so that phases follow the reported phase
+     *
+     * Each change of ProgressInfo::phase starts a monitor phase named after
+     * it; Complete ends the last phase. The returned callback may be called
+     * from several threads and must not outlive the monitor.
+     *
+     * @param progressCallback Callback to forward to (may be empty)
+     * @return std::function<void(const ProgressInfo&)> Tracking callback
+     */
+    std::function<void(const ProgressInfo&)> track(const std::function<void(const ProgressInfo&)>& progressCallback);
+
+    /**
+     * @brief Stop sampling and return the measurements
+     * @return MemoryStats Peak and per-phase memory
+     */
+    MemoryStats finish();
+
+    /**
+     * @brief Stop sampling, return the memory and fill in the time measurements
+     *
+     * The operation sets bytesIn, lines and threads of the metrics; the
+     * times, output bytes, rates and phases are filled in here.
+     *
+     * @param metrics Metrics of the operation
+     * @return MemoryStats Peak and per-phase memory
+     */
+    MemoryStats finish(OperationMetrics& metrics);
+
+private:
+    /// Counters read together at a phase boundary
+    struct Snapshot {
+        uint64_t heap = 0;
+        uint64_t resident = 0;
+        std::chrono::steady_clock::time_point time;
+        uint64_t cpuMicros = 0;
+        uint64_t bytesOut = 0;
+        HardwareCounters counters;
+    };
+
+    /// Time taken by one closed phase
+    struct PhaseTime {
+        std::string phase;
+        uint64_t wallMicros = 0;
+        uint64_t cpuMicros = 0;
+        uint64_t bytesOut = 0;
+        HardwareCounters counters;
+    };
+
+    Snapshot takeSnapshot() const;
+    void sample();
+    void closePhase(const Snapshot& now);
+
+    std::chrono::milliseconds interval_;
+    std::unique_ptr<HardwareCounterSet> hardwareCounters_;  ///< Null unless enabled; opened before the first snapshot
+    MemoryPeakTracker subsystemPeaks_;
+    Snapshot start_;
+    Snapshot end_;
+    Snapshot phaseStart_;
+    std::vector<PhaseTime> phaseTimes_;
+    uint64_t baseHeap_;
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    MemoryStats stats_;
+    bool inPhase_;
+    PhaseMemory phase_;
+    std::atomic<int> trackedPhase_;
+    std::thread sampler_;
+};
+
+/**
+ * @brief Run an operation under a memory monitor and attach its measurements
+ *
+ * The operation receives the tracking progress callback of the monitor;
+ * its result gets the measurements in Result::memory and Result::metrics.
+ *
+ * @param progressCallback Progress callback of the operation (may be empty)
+ * @param operation Callable taking the tracking callback and returning Result
+ * @return Result Result of the operation with its memory filled in
+ */
+template <typename Result, typename Operation>
+Result measureMemory(const std::function<void(const ProgressInfo&)>& progressCallback, Operation&& operation) {
+    MemoryMonitor monitor;
+    Result result = operation(monitor.track(progressCallback));
+    result.memory = monitor.finish(result.metrics);
+    return result;
+}
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_MEMORY_MONITOR_H_
@@ -0,0 +1,177 @@
+/**
+ * @file near_dedup.cpp
+ * @brief Implementation of SimHash near-duplicate detection
+ */
+
+#include "core/near_dedup.h"
+#include "xxhash.h"
+#include <bitset>
+#include <stdexcept>
+#include <string>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Code points per shingle
+constexpr size_t kShingleSize = 3;
+
+// Initial bucket count per band
+constexpr size_t kInitialBuckets = 1024;
+
+// Finalizer from SplitMix64, spreads band keys over the bucket table
+inline uint64_t mixKey(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+inline uint32_t hammingDistance(uint64_t a, uint64_t b) {
+    return static_cast<uint32_t>(std::bitset<64>(a ^ b).count());
+}
+
+inline void addFeature(const char* data, size_t length, int32_t* weights) {
+    uint64_t hash = XXH64(data, length, 0);
+    for (int bit = 0; bit < 64; ++bit) {
+        weights[bit] += ((hash >> bit) & 1) ? 1 : -1;
+    }
+}
+
+} // namespace
+
+uint64_t computeSimHash(std::string_view text) {
+    int32_t weights[64] = {};
+
+    // Start offsets of the last kShingleSize + 1 code points
+    size_t starts[kShingleSize + 1] = {};
+    size_t codePoints = 0;
+
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        if ((static_cast<unsigned char>(text[pos]) & 0xC0) == 0x80) {
+            continue; // Continuation byte
+        }
+        starts[codePoints % (kShingleSize + 1)] = pos;
+        codePoints++;
+
+        // The code point that just started closes the shingle before it
+        if (codePoints > kShingleSize) {
+            size_t first = starts[(codePoints - 1 - kShingleSize) % (kShingleSize + 1)];
+            addFeature(text.data() + first, pos - first, weights);
+        }
+    }
+
+    if (codePoints >= kShingleSize) {
+        size_t first = starts[(codePoints - kShingleSize) % (kShingleSize + 1)];
+        addFeature(text.data() + first, text.size() - first, weights);
+    } else {
+        addFeature(text.data(), text.size(), weights);
+    }
+
+    uint64_t signature = 0;
+    for (int bit = 0; bit < 64; ++bit) {
+        if (weights[bit] > 0) {
+            signature |= uint64_t{1} << bit;
+        }
+    }
+    return signature;
+}
+
+NearDuplicateFilter::NearDuplicateFilter(uint32_t maxDistance, size_t maxEntries)
+    : maxDistance_(maxDistance)
+    , bandCount_(maxDistance + 1)
+    , bandWidth_(0)
+    , maxEntries_(maxEntries)
+    , bucketMask_(0)
+    , rejected_(0)
+{
+    if (maxDistance == 0 || maxDistance > 31) {
+        throw std::invalid_argument("Invalid near-duplicate distance: " +
+                                   std::to_string(maxDistance) +
+                                   " (must be between 1 and 31)");
+    }
+    bandWidth_ = 64 / bandCount_;
+    rehash(kInitialBuckets);
+}
+
+uint64_t NearDuplicateFilter::bandKey(uint64_t signature, uint32_t band) const {
+    uint32_t start = band * bandWidth_;
+    uint32_t width = (band == bandCount_ - 1) ? 64 - start : bandWidth_;
+    uint64_t bits = width == 64 ? signature : (signature >> start) & ((uint64_t{1} << width) - 1);
+    return mixKey(bits + band * 0x9E3779B97F4A7C15ULL);
+}
+
+bool NearDuplicateFilter::insertSignature(uint64_t signature) {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    // Candidates share at least one band with the signature
+    size_t bucketCount = bucketMask_ + 1;
+    for (uint32_t band = 0; band < bandCount_; ++band) {
+        size_t bucket = static_cast<size_t>(bandKey(signature, band)) & bucketMask_;
+        for (uint32_t entry = heads_[band * bucketCount + bucket]; entry != kNoEntry;
+             entry = next_[static_cast<size_t>(entry) * bandCount_ + band]) {
+            if (hammingDistance(signature, signatures_[entry]) <= maxDistance_) {
+                rejected_++;
+                return false;
+            }
+        }
+    }
+
+    // Past the cap, lines are still checked but no longer indexed
+    if (maxEntries_ != 0 && signatures_.size() >= maxEntries_) {
+        return true;
+    }
+
+    uint32_t entry = static_cast<uint32_t>(signatures_.size());
+    signatures_.push_back(signature);
+    next_.resize(next_.size() + bandCount_);
+    for (uint32_t band = 0; band < bandCount_; ++band) {
+        size_t bucket = static_cast<size_t>(bandKey(signature, band)) & bucketMask_;
+        uint32_t& head = heads_[band * bucketCount + bucket];
+        next_[static_cast<size_t>(entry) * bandCount_ + band] = head;
+        head = entry;
+    }
+
+    // Keep chains short: about one entry per bucket
+    if (signatures_.size() > bucketCount) {
+        rehash(bucketCount * 2);
+    }
+    return true;
+}
+
+void NearDuplicateFilter::rehash(size_t bucketCount) {
+    bucketMask_ = bucketCount - 1;
+    heads_.assign(bandCount_ * bucketCount, kNoEntry);
+    for (uint32_t entry = 0; entry < signatures_.size(); ++entry) {
+        for (uint32_t band = 0; band < bandCount_; ++band) {
+            size_t bucket = static_cast<size_t>(bandKey(signatures_[entry], band)) & bucketMask_;
+            uint32_t& head = heads_[band * bucketCount + bucket];
+            next_[static_cast<size_t>(entry) * bandCount_ + band] = head;
+            head = entry;
+        }
+    }
+    charge_.set(signatures_.capacity() * sizeof(uint64_t) +
+                (heads_.capacity() + next_.capacity()) * sizeof(uint32_t));
+}
+
+size_t NearDuplicateFilter::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return signatures_.size();
+}
+
+uint64_t NearDuplicateFilter::rejected() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return rejected_;
+}
+
+size_t NearDuplicateFilter::memoryUsage() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return signatures_.capacity() * sizeof(uint64_t) +
+           (heads_.capacity() + next_.capacity()) * sizeof(uint32_t);
+}
+
+} // namespace core
+} // namespace suzume
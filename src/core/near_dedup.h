@@ -0,0 +1,110 @@
+/**
+ * @file near_dedup.h
+ * @brief Near-duplicate detection with SimHash signatures and banded LSH
+ */
+
+#ifndef SUZUME_CORE_NEAR_DEDUP_H_
+#define SUZUME_CORE_NEAR_DEDUP_H_
+
+#include <cstdint>
+#include <cstddef>
+#include <mutex>
+#include <string_view>
+#include <vector>
+#include "core/memory_accounting.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Compute a 64-bit SimHash signature of a line
+ *
+ * Features are overlapping 3-code-point shingles hashed with XXH64, so lines
+ * that share most of their text get signatures a few bits apart. Lines
+ * shorter than a shingle use the whole line as their only feature.
+ *
+ * @param text Normalized line
+ * @return uint64_t SimHash signature
+ */
+uint64_t computeSimHash(std::string_view text);
+
+/**
+ * @brief Index of kept lines that rejects near-duplicates
+ *
+ * A line is a near-duplicate when its SimHash differs from a kept line in at
+ * most maxDistance bits. Signatures are split into maxDistance + 1 bands; by
+ * the pigeonhole principle a near-duplicate matches a kept signature exactly
+ * in at least one band, so only lines sharing a band bucket are compared.
+ *
+ * Each kept line costs 8 bytes plus 4 bytes per band. Once maxEntries lines
+ * are indexed, new lines are still checked but no longer added, capping
+ * memory at the price of missing near-duplicates of later lines.
+ *
+ * All methods are thread-safe.
+ */
+class NearDuplicateFilter {
+public:
+    /**
+     * @brief Constructor
+     * @param maxDistance Largest Hamming distance treated as a near-duplicate (1-31)
+     * @param maxEntries Maximum number of indexed lines (0 = unlimited)
+     * @throws std::invalid_argument If maxDistance is out of range
+     */
+    explicit NearDuplicateFilter(uint32_t maxDistance = 3, size_t maxEntries = 0);
+
+    /**
+     * @brief Check a line and index it if it is not a near-duplicate
+     * @param text Normalized line
+     * @return bool True if the line is a near-duplicate of an indexed line
+     */
+    bool isNearDuplicate(std::string_view text) { return !insertSignature(computeSimHash(text)); }
+
+    /**
+     * @brief Check a signature and index it if it is not a near-duplicate
+     * @param signature SimHash signature
+     * @return bool True if no indexed signature is within maxDistance bits
+     */
+    bool insertSignature(uint64_t signature);
+
+    /**
+     * @brief Get number of indexed lines
+     * @return size_t Entry count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get number of lines rejected as near-duplicates
+     * @return uint64_t Rejected count
+     */
+    uint64_t rejected() const;
+
+    /**
+     * @brief Get memory usage of the index
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+private:
+    static constexpr uint32_t kNoEntry = 0xFFFFFFFFu;
+
+    uint64_t bandKey(uint64_t signature, uint32_t band) const;
+    void rehash(size_t bucketCount);
+
+    uint32_t maxDistance_;
+    uint32_t bandCount_;
+    uint32_t bandWidth_;
+    size_t maxEntries_;
+
+    mutable std::mutex mutex_;
+    std::vector<uint64_t> signatures_;
+    std::vector<uint32_t> heads_;   // bandCount_ bucket tables of bucketMask_ + 1 heads
+    std::vector<uint32_t> next_;    // bandCount_ chain links per entry
+    size_t bucketMask_;
+    uint64_t rejected_;
+    MemoryCharge charge_{MemorySubsystem::Dedup};  // Updated when the buckets double
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_NEAR_DEDUP_H_
@@ -5,16 +5,298 @@
 
 #pragma once
 
-#include <unordered_map>
 #include <string>
 #include <vector>
 #include <mutex>
+#include <atomic>
 #include <chrono>
+#include <cstdint>
+#include <memory>
 #include <optional>
+#include <tuple>
+#include "robin_hood.h"
 
 namespace suzume {
 namespace core {
 
+/**
+ * @brief Hash-sharded LRU cache with O(1) lookup, insert and eviction
+ *
+ * Keys are spread over independently locked shards, so threads working on
+ * different keys rarely wait on each other. Each shard keeps its entries in
+ * a flat slot array threaded by an intrusive doubly-linked recency list:
+ * a hit moves its slot to the front, and a full shard reuses the slot at
+ * the back. Nothing is scanned and, once the shard is full, nothing is
+ * allocated.
+ *
+ * @tparam Key Key type (hashable with robin_hood::hash)
+ * @tparam Value Value type
+ */
+template <typename Key, typename Value>
+class ShardedLruCache {
+public:
+    /**
+     * @brief Constructor
+     * @param capacity Maximum number of entries across all shards
+     */
+    explicit ShardedLruCache(size_t capacity) {
+        // Small caches keep one shard so the capacity is exact
+        size_t shardCount = 1;
+        while (shardCount < kMaxShards && capacity / (shardCount * 2) >= kMinShardCapacity) {
+            shardCount *= 2;
+        }
+        shards_ = std::make_unique<Shard[]>(shardCount);
+        shardCount_ = shardCount;
+        for (size_t i = 0; i < shardCount; ++i) {
+            // The first shards take the remainder
+            shards_[i].capacity = capacity / shardCount + (i < capacity % shardCount ? 1 : 0);
+        }
+    }
+
+    /**
+     * @brief Get a copy of the value of a key and mark it most recently used
+     * @param key Key to look up
+     * @return std::optional<Value> Value if cached
+     */
+    std::optional<Value> get(const Key& key) {
+        std::optional<Value> result;
+        visit(key, [&](Value& value) {
+            result = value;
+            return true;
+        });
+        return result;
+    }
+
+    /**
+     * @brief Inspect the cached value of a key under its shard lock
+     *
+     * fn(Value&) may update the value and returns false to drop the entry
+     * (for example when it has expired). A kept entry counts as a hit and
+     * becomes the most recently used; anything else counts as a miss.
+     *
+     * @param key Key to look up
+     * @param fn Visitor returning whether to keep the entry
+     * @return bool True if the key was cached and kept
+     */
+    template <typename Fn>
+    bool visit(const Key& key, Fn&& fn) {
+        Shard& shard = shardOf(key);
+        bool kept = false;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            auto it = shard.index.find(key);
+            if (it != shard.index.end()) {
+                uint32_t slot = it->second;
+                if (fn(shard.slots[slot].value)) {
+                    shard.moveToFront(slot);
+                    kept = true;
+                } else {
+                    shard.index.erase(it);
+                    shard.release(slot);
+                }
+            }
+        }
+        (kept ? hits_ : misses_).fetch_add(1, std::memory_order_relaxed);
+        return kept;
+    }
+
+    /**
+     * @brief Insert or replace the value of a key
+     *
+     * The least recently used entry of the key's shard is evicted when the
+     * shard is full.
+     *
+     * @param key Key
+     * @param value Value
+     */
+    void put(const Key& key, Value value) {
+        Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        if (shard.capacity == 0) {
+            return;
+        }
+        auto it = shard.index.find(key);
+        if (it != shard.index.end()) {
+            shard.slots[it->second].value = std::move(value);
+            shard.moveToFront(it->second);
+            return;
+        }
+        if (shard.index.size() >= shard.capacity) {
+            uint32_t victim = shard.tail;
+            shard.index.erase(shard.slots[victim].key);
+            shard.release(victim);
+        }
+        uint32_t slot = shard.acquire(key, std::move(value));
+        shard.index.emplace(key, slot);
+    }
+
+    /**
+     * @brief Get the cached value of a key, computing and caching it on a miss
+     *
+     * The value is computed outside the shard lock, so a slow computation
+     * does not block other keys of the shard.
+     *
+     * @param key Key
+     * @param compute Function returning the value
+     * @return Value Cached or computed value
+     */
+    template <typename Compute>
+    Value getOrCompute(const Key& key, Compute&& compute) {
+        if (std::optional<Value> cached = get(key)) {
+            return *cached;
+        }
+        Value value = compute();
+        put(key, value);
+        return value;
+    }
+
+    /**
+     * @brief Check whether a key is cached, without counting or touching it
+     * @param key Key to look up
+     * @return bool True if cached
+     */
+    bool contains(const Key& key) const {
+        const Shard& shard = shardOf(key);
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        return shard.index.find(key) != shard.index.end();
+    }
+
+    /**
+     * @brief Remove every entry for which pred(const Value&) is true
+     * @param pred Predicate
+     * @return size_t Number of entries removed
+     */
+    template <typename Pred>
+    size_t removeIf(Pred&& pred) {
+        size_t removed = 0;
+        for (size_t i = 0; i < shardCount_; ++i) {
+            Shard& shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            uint32_t slot = shard.head;
+            while (slot != kNone) {
+                uint32_t next = shard.slots[slot].next;
+                if (pred(static_cast<const Value&>(shard.slots[slot].value))) {
+                    shard.index.erase(shard.slots[slot].key);
+                    shard.release(slot);
+                    removed++;
+                }
+                slot = next;
+            }
+        }
+        return removed;
+    }
+
+    /**
+     * @brief Remove all entries and reset the statistics
+     */
+    void clear() {
+        for (size_t i = 0; i < shardCount_; ++i) {
+            Shard& shard = shards_[i];
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            shard.index.clear();
+            shard.slots.clear();
+            shard.freeSlots.clear();
+            shard.head = kNone;
+            shard.tail = kNone;
+        }
+        hits_.store(0, std::memory_order_relaxed);
+        misses_.store(0, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Get the number of cached entries
+     * @return size_t Entry count
+     */
+    size_t size() const {
+        size_t total = 0;
+        for (size_t i = 0; i < shardCount_; ++i) {
+            std::lock_guard<std::mutex> lock(shards_[i].mutex);
+            total += shards_[i].index.size();
+        }
+        return total;
+    }
+
+    size_t hits() const { return hits_.load(std::memory_order_relaxed); }
+    size_t misses() const { return misses_.load(std::memory_order_relaxed); }
+    size_t shardCount() const { return shardCount_; }
+
+private:
+    static constexpr uint32_t kNone = UINT32_MAX;
+    static constexpr size_t kMaxShards = 16;
+    static constexpr size_t kMinShardCapacity = 256;
+
+    struct Slot {
+        Key key;
+        Value value;
+        uint32_t prev;
+        uint32_t next;
+    };
+
+    struct Shard {
+        mutable std::mutex mutex;
+        robin_hood::unordered_flat_map<Key, uint32_t> index;
+        std::vector<Slot> slots;
+        std::vector<uint32_t> freeSlots;
+        uint32_t head = kNone;
+        uint32_t tail = kNone;
+        size_t capacity = 0;
+
+        void unlink(uint32_t slot) {
+            Slot& s = slots[slot];
+            (s.prev == kNone ? head : slots[s.prev].next) = s.next;
+            (s.next == kNone ? tail : slots[s.next].prev) = s.prev;
+        }
+
+        void pushFront(uint32_t slot) {
+            slots[slot].prev = kNone;
+            slots[slot].next = head;
+            (head == kNone ? tail : slots[head].prev) = slot;
+            head = slot;
+        }
+
+        void moveToFront(uint32_t slot) {
+            if (slot != head) {
+                unlink(slot);
+                pushFront(slot);
+            }
+        }
+
+        uint32_t acquire(const Key& key, Value value) {
+            uint32_t slot;
+            if (!freeSlots.empty()) {
+                slot = freeSlots.back();
+                freeSlots.pop_back();
+                slots[slot].key = key;
+                slots[slot].value = std::move(value);
+            } else {
+                slot = static_cast<uint32_t>(slots.size());
+                slots.push_back({key, std::move(value), kNone, kNone});
+            }
+            pushFront(slot);
+            return slot;
+        }
+
+        void release(uint32_t slot) {
+            unlink(slot);
+            freeSlots.push_back(slot);
+        }
+    };
+
+    size_t shardIndex(const Key& key) const {
+        // Top bits of a remixed hash, independent of the bits the index uses
+        uint64_t hash = static_cast<uint64_t>(robin_hood::hash<Key>{}(key)) * 0x9E3779B97F4A7C15ULL;
+        return static_cast<size_t>(hash >> 32) & (shardCount_ - 1);
+    }
+
+    Shard& shardOf(const Key& key) { return shards_[shardIndex(key)]; }
+    const Shard& shardOf(const Key& key) const { return shards_[shardIndex(key)]; }
+
+    std::unique_ptr<Shard[]> shards_;
+    size_t shardCount_ = 1;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
 /**
  * @brief Cache entry for N-gram data
  */
@@ -22,18 +304,19 @@ struct NGramCacheEntry {
     double score;
     uint32_t frequency;
     std::chrono::steady_clock::time_point lastAccess;
-    
+
     NGramCacheEntry() : score(0.0), frequency(0), lastAccess(std::chrono::steady_clock::now()) {}
-    
-    NGramCacheEntry(double s, uint32_t f) 
+
+    NGramCacheEntry(double s, uint32_t f)
         : score(s), frequency(f), lastAccess(std::chrono::steady_clock::now()) {}
 };
 
 /**
  * @brief High-performance LRU cache for N-gram processing
- * 
+ *
  * This class provides efficient caching of N-gram computation results,
  * reducing redundant calculations and improving overall performance.
+ * Entries expire ttlMinutes after their last access.
  */
 class NGramCache {
 public:
@@ -43,14 +326,14 @@ public:
      * @param ttlMinutes Time-to-live for cache entries in minutes
      */
     explicit NGramCache(size_t maxSize = 10000, int ttlMinutes = 30);
-    
+
     /**
      * @brief Get cached entry for N-gram
      * @param ngram N-gram text
      * @return Optional cache entry if found and valid
      */
     std::optional<NGramCacheEntry> get(const std::string& ngram);
-    
+
     /**
      * @brief Put entry into cache
      * @param ngram N-gram text
@@ -58,56 +341,46 @@ public:
      * @param frequency Frequency count
      */
     void put(const std::string& ngram, double score, uint32_t frequency);
-    
+
     /**
      * @brief Clear all cache entries
      */
     void clear();
-    
+
     /**
      * @brief Get cache statistics
      * @return Tuple of (hits, misses, total_entries)
      */
     std::tuple<size_t, size_t, size_t> getStats() const;
-    
+
     /**
      * @brief Get cache hit rate
      * @return Hit rate as percentage (0.0 to 1.0)
      */
     double getHitRate() const;
-    
+
     /**
      * @brief Remove expired entries
      * @return Number of entries removed
      */
     size_t cleanupExpired();
-    
+
 private:
-    /**
-     * @brief Remove least recently used entry
-     */
-    void evictLRU();
-    
     /**
      * @brief Check if entry is expired
      * @param entry Cache entry to check
+     * @param now Current time
      * @return True if expired
      */
-    bool isExpired(const NGramCacheEntry& entry) const;
-    
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, NGramCacheEntry> cache_;
-    size_t maxSize_;
+    bool isExpired(const NGramCacheEntry& entry, std::chrono::steady_clock::time_point now) const;
+
+    ShardedLruCache<std::string, NGramCacheEntry> cache_;
     std::chrono::minutes ttl_;
-    
-    // Statistics
-    mutable size_t hits_;
-    mutable size_t misses_;
 };
 
 /**
  * @brief Thread-safe N-gram computation cache
- * 
+ *
  * Provides optimized caching specifically for PMI calculations
  * with automatic cleanup and performance monitoring.
  */
@@ -118,39 +391,40 @@ public:
      * @param cacheSize Maximum cache size
      */
     explicit PMICache(size_t cacheSize = 50000);
-    
+
     /**
      * @brief Get or compute PMI value
+     *
+     * The value is computed without holding any lock; two threads missing
+     * the same N-gram at once may both compute it.
+     *
      * @param ngram N-gram text
      * @param computeFunc Function to compute PMI if not cached
      * @return PMI score
      */
     template<typename ComputeFunc>
     double getOrCompute(const std::string& ngram, ComputeFunc&& computeFunc) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
-        auto it = pmiCache_.find(ngram);
-        if (it != pmiCache_.end() && !isExpired(it->second)) {
+        double pmi = 0.0;
+        auto now = std::chrono::steady_clock::now();
+        bool cached = cache_.visit(ngram, [&](NGramCacheEntry& entry) {
+            if (isExpired(entry, now)) {
+                return false;
+            }
             // Update access time
-            it->second.lastAccess = std::chrono::steady_clock::now();
-            hits_++;
-            return it->second.score;
+            entry.lastAccess = now;
+            pmi = entry.score;
+            return true;
+        });
+        if (cached) {
+            return pmi;
         }
-        
+
         // Compute new value
-        double pmi = computeFunc();
-        
-        // Store in cache
-        if (pmiCache_.size() >= maxSize_) {
-            evictLRU();
-        }
-        
-        pmiCache_[ngram] = NGramCacheEntry(pmi, 1); // Frequency not used for PMI cache
-        misses_++;
-        
+        pmi = computeFunc();
+        cache_.put(ngram, NGramCacheEntry(pmi, 1)); // Frequency not used for PMI cache
         return pmi;
     }
-    
+
     /**
      * @brief Preload cache with common N-grams
      * @param ngrams Vector of N-grams to preload
@@ -158,41 +432,29 @@ public:
      */
     template<typename ComputeFunc>
     void preload(const std::vector<std::string>& ngrams, ComputeFunc&& computeFunc) {
-        std::lock_guard<std::mutex> lock(mutex_);
-        
         for (const auto& ngram : ngrams) {
-            if (pmiCache_.find(ngram) == pmiCache_.end()) {
-                double pmi = computeFunc(ngram);
-                if (pmiCache_.size() >= maxSize_) {
-                    evictLRU();
-                }
-                pmiCache_[ngram] = NGramCacheEntry(pmi, 1);
+            if (!cache_.contains(ngram)) {
+                cache_.put(ngram, NGramCacheEntry(computeFunc(ngram), 1));
             }
         }
     }
-    
+
     /**
      * @brief Get cache statistics
      */
     std::tuple<size_t, size_t, size_t> getStats() const;
-    
+
     /**
      * @brief Clear cache
      */
     void clear();
-    
+
 private:
-    void evictLRU();
-    bool isExpired(const NGramCacheEntry& entry) const;
-    
-    mutable std::mutex mutex_;
-    std::unordered_map<std::string, NGramCacheEntry> pmiCache_;
-    size_t maxSize_;
+    bool isExpired(const NGramCacheEntry& entry, std::chrono::steady_clock::time_point now) const;
+
+    ShardedLruCache<std::string, NGramCacheEntry> cache_;
     std::chrono::minutes ttl_;
-    
-    mutable size_t hits_;
-    mutable size_t misses_;
 };
 
 } // namespace core
-} // namespace suzume
\ No newline at end of file
+} // namespace suzume
@@ -0,0 +1,390 @@
+/**
+ * @file ngram_snapshot.cpp
+ * @brief Implementation of binary n-gram count snapshots
+ */
+
+#include "core/ngram_snapshot.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+constexpr char kSnapshotMagic[8] = {'S', 'Z', 'N', 'G', 'S', 'N', 'P', '1'};
+constexpr uint32_t kSnapshotVersion = 2;
+
+// Version 1 headers end after the index entries
+constexpr size_t kSnapshotHeaderSizeV1 = 48;
+
+// Data is written out in blocks of about this size
+constexpr size_t kWriteBlockSize = 1 << 20;
+
+void appendUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendUint64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendVarint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(static_cast<char>(value));
+}
+
+bool readVarint(std::string_view data, size_t& pos, uint64_t& value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (pos >= data.size()) {
+            return false;
+        }
+        uint8_t byte = static_cast<uint8_t>(data[pos++]);
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string withSuffix(const std::string& basePath, const std::string& suffix) {
+    std::filesystem::path path(basePath);
+    std::string name = path.stem().string() + "." + suffix + path.extension().string();
+    return (path.parent_path() / name).string();
+}
+
+} // namespace
+
+SnapshotWriter::SnapshotWriter(const std::string& path, uint32_t n, uint32_t partition, uint32_t partitionCount)
+    : path_(path)
+    , n_(n)
+    , partition_(partition)
+    , partitionCount_(partitionCount)
+    , entries_(0)
+    , total_(0)
+    , orderTotal_(0)
+    , offset_(0)
+    , lastKey_(0)
+    , hasOrderTotal_(false)
+    , finished_(false)
+{
+    if (partitionCount < 1 || partition >= partitionCount) {
+        throw std::invalid_argument("Invalid snapshot partition: " + std::to_string(partition) + " of " +
+                                    std::to_string(partitionCount));
+    }
+    std::filesystem::path filePath(path);
+    if (!filePath.parent_path().empty()) {
+        std::filesystem::create_directories(filePath.parent_path());
+    }
+    out_.open(path, std::ios::binary | std::ios::trunc);
+    if (!out_) {
+        throw std::runtime_error("Failed to create snapshot: " + path);
+    }
+    // The header is written by finish(); zeros keep an unfinished file invalid
+    buffer_.assign(kSnapshotHeaderSize, '\0');
+    buffer_.reserve(kWriteBlockSize + 32);
+}
+
+void SnapshotWriter::add(uint64_t key, uint64_t count) {
+    if (entries_ > 0 && key <= lastKey_) {
+        throw std::invalid_argument("Snapshot keys must be strictly ascending");
+    }
+
+    // Index points restart the deltas so they can be decoded on their own
+    uint64_t previous = lastKey_;
+    if (entries_ % kSnapshotIndexInterval == 0) {
+        index_.emplace_back(key, offset_ + buffer_.size());
+        previous = 0;
+    }
+    appendVarint(buffer_, key - previous);
+    appendVarint(buffer_, count);
+
+    lastKey_ = key;
+    entries_++;
+    total_ += count;
+    if (buffer_.size() >= kWriteBlockSize) {
+        flush();
+    }
+}
+
+void SnapshotWriter::setOrderTotal(uint64_t orderTotal) {
+    orderTotal_ = orderTotal;
+    hasOrderTotal_ = true;
+}
+
+void SnapshotWriter::flush() {
+    out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+    offset_ += buffer_.size();
+    buffer_.clear();
+}
+
+void SnapshotWriter::finish() {
+    if (finished_) {
+        return;
+    }
+    flush();
+
+    uint64_t indexOffset = offset_;
+    std::string tail;
+    for (const auto& [key, offset] : index_) {
+        appendUint64(tail, key);
+        appendUint64(tail, offset);
+    }
+    out_.write(tail.data(), static_cast<std::streamsize>(tail.size()));
+
+    std::string header(kSnapshotMagic, sizeof(kSnapshotMagic));
+    appendUint32(header, kSnapshotVersion);
+    appendUint32(header, n_);
+    appendUint64(header, entries_);
+    appendUint64(header, total_);
+    appendUint64(header, indexOffset);
+    appendUint64(header, index_.size());
+    appendUint32(header, partition_);
+    appendUint32(header, partitionCount_);
+    appendUint64(header, hasOrderTotal_ ? orderTotal_ : total_);
+    out_.seekp(0);
+    out_.write(header.data(), static_cast<std::streamsize>(header.size()));
+    out_.close();
+    if (!out_) {
+        throw std::runtime_error("Failed to write snapshot: " + path_);
+    }
+    finished_ = true;
+}
+
+SnapshotReader::SnapshotReader(const std::string& path)
+    : path_(path)
+    , headerSize_(kSnapshotHeaderSize)
+    , n_(0)
+    , partition_(0)
+    , partitionCount_(1)
+    , entries_(0)
+    , total_(0)
+    , orderTotal_(0)
+    , indexOffset_(0)
+    , indexEntries_(0)
+    , pos_(kSnapshotHeaderSize)
+    , decoded_(0)
+    , previous_(0)
+{
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Snapshot does not exist: " + path);
+    }
+    mapping_ = std::make_unique<MemoryMappedProcessor>(path);
+    if (mapping_->isMapped()) {
+        data_ = std::string_view(mapping_->data(), mapping_->getFileSize());
+    } else {
+        mapping_.reset();
+        std::ifstream in(path, std::ios::binary);
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_;
+    }
+
+    if (data_.size() < kSnapshotHeaderSizeV1 || std::memcmp(data_.data(), kSnapshotMagic, sizeof(kSnapshotMagic)) != 0) {
+        throw std::runtime_error("Not an n-gram snapshot: " + path);
+    }
+    uint64_t versionAndN = readUint64(8);
+    uint32_t version = static_cast<uint32_t>(versionAndN);
+    if (version != 1 && version != kSnapshotVersion) {
+        throw std::runtime_error("Unsupported snapshot version in " + path);
+    }
+    n_ = static_cast<uint32_t>(versionAndN >> 32);
+    entries_ = readUint64(16);
+    total_ = readUint64(24);
+    indexOffset_ = readUint64(32);
+    indexEntries_ = readUint64(40);
+    orderTotal_ = total_;
+    if (version == 1) {
+        headerSize_ = kSnapshotHeaderSizeV1;
+    } else {
+        if (data_.size() < kSnapshotHeaderSize) {
+            throw std::runtime_error("Corrupt n-gram snapshot: " + path);
+        }
+        uint64_t partitioning = readUint64(48);
+        partition_ = static_cast<uint32_t>(partitioning);
+        partitionCount_ = static_cast<uint32_t>(partitioning >> 32);
+        orderTotal_ = readUint64(56);
+    }
+    pos_ = headerSize_;
+    if (n_ < 1 || n_ > PackedNgramCounter::kMaxN || indexOffset_ < headerSize_ ||
+        indexOffset_ > data_.size() || (data_.size() - indexOffset_) / 16 < indexEntries_ ||
+        partitionCount_ < 1 || partition_ >= partitionCount_) {
+        throw std::runtime_error("Corrupt n-gram snapshot: " + path);
+    }
+}
+
+uint64_t SnapshotReader::readUint64(size_t offset) const {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(data_[offset + i]);
+    }
+    return value;
+}
+
+bool SnapshotReader::decode(
+    size_t& pos,
+    uint64_t& key,
+    uint64_t& count,
+    uint64_t& decoded,
+    uint64_t& previous
+) const {
+    if (decoded >= entries_) {
+        return false;
+    }
+    std::string_view data = data_.substr(0, indexOffset_);
+    uint64_t delta = 0;
+    if (!readVarint(data, pos, delta) || !readVarint(data, pos, count)) {
+        throw std::runtime_error("Corrupt n-gram snapshot: " + path_);
+    }
+    if (decoded % kSnapshotIndexInterval == 0) {
+        previous = 0;
+    }
+    key = previous + delta;
+    previous = key;
+    decoded++;
+    return true;
+}
+
+bool SnapshotReader::next(uint64_t& key, uint64_t& count) {
+    return decode(pos_, key, count, decoded_, previous_);
+}
+
+void SnapshotReader::rewind() {
+    pos_ = headerSize_;
+    decoded_ = 0;
+    previous_ = 0;
+}
+
+uint64_t SnapshotReader::count(uint64_t key) const {
+    // Find the last index point at or before the key
+    size_t lo = 0;
+    size_t hi = static_cast<size_t>(indexEntries_);
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (readUint64(indexOffset_ + mid * 16) <= key) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    if (lo == 0) {
+        return 0;
+    }
+
+    size_t block = lo - 1;
+    size_t pos = static_cast<size_t>(readUint64(indexOffset_ + block * 16 + 8));
+    uint64_t decoded = block * kSnapshotIndexInterval;
+    uint64_t previous = 0;
+    uint64_t entryKey = 0;
+    uint64_t entryCount = 0;
+    for (uint64_t i = 0; i < kSnapshotIndexInterval && decode(pos, entryKey, entryCount, decoded, previous); ++i) {
+        if (entryKey == key) {
+            return entryCount;
+        }
+        if (entryKey > key) {
+            break;
+        }
+    }
+    return 0;
+}
+
+bool isSnapshotFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kSnapshotMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kSnapshotMagic, sizeof(magic)) == 0;
+}
+
+void writeSnapshot(const std::string& path, const PartitionedNgramCounter& counts) {
+    std::vector<std::pair<uint64_t, uint32_t>> entries;
+    entries.reserve(counts.size());
+    counts.forEach([&](uint64_t key, uint32_t count) { entries.emplace_back(key, count); });
+    std::sort(entries.begin(), entries.end());
+
+    SnapshotWriter writer(path, counts.n());
+    for (const auto& [key, count] : entries) {
+        writer.add(key, count);
+    }
+    writer.finish();
+}
+
+std::string partitionSnapshotPath(const std::string& basePath, uint32_t partition, uint32_t partitionCount) {
+    return withSuffix(basePath, "part-" + std::to_string(partition) + "-of-" + std::to_string(partitionCount));
+}
+
+std::string marginalSnapshotPath(const std::string& basePath) {
+    return withSuffix(basePath, "marginals");
+}
+
+void writePartitionedSnapshots(
+    const std::string& basePath,
+    const PartitionedNgramCounter& counts,
+    const PartitionedNgramCounter& unigrams,
+    uint32_t partitionCount
+) {
+    if (partitionCount < 1) {
+        throw std::invalid_argument("Snapshot partition count must be at least 1");
+    }
+    if (unigrams.n() != 1) {
+        throw std::invalid_argument("Marginal counts must be unigrams");
+    }
+
+    std::vector<std::vector<std::pair<uint64_t, uint32_t>>> partitions(partitionCount);
+    uint64_t orderTotal = 0;
+    counts.forEach([&](uint64_t key, uint32_t count) {
+        partitions[PartitionedNgramCounter::partitionIndex(key, partitionCount)].emplace_back(key, count);
+        orderTotal += count;
+    });
+
+    for (uint32_t i = 0; i < partitionCount; ++i) {
+        auto& entries = partitions[i];
+        std::sort(entries.begin(), entries.end());
+        SnapshotWriter writer(partitionSnapshotPath(basePath, i, partitionCount), counts.n(), i, partitionCount);
+        for (const auto& [key, count] : entries) {
+            writer.add(key, count);
+        }
+        writer.setOrderTotal(orderTotal);
+        writer.finish();
+        // Release each partition once it is on disk
+        std::vector<std::pair<uint64_t, uint32_t>>().swap(entries);
+    }
+
+    std::vector<std::pair<uint64_t, uint32_t>> marginals;
+    marginals.reserve(unigrams.size());
+    unigrams.forEach([&](uint64_t key, uint32_t count) { marginals.emplace_back(key, count); });
+    std::sort(marginals.begin(), marginals.end());
+    SnapshotWriter writer(marginalSnapshotPath(basePath), 1);
+    for (const auto& [key, count] : marginals) {
+        writer.add(key, count);
+    }
+    writer.setOrderTotal(orderTotal);
+    writer.finish();
+}
+
+uint64_t mergeSnapshots(const std::vector<std::string>& inputPaths, const std::string& outputPath) {
+    if (inputPaths.empty()) {
+        throw std::invalid_argument("No snapshots to merge");
+    }
+    std::vector<SnapshotReader> readers;
+    readers.reserve(inputPaths.size());
+    for (const auto& path : inputPaths) {
+        readers.emplace_back(path);
+    }
+
+    SnapshotWriter writer(outputPath, readers.front().n());
+    forEachMergedEntry(readers, [&](uint64_t key, uint64_t count) { writer.add(key, count); });
+    writer.finish();
+    return writer.entries();
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,305 @@
+/**
+ * @file ngram_snapshot.h
+ * @brief Binary snapshots of packed n-gram counts and their k-way merge
+ */
+
+#ifndef SUZUME_CORE_NGRAM_SNAPSHOT_H_
+#define SUZUME_CORE_NGRAM_SNAPSHOT_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <queue>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "core/streaming_processor.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * Snapshot layout (all integers little-endian):
+ *
+ *   header   "SZNGSNP1", uint32 version, uint32 n, uint64 entries,
+ *            uint64 total count, uint64 index offset, uint64 index entries,
+ *            uint32 partition, uint32 partition count, uint64 order total
+ *   data     per entry: varint key delta, varint count; keys ascending
+ *   index    every kSnapshotIndexInterval-th entry: uint64 key, uint64 offset
+ *
+ * The key of every indexed entry is stored in full (delta from 0), so a
+ * mapped snapshot can be searched through the index and decoded from any
+ * index point without reading what comes before it.
+ *
+ * A snapshot may hold one hash partition of the keys (see
+ * PartitionedNgramCounter::partitionIndex()). The order total is the count
+ * of the n-gram order over all partitions written by the same run; in a
+ * marginals snapshot (unigram counts written next to partitions) it is the
+ * order total of those partitions. Version 1 files end the header after the
+ * index entries and are read as a single partition.
+ */
+constexpr size_t kSnapshotHeaderSize = 64;
+constexpr uint64_t kSnapshotIndexInterval = 1024;
+
+/**
+ * @brief Writes a snapshot from keys given in ascending order
+ */
+class SnapshotWriter {
+public:
+    /**
+     * @brief Constructor
+     * @param path Output file path
+     * @param n N-gram size of the keys
+     * @param partition Hash partition of the keys
+     * @param partitionCount Number of hash partitions (1 = all keys)
+     * @throws std::invalid_argument If the partition is out of range
+     * @throws std::runtime_error If the file cannot be created
+     */
+    SnapshotWriter(const std::string& path, uint32_t n, uint32_t partition = 0, uint32_t partitionCount = 1);
+
+    /**
+     * @brief Append an entry
+     * @param key Packed n-gram, greater than the previous key
+     * @param count Occurrences (at least 1)
+     * @throws std::invalid_argument If keys are not ascending
+     */
+    void add(uint64_t key, uint64_t count);
+
+    /**
+     * @brief Set the order total recorded in the header
+     * @param orderTotal Count of the order over all partitions (default: total())
+     */
+    void setOrderTotal(uint64_t orderTotal);
+
+    /**
+     * @brief Write the index and header and close the file
+     *
+     * A snapshot that is never finished has no valid header and is rejected
+     * by SnapshotReader.
+     *
+     * @throws std::runtime_error If writing fails
+     */
+    void finish();
+
+    uint64_t entries() const { return entries_; }
+    uint64_t total() const { return total_; }
+
+private:
+    void flush();
+
+    std::string path_;
+    std::ofstream out_;
+    std::string buffer_;
+    std::vector<std::pair<uint64_t, uint64_t>> index_;
+    uint32_t n_;
+    uint32_t partition_;
+    uint32_t partitionCount_;
+    uint64_t entries_;
+    uint64_t total_;
+    uint64_t orderTotal_;
+    uint64_t offset_;
+    uint64_t lastKey_;
+    bool hasOrderTotal_;
+    bool finished_;
+};
+
+/**
+ * @brief Reads a snapshot through a memory mapping
+ */
+class SnapshotReader {
+public:
+    /**
+     * @brief Constructor
+     * @param path Snapshot path
+     * @throws std::runtime_error If the file is missing or not a valid snapshot
+     */
+    explicit SnapshotReader(const std::string& path);
+
+    /**
+     * @brief Decode the next entry
+     * @param key Receives the packed n-gram
+     * @param count Receives its count
+     * @return bool False at the end of the data
+     * @throws std::runtime_error If the data is corrupt
+     */
+    bool next(uint64_t& key, uint64_t& count);
+
+    /**
+     * @brief Restart from the first entry
+     */
+    void rewind();
+
+    /**
+     * @brief Look up the count of one key through the index
+     * @param key Packed n-gram
+     * @return uint64_t Count (0 if absent)
+     */
+    uint64_t count(uint64_t key) const;
+
+    const std::string& path() const { return path_; }
+    uint32_t n() const { return n_; }
+    uint64_t entries() const { return entries_; }
+    uint64_t total() const { return total_; }
+    uint32_t partition() const { return partition_; }
+    uint32_t partitionCount() const { return partitionCount_; }
+    uint64_t orderTotal() const { return orderTotal_; }
+
+    /**
+     * @brief Get the snapshot size
+     * @return size_t File size in bytes
+     */
+    size_t fileSize() const { return data_.size(); }
+
+private:
+    bool decode(size_t& pos, uint64_t& key, uint64_t& count, uint64_t& decoded, uint64_t& previous) const;
+    uint64_t readUint64(size_t offset) const;
+
+    std::string path_;
+    std::unique_ptr<MemoryMappedProcessor> mapping_;
+    std::string buffer_;
+    std::string_view data_;
+    size_t headerSize_;
+    uint32_t n_;
+    uint32_t partition_;
+    uint32_t partitionCount_;
+    uint64_t entries_;
+    uint64_t total_;
+    uint64_t orderTotal_;
+    uint64_t indexOffset_;
+    uint64_t indexEntries_;
+    size_t pos_;
+    uint64_t decoded_;
+    uint64_t previous_;
+};
+
+/**
+ * @brief Check whether a file starts with the snapshot magic
+ * @param path File path
+ * @return bool True for snapshot files
+ */
+bool isSnapshotFile(const std::string& path);
+
+/**
+ * @brief Write the counts of a table as a snapshot
+ * @param path Output file path
+ * @param counts N-gram counts
+ * @throws std::runtime_error If the file cannot be written
+ */
+void writeSnapshot(const std::string& path, const PartitionedNgramCounter& counts);
+
+/**
+ * @brief Path of one hash partition of a snapshot
+ *
+ * "counts.snap" becomes "counts.part-3-of-8.snap".
+ *
+ * @param basePath Snapshot path given by the caller
+ * @param partition Partition index
+ * @param partitionCount Number of partitions
+ * @return std::string Partition snapshot path
+ */
+std::string partitionSnapshotPath(const std::string& basePath, uint32_t partition, uint32_t partitionCount);
+
+/**
+ * @brief Path of the marginals written next to partition snapshots
+ *
+ * "counts.snap" becomes "counts.marginals.snap".
+ *
+ * @param basePath Snapshot path given by the caller
+ * @return std::string Marginals snapshot path
+ */
+std::string marginalSnapshotPath(const std::string& basePath);
+
+/**
+ * @brief Write counts split into hash partitions, plus their marginals
+ *
+ * Partition i holds the keys with PartitionedNgramCounter::partitionIndex()
+ * equal to i, so partition i of every machine's counts can be reduced on
+ * its own. The unigram counts go to marginalSnapshotPath() with the order
+ * total of the counts, which is all a reducer needs besides its partition.
+ *
+ * @param basePath Snapshot path (see partitionSnapshotPath())
+ * @param counts N-gram counts
+ * @param unigrams Unigram counts of the same text
+ * @param partitionCount Number of partitions (at least 1)
+ * @throws std::invalid_argument If partitionCount is 0 or unigrams are not unigrams
+ * @throws std::runtime_error If a file cannot be written
+ */
+void writePartitionedSnapshots(
+    const std::string& basePath,
+    const PartitionedNgramCounter& counts,
+    const PartitionedNgramCounter& unigrams,
+    uint32_t partitionCount
+);
+
+/**
+ * @brief Call fn(key, count) for every key of several snapshots, summed, in key order
+ *
+ * A k-way merge over the readers: each key is visited once with the sum of
+ * its counts, and only one entry per reader is held at a time.
+ *
+ * @param readers Snapshots with the same n (rewound first)
+ * @param fn Visitor taking a uint64_t key and a uint64_t count
+ * @throws std::invalid_argument If the readers are empty or their n differ
+ */
+template <typename Fn>
+void forEachMergedEntry(std::vector<SnapshotReader>& readers, Fn&& fn);
+
+/**
+ * @brief Merge snapshots into one
+ * @param inputPaths Snapshots to merge
+ * @param outputPath Merged snapshot path
+ * @return uint64_t Number of entries written
+ * @throws std::invalid_argument If the inputs are empty or their n differ
+ * @throws std::runtime_error If a snapshot cannot be read or written
+ */
+uint64_t mergeSnapshots(const std::vector<std::string>& inputPaths, const std::string& outputPath);
+
+template <typename Fn>
+void forEachMergedEntry(std::vector<SnapshotReader>& readers, Fn&& fn) {
+    if (readers.empty()) {
+        throw std::invalid_argument("No snapshots to merge");
+    }
+    for (auto& reader : readers) {
+        if (reader.n() != readers.front().n()) {
+            throw std::invalid_argument("Cannot merge snapshots of different n-gram sizes: " + reader.path());
+        }
+        reader.rewind();
+    }
+
+    // Smallest key on top; each reader has at most one entry queued
+    struct Head {
+        uint64_t key;
+        uint64_t count;
+        size_t reader;
+        bool operator>(const Head& other) const { return key > other.key; }
+    };
+    std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+    for (size_t i = 0; i < readers.size(); ++i) {
+        Head head{0, 0, i};
+        if (readers[i].next(head.key, head.count)) {
+            heads.push(head);
+        }
+    }
+
+    while (!heads.empty()) {
+        uint64_t key = heads.top().key;
+        uint64_t count = 0;
+        while (!heads.empty() && heads.top().key == key) {
+            Head head = heads.top();
+            heads.pop();
+            count += head.count;
+            if (readers[head.reader].next(head.key, head.count)) {
+                heads.push(head);
+            }
+        }
+        fn(key, count);
+    }
+}
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_NGRAM_SNAPSHOT_H_
@@ -0,0 +1,271 @@
+/**
+ * @file ngram_stats.cpp
+ * @brief Implementation of n-gram occurrence statistics
+ */
+
+#include "core/ngram_stats.h"
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include "core/auto_tune.h"
+#include "core/ngram_window.h"
+#include "core/output_writer.h"
+#include "core/text_utils.h"
+#include "parallel/executor.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+constexpr char kStatsHeader[] = "# suzume-feedmill pmi-stats v1 text_bytes=";
+constexpr char kStatsColumns[] = "ngram\tcount\tleft_variety\tright_variety\tfirst_offset\tcontext";
+
+// Neighbour of an occurrence at a line start or end; above every code point
+constexpr uint32_t kLineBoundary = 0x110000;
+
+// Chunks smaller than this are not worth a thread
+constexpr size_t kMinChunkBytes = 1 << 20;
+
+// Neighbour set entry: n-gram index, side (1 = right) and neighbour in 21 bits
+uint64_t neighbourKey(size_t index, uint64_t side, uint32_t neighbour) {
+    return (static_cast<uint64_t>(index) << 22) | (side << 21) | neighbour;
+}
+
+uint64_t parseField(std::string_view field, const std::string& path) {
+    uint64_t value = 0;
+    if (field.empty()) {
+        throw std::runtime_error("Malformed PMI statistics file: " + path);
+    }
+    for (char c : field) {
+        if (c < '0' || c > '9') {
+            throw std::runtime_error("Malformed PMI statistics file: " + path);
+        }
+        value = value * 10 + static_cast<uint64_t>(c - '0');
+    }
+    return value;
+}
+
+} // namespace
+
+std::vector<NgramStats> gatherNgramStats(
+    std::string_view text,
+    const std::vector<std::string_view>& ngrams,
+    size_t contextCodePoints,
+    unsigned int threads
+) {
+    std::vector<NgramStats> result(ngrams.size());
+
+    // Windows are only looked up at the code point lengths of the n-grams
+    robin_hood::unordered_flat_map<std::string_view, size_t> lookup;
+    std::vector<size_t> lengths;
+    for (size_t i = 0; i < ngrams.size(); ++i) {
+        if (ngrams[i].empty() || !lookup.emplace(ngrams[i], i).second) {
+            continue;
+        }
+        size_t length = 0;
+        forEachCodePoint(ngrams[i], [&length](uint32_t) { length++; });
+        if (std::find(lengths.begin(), lengths.end(), length) == lengths.end()) {
+            lengths.push_back(length);
+        }
+    }
+    if (lookup.empty()) {
+        return result;
+    }
+
+    threads = resolveThreads(threads);
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(threads, text.size() / kMinChunkBytes));
+    std::vector<size_t> bounds{0};
+    for (size_t c = 1; c < chunkCount; ++c) {
+        size_t cut = text.find('\n', std::max(bounds.back(), text.size() * c / chunkCount));
+        if (cut == std::string_view::npos) {
+            break;
+        }
+        bounds.push_back(cut + 1);
+    }
+    bounds.push_back(text.size());
+    chunkCount = bounds.size() - 1;
+
+    // Greedy leftmost non-overlapping count per n-gram, and every neighbour seen
+    struct Tally {
+        uint32_t count = 0;
+        uint64_t first = 0;
+        uint64_t next = 0;
+    };
+    struct ChunkStats {
+        robin_hood::unordered_flat_map<size_t, Tally> tallies;
+        robin_hood::unordered_flat_set<uint64_t> neighbours;
+    };
+    std::vector<ChunkStats> chunks(chunkCount);
+    parallel::ParallelExecutor::parallelFor(chunkCount, [&](size_t begin, size_t end) {
+        std::vector<size_t> starts;
+        std::vector<uint32_t> codePoints;
+        for (size_t c = begin; c < end; ++c) {
+            ChunkStats& chunk = chunks[c];
+            size_t lineStart = bounds[c];
+            forEachLine(text.substr(bounds[c], bounds[c + 1] - bounds[c]), [&](std::string_view line) {
+                starts.clear();
+                codePoints.clear();
+                size_t pos = 0;
+                while (pos < line.size()) {
+                    starts.push_back(pos);
+                    codePoints.push_back(nextCodePoint(line, pos));
+                }
+                starts.push_back(line.size());
+
+                const size_t count = codePoints.size();
+                for (size_t length : lengths) {
+                    for (size_t i = 0; i + length <= count; ++i) {
+                        auto it = lookup.find(line.substr(starts[i], starts[i + length] - starts[i]));
+                        if (it == lookup.end()) {
+                            continue;
+                        }
+                        size_t index = it->second;
+                        uint32_t left = i > 0 ? codePoints[i - 1] : kLineBoundary;
+                        uint32_t right = i + length < count ? codePoints[i + length] : kLineBoundary;
+                        chunk.neighbours.insert(neighbourKey(index, 0, left));
+                        chunk.neighbours.insert(neighbourKey(index, 1, right));
+
+                        uint64_t position = lineStart + starts[i];
+                        auto [entry, inserted] = chunk.tallies.try_emplace(index);
+                        Tally& tally = entry->second;
+                        if (inserted) {
+                            tally.first = position;
+                        } else if (position < tally.next) {
+                            continue;
+                        }
+                        tally.count++;
+                        tally.next = lineStart + starts[i + length];
+                    }
+                }
+                lineStart += line.size() + 1;
+            });
+        }
+    }, static_cast<unsigned int>(chunkCount), 1);
+
+    // Chunks are in text order, so the first chunk holding an n-gram has its first occurrence
+    robin_hood::unordered_flat_set<uint64_t> neighbours;
+    for (ChunkStats& chunk : chunks) {
+        for (const auto& entry : chunk.tallies) {
+            NgramStats& stats = result[entry.first];
+            if (stats.count == 0) {
+                stats.firstOffset = entry.second.first;
+            }
+            stats.count += entry.second.count;
+        }
+        for (uint64_t key : chunk.neighbours) {
+            neighbours.insert(key);
+        }
+        chunk = ChunkStats();
+    }
+    for (uint64_t key : neighbours) {
+        NgramStats& stats = result[key >> 22];
+        ((key >> 21) & 1 ? stats.rightVariety : stats.leftVariety)++;
+    }
+
+    // Duplicates share the statistics of their first copy
+    for (size_t i = 0; i < ngrams.size(); ++i) {
+        auto it = lookup.find(ngrams[i]);
+        if (it == lookup.end()) {
+            continue;
+        }
+        if (it->second != i) {
+            result[i] = result[it->second];
+        } else if (result[i].count > 0) {
+            result[i].context = std::string(utf8Context(text, result[i].firstOffset, contextCodePoints, true));
+        }
+    }
+    return result;
+}
+
+void writeNgramStats(
+    const std::string& path,
+    std::string_view text,
+    const std::vector<PmiItem>& items,
+    unsigned int threads
+) {
+    // A tab or newline in an n-gram would break its row
+    std::vector<std::string_view> ngrams;
+    ngrams.reserve(items.size());
+    for (const auto& item : items) {
+        bool writable = item.ngram.find_first_of("\t\n") == std::string::npos;
+        ngrams.push_back(writable ? std::string_view(item.ngram) : std::string_view());
+    }
+    std::vector<NgramStats> stats = gatherNgramStats(text, ngrams, NgramStatsTable::kContextCodePoints, threads);
+
+    prepareOutputPath(path);
+    OutputWriter output(path);
+    output.write(kStatsHeader);
+    output.writeNumber(static_cast<uint64_t>(text.size()));
+    output.put('\n');
+    output.write(kStatsColumns);
+    output.put('\n');
+    for (size_t i = 0; i < ngrams.size(); ++i) {
+        if (ngrams[i].empty()) {
+            continue;
+        }
+        const NgramStats& entry = stats[i];
+        output.write(ngrams[i]);
+        output.put('\t');
+        output.writeNumber(static_cast<uint64_t>(entry.count));
+        output.put('\t');
+        output.writeNumber(static_cast<uint64_t>(entry.leftVariety));
+        output.put('\t');
+        output.writeNumber(static_cast<uint64_t>(entry.rightVariety));
+        output.put('\t');
+        output.writeNumber(entry.firstOffset);
+        output.put('\t');
+        output.write(entry.context);
+        output.put('\n');
+    }
+    output.close();
+}
+
+NgramStatsTable::NgramStatsTable(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open PMI statistics file: " + path);
+    }
+
+    std::string line;
+    const std::string_view header(kStatsHeader);
+    if (!std::getline(input, line) || line.compare(0, header.size(), header) != 0) {
+        throw std::runtime_error("Not a PMI statistics file: " + path);
+    }
+    textBytes_ = parseField(std::string_view(line).substr(header.size()), path);
+    if (!std::getline(input, line) || line != kStatsColumns) {
+        throw std::runtime_error("Not a PMI statistics file: " + path);
+    }
+
+    while (std::getline(input, line)) {
+        // Five tab-separated fields, then the context with any tabs it holds
+        std::string_view rest(line);
+        std::string_view fields[5];
+        for (auto& field : fields) {
+            size_t tab = rest.find('\t');
+            if (tab == std::string_view::npos) {
+                throw std::runtime_error("Malformed PMI statistics file: " + path);
+            }
+            field = rest.substr(0, tab);
+            rest.remove_prefix(tab + 1);
+        }
+        NgramStats stats;
+        stats.count = static_cast<uint32_t>(parseField(fields[1], path));
+        stats.leftVariety = static_cast<uint32_t>(parseField(fields[2], path));
+        stats.rightVariety = static_cast<uint32_t>(parseField(fields[3], path));
+        stats.firstOffset = parseField(fields[4], path);
+        stats.context = std::string(rest);
+        stats_.emplace(std::string(fields[0]), std::move(stats));
+    }
+    if (input.bad()) {
+        throw std::runtime_error("Failed to read PMI statistics file: " + path);
+    }
+}
+
+const NgramStats* NgramStatsTable::find(std::string_view ngram) const {
+    auto it = stats_.find(ngram);
+    return it == stats_.end() ? nullptr : &it->second;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,124 @@
+/**
+ * @file ngram_stats.h
+ * @brief Occurrence statistics of scored n-grams, written by PMI for word extraction
+ */
+
+#ifndef SUZUME_CORE_NGRAM_STATS_H_
+#define SUZUME_CORE_NGRAM_STATS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/counting_map.h"
+#include "core/pmi.h"
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * Statistics file layout (UTF-8 text, '\n'-terminated lines):
+ *
+ *   # suzume-feedmill pmi-stats v1 text_bytes=<size of the counted text>
+ *   ngram  count  left_variety  right_variety  first_offset  context
+ *   one tab-separated row per n-gram, in PMI output order
+ *
+ * The context is the last column and may itself hold tabs. N-grams that
+ * hold a tab or a newline are left out; readers look them up in the text.
+ */
+
+/**
+ * @brief What a text says about one n-gram
+ */
+struct NgramStats {
+    uint32_t count = 0;         ///< Non-overlapping occurrences, leftmost first
+    uint32_t leftVariety = 0;   ///< Distinct characters right before an occurrence (a line start is one)
+    uint32_t rightVariety = 0;  ///< Distinct characters right after an occurrence (a line end is one)
+    uint64_t firstOffset = 0;   ///< Byte offset of the first occurrence
+    std::string context;        ///< Context of the first occurrence, within its line
+};
+
+/**
+ * @brief Gather the statistics of many n-grams in one pass over a text
+ *
+ * Every line is decoded once and each window of as many code points as one
+ * of the n-grams has is looked up in a hash table of the n-grams. The text
+ * is split into line-aligned chunks scanned in parallel; n-grams never span
+ * a newline, so the results equal those of a sequential scan. Counts keep
+ * the leftmost of overlapping occurrences, as the word extraction verifier
+ * counts them.
+ *
+ * @param text UTF-8 text, lines separated by '\n'
+ * @param ngrams N-grams to look up (empty ones are never found)
+ * @param contextCodePoints Context size (characters before and after, within the line)
+ * @param threads Number of threads (0 = auto)
+ * @return std::vector<NgramStats> Statistics of each n-gram, in input order
+ */
+std::vector<NgramStats> gatherNgramStats(
+    std::string_view text,
+    const std::vector<std::string_view>& ngrams,
+    size_t contextCodePoints,
+    unsigned int threads
+);
+
+/**
+ * @brief Gather the statistics of scored n-grams and write them to a file
+ *
+ * @param path Output file path
+ * @param text Text the items were counted in
+ * @param items Scored n-grams, in output order
+ * @param threads Number of threads (0 = auto)
+ * @throws std::runtime_error If the file cannot be written
+ */
+void writeNgramStats(
+    const std::string& path,
+    std::string_view text,
+    const std::vector<PmiItem>& items,
+    unsigned int threads
+);
+
+/**
+ * @brief N-gram statistics loaded from a file, looked up by n-gram
+ */
+class NgramStatsTable {
+public:
+    /// Context size, in characters on each side, that statistics files carry
+    static constexpr size_t kContextCodePoints = 20;
+
+    /**
+     * @brief Load a statistics file
+     * @param path File written by writeNgramStats()
+     * @throws std::runtime_error If the file cannot be read or is not a statistics file
+     */
+    explicit NgramStatsTable(const std::string& path);
+
+    /**
+     * @brief Look up an n-gram
+     * @param ngram N-gram text
+     * @return const NgramStats* Its statistics, or nullptr if the file does not cover it
+     */
+    const NgramStats* find(std::string_view ngram) const;
+
+    /**
+     * @brief Get the size of the text the statistics were gathered over
+     * @return uint64_t Text size in bytes
+     */
+    uint64_t textBytes() const { return textBytes_; }
+
+    /**
+     * @brief Get the number of n-grams covered
+     * @return size_t N-gram count
+     */
+    size_t size() const { return stats_.size(); }
+
+private:
+    uint64_t textBytes_ = 0;
+    robin_hood::unordered_node_map<std::string, NgramStats, Utf8KeyHash, Utf8KeyEqual> stats_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_NGRAM_STATS_H_
@@ -0,0 +1,174 @@
+/**
+ * @file ngram_window.h
+ * @brief Allocation-free UTF-8 decoding and sliding n-gram windows
+ */
+
+#ifndef SUZUME_CORE_NGRAM_WINDOW_H_
+#define SUZUME_CORE_NGRAM_WINDOW_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/// Code point substituted for ill-formed UTF-8
+constexpr uint32_t kReplacementCharacter = 0xFFFD;
+
+/**
+ * @brief Decode the UTF-8 code point at a position and advance past it
+ *
+ * Ill-formed sequences decode to U+FFFD, one per maximal subpart, exactly
+ * like ICU's U8_NEXT_OR_FFFD and UnicodeString::fromUTF8().
+ *
+ * @param text UTF-8 text
+ * @param pos Byte offset (must be < text.size()); advanced past the code point
+ * @return uint32_t Code point
+ */
+inline uint32_t nextCodePoint(std::string_view text, size_t& pos) {
+    const unsigned char* s = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t length = text.size();
+    uint32_t c = s[pos++];
+    if (c < 0x80) {
+        return c;
+    }
+
+    auto trail = [&](unsigned char lo, unsigned char hi) {
+        return pos < length && s[pos] >= lo && s[pos] <= hi;
+    };
+
+    if (c >= 0xC2 && c <= 0xDF) {
+        if (trail(0x80, 0xBF)) {
+            return ((c & 0x1F) << 6) | (s[pos++] & 0x3F);
+        }
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        // Second byte excludes overlongs (E0) and surrogates (ED)
+        if (trail(c == 0xE0 ? 0xA0 : 0x80, c == 0xED ? 0x9F : 0xBF)) {
+            uint32_t cp = ((c & 0x0F) << 12) | ((s[pos++] & 0x3F) << 6);
+            if (trail(0x80, 0xBF)) {
+                return cp | (s[pos++] & 0x3F);
+            }
+        }
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        // Second byte excludes overlongs (F0) and code points past U+10FFFF (F4)
+        if (trail(c == 0xF0 ? 0x90 : 0x80, c == 0xF4 ? 0x8F : 0xBF)) {
+            uint32_t cp = ((c & 0x07) << 18) | ((s[pos++] & 0x3F) << 12);
+            if (trail(0x80, 0xBF)) {
+                cp |= (s[pos++] & 0x3F) << 6;
+                if (trail(0x80, 0xBF)) {
+                    return cp | (s[pos++] & 0x3F);
+                }
+            }
+        }
+    }
+    return kReplacementCharacter;
+}
+
+/**
+ * @brief Append a code point to a string as UTF-8
+ *
+ * @param out Output string
+ * @param cp Code point (at most U+10FFFF)
+ */
+inline void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+/**
+ * @brief Call fn(codePoint) for every code point of a text
+ *
+ * @param text UTF-8 text
+ * @param fn Visitor taking a uint32_t code point
+ */
+template <typename Fn>
+inline void forEachCodePoint(std::string_view text, Fn&& fn) {
+    size_t pos = 0;
+    while (pos < text.size()) {
+        fn(nextCodePoint(text, pos));
+    }
+}
+
+/**
+ * @brief Call fn(window) for every window of n consecutive code points
+ *
+ * Windows are std::string_view slices of the line, so nothing is allocated
+ * per n-gram (windows wider than 16 code points allocate once per call). An
+ * ill-formed sequence counts as one code point and stays as its raw bytes in
+ * the window. Lines shorter than n yield nothing.
+ *
+ * @param line UTF-8 line (no newline handling)
+ * @param n Window size in code points
+ * @param fn Visitor taking a std::string_view
+ */
+template <typename Fn>
+inline void forEachNgram(std::string_view line, uint32_t n, Fn&& fn) {
+    if (n == 0) {
+        return;
+    }
+
+    // Start offsets of the last n code points, in a ring
+    constexpr size_t kInlineWindow = 16;
+    std::array<size_t, kInlineWindow> inlineStarts;
+    std::vector<size_t> heapStarts;
+    size_t* starts = inlineStarts.data();
+    if (n > kInlineWindow) {
+        heapStarts.resize(n);
+        starts = heapStarts.data();
+    }
+
+    size_t codePoints = 0;
+    size_t pos = 0;
+    while (pos < line.size()) {
+        starts[codePoints % n] = pos;
+        nextCodePoint(line, pos);
+        codePoints++;
+        if (codePoints >= n) {
+            size_t first = starts[(codePoints - n) % n];
+            fn(line.substr(first, pos - first));
+        }
+    }
+}
+
+/**
+ * @brief Call fn(line) for every '\n'-separated line of a text
+ *
+ * Follows std::getline: a trailing newline does not start an empty line.
+ *
+ * @param text Text
+ * @param fn Visitor taking a std::string_view without its newline
+ */
+template <typename Fn>
+inline void forEachLine(std::string_view text, Fn&& fn) {
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string_view::npos) {
+            end = text.size();
+        }
+        fn(text.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_NGRAM_WINDOW_H_
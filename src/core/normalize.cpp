@@ -5,12 +5,36 @@
 
 #include "core/normalize.h"
 #include "core/text_utils.h"
+#include "core/auto_tune.h"
+#include "core/background_writer.h"
+#include "core/checkpoint.h"
+#include "core/streaming_processor.h"
+#include "core/compressed_input.h"
+#include "core/dedup.h"
+#include "core/external_dedup.h"
+#include "core/external_sort.h"
+#include "core/input_files.h"
+#include "core/mapped_text.h"
+#include "core/memory_accounting.h"
+#include "core/memory_monitor.h"
+#include "core/near_dedup.h"
+#include "core/numa_topology.h"
+#include "core/output_writer.h"
+#include "core/progress_reporter.h"
+#include "core/sampling.h"
+#include "core/sharded_output.h"
+#include "parallel/thread_pool.h"
+#include "parallel/trace.h"
 #include <algorithm>
-#include <fstream>
+#include <cstring>
+#include <iterator>
+#include <exception>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <thread>
-#include <unordered_set>
 #include <vector>
 #include <filesystem>
 #include <atomic>
@@ -18,11 +42,988 @@
 namespace suzume {
 namespace core {
 
+namespace {
+
+// Chunks per thread when finished chunks are written in the background
+constexpr size_t kChunksPerThread = 4;
+
+// Fewer lines are always normalized on the calling thread
+constexpr size_t kMinParallelLines = 100;
+
+// Work a normalizing worker needs to pay for starting it
+constexpr uint64_t kMinLinesPerThread = 1000;
+constexpr uint64_t kMinBytesPerThread = 256 * 1024;
+
+/**
+ * @brief Choose the workers of a run (see tuneWorkers())
+ *
+ * @param options Normalization options
+ * @param inputBytes Input size (0 = unknown)
+ * @param lines Input lines (0 = not known yet)
+ * @return TuningChoice Workers, chunk size and variant
+ */
+TuningChoice tuneNormalize(const NormalizeOptions& options, uint64_t inputBytes, uint64_t lines) {
+    WorkloadShape shape;
+    shape.inputBytes = inputBytes;
+    shape.items = lines;
+    shape.minBytesPerThread = lines > 0 ? 0 : kMinBytesPerThread;
+    shape.minItemsPerThread = kMinLinesPerThread;
+    return tuneWorkers(options.threads, shape);
+}
+
+/**
+ * @brief Attach the tuning of a run to its result
+ */
+NormalizeResult withTuning(NormalizeResult result, const TuningChoice& tuning) {
+    result.metrics.threads = tuning.threads;
+    result.metrics.tuning = tuning;
+    return result;
+}
+
+/**
+ * @brief Write 1-based columns as a comma-separated list
+ */
+std::string joinColumns(const std::vector<uint32_t>& columns) {
+    std::string joined;
+    for (uint32_t column : columns) {
+        joined += (joined.empty() ? "" : ",") + std::to_string(column);
+    }
+    return joined;
+}
+
+/**
+ * @brief Check whether two paths name the same existing file
+ *
+ * @param first First path
+ * @param second Second path
+ * @return bool True if both exist and are the same file
+ */
+bool sameFile(const std::string& first, const std::string& second) {
+    std::error_code error;
+    return std::filesystem::equivalent(first, second, error) && !error;
+}
+
+/**
+ * @brief Normalize a single line and apply the length filters
+ *
+ * @param line Input line
+ * @param form Normalization form
+ * @param minLength Minimum line length (0 = no minimum)
+ * @param maxLength Maximum line length (0 = no maximum)
+ * @param normalized Output normalized line
+ * @param columns 1-based columns to normalize, the others pass through (empty = every column)
+ * @return true If the line should be emitted
+ */
+bool normalizeForOutput(
+    std::string_view line,
+    NormalizationForm form,
+    uint32_t minLength,
+    uint32_t maxLength,
+    std::string& normalized,
+    const std::vector<uint32_t>& columns = {}
+) {
+    // Check length filters before normalization to save processing time
+    if (shouldExcludeLine(line, minLength, maxLength)) {
+        return false;
+    }
+
+    // Normalize into the caller's buffer so its capacity is reused across lines
+    // (normalizeLineInto handles whitespace-only and excluded lines)
+    if (!normalizeLineInto(line, form, normalized, columns)) {
+        return false;
+    }
+
+    // Apply length filters to normalized line as well
+    return !shouldExcludeLine(normalized, minLength, maxLength);
+}
+
+/**
+ * @brief Normalize a range of lines, handing each one that passes the filters on
+ *
+ * @param begin First input line
+ * @param end One past the last input line
+ * @param options Normalization options
+ * @param emit Called with each normalized line, in a buffer reused for the next one
+ */
+template <typename LineIterator, typename Emit>
+void forEachNormalized(
+    LineIterator begin,
+    LineIterator end,
+    const NormalizeOptions& options,
+    Emit&& emit
+) {
+    std::string normalizedLine;
+    for (LineIterator it = begin; it != end; ++it) {
+        if (normalizeForOutput(*it, options.form, options.minLength, options.maxLength, normalizedLine,
+                               options.normalizeColumns)) {
+            emit(normalizedLine);
+        }
+    }
+}
+
+/**
+ * @brief Check a normalized line against the exact and near-duplicate filters
+ *
+ * Only exact-unique lines reach the near-duplicate index. With key columns,
+ * both filters judge the line by those columns alone.
+ *
+ * @param line Normalized line
+ * @param uniqueFilter Dedup filter
+ * @param nearFilter Near-duplicate filter (nullptr = exact dedup only)
+ * @param keyColumns 1-based dedup key columns (empty = the whole line)
+ * @return true If the line was not seen before
+ */
+bool isFirstOccurrence(std::string_view line, ConcurrentDedupFilter& uniqueFilter, NearDuplicateFilter* nearFilter,
+                       const std::vector<uint32_t>& keyColumns) {
+    thread_local std::string scratch;
+    std::string_view key = selectColumns(line, keyColumns, scratch);
+    return !isDuplicate(key, uniqueFilter) && !(nearFilter && nearFilter->isNearDuplicate(key));
+}
+
+/**
+ * @brief Normalize a range of lines without deduplicating them
+ *
+ * @param begin First input line
+ * @param end One past the last input line
+ * @param options Normalization options
+ * @return std::vector<std::string> Normalized lines that pass the filters
+ */
+template <typename LineIterator>
+std::vector<std::string> normalizeLines(
+    LineIterator begin,
+    LineIterator end,
+    const NormalizeOptions& options
+) {
+    std::vector<std::string> result;
+    result.reserve(static_cast<size_t>(std::distance(begin, end)));
+    forEachNormalized(begin, end, options, [&result](const std::string& line) { result.push_back(line); });
+    return result;
+}
+
+/**
+ * @brief Keep only the lines not yet in the filter, in their original order
+ *
+ * @param lines Normalized lines
+ * @param uniqueFilter Dedup filter
+ * @param nearFilter Near-duplicate filter (nullptr = exact dedup only)
+ * @param keyColumns 1-based dedup key columns (empty = the whole line)
+ * @return std::vector<std::string> First occurrences
+ */
+std::vector<std::string> dropDuplicates(
+    std::vector<std::string>&& lines,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter,
+    const std::vector<uint32_t>& keyColumns
+) {
+    std::vector<std::string> result;
+    result.reserve(lines.size());
+    for (auto& line : lines) {
+        if (isFirstOccurrence(line, uniqueFilter, nearFilter, keyColumns)) {
+            result.push_back(std::move(line));
+        }
+    }
+    return result;
+}
+
+/**
+ * @brief Normalize a range of lines, dropping lines already in the filter
+ *
+ * @param begin First input line
+ * @param end One past the last input line
+ * @param options Normalization options
+ * @param uniqueFilter Dedup filter (shared between workers)
+ * @param nearFilter Near-duplicate filter (nullptr = exact dedup only)
+ * @return std::vector<std::string> Normalized lines not seen before
+ */
+template <typename LineIterator>
+std::vector<std::string> normalizeRange(
+    LineIterator begin,
+    LineIterator end,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter
+) {
+    std::vector<std::string> result;
+
+    // Duplicates across batches are dropped here, not in a later merge
+    forEachNormalized(begin, end, options, [&](const std::string& line) {
+        if (isFirstOccurrence(line, uniqueFilter, nearFilter, options.dedupColumns)) {
+            result.push_back(line);
+        }
+    });
+
+    return result;
+}
+
+/**
+ * @brief Read a whole stream into one buffer, reporting progress per block
+ *
+ * @param input Input stream
+ * @param sizeHint Expected size in bytes (0 = unknown)
+ * @param buffer Output buffer
+ * @param progress Called with the number of bytes read so far
+ */
+void readInputBuffer(
+    std::istream& input,
+    size_t sizeHint,
+    std::string& buffer,
+    const std::function<void(size_t)>& progress
+) {
+    constexpr size_t kReadBlockSize = 4 * 1024 * 1024;
+
+    buffer.clear();
+    if (sizeHint > 0) {
+        buffer.reserve(sizeHint);
+    }
+
+    size_t total = 0;
+    while (input) {
+        buffer.resize(total + kReadBlockSize);
+        input.read(&buffer[total], kReadBlockSize);
+        total += static_cast<size_t>(input.gcount());
+        buffer.resize(total);
+        progress(total);
+    }
+}
+
+/**
+ * @brief Split a buffer into line views with std::getline semantics
+ *
+ * @param buffer Input buffer (must outlive the views)
+ * @return std::vector<std::string_view> Lines without their newline
+ */
+std::vector<std::string_view> splitLineViews(std::string_view buffer) {
+    std::vector<std::string_view> lines;
+    for (std::string_view line : LineRange(buffer)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+/**
+ * @brief Output of a run: one buffered file, or shard files written concurrently
+ */
+class RunOutput {
+public:
+    RunOutput(const std::string& outputPath, const NormalizeOptions& options) {
+        bool compress = options.compressOutput || isCompressedOutputPath(outputPath);
+        if (options.outputShards > 1) {
+            sharded_ = std::make_unique<ShardedOutputWriter>(
+                outputPath, options.outputShards, options.shardRouting, compress);
+            return;
+        }
+        if (outputPath != "-") {
+            prepareOutputPath(outputPath);
+        }
+        single_ = std::make_unique<OutputWriter>(outputPath, OutputWriter::kDefaultBufferSize, compress);
+    }
+
+    /// True if workers may write concurrently, each line to its shard
+    bool sharded() const { return sharded_ != nullptr; }
+
+    void writeLine(std::string_view line) {
+        if (single_) {
+            single_->writeLine(line);
+        } else {
+            sharded_->writeLine(line);
+        }
+    }
+
+    void writeLines(const std::vector<std::string>& lines) {
+        if (single_) {
+            for (const auto& line : lines) {
+                single_->writeLine(line);
+            }
+        } else {
+            sharded_->writeLines(lines);
+        }
+    }
+
+    /// Stream buffer for code written against std::ostream
+    std::streambuf* buffer() {
+        return single_ ? static_cast<std::streambuf*>(single_.get()) : sharded_.get();
+    }
+
+    void close() {
+        if (single_) {
+            single_->close();
+        } else {
+            sharded_->close();
+        }
+    }
+
+private:
+    std::unique_ptr<OutputWriter> single_;
+    std::unique_ptr<ShardedOutputWriter> sharded_;
+};
+
+/**
+ * @brief Prepare and open the output of a run
+ *
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param options Normalization options (compression and sharding)
+ * @return std::unique_ptr<RunOutput> Output, or nullptr for "null"
+ * @throws std::invalid_argument If sharded output is asked for on stdout
+ * @throws std::runtime_error If the output cannot be opened
+ */
+std::unique_ptr<RunOutput> openOutput(const std::string& outputPath, const NormalizeOptions& options) {
+    if (outputPath == "null") {
+        return nullptr;
+    }
+    return std::make_unique<RunOutput>(outputPath, options);
+}
+
+/**
+ * @brief Reject invalid or conflicting normalization options
+ *
+ * @param options Normalization options
+ * @throws std::invalid_argument If an option is out of range or options conflict
+ */
+void validateOptions(const NormalizeOptions& options) {
+    // Validate length filters
+    if (options.minLength > 0 && options.maxLength > 0 && options.minLength > options.maxLength) {
+        throw std::invalid_argument("Invalid length filters: min-length (" +
+                                   std::to_string(options.minLength) +
+                                   ") cannot be greater than max-length (" +
+                                   std::to_string(options.maxLength) + ")");
+    }
+    
+    // Validate bloom filter false positive rate
+    if (options.bloomFalsePositiveRate <= 0.0 || options.bloomFalsePositiveRate >= 1.0) {
+        throw std::invalid_argument("Invalid bloomFalsePositiveRate: " +
+                                   std::to_string(options.bloomFalsePositiveRate) +
+                                   " (must be between 0.0 and 1.0)");
+    }
+    
+    // Validate progress step
+    if (options.progressStep <= 0.0 || options.progressStep > 1.0) {
+        throw std::invalid_argument("Invalid progressStep: " +
+                                   std::to_string(options.progressStep) +
+                                   " (must be between 0.0 and 1.0)");
+    }
+
+    // The persisted index is an in-memory filter, external dedup is not
+    if (options.externalDedup && !options.dedupIndexPath.empty()) {
+        throw std::invalid_argument("External dedup cannot be combined with a dedup index");
+    }
+
+    // External dedup writes partition by partition, never in input order
+    if (options.externalDedup && options.preserveOrder) {
+        throw std::invalid_argument("External dedup cannot preserve input order");
+    }
+
+    // Sampled lines are few enough to dedup in memory
+    if (options.externalDedup && options.sampleSize > 0) {
+        throw std::invalid_argument("External dedup cannot be combined with sampling");
+    }
+
+    // Near-duplicate detection needs every kept line in one in-memory index
+    if (options.externalDedup && options.nearDupDistance > 0) {
+        throw std::invalid_argument("External dedup cannot be combined with near-duplicate detection");
+    }
+    if (options.nearDupDistance > 31) {
+        throw std::invalid_argument("Invalid nearDupDistance: " +
+                                   std::to_string(options.nearDupDistance) +
+                                   " (must be between 0 and 31)");
+    }
+
+    // Columns are 1-based, like cut -f
+    for (const auto* columns : {&options.normalizeColumns, &options.dedupColumns}) {
+        if (std::find(columns->begin(), columns->end(), 0u) != columns->end()) {
+            throw std::invalid_argument("Invalid column: 0 (columns are numbered from 1)");
+        }
+    }
+
+    // Spilled partitions are split and deduplicated by whole-line fingerprints
+    if (options.externalDedup && !options.dedupColumns.empty()) {
+        throw std::invalid_argument("External dedup cannot be combined with dedup key columns");
+    }
+
+    // Sorted runs are merged into one stream and deduplicated on whole lines while merging
+    if (options.sortedOutput) {
+        if (options.externalDedup || options.preserveOrder || !options.dedupIndexPath.empty() ||
+            options.nearDupDistance > 0 || !options.dedupColumns.empty() || options.sampleSize > 0 ||
+            options.outputShards > 1) {
+            throw std::invalid_argument("Sorted output cannot be combined with external dedup, input order, a dedup "
+                                       "index, near-duplicate detection, dedup key columns, sampling, or "
+                                       "sharded output");
+        }
+    }
+
+    if (options.outputShards > ShardedOutputWriter::kMaxShards) {
+        throw std::invalid_argument("Invalid outputShards: " + std::to_string(options.outputShards) +
+                                   " (must be at most " + std::to_string(ShardedOutputWriter::kMaxShards) + ")");
+    }
+
+    // A checkpoint records an offset into one plain output and an exact dedup state
+    if (!options.checkpointPath.empty()) {
+        if (options.sampleSize > 0 || options.externalDedup || options.sortedOutput || options.nearDupDistance > 0 ||
+            options.outputShards > 1 || options.compressOutput) {
+            throw std::invalid_argument("Checkpointing cannot be combined with sampling, external dedup, sorted "
+                                       "output, near-duplicate detection, or sharded or compressed output");
+        }
+        if (options.checkpointInterval < 1) {
+            throw std::invalid_argument("Invalid checkpointInterval: 0 (must be at least 1 byte)");
+        }
+    }
+}
+
+/// Bytes an in-memory run holds per input byte: the text, its line views and the unique lines
+constexpr uint64_t kInMemoryBytesPerInputByte = 3;
+
+/**
+ * @brief Options that keep a run within the memory limit (see setMemoryLimit())
+ *
+ * An input that would not fit in half the limit in memory, or whose size
+ * is unknown, is streamed with at most a quarter of the limit in line
+ * buffers. When it is also larger than another quarter, or of unknown
+ * size, it dedups externally if the options allow, since the dedup set
+ * grows with the unique lines. Samples are bounded by their size.
+ *
+ * @param options Requested options
+ * @param inputPaths Input paths, directories or globs ("-" for stdin)
+ * @return NormalizeOptions Options to run with
+ */
+NormalizeOptions withinMemoryLimit(const NormalizeOptions& options, const std::vector<std::string>& inputPaths) {
+    const uint64_t limit = memoryLimit();
+    if (limit == 0 || options.sampleSize > 0) {
+        return options;
+    }
+
+    // Compressed files and stdin hold an unknown amount of text
+    bool sizeKnown = true;
+    uint64_t inputBytes = 0;
+    for (const auto& path : inputPaths) {
+        if (path == "-") {
+            sizeKnown = false;
+            continue;
+        }
+        try {
+            for (const auto& file : expandInputPaths({path})) {
+                sizeKnown = sizeKnown && detectFileCompression(file.path) == Compression::None;
+                inputBytes += file.size;
+            }
+        } catch (const std::exception&) {
+            // Missing inputs are reported by the run itself
+        }
+    }
+    if (sizeKnown && inputBytes * kInMemoryBytesPerInputByte <= limit / 2) {
+        return options;
+    }
+
+    NormalizeOptions planned = options;
+    planned.streaming = true;
+    const uint64_t lineBudget = limit / 4;
+    planned.maxMemoryUsage = options.maxMemoryUsage > 0 ? std::min(options.maxMemoryUsage, lineBudget) : lineBudget;
+    bool canSpill = options.dedupIndexPath.empty() && options.checkpointPath.empty() && !options.preserveOrder &&
+                    options.nearDupDistance == 0 && !options.sortedOutput;
+    if (canSpill && (!sizeKnown || inputBytes > limit / 4)) {
+        planned.externalDedup = true;
+    }
+    return planned;
+}
+
+/**
+ * @brief Fill in the totals derived from the counts and the measured run
+ *
+ * @param result Result with its counts and metrics
+ * @return NormalizeResult The result with duplicates, elapsed time and throughput
+ */
+NormalizeResult withTotals(NormalizeResult result) {
+    result.duplicates = result.rows - std::min(result.rows, result.uniques);
+    result.elapsedMs = result.metrics.elapsedMs;
+    result.mbPerSec = result.metrics.mbPerSec;
+    return result;
+}
+
+/**
+ * @brief Normalize input in bounded batches through ParallelStreamProcessor
+ *
+ * Lines are read, normalized and written batch by batch, so the line buffers
+ * never exceed the configured memory budget. Only the dedup state grows with
+ * the number of unique lines, unless external dedup spills it to disk.
+ *
+ * @param inputPath Input path ("-" for stdin)
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progress Progress reporter of the operation
+ * @param options Normalization options
+ * @param numThreads Number of worker threads
+ * @param fileSize Input size in bytes (0 = unknown)
+ * @return NormalizeResult Results of the normalization operation
+ */
+NormalizeResult normalizeStreaming(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    ProgressReporter& progress,
+    const NormalizeOptions& options,
+    unsigned int numThreads,
+    size_t fileSize
+) {
+    StreamingConfig config;
+    if (options.maxMemoryUsage > 0) {
+        config.maxMemoryUsage = static_cast<size_t>(options.maxMemoryUsage);
+    }
+
+    if (!options.tempDir.empty()) {
+        config.tempDir = options.tempDir;
+    }
+    config.numaAware = options.numaAware;
+
+    // Dedup state shared by all workers, seeded from earlier runs if requested
+    bool singleWriter = options.externalDedup || options.preserveOrder;
+    ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate, 0, singleWriter ? 1 : 0);
+    if (!options.dedupIndexPath.empty()) {
+        loadDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+
+    std::unique_ptr<NearDuplicateFilter> nearFilter;
+    if (options.nearDupDistance > 0) {
+        nearFilter = std::make_unique<NearDuplicateFilter>(
+            options.nearDupDistance, static_cast<size_t>(options.nearDupMaxLines));
+    }
+
+    // External mode spills normalized lines to disk and dedups them afterwards;
+    // sorted mode sorts each batch into a run and merges the runs at the end
+    std::unique_ptr<ExternalDedup> spill;
+    if (options.externalDedup) {
+        spill = std::make_unique<ExternalDedup>(
+            config.tempDir, config.maxMemoryUsage, fileSize, options.bloomFalsePositiveRate);
+    }
+    std::unique_ptr<ExternalSort> sorter;
+    if (options.sortedOutput) {
+        sorter = std::make_unique<ExternalSort>(config.tempDir, config.maxMemoryUsage);
+    }
+
+    // Batches and their results are line blocks, allocated and released per batch
+    auto batchProcessor = [&](const LineBlock& batch, LineBlock& result) {
+        if (spill) {
+            spill->add(normalizeLines(batch.begin(), batch.end(), options));
+            return;
+        }
+        if (sorter) {
+            sorter->add(normalizeLines(batch.begin(), batch.end(), options));
+            return;
+        }
+        if (options.preserveOrder) {
+            // Dedup is left to the writer, which sees batches in input order
+            forEachNormalized(batch.begin(), batch.end(), options,
+                              [&result](const std::string& line) { result.push_back(line); });
+            return;
+        }
+        forEachNormalized(batch.begin(), batch.end(), options, [&](const std::string& line) {
+            if (isFirstOccurrence(line, uniqueFilter, nearFilter.get(), options.dedupColumns)) {
+                result.push_back(line);
+            }
+        });
+    };
+
+    // Ordered runs dedup on the writer thread so the first occurrence wins
+    ParallelStreamProcessor::BlockProcessor sequentialStage;
+    if (options.preserveOrder) {
+        config.preserveOrder = true;
+        sequentialStage = [&](const LineBlock& batch, LineBlock& result) {
+            for (std::string_view line : batch) {
+                if (isFirstOccurrence(line, uniqueFilter, nearFilter.get(), options.dedupColumns)) {
+                    result.push_back(line);
+                }
+            }
+        };
+    }
+
+    // Reading and processing overlap, so report a single processing phase
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 0.95, fileSize);
+    uint64_t streamedBytes = 0;
+    auto streamProgress = [&](double ratio) {
+        uint64_t bytes = static_cast<uint64_t>(ratio * fileSize);
+        if (bytes > streamedBytes) {
+            progress.add(bytes - streamedBytes);
+            streamedBytes = bytes;
+        }
+    };
+
+    ParallelStreamProcessor processor(numThreads, config);
+
+    std::unique_ptr<std::istream> input = openInputStream(inputPath, numThreads);
+
+    // The stream shares the writer's buffer; batches are written through it
+    std::unique_ptr<RunOutput> writer = openOutput(outputPath, options);
+    std::ostream outputStream(writer ? writer->buffer() : nullptr);
+    std::ostream* output = writer ? &outputStream : nullptr;
+
+    size_t rows = processor.processStreamBlocks(*input, spill || sorter ? nullptr : output, batchProcessor,
+                                          streamProgress,
+                                          fileSize, sequentialStage);
+
+    NormalizeResult result;
+    result.rows = rows;
+    result.metrics.bytesIn = fileSize;
+    result.metrics.lines = rows;
+    result.metrics.threads = numThreads;
+    if (spill) {
+        result.uniques = spill->finish(output);
+    } else if (sorter) {
+        result.uniques = sorter->finish(output);
+    } else {
+        result.uniques = processor.getOutputLines();
+    }
+    if (writer) {
+        writer->close();
+    }
+
+    if (!options.dedupIndexPath.empty()) {
+        saveDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+    return result;
+}
+
+/**
+ * @brief Normalize the lines of one checkpoint segment on all threads
+ *
+ * @param lines Lines of the segment
+ * @param options Normalization options
+ * @param uniqueFilter Dedup filter of the run
+ * @param numThreads Number of worker threads
+ * @return std::vector<std::string> Unique lines of the segment, in chunk order
+ */
+std::vector<std::string> normalizeSegment(
+    const std::vector<std::string_view>& lines,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    unsigned int numThreads
+) {
+    size_t chunkCount = lines.size() > 100 && numThreads > 1 ? numThreads : 1;
+    size_t chunkSize = (lines.size() + chunkCount - 1) / chunkCount;
+    std::vector<std::vector<std::string>> chunkResults(chunkCount);
+
+    parallel::TaskGroup group("normalize");
+    for (size_t i = 0; i < chunkCount; ++i) {
+        size_t start = std::min(i * chunkSize, lines.size());
+        size_t end = std::min(start + chunkSize, lines.size());
+        group.run([&, i, start, end]() {
+            // With preserveOrder, dedup happens after the join so the first occurrence wins
+            chunkResults[i] = options.preserveOrder
+                ? normalizeLines(lines.data() + start, lines.data() + end, options)
+                : processBatch(lines.data() + start, end - start, options, uniqueFilter, nullptr);
+        });
+    }
+    group.wait();
+
+    std::vector<std::string> uniqueLines;
+    for (auto& result : chunkResults) {
+        if (options.preserveOrder) {
+            result = dropDuplicates(std::move(result), uniqueFilter, nullptr, options.dedupColumns);
+        }
+        std::move(result.begin(), result.end(), std::back_inserter(uniqueLines));
+    }
+    return uniqueLines;
+}
+
+/**
+ * @brief Normalize a file segment by segment, checkpointing after each
+ *
+ * Each line-aligned segment of NormalizeOptions::checkpointInterval bytes is
+ * normalized, and its unique lines are appended to the output and synced.
+ * The dedup state is then saved to a new index file and the checkpoint
+ * replaced to record both, with the input and output offsets after the
+ * segment. A resumed run cuts the output back to the recorded offset,
+ * reloads the dedup state and continues with the next segment, so its
+ * output matches an uninterrupted run.
+ *
+ * @param inputPath Input file (plain text)
+ * @param outputPath Output file ("null" for no output)
+ * @param progress Progress reporter of the operation
+ * @param options Normalization options
+ * @param numThreads Number of worker threads
+ * @return NormalizeResult Results of the normalization operation
+ * @throws std::invalid_argument If the input or output cannot be checkpointed
+ * @throws std::runtime_error If the checkpoint does not match the run
+ */
+NormalizeResult normalizeCheckpointed(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    ProgressReporter& progress,
+    const NormalizeOptions& options,
+    unsigned int numThreads
+) {
+    if (inputPath == "-" || detectFileCompression(inputPath) != Compression::None) {
+        throw std::invalid_argument("Checkpointing needs a plain input file; stdin and compressed input cannot be "
+                                    "resumed at an offset");
+    }
+    if (outputPath == "-" || isCompressedOutputPath(outputPath) || sameFile(inputPath, outputPath)) {
+        throw std::invalid_argument("Checkpointing needs a plain output file other than the input");
+    }
+
+    // The output offset and the dedup state are only valid for the same filters and output
+    std::string settings = "form=" + std::to_string(static_cast<int>(options.form)) +
+                           " min=" + std::to_string(options.minLength) +
+                           " max=" + std::to_string(options.maxLength) +
+                           " order=" + std::to_string(options.preserveOrder ? 1 : 0) +
+                           " columns=" + joinColumns(options.normalizeColumns) +
+                           " key=" + joinColumns(options.dedupColumns) +
+                           " index=" + options.dedupIndexPath + " output=" + outputPath;
+    Checkpoint checkpoint = openCheckpoint(options.checkpointPath, "normalize", inputPath, settings, options.resume);
+
+    ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate, 0, options.preserveOrder ? 1 : 0);
+    if (!checkpoint.dedupPath.empty()) {
+        loadDedupIndex(checkpoint.dedupPath, uniqueFilter);
+    } else if (!options.dedupIndexPath.empty()) {
+        loadDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+
+    std::unique_ptr<OutputWriter> output;
+    if (outputPath != "null") {
+        prepareOutputPath(outputPath);
+        output = OutputWriter::continueAt(outputPath, checkpoint.outputOffset);
+    }
+
+    MappedText input(inputPath);
+    std::string_view text = input.text();
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 0.95, text.size());
+    progress.add(checkpoint.inputOffset);
+
+    while (checkpoint.inputOffset < text.size()) {
+        size_t begin = static_cast<size_t>(checkpoint.inputOffset);
+        size_t end = checkpointSegmentEnd(text, begin, options.checkpointInterval);
+        std::vector<std::string_view> lines = splitLineViews(text.substr(begin, end - begin));
+        std::vector<std::string> uniqueLines = normalizeSegment(lines, options, uniqueFilter, numThreads);
+
+        if (output) {
+            for (const auto& line : uniqueLines) {
+                output->writeLine(line);
+                checkpoint.outputOffset += line.size() + 1;
+            }
+            output->syncToDisk();
+        }
+
+        // A new index per checkpoint, so the one the previous checkpoint names stays whole until replaced
+        std::string previousDedup = checkpoint.dedupPath;
+        checkpoint.dedupPath = options.checkpointPath + ".dedup." + std::to_string(end);
+        saveDedupIndex(checkpoint.dedupPath, uniqueFilter);
+        syncFile(checkpoint.dedupPath);
+
+        checkpoint.inputOffset = end;
+        checkpoint.rows += lines.size();
+        checkpoint.uniques += uniqueLines.size();
+        saveCheckpoint(options.checkpointPath, checkpoint);
+        if (!previousDedup.empty() && previousDedup != checkpoint.dedupPath) {
+            std::error_code error;
+            std::filesystem::remove(previousDedup, error);
+        }
+        progress.add(end - begin);
+    }
+
+    if (output) {
+        output->close();
+    }
+    if (!options.dedupIndexPath.empty()) {
+        saveDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+    removeCheckpoint(options.checkpointPath, checkpoint);
+
+    NormalizeResult result;
+    result.rows = checkpoint.rows;
+    result.uniques = checkpoint.uniques;
+    result.metrics.bytesIn = text.size();
+    result.metrics.lines = checkpoint.rows;
+    result.metrics.threads = numThreads;
+    return result;
+}
+
+/**
+ * @brief Normalize several files with one shared dedup state
+ *
+ * Workers take whole files from the list, largest first, and read them
+ * concurrently. Unique lines are written as soon as their file is done;
+ * with preserveOrder, files are deduplicated and written in expansion order
+ * instead, so the first occurrence across all files wins.
+ *
+ * @param files Files to read, largest first
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progress Progress reporter of the operation
+ * @param options Normalization options
+ * @return NormalizeResult Results of the normalization operation
+ */
+NormalizeResult normalizeFileSet(
+    const std::vector<InputFile>& files,
+    const std::string& outputPath,
+    ProgressReporter& progress,
+    const NormalizeOptions& options
+) {
+    if (options.sampleSize > 0) {
+        throw std::invalid_argument("Sampling is not supported with multiple input files");
+    }
+    if (!options.checkpointPath.empty()) {
+        throw std::invalid_argument("Checkpointing takes a single input file");
+    }
+
+    uint64_t totalBytes = 0;
+    for (const auto& file : files) {
+        totalBytes += file.size;
+    }
+
+    // Workers take whole files, so there are never more of them than files
+    TuningChoice tuning = tuneNormalize(options, totalBytes, 0);
+    tuning.threads = static_cast<uint32_t>(std::max<size_t>(1, std::min<size_t>(tuning.threads, files.size())));
+    tuning.variant = tuning.threads > 1 ? "parallel" : "serial";
+    unsigned int numThreads = tuning.threads;
+
+    ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate, 0, options.preserveOrder ? 1 : 0);
+    if (!options.dedupIndexPath.empty()) {
+        loadDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+
+    std::unique_ptr<NearDuplicateFilter> nearFilter;
+    if (options.nearDupDistance > 0) {
+        nearFilter = std::make_unique<NearDuplicateFilter>(
+            options.nearDupDistance, static_cast<size_t>(options.nearDupMaxLines));
+    }
+
+    std::unique_ptr<ExternalDedup> spill;
+    if (options.externalDedup) {
+        StreamingConfig config;
+        if (options.maxMemoryUsage > 0) {
+            config.maxMemoryUsage = static_cast<size_t>(options.maxMemoryUsage);
+        }
+        if (!options.tempDir.empty()) {
+            config.tempDir = options.tempDir;
+        }
+        spill = std::make_unique<ExternalDedup>(
+            config.tempDir, config.maxMemoryUsage, totalBytes, options.bloomFalsePositiveRate);
+    }
+    std::unique_ptr<ExternalSort> sorter;
+    if (options.sortedOutput) {
+        StreamingConfig config;
+        if (options.maxMemoryUsage > 0) {
+            config.maxMemoryUsage = static_cast<size_t>(options.maxMemoryUsage);
+        }
+        if (!options.tempDir.empty()) {
+            config.tempDir = options.tempDir;
+        }
+        sorter = std::make_unique<ExternalSort>(config.tempDir, config.maxMemoryUsage);
+    }
+
+    std::unique_ptr<RunOutput> output = openOutput(outputPath, options);
+    std::ostream outputStream(output ? output->buffer() : nullptr);
+
+    // Workers hand finished files to the writer thread instead of writing them;
+    // shards have a lock each, so workers write to them directly
+    std::unique_ptr<BackgroundWriter> background;
+    if (output && !output->sharded()) {
+        background = std::make_unique<BackgroundWriter>();
+    }
+
+    std::mutex outputMutex;
+    uint64_t uniques = 0;
+    auto writeLines = [&](std::vector<std::string>&& lines) {
+        uniques += lines.size();
+        if (background) {
+            background->submit([&output, lines = std::move(lines)]() {
+                output->writeLines(lines);
+            });
+        } else if (output) {
+            output->writeLines(lines);
+        }
+    };
+
+    // Ordered runs park finished files until every earlier file is written
+    std::map<size_t, std::vector<std::string>> pending;
+    size_t nextOrder = 0;
+
+    std::atomic<size_t> nextFile(0);
+    std::atomic<uint64_t> rows(0);
+    std::optional<WorkerPlacement> placement;
+    if (options.numaAware) {
+        placement.emplace(NumaTopology::system(), numThreads);
+    }
+    parallel::TaskGroup group("normalize");
+
+    auto worker = [&](unsigned int slot) {
+        ThreadPin pin(placement ? &*placement : nullptr, slot);
+        std::string buffer;
+        while (!group.failed()) {
+            size_t index = nextFile.fetch_add(1);
+            if (index >= files.size()) {
+                return;
+            }
+            const InputFile& file = files[index];
+
+            std::unique_ptr<std::istream> input = openInputStream(file.path);
+            readInputBuffer(*input, static_cast<size_t>(file.size), buffer, [](size_t) {});
+            std::vector<std::string_view> lines = splitLineViews(buffer);
+            rows += lines.size();
+
+            if (spill) {
+                spill->add(normalizeLines(lines.begin(), lines.end(), options));
+            } else if (sorter) {
+                sorter->add(normalizeLines(lines.begin(), lines.end(), options));
+            } else if (options.preserveOrder) {
+                std::vector<std::string> normalized = normalizeLines(lines.begin(), lines.end(), options);
+                std::lock_guard<std::mutex> lock(outputMutex);
+                pending.emplace(file.order, std::move(normalized));
+                for (auto it = pending.find(nextOrder); it != pending.end(); it = pending.find(nextOrder)) {
+                    writeLines(dropDuplicates(std::move(it->second), uniqueFilter, nearFilter.get(),
+                                              options.dedupColumns));
+                    pending.erase(it);
+                    nextOrder++;
+                }
+            } else {
+                std::vector<std::string> result =
+                    processBatch(lines.data(), lines.size(), options, uniqueFilter, nearFilter.get());
+                if (output && output->sharded()) {
+                    output->writeLines(result);
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    uniques += result.size();
+                } else {
+                    std::lock_guard<std::mutex> lock(outputMutex);
+                    writeLines(std::move(result));
+                }
+            }
+
+            progress.add(file.size);
+        }
+    };
+
+    // Reading and processing overlap, so report a single processing phase
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 0.95, totalBytes);
+    for (unsigned int i = 0; i < numThreads; ++i) {
+        group.run([&worker, i]() { worker(i); });
+    }
+    group.wait();
+    progress.endPhase();
+    if (background) {
+        background->finish();
+    }
+
+    if (spill) {
+        uniques = spill->finish(output ? &outputStream : nullptr);
+    } else if (sorter) {
+        uniques = sorter->finish(output ? &outputStream : nullptr);
+    }
+    if (output) {
+        output->close();
+    }
+
+    if (!options.dedupIndexPath.empty()) {
+        saveDedupIndex(options.dedupIndexPath, uniqueFilter);
+    }
+
+    NormalizeResult result;
+    result.rows = rows.load();
+    result.uniques = uniques;
+    result.metrics.bytesIn = totalBytes;
+    result.metrics.lines = result.rows;
+    return withTuning(result, tuning);
+}
+
+} // namespace
+
 NormalizeResult normalize(
     const std::string& inputPath,
     const std::string& outputPath,
     const NormalizeOptions& options
 ) {
+    parallel::TraceScope span("normalize", "operation");
+
     // Use structured callback if provided, otherwise use simple callback
     if (options.structuredProgressCallback) {
         return normalizeWithStructuredProgress(inputPath, outputPath, options.structuredProgressCallback, options);
@@ -35,6 +1036,47 @@ NormalizeResult normalize(
     }
 }
 
+NormalizeResult normalizeFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const NormalizeOptions& options
+) {
+    if (inputPaths.empty()) {
+        throw std::invalid_argument("No input files given");
+    }
+
+    // A lone path keeps the single-input behavior, including stdin
+    if (inputPaths.size() == 1) {
+        return core::normalize(inputPaths.front(), outputPath, options);
+    }
+
+    parallel::TraceScope span("normalize", "operation");
+    validateOptions(options);
+
+    std::function<void(const ProgressInfo&)> progressCallback = options.structuredProgressCallback;
+    if (!progressCallback && options.progressCallback) {
+        progressCallback = [&options](const ProgressInfo& info) {
+            options.progressCallback(info.overallRatio);
+        };
+    }
+
+    const NormalizeOptions planned = withinMemoryLimit(options, inputPaths);
+    NormalizeResult result = withTotals(measureMemory<NormalizeResult>(
+        progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+            ProgressReporter progress(tracked, planned.progressStep);
+            return normalizeFileSet(expandInputPaths(inputPaths), outputPath, progress, planned);
+        }));
+
+    if (progressCallback) {
+        ProgressInfo info;
+        info.phase = ProgressInfo::Phase::Complete;
+        info.phaseRatio = 1.0;
+        info.overallRatio = 1.0;
+        progressCallback(info);
+    }
+    return result;
+}
+
 NormalizeResult normalizeWithProgress(
     const std::string& inputPath,
     const std::string& outputPath,
@@ -100,8 +1142,12 @@ std::vector<std::string> processBatch(
     const std::vector<std::string>& lines,
     const NormalizeOptions& options
 ) {
-    return processBatch(lines, options.form, options.bloomFalsePositiveRate,
-                       options.minLength, options.maxLength);
+    if (options.normalizeColumns.empty() && options.dedupColumns.empty()) {
+        return processBatch(lines, options.form, options.bloomFalsePositiveRate,
+                           options.minLength, options.maxLength);
+    }
+    ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate, lines.size(), 1);
+    return normalizeRange(lines.begin(), lines.end(), options, uniqueFilter, nullptr);
 }
 
 std::vector<std::string> processBatch(
@@ -111,31 +1157,18 @@ std::vector<std::string> processBatch(
     uint32_t minLength,
     uint32_t maxLength
 ) {
-    std::unordered_set<std::string> uniqueSet;
+    DedupFilter uniqueFilter(bloomFalsePositiveRate, lines.size());
     std::vector<std::string> result;
 
     // Process each line according to specification
+    std::string normalizedLine;
     for (const auto& line : lines) {
-        // Check length filters before normalization to save processing time
-        if (shouldExcludeLine(line, minLength, maxLength)) {
-            continue;
-        }
-
-        // Normalize the line (normalizeLine handles whitespace-only lines)
-        std::string normalizedLine = normalizeLine(line, form);
-
-        // Skip empty lines (normalizeLine returns empty string for lines to exclude)
-        if (normalizedLine.empty()) {
-            continue;
-        }
-
-        // Apply length filters to normalized line as well
-        if (shouldExcludeLine(normalizedLine, minLength, maxLength)) {
+        if (!normalizeForOutput(line, form, minLength, maxLength, normalizedLine)) {
             continue;
         }
 
         // Check for duplicates using xxHash64 and Bloom filter
-        if (!isDuplicate(normalizedLine, uniqueSet, bloomFalsePositiveRate)) {
+        if (!isDuplicate(normalizedLine, uniqueFilter)) {
             result.push_back(normalizedLine);
         }
     }
@@ -143,46 +1176,57 @@ std::vector<std::string> processBatch(
     return result;
 }
 
-NormalizeResult normalizeWithStructuredProgress(
+std::vector<std::string> processBatch(
+    const std::vector<std::string>& lines,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter
+) {
+    return normalizeRange(lines.begin(), lines.end(), options, uniqueFilter, nearFilter);
+}
+
+std::vector<std::string> processBatch(
+    const std::string_view* lines,
+    size_t count,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter
+) {
+    return normalizeRange(lines, lines + count, options, uniqueFilter, nearFilter);
+}
+
+namespace {
+
+/**
+ * @brief Normalize one input, to an output or into memory
+ *
+ * @param inputPath Input path, directory or glob ("-" for stdin)
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback (may be empty)
+ * @param options Normalization options
+ * @param memoryOutput Receives the unique lines instead of the output, or nullptr
+ * @return NormalizeResult Results of the normalization operation
+ */
+NormalizeResult normalizeInput(
     const std::string& inputPath,
     const std::string& outputPath,
     const std::function<void(const ProgressInfo&)>& progressCallback,
-    const NormalizeOptions& options
+    const NormalizeOptions& options,
+    std::vector<std::string>* memoryOutput
 ) {
     try {
-        // Validate options
-        if (options.minLength > 0 && options.maxLength > 0 && options.minLength > options.maxLength) {
-            throw std::invalid_argument("Invalid length filters: min-length (" +
-                                       std::to_string(options.minLength) +
-                                       ") cannot be greater than max-length (" +
-                                       std::to_string(options.maxLength) + ")");
-        }
-        
-        // Validate bloom filter false positive rate
-        if (options.bloomFalsePositiveRate <= 0.0 || options.bloomFalsePositiveRate >= 1.0) {
-            throw std::invalid_argument("Invalid bloomFalsePositiveRate: " +
-                                       std::to_string(options.bloomFalsePositiveRate) +
-                                       " (must be between 0.0 and 1.0)");
-        }
-        
-        // Validate progress step
-        if (options.progressStep <= 0.0 || options.progressStep > 1.0) {
-            throw std::invalid_argument("Invalid progressStep: " +
-                                       std::to_string(options.progressStep) +
-                                       " (must be between 0.0 and 1.0)");
-        }
-
-        // Track last reported progress to avoid excessive callbacks
-        // Use atomic for thread safety
-        std::atomic<double> lastReportedProgress{0.0};
-
-        // Initial progress report
-        ProgressInfo info;
-        info.phase = ProgressInfo::Phase::Reading;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.0;
-        if (progressCallback) {
-            progressCallback(info);
+        validateOptions(options);
+
+        // Workers only count what they did; the reporter thread builds and reports the progress
+        ProgressReporter progress(progressCallback, options.progressStep);
+        progress.beginPhase(ProgressInfo::Phase::Reading, 0.0, 0.5);
+
+        // Directories and globs expand into a multi-file run
+        if (isInputPattern(inputPath)) {
+            NormalizeResult result = normalizeFileSet(
+                expandInputPaths({inputPath}), outputPath, progress, options);
+            progress.complete();
+            return result;
         }
 
         // Check if input is stdin or if file exists
@@ -191,14 +1235,9 @@ NormalizeResult normalizeWithStructuredProgress(
             throw std::runtime_error("Input file does not exist: " + inputPath);
         }
 
-        // Determine number of threads
-        unsigned int numThreads = options.threads;
-        if (numThreads == 0) {
-            numThreads = std::thread::hardware_concurrency();
-        }
+        // Reading and decompression use every thread asked for; processing is tuned below
+        unsigned int numThreads = resolveThreads(options.threads);
 
-        // Read all lines from the input file
-        std::vector<std::string> allLines;
         size_t fileSize = 0;
 
         try {
@@ -207,244 +1246,252 @@ NormalizeResult normalizeWithStructuredProgress(
             // Continue without progress reporting
         }
 
-        // Read lines from stdin or file
-        std::string line;
-        size_t bytesRead = 0;
-
-        if (isStdin) {
-            // Read from stdin
-            while (std::getline(std::cin, line)) {
-                allLines.push_back(line);
-                bytesRead += line.size() + 1; // +1 for newline
+        // The on-disk size of a compressed file says nothing about how much text it holds
+        bool compressed = !isStdin && detectFileCompression(inputPath) != Compression::None;
+        if (compressed) {
+            fileSize = 0;
+        }
 
-                // Update progress info (less frequently for stdin)
-                if (allLines.size() % 1000 == 0) {
-                    info.phase = ProgressInfo::Phase::Reading;
-                    info.phaseRatio = 0.5; // Assume we're halfway through for stdin
-                    info.overallRatio = 0.25; // Reading is about 50% of total work
-                    info.processedBytes = bytesRead;
-                    info.totalBytes = 0; // Unknown for stdin
+        if (!options.checkpointPath.empty()) {
+            TuningChoice tuning = tuneNormalize(options, fileSize, 0);
+            NormalizeResult result = withTuning(
+                normalizeCheckpointed(inputPath, outputPath, progress, options, tuning.threads), tuning);
+            progress.complete();
+            return result;
+        }
 
-                    if (progressCallback) {
-            progressCallback(info);
+        // Streaming mode never holds the whole input in memory. A sample is
+        // bounded by its size, so sampled runs always take the in-memory path.
+        if ((options.streaming || options.externalDedup || options.sortedOutput) && options.sampleSize == 0) {
+            TuningChoice tuning = tuneNormalize(options, fileSize, 0);
+            NormalizeResult result = withTuning(normalizeStreaming(
+                inputPath, outputPath, progress, options, tuning.threads, fileSize), tuning);
+            progress.complete();
+            return result;
         }
-                    lastReportedProgress.store(info.overallRatio);
-                }
-            }
+
+        // Map the input, or read it whole into one contiguous buffer; lines are views into either
+        std::string inputBuffer;
+        std::unique_ptr<MappedText> mappedInput;
+        size_t bytesRead = 0;
+
+        // Reading is about half of the work; stdin and compressed input have no known size
+        progress.setPhaseTotal(fileSize);
+        auto readProgress = [&](size_t totalRead) {
+            progress.add(totalRead - bytesRead);
+            bytesRead = totalRead;
+        };
+
+        // Sampled lines are kept here and handed to the workers as views
+        std::vector<std::string> sampledLines;
+        bool sampling = options.sampleSize > 0;
+        size_t sampleSize = static_cast<size_t>(options.sampleSize);
+
+        bool mappedSample = sampling && !isStdin && !compressed;
+        if (mappedSample) {
+            // Mapped files are sampled in place, without reading the whole input
+            sampledLines = sampleLines(inputPath, sampleSize, options.sampleSeed, numThreads);
+            readProgress(fileSize);
+        } else if (!isStdin && !compressed && !sampling) {
+            mappedInput = std::make_unique<MappedText>(inputPath);
+            readProgress(mappedInput->text().size());
         } else {
-            // Open input file
-            std::ifstream inputFile(inputPath, std::ios::binary);
-            if (!inputFile) {
-                throw std::runtime_error("Failed to open input file: " + inputPath);
-            }
+            std::unique_ptr<std::istream> input = openInputStream(inputPath, numThreads);
+            readInputBuffer(*input, fileSize, inputBuffer, readProgress);
+        }
 
-            // Read lines from file
-            while (std::getline(inputFile, line)) {
-            allLines.push_back(line);
-
-            bytesRead += line.size() + 1; // +1 for newline
-
-            // Limit progress reporting frequency to reduce potential memory issues
-            // Only report progress at 25%, 50%, 75% of file reading
-            if (fileSize > 0) {
-                double progress = static_cast<double>(bytesRead) / fileSize;
-
-                // Update progress info
-                info.phase = ProgressInfo::Phase::Reading;
-                info.phaseRatio = progress;
-                info.overallRatio = progress * 0.5; // Reading is about 50% of total work
-                info.processedBytes = bytesRead;
-                info.totalBytes = fileSize;
-
-                // Report at specific thresholds or if significant progress made
-                if (progressCallback) {
-                    double currentProgress = lastReportedProgress.load();
-                    if (info.overallRatio >= currentProgress + options.progressStep ||
-                        (progress >= 0.99 && currentProgress < 0.49)) {
-                        if (progressCallback) {
-            progressCallback(info);
-        }
-                        lastReportedProgress.store(info.overallRatio);
-                    }
-                }
-            }
-            }
+        if (sampling && !mappedSample) {
+            sampledLines = sampleLineBuffer(inputBuffer.data(), inputBuffer.size(), sampleSize,
+                                            options.sampleSeed, numThreads);
+            std::string().swap(inputBuffer);
         }
 
-        // Update progress after reading complete
-        info.phase = ProgressInfo::Phase::Processing;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.5; // Reading phase complete
-        if (progressCallback) {
-            progressCallback(info);
+        std::vector<std::string_view> allLines;
+        if (sampling) {
+            allLines.assign(sampledLines.begin(), sampledLines.end());
+        } else if (mappedInput) {
+            allLines = splitLineViews(mappedInput->text());
+        } else {
+            allLines = splitLineViews(inputBuffer);
+            bytesRead = inputBuffer.size();
         }
-        lastReportedProgress.store(info.overallRatio);
+        // Mapped input is page cache; a read buffer and the views are held until the end
+        MemoryCharge lineMemory(MemorySubsystem::Lines, inputBuffer.capacity() +
+                                sampledLines.capacity() * sizeof(std::string) +
+                                allLines.capacity() * sizeof(std::string_view));
+
+        // Processing is about 40% of the work, counted in lines
+        progress.beginPhase(ProgressInfo::Phase::Processing, 0.5, 0.9, allLines.size(), bytesRead);
 
         // Process in parallel or single-threaded based on input size
         std::vector<std::string> uniqueLines;
+        const TuningChoice tuning = tuneNormalize(options, bytesRead, allLines.size());
+        numThreads = tuning.threads;
+        bool useParallel = allLines.size() > kMinParallelLines && numThreads > 1;
+
+        // Dedup state; a single shard suffices without concurrent workers
+        ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate, allLines.size(),
+                                           useParallel && !options.preserveOrder ? 0 : 1);
+        if (!options.dedupIndexPath.empty()) {
+            loadDedupIndex(options.dedupIndexPath, uniqueFilter);
+        }
+
+        std::unique_ptr<NearDuplicateFilter> nearFilter;
+        if (options.nearDupDistance > 0) {
+            nearFilter = std::make_unique<NearDuplicateFilter>(
+                options.nearDupDistance, static_cast<size_t>(options.nearDupMaxLines));
+        }
+
+        // Chunks finished in order are written on a writer thread while later ones
+        // are computed. An output that is also the input is written at the end,
+        // only once the input is no longer read. Unordered sharded output is
+        // written by the workers themselves, each chunk as soon as it is done.
+        std::unique_ptr<RunOutput> backgroundOutput;
+        std::unique_ptr<BackgroundWriter> background;
+        bool directOutput = false;
+        std::atomic<size_t> uniqueCount(0);
+        if (useParallel && !memoryOutput && outputPath != "null" && !sameFile(inputPath, outputPath)) {
+            backgroundOutput = openOutput(outputPath, options);
+            if (backgroundOutput->sharded() && !options.preserveOrder) {
+                directOutput = true;
+            } else {
+                background = std::make_unique<BackgroundWriter>();
+            }
+        }
 
         // Use parallel processing for larger inputs
-        if (allLines.size() > 100 && numThreads > 1) {
-            // Calculate chunk size
-            size_t chunkSize = allLines.size() / numThreads;
+        if (useParallel) {
+            // More chunks than threads let the first ones be written while the rest run
+            size_t chunkCount = background || directOutput ? numThreads * kChunksPerThread : numThreads;
+            size_t chunkSize = allLines.size() / chunkCount;
             if (chunkSize == 0) chunkSize = 1;
 
             // Create threads
-            std::vector<std::thread> threads;
-            std::vector<std::vector<std::string>> threadResults(numThreads);
-            std::mutex progressMutex;
-            std::atomic<size_t> processedLines(0);
-
-            // Launch threads
-            for (unsigned int i = 0; i < numThreads; ++i) {
-                size_t start = i * chunkSize;
-                size_t end = (i == numThreads - 1) ? allLines.size() : (i + 1) * chunkSize;
-
-                threads.emplace_back([&, i, start, end]() {
-                    // Extract chunk
-                    std::vector<std::string> chunk(allLines.begin() + start, allLines.begin() + end);
-
-                    // Process chunk
-                    threadResults[i] = processBatch(chunk, options);
-
-                    // Update processed lines count
-                    processedLines += (end - start);
-
-                    // Minimize progress callbacks to reduce memory issues
-                    // Only report at specific thread completion milestones
-                    if (!allLines.empty()) {
-                        // Calculate current progress ratio
-                        double progressRatio = static_cast<double>(processedLines.load()) / allLines.size();
-
-                        // Update progress info
-                        ProgressInfo threadInfo;
-                        threadInfo.phase = ProgressInfo::Phase::Processing;
-                        threadInfo.phaseRatio = progressRatio;
-                        threadInfo.overallRatio = 0.5 + progressRatio * 0.4; // Processing is 40% of total work
-                        threadInfo.processedBytes = bytesRead;
-                        threadInfo.totalBytes = fileSize;
-
-                        // Report progress if significant and callback exists
-                        if (progressCallback) {
-                            double currentProgress = lastReportedProgress.load();
-                            if (threadInfo.overallRatio >= currentProgress + options.progressStep) {
-                                std::lock_guard<std::mutex> lock(progressMutex);
-                                // Re-check after acquiring lock to ensure monotonic progress
-                                double lockedProgress = lastReportedProgress.load();
-                                if (threadInfo.overallRatio > lockedProgress) {
-                                    progressCallback(threadInfo);
-                                    lastReportedProgress.store(threadInfo.overallRatio);
-                                }
-                            }
-                        }
+            parallel::TaskGroup group("normalize");
+            std::vector<std::vector<std::string>> threadResults(chunkCount);
+            std::vector<bool> chunkDone(chunkCount, false);
+            size_t nextChunk = 0;
+            std::mutex chunkMutex;
+
+            // Hand finished chunks to the writer in chunk order; with preserveOrder
+            // their duplicates are dropped here, so the first occurrence wins
+            auto releaseChunks = [&](size_t chunk) {
+                std::lock_guard<std::mutex> lock(chunkMutex);
+                chunkDone[chunk] = true;
+                while (nextChunk < chunkCount && chunkDone[nextChunk]) {
+                    std::vector<std::string>& result = threadResults[nextChunk++];
+                    if (options.preserveOrder) {
+                        result = dropDuplicates(std::move(result), uniqueFilter, nearFilter.get(), options.dedupColumns);
                     }
-                });
-            }
-
-            // Wait for all threads to complete
-            for (auto& thread : threads) {
-                thread.join();
+                    uniqueCount += result.size();
+                    background->submit([&backgroundOutput, lines = std::move(result)]() {
+                        backgroundOutput->writeLines(lines);
+                    });
+                }
+            };
+            std::optional<WorkerPlacement> placement;
+            if (options.numaAware) {
+                placement.emplace(NumaTopology::system(), numThreads);
             }
 
-            // Merge results
-            std::unordered_set<std::string> uniqueSet;
-            for (const auto& result : threadResults) {
-                for (const auto& line : result) {
-                    if (!line.empty() && uniqueSet.find(line) == uniqueSet.end()) {
-                        uniqueSet.insert(line);
-                        uniqueLines.push_back(line);
+            // One task per chunk; the chunks keep the output order of earlier versions
+            for (size_t i = 0; i < chunkCount; ++i) {
+                size_t start = std::min(i * chunkSize, allLines.size());
+                size_t end = (i == chunkCount - 1) ? allLines.size() : std::min((i + 1) * chunkSize, allLines.size());
+
+                group.run([&, i, start, end]() {
+                    // Results are built after pinning, so they live on the worker's node
+                    ThreadPin pin(placement ? &*placement : nullptr, i % numThreads);
+                    // Process the chunk in place; no per-line copies
+                    if (options.preserveOrder) {
+                        // Dedup happens after the join so the first occurrence wins
+                        threadResults[i] = normalizeLines(allLines.data() + start, allLines.data() + end, options);
+                    } else {
+                        threadResults[i] = processBatch(allLines.data() + start, end - start, options, uniqueFilter,
+                                                         nearFilter.get());
                     }
-                }
-            }
-        } else {
-            // Process all lines in single-threaded mode
-            uniqueLines = processBatch(allLines, options);
 
-            // Update progress for processing phase
-            info.phase = ProgressInfo::Phase::Processing;
-            info.phaseRatio = 1.0;
-            info.overallRatio = 0.9; // Processing complete
-            if (progressCallback) {
-            progressCallback(info);
-        }
-            lastReportedProgress.store(info.overallRatio);
-        }
+                    if (background) {
+                        releaseChunks(i);
+                    } else if (directOutput) {
+                        backgroundOutput->writeLines(threadResults[i]);
+                        uniqueCount += threadResults[i].size();
+                        std::vector<std::string>().swap(threadResults[i]);
+                    }
 
-        // Update progress for writing phase
-        info.phase = ProgressInfo::Phase::Writing;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.9;
-        if (progressCallback) {
-            progressCallback(info);
-        }
-        lastReportedProgress.store(info.overallRatio);
+                    progress.add(end - start);
+                });
+            }
 
-        // Check if output is null (special case for no output) or stdout
-        bool isStdout = (outputPath == "-");
+            // Wait for all chunks; the first failure is rethrown here
+            group.wait();
 
-        if (outputPath != "null") {
-            if (isStdout) {
-                // Write to stdout
-                for (const auto& line : uniqueLines) {
-                    std::cout << line << '\n';
+            if (backgroundOutput) {
+                // Only the chunks still queued are left to write
+                if (background) {
+                    background->finish();
                 }
-                std::cout.flush();
+                backgroundOutput->close();
             } else {
-                // Create directory if it doesn't exist
-                std::filesystem::path filePath(outputPath);
-
-                try {
-                    // Check if the path exists and is a directory
-                    if (std::filesystem::exists(outputPath) && std::filesystem::is_directory(outputPath)) {
-                        throw std::runtime_error("Cannot write to '" + outputPath + "' because it is a directory");
-                    }
-
-                    // Check if the parent path exists or can be created
-                    if (!filePath.parent_path().empty()) {
-                        std::filesystem::create_directories(filePath.parent_path());
-                    }
-                } catch (const std::filesystem::filesystem_error& e) {
-                    // Handle filesystem errors
-                    throw std::runtime_error("Failed to create directory for output file: " +
-                                            std::string(e.what()));
+                // Concatenate results; duplicates were already dropped by the workers
+                // unless input order is preserved, in which case they go here in chunk order
+                size_t totalUnique = 0;
+                for (const auto& result : threadResults) {
+                    totalUnique += result.size();
                 }
-
-                // Open output file
-                std::ofstream outputFile(outputPath, std::ios::binary);
-                if (!outputFile) {
-                    // Provide more detailed error message based on errno
-                    std::string errorMsg;
-                    if (errno == EACCES || errno == EPERM) {
-                        errorMsg = "Permission denied: Cannot write to " + outputPath;
-                    } else if (errno == ENOENT) {
-                        errorMsg = "Directory does not exist: " + outputPath;
-                    } else if (errno == EISDIR) {
-                        errorMsg = "Cannot write to '" + outputPath + "' because it is a directory";
-                    } else {
-                        errorMsg = "Failed to open output file: " + outputPath;
+                uniqueLines.reserve(totalUnique);
+                for (auto& result : threadResults) {
+                    if (options.preserveOrder) {
+                        result = dropDuplicates(std::move(result), uniqueFilter, nearFilter.get(), options.dedupColumns);
                     }
-                    throw std::runtime_error(errorMsg);
-                }
-
-                // Write unique lines to output
-                for (const auto& line : uniqueLines) {
-                    outputFile << line << '\n';
+                    std::move(result.begin(), result.end(), std::back_inserter(uniqueLines));
                 }
             }
+        } else {
+            // Process all lines in single-threaded mode
+            uniqueLines = processBatch(allLines.data(), allLines.size(), options, uniqueFilter,
+                                       nearFilter.get());
+        }
+        progress.endPhase();
+
+        progress.beginPhase(ProgressInfo::Phase::Writing, 0.9, 1.0);
+
+        // The input is no longer viewed; unmap it before the output may replace it
+        mappedInput.reset();
+        size_t rows = allLines.size();
+        allLines.clear();
+
+        // Write unique lines to the output, unless they are kept in memory
+        // or the output is null (special case for no output)
+        if (memoryOutput || backgroundOutput) {
+            // Handed over below, once the counts are taken, or already written
+        } else if (std::unique_ptr<RunOutput> output = openOutput(outputPath, options)) {
+            output->writeLines(uniqueLines);
+            output->close();
         }
 
-        // Final progress update
-        info.phase = ProgressInfo::Phase::Complete;
-        info.phaseRatio = 1.0;
-        info.overallRatio = 1.0;
-        if (progressCallback) {
-            progressCallback(info);
+        // Persist the updated index only once the output is complete
+        if (!options.dedupIndexPath.empty()) {
+            saveDedupIndex(options.dedupIndexPath, uniqueFilter);
         }
 
+        progress.complete();
+
         // Return results
         NormalizeResult result;
-        result.rows = allLines.size();
-        result.uniques = uniqueLines.size();
+        result.rows = rows;
+        result.uniques = backgroundOutput ? uniqueCount.load() : uniqueLines.size();
+        result.metrics.bytesIn = bytesRead;
+        result.metrics.lines = rows;
+        result.metrics.threads = useParallel ? numThreads : 1;
+        result.metrics.tuning = tuning;
+        if (!useParallel) {
+            result.metrics.tuning.threads = 1;
+            result.metrics.tuning.variant = "serial";
+        }
+        if (memoryOutput) {
+            *memoryOutput = std::move(uniqueLines);
+        }
         return result;
     } catch (const std::exception& e) {
         std::cerr << "Exception in normalize(): " << e.what() << std::endl;
@@ -475,5 +1522,39 @@ NormalizeResult normalizeWithStructuredProgress(
     }
 }
 
+} // namespace
+
+NormalizeResult normalizeWithStructuredProgress(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const NormalizeOptions& options
+) {
+    const NormalizeOptions planned = withinMemoryLimit(options, {inputPath});
+    return withTotals(measureMemory<NormalizeResult>(
+        progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+            return normalizeInput(inputPath, outputPath, tracked, planned, nullptr);
+        }));
+}
+
+NormalizeResult normalizeToMemory(
+    const std::string& inputPath,
+    std::vector<std::string>& uniqueLines,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const NormalizeOptions& options
+) {
+    if (isInputPattern(inputPath)) {
+        throw std::invalid_argument("Normalizing into memory takes a single input file: " + inputPath);
+    }
+    if (options.streaming || options.externalDedup || options.sortedOutput || !options.checkpointPath.empty()) {
+        throw std::invalid_argument("Streaming, external dedup, sorted output and checkpoints cannot be used when "
+                                    "normalizing into memory");
+    }
+    return withTotals(measureMemory<NormalizeResult>(
+        progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+            return normalizeInput(inputPath, "null", tracked, options, &uniqueLines);
+        }));
+}
+
 } // namespace core
 } // namespace suzume
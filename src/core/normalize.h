@@ -7,11 +7,14 @@
 #define SUZUME_CORE_NORMALIZE_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <cstdint>
 #include "suzume_feedmill.h"
 #include "buffer_api.h"
+#include "dedup.h"
+#include "near_dedup.h"
 
 namespace suzume {
 namespace core {
@@ -30,6 +33,25 @@ NormalizeResult normalize(
     const NormalizeOptions& options = NormalizeOptions()
 );
 
+/**
+ * @brief Normalize several input files into one output
+ *
+ * Entries may be files, directories or globs (see expandInputPaths()).
+ * Files are read concurrently, largest first, and share one dedup state, so
+ * a line is kept only once across all files. The single-path functions
+ * accept a directory or glob as well.
+ *
+ * @param inputPaths Input files, directories or globs
+ * @param outputPath Path to output TSV file
+ * @param options Normalization options
+ * @return NormalizeResult Results of the normalization operation
+ */
+NormalizeResult normalizeFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const NormalizeOptions& options = NormalizeOptions()
+);
+
 /**
  * @brief Normalize text data with progress reporting
  *
@@ -62,6 +84,27 @@ NormalizeResult normalizeWithStructuredProgress(
     const NormalizeOptions& options = NormalizeOptions()
 );
 
+/**
+ * @brief Normalize text data into memory instead of an output file
+ *
+ * Runs the in-memory path of normalize() and hands over the unique lines,
+ * in the order normalize() would write them. Streaming and external dedup
+ * exist to avoid holding the input in memory and are rejected.
+ *
+ * @param inputPath Path to input file ("-" for stdin)
+ * @param uniqueLines Receives the normalized unique lines
+ * @param progressCallback Structured progress callback (may be empty)
+ * @param options Normalization options
+ * @return NormalizeResult Results of the normalization operation
+ * @throws std::invalid_argument If the input is a pattern or streaming is requested
+ */
+NormalizeResult normalizeToMemory(
+    const std::string& inputPath,
+    std::vector<std::string>& uniqueLines,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const NormalizeOptions& options
+);
+
 /**
  * @brief Process a batch of lines for normalization
  *
@@ -106,6 +149,45 @@ std::vector<std::string> processBatch(
     const NormalizeOptions& options
 );
 
+/**
+ * @brief Process a batch of lines against a dedup filter shared between workers
+ *
+ * Lines already inserted by other batches are dropped as duplicates.
+ *
+ * @param lines Input lines
+ * @param options Normalization options
+ * @param uniqueFilter Shared dedup filter
+ * @param nearFilter Shared near-duplicate filter (nullptr = exact dedup only)
+ * @return std::vector<std::string> Normalized lines not seen before
+ */
+std::vector<std::string> processBatch(
+    const std::vector<std::string>& lines,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter = nullptr
+);
+
+/**
+ * @brief Process a range of line views against a shared dedup filter
+ *
+ * The views point into the caller's input buffer, so workers read their
+ * slice in place instead of copying it.
+ *
+ * @param lines First line of the range
+ * @param count Number of lines
+ * @param options Normalization options
+ * @param uniqueFilter Shared dedup filter
+ * @param nearFilter Shared near-duplicate filter (nullptr = exact dedup only)
+ * @return std::vector<std::string> Normalized lines not seen before
+ */
+std::vector<std::string> processBatch(
+    const std::string_view* lines,
+    size_t count,
+    const NormalizeOptions& options,
+    ConcurrentDedupFilter& uniqueFilter,
+    NearDuplicateFilter* nearFilter = nullptr
+);
+
 } // namespace core
 } // namespace suzume
 
@@ -0,0 +1,213 @@
+/**
+ * @file numa_topology.cpp
+ * @brief Implementation of NUMA node discovery and worker placement
+ */
+
+#include "core/numa_topology.h"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <stdexcept>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/**
+ * @brief Read the node CPU lists from sysfs
+ * @return std::vector<std::vector<int>> CPUs per node ordered by node ID (empty if unavailable)
+ */
+std::vector<std::vector<int>> readSystemNodes() {
+    std::map<int, std::vector<int>> nodes;
+    std::error_code error;
+    std::filesystem::directory_iterator it("/sys/devices/system/node", error);
+    if (error) {
+        return {};
+    }
+    for (; it != std::filesystem::directory_iterator(); it.increment(error)) {
+        if (error) {
+            return {};
+        }
+        std::string name = it->path().filename().string();
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0 ||
+            !std::all_of(name.begin() + 4, name.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            continue;
+        }
+        std::ifstream file(it->path() / "cpulist");
+        std::string list;
+        if (!file || !std::getline(file, list)) {
+            continue;
+        }
+        try {
+            nodes[std::stoi(name.substr(4))] = NumaTopology::parseCpuList(list);
+        } catch (const std::exception&) {
+            return {};
+        }
+    }
+
+    std::vector<std::vector<int>> result;
+    for (auto& entry : nodes) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+} // namespace
+
+NumaTopology::NumaTopology(std::vector<std::vector<int>> nodeCpus) {
+    for (auto& cpus : nodeCpus) {
+        if (!cpus.empty()) {
+            nodeCpus_.push_back(std::move(cpus));
+        }
+    }
+    if (nodeCpus_.empty()) {
+        // One node holding every hardware thread
+        unsigned int count = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<int> cpus(count);
+        for (unsigned int i = 0; i < count; ++i) {
+            cpus[i] = static_cast<int>(i);
+        }
+        nodeCpus_.push_back(std::move(cpus));
+    }
+}
+
+const NumaTopology& NumaTopology::system() {
+    static const NumaTopology topology(readSystemNodes());
+    return topology;
+}
+
+std::vector<int> NumaTopology::parseCpuList(const std::string& list) {
+    std::vector<int> cpus;
+    size_t pos = 0;
+    auto readNumber = [&]() {
+        size_t start = pos;
+        int value = 0;
+        while (pos < list.size() && list[pos] >= '0' && list[pos] <= '9') {
+            value = value * 10 + (list[pos] - '0');
+            ++pos;
+        }
+        if (pos == start) {
+            throw std::invalid_argument("Malformed CPU list: " + list);
+        }
+        return value;
+    };
+
+    while (pos < list.size() && list[pos] != '\n') {
+        int first = readNumber();
+        int last = first;
+        if (pos < list.size() && list[pos] == '-') {
+            ++pos;
+            last = readNumber();
+            if (last < first) {
+                throw std::invalid_argument("Malformed CPU list: " + list);
+            }
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+        if (pos < list.size() && list[pos] == ',') {
+            ++pos;
+        } else if (pos < list.size() && list[pos] != '\n') {
+            throw std::invalid_argument("Malformed CPU list: " + list);
+        }
+    }
+    return cpus;
+}
+
+WorkerPlacement::WorkerPlacement(const NumaTopology& topology, size_t workers)
+    : nodes_(workers)
+    , cpus_(workers)
+{
+    const size_t nodeCount = topology.nodeCount();
+    std::vector<size_t> groupOfNode(nodeCount, SIZE_MAX);
+    for (size_t worker = 0; worker < workers; ++worker) {
+        // Consecutive blocks of workers per node, as even as the counts allow
+        size_t node = worker * nodeCount / workers;
+        if (groupOfNode[node] == SIZE_MAX) {
+            groupOfNode[node] = groups_.size();
+            groups_.emplace_back();
+        }
+        std::vector<size_t>& group = groups_[groupOfNode[node]];
+        const std::vector<int>& cpus = topology.cpus(node);
+        nodes_[worker] = node;
+        cpus_[worker] = cpus[group.size() % cpus.size()];
+        group.push_back(worker);
+    }
+}
+
+std::vector<int> WorkerPlacement::groupCpus(size_t group) const {
+    std::vector<int> cpus;
+    for (size_t worker : groups_[group]) {
+        cpus.push_back(cpus_[worker]);
+    }
+    return cpus;
+}
+
+bool pinCurrentThread(const std::vector<int>& cpus) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    bool any = false;
+    for (int cpu : cpus) {
+        if (cpu >= 0 && cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+            any = true;
+        }
+    }
+    return any && sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+ThreadPin::ThreadPin(const WorkerPlacement* placement, size_t worker) {
+    if (placement) {
+        pin({placement->cpuOf(worker)});
+    }
+}
+
+ThreadPin::ThreadPin(const std::vector<int>& cpus) {
+    pin(cpus);
+}
+
+ThreadPin::~ThreadPin() {
+    if (!saved_.empty()) {
+        pinCurrentThread(saved_);
+    }
+}
+
+void ThreadPin::pin(const std::vector<int>& cpus) {
+#ifdef __linux__
+    if (cpus.empty()) {
+        return;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) {
+        return;
+    }
+    std::vector<int> saved;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &set)) {
+            saved.push_back(cpu);
+        }
+    }
+    if (pinCurrentThread(cpus)) {
+        saved_ = std::move(saved);
+    }
+#else
+    (void)cpus;
+#endif
+}
+
+} // namespace core
+} // namespace suzume
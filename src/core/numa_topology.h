@@ -0,0 +1,159 @@
+/**
+ * @file numa_topology.h
+ * @brief NUMA node discovery and worker placement
+ */
+
+#ifndef SUZUME_CORE_NUMA_TOPOLOGY_H_
+#define SUZUME_CORE_NUMA_TOPOLOGY_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief CPUs of each NUMA node
+ *
+ * The system topology comes from /sys/devices/system/node. Hosts without
+ * that directory (or with a single node) are treated as one node holding
+ * every hardware thread.
+ */
+class NumaTopology {
+public:
+    /**
+     * @brief Constructor
+     * @param nodeCpus CPU IDs of each node; empty nodes are dropped
+     */
+    explicit NumaTopology(std::vector<std::vector<int>> nodeCpus);
+
+    /**
+     * @brief Get the topology of this host, read once
+     * @return const NumaTopology& System topology
+     */
+    static const NumaTopology& system();
+
+    /**
+     * @brief Parse a kernel CPU list such as "0-3,8,10-11"
+     * @param list CPU list
+     * @return std::vector<int> CPU IDs in order
+     * @throws std::invalid_argument If the list is malformed
+     */
+    static std::vector<int> parseCpuList(const std::string& list);
+
+    /**
+     * @brief Get the number of nodes
+     * @return size_t Node count (at least 1)
+     */
+    size_t nodeCount() const { return nodeCpus_.size(); }
+
+    /**
+     * @brief Get the CPUs of a node
+     * @param node Node index
+     * @return const std::vector<int>& CPU IDs
+     */
+    const std::vector<int>& cpus(size_t node) const { return nodeCpus_[node]; }
+
+private:
+    std::vector<std::vector<int>> nodeCpus_;
+};
+
+/**
+ * @brief Maps workers to nodes and CPUs
+ *
+ * Workers are split into consecutive blocks, one block per node, so that
+ * neighbouring chunks of work share a node and each node's results can be
+ * merged locally before the global merge. Within a node, workers take the
+ * node's CPUs in order, wrapping around when there are more workers than
+ * CPUs.
+ */
+class WorkerPlacement {
+public:
+    /**
+     * @brief Constructor
+     * @param topology Node topology
+     * @param workers Number of workers
+     */
+    WorkerPlacement(const NumaTopology& topology, size_t workers);
+
+    /**
+     * @brief Get the node of a worker
+     * @param worker Worker index
+     * @return size_t Node index
+     */
+    size_t nodeOf(size_t worker) const { return nodes_[worker]; }
+
+    /**
+     * @brief Get the CPU of a worker
+     * @param worker Worker index
+     * @return int CPU ID
+     */
+    int cpuOf(size_t worker) const { return cpus_[worker]; }
+
+    /**
+     * @brief Get the workers of each node that has any
+     * @return const std::vector<std::vector<size_t>>& Worker indices per node, in order
+     */
+    const std::vector<std::vector<size_t>>& groups() const { return groups_; }
+
+    /**
+     * @brief Get the CPUs of one group of workers
+     * @param group Index into groups()
+     * @return std::vector<int> CPU IDs of the group's workers
+     */
+    std::vector<int> groupCpus(size_t group) const;
+
+private:
+    std::vector<size_t> nodes_;
+    std::vector<int> cpus_;
+    std::vector<std::vector<size_t>> groups_;
+};
+
+/**
+ * @brief Pin the calling thread to a set of CPUs
+ * @param cpus CPU IDs
+ * @return bool True on success (always false where affinity is unsupported)
+ */
+bool pinCurrentThread(const std::vector<int>& cpus);
+
+/**
+ * @brief Pins the calling thread for the lifetime of the object
+ *
+ * Work runs on pooled threads, so the previous affinity of the thread is
+ * restored on destruction. Memory the thread touches first while pinned is
+ * allocated on the pinned node by the kernel's first-touch policy.
+ */
+class ThreadPin {
+public:
+    /**
+     * @brief Pin to the CPU of a worker
+     * @param placement Worker placement, or nullptr to leave the thread alone
+     * @param worker Worker index
+     */
+    ThreadPin(const WorkerPlacement* placement, size_t worker);
+
+    /**
+     * @brief Pin to a set of CPUs
+     * @param cpus CPU IDs (empty = leave the thread alone)
+     */
+    explicit ThreadPin(const std::vector<int>& cpus);
+
+    /**
+     * @brief Destructor; restores the previous affinity
+     */
+    ~ThreadPin();
+
+    ThreadPin(const ThreadPin&) = delete;
+    ThreadPin& operator=(const ThreadPin&) = delete;
+
+private:
+    void pin(const std::vector<int>& cpus);
+
+    std::vector<int> saved_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_NUMA_TOPOLOGY_H_
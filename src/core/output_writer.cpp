@@ -0,0 +1,360 @@
+/**
+ * @file output_writer.cpp
+ * @brief Implementation of buffered output
+ */
+
+#include "core/output_writer.h"
+#include "core/async_io.h"
+#include "core/standard_streams.h"
+#include "parallel/executor.h"
+#include "parallel/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef SUZUME_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/// Longest shortest-form double (sign, 17 digits, point, exponent) with room to spare
+constexpr size_t kMaxNumberChars = 32;
+
+/// Bytes all writers have handed to their files, see outputBytesWritten()
+std::atomic<uint64_t> bytesWritten{0};
+
+/**
+ * @brief Describe a failure to open an output file
+ *
+ * @param path Output file path
+ * @param error errno of the failed open
+ * @return std::string Error message
+ */
+std::string openErrorMessage(const std::string& path, int error) {
+    if (error == EACCES || error == EPERM) {
+        return "Permission denied: Cannot write to " + path;
+    } else if (error == ENOENT) {
+        return "Directory does not exist: " + path;
+    } else if (error == EISDIR) {
+        return "Cannot write to '" + path + "' because it is a directory";
+    }
+    return "Failed to open output file: " + path;
+}
+
+} // namespace
+
+uint64_t outputBytesWritten() {
+    return bytesWritten.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Compresses output blocks in parallel into independent zstd frames
+ */
+class OutputWriter::FrameCompressor {
+public:
+    FrameCompressor(OutputWriter& owner, unsigned int threads)
+        : owner_(owner)
+        , batchSize_(std::max(1u, threads > 0 ? threads : parallel::ThreadPool::global().size()))
+    {
+#ifndef SUZUME_HAVE_ZSTD
+        throw std::runtime_error("zstd output is not supported by this build: " + owner.path_);
+#endif
+    }
+
+    /**
+     * @brief Append uncompressed bytes; full batches of blocks are compressed and written
+     */
+    void add(const char* data, size_t size) {
+        while (size > 0) {
+            size_t take = std::min(size, kFrameSize - current_.size());
+            current_.append(data, take);
+            data += take;
+            size -= take;
+            if (current_.size() == kFrameSize) {
+                blocks_.push_back(std::move(current_));
+                current_.clear();
+                if (blocks_.size() >= batchSize_) {
+                    compressBlocks();
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Compress and write everything added so far, ending the last frame
+     */
+    void flush() {
+        if (!current_.empty()) {
+            blocks_.push_back(std::move(current_));
+            current_.clear();
+        }
+        compressBlocks();
+    }
+
+private:
+    void compressBlocks() {
+        if (blocks_.empty()) {
+            return;
+        }
+#ifdef SUZUME_HAVE_ZSTD
+        frames_.resize(blocks_.size());
+        parallel::ParallelExecutor::parallelFor(blocks_.size(), [this](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                const std::string& block = blocks_[i];
+                std::string& frame = frames_[i];
+                frame.resize(ZSTD_compressBound(block.size()));
+                size_t size = ZSTD_compress(&frame[0], frame.size(), block.data(), block.size(),
+                                            ZSTD_CLEVEL_DEFAULT);
+                if (ZSTD_isError(size)) {
+                    throw std::runtime_error(std::string("zstd compression failed: ") + ZSTD_getErrorName(size));
+                }
+                frame.resize(size);
+            }
+        }, 0, 1);
+        for (const std::string& frame : frames_) {
+            owner_.writeRaw(frame.data(), frame.size());
+        }
+#endif
+        blocks_.clear();
+    }
+
+    OutputWriter& owner_;
+    size_t batchSize_;
+    std::string current_;
+    std::vector<std::string> blocks_;
+    std::vector<std::string> frames_;
+};
+
+bool isCompressedOutputPath(const std::string& path) {
+    const std::string extension = ".zst";
+    return path.size() > extension.size() &&
+           path.compare(path.size() - extension.size(), extension.size(), extension) == 0;
+}
+
+void prepareOutputPath(const std::string& path) {
+    std::filesystem::path filePath(path);
+
+    try {
+        // Check if the path exists and is a directory
+        if (std::filesystem::exists(path) && std::filesystem::is_directory(path)) {
+            throw std::runtime_error("Cannot write to '" + path + "' because it is a directory");
+        }
+
+        // Check if the parent path exists or can be created
+        if (!filePath.parent_path().empty()) {
+            std::filesystem::create_directories(filePath.parent_path());
+        }
+    } catch (const std::filesystem::filesystem_error& e) {
+        // Handle filesystem errors
+        throw std::runtime_error("Failed to create directory for output file: " +
+                                std::string(e.what()));
+    }
+}
+
+OutputWriter::OutputWriter(const std::string& path, size_t bufferSize, bool compress, unsigned int compressThreads)
+    : path_(path)
+    , fd_(-1)
+    , buffer_(std::max<size_t>(bufferSize, kMaxNumberChars))
+{
+    if (path_ != "-") {
+        fd_ = ::open(path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd_ < 0) {
+            throw std::runtime_error(openErrorMessage(path_, errno));
+        }
+        struct stat sb;
+        if (ioBackend() == IoBackend::IoUring && ::fstat(fd_, &sb) == 0 && S_ISREG(sb.st_mode)) {
+            asyncWriter_ = std::make_unique<AsyncFileWriter>(fd_, path_, IoBackend::IoUring);
+        }
+    }
+    if (compress) {
+        compressor_ = std::make_unique<FrameCompressor>(*this, compressThreads);
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+OutputWriter::OutputWriter(int fd, const std::string& path)
+    : path_(path)
+    , fd_(fd)
+    , buffer_(kDefaultBufferSize)
+{
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+std::unique_ptr<OutputWriter> OutputWriter::continueAt(const std::string& path, uint64_t offset) {
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        throw std::runtime_error(openErrorMessage(path, errno));
+    }
+    struct stat sb;
+    bool kept = ::fstat(fd, &sb) == 0 && static_cast<uint64_t>(sb.st_size) >= offset &&
+                ::ftruncate(fd, static_cast<off_t>(offset)) == 0 &&
+                ::lseek(fd, static_cast<off_t>(offset), SEEK_SET) == static_cast<off_t>(offset);
+    if (!kept) {
+        ::close(fd);
+        throw std::runtime_error("Output file is shorter than the " + std::to_string(offset) +
+                                 " bytes to continue after: " + path);
+    }
+    return std::unique_ptr<OutputWriter>(new OutputWriter(fd, path));
+}
+
+OutputWriter::~OutputWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw
+    }
+}
+
+void OutputWriter::writeNumber(uint64_t value) {
+    if (static_cast<size_t>(epptr() - pptr()) < kMaxNumberChars) {
+        drain();
+    }
+    auto result = std::to_chars(pptr(), epptr(), value);
+    pbump(static_cast<int>(result.ptr - pptr()));
+}
+
+void OutputWriter::writeNumber(double value) {
+    if (static_cast<size_t>(epptr() - pptr()) < kMaxNumberChars) {
+        drain();
+    }
+    auto result = std::to_chars(pptr(), epptr(), value);
+    pbump(static_cast<int>(result.ptr - pptr()));
+}
+
+void OutputWriter::flush() {
+    drain();
+    if (compressor_) {
+        compressor_->flush();
+    }
+    if (asyncWriter_) {
+        asyncWriter_->finish();
+    }
+    if (path_ == "-") {
+        std::cout.flush();
+    }
+}
+
+void OutputWriter::syncToDisk() {
+    flush();
+    if (fd_ >= 0 && ::fsync(fd_) != 0) {
+        throw std::runtime_error("Failed to sync output file: " + path_);
+    }
+}
+
+void OutputWriter::close() {
+    flush();
+    asyncWriter_.reset();
+    if (fd_ >= 0) {
+        int fd = fd_;
+        fd_ = -1;
+        if (::close(fd) != 0) {
+            throw std::runtime_error("Failed to write output file: " + path_);
+        }
+    }
+}
+
+OutputWriter::int_type OutputWriter::overflow(int_type c) {
+    try {
+        drain();
+    } catch (const std::exception&) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize OutputWriter::xsputn(const char* data, std::streamsize size) {
+    try {
+        write(std::string_view(data, static_cast<size_t>(size)));
+    } catch (const std::exception&) {
+        return 0;
+    }
+    return size;
+}
+
+int OutputWriter::sync() {
+    try {
+        flush();
+    } catch (const std::exception&) {
+        return -1;
+    }
+    return 0;
+}
+
+void OutputWriter::writeLarge(std::string_view text) {
+    drain();
+    if (text.size() >= buffer_.size()) {
+        // Too large to gather; write it straight through
+        writeOut(text.data(), text.size());
+        return;
+    }
+    text.copy(pptr(), text.size());
+    pbump(static_cast<int>(text.size()));
+}
+
+void OutputWriter::drain() {
+    size_t size = static_cast<size_t>(pptr() - pbase());
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    if (size > 0) {
+        writeOut(buffer_.data(), size);
+    }
+}
+
+void OutputWriter::writeOut(const char* data, size_t size) {
+    if (compressor_) {
+        compressor_->add(data, size);
+        return;
+    }
+    writeRaw(data, size);
+}
+
+void OutputWriter::writeRaw(const char* data, size_t size) {
+    // Counted when handed over; a failed write ends the run with an exception anyway
+    bytesWritten.fetch_add(size, std::memory_order_relaxed);
+    if (path_ == "-") {
+        if (isProcessStdout()) {
+            writeStdout(data, size);
+            return;
+        }
+        std::streambuf* out = std::cout.rdbuf();
+        if (!out || out->sputn(data, static_cast<std::streamsize>(size)) != static_cast<std::streamsize>(size)) {
+            throw std::runtime_error("Failed to write to stdout");
+        }
+        return;
+    }
+    if (fd_ < 0) {
+        throw std::runtime_error("Output file is closed: " + path_);
+    }
+    if (asyncWriter_) {
+        asyncWriter_->write(data, size);
+        return;
+    }
+    while (size > 0) {
+        ssize_t written = ::write(fd_, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error("Failed to write output file: " + path_);
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,203 @@
+/**
+ * @file output_writer.h
+ * @brief Buffered output with allocation-free number formatting
+ */
+
+#ifndef SUZUME_CORE_OUTPUT_WRITER_H_
+#define SUZUME_CORE_OUTPUT_WRITER_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+class AsyncFileWriter;
+
+/**
+ * @brief Create the parent directories of an output file
+ *
+ * @param path Output file path
+ * @throws std::runtime_error If the path is a directory or its parent cannot be created
+ */
+void prepareOutputPath(const std::string& path);
+
+/**
+ * @brief Check whether an output path asks for zstd output by its extension
+ *
+ * @param path Output file path
+ * @return bool True if the path ends in ".zst"
+ */
+bool isCompressedOutputPath(const std::string& path);
+
+/**
+ * @brief Get the bytes all output writers of the process have written so far
+ *
+ * Compressed output counts its compressed bytes. Operations take the
+ * difference over their run (see MemoryMonitor).
+ *
+ * @return uint64_t Bytes handed to output files and stdout
+ */
+uint64_t outputBytesWritten();
+
+/**
+ * @brief Buffered writer for large text outputs
+ *
+ * Text is gathered in one large user-space buffer and handed to the file
+ * with a single write(2) per buffer, without locale or stream state on the
+ * way. Numbers are formatted with std::to_chars: integers exactly, doubles
+ * in their shortest form that reads back to the same value.
+ *
+ * The writer is also a std::streambuf, so code written against std::ostream
+ * can wrap it and share the same buffer. On stdout ("-") full buffers are
+ * written to file descriptor 1 directly, or passed to std::cout's stream
+ * buffer once std::cout has been redirected, which keeps such redirections
+ * working.
+ *
+ * Compressed output is cut into blocks of kFrameSize bytes that are
+ * compressed on the worker pool, one block per thread at a time, and written
+ * in order as independent zstd frames that record their content size, so
+ * openInputStream() can decode them in parallel again.
+ *
+ * When the io_uring backend is selected (setIoBackend()), full buffers of
+ * regular files are handed to an AsyncFileWriter and written while the
+ * next one fills; flush() waits for them.
+ */
+class OutputWriter : public std::streambuf {
+public:
+    /// Default buffer size in bytes
+    static constexpr size_t kDefaultBufferSize = 1024 * 1024;
+
+    /// Uncompressed bytes per zstd frame of compressed output
+    static constexpr size_t kFrameSize = 4 * 1024 * 1024;
+
+    /**
+     * @brief Open an output file, truncating it
+     * @param path Output path ("-" for stdout)
+     * @param bufferSize Buffer size in bytes
+     * @param compress Write zstd frames instead of plain text
+     * @param compressThreads Blocks compressed at a time (0 = one per pool thread)
+     * @throws std::runtime_error If the file cannot be opened, or compress is set
+     *         in a build without zstd
+     */
+    explicit OutputWriter(const std::string& path, size_t bufferSize = kDefaultBufferSize, bool compress = false,
+                          unsigned int compressThreads = 0);
+
+    /**
+     * @brief Open an output file to continue it after its first bytes
+     *
+     * Bytes past @p offset, written after the last point the caller knows
+     * to be complete, are cut off. Continued files are written directly,
+     * without compression or the io_uring backend.
+     *
+     * @param path Output file path
+     * @param offset Bytes of the file kept
+     * @return std::unique_ptr<OutputWriter> Writer appending after them
+     * @throws std::runtime_error If the file cannot be opened or is shorter than @p offset
+     */
+    static std::unique_ptr<OutputWriter> continueAt(const std::string& path, uint64_t offset);
+
+    /**
+     * @brief Destructor; flushes what is left, ignoring errors (call close() to see them)
+     */
+    ~OutputWriter() override;
+
+    OutputWriter(const OutputWriter&) = delete;
+    OutputWriter& operator=(const OutputWriter&) = delete;
+
+    /**
+     * @brief Append text
+     * @param text Bytes to write
+     */
+    void write(std::string_view text) {
+        if (text.size() <= static_cast<size_t>(epptr() - pptr())) {
+            text.copy(pptr(), text.size());
+            pbump(static_cast<int>(text.size()));
+        } else {
+            writeLarge(text);
+        }
+    }
+
+    /**
+     * @brief Append one character
+     * @param c Character to write
+     */
+    void put(char c) {
+        if (pptr() == epptr()) {
+            drain();
+        }
+        *pptr() = c;
+        pbump(1);
+    }
+
+    /**
+     * @brief Append a line and its newline
+     * @param line Line without terminator
+     */
+    void writeLine(std::string_view line) {
+        write(line);
+        put('\n');
+    }
+
+    /**
+     * @brief Append an integer in decimal
+     * @param value Value to write
+     */
+    void writeNumber(uint64_t value);
+
+    /**
+     * @brief Append a double in its shortest round-trip form
+     * @param value Value to write
+     */
+    void writeNumber(double value);
+
+    /**
+     * @brief Write out the buffer
+     * @throws std::runtime_error If the write fails
+     */
+    void flush();
+
+    /**
+     * @brief Write out the buffer and wait until the file's data is on disk
+     * @throws std::runtime_error If the write or the sync fails
+     */
+    void syncToDisk();
+
+    /**
+     * @brief Write out the buffer and close the file
+     * @throws std::runtime_error If the write or close fails
+     */
+    void close();
+
+protected:
+    int_type overflow(int_type c) override;
+    std::streamsize xsputn(const char* data, std::streamsize size) override;
+    int sync() override;
+
+private:
+    class FrameCompressor;
+
+    // Writer on an already opened file descriptor (see continueAt())
+    OutputWriter(int fd, const std::string& path);
+
+    void writeLarge(std::string_view text);
+    void drain();
+    void writeOut(const char* data, size_t size);
+    void writeRaw(const char* data, size_t size);
+
+    std::string path_;
+    int fd_;
+    std::vector<char> buffer_;
+    std::unique_ptr<AsyncFileWriter> asyncWriter_;
+    std::unique_ptr<FrameCompressor> compressor_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_OUTPUT_WRITER_H_
@@ -0,0 +1,364 @@
+/**
+ * @file packed_ngram.cpp
+ * @brief Implementation of packed-key n-gram counting
+ */
+
+#include "core/packed_ngram.h"
+#include "core/counting_map.h"
+#include "parallel/thread_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Smallest table allocated
+constexpr size_t kMinCapacity = 1024;
+
+// Finalizer from SplitMix64, spreads packed keys over the slots
+inline uint64_t mixKey(uint64_t x) {
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ULL;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// Slots needed to keep the load factor below 0.7
+inline size_t capacityFor(size_t entries) {
+    size_t capacity = kMinCapacity;
+    while (capacity * 7 < entries * 10) {
+        capacity *= 2;
+    }
+    return capacity;
+}
+
+} // namespace
+
+PackedNgramCounter::PackedNgramCounter(uint32_t n, size_t expectedEntries)
+    : n_(n)
+    , size_(0)
+    , slotMask_(0)
+{
+    if (n == 0 || n > kMaxN) {
+        throw std::invalid_argument("Invalid n-gram size for packed counting: " + std::to_string(n) +
+                                    " (must be 1, 2, or 3)");
+    }
+    rehash(capacityFor(expectedEntries));
+}
+
+void PackedNgramCounter::addText(std::string_view text) {
+    dispatchNgramSize(n_, [&](auto size) {
+        forEachLine(text, [this](std::string_view line) {
+            forEachKey<decltype(size)::value>(line, [this](uint64_t key) { add(key); });
+        });
+    });
+}
+
+void PackedNgramCounter::add(uint64_t key, uint32_t count) {
+    size_t slot = static_cast<size_t>(mixKey(key)) & slotMask_;
+    while (true) {
+        if (keys_[slot] == key) {
+            counts_[slot] += count;
+            return;
+        }
+        if (keys_[slot] == kEmptyKey) {
+            break;
+        }
+        slot = (slot + 1) & slotMask_;
+    }
+
+    keys_[slot] = key;
+    counts_[slot] = count;
+    size_++;
+    if (size_ * 10 >= keys_.size() * 7) {
+        rehash(keys_.size() * 2);
+    }
+}
+
+void PackedNgramCounter::merge(const PackedNgramCounter& other) {
+    if (other.n_ != n_) {
+        throw std::invalid_argument("Cannot merge n-gram counts of different sizes");
+    }
+    if (capacityFor(size_ + other.size_) > keys_.size()) {
+        rehash(capacityFor(size_ + other.size_));
+    }
+    other.forEach([this](uint64_t key, uint32_t count) { add(key, count); });
+}
+
+size_t PackedNgramCounter::prune(uint32_t maxCount) {
+    size_t kept = 0;
+    for (size_t slot = 0; slot < keys_.size(); ++slot) {
+        kept += keys_[slot] != kEmptyKey && counts_[slot] > maxCount ? 1 : 0;
+    }
+    const size_t dropped = size_ - kept;
+    if (dropped == 0) {
+        return 0;
+    }
+
+    // Rebuild from the survivors at the capacity they need
+    std::vector<uint64_t> oldKeys = std::move(keys_);
+    std::vector<uint32_t> oldCounts = std::move(counts_);
+    keys_.clear();
+    counts_.clear();
+    size_ = 0;
+    rehash(capacityFor(kept));
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldKeys[i] != kEmptyKey && oldCounts[i] > maxCount) {
+            add(oldKeys[i], oldCounts[i]);
+        }
+    }
+    return dropped;
+}
+
+uint32_t PackedNgramCounter::count(uint64_t key) const {
+    size_t slot = static_cast<size_t>(mixKey(key)) & slotMask_;
+    while (keys_[slot] != kEmptyKey) {
+        if (keys_[slot] == key) {
+            return counts_[slot];
+        }
+        slot = (slot + 1) & slotMask_;
+    }
+    return 0;
+}
+
+void PackedNgramCounter::rehash(size_t capacity) {
+    std::vector<uint64_t> oldKeys = std::move(keys_);
+    std::vector<uint32_t> oldCounts = std::move(counts_);
+    keys_.assign(capacity, kEmptyKey);
+    counts_.assign(capacity, 0);
+    slotMask_ = capacity - 1;
+    // Both tables are held until the entries are moved over
+    charge_.set(memoryUsage() + oldKeys.capacity() * sizeof(uint64_t) + oldCounts.capacity() * sizeof(uint32_t));
+
+    for (size_t i = 0; i < oldKeys.size(); ++i) {
+        if (oldKeys[i] == kEmptyKey) {
+            continue;
+        }
+        size_t slot = static_cast<size_t>(mixKey(oldKeys[i])) & slotMask_;
+        while (keys_[slot] != kEmptyKey) {
+            slot = (slot + 1) & slotMask_;
+        }
+        keys_[slot] = oldKeys[i];
+        counts_[slot] = oldCounts[i];
+    }
+    charge_.set(memoryUsage());
+}
+
+std::unordered_map<std::string, uint32_t> PackedNgramCounter::toStringCounts() const {
+    std::unordered_map<std::string, uint32_t> counts;
+    counts.reserve(size_);
+    forEach([&](uint64_t key, uint32_t count) { counts.emplace(decode(key, n_), count); });
+    return counts;
+}
+
+size_t PackedNgramCounter::memoryUsage() const {
+    return keys_.capacity() * sizeof(uint64_t) + counts_.capacity() * sizeof(uint32_t);
+}
+
+bool PackedNgramCounter::pack(std::string_view ngram, uint32_t n, uint64_t& key) {
+    key = 0;
+    uint32_t codePoints = 0;
+    size_t pos = 0;
+    while (pos < ngram.size()) {
+        if (++codePoints > n) {
+            return false;
+        }
+        key = (key << kBitsPerCodePoint) | nextCodePoint(ngram, pos);
+    }
+    return codePoints == n;
+}
+
+std::string PackedNgramCounter::decode(uint64_t key, uint32_t n) {
+    std::string text;
+    text.reserve(n * 4);
+    for (uint32_t i = 0; i < n; ++i) {
+        appendUtf8(text, codePoint(key, n, i));
+    }
+    return text;
+}
+
+PartitionedNgramCounter::PartitionedNgramCounter(uint32_t n, size_t partitions, size_t expectedEntries)
+    : n_(n)
+{
+    if (partitions == 0) {
+        throw std::invalid_argument("Partition count must be at least 1");
+    }
+    partitions_.reserve(partitions);
+    for (size_t i = 0; i < partitions; ++i) {
+        partitions_.emplace_back(n, expectedEntries / partitions);
+    }
+}
+
+void PartitionedNgramCounter::addText(std::string_view text) {
+    dispatchNgramSize(n_, [&](auto size) {
+        forEachLine(text, [this](std::string_view line) {
+            PackedNgramCounter::forEachKey<decltype(size)::value>(line, [this](uint64_t key) { add(key); });
+        });
+    });
+}
+
+PartitionedNgramCounter PartitionedNgramCounter::mergeAll(
+    std::vector<PartitionedNgramCounter>&& tables,
+    unsigned int threads
+) {
+    if (tables.empty()) {
+        throw std::invalid_argument("No n-gram tables to merge");
+    }
+    const size_t partitions = tables.front().partitions_.size();
+    for (const auto& table : tables) {
+        if (table.n_ != tables.front().n_ || table.partitions_.size() != partitions) {
+            throw std::invalid_argument("Cannot merge n-gram tables with different layouts");
+        }
+    }
+
+    PartitionedNgramCounter result = std::move(tables.front());
+    auto mergePartition = [&](size_t index) {
+        // Start from the largest piece so the fewest entries are moved
+        PackedNgramCounter* largest = &result.partitions_[index];
+        for (auto& table : tables) {
+            if (!table.partitions_.empty() && table.partitions_[index].size() > largest->size()) {
+                largest = &table.partitions_[index];
+            }
+        }
+        if (largest != &result.partitions_[index]) {
+            std::swap(result.partitions_[index], *largest);
+        }
+        for (size_t t = 1; t < tables.size(); ++t) {
+            result.partitions_[index].merge(tables[t].partitions_[index]);
+            // Release the merged piece right away
+            tables[t].partitions_[index] = PackedNgramCounter(result.n_);
+        }
+    };
+
+    // Workers claim partitions one at a time; partitions vary a lot in size
+    size_t threadCount = std::max<size_t>(1, std::min<size_t>(threads, partitions));
+    std::atomic<size_t> nextPartition(0);
+    auto worker = [&]() {
+        for (size_t index = nextPartition.fetch_add(1); index < partitions; index = nextPartition.fetch_add(1)) {
+            mergePartition(index);
+        }
+    };
+    if (threadCount == 1) {
+        worker();
+    } else {
+        parallel::TaskGroup group("merge");
+        for (size_t i = 0; i < threadCount; ++i) {
+            group.run(worker);
+        }
+        group.wait();
+    }
+
+    tables.clear();
+    return result;
+}
+
+size_t PartitionedNgramCounter::prune(uint32_t maxCount) {
+    size_t dropped = 0;
+    for (auto& partition : partitions_) {
+        dropped += partition.prune(maxCount);
+    }
+    return dropped;
+}
+
+size_t PartitionedNgramCounter::size() const {
+    size_t total = 0;
+    for (const auto& partition : partitions_) {
+        total += partition.size();
+    }
+    return total;
+}
+
+size_t PartitionedNgramCounter::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& partition : partitions_) {
+        total += partition.memoryUsage();
+    }
+    return total;
+}
+
+MultiOrderNgramCounter::MultiOrderNgramCounter(
+    uint32_t minN,
+    uint32_t maxN,
+    size_t partitions,
+    size_t inputBytes
+)
+    : minN_(minN)
+    , maxN_(maxN)
+{
+    if (minN < 1 || maxN > PackedNgramCounter::kMaxN || minN > maxN) {
+        throw std::invalid_argument("Invalid n-gram orders: " + std::to_string(minN) + "-" + std::to_string(maxN));
+    }
+    orders_.reserve(maxN - minN + 1);
+    for (uint32_t n = minN; n <= maxN; ++n) {
+        orders_.emplace_back(n, partitions, estimateDistinctNgrams(inputBytes, n));
+    }
+}
+
+void MultiOrderNgramCounter::addText(std::string_view text) {
+    forEachLine(text, [this](std::string_view line) {
+        PackedNgramCounter::forEachKey(line, minN_, maxN_, [this](uint32_t n, uint64_t key) {
+            orders_[n - minN_].add(key);
+        });
+    });
+}
+
+MultiOrderNgramCounter MultiOrderNgramCounter::mergeAll(
+    std::vector<MultiOrderNgramCounter>&& tables,
+    unsigned int threads
+) {
+    if (tables.empty()) {
+        throw std::invalid_argument("No n-gram tables to merge");
+    }
+    for (const auto& table : tables) {
+        if (table.minN_ != tables.front().minN_ || table.maxN_ != tables.front().maxN_) {
+            throw std::invalid_argument("Cannot merge n-gram tables with different orders");
+        }
+    }
+
+    MultiOrderNgramCounter result;
+    result.minN_ = tables.front().minN_;
+    result.maxN_ = tables.front().maxN_;
+    for (size_t order = 0; order < tables.front().orders_.size(); ++order) {
+        std::vector<PartitionedNgramCounter> pieces;
+        pieces.reserve(tables.size());
+        for (auto& table : tables) {
+            pieces.push_back(std::move(table.orders_[order]));
+        }
+        result.orders_.push_back(PartitionedNgramCounter::mergeAll(std::move(pieces), threads));
+    }
+
+    tables.clear();
+    return result;
+}
+
+size_t MultiOrderNgramCounter::prune(uint32_t maxCount) {
+    size_t dropped = 0;
+    for (auto& order : orders_) {
+        dropped += order.prune(maxCount);
+    }
+    return dropped;
+}
+
+size_t MultiOrderNgramCounter::size() const {
+    size_t total = 0;
+    for (const auto& order : orders_) {
+        total += order.size();
+    }
+    return total;
+}
+
+size_t MultiOrderNgramCounter::memoryUsage() const {
+    size_t total = 0;
+    for (const auto& order : orders_) {
+        total += order.memoryUsage();
+    }
+    return total;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,489 @@
+/**
+ * @file packed_ngram.h
+ * @brief N-gram counting with code points packed into integer keys
+ */
+
+#ifndef SUZUME_CORE_PACKED_NGRAM_H_
+#define SUZUME_CORE_PACKED_NGRAM_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include "core/memory_accounting.h"
+#include "core/ngram_window.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Call fn with an n-gram size of 1-3 as a compile-time constant
+ *
+ * Kernels take the size as a template parameter, so their windows, key
+ * masks and marginal products are unrolled; entry points dispatch once
+ * here instead of branching on n in the hot loop.
+ *
+ * @param n N-gram size
+ * @param fn Callable taking std::integral_constant<uint32_t, N>
+ * @return Result of fn
+ * @throws std::invalid_argument If n is not 1, 2 or 3
+ */
+template <typename Fn>
+decltype(auto) dispatchNgramSize(uint32_t n, Fn&& fn) {
+    switch (n) {
+        case 1: return fn(std::integral_constant<uint32_t, 1>());
+        case 2: return fn(std::integral_constant<uint32_t, 2>());
+        case 3: return fn(std::integral_constant<uint32_t, 3>());
+    }
+    throw std::invalid_argument("Invalid n-gram size for packed counting: " + std::to_string(n) +
+                                " (must be 1, 2, or 3)");
+}
+
+/**
+ * @brief Flat open-addressing table of n-gram counts keyed by packed code points
+ *
+ * Every code point fits in 21 bits, so an n-gram of up to three code points
+ * is packed into one uint64_t, first code point in the highest bits. Keys and
+ * counts live in two parallel arrays probed linearly, which costs 12 bytes
+ * per slot instead of a heap-allocated string plus a node per n-gram. Keys are
+ * decoded back to UTF-8 only for the n-grams that are written.
+ *
+ * Text is split into lines like countNgrams(); invalid UTF-8 decodes to
+ * U+FFFD as in ICU (see nextCodePoint()). Not thread-safe: count into one
+ * table per thread and merge().
+ */
+class PackedNgramCounter {
+public:
+    /// Largest n-gram size that fits in a key
+    static constexpr uint32_t kMaxN = 3;
+
+    /**
+     * @brief Constructor
+     * @param n N-gram size (1-3)
+     * @param expectedEntries Distinct n-grams to size the table for
+     * @throws std::invalid_argument If n is out of range
+     */
+    explicit PackedNgramCounter(uint32_t n, size_t expectedEntries = 0);
+
+    /**
+     * @brief Count the n-grams of every line in a text
+     * @param text UTF-8 text, lines separated by '\n'
+     */
+    void addText(std::string_view text);
+
+    /**
+     * @brief Add to the count of a packed n-gram
+     * @param key Packed n-gram
+     * @param count Occurrences to add
+     */
+    void add(uint64_t key, uint32_t count = 1);
+
+    /**
+     * @brief Call fn(key) for every packed n-gram of a line
+     * @param line UTF-8 line (no newline handling)
+     * @param n N-gram size (1-3)
+     * @param fn Visitor taking a uint64_t key
+     * @throws std::invalid_argument If n is out of range
+     */
+    template <typename Fn>
+    static void forEachKey(std::string_view line, uint32_t n, Fn&& fn);
+
+    /**
+     * @brief Call fn(key) for every packed n-gram of a line, for a size fixed at compile time
+     *
+     * The window is filled with the first N - 1 code points, after which
+     * every code point completes a key under a constant mask.
+     *
+     * @tparam N N-gram size (1-3)
+     * @param line UTF-8 line (no newline handling)
+     * @param fn Visitor taking a uint64_t key
+     */
+    template <uint32_t N, typename Fn>
+    static void forEachKey(std::string_view line, Fn&& fn);
+
+    /**
+     * @brief Call fn(order, key) for every packed n-gram of a line, orders minN..maxN
+     *
+     * Code points are decoded once for all orders.
+     *
+     * @param line UTF-8 line (no newline handling)
+     * @param minN Smallest n-gram size (1-3)
+     * @param maxN Largest n-gram size (minN-3)
+     * @param fn Visitor taking a uint32_t order and a uint64_t key
+     */
+    template <typename Fn>
+    static void forEachKey(std::string_view line, uint32_t minN, uint32_t maxN, Fn&& fn);
+
+    /**
+     * @brief Add every count of another table with the same n
+     * @param other Table to merge
+     * @throws std::invalid_argument If the n-gram sizes differ
+     */
+    void merge(const PackedNgramCounter& other);
+
+    /**
+     * @brief Drop every n-gram counted at most maxCount times
+     *
+     * The table is rebuilt at the size the remaining entries need, so the
+     * memory of the dropped entries is released.
+     *
+     * @param maxCount Largest count dropped
+     * @return size_t Entries dropped
+     */
+    size_t prune(uint32_t maxCount);
+
+    /**
+     * @brief Get the count of a packed n-gram
+     * @param key Packed n-gram
+     * @return uint32_t Count (0 if never added)
+     */
+    uint32_t count(uint64_t key) const;
+
+    /**
+     * @brief Call fn(key, count) for every counted n-gram
+     * @param fn Visitor
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (size_t slot = 0; slot < keys_.size(); ++slot) {
+            if (keys_[slot] != kEmptyKey) {
+                fn(keys_[slot], counts_[slot]);
+            }
+        }
+    }
+
+    /**
+     * @brief Convert to a string-keyed table
+     * @return std::unordered_map<std::string, uint32_t> UTF-8 n-gram counts
+     */
+    std::unordered_map<std::string, uint32_t> toStringCounts() const;
+
+    /**
+     * @brief Get the n-gram size
+     * @return uint32_t N
+     */
+    uint32_t n() const { return n_; }
+
+    /**
+     * @brief Get number of distinct n-grams
+     * @return size_t Entry count
+     */
+    size_t size() const { return size_; }
+
+    /**
+     * @brief Get memory usage of the table
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Pack a UTF-8 n-gram into a key
+     * @param ngram UTF-8 text of exactly n code points
+     * @param n N-gram size (1-3)
+     * @param key Packed n-gram
+     * @return bool False if the text is not n code points
+     */
+    static bool pack(std::string_view ngram, uint32_t n, uint64_t& key);
+
+    /**
+     * @brief Decode a packed n-gram to UTF-8
+     * @param key Packed n-gram
+     * @param n N-gram size
+     * @return std::string UTF-8 text
+     */
+    static std::string decode(uint64_t key, uint32_t n);
+
+    /**
+     * @brief Extract one code point of a packed n-gram
+     * @param key Packed n-gram
+     * @param n N-gram size
+     * @param index Position within the n-gram (0 = first)
+     * @return uint32_t Code point
+     */
+    static uint32_t codePoint(uint64_t key, uint32_t n, uint32_t index) {
+        return static_cast<uint32_t>(key >> (kBitsPerCodePoint * (n - 1 - index))) & kCodePointMask;
+    }
+
+private:
+    static constexpr uint32_t kBitsPerCodePoint = 21;
+    static constexpr uint32_t kCodePointMask = (1u << kBitsPerCodePoint) - 1;
+    // Packed keys use at most 63 bits, so all-ones never occurs
+    static constexpr uint64_t kEmptyKey = ~uint64_t{0};
+
+    void rehash(size_t capacity);
+
+    uint32_t n_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> counts_;
+    size_t size_;
+    size_t slotMask_;
+    MemoryCharge charge_{MemorySubsystem::NgramTables};
+};
+
+template <typename Fn>
+void PackedNgramCounter::forEachKey(std::string_view line, uint32_t n, Fn&& fn) {
+    dispatchNgramSize(n, [&](auto size) { forEachKey<decltype(size)::value>(line, fn); });
+}
+
+template <uint32_t N, typename Fn>
+void PackedNgramCounter::forEachKey(std::string_view line, Fn&& fn) {
+    static_assert(N >= 1 && N <= kMaxN, "Packed n-grams hold 1 to 3 code points");
+    constexpr uint64_t keyMask = (uint64_t{1} << (N * kBitsPerCodePoint)) - 1;
+    uint64_t window = 0;
+    size_t pos = 0;
+    for (uint32_t filled = 1; filled < N; ++filled) {
+        if (pos >= line.size()) {
+            return;
+        }
+        window = (window << kBitsPerCodePoint) | nextCodePoint(line, pos);
+    }
+    while (pos < line.size()) {
+        window = ((window << kBitsPerCodePoint) | nextCodePoint(line, pos)) & keyMask;
+        fn(window);
+    }
+}
+
+template <typename Fn>
+void PackedNgramCounter::forEachKey(std::string_view line, uint32_t minN, uint32_t maxN, Fn&& fn) {
+    const uint64_t windowMask = (uint64_t{1} << (maxN * kBitsPerCodePoint)) - 1;
+    uint64_t window = 0;
+    uint32_t filled = 0;
+    forEachCodePoint(line, [&](uint32_t c) {
+        window = ((window << kBitsPerCodePoint) | c) & windowMask;
+        if (filled < maxN) {
+            filled++;
+        }
+        for (uint32_t order = minN; order <= filled; ++order) {
+            fn(order, window & ((uint64_t{1} << (order * kBitsPerCodePoint)) - 1));
+        }
+    });
+}
+
+/**
+ * @brief Packed n-gram counts split into disjoint key partitions
+ *
+ * Each key belongs to exactly one partition, chosen by a multiplicative hash
+ * that is independent of the slot hash. Worker tables partitioned the same
+ * way can therefore be reduced partition by partition in parallel, each
+ * partition merged by one thread without locks, instead of folding every
+ * worker table into one on a single thread.
+ */
+class PartitionedNgramCounter {
+public:
+    /**
+     * @brief Constructor
+     * @param n N-gram size (1-3)
+     * @param partitions Number of partitions (at least 1)
+     * @param expectedEntries Distinct n-grams expected across all partitions
+     * @throws std::invalid_argument If n or partitions is out of range
+     */
+    PartitionedNgramCounter(uint32_t n, size_t partitions, size_t expectedEntries = 0);
+
+    /**
+     * @brief Count the n-grams of every line in a text
+     * @param text UTF-8 text, lines separated by '\n'
+     */
+    void addText(std::string_view text);
+
+    /**
+     * @brief Add to the count of a packed n-gram
+     * @param key Packed n-gram
+     * @param count Occurrences to add
+     */
+    void add(uint64_t key, uint32_t count = 1) {
+        partitions_[partitionOf(key)].add(key, count);
+    }
+
+    /**
+     * @brief Get the count of a packed n-gram
+     * @param key Packed n-gram
+     * @return uint32_t Count (0 if never added)
+     */
+    uint32_t count(uint64_t key) const {
+        return partitions_[partitionOf(key)].count(key);
+    }
+
+    /**
+     * @brief Call fn(key, count) for every counted n-gram
+     * @param fn Visitor
+     */
+    template <typename Fn>
+    void forEach(Fn&& fn) const {
+        for (const auto& partition : partitions_) {
+            partition.forEach(fn);
+        }
+    }
+
+    /**
+     * @brief Merge worker tables partition by partition on several threads
+     *
+     * Partition i of the result is the sum of partition i of every table.
+     * Each merged partition of the inputs is released right away, so memory
+     * does not peak at a second full copy of the counts.
+     *
+     * @param tables Worker tables with the same n and partition count (consumed)
+     * @param threads Maximum number of merging threads
+     * @return PartitionedNgramCounter Summed counts
+     * @throws std::invalid_argument If the tables are empty or do not match
+     */
+    static PartitionedNgramCounter mergeAll(std::vector<PartitionedNgramCounter>&& tables, unsigned int threads);
+
+    /**
+     * @brief Drop every n-gram counted at most maxCount times (see PackedNgramCounter::prune())
+     * @param maxCount Largest count dropped
+     * @return size_t Entries dropped
+     */
+    size_t prune(uint32_t maxCount);
+
+    /**
+     * @brief Get a partition
+     * @param index Partition index
+     * @return const PackedNgramCounter& Counts of the partition
+     */
+    const PackedNgramCounter& partition(size_t index) const { return partitions_[index]; }
+
+    /**
+     * @brief Get the number of partitions
+     * @return size_t Partition count
+     */
+    size_t partitionCount() const { return partitions_.size(); }
+
+    /**
+     * @brief Get the n-gram size
+     * @return uint32_t N
+     */
+    uint32_t n() const { return n_; }
+
+    /**
+     * @brief Get number of distinct n-grams
+     * @return size_t Entry count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get memory usage of all partitions
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+    /**
+     * @brief Get the partition of a key for a given partition count
+     *
+     * Depends only on the key and the count, so tables built on different
+     * machines agree on where every key belongs.
+     *
+     * @param key Packed n-gram
+     * @param partitions Number of partitions (at least 1)
+     * @return size_t Partition index
+     */
+    static size_t partitionIndex(uint64_t key, size_t partitions) {
+        // Fibonacci hashing of the key, scaled to the partition count
+        uint64_t hash = (key * 0x9E3779B97F4A7C15ULL) >> 32;
+        return static_cast<size_t>((hash * partitions) >> 32);
+    }
+
+private:
+    size_t partitionOf(uint64_t key) const {
+        return partitionIndex(key, partitions_.size());
+    }
+
+    uint32_t n_;
+    std::vector<PackedNgramCounter> partitions_;
+};
+
+/**
+ * @brief Packed n-gram counts of several orders gathered in one pass
+ *
+ * Each line is decoded once and every window of minN..maxN code points is
+ * counted into the table of its order, so counting orders 1-3 costs one
+ * scan of the input rather than three.
+ */
+class MultiOrderNgramCounter {
+public:
+    /**
+     * @brief Constructor
+     * @param minN Smallest n-gram size counted (1-3)
+     * @param maxN Largest n-gram size counted (minN-3)
+     * @param partitions Number of partitions of every order's table
+     * @param inputBytes Input size in bytes, to pre-size the tables
+     * @throws std::invalid_argument If the orders or partitions are out of range
+     */
+    MultiOrderNgramCounter(uint32_t minN, uint32_t maxN, size_t partitions, size_t inputBytes = 0);
+
+    /**
+     * @brief Count the n-grams of every order in every line of a text
+     * @param text UTF-8 text, lines separated by '\n'
+     */
+    void addText(std::string_view text);
+
+    /**
+     * @brief Add to the count of a packed n-gram of one order
+     * @param n N-gram size (minOrder()-maxOrder())
+     * @param key Packed n-gram
+     * @param count Occurrences to add
+     */
+    void add(uint32_t n, uint64_t key, uint32_t count) { orders_[n - minN_].add(key, count); }
+
+    /**
+     * @brief Merge worker tables order by order (see PartitionedNgramCounter::mergeAll())
+     * @param tables Worker tables with the same orders and partition count (consumed)
+     * @param threads Maximum number of merging threads
+     * @return MultiOrderNgramCounter Summed counts
+     * @throws std::invalid_argument If the tables are empty or do not match
+     */
+    static MultiOrderNgramCounter mergeAll(std::vector<MultiOrderNgramCounter>&& tables, unsigned int threads);
+
+    /**
+     * @brief Drop every n-gram of every order counted at most maxCount times
+     * @param maxCount Largest count dropped
+     * @return size_t Entries dropped
+     */
+    size_t prune(uint32_t maxCount);
+
+    /**
+     * @brief Get number of distinct n-grams over all orders
+     * @return size_t Entry count
+     */
+    size_t size() const;
+
+    /**
+     * @brief Get the counts of one order
+     * @param n N-gram size (minOrder()-maxOrder())
+     * @return const PartitionedNgramCounter& Counts of that order
+     */
+    const PartitionedNgramCounter& order(uint32_t n) const { return orders_[n - minN_]; }
+
+    /**
+     * @brief Get the smallest n-gram size counted
+     * @return uint32_t Smallest N
+     */
+    uint32_t minOrder() const { return minN_; }
+
+    /**
+     * @brief Get the largest n-gram size counted
+     * @return uint32_t Largest N
+     */
+    uint32_t maxOrder() const { return maxN_; }
+
+    /**
+     * @brief Get memory usage of all orders
+     * @return size_t Bytes used
+     */
+    size_t memoryUsage() const;
+
+private:
+    MultiOrderNgramCounter() = default;
+
+    uint32_t minN_ = 0;
+    uint32_t maxN_ = 0;
+    std::vector<PartitionedNgramCounter> orders_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_PACKED_NGRAM_H_
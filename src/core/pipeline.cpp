@@ -0,0 +1,157 @@
+/**
+ * @file pipeline.cpp
+ * @brief Implementation of the in-memory pipeline
+ */
+
+#include "core/pipeline.h"
+#include "core/arrow_ipc.h"
+#include "core/normalize.h"
+#include "core/output_writer.h"
+#include "core/pmi.h"
+#include "core/word_extraction.h"
+#include "parallel/trace.h"
+#include <chrono>
+#include <functional>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+using StructuredCallback = std::function<void(const ProgressInfo&)>;
+
+/**
+ * @brief Map the progress of one stage onto its share of the pipeline
+ *
+ * @param report Pipeline progress callback
+ * @param start Overall ratio at which the stage starts
+ * @param share Share of the overall progress taken by the stage
+ * @return StructuredCallback Callback for the stage
+ */
+StructuredCallback stageCallback(const StructuredCallback& report, double start, double share) {
+    return [&report, start, share](const ProgressInfo& stageInfo) {
+        ProgressInfo info = stageInfo;
+        // Only the pipeline as a whole completes
+        if (info.phase == ProgressInfo::Phase::Complete) {
+            info.phase = ProgressInfo::Phase::Processing;
+        }
+        info.overallRatio = start + stageInfo.overallRatio * share;
+        report(info);
+    };
+}
+
+} // namespace
+
+PipelineResult runPipeline(
+    const std::string& inputPath,
+    const PipelineOptions& options
+) {
+    parallel::TraceScope span("pipeline", "operation");
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    StructuredCallback report = [](const ProgressInfo&) {};
+    if (options.structuredProgressCallback) {
+        report = options.structuredProgressCallback;
+    } else if (options.progressCallback) {
+        report = [&options](const ProgressInfo& info) {
+            options.progressCallback(info.overallRatio);
+        };
+    }
+
+    // Stages report through the pipeline only
+    NormalizeOptions normalizeOptions = options.normalize;
+    normalizeOptions.progressCallback = nullptr;
+    normalizeOptions.structuredProgressCallback = nullptr;
+    PmiOptions pmiOptions = options.pmi;
+    pmiOptions.progressCallback = nullptr;
+    pmiOptions.structuredProgressCallback = nullptr;
+    WordExtractionOptions wordOptions = options.wordExtraction;
+    wordOptions.progressCallback = nullptr;
+    wordOptions.structuredProgressCallback = nullptr;
+
+    PipelineResult result;
+
+    // Step 1: Normalize into memory and join the unique lines into the
+    // corpus, laid out as the normalized file would be
+    std::string corpus;
+    {
+        std::vector<std::string> lines;
+        result.normalize = normalizeToMemory(inputPath, lines, stageCallback(report, 0.0, 0.3), normalizeOptions);
+
+        size_t corpusSize = 0;
+        for (const auto& line : lines) {
+            corpusSize += line.size() + 1;
+        }
+        corpus.reserve(corpusSize);
+        for (const auto& line : lines) {
+            corpus += line;
+            corpus += '\n';
+        }
+    }
+
+    // Step 2: Count the corpus in place and keep the top PMI items
+    std::vector<PmiItem> pmiItems;
+    result.pmi = calculatePmiFromText(corpus, pmiItems, stageCallback(report, 0.3, 0.3), pmiOptions);
+
+    // Step 3: Extract words, verifying against the corpus already loaded
+    StructuredCallback wordReport = stageCallback(report, 0.6, 0.4);
+    result.words = extractWordsFromMemory(pmiItems, corpus, wordOptions, [&wordReport](double ratio) {
+        ProgressInfo info;
+        info.phase = ProgressInfo::Phase::Processing;
+        info.phaseRatio = ratio;
+        info.overallRatio = ratio;
+        wordReport(info);
+    });
+
+    auto endTime = std::chrono::high_resolution_clock::now();
+    result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Complete;
+    info.phaseRatio = 1.0;
+    info.overallRatio = 1.0;
+    report(info);
+
+    return result;
+}
+
+void writeWordList(const WordExtractionResult& result, const std::string& outputPath) {
+    // Check if output is null (special case for no output)
+    if (outputPath == "null") {
+        return;
+    }
+    if (outputPath != "-") {
+        prepareOutputPath(outputPath);
+    }
+
+    if (isArrowOutputPath(outputPath)) {
+        ArrowFileWriter table(outputPath, {{"word", ArrowType::Utf8},
+                                           {"score", ArrowType::Float64},
+                                           {"frequency", ArrowType::UInt32},
+                                           {"context", ArrowType::Utf8}});
+        for (size_t i = 0; i < result.words.size(); ++i) {
+            table.append(0, result.words[i]);
+            table.append(1, result.scores[i]);
+            table.append(2, result.frequencies[i]);
+            table.append(3, i < result.contexts.size() ? std::string_view(result.contexts[i]) : std::string_view());
+            table.endRow();
+        }
+        table.close();
+        return;
+    }
+
+    OutputWriter output(outputPath);
+    for (size_t i = 0; i < result.words.size(); ++i) {
+        output.write(result.words[i]);
+        output.put('\t');
+        output.writeNumber(result.scores[i]);
+        output.put('\t');
+        output.writeNumber(static_cast<uint64_t>(result.frequencies[i]));
+        output.put('\n');
+    }
+    output.close();
+}
+
+} // namespace core
+} // namespace suzume
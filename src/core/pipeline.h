@@ -0,0 +1,52 @@
+/**
+ * @file pipeline.h
+ * @brief In-memory normalize, PMI and word extraction pipeline
+ */
+
+#ifndef SUZUME_CORE_PIPELINE_H_
+#define SUZUME_CORE_PIPELINE_H_
+
+#include <string>
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Normalize, calculate PMI and extract unknown words in one run
+ *
+ * The unique normalized lines are joined into one corpus buffer, which the
+ * PMI stage counts in place and the verifier indexes in place; the top PMI
+ * items go to the candidate generator as they are. The result equals
+ * running normalize, pmi and word-extract over the intermediate files.
+ *
+ * Overall progress is split 30% normalization, 30% PMI and 40% word
+ * extraction.
+ *
+ * @param inputPath Path to input text file ("-" for stdin)
+ * @param options Pipeline options
+ * @return PipelineResult Results of every stage
+ * @throws std::invalid_argument If a stage option is invalid or needs files
+ * @throws std::runtime_error If the input cannot be read
+ */
+PipelineResult runPipeline(
+    const std::string& inputPath,
+    const PipelineOptions& options = PipelineOptions()
+);
+
+/**
+ * @brief Write extracted words as TSV (word, score, frequency)
+ *
+ * A path ending in ".arrow" is written as an Arrow IPC file instead, with
+ * the contexts as a fourth column.
+ *
+ * @param result Word extraction result
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @throws std::runtime_error If the output cannot be written
+ */
+void writeWordList(const WordExtractionResult& result, const std::string& outputPath);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_PIPELINE_H_
@@ -5,15 +5,48 @@
 
 #include "core/pmi.h"
 #include "core/text_utils.h"
-#include "core/ngram_cache.h"
+#include "core/approximate_counter.h"
+#include "core/arrow_ipc.h"
+#include "core/auto_tune.h"
+#include "core/background_writer.h"
+#include "core/checkpoint.h"
+#include "core/compressed_input.h"
+#include "core/cooccurrence.h"
+#include "core/count_budget.h"
+#include "core/counting_map.h"
+#include "core/gpu_counter.h"
+#include "core/ngram_window.h"
+#include "core/input_files.h"
+#include "core/line_blocks.h"
+#include "core/mapped_text.h"
+#include "core/memory_accounting.h"
+#include "core/memory_monitor.h"
+#include "core/ngram_snapshot.h"
+#include "core/ngram_stats.h"
+#include "core/numa_topology.h"
+#include "core/output_writer.h"
+#include "core/pmi_results.h"
+#include "core/pmi_scoring.h"
+#include "core/progress_reporter.h"
+#include "core/sharded_output.h"
+#include "core/streaming_processor.h"
+#include "core/top_k.h"
+#include "parallel/thread_pool.h"
+#include "parallel/trace.h"
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <mutex>
+#include <optional>
 #include <queue>
-#include <sstream>
 #include <thread>
+#include <type_traits>
 #include <unordered_map>
 #include <vector>
 #include <filesystem>
@@ -22,352 +55,1438 @@
 namespace suzume {
 namespace core {
 
-PmiResult calculatePmi(
-    const std::string& inputPath,
+namespace {
+
+// Input a counting worker needs to pay for starting it and merging its table
+constexpr uint64_t kMinCountBytesPerThread = 1024 * 1024;
+
+PmiResult scoreSnapshots(
+    const std::vector<std::string>& snapshotPaths,
+    const std::vector<std::string>& marginalPaths,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+);
+
+/**
+ * @brief Reject invalid PMI options
+ *
+ * @param options PMI calculation options
+ * @throws std::invalid_argument If an option is out of range
+ */
+void validatePmiOptions(const PmiOptions& options) {
+    if (options.n < 1 || options.n > 3) {
+        throw std::invalid_argument("Invalid n-gram size: " + std::to_string(options.n) + " (must be 1, 2, or 3)");
+    }
+
+    if (options.topK < 1) {
+        throw std::invalid_argument("Invalid topK: " + std::to_string(options.topK) + " (must be at least 1)");
+    }
+
+    if (options.minFreq < 1) {
+        throw std::invalid_argument("Invalid minFreq: " + std::to_string(options.minFreq) + " (must be at least 1)");
+    }
+
+    if (options.snapshotPartitions < 1) {
+        throw std::invalid_argument("Invalid snapshot partitions: " + std::to_string(options.snapshotPartitions) +
+                                    " (must be at least 1)");
+    }
+
+    if (options.outputShards > ShardedOutputWriter::kMaxShards) {
+        throw std::invalid_argument("Invalid output shards: " + std::to_string(options.outputShards) +
+                                    " (must be at most " + std::to_string(ShardedOutputWriter::kMaxShards) + ")");
+    }
+
+    if (options.memoryBudget > 0) {
+        if (options.approximate) {
+            throw std::invalid_argument("Approximate counting already has a fixed size; a memory budget does not apply");
+        }
+        if (options.budgetStrategy == MemoryBudgetStrategy::None) {
+            throw std::invalid_argument("A memory budget needs the Prune or Spill strategy");
+        }
+        if (options.budgetStrategy == MemoryBudgetStrategy::Spill &&
+            (options.allOrders || options.snapshotPartitions > 1)) {
+            throw std::invalid_argument("Spilling counts needs a single order; it cannot be combined with all orders "
+                                        "or snapshot partitions");
+        }
+    }
+
+    if (!options.checkpointPath.empty()) {
+        // Segments are checkpointed as single-order snapshots of exact counts
+        if (options.approximate || options.allOrders || options.snapshotPartitions > 1 || options.memoryBudget > 0) {
+            throw std::invalid_argument("Checkpointing needs exact counts of one order without a memory budget; it "
+                                        "cannot be combined with approximate counting, all orders or snapshot "
+                                        "partitions");
+        }
+        if (options.checkpointInterval < 1) {
+            throw std::invalid_argument("Invalid checkpoint interval: 0 (must be at least 1 byte)");
+        }
+    }
+
+    if (options.window > 0) {
+        if (options.window > CooccurrenceCounter::kMaxWindow) {
+            throw std::invalid_argument("Invalid co-occurrence window: " + std::to_string(options.window) +
+                                        " (must be 1-" + std::to_string(CooccurrenceCounter::kMaxWindow) + ")");
+        }
+        // Pairs are counted exactly, in memory, and only written as scored text
+        if (options.approximate || options.allOrders || !options.snapshotPath.empty() ||
+            !options.binaryOutputPath.empty() || options.memoryBudget > 0 || !options.checkpointPath.empty()) {
+            throw std::invalid_argument("Co-occurrence PMI cannot be combined with approximate counting, all orders, "
+                                        "snapshots, binary results, a memory budget or checkpoints");
+        }
+    }
+
+    if (options.countingBackend == CountingBackend::Gpu &&
+        (options.approximate || options.window > 0 || options.memoryBudget > 0)) {
+        // The device counts exactly, into one host table that no budget watches
+        throw std::invalid_argument("GPU counting cannot be combined with approximate counting, co-occurrence PMI "
+                                    "or a memory budget");
+    }
+
+    if (!options.statsOutputPath.empty()) {
+        // Statistics are gathered over the input for the one order of n-grams scored in memory
+        if (options.window > 0 || options.allOrders || !options.checkpointPath.empty() ||
+            (options.memoryBudget > 0 && options.budgetStrategy == MemoryBudgetStrategy::Spill)) {
+            throw std::invalid_argument("N-gram statistics cannot be combined with co-occurrence PMI, all orders, "
+                                        "checkpoints or spilling");
+        }
+    }
+
+    if (options.approximate) {
+        if (options.allOrders || !options.snapshotPath.empty()) {
+            throw std::invalid_argument("Approximate counting cannot be combined with all orders or snapshots");
+        }
+        if (options.sketchWidth < 1 || options.sketchDepth < 1 || options.sketchDepth > 16) {
+            throw std::invalid_argument("Invalid sketch size: " + std::to_string(options.sketchWidth) + " x " +
+                                        std::to_string(options.sketchDepth) + " (depth must be 1-16)");
+        }
+    }
+}
+
+/**
+ * @brief Smallest n-gram order counted for the options
+ *
+ * Partitioned snapshots need the unigrams as marginals, so they are counted
+ * in the same pass.
+ *
+ * @param options PMI calculation options
+ * @return uint32_t 1 in all-orders mode or for partitioned snapshots, otherwise n
+ */
+uint32_t minOrder(const PmiOptions& options) {
+    bool partitionedSnapshot = !options.snapshotPath.empty() && options.snapshotPartitions > 1;
+    return options.allOrders || partitionedSnapshot ? 1 : options.n;
+}
+
+/**
+ * @brief Memory-map an input where possible
+ *
+ * Uncompressed regular files are memory-mapped, advised for sequential
+ * reading and counted in place, so counting reads the page cache directly
+ * instead of a copy of the file.
+ * Stdin, compressed files and files that cannot be mapped (empty files,
+ * pipes) are left to be streamed in line-aligned blocks.
+ *
+ * @param path Input path ("-" for stdin)
+ * @param mapping Receives the mapping when the input is mapped
+ * @param sizeHint Receives the file size when it is known
+ * @return bool True if the input is mapped
+ */
+bool mapInput(const std::string& path, std::unique_ptr<MemoryMappedProcessor>& mapping, size_t& sizeHint) {
+    sizeHint = 0;
+    if (path == "-" || detectFileCompression(path) != Compression::None) {
+        return false;
+    }
+    mapping = std::make_unique<MemoryMappedProcessor>(path);
+    sizeHint = mapping->getFileSize();
+    if (mapping->isMapped()) {
+        mapping->adviseSequential();
+        return true;
+    }
+    mapping.reset();
+    return false;
+}
+
+/**
+ * @brief Write one scored n-gram as a TSV row; scores keep full precision
+ *
+ * @param output Text output
+ * @param item Item to write
+ */
+void writePmiRow(OutputWriter& output, const PmiItem& item) {
+    output.write(item.ngram);
+    output.put('\t');
+    output.writeNumber(item.score);
+    output.put('\t');
+    output.writeNumber(static_cast<uint64_t>(item.frequency));
+    output.put('\n');
+}
+
+/**
+ * @brief Write scored n-grams as TSV with a header, and in binary if requested
+ *
+ * With PmiOptions::outputShards above 1 the rows are split over that many
+ * shard files by PmiOptions::shardRouting, each with the header and its
+ * rows in score order.
+ *
+ * @param pmiScores Items to write, in order
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param binaryPath Binary results path (empty for none)
+ * @param n N-gram size of the items
+ * @param options Text output options: compressOutput (also chosen by a ".zst" path;
+ *        ignored for Arrow output, chosen by a ".arrow" path), outputShards and shardRouting
+ * @throws std::invalid_argument If sharded output is asked for on stdout or as Arrow
+ * @throws std::runtime_error If an output cannot be written
+ */
+void writePmiItems(
+    const std::vector<PmiItem>& pmiScores,
     const std::string& outputPath,
+    const std::string& binaryPath,
+    uint32_t n,
     const PmiOptions& options
 ) {
-    // Use structured callback if provided, otherwise use simple callback
-    if (options.structuredProgressCallback) {
-        return calculatePmiWithStructuredProgress(inputPath, outputPath, options.structuredProgressCallback, options);
-    } else if (options.progressCallback) {
-        return calculatePmiWithProgress(inputPath, outputPath, options.progressCallback, options);
-    } else {
-        // Create a no-op callback
-        auto noopCallback = [](double) {};
-        return calculatePmiWithProgress(inputPath, outputPath, noopCallback, options);
+    if (!binaryPath.empty()) {
+        writePmiResults(binaryPath, n, pmiScores);
+    }
+
+    // Check if output is null (special case for no output)
+    if (outputPath == "null") {
+        return;
     }
+    if (outputPath != "-") {
+        prepareOutputPath(outputPath);
+    }
+
+    if (options.outputShards > 1) {
+        if (isArrowOutputPath(outputPath)) {
+            throw std::invalid_argument("Sharded output is written as text; it cannot be written as Arrow: " +
+                                        outputPath);
+        }
+        ShardedOutputWriter shards(outputPath, options.outputShards, options.shardRouting, options.compressOutput);
+        for (uint32_t i = 0; i < shards.shardCount(); ++i) {
+            shards.shard(i).write("ngram\tpmi\tfrequency\n");
+        }
+        for (const auto& item : pmiScores) {
+            writePmiRow(shards.shard(shards.shardOf(item.ngram)), item);
+        }
+        shards.close();
+        return;
+    }
+
+    // Columnar output carries the same columns as the TSV header
+    if (isArrowOutputPath(outputPath)) {
+        ArrowFileWriter table(outputPath, {{"ngram", ArrowType::Utf8},
+                                           {"pmi", ArrowType::Float64},
+                                           {"frequency", ArrowType::UInt32}});
+        for (const auto& item : pmiScores) {
+            table.append(0, item.ngram);
+            table.append(1, item.score);
+            table.append(2, item.frequency);
+            table.endRow();
+        }
+        table.close();
+        return;
+    }
+
+    OutputWriter output(outputPath, OutputWriter::kDefaultBufferSize,
+                        options.compressOutput || isCompressedOutputPath(outputPath));
+
+    // Write header
+    output.write("ngram\tpmi\tfrequency\n");
+
+    // Write results
+    for (const auto& item : pmiScores) {
+        writePmiRow(output, item);
+    }
+    output.close();
 }
 
-PmiResult calculatePmiWithStructuredProgress(
-    const std::string& inputPath,
+/**
+ * @brief Output path of one order in all-orders mode
+ *
+ * "out.tsv" becomes "out.2gram.tsv"; stdout and "null" are shared by all orders.
+ *
+ * @param outputPath Output path given by the caller
+ * @param n N-gram size
+ * @return std::string Output path for that order
+ */
+std::string orderOutputPath(const std::string& outputPath, uint32_t n) {
+    if (outputPath == "-" || outputPath == "null") {
+        return outputPath;
+    }
+    std::filesystem::path path(outputPath);
+    std::string name = path.stem().string() + "." + std::to_string(n) + "gram" + path.extension().string();
+    return (path.parent_path() / name).string();
+}
+
+/**
+ * @brief Report completion and fill in the timing of a run
+ *
+ * @param result Counts of the run
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @param fileSize Input size in bytes, for throughput
+ * @param startTime Start of the run, for elapsed time
+ * @return PmiResult The result with elapsed time, throughput and the input of its metrics
+ */
+PmiResult finishRun(
+    PmiResult result,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime
+) {
+    ProgressInfo info;
+
+    // Final progress update
+    info.phase = ProgressInfo::Phase::Complete;
+    info.phaseRatio = 1.0;
+    info.overallRatio = 1.0;
+    progressCallback(info);
+
+    // Calculate elapsed time
+    auto endTime = std::chrono::high_resolution_clock::now();
+    auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+
+    // Calculate processing speed
+    double mbProcessed = static_cast<double>(fileSize) / (1024 * 1024);
+    double mbPerSec = mbProcessed / (static_cast<double>(elapsedMs) / 1000.0);
+
+    // Log results if verbose mode is enabled
+    if (options.verbose) {
+        std::cerr << "PMI calculation completed:" << std::endl
+                  << "  Total n-grams: " << result.grams << std::endl
+                  << "  Elapsed time: " << elapsedMs << " ms" << std::endl
+                  << "  Processing speed: " << mbPerSec << " MB/s" << std::endl;
+    }
+
+    // Return results
+    result.elapsedMs = elapsedMs;
+    result.mbPerSec = mbPerSec;
+    result.metrics.bytesIn = fileSize;
+    result.metrics.threads = resolveThreads(options.threads);
+    return result;
+}
+
+/**
+ * @brief Score counted n-grams, keep the top K and write them
+ *
+ * With several orders counted, each order is written to orderOutputPath()
+ * and scored against the unigram counts as marginals.
+ *
+ * @param ngramCounts N-gram counts of one or more orders
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @param fileSize Input size in bytes, for throughput
+ * @param startTime Start of the run, for elapsed time
+ * @param kept Receives a copy of the items kept for the highest order, or nullptr
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult scoreAndWrite(
+    const MultiOrderNgramCounter& ngramCounts,
     const std::string& outputPath,
     const std::function<void(const ProgressInfo&)>& progressCallback,
-    const PmiOptions& options
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime,
+    std::vector<PmiItem>* kept = nullptr
 ) {
-    try {
-        // Track last reported progress to avoid excessive callbacks
-        // Use atomic for thread safety
-        std::atomic<double> lastReportedProgress{0.0};
+    ProgressInfo info;
+    PmiResult result;
+    // Unigrams counted only as snapshot marginals are not scored
+    const uint32_t firstOrder = options.allOrders ? ngramCounts.minOrder() : ngramCounts.maxOrder();
+    const bool multiOrder = firstOrder < ngramCounts.maxOrder();
+    const uint32_t orderCount = ngramCounts.maxOrder() - firstOrder + 1;
+
+    // Snapshots and results are written on a writer thread while the next
+    // order is scored; the counts are only read by both
+    BackgroundWriter background;
+
+    for (uint32_t n = firstOrder; n <= ngramCounts.maxOrder(); ++n) {
+        const PartitionedNgramCounter& counts = ngramCounts.order(n);
+        if (!options.snapshotPath.empty()) {
+            std::string snapshotPath = multiOrder ? orderOutputPath(options.snapshotPath, n) : options.snapshotPath;
+            background.submit([&ngramCounts, &counts, &options, snapshotPath]() {
+                if (options.snapshotPartitions > 1) {
+                    writePartitionedSnapshots(snapshotPath, counts, ngramCounts.order(1), options.snapshotPartitions);
+                } else {
+                    writeSnapshot(snapshotPath, counts);
+                }
+            });
+        }
+        double orderShare = 0.2 / orderCount;
+        double orderStart = 0.8 + orderShare * (n - firstOrder);
 
-        // Start timing
-        auto startTime = std::chrono::high_resolution_clock::now();
+        // Update progress for calculation phase
+        info.phase = ProgressInfo::Phase::Calculating;
+        info.phaseRatio = 0.0;
+        info.overallRatio = orderStart;
+        progressCallback(info);
 
-        // Initial progress report
-        ProgressInfo info;
-        info.phase = ProgressInfo::Phase::Reading;
+        // Calculate PMI scores, keeping the top K highest first
+        std::vector<PmiItem> pmiScores = multiOrder && n > 1
+            ? calculatePmiScores(counts, ngramCounts.order(1), options.minFreq, options.topK)
+            : calculatePmiScores(counts, options.minFreq, options.topK);
+
+        // Update progress after calculation
+        info.phase = ProgressInfo::Phase::Calculating;
+        info.phaseRatio = 1.0;
+        info.overallRatio = orderStart + orderShare / 2;
+        progressCallback(info);
+
+        // Update progress for writing phase
+        info.phase = ProgressInfo::Phase::Writing;
         info.phaseRatio = 0.0;
-        info.overallRatio = 0.0;
+        info.overallRatio = orderStart + orderShare / 2;
         progressCallback(info);
 
-        // Check if input is stdin or if file exists
-        bool isStdin = (inputPath == "-");
-        if (!isStdin && !std::filesystem::exists(inputPath)) {
-            throw std::runtime_error("Input file does not exist: " + inputPath);
+        std::string orderPath = multiOrder ? orderOutputPath(outputPath, n) : outputPath;
+        std::string binaryPath = multiOrder && !options.binaryOutputPath.empty()
+            ? orderOutputPath(options.binaryOutputPath, n)
+            : options.binaryOutputPath;
+        size_t distinctNgrams = pmiScores.size();
+        if (kept && n == ngramCounts.maxOrder()) {
+            *kept = pmiScores;
         }
+        background.submit([scores = std::move(pmiScores), orderPath, binaryPath, n, &options]() {
+            writePmiItems(scores, orderPath, binaryPath, n, options);
+        });
 
-        // Early validation of options
-        if (options.n < 1 || options.n > 3) {
-            throw std::invalid_argument("Invalid n-gram size: " + std::to_string(options.n) + " (must be 1, 2, or 3)");
+        if (multiOrder) {
+            PmiOrderResult orderResult;
+            orderResult.n = n;
+            orderResult.grams = counts.size();
+            orderResult.distinctNgrams = distinctNgrams;
+            orderResult.outputPath = orderPath;
+            result.orders.push_back(orderResult);
         }
 
-        if (options.topK < 1) {
-            throw std::invalid_argument("Invalid topK: " + std::to_string(options.topK) + " (must be at least 1)");
+        // The highest order fills the overall result
+        result.grams = counts.size();
+        result.distinctNgrams = distinctNgrams;
+    }
+    background.finish();
+
+    return finishRun(result, progressCallback, options, fileSize, startTime);
+}
+
+/**
+ * @brief Score approximate counts, keep the top K and write them
+ *
+ * @param ngramCounts Approximate n-gram counts
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @param fileSize Input size in bytes, for throughput
+ * @param startTime Start of the run, for elapsed time
+ * @param kept Receives a copy of the items kept, or nullptr
+ * @return PmiResult Results of the PMI calculation, with the error bounds
+ */
+PmiResult scoreAndWrite(
+    const ApproximateNgramCounter& ngramCounts,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime,
+    std::vector<PmiItem>* kept = nullptr
+) {
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Calculating;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.8;
+    progressCallback(info);
+
+    // Only the heavy hitters are scored
+    std::vector<PmiItem> pmiScores = calculatePmiScores(ngramCounts, options.minFreq, options.topK);
+
+    info.phase = ProgressInfo::Phase::Writing;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.9;
+    progressCallback(info);
+
+    writePmiItems(pmiScores, outputPath, options.binaryOutputPath, ngramCounts.n(), options);
+    if (kept) {
+        *kept = pmiScores;
+    }
+
+    PmiResult result;
+    result.grams = ngramCounts.n() == 1 ? ngramCounts.unigrams().size() : ngramCounts.heavyHitters().size();
+    result.distinctNgrams = pmiScores.size();
+    result.countErrorBound = ngramCounts.errorBound();
+    result.errorProbability = ngramCounts.errorProbability();
+    if (options.verbose) {
+        std::cerr << "Approximate counting: " << ngramCounts.total() << " n-grams, counts overestimated by at most "
+                  << result.countErrorBound << " with probability " << (1.0 - result.errorProbability)
+                  << ", " << ngramCounts.memoryUsage() / (1024 * 1024) << " MB of tables" << std::endl;
+    }
+    return finishRun(result, progressCallback, options, fileSize, startTime);
+}
+
+/**
+ * @brief Build an empty counter for a run
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ * @param options PMI calculation options
+ * @param partitions Partitions per table (exact counting only)
+ * @param inputBytes Bytes the counter will see, to pre-size exact tables
+ * @return Counter Empty counter
+ */
+template <typename Counter>
+Counter makeCounter(const PmiOptions& options, size_t partitions, size_t inputBytes);
+
+template <>
+MultiOrderNgramCounter makeCounter(const PmiOptions& options, size_t partitions, size_t inputBytes) {
+    // Under a memory budget, tables grow from the smallest size instead of being sized for the input
+    bool budgeted = options.memoryBudget > 0 || memoryLimit() > 0;
+    return MultiOrderNgramCounter(minOrder(options), options.n, partitions, budgeted ? 0 : inputBytes);
+}
+
+template <>
+CooccurrenceCounter makeCounter(const PmiOptions& options, size_t partitions, size_t inputBytes) {
+    // Each unit pairs with up to window others; the bigram estimate is the floor of that
+    return CooccurrenceCounter(options.window, options.cooccurrenceUnit, partitions,
+                               memoryLimit() > 0 ? 0 : estimateDistinctNgrams(inputBytes, 2));
+}
+
+template <>
+ApproximateNgramCounter makeCounter(const PmiOptions& options, size_t, size_t) {
+    // The sketch is fixed in size; only the candidate table follows topK by default
+    size_t heavyHitters = options.heavyHitters > 0 ? options.heavyHitters : size_t{4} * options.topK;
+    return ApproximateNgramCounter(options.n, options.sketchWidth, options.sketchDepth, heavyHitters);
+}
+
+/**
+ * @brief Counting tables of the parallel workers
+ *
+ * Each worker slot builds its table on first use, on the thread that fills
+ * it, so slots that never get work cost nothing. With
+ * PmiOptions::numaAware, workers hold a ThreadPin for their slot while
+ * counting, so every table's pages are first touched, and allocated, on the
+ * slot's node. merge() then merges each node's tables on that node before
+ * merging the per-node results, so only one table per node crosses the
+ * interconnect.
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ */
+template <typename Counter>
+class WorkerTables {
+public:
+    /**
+     * @brief Constructor
+     * @param options PMI calculation options
+     * @param workers Number of worker slots
+     * @param inputBytes Input bytes per worker to pre-size exact tables
+     */
+    WorkerTables(const PmiOptions& options, unsigned int workers, size_t inputBytes)
+        : options_(options)
+        , workers_(workers)
+        , inputBytes_(inputBytes)
+        , tables_(workers)
+    {
+        if (options.numaAware) {
+            placement_.emplace(NumaTopology::system(), workers);
         }
+    }
 
-        if (options.minFreq < 1) {
-            throw std::invalid_argument("Invalid minFreq: " + std::to_string(options.minFreq) + " (must be at least 1)");
+    /**
+     * @brief Get the placement of the slots
+     * @return const WorkerPlacement* Placement, or nullptr unless NUMA-aware
+     */
+    const WorkerPlacement* placement() const { return placement_ ? &*placement_ : nullptr; }
+
+    /**
+     * @brief Get the table of a slot, building it on the calling thread the first time
+     * @param slot Worker slot (used by one thread at a time)
+     * @return Counter& Table of the slot
+     */
+    Counter& table(unsigned int slot) {
+        if (!tables_[slot]) {
+            tables_[slot].emplace(makeCounter<Counter>(options_, workers_, inputBytes_));
         }
+        return *tables_[slot];
+    }
 
-        // Determine number of threads
-        unsigned int numThreads = options.threads;
-        if (numThreads == 0) {
-            numThreads = std::thread::hardware_concurrency();
+    /**
+     * @brief Merge all tables, node by node first when placed
+     * @param numThreads Threads for the merge
+     * @return Counter Merged counts
+     */
+    Counter merge(unsigned int numThreads) {
+        parallel::TraceScope span("merge tables");
+        if (!placement_ || placement_->groups().size() <= 1) {
+            return Counter::mergeAll(take(0, workers_), numThreads);
         }
 
-        // Log configuration if verbose mode is enabled
-        if (options.verbose) {
-            std::cerr << "PMI calculation started with:" << std::endl
-                      << "  n-gram size: " << options.n << std::endl
-                      << "  topK: " << options.topK << std::endl
-                      << "  minFreq: " << options.minFreq << std::endl
-                      << "  threads: " << numThreads << std::endl;
+        // Merge each node's tables on that node, then the per-node results
+        const auto& groups = placement_->groups();
+        std::vector<std::optional<Counter>> nodeCounts(groups.size());
+        parallel::TaskGroup group("merge");
+        for (size_t g = 0; g < groups.size(); ++g) {
+            group.run([&, g]() {
+                ThreadPin pin(placement_->groupCpus(g));
+                const auto& slots = groups[g];
+                nodeCounts[g].emplace(Counter::mergeAll(take(slots.front(), slots.size()),
+                                                        static_cast<unsigned int>(slots.size())));
+            });
         }
+        group.wait();
 
-        // Read the entire input from stdin or file
-        std::string text;
-        size_t fileSize = 0;
-        size_t bytesRead = 0;
-        std::string line;
-
-        if (isStdin) {
-            // Read from stdin
-            while (std::getline(std::cin, line)) {
-                text += line;
-                text += '\n';
-
-                bytesRead += line.size() + 1; // +1 for newline
-
-                // Update progress for reading phase (less frequently for stdin)
-                if (text.size() % 10000 == 0) {
-                    // Update progress info
-                    info.phase = ProgressInfo::Phase::Reading;
-                    info.phaseRatio = 0.5; // Assume we're halfway through for stdin
-                    info.overallRatio = 0.15; // Reading is about 30% of total work
-
-                    progressCallback(info);
-                    lastReportedProgress.store(info.overallRatio);
-                }
-            }
-        } else {
-            // Get file size for progress reporting
-            try {
-                fileSize = std::filesystem::file_size(inputPath);
-                text.reserve(fileSize);
-            } catch (const std::exception& e) {
-                // Continue without reserving space
-            }
+        std::vector<Counter> merged;
+        merged.reserve(nodeCounts.size());
+        for (auto& counts : nodeCounts) {
+            merged.push_back(std::move(*counts));
+        }
+        return Counter::mergeAll(std::move(merged), numThreads);
+    }
 
-            // Open input file
-            std::ifstream inputFile(inputPath, std::ios::binary);
-            if (!inputFile) {
-                throw std::runtime_error("Failed to open input file: " + inputPath);
+private:
+    // Groups are consecutive slots; slots that never counted are left out
+    std::vector<Counter> take(size_t first, size_t count) {
+        std::vector<Counter> tables;
+        for (size_t i = first; i < first + count; ++i) {
+            if (tables_[i]) {
+                tables.push_back(std::move(*tables_[i]));
             }
+        }
+        if (tables.empty()) {
+            tables.push_back(makeCounter<Counter>(options_, workers_, 0));
+        }
+        return tables;
+    }
 
-            // Read file content
-            while (std::getline(inputFile, line)) {
-            text += line;
-            text += '\n';
+    const PmiOptions& options_;
+    unsigned int workers_;
+    size_t inputBytes_;
+    std::vector<std::optional<Counter>> tables_;
+    std::optional<WorkerPlacement> placement_;
+};
 
-            bytesRead += line.size() + 1; // +1 for newline
+/**
+ * @brief Create the memory budget of a run
+ *
+ * Without PmiOptions::memoryBudget, a process memory limit (setMemoryLimit())
+ * gives the exact tables half of it. They spill when that strategy is
+ * chosen and the run can merge spilled runs, and prune otherwise.
+ *
+ * @param options PMI calculation options
+ * @param workers Number of tables counted concurrently
+ * @param canSpill Whether the caller merges spilled runs before scoring
+ * @return std::unique_ptr<CountBudget> Budget, or nullptr when neither a budget nor a limit is set
+ */
+std::unique_ptr<CountBudget> makeBudget(const PmiOptions& options, unsigned int workers, bool canSpill = true) {
+    if (options.memoryBudget > 0) {
+        return std::make_unique<CountBudget>(options.memoryBudget, workers, options.budgetStrategy, options.tempDir);
+    }
+    if (memoryLimit() == 0 || options.approximate) {
+        return nullptr;
+    }
+    bool spill = canSpill && options.budgetStrategy == MemoryBudgetStrategy::Spill &&
+                 !options.allOrders && options.snapshotPartitions <= 1;
+    return std::make_unique<CountBudget>(memoryLimit() / 2, workers,
+                                         spill ? MemoryBudgetStrategy::Spill : MemoryBudgetStrategy::Prune,
+                                         options.tempDir);
+}
 
-            // Update progress for reading phase
-            if (fileSize > 0) {
-                double progress = static_cast<double>(bytesRead) / fileSize;
+/**
+ * @brief Count a text into a worker table (approximate tables are fixed in size)
+ */
+template <typename Counter>
+void addCountedText(Counter& counts, std::string_view text, CountBudget*) {
+    counts.addText(text);
+}
+
+/**
+ * @brief Count a text into an exact worker table, within the budget if there is one
+ */
+void addCountedText(MultiOrderNgramCounter& counts, std::string_view text, CountBudget* budget) {
+    if (budget) {
+        budget->addText(counts, text);
+    } else {
+        counts.addText(text);
+    }
+}
 
-                // Update progress info
-                info.phase = ProgressInfo::Phase::Reading;
-                info.phaseRatio = progress;
-                info.overallRatio = progress * 0.3; // Reading is about 30% of total work
+/**
+ * @brief Score approximate counts (see scoreAndWrite())
+ */
+PmiResult scoreCounted(
+    ApproximateNgramCounter&& ngramCounts,
+    CountBudget*,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime,
+    std::vector<PmiItem>* kept = nullptr
+) {
+    return scoreAndWrite(ngramCounts, outputPath, progressCallback, options, fileSize, startTime, kept);
+}
 
-                // Report at specific thresholds or if significant progress made
-                double currentProgress = lastReportedProgress.load();
-                if (info.overallRatio >= currentProgress + options.progressStep ||
-                    (progress >= 0.99 && currentProgress < 0.29)) {
-                    progressCallback(info);
-                    lastReportedProgress.store(info.overallRatio);
-                }
+/**
+ * @brief Score co-occurring pairs, keep the top K and write them
+ *
+ * @param pairCounts Merged pair counts
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @param fileSize Input size in bytes, for throughput
+ * @param startTime Start of the run, for elapsed time
+ * @return PmiResult Results of the PMI calculation; grams counts the distinct pairs
+ */
+PmiResult scoreCounted(
+    CooccurrenceCounter&& pairCounts,
+    CountBudget*,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime
+) {
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Calculating;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.8;
+    progressCallback(info);
+
+    std::vector<PmiItem> pmiScores = calculateCooccurrenceScores(pairCounts, options.minFreq, options.topK);
+
+    info.phase = ProgressInfo::Phase::Writing;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.9;
+    progressCallback(info);
+
+    writePmiItems(pmiScores, outputPath, "", 2, options);
+
+    PmiResult result;
+    result.grams = pairCounts.size();
+    result.distinctNgrams = pmiScores.size();
+    if (options.verbose) {
+        std::cerr << "Co-occurrence counting: " << pairCounts.pairTotal() << " pairs within " << pairCounts.window()
+                  << " of " << pairCounts.unitTotal() << " units" << std::endl;
+    }
+    return finishRun(result, progressCallback, options, fileSize, startTime);
+}
+
+/**
+ * @brief Score exact counts and report how the budget was kept
+ *
+ * When the budget spilled, the counts still in memory become the last run
+ * and all runs are merged and scored as snapshots; otherwise the counts are
+ * scored in memory, with the pruning error bound when they were pruned.
+ *
+ * @param ngramCounts Merged counts (consumed)
+ * @param budget Memory budget of the run, or nullptr
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @param fileSize Input size in bytes, for throughput
+ * @param startTime Start of the run, for elapsed time
+ * @param kept Receives a copy of the items kept when the counts are scored in memory, or nullptr
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult scoreCounted(
+    MultiOrderNgramCounter&& ngramCounts,
+    CountBudget* budget,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options,
+    size_t fileSize,
+    std::chrono::high_resolution_clock::time_point startTime,
+    std::vector<PmiItem>* kept = nullptr
+) {
+    if (budget && budget->used() == MemoryBudgetStrategy::Spill) {
+        {
+            // Release the last run's table before the merge
+            MultiOrderNgramCounter counts = std::move(ngramCounts);
+            budget->spill(counts);
+        }
+        PmiResult result = scoreSnapshots(budget->runs(), {}, outputPath, progressCallback, options);
+        auto elapsed = std::chrono::high_resolution_clock::now() - startTime;
+        result.elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        result.mbPerSec = static_cast<double>(fileSize) / (1024 * 1024) / (static_cast<double>(result.elapsedMs) / 1000.0);
+        result.metrics.bytesIn = fileSize;
+        result.budgetStrategy = MemoryBudgetStrategy::Spill;
+        return result;
+    }
+
+    PmiResult result = scoreAndWrite(ngramCounts, outputPath, progressCallback, options, fileSize, startTime, kept);
+    if (budget && budget->used() == MemoryBudgetStrategy::Prune) {
+        result.budgetStrategy = MemoryBudgetStrategy::Prune;
+        result.countErrorBound = budget->errorBound();
+    }
+    return result;
+}
+
+/**
+ * @brief Count n-grams over several files into one table
+ *
+ * Workers take whole files from the list, largest first, and count them
+ * into per-worker tables that are merged once all files are read.
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ * @param files Files to read, largest first
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+template <typename Counter>
+PmiResult countFileSet(
+    const std::vector<InputFile>& files,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+
+    unsigned int numThreads = static_cast<unsigned int>(
+        std::max<size_t>(1, std::min<size_t>(resolveThreads(options.threads), files.size())));
+
+    uint64_t totalBytes = 0;
+    for (const auto& file : files) {
+        totalBytes += file.size;
+    }
+
+    std::unique_ptr<CountBudget> budget = makeBudget(options, numThreads);
+    WorkerTables<Counter> threadCounts(options, numThreads, static_cast<size_t>(totalBytes / numThreads));
+    std::atomic<size_t> nextFile(0);
+    ProgressReporter progress(progressCallback, options.progressStep);
+    parallel::TaskGroup group("count");
+
+    auto worker = [&](unsigned int slot) {
+        ThreadPin pin(threadCounts.placement(), slot);
+        std::string block;
+        while (!group.failed()) {
+            size_t index = nextFile.fetch_add(1);
+            if (index >= files.size()) {
+                return;
             }
+            const InputFile& file = files[index];
+            Counter& counts = threadCounts.table(slot);
+
+            std::unique_ptr<MemoryMappedProcessor> mapping;
+            size_t sizeHint = 0;
+            if (mapInput(file.path, mapping, sizeHint)) {
+                addCountedText(counts, std::string_view(mapping->data(), mapping->getFileSize()), budget.get());
+            } else {
+                // Compressed files hold more text than their size, so they are streamed until EOF
+                std::unique_ptr<std::istream> input = openInputStream(file.path, 1);
+                LineBlockReader reader(*input);
+                while (reader.next(block)) {
+                    addCountedText(counts, block, budget.get());
+                }
             }
+
+            progress.add(file.size);
         }
+    };
 
-        // Update progress after reading complete
-        info.phase = ProgressInfo::Phase::Processing;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.3; // Reading phase complete
-        progressCallback(info);
-        lastReportedProgress.store(info.overallRatio);
+    // Reading and counting are 80% of the work, counted in input bytes
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 0.8, totalBytes);
+    for (unsigned int i = 0; i < numThreads; ++i) {
+        group.run([&worker, i]() { worker(i); });
+    }
+    group.wait();
+    progress.endPhase();
 
-        // Count n-grams
-        std::unordered_map<std::string, uint32_t> ngramCounts;
+    // Merge partition by partition on all workers
+    Counter ngramCounts = threadCounts.merge(numThreads);
 
-        if (numThreads > 1 && text.size() > 10000) {
-            // Parallel n-gram counting for large inputs
-            std::vector<std::thread> threads;
-            std::vector<std::unordered_map<std::string, uint32_t>> threadCounts(numThreads);
-            std::mutex progressMutex;
+    return scoreCounted(std::move(ngramCounts), budget.get(), outputPath, progressCallback, options,
+                        static_cast<size_t>(totalBytes), startTime);
+}
 
-            // Calculate chunk size
-            size_t chunkSize = text.size() / numThreads;
-            if (chunkSize == 0) chunkSize = 1;
+/**
+ * @brief Count n-grams over several files into one table (see countFileSet())
+ */
+PmiResult calculatePmiFileSet(
+    const std::vector<InputFile>& files,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    if (!options.statsOutputPath.empty()) {
+        throw std::invalid_argument("N-gram statistics take a single input file");
+    }
 
-            // Launch threads
-            for (unsigned int i = 0; i < numThreads; ++i) {
-                size_t start = i * chunkSize;
-                size_t end = (i == numThreads - 1) ? text.size() : (i + 1) * chunkSize;
+    // Snapshots are merged instead of counted
+    size_t snapshots = 0;
+    for (const auto& file : files) {
+        snapshots += isSnapshotFile(file.path) ? 1 : 0;
+    }
+    if (snapshots > 0) {
+        if (snapshots != files.size()) {
+            throw std::invalid_argument("Cannot mix n-gram snapshots and text inputs");
+        }
+        std::vector<InputFile> ordered = files;
+        std::sort(ordered.begin(), ordered.end(),
+                  [](const InputFile& a, const InputFile& b) { return a.order < b.order; });
+        std::vector<std::string> paths;
+        for (const auto& file : ordered) {
+            paths.push_back(file.path);
+        }
+        return scoreSnapshots(paths, {}, outputPath, progressCallback, options);
+    }
 
-                // Adjust end to avoid cutting in the middle of a character
-                while (end < text.size() && (text[end] & 0xC0) == 0x80) {
-                    end++;
-                }
+    if (!options.checkpointPath.empty()) {
+        throw std::invalid_argument("Checkpointing takes a single input file");
+    }
 
-                threads.emplace_back([&, i, start, end]() {
-                    // Extract chunk
-                    std::string chunk = text.substr(start, end - start);
+    if (options.window > 0) {
+        return countFileSet<CooccurrenceCounter>(files, outputPath, progressCallback, options);
+    }
+    if (options.approximate) {
+        return countFileSet<ApproximateNgramCounter>(files, outputPath, progressCallback, options);
+    }
+    return countFileSet<MultiOrderNgramCounter>(files, outputPath, progressCallback, options);
+}
 
-                    // Count n-grams in chunk
-                    threadCounts[i] = countNgrams(chunk, options.n);
+/**
+ * @brief Count a text on several threads and merge the worker tables
+ *
+ * The text is split at line boundaries so no n-gram straddles two chunks,
+ * into several chunks per worker. Workers claim chunks as they finish the
+ * last one, so a slow worker or a dense chunk does not hold up the rest, and
+ * count them in place. Small inputs and single-thread runs are counted on
+ * the calling thread. With the GPU backend, exact counts are gathered on
+ * the device instead (see countNgramsOnGpu()).
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ * @param text Input text
+ * @param numThreads Number of worker threads
+ * @param options PMI calculation options
+ * @param budget Memory budget for numThreads workers, or nullptr
+ * @param progress Reporter the counted bytes are added to, or nullptr
+ * @return Counter Merged counts
+ */
+template <typename Counter>
+Counter countText(
+    std::string_view text,
+    unsigned int numThreads,
+    const PmiOptions& options,
+    CountBudget* budget,
+    ProgressReporter* progress
+) {
+    if constexpr (std::is_same_v<Counter, MultiOrderNgramCounter>) {
+        if (options.countingBackend == CountingBackend::Gpu) {
+            Counter counts = makeCounter<Counter>(options, 1, text.size());
+            countNgramsOnGpu(text, counts);
+            if (progress) {
+                progress->add(text.size());
+            }
+            return counts;
+        }
+    }
 
-                    // Update progress
-                    {
-                        std::lock_guard<std::mutex> lock(progressMutex);
+    // Chunks of the tuned size; a text that fills only one is counted on this thread
+    const uint64_t chunkBytes = tuneWorkers(numThreads, WorkloadShape{text.size()}).chunkBytes;
+    const size_t chunkCount = chunkBytes > 0 ? static_cast<size_t>(text.size() / chunkBytes) : 0;
+    if (numThreads <= 1 || chunkCount <= 1) {
+        // Single-threaded n-gram counting into a table sized for the input
+        Counter counts = makeCounter<Counter>(options, 1, text.size());
+        addCountedText(counts, text, budget);
+        return counts;
+    }
 
-                        // Calculate thread progress
-                        double threadProgress = static_cast<double>(i + 1) / numThreads;
+    // Every worker partitions its table the same way, so partitions merge independently
+    WorkerTables<Counter> threadCounts(options, numThreads, text.size() / numThreads);
 
-                        // Update progress info
-                        ProgressInfo threadInfo;
-                        threadInfo.phase = ProgressInfo::Phase::Processing;
-                        threadInfo.phaseRatio = threadProgress;
-                        threadInfo.overallRatio = 0.3 + threadProgress * 0.5; // Processing is 50% of total work
+    // Split at line boundaries so no n-gram straddles two chunks
+    std::vector<size_t> bounds(chunkCount + 1, text.size());
+    bounds[0] = 0;
+    for (size_t i = 1; i < chunkCount; ++i) {
+        size_t split = std::max(bounds[i - 1], text.size() / chunkCount * i);
+        size_t newline = text.find('\n', split);
+        bounds[i] = newline == std::string_view::npos ? text.size() : newline + 1;
+    }
 
-                        // Report progress if significant
-                        double currentProgress = lastReportedProgress.load();
-                        if (threadInfo.overallRatio >= currentProgress + options.progressStep) {
-                            progressCallback(threadInfo);
-                            lastReportedProgress.store(threadInfo.overallRatio);
-                        }
-                    }
-                });
+    std::atomic<size_t> nextChunk(0);
+    parallel::TaskGroup group("count");
+    for (unsigned int slot = 0; slot < numThreads; ++slot) {
+        group.run([&, slot]() {
+            ThreadPin pin(threadCounts.placement(), slot);
+            while (!group.failed()) {
+                size_t chunk = nextChunk.fetch_add(1);
+                if (chunk >= chunkCount) {
+                    return;
+                }
+                addCountedText(threadCounts.table(slot), text.substr(bounds[chunk], bounds[chunk + 1] - bounds[chunk]),
+                               budget);
+                if (progress) {
+                    progress->add(bounds[chunk + 1] - bounds[chunk]);
+                }
             }
+        });
+    }
+    group.wait();
+
+    // Merge results, one partition per thread
+    return threadCounts.merge(numThreads);
+}
+
+/**
+ * @brief Count a stream while it is being read
+ *
+ * The calling thread reads the stream in line-aligned blocks and hands them
+ * to the workers through a bounded queue, so counting overlaps reading and
+ * only a few blocks per worker are ever held in memory. Block buffers go
+ * back to the reader once counted and are reused. When the queue is full and
+ * some worker has not started yet (the pool is busy elsewhere), the reader
+ * takes over that worker's slot and counts blocks itself, so the pipeline
+ * never waits on a worker that cannot run. Single-thread runs count each
+ * block on the calling thread as soon as it is read, and so does the GPU
+ * backend, on the device.
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ * @param input Input stream, read until EOF
+ * @param numThreads Number of worker threads
+ * @param options PMI calculation options
+ * @param budget Memory budget for numThreads workers, or nullptr
+ * @param sizeHint Expected input size to pre-size exact tables (0 if unknown)
+ * @param onRead Called on the reading thread with the bytes read so far
+ * @param onReadDone Called once the stream is exhausted
+ * @return Counter Merged counts
+ * @throws std::runtime_error If the stream cannot be decoded
+ */
+template <typename Counter>
+Counter countStream(
+    std::istream& input,
+    unsigned int numThreads,
+    const PmiOptions& options,
+    CountBudget* budget,
+    size_t sizeHint,
+    const std::function<void(size_t)>& onRead,
+    const std::function<void()>& onReadDone
+) {
+    LineBlockReader reader(input);
+    std::string block;
+    if constexpr (std::is_same_v<Counter, MultiOrderNgramCounter>) {
+        // Blocks go to the device as they are read
+        if (options.countingBackend == CountingBackend::Gpu) {
+            Counter counts = makeCounter<Counter>(options, 1, sizeHint);
+            while (reader.next(block)) {
+                countNgramsOnGpu(block, counts);
+                onRead(static_cast<size_t>(reader.bytesRead()));
+            }
+            onReadDone();
+            return counts;
+        }
+    }
+    if (numThreads <= 1) {
+        Counter counts = makeCounter<Counter>(options, 1, sizeHint);
+        while (reader.next(block)) {
+            addCountedText(counts, block, budget);
+            onRead(static_cast<size_t>(reader.bytesRead()));
+        }
+        onReadDone();
+        return counts;
+    }
 
-            // Wait for all threads to complete
-            for (auto& thread : threads) {
-                thread.join();
+    // Every worker partitions its table the same way, so partitions merge independently
+    WorkerTables<Counter> threadCounts(options, numThreads, sizeHint / numThreads);
+    const size_t maxQueued = size_t{2} * numThreads;
+    std::mutex queueMutex;
+    std::condition_variable blockReady;
+    std::condition_variable blockTaken;
+    std::deque<std::string> queued;
+    std::vector<std::string> spare;
+    bool finished = false;
+    std::exception_ptr failure;
+
+    // A slot is run by its worker or, if the worker has not started, by the reader
+    std::vector<std::atomic<bool>> slotTaken(numThreads);
+    unsigned int readerSlot = numThreads;
+
+    auto worker = [&](unsigned int slot) {
+        if (slotTaken[slot].exchange(true)) {
+            return;
+        }
+        ThreadPin pin(threadCounts.placement(), slot);
+        std::string text;
+        std::unique_lock<std::mutex> lock(queueMutex);
+        while (true) {
+            blockReady.wait(lock, [&]() { return !queued.empty() || finished; });
+            if (queued.empty()) {
+                return;
             }
+            text = std::move(queued.front());
+            queued.pop_front();
+            blockTaken.notify_one();
+            lock.unlock();
 
-            // Merge results
-            for (const auto& counts : threadCounts) {
-                for (const auto& [ngram, count] : counts) {
-                    ngramCounts[ngram] += count;
+            try {
+                addCountedText(threadCounts.table(slot), text, budget);
+            } catch (...) {
+                lock.lock();
+                if (!failure) {
+                    failure = std::current_exception();
                 }
+                blockTaken.notify_all();
+                return;
             }
-        } else {
-            // Single-threaded n-gram counting
-            ngramCounts = countNgrams(text, options.n);
 
-            // Update progress
-            info.phase = ProgressInfo::Phase::Processing;
-            info.phaseRatio = 1.0;
-            info.overallRatio = 0.8; // Processing complete
-            progressCallback(info);
-            lastReportedProgress.store(info.overallRatio);
+            lock.lock();
+            spare.push_back(std::move(text));
         }
+    };
 
-        // Update progress for calculation phase
-        info.phase = ProgressInfo::Phase::Calculating;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.8;
-        progressCallback(info);
-        lastReportedProgress.store(info.overallRatio);
+    parallel::TaskGroup group("count");
+    for (unsigned int i = 0; i < numThreads; ++i) {
+        group.run([&worker, i]() { worker(i); });
+    }
 
-        // Calculate PMI scores
-        std::vector<PmiItem> pmiScores = calculatePmiScores(ngramCounts, options.n, options.minFreq);
+    try {
+        while (reader.next(block)) {
+            onRead(static_cast<size_t>(reader.bytesRead()));
+
+            std::unique_lock<std::mutex> lock(queueMutex);
+            if (queued.size() >= maxQueued && readerSlot == numThreads) {
+                for (unsigned int slot = numThreads; slot-- > 0;) {
+                    if (!slotTaken[slot].exchange(true)) {
+                        readerSlot = slot;
+                        break;
+                    }
+                }
+            }
+            if (queued.size() >= maxQueued && readerSlot < numThreads && !failure) {
+                lock.unlock();
+                addCountedText(threadCounts.table(readerSlot), block, budget);
+                continue;
+            }
+            blockTaken.wait(lock, [&]() { return queued.size() < maxQueued || failure; });
+            if (failure) {
+                break;
+            }
+            queued.push_back(std::move(block));
+            blockReady.notify_one();
+            block.clear();
+            if (!spare.empty()) {
+                block = std::move(spare.back());
+                spare.pop_back();
+            }
+        }
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        if (!failure) {
+            failure = std::current_exception();
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        finished = true;
+    }
+    blockReady.notify_all();
+    if (!failure) {
+        onReadDone();
+    }
+    group.wait();
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+
+    // Merge results, one partition per thread
+    return threadCounts.merge(numThreads);
+}
+
+/**
+ * @brief Count an input, in place when it can be mapped and streamed otherwise
+ *
+ * @tparam Counter MultiOrderNgramCounter, ApproximateNgramCounter or CooccurrenceCounter
+ * @param path Input path ("-" for stdin)
+ * @param numThreads Number of worker threads
+ * @param options PMI calculation options
+ * @param budget Memory budget for numThreads workers, or nullptr
+ * @param onRead Called with the bytes read so far
+ * @param onReadDone Called once the whole input is read or mapped
+ * @param progress Reporter the bytes counted from a mapped input are added to, or nullptr
+ * @return Counter Merged counts
+ * @throws std::runtime_error If the input cannot be opened or decoded
+ */
+template <typename Counter>
+Counter countInput(
+    const std::string& path,
+    unsigned int numThreads,
+    const PmiOptions& options,
+    CountBudget* budget,
+    const std::function<void(size_t)>& onRead,
+    const std::function<void()>& onReadDone,
+    ProgressReporter* progress
+) {
+    std::unique_ptr<MemoryMappedProcessor> mapping;
+    size_t sizeHint = 0;
+    if (mapInput(path, mapping, sizeHint)) {
+        onRead(sizeHint);
+        onReadDone();
+        return countText<Counter>(std::string_view(mapping->data(), sizeHint), numThreads, options, budget, progress);
+    }
+
+    std::unique_ptr<std::istream> input = openInputStream(path, numThreads);
+    return countStream<Counter>(*input, numThreads, options, budget, sizeHint, onRead, onReadDone);
+}
+
+} // namespace
+
+PmiResult calculatePmi(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    parallel::TraceScope span("pmi", "operation");
+
+    // Use structured callback if provided, otherwise use simple callback
+    if (options.structuredProgressCallback) {
+        return calculatePmiWithStructuredProgress(inputPath, outputPath, options.structuredProgressCallback, options);
+    } else if (options.progressCallback) {
+        return calculatePmiWithProgress(inputPath, outputPath, options.progressCallback, options);
+    } else {
+        // Create a no-op callback
+        auto noopCallback = [](double) {};
+        return calculatePmiWithProgress(inputPath, outputPath, noopCallback, options);
+    }
+}
+
+namespace {
+
+/**
+ * @brief Choose the counting workers for an input (see tuneWorkers())
+ *
+ * Approximate workers each hold a whole sketch, so their count is bounded
+ * by memory as well. Exact runs with several workers count into
+ * hash-partitioned tables that merge partition by partition, hence
+ * "sharded".
+ *
+ * @param options PMI calculation options
+ * @param inputBytes Input size (0 = unknown, as for stdin and compressed input)
+ * @return TuningChoice Workers, chunk size and variant
+ */
+TuningChoice tuneCounting(const PmiOptions& options, uint64_t inputBytes) {
+    WorkloadShape shape;
+    shape.inputBytes = inputBytes;
+    shape.minBytesPerThread = kMinCountBytesPerThread;
+    if (options.approximate) {
+        shape.memoryPerThread = uint64_t{options.sketchWidth} * options.sketchDepth * sizeof(uint32_t);
+    }
+    TuningChoice tuning = tuneWorkers(options.threads, shape);
+    if (options.approximate) {
+        tuning.variant = "approximate";
+    } else if (options.countingBackend == CountingBackend::Gpu) {
+        tuning.variant = "gpu";
+    } else if (tuning.threads > 1) {
+        tuning.variant = "sharded";
+    }
+    return tuning;
+}
+
+/**
+ * @brief Attach the tuning of a run to its result
+ */
+PmiResult withTuning(PmiResult result, const TuningChoice& tuning) {
+    result.metrics.threads = tuning.threads;
+    result.metrics.tuning = tuning;
+    return result;
+}
+
+/**
+ * @brief Count an input segment by segment, checkpointing after each, then score
+ *
+ * Each line-aligned segment of PmiOptions::checkpointInterval bytes is
+ * counted on all threads and written as a count snapshot; once it is on
+ * disk, the checkpoint records it and the input offset after it. A resumed
+ * run counts only the segments after that offset. The segment snapshots
+ * are merged and scored like any set of snapshots, which gives the counts
+ * of the whole input, since no n-gram crosses a line.
+ *
+ * @param inputPath Input file (plain text)
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param progress Progress reporter of the run, in its reading phase
+ * @param options PMI calculation options
+ * @param numThreads Number of worker threads
+ * @return PmiResult Results of the PMI calculation
+ * @throws std::invalid_argument If the input is stdin or compressed
+ * @throws std::runtime_error If the checkpoint does not match the run
+ */
+PmiResult calculatePmiCheckpointed(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    ProgressReporter& progress,
+    const PmiOptions& options,
+    unsigned int numThreads
+) {
+    if (inputPath == "-" || detectFileCompression(inputPath) != Compression::None) {
+        throw std::invalid_argument("Checkpointing needs a plain input file; stdin and compressed input cannot be "
+                                    "resumed at an offset");
+    }
+    std::unique_ptr<MemoryMappedProcessor> mapping;
+    size_t fileSize = 0;
+    if (!mapInput(inputPath, mapping, fileSize) && fileSize > 0) {
+        throw std::runtime_error("Failed to map input file for checkpointing: " + inputPath);
+    }
+    std::string_view text = mapping ? std::string_view(mapping->data(), fileSize) : std::string_view();
+
+    // The counts depend on the order only; scoring options may change between runs
+    Checkpoint checkpoint = openCheckpoint(options.checkpointPath, "pmi", inputPath,
+                                           "n=" + std::to_string(options.n), options.resume);
+    if (options.verbose && checkpoint.inputOffset > 0) {
+        std::cerr << "Resuming from checkpoint at byte " << checkpoint.inputOffset << " of " << fileSize
+                  << std::endl;
+    }
 
-        // Update progress after calculation
-        info.phase = ProgressInfo::Phase::Calculating;
-        info.phaseRatio = 1.0;
-        info.overallRatio = 0.9;
-        progressCallback(info);
-        lastReportedProgress.store(info.overallRatio);
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 0.8, fileSize);
+    progress.add(checkpoint.inputOffset);
+    // An empty input still leaves one (empty) snapshot to score
+    while (checkpoint.inputOffset < text.size() || checkpoint.segments.empty()) {
+        size_t begin = static_cast<size_t>(checkpoint.inputOffset);
+        size_t end = checkpointSegmentEnd(text, begin, options.checkpointInterval);
+        std::unique_ptr<CountBudget> budget = makeBudget(options, std::max(1u, numThreads), false);
+        MultiOrderNgramCounter counts = countText<MultiOrderNgramCounter>(
+            text.substr(begin, end - begin), numThreads, options, budget.get(), &progress);
+
+        std::string segmentPath = options.checkpointPath + "." + std::to_string(checkpoint.segments.size()) + ".snap";
+        writeSnapshot(segmentPath, counts.order(options.n));
+        syncFile(segmentPath);
+        checkpoint.segments.push_back(segmentPath);
+        checkpoint.inputOffset = end;
+        saveCheckpoint(options.checkpointPath, checkpoint);
+    }
+    progress.endPhase();
+    progress.stop();
+    mapping.reset();
 
-        // Sort by PMI score (descending)
-        std::sort(pmiScores.begin(), pmiScores.end(), [](const PmiItem& a, const PmiItem& b) {
-            return a.score > b.score;
-        });
+    PmiResult result = scoreSnapshots(checkpoint.segments, {}, outputPath, progressCallback, options);
+    removeCheckpoint(options.checkpointPath, checkpoint);
+    return result;
+}
 
-        // Limit to top K results
-        if (pmiScores.size() > options.topK) {
-            pmiScores.resize(options.topK);
-        }
+/**
+ * @brief Count and score one input (see calculatePmiWithStructuredProgress())
+ */
+PmiResult calculatePmiInput(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    try {
+        // Start timing
+        auto startTime = std::chrono::high_resolution_clock::now();
 
-        // Update progress for writing phase
-        info.phase = ProgressInfo::Phase::Writing;
-        info.phaseRatio = 0.0;
-        info.overallRatio = 0.9;
-        progressCallback(info);
-        lastReportedProgress.store(info.overallRatio);
+        // Reading and counting only count their bytes; the reporter thread reports them
+        ProgressReporter progress(progressCallback, options.progressStep);
+        progress.beginPhase(ProgressInfo::Phase::Reading, 0.0, 0.3);
 
-        // Check if output is null (special case for no output) or stdout
-        bool isStdout = (outputPath == "-");
+        // Directories and globs expand into a multi-file run, which reports for itself
+        if (isInputPattern(inputPath)) {
+            progress.stop();
+            validatePmiOptions(options);
+            return calculatePmiFileSet(expandInputPaths({inputPath}), outputPath, progressCallback, options);
+        }
 
-        if (outputPath != "null") {
-            if (isStdout) {
-                // Write to stdout
-                // Write header
-                std::cout << "ngram\tpmi\tfrequency\n";
+        // Check if input is stdin or if file exists
+        bool isStdin = (inputPath == "-");
+        if (!isStdin && !std::filesystem::exists(inputPath)) {
+            throw std::runtime_error("Input file does not exist: " + inputPath);
+        }
 
-                // Write results
-                for (const auto& item : pmiScores) {
-                    std::cout << item.ngram << "\t" << item.score << "\t" << item.frequency << "\n";
-                }
-                std::cout.flush();
-            } else {
-                // Create directory if it doesn't exist
-                std::filesystem::path filePath(outputPath);
+        validatePmiOptions(options);
 
-                try {
-                    // Check if the path exists and is a directory
-                    if (std::filesystem::exists(outputPath) && std::filesystem::is_directory(outputPath)) {
-                        throw std::runtime_error("Cannot write to '" + outputPath + "' because it is a directory");
-                    }
+        if (!isStdin && isSnapshotFile(inputPath)) {
+            if (!options.statsOutputPath.empty()) {
+                throw std::invalid_argument("N-gram statistics are gathered over text; a snapshot holds none");
+            }
+            progress.stop();
+            return scoreSnapshots({inputPath}, {}, outputPath, progressCallback, options);
+        }
 
-                    // Check if the parent path exists or can be created
-                    if (!filePath.parent_path().empty()) {
-                        std::filesystem::create_directories(filePath.parent_path());
-                    }
-                } catch (const std::filesystem::filesystem_error& e) {
-                    // Handle filesystem errors
-                    throw std::runtime_error("Failed to create directory for output file: " +
-                                            std::string(e.what()));
-                }
+        // Map the input, or stream it from stdin or a compressed file
+        size_t fileSize = 0;
+        const bool plainFile = !isStdin && detectFileCompression(inputPath) == Compression::None;
+        if (plainFile) {
+            try {
+                fileSize = std::filesystem::file_size(inputPath);
+            } catch (const std::exception& e) {
+                // Continue without a size for progress reporting
+            }
+        }
 
-                // Open output file
-                std::ofstream outputFile(outputPath, std::ios::binary);
-                if (!outputFile) {
-                    // Provide more detailed error message based on errno
-                    std::string errorMsg;
-                    if (errno == EACCES || errno == EPERM) {
-                        errorMsg = "Permission denied: Cannot write to " + outputPath;
-                    } else if (errno == ENOENT) {
-                        errorMsg = "Directory does not exist: " + outputPath;
-                    } else if (errno == EISDIR) {
-                        errorMsg = "Cannot write to '" + outputPath + "' because it is a directory";
-                    } else {
-                        errorMsg = "Failed to open output file: " + outputPath;
-                    }
-                    throw std::runtime_error(errorMsg);
-                }
+        // Statistics read the text a second time, which a stream cannot give
+        if (!options.statsOutputPath.empty() && !plainFile) {
+            throw std::invalid_argument("N-gram statistics need an uncompressed input file");
+        }
 
-                // Write header
-                outputFile << "ngram\tpmi\tfrequency\n";
+        // Workers are sized for the input; later stages see the tuned thread count
+        const TuningChoice tuning = tuneCounting(options, fileSize);
+        const unsigned int numThreads = tuning.threads;
+        PmiOptions tuned = options;
+        tuned.threads = numThreads;
 
-                // Write results
-                for (const auto& item : pmiScores) {
-                    outputFile << item.ngram << "\t" << item.score << "\t" << item.frequency << "\n";
-                }
-            }
+        // Log configuration if verbose mode is enabled
+        if (options.verbose) {
+            std::cerr << "PMI calculation started with:" << std::endl
+                      << "  n-gram size: " << options.n << std::endl
+                      << "  topK: " << options.topK << std::endl
+                      << "  minFreq: " << options.minFreq << std::endl
+                      << "  threads: " << numThreads << " (" << tuning.variant << ", " << tuning.reason << ")"
+                      << std::endl;
         }
 
-        // Final progress update
-        info.phase = ProgressInfo::Phase::Complete;
-        info.phaseRatio = 1.0;
-        info.overallRatio = 1.0;
-        progressCallback(info);
+        if (!options.checkpointPath.empty()) {
+            return withTuning(calculatePmiCheckpointed(inputPath, outputPath, progressCallback, progress, tuned,
+                                                       numThreads), tuning);
+        }
 
-        // Calculate elapsed time
-        auto endTime = std::chrono::high_resolution_clock::now();
-        auto elapsedMs = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
+        // Streamed input has no size up front; throughput uses the bytes read instead
+        // Reading is about 30% of the work and counting 50%; counted bytes come from the workers
+        progress.setPhaseTotal(fileSize);
+        size_t totalRead = 0;
+        auto reportRead = [&](size_t bytesRead) {
+            progress.add(bytesRead - totalRead);
+            totalRead = bytesRead;
+        };
+        auto reportReadDone = [&]() {
+            progress.beginPhase(ProgressInfo::Phase::Processing, 0.3, 0.8, fileSize);
+        };
+        auto reportCounted = [&]() {
+            progress.endPhase();
+        };
 
-        // Calculate processing speed
-        double mbProcessed = static_cast<double>(fileSize) / (1024 * 1024);
-        double mbPerSec = mbProcessed / (static_cast<double>(elapsedMs) / 1000.0);
+        if (options.window > 0) {
+            CooccurrenceCounter pairCounts = countInput<CooccurrenceCounter>(
+                inputPath, numThreads, tuned, nullptr, reportRead, reportReadDone, &progress);
+            reportCounted();
+            return withTuning(scoreCounted(std::move(pairCounts), nullptr, outputPath, progressCallback, tuned,
+                                           fileSize > 0 ? fileSize : totalRead, startTime), tuning);
+        }
+        // Only the kept n-grams are looked up, in one more pass over the file (now in the page cache)
+        std::vector<PmiItem> kept;
+        std::vector<PmiItem>* keep = options.statsOutputPath.empty() ? nullptr : &kept;
+        auto writeStats = [&]() {
+            if (keep) {
+                MappedText text(inputPath);
+                writeNgramStats(options.statsOutputPath, text.text(), kept, numThreads);
+            }
+        };
 
-        // Log results if verbose mode is enabled
-        if (options.verbose) {
-            std::cerr << "PMI calculation completed:" << std::endl
-                      << "  Total n-grams: " << ngramCounts.size() << std::endl
-                      << "  Elapsed time: " << elapsedMs << " ms" << std::endl
-                      << "  Processing speed: " << mbPerSec << " MB/s" << std::endl;
-        }
-
-        // Return results
-        PmiResult result;
-        result.grams = ngramCounts.size();
-        result.distinctNgrams = pmiScores.size();
-        result.elapsedMs = elapsedMs;
-        result.mbPerSec = mbPerSec;
-        return result;
+        if (options.approximate) {
+            ApproximateNgramCounter ngramCounts = countInput<ApproximateNgramCounter>(
+                inputPath, numThreads, tuned, nullptr, reportRead, reportReadDone, &progress);
+            reportCounted();
+            PmiResult result = scoreCounted(std::move(ngramCounts), nullptr, outputPath, progressCallback, tuned,
+                                            fileSize > 0 ? fileSize : totalRead, startTime, keep);
+            writeStats();
+            return withTuning(result, tuning);
+        }
+        std::unique_ptr<CountBudget> budget = makeBudget(tuned, std::max(1u, numThreads));
+        MultiOrderNgramCounter ngramCounts = countInput<MultiOrderNgramCounter>(
+            inputPath, numThreads, tuned, budget.get(), reportRead, reportReadDone, &progress);
+        reportCounted();
+        PmiResult result = scoreCounted(std::move(ngramCounts), budget.get(), outputPath, progressCallback, tuned,
+                                        fileSize > 0 ? fileSize : totalRead, startTime, keep);
+        writeStats();
+        return withTuning(result, tuning);
     } catch (const std::exception& e) {
         std::cerr << "Exception in calculatePmi(): " << e.what() << std::endl;
 
@@ -393,6 +1512,119 @@ PmiResult calculatePmiWithStructuredProgress(
     }
 }
 
+} // namespace
+
+PmiResult calculatePmiWithStructuredProgress(
+    const std::string& inputPath,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    return measureMemory<PmiResult>(progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+        return calculatePmiInput(inputPath, outputPath, tracked, options);
+    });
+}
+
+PmiResult calculatePmiFromText(
+    std::string_view text,
+    std::vector<PmiItem>& items,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    validatePmiOptions(options);
+    if (options.allOrders || !options.snapshotPath.empty() || !options.checkpointPath.empty() ||
+        (options.memoryBudget > 0 && options.budgetStrategy == MemoryBudgetStrategy::Spill)) {
+        throw std::invalid_argument("All orders, snapshots, checkpoints and spilling cannot be used with PMI over an "
+                                    "in-memory text");
+    }
+
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const TuningChoice tuning = tuneCounting(options, text.size());
+    const unsigned int numThreads = tuning.threads;
+    MemoryMonitor monitor;
+    std::function<void(const ProgressInfo&)> progress = monitor.track(progressCallback);
+
+    // The text is already read; counting is the first phase
+    ProgressReporter counting(progress, options.progressStep);
+    counting.beginPhase(ProgressInfo::Phase::Processing, 0.3, 0.8, text.size());
+
+    PmiResult result;
+    if (options.window > 0) {
+        CooccurrenceCounter counts = countText<CooccurrenceCounter>(text, numThreads, options, nullptr, &counting);
+        counting.endPhase();
+        items = calculateCooccurrenceScores(counts, options.minFreq, options.topK);
+        result.grams = counts.size();
+    } else if (options.approximate) {
+        ApproximateNgramCounter counts = countText<ApproximateNgramCounter>(text, numThreads, options, nullptr,
+                                                                            &counting);
+        counting.endPhase();
+        items = calculatePmiScores(counts, options.minFreq, options.topK);
+        result.grams = counts.n() == 1 ? counts.unigrams().size() : counts.heavyHitters().size();
+        result.countErrorBound = counts.errorBound();
+        result.errorProbability = counts.errorProbability();
+    } else {
+        std::unique_ptr<CountBudget> budget = makeBudget(options, std::max(1u, numThreads), false);
+        MultiOrderNgramCounter counts = countText<MultiOrderNgramCounter>(
+            text, numThreads, options, budget.get(), &counting);
+        counting.endPhase();
+        const PartitionedNgramCounter& order = counts.order(counts.maxOrder());
+        items = calculatePmiScores(order, options.minFreq, options.topK);
+        result.grams = order.size();
+        if (budget && budget->used() == MemoryBudgetStrategy::Prune) {
+            result.budgetStrategy = MemoryBudgetStrategy::Prune;
+            result.countErrorBound = budget->errorBound();
+        }
+    }
+    result.distinctNgrams = items.size();
+
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Calculating;
+    info.phaseRatio = 1.0;
+    info.overallRatio = 0.9;
+    progress(info);
+
+    if (!options.binaryOutputPath.empty()) {
+        writePmiResults(options.binaryOutputPath, options.n, items);
+    }
+    if (!options.statsOutputPath.empty()) {
+        writeNgramStats(options.statsOutputPath, text, items, numThreads);
+    }
+    result = withTuning(finishRun(result, progress, options, text.size(), startTime), tuning);
+    result.memory = monitor.finish(result.metrics);
+    return result;
+}
+
+PmiResult calculatePmiFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    if (inputPaths.empty()) {
+        throw std::invalid_argument("No input files given");
+    }
+
+    // A lone path keeps the single-input behavior, including stdin
+    if (inputPaths.size() == 1) {
+        return core::calculatePmi(inputPaths.front(), outputPath, options);
+    }
+
+    parallel::TraceScope span("pmi", "operation");
+    validatePmiOptions(options);
+
+    std::function<void(const ProgressInfo&)> progressCallback = options.structuredProgressCallback;
+    if (!progressCallback) {
+        progressCallback = [&options](const ProgressInfo& info) {
+            if (options.progressCallback) {
+                options.progressCallback(info.overallRatio);
+            }
+        };
+    }
+
+    return measureMemory<PmiResult>(progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+        return calculatePmiFileSet(expandInputPaths(inputPaths), outputPath, tracked, options);
+    });
+}
+
 PmiResult calculatePmiWithProgress(
     const std::string& inputPath,
     const std::string& outputPath,
@@ -446,31 +1678,20 @@ std::unordered_map<std::string, uint32_t> countNgrams(
     const std::string& text,
     uint32_t n
 ) {
-    std::unordered_map<std::string, uint32_t> counts;
-    
-    // Use cache for frequently processed n-grams
-    static thread_local NGramCache cache(5000, 15); // 5K entries, 15min TTL
-
-    // Split text into lines
-    std::istringstream iss(text);
-    std::string line;
-
-    while (std::getline(iss, line)) {
-        // Skip empty lines
-        if (line.empty()) {
-            continue;
-        }
-
-        // Generate n-grams for this line
-        std::vector<std::string> ngrams = generateNgrams(line, n);
-
-        // Count n-grams
-        for (const auto& ngram : ngrams) {
-            counts[ngram]++;
-        }
+    if (n >= 1 && n <= PackedNgramCounter::kMaxN) {
+        PackedNgramCounter packed(n, estimateDistinctNgrams(text.size(), n));
+        packed.addText(text);
+        return packed.toStringCounts();
     }
 
-    return counts;
+    CountingMap<std::string> counts(estimateDistinctNgrams(text.size(), n));
+    
+    // Count windows of every line in place; only new keys allocate
+    forEachLine(text, [&](std::string_view line) {
+        forEachNgram(line, n, [&](std::string_view ngram) { counts.add(ngram); });
+    });
+
+    return counts.toUnorderedMap();
 }
 
 std::vector<PmiItem> calculatePmiScores(
@@ -506,55 +1727,48 @@ std::vector<PmiItem> calculatePmiScores(
         return results;
     }
 
-    // Count individual characters/components
-    std::unordered_map<std::string, uint32_t> componentCounts;
-
-    for (const auto& [ngram, count] : ngramCounts) {
+    // Resolve the components of every frequent n-gram to dense IDs once,
+    // summing their counts as marginals; ID 0 is unused
+    CountingMap<std::string, uint32_t> componentIds;
+    std::vector<uint64_t> componentCounts(1, 0);
+    std::vector<const std::pair<const std::string, uint32_t>*> frequent;
+    std::vector<uint32_t> ids;
+    std::vector<size_t> offsets(1, 0);
+    for (const auto& entry : ngramCounts) {
         // Skip n-grams below minimum frequency
-        if (count < minFreq) {
+        if (entry.second < minFreq) {
             continue;
         }
 
-        // Generate component n-grams
-        std::vector<std::string> components = generateNgrams(ngram, 1);
-
-        // Count components
-        for (const auto& component : components) {
-            componentCounts[component] += count;
-        }
+        forEachNgram(entry.first, 1, [&](std::string_view component) {
+            uint32_t id = componentIds.get(component);
+            if (id == 0) {
+                id = static_cast<uint32_t>(componentCounts.size());
+                componentIds.add(component, id);
+                componentCounts.push_back(0);
+            }
+            componentCounts[id] += entry.second;
+            ids.push_back(id);
+        });
+        frequent.push_back(&entry);
+        offsets.push_back(ids.size());
     }
 
-    // Calculate PMI scores
-    for (const auto& [ngram, count] : ngramCounts) {
-        // Skip n-grams below minimum frequency
-        if (count < minFreq) {
-            continue;
-        }
-
-        // Generate component n-grams
-        std::vector<std::string> components = generateNgrams(ngram, 1);
-
-        // Skip if components are missing
-        bool skipNgram = false;
-        for (const auto& component : components) {
-            if (componentCounts.find(component) == componentCounts.end()) {
-                skipNgram = true;
-                break;
-            }
-        }
+    // Marginal probabilities P(x) in a flat array indexed by ID
+    std::vector<double> probabilities(componentCounts.size(), 0.0);
+    for (size_t id = 1; id < componentCounts.size(); ++id) {
+        probabilities[id] = static_cast<double>(componentCounts[id]) / totalCount;
+    }
 
-        if (skipNgram) {
-            continue;
-        }
+    // Calculate PMI scores from the IDs alone
+    for (size_t i = 0; i < frequent.size(); ++i) {
+        uint32_t count = frequent[i]->second;
 
-        // Calculate joint probability P(x,y)
+        // Calculate joint probability P(x,y) and the product of the marginals
         double jointProb = static_cast<double>(count) / totalCount;
-
-        // Calculate marginal probabilities P(x) and P(y)
         double marginalProbProduct = 1.0;
-        for (const auto& component : components) {
-            double marginalProb = static_cast<double>(componentCounts[component]) / totalCount;
-            marginalProbProduct *= marginalProb;
+        for (size_t k = offsets[i]; k < offsets[i + 1]; ++k) {
+            marginalProbProduct *= probabilities[ids[k]];
         }
 
         // Calculate PMI = log(P(x,y) / (P(x) * P(y)))
@@ -562,20 +1776,381 @@ std::vector<PmiItem> calculatePmiScores(
         if (marginalProbProduct <= 0.0 || jointProb <= 0.0) {
             continue; // Skip invalid PMI calculations
         }
-        
+
         double pmi = std::log2(jointProb / marginalProbProduct);
-        
+
         // Check for invalid results (NaN, Inf)
         if (!std::isfinite(pmi)) {
             continue; // Skip invalid PMI values
         }
 
         // Add to results
-        results.push_back({ngram, pmi, count});
+        results.push_back({frequent[i]->first, pmi, count});
+    }
+
+    return results;
+}
+
+namespace {
+
+// Tables smaller than this are scored on the calling thread
+constexpr size_t kParallelScoringEntries = 1 << 16;
+
+size_t pieceCount(const PackedNgramCounter&) { return 1; }
+const PackedNgramCounter& piece(const PackedNgramCounter& counts, size_t) { return counts; }
+size_t pieceCount(const PartitionedNgramCounter& counts) { return counts.partitionCount(); }
+const PackedNgramCounter& piece(const PartitionedNgramCounter& counts, size_t index) {
+    return counts.partition(index);
+}
+
+/**
+ * @brief Score packed n-gram counts and keep the best (see calculatePmiScores())
+ *
+ * Each partition is scored into its own bounded selector, on its own thread
+ * for large tables, and the selectors are merged. Only the best K scored
+ * keys are ever held, and only those are decoded.
+ *
+ * @tparam Counts PackedNgramCounter or PartitionedNgramCounter
+ * @param unigrams Unigram counts used as marginals, or nullptr to derive
+ *        them from the components of the frequent n-grams
+ */
+template <typename Counts>
+std::vector<PmiItem> scorePackedCounts(
+    const Counts& counts,
+    const PartitionedNgramCounter* unigrams,
+    uint32_t minFreq,
+    size_t topK
+) {
+    const uint32_t n = counts.n();
+
+    // Calculate total count of all n-grams with overflow check
+    uint64_t totalCount = 0;
+    counts.forEach([&](uint64_t, uint32_t count) {
+        if (totalCount > UINT64_MAX - count) {
+            throw std::overflow_error("Total count overflow in PMI calculation");
+        }
+        totalCount += count;
+    });
+    if (totalCount == 0) {
+        return {};
+    }
+
+    // Marginal probabilities under dense code point IDs
+    MarginalTable marginals;
+    if (n > 1) {
+        if (unigrams) {
+            // Marginals come straight from the unigram table
+            unigrams->forEach([&](uint64_t key, uint32_t count) {
+                marginals.add(static_cast<uint32_t>(key), count);
+            });
+            marginals.finish(marginals.sum());
+        } else {
+            // Count component code points of the frequent n-grams
+            counts.forEach([&](uint64_t key, uint32_t count) {
+                if (count < minFreq) {
+                    return;
+                }
+                for (uint32_t i = 0; i < n; ++i) {
+                    marginals.add(PackedNgramCounter::codePoint(key, n, i), count);
+                }
+            });
+            marginals.finish(totalCount);
+        }
+    }
+
+    auto scorePiece = [&](const PackedNgramCounter& table, ScoredKeySelector& selector) {
+        dispatchNgramSize(n, [&](auto size) {
+            PmiBlockScorer<decltype(size)::value> scorer(marginals, totalCount, selector);
+            table.forEach([&](uint64_t key, uint32_t count) {
+                if (count >= minFreq) {
+                    scorer.add(key, count);
+                }
+            });
+            scorer.finish();
+        });
+    };
+
+    const size_t pieces = pieceCount(counts);
+    std::vector<ScoredKeySelector> selectors(pieces, ScoredKeySelector(topK));
+    if (pieces > 1 && counts.size() >= kParallelScoringEntries) {
+        parallel::TaskGroup group("score");
+        for (size_t i = 0; i < pieces; ++i) {
+            group.run([&, i]() { scorePiece(piece(counts, i), selectors[i]); });
+        }
+        group.wait();
+    } else {
+        for (size_t i = 0; i < pieces; ++i) {
+            scorePiece(piece(counts, i), selectors[i]);
+        }
+    }
+    for (size_t i = 1; i < pieces; ++i) {
+        selectors[0].merge(std::move(selectors[i]));
+    }
+
+    // Only the kept n-grams are decoded
+    std::vector<ScoredKey> best = selectors[0].take();
+    std::vector<PmiItem> results;
+    results.reserve(best.size());
+    for (const auto& item : best) {
+        results.push_back({PackedNgramCounter::decode(item.key, n), item.score, item.frequency});
+    }
+    return results;
+}
+
+/**
+ * @brief Merge count snapshots and score the summed counts
+ *
+ * Two streaming passes over a k-way merge of the snapshots: the first sums
+ * the totals and component counts (and writes the merged snapshot when
+ * PmiOptions::snapshotPath is set), the second scores every n-gram into a
+ * bounded top-K selector. Memory stays at one entry per snapshot plus the
+ * component table and the kept items. Scores match counting the snapshots'
+ * texts together.
+ *
+ * With marginal snapshots, the snapshots may be any subset of the hash
+ * partitions: the joint total is the summed order total of the marginals
+ * and the marginals are the summed unigram counts, so every partition is
+ * scored against the same global distribution.
+ *
+ * @param snapshotPaths Snapshots to merge (their n is used)
+ * @param marginalPaths Marginal snapshots of every counting run, or empty
+ *        to derive the marginals from the snapshots themselves
+ * @param outputPath Output path ("-" for stdout, "null" for no output)
+ * @param progressCallback Structured progress callback
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ * @throws std::invalid_argument If the options do not apply to snapshots
+ */
+PmiResult scoreSnapshots(
+    const std::vector<std::string>& snapshotPaths,
+    const std::vector<std::string>& marginalPaths,
+    const std::string& outputPath,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options
+) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    if (options.approximate || options.allOrders) {
+        throw std::invalid_argument("Snapshots hold exact counts of one order; approximate and all-orders modes do not apply");
+    }
+
+    std::vector<SnapshotReader> readers;
+    readers.reserve(snapshotPaths.size());
+    size_t totalBytes = 0;
+    for (const auto& path : snapshotPaths) {
+        readers.emplace_back(path);
+        totalBytes += readers.back().fileSize();
+    }
+    const uint32_t n = readers.front().n();
+
+    // Global marginals, summed over the marginal snapshots of every run
+    const bool globalMarginals = !marginalPaths.empty();
+    uint64_t totalCount = 0;
+    uint64_t marginalTotal = 0;
+    MarginalTable marginals;
+    if (globalMarginals) {
+        std::vector<SnapshotReader> marginalReaders;
+        marginalReaders.reserve(marginalPaths.size());
+        for (const auto& path : marginalPaths) {
+            marginalReaders.emplace_back(path);
+            if (marginalReaders.back().n() != 1) {
+                throw std::invalid_argument("Marginal snapshot does not hold unigrams: " + path);
+            }
+            totalCount += marginalReaders.back().orderTotal();
+            marginalTotal += marginalReaders.back().total();
+        }
+        forEachMergedEntry(marginalReaders, [&](uint64_t key, uint64_t count) {
+            marginals.add(static_cast<uint32_t>(key), count);
+        });
+        for (const auto& reader : readers) {
+            if (reader.partitionCount() != readers.front().partitionCount()) {
+                throw std::invalid_argument("Snapshots are split into different partition counts: " + reader.path());
+            }
+        }
     }
 
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Processing;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.3;
+    progressCallback(info);
+
+    // First pass: totals, component counts and the merged snapshot
+    std::unique_ptr<SnapshotWriter> writer;
+    if (!options.snapshotPath.empty()) {
+        writer = std::make_unique<SnapshotWriter>(options.snapshotPath, n);
+    }
+    uint64_t entries = 0;
+    forEachMergedEntry(readers, [&](uint64_t key, uint64_t count) {
+        entries++;
+        if (writer) {
+            writer->add(key, count);
+        }
+        if (globalMarginals) {
+            return;
+        }
+        totalCount += count;
+        if (n > 1 && count >= options.minFreq) {
+            for (uint32_t i = 0; i < n; ++i) {
+                marginals.add(PackedNgramCounter::codePoint(key, n, i), count);
+            }
+        }
+    });
+    if (writer) {
+        writer->finish();
+    }
+    marginals.finish(globalMarginals ? marginalTotal : totalCount);
+
+    info.phaseRatio = 1.0;
+    info.overallRatio = 0.8;
+    progressCallback(info);
+    info.phase = ProgressInfo::Phase::Calculating;
+    info.phaseRatio = 0.0;
+    progressCallback(info);
+
+    // Second pass: score into the top-K selector
+    ScoredKeySelector selector(options.topK);
+    if (totalCount > 0) {
+        dispatchNgramSize(n, [&](auto size) {
+            PmiBlockScorer<decltype(size)::value> scorer(marginals, totalCount, selector);
+            forEachMergedEntry(readers, [&](uint64_t key, uint64_t count) {
+                if (count >= options.minFreq) {
+                    scorer.add(key, count);
+                }
+            });
+            scorer.finish();
+        });
+    }
+
+    std::vector<PmiItem> pmiScores;
+    for (const auto& item : selector.take()) {
+        pmiScores.push_back({PackedNgramCounter::decode(item.key, n), item.score, item.frequency});
+    }
+
+    info.phase = ProgressInfo::Phase::Writing;
+    info.phaseRatio = 0.0;
+    info.overallRatio = 0.9;
+    progressCallback(info);
+    writePmiItems(pmiScores, outputPath, options.binaryOutputPath, n, options);
+
+    PmiResult result;
+    result.grams = entries;
+    result.distinctNgrams = pmiScores.size();
+    return finishRun(result, progressCallback, options, totalBytes, startTime);
+}
+
+} // namespace
+
+std::vector<PmiItem> calculatePmiScores(
+    const PackedNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+) {
+    return scorePackedCounts(counts, nullptr, minFreq, topK);
+}
+
+std::vector<PmiItem> calculatePmiScores(
+    const PartitionedNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+) {
+    return scorePackedCounts(counts, nullptr, minFreq, topK);
+}
+
+std::vector<PmiItem> calculatePmiScores(
+    const PartitionedNgramCounter& counts,
+    const PartitionedNgramCounter& unigrams,
+    uint32_t minFreq,
+    size_t topK
+) {
+    if (unigrams.n() != 1) {
+        throw std::invalid_argument("Marginal counts must be unigrams");
+    }
+    return scorePackedCounts(counts, &unigrams, minFreq, topK);
+}
+
+std::vector<PmiItem> calculatePmiScores(
+    const ApproximateNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+) {
+    const uint32_t n = counts.n();
+    uint64_t totalCount = counts.total();
+    MarginalTable marginals;
+    counts.unigrams().forEach([&](uint64_t key, uint32_t count) {
+        marginals.add(static_cast<uint32_t>(key), count);
+    });
+    if (totalCount == 0 || marginals.sum() == 0) {
+        return {};
+    }
+    marginals.finish(marginals.sum());
+
+    ScoredKeySelector selector(topK);
+    dispatchNgramSize(n, [&](auto size) {
+        PmiBlockScorer<decltype(size)::value> scorer(marginals, totalCount, selector);
+        counts.forEachCandidate([&](uint64_t key, uint32_t count) {
+            if (count >= minFreq) {
+                scorer.add(key, count);
+            }
+        });
+        scorer.finish();
+    });
+
+    std::vector<PmiItem> results;
+    for (const auto& item : selector.take()) {
+        results.push_back({PackedNgramCounter::decode(item.key, n), item.score, item.frequency});
+    }
     return results;
 }
 
+PmiResult calculatePmiFromSnapshots(
+    const std::vector<std::string>& snapshotPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    if (snapshotPaths.empty()) {
+        throw std::invalid_argument("No snapshots given");
+    }
+    validatePmiOptions(options);
+
+    std::function<void(const ProgressInfo&)> progressCallback = options.structuredProgressCallback;
+    if (!progressCallback) {
+        progressCallback = [&options](const ProgressInfo& info) {
+            if (options.progressCallback) {
+                options.progressCallback(info.overallRatio);
+            }
+        };
+    }
+    return measureMemory<PmiResult>(progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+        return scoreSnapshots(snapshotPaths, {}, outputPath, tracked, options);
+    });
+}
+
+PmiResult calculatePmiFromPartitions(
+    const std::vector<std::string>& partitionPaths,
+    const std::vector<std::string>& marginalPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    if (partitionPaths.empty()) {
+        throw std::invalid_argument("No partition snapshots given");
+    }
+    if (marginalPaths.empty()) {
+        throw std::invalid_argument("No marginal snapshots given");
+    }
+    validatePmiOptions(options);
+
+    std::function<void(const ProgressInfo&)> progressCallback = options.structuredProgressCallback;
+    if (!progressCallback) {
+        progressCallback = [&options](const ProgressInfo& info) {
+            if (options.progressCallback) {
+                options.progressCallback(info.overallRatio);
+            }
+        };
+    }
+    return measureMemory<PmiResult>(progressCallback, [&](const std::function<void(const ProgressInfo&)>& tracked) {
+        return scoreSnapshots(partitionPaths, marginalPaths, outputPath, tracked, options);
+    });
+}
+
 } // namespace core
 } // namespace suzume
@@ -7,12 +7,15 @@
 #define SUZUME_CORE_PMI_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <unordered_map>
 #include <cstdint>
 #include "suzume_feedmill.h"
 #include "buffer_api.h"
+#include "packed_ngram.h"
+#include "approximate_counter.h"
 
 namespace suzume {
 namespace core {
@@ -31,6 +34,71 @@ PmiResult calculatePmi(
     const PmiOptions& options = PmiOptions()
 );
 
+/**
+ * @brief Calculate PMI over several input files
+ *
+ * Entries may be files, directories or globs (see expandInputPaths()).
+ * Files are counted concurrently, largest first, into one n-gram table. The
+ * single-path functions accept a directory or glob as well.
+ *
+ * @param inputPaths Input files, directories or globs
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const PmiOptions& options = PmiOptions()
+);
+
+/**
+ * @brief Calculate PMI from merged n-gram count snapshots
+ *
+ * Snapshots written with PmiOptions::snapshotPath are merged with a k-way
+ * streaming merge and scored as if their texts had been counted together.
+ * The n-gram size comes from the snapshots. With PmiOptions::snapshotPath
+ * set, the merged counts are also written as a new snapshot. calculatePmi()
+ * and calculatePmiFiles() take this path on their own when every input is
+ * a snapshot.
+ *
+ * @param snapshotPaths Snapshots with the same n-gram size
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ */
+PmiResult calculatePmiFromSnapshots(
+    const std::vector<std::string>& snapshotPaths,
+    const std::string& outputPath,
+    const PmiOptions& options = PmiOptions()
+);
+
+/**
+ * @brief Calculate PMI for hash partitions counted on several machines
+ *
+ * Each machine counts its shard with PmiOptions::snapshotPartitions set and
+ * writes one snapshot per key partition plus a marginals snapshot. Reducing
+ * partition i merges partition i of every machine and scores it against the
+ * marginals summed over all machines, so the partitions can be reduced on
+ * different machines and their outputs concatenated: the best K of the
+ * concatenation equal a single PMI run over all shards with unigram
+ * marginals (as in PmiOptions::allOrders).
+ *
+ * @param partitionPaths Partition snapshots (any subset of the partitions)
+ * @param marginalPaths Marginal snapshots, one per counting machine
+ * @param outputPath Path to output TSV file
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ * @throws std::invalid_argument If the snapshot lists are empty or do not match
+ * @throws std::runtime_error If a snapshot cannot be read
+ */
+PmiResult calculatePmiFromPartitions(
+    const std::vector<std::string>& partitionPaths,
+    const std::vector<std::string>& marginalPaths,
+    const std::string& outputPath,
+    const PmiOptions& options = PmiOptions()
+);
+
 /**
  * @brief Calculate PMI with progress reporting
  *
@@ -86,9 +154,32 @@ struct PmiItem {
     }
 };
 
+/**
+ * @brief Calculate PMI over a text already in memory and keep the results
+ *
+ * Counts like calculatePmi() does a mapped file, in parallel line-aligned
+ * chunks, and returns the top K items instead of writing them. All orders,
+ * snapshots and spilling to disk are file-based and are rejected.
+ *
+ * @param text Input text
+ * @param items Receives the best PMI items, highest first
+ * @param progressCallback Structured progress callback function
+ * @param options PMI calculation options
+ * @return PmiResult Results of the PMI calculation
+ * @throws std::invalid_argument If the options are invalid or file-based
+ */
+PmiResult calculatePmiFromText(
+    std::string_view text,
+    std::vector<PmiItem>& items,
+    const std::function<void(const ProgressInfo&)>& progressCallback,
+    const PmiOptions& options = PmiOptions()
+);
+
 /**
  * @brief Count n-grams in text
  *
+ * Sizes 1-3 are counted with PackedNgramCounter and decoded afterwards.
+ *
  * @param text Input text
  * @param n N-gram size
  * @return std::unordered_map<std::string, uint32_t> N-gram counts
@@ -112,6 +203,76 @@ std::vector<PmiItem> calculatePmiScores(
     uint32_t minFreq
 );
 
+/**
+ * @brief Calculate PMI scores for packed n-grams and keep the best
+ *
+ * Scores match the string-keyed overload; only the n-grams kept are
+ * decoded to UTF-8.
+ *
+ * @param counts Packed n-gram counts
+ * @param minFreq Minimum frequency threshold
+ * @param topK Maximum number of items returned
+ * @return std::vector<PmiItem> Best PMI scores, highest first
+ */
+std::vector<PmiItem> calculatePmiScores(
+    const PackedNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+);
+
+/**
+ * @brief Calculate PMI scores for partitioned packed n-grams and keep the best
+ *
+ * @param counts Partitioned packed n-gram counts
+ * @param minFreq Minimum frequency threshold
+ * @param topK Maximum number of items returned
+ * @return std::vector<PmiItem> Best PMI scores, highest first
+ */
+std::vector<PmiItem> calculatePmiScores(
+    const PartitionedNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+);
+
+/**
+ * @brief Calculate PMI scores against unigram marginals and keep the best
+ *
+ * P(x) is taken from the unigram table rather than estimated from the
+ * components of the n-grams, which is how all-orders runs reuse the
+ * unigrams they count anyway.
+ *
+ * @param counts Partitioned packed n-gram counts
+ * @param unigrams Unigram counts of the same text
+ * @param minFreq Minimum frequency threshold
+ * @param topK Maximum number of items returned
+ * @return std::vector<PmiItem> Best PMI scores, highest first
+ * @throws std::invalid_argument If unigrams is not a unigram table
+ */
+std::vector<PmiItem> calculatePmiScores(
+    const PartitionedNgramCounter& counts,
+    const PartitionedNgramCounter& unigrams,
+    uint32_t minFreq,
+    size_t topK
+);
+
+/**
+ * @brief Calculate PMI scores for the heavy hitters of approximate counts
+ *
+ * Frequencies are sketch estimates, which may exceed the true counts by
+ * up to ApproximateNgramCounter::errorBound(); marginals are the exact
+ * unigram counts.
+ *
+ * @param counts Approximate n-gram counts
+ * @param minFreq Minimum (estimated) frequency threshold
+ * @param topK Maximum number of items returned
+ * @return std::vector<PmiItem> Best PMI scores, highest first
+ */
+std::vector<PmiItem> calculatePmiScores(
+    const ApproximateNgramCounter& counts,
+    uint32_t minFreq,
+    size_t topK
+);
+
 } // namespace core
 } // namespace suzume
 
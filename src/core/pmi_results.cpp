@@ -0,0 +1,145 @@
+/**
+ * @file pmi_results.cpp
+ * @brief Implementation of binary PMI results
+ */
+
+#include "core/pmi_results.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "core/output_writer.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+constexpr char kPmiResultsMagic[8] = {'S', 'Z', 'P', 'M', 'I', 'R', 'S', '1'};
+constexpr uint32_t kPmiResultsVersion = 1;
+
+void appendUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendUint64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+} // namespace
+
+void writePmiResults(const std::string& path, uint32_t n, const std::vector<PmiItem>& items) {
+    uint64_t poolSize = 0;
+    for (const auto& item : items) {
+        poolSize += item.ngram.size();
+    }
+    if (poolSize > UINT32_MAX) {
+        throw std::runtime_error("PMI results too large for the binary format: " + path);
+    }
+
+    std::string header(kPmiResultsMagic, sizeof(kPmiResultsMagic));
+    appendUint32(header, kPmiResultsVersion);
+    appendUint32(header, n);
+    appendUint64(header, items.size());
+    appendUint64(header, poolSize);
+
+    std::string column;
+    column.reserve(items.size() * 8);
+    for (const auto& item : items) {
+        uint64_t bits;
+        std::memcpy(&bits, &item.score, sizeof(bits));
+        appendUint64(column, bits);
+    }
+    for (const auto& item : items) {
+        appendUint32(column, item.frequency);
+    }
+    uint32_t offset = 0;
+    appendUint32(column, offset);
+    for (const auto& item : items) {
+        offset += static_cast<uint32_t>(item.ngram.size());
+        appendUint32(column, offset);
+    }
+
+    prepareOutputPath(path);
+    OutputWriter output(path);
+    output.write(header);
+    output.write(column);
+    for (const auto& item : items) {
+        output.write(item.ngram);
+    }
+    output.close();
+}
+
+bool isPmiResultsFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kPmiResultsMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kPmiResultsMagic, sizeof(magic)) == 0;
+}
+
+PmiResultsReader::PmiResultsReader(const std::string& path)
+    : n_(0)
+    , items_(0)
+    , frequenciesOffset_(0)
+    , offsetsOffset_(0)
+    , poolOffset_(0)
+{
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("PMI results file does not exist: " + path);
+    }
+    mapping_ = std::make_unique<MemoryMappedProcessor>(path);
+    if (mapping_->isMapped()) {
+        data_ = std::string_view(mapping_->data(), mapping_->getFileSize());
+    } else {
+        mapping_.reset();
+        std::ifstream in(path, std::ios::binary);
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_;
+    }
+
+    if (data_.size() < kPmiResultsHeaderSize ||
+        std::memcmp(data_.data(), kPmiResultsMagic, sizeof(kPmiResultsMagic)) != 0) {
+        throw std::runtime_error("Not binary PMI results: " + path);
+    }
+    if (readUint32(8) != kPmiResultsVersion) {
+        throw std::runtime_error("Unsupported PMI results version in " + path);
+    }
+    n_ = readUint32(12);
+    uint64_t items = readUint64(16);
+    uint64_t poolSize = readUint64(24);
+
+    // Columns are fixed-width, so the size of the file follows from the header
+    uint64_t columns = items * (8 + 4 + 4) + 4;
+    if (items > data_.size() || kPmiResultsHeaderSize + columns + poolSize != data_.size()) {
+        throw std::runtime_error("Corrupt PMI results file: " + path);
+    }
+    items_ = static_cast<size_t>(items);
+    frequenciesOffset_ = kPmiResultsHeaderSize + items_ * 8;
+    offsetsOffset_ = frequenciesOffset_ + items_ * 4;
+    poolOffset_ = offsetsOffset_ + (items_ + 1) * 4;
+    if (readUint32(offsetsOffset_ + items_ * 4) != poolSize) {
+        throw std::runtime_error("Corrupt PMI results file: " + path);
+    }
+}
+
+double PmiResultsReader::score(size_t index) const {
+    uint64_t bits = readUint64(kPmiResultsHeaderSize + index * 8);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+uint64_t PmiResultsReader::readUint64(size_t offset) const {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(data_[offset + i]);
+    }
+    return value;
+}
+
+} // namespace core
+} // namespace suzume
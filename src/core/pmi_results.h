@@ -0,0 +1,123 @@
+/**
+ * @file pmi_results.h
+ * @brief Binary PMI results that can be mapped and read without parsing
+ */
+
+#ifndef SUZUME_CORE_PMI_RESULTS_H_
+#define SUZUME_CORE_PMI_RESULTS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/pmi.h"
+#include "core/streaming_processor.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * Results layout (all integers little-endian, scores IEEE 754 doubles
+ * stored as their little-endian bit patterns):
+ *
+ *   header   "SZPMIRS1", uint32 version, uint32 n, uint64 items, uint64 pool bytes
+ *   scores   double per item, in output order (highest first)
+ *   freqs    uint32 per item
+ *   offsets  uint32 per item plus one: start of each n-gram in the pool
+ *   pool     UTF-8 n-grams back to back, without separators
+ *
+ * Every column has a fixed width, so item i is read with three loads and
+ * a slice of the pool; nothing is tokenized or converted from text.
+ */
+constexpr size_t kPmiResultsHeaderSize = 32;
+
+/**
+ * @brief Write PMI results in the binary format
+ *
+ * @param path Output file path
+ * @param n N-gram size of the items
+ * @param items Scored n-grams, in output order
+ * @throws std::runtime_error If the file cannot be written or the pool exceeds 4 GiB
+ */
+void writePmiResults(const std::string& path, uint32_t n, const std::vector<PmiItem>& items);
+
+/**
+ * @brief Check whether a file starts with the binary results magic
+ * @param path File path
+ * @return bool True for binary PMI results
+ */
+bool isPmiResultsFile(const std::string& path);
+
+/**
+ * @brief Reads binary PMI results in place from a memory mapping
+ */
+class PmiResultsReader {
+public:
+    /**
+     * @brief Constructor
+     * @param path Results path
+     * @throws std::runtime_error If the file is missing, truncated or not binary results
+     */
+    explicit PmiResultsReader(const std::string& path);
+
+    /**
+     * @brief Get the number of items
+     * @return size_t Item count
+     */
+    size_t size() const { return items_; }
+
+    /**
+     * @brief Get the n-gram size recorded by the writer
+     * @return uint32_t N-gram size
+     */
+    uint32_t n() const { return n_; }
+
+    /**
+     * @brief Get the n-gram of an item
+     * @param index Item index
+     * @return std::string_view N-gram, valid while the reader lives
+     */
+    std::string_view ngram(size_t index) const {
+        uint32_t begin = readUint32(offsetsOffset_ + index * 4);
+        uint32_t end = readUint32(offsetsOffset_ + (index + 1) * 4);
+        return data_.substr(poolOffset_ + begin, end - begin);
+    }
+
+    /**
+     * @brief Get the PMI score of an item
+     * @param index Item index
+     * @return double Score
+     */
+    double score(size_t index) const;
+
+    /**
+     * @brief Get the frequency of an item
+     * @param index Item index
+     * @return uint32_t Frequency
+     */
+    uint32_t frequency(size_t index) const { return readUint32(frequenciesOffset_ + index * 4); }
+
+private:
+    uint32_t readUint32(size_t offset) const {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data_.data() + offset);
+        return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+               static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    }
+    uint64_t readUint64(size_t offset) const;
+
+    std::unique_ptr<MemoryMappedProcessor> mapping_;
+    std::string buffer_;
+    std::string_view data_;
+    uint32_t n_;
+    size_t items_;
+    size_t frequenciesOffset_;
+    size_t offsetsOffset_;
+    size_t poolOffset_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_PMI_RESULTS_H_
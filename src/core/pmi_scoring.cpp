@@ -0,0 +1,133 @@
+/**
+ * @file pmi_scoring.cpp
+ * @brief Implementation of columnar PMI scoring
+ */
+
+#include "core/pmi_scoring.h"
+#include <algorithm>
+#include <cmath>
+#include "core/packed_ngram.h"
+
+namespace suzume {
+namespace core {
+
+MarginalTable::MarginalTable()
+    : directIds_(kDirectCodePoints, 0)
+    , counts_(1, 0)
+    , probabilities_(1, 0.0)
+    , sum_(0)
+{
+}
+
+void MarginalTable::add(uint32_t codePoint, uint64_t count) {
+    uint32_t index = id(codePoint);
+    if (index == 0) {
+        index = static_cast<uint32_t>(counts_.size());
+        counts_.push_back(0);
+        if (codePoint < kDirectCodePoints) {
+            directIds_[codePoint] = index;
+        } else {
+            otherIds_[codePoint] = index;
+        }
+    }
+    counts_[index] += count;
+    sum_ += count;
+}
+
+void MarginalTable::finish(uint64_t total) {
+    probabilities_.assign(counts_.size(), 0.0);
+    if (total == 0) {
+        return;
+    }
+    for (size_t i = 1; i < counts_.size(); ++i) {
+        probabilities_[i] = static_cast<double>(counts_[i]) / total;
+    }
+}
+
+template <uint32_t N>
+PmiBlockScorer<N>::PmiBlockScorer(
+    const MarginalTable& marginals,
+    uint64_t jointTotal,
+    ScoredKeySelector& selector
+)
+    : marginals_(marginals)
+    , jointTotal_(static_cast<double>(jointTotal))
+    , selector_(selector)
+{
+    if constexpr (N > 1) {
+        keys_.reserve(kBlockSize);
+        counts_.reserve(kBlockSize);
+        ids_.assign(kBlockSize * N, 0);
+        joint_.resize(kBlockSize);
+        product_.resize(kBlockSize);
+        scores_.resize(kBlockSize);
+    }
+}
+
+template <uint32_t N>
+void PmiBlockScorer<N>::add(uint64_t key, uint64_t count) {
+    if constexpr (N == 1) {
+        // For unigrams, just return frequency
+        uint32_t frequency = static_cast<uint32_t>(std::min<uint64_t>(count, UINT32_MAX));
+        selector_.push({key, static_cast<double>(count), frequency});
+    } else {
+        // Component IDs are resolved once, here
+        const size_t row = keys_.size();
+        for (uint32_t i = 0; i < N; ++i) {
+            ids_[i * kBlockSize + row] = marginals_.id(PackedNgramCounter::codePoint(key, N, i));
+        }
+        keys_.push_back(key);
+        counts_.push_back(count);
+        if (keys_.size() == kBlockSize) {
+            scoreBlock();
+        }
+    }
+}
+
+template <uint32_t N>
+void PmiBlockScorer<N>::finish() {
+    if (!keys_.empty()) {
+        scoreBlock();
+    }
+}
+
+template <uint32_t N>
+void PmiBlockScorer<N>::scoreBlock() {
+    const size_t size = keys_.size();
+    const double* probabilities = marginals_.probabilities();
+    const uint64_t* counts = counts_.data();
+    const uint32_t* ids = ids_.data();
+    double* joint = joint_.data();
+    double* product = product_.data();
+    double* scores = scores_.data();
+
+    // PMI = log(P(x,y) / (P(x) * P(y))); the product over the N columns is unrolled
+    for (size_t j = 0; j < size; ++j) {
+        joint[j] = static_cast<double>(counts[j]) / jointTotal_;
+        double marginalProduct = 1.0;
+        for (uint32_t i = 0; i < N; ++i) {
+            marginalProduct *= probabilities[ids[i * kBlockSize + j]];
+        }
+        product[j] = marginalProduct;
+    }
+    for (size_t j = 0; j < size; ++j) {
+        scores[j] = std::log2(joint[j] / product[j]);
+    }
+
+    // Absent components give a zero product; those and non-finite scores are skipped
+    for (size_t j = 0; j < size; ++j) {
+        if (product[j] > 0.0 && joint[j] > 0.0 && std::isfinite(scores[j])) {
+            uint32_t frequency = static_cast<uint32_t>(std::min<uint64_t>(counts[j], UINT32_MAX));
+            selector_.push({keys_[j], scores[j], frequency});
+        }
+    }
+    keys_.clear();
+    counts_.clear();
+}
+
+template class PmiBlockScorer<1>;
+template class PmiBlockScorer<2>;
+template class PmiBlockScorer<3>;
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,180 @@
+/**
+ * @file pmi_scoring.h
+ * @brief Columnar PMI scoring of packed n-grams against a dense marginal table
+ */
+
+#ifndef SUZUME_CORE_PMI_SCORING_H_
+#define SUZUME_CORE_PMI_SCORING_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "core/top_k.h"
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/// Packed n-gram with its score, before decoding
+struct ScoredKey {
+    uint64_t key;
+    double score;
+    uint32_t frequency;
+};
+
+/// Highest score first; ties go to the more frequent n-gram, then the lower key
+struct BetterScoredKey {
+    bool operator()(const ScoredKey& a, const ScoredKey& b) const {
+        if (a.score != b.score) {
+            return a.score > b.score;
+        }
+        if (a.frequency != b.frequency) {
+            return a.frequency > b.frequency;
+        }
+        return a.key < b.key;
+    }
+};
+
+using ScoredKeySelector = TopKSelector<ScoredKey, BetterScoredKey>;
+
+/**
+ * @brief Marginal counts of code points under dense integer IDs
+ *
+ * Every code point added gets an ID from 1 up; ID 0 stands for code points
+ * never added and has probability 0. After finish(), the marginal
+ * probabilities sit in one flat array indexed by ID, so scoring reads them
+ * with a plain load instead of a hash lookup. BMP code points resolve to
+ * their ID through a direct table; the rest go through a hash map.
+ */
+class MarginalTable {
+public:
+    MarginalTable();
+
+    /**
+     * @brief Add to the count of a code point
+     * @param codePoint Unicode code point
+     * @param count Occurrences to add
+     */
+    void add(uint32_t codePoint, uint64_t count);
+
+    /**
+     * @brief Compute the marginal probabilities
+     * @param total Denominator of the probabilities (usually the sum of all counts)
+     */
+    void finish(uint64_t total);
+
+    /**
+     * @brief Get the dense ID of a code point
+     * @param codePoint Unicode code point
+     * @return uint32_t ID (0 if the code point was never added)
+     */
+    uint32_t id(uint32_t codePoint) const {
+        if (codePoint < kDirectCodePoints) {
+            return directIds_[codePoint];
+        }
+        auto it = otherIds_.find(codePoint);
+        return it == otherIds_.end() ? 0 : it->second;
+    }
+
+    /**
+     * @brief Get the marginal probabilities indexed by ID (valid after finish())
+     * @return const double* counts[id] / total, with 0.0 at ID 0
+     */
+    const double* probabilities() const { return probabilities_.data(); }
+
+    /**
+     * @brief Get the count of a code point
+     * @param codePoint Unicode code point
+     * @return uint64_t Count (0 if never added)
+     */
+    uint64_t count(uint32_t codePoint) const { return counts_[id(codePoint)]; }
+
+    /**
+     * @brief Get the sum of all counts added
+     * @return uint64_t Total count
+     */
+    uint64_t sum() const { return sum_; }
+
+    /**
+     * @brief Get the number of distinct code points
+     * @return size_t Code point count
+     */
+    size_t size() const { return counts_.size() - 1; }
+
+private:
+    static constexpr uint32_t kDirectCodePoints = 0x10000;
+
+    std::vector<uint32_t> directIds_;
+    robin_hood::unordered_flat_map<uint32_t, uint32_t> otherIds_;
+    std::vector<uint64_t> counts_;
+    std::vector<double> probabilities_;
+    uint64_t sum_;
+};
+
+/**
+ * @brief Scores packed n-grams in blocks of columnar arrays
+ *
+ * add() resolves the component IDs of an n-gram once and appends its key,
+ * joint count and IDs to flat columns. Each full block is then scored in
+ * passes that touch only those columns and the marginal probabilities:
+ * joint probabilities, marginal products, then log2(joint / product). The
+ * passes have no hashing, strings or calls other than log2, which leaves
+ * them to the compiler's vectorizer. Finite scores go to the selector.
+ *
+ * The arithmetic is the same as scoring one n-gram at a time, so results
+ * do not depend on the block size. The n-gram size is a template
+ * parameter, so the component lookups and the marginal product are
+ * unrolled; it is instantiated for 1, 2 and 3 (see dispatchNgramSize()).
+ *
+ * @tparam N N-gram size (1-3); unigrams are scored by frequency
+ */
+template <uint32_t N>
+class PmiBlockScorer {
+public:
+    /// N-grams scored per block
+    static constexpr size_t kBlockSize = 1024;
+
+    /**
+     * @brief Constructor
+     * @param marginals Finished marginal table
+     * @param jointTotal Denominator of the joint probabilities
+     * @param selector Receives the scored keys
+     */
+    PmiBlockScorer(const MarginalTable& marginals, uint64_t jointTotal, ScoredKeySelector& selector);
+
+    /**
+     * @brief Queue an n-gram for scoring
+     * @param key Packed n-gram
+     * @param count Joint count
+     */
+    void add(uint64_t key, uint64_t count);
+
+    /**
+     * @brief Score the n-grams still queued
+     */
+    void finish();
+
+private:
+    void scoreBlock();
+
+    const MarginalTable& marginals_;
+    double jointTotal_;
+    ScoredKeySelector& selector_;
+
+    // One column per field; ids_ holds kBlockSize IDs per component
+    std::vector<uint64_t> keys_;
+    std::vector<uint64_t> counts_;
+    std::vector<uint32_t> ids_;
+    std::vector<double> joint_;
+    std::vector<double> product_;
+    std::vector<double> scores_;
+};
+
+extern template class PmiBlockScorer<1>;
+extern template class PmiBlockScorer<2>;
+extern template class PmiBlockScorer<3>;
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_PMI_SCORING_H_
@@ -8,6 +8,9 @@
 
 #include <atomic>
 #include <cstdint>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
 
 namespace suzume {
 namespace core {
@@ -53,7 +56,33 @@ public:
     }
   }
 
+  /**
+   * @brief Copy values to a uint32_t[3] buffer read by other threads
+   *
+   * Each word is stored atomically, so a reader on another thread (or a
+   * JavaScript Atomics.load() on a SharedArrayBuffer) never sees a torn
+   * value. The phase is stored last; a reader that loads it first may
+   * still see the next phase's counts along with it.
+   *
+   * @param buffer Shared uint32_t[3] buffer (phase, current, total)
+   */
+  void copyToSharedBuffer(uint32_t* buffer) const {
+    if (buffer) {
+      storeShared(buffer + 1, current_.load(std::memory_order_acquire));
+      storeShared(buffer + 2, total_.load(std::memory_order_acquire));
+      storeShared(buffer, phase_.load(std::memory_order_acquire));
+    }
+  }
+
 private:
+  static void storeShared(uint32_t* word, uint32_t value) {
+#if defined(_MSC_VER)
+    _InterlockedExchange(reinterpret_cast<volatile long*>(word), static_cast<long>(value));
+#else
+    __atomic_store_n(word, value, __ATOMIC_RELEASE);
+#endif
+  }
+
   std::atomic<uint32_t> phase_{0};
   std::atomic<uint32_t> current_{0};
   std::atomic<uint32_t> total_{0};
@@ -0,0 +1,215 @@
+/**
+ * @file progress_reporter.cpp
+ * @brief Implementation of the progress reporter
+ */
+
+#include "core/progress_reporter.h"
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Ids tell reporters apart in the thread-local counter cache, even at a reused address
+std::atomic<uint64_t> nextReporterId{1};
+
+double secondsSince(std::chrono::steady_clock::time_point begin, std::chrono::steady_clock::time_point now) {
+    return std::chrono::duration<double>(now - begin).count();
+}
+
+} // namespace
+
+ProgressReporter::ProgressReporter(std::function<void(const ProgressInfo&)> callback, double progressStep,
+                                   std::chrono::milliseconds interval)
+    : callback_(std::move(callback))
+    , progressStep_(progressStep)
+    , interval_(interval)
+    , id_(nextReporterId.fetch_add(1))
+    , stopping_(false)
+    , sampling_(false)
+    , phase_(ProgressInfo::Phase::Reading)
+    , overallBegin_(0.0)
+    , overallEnd_(0.0)
+    , phaseUnits_(0)
+    , phaseBytes_(0)
+    , baseUnits_(0)
+    , reportedUnits_(0)
+    , reportedRatio_(0.0)
+    , start_(std::chrono::steady_clock::now())
+    , phaseStart_(start_)
+{
+    if (callback_) {
+        reporter_ = std::thread([this]() { run(); });
+    }
+}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_one();
+    if (reporter_.joinable()) {
+        reporter_.join();
+    }
+}
+
+void ProgressReporter::beginPhase(ProgressInfo::Phase phase, double overallBegin, double overallEnd,
+                                  uint64_t totalUnits, uint64_t totalBytes) {
+    if (!callback_) {
+        return;
+    }
+    uint64_t base = this->totalUnits();
+    std::lock_guard<std::mutex> lock(mutex_);
+    rethrowLocked();
+    phase_ = phase;
+    overallBegin_ = overallBegin;
+    overallEnd_ = overallEnd;
+    phaseUnits_ = totalUnits;
+    phaseBytes_ = totalBytes;
+    baseUnits_ = base;
+    reportedUnits_ = 0;
+    phaseStart_ = std::chrono::steady_clock::now();
+    sampling_ = true;
+    reportLocked(0, true);
+}
+
+void ProgressReporter::setPhaseTotal(uint64_t totalUnits, uint64_t totalBytes) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    phaseUnits_ = totalUnits;
+    phaseBytes_ = totalBytes;
+}
+
+void ProgressReporter::endPhase() {
+    if (!callback_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    rethrowLocked();
+    sampling_ = false;
+    if (phaseUnits_ == 0) {
+        // An unknown total is done once the phase is
+        phaseUnits_ = std::max<uint64_t>(1, totalUnits() - baseUnits_);
+    }
+    reportLocked(phaseUnits_, true);
+}
+
+void ProgressReporter::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    sampling_ = false;
+}
+
+void ProgressReporter::complete() {
+    if (!callback_) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    rethrowLocked();
+    sampling_ = false;
+    ProgressInfo info;
+    info.phase = ProgressInfo::Phase::Complete;
+    info.phaseRatio = 1.0;
+    info.overallRatio = 1.0;
+    reportedRatio_ = 1.0;
+    callback_(info);
+}
+
+std::atomic<uint64_t>& ProgressReporter::threadCounter() {
+    // Counter of the reporter this thread added to last
+    thread_local uint64_t cachedId = 0;
+    thread_local std::atomic<uint64_t>* cached = nullptr;
+    if (cachedId == id_) {
+        return *cached;
+    }
+
+    std::lock_guard<std::mutex> lock(countersMutex_);
+    std::thread::id self = std::this_thread::get_id();
+    auto found = std::find_if(counters_.begin(), counters_.end(),
+                              [self](const Counter& counter) { return counter.thread == self; });
+    if (found == counters_.end()) {
+        counters_.emplace_back();
+        counters_.back().thread = self;
+        found = std::prev(counters_.end());
+    }
+    cachedId = id_;
+    cached = &found->units;
+    return *cached;
+}
+
+uint64_t ProgressReporter::totalUnits() {
+    std::lock_guard<std::mutex> lock(countersMutex_);
+    uint64_t total = 0;
+    for (const Counter& counter : counters_) {
+        total += counter.units.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+void ProgressReporter::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stopping_) {
+        wake_.wait_for(lock, interval_);
+        if (stopping_ || !sampling_ || error_) {
+            continue;
+        }
+        try {
+            reportLocked(totalUnits() - baseUnits_, false);
+        } catch (...) {
+            // Thrown again on the operation's thread at its next phase change
+            error_ = std::current_exception();
+            sampling_ = false;
+        }
+    }
+}
+
+void ProgressReporter::rethrowLocked() {
+    if (error_) {
+        std::exception_ptr error = error_;
+        error_ = nullptr;
+        sampling_ = false;
+        std::rethrow_exception(error);
+    }
+}
+
+void ProgressReporter::reportLocked(uint64_t units, bool force) {
+    ProgressInfo info;
+    info.phase = phase_;
+    if (phaseUnits_ > 0) {
+        info.phaseRatio = std::min(1.0, static_cast<double>(units) / static_cast<double>(phaseUnits_));
+    }
+    info.overallRatio = std::max(reportedRatio_, overallBegin_ + (overallEnd_ - overallBegin_) * info.phaseRatio);
+    if (phaseBytes_ > 0) {
+        info.totalBytes = phaseBytes_;
+        info.processedBytes = static_cast<uint64_t>(static_cast<double>(phaseBytes_) * info.phaseRatio);
+    } else {
+        info.totalBytes = phaseUnits_;
+        info.processedBytes = units;
+    }
+
+    if (!force) {
+        bool moved = phaseUnits_ > 0 ? info.overallRatio >= reportedRatio_ + progressStep_ : units > reportedUnits_;
+        if (!moved) {
+            return;
+        }
+    }
+
+    // Speed within the phase; the time left extrapolates the whole run so far
+    auto now = std::chrono::steady_clock::now();
+    double phaseSeconds = secondsSince(phaseStart_, now);
+    if (phaseSeconds > 0.0 && info.processedBytes > 0) {
+        info.processingSpeed = static_cast<double>(info.processedBytes) / (1024 * 1024) / phaseSeconds;
+    }
+    if (info.overallRatio > 0.0 && info.overallRatio < 1.0) {
+        info.estimatedTimeLeft = secondsSince(start_, now) * (1.0 - info.overallRatio) / info.overallRatio;
+    }
+
+    reportedRatio_ = info.overallRatio;
+    reportedUnits_ = units;
+    callback_(info);
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,164 @@
+/**
+ * @file progress_reporter.h
+ * @brief Progress aggregation off the hot path, reported from a dedicated thread
+ */
+
+#ifndef SUZUME_CORE_PROGRESS_REPORTER_H_
+#define SUZUME_CORE_PROGRESS_REPORTER_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Collects progress from workers and reports it on a timer
+ *
+ * Workers only add the work they finished to a counter of their own thread,
+ * a relaxed store to a cache line no other thread writes. A reporter thread
+ * sums the counters every interval, builds the ProgressInfo, including the
+ * processing speed and the estimated time left, and calls the callback
+ * when overall progress moved by at least the progress step. Phase changes
+ * are reported at once on the thread that makes them, so the callback sees
+ * phases begin and end where the operation moves on. Calls of the callback
+ * never overlap, and overall progress never goes backwards.
+ *
+ * Without a callback no thread is started and add() is a single branch.
+ */
+class ProgressReporter {
+public:
+    /// Time between samples of the counters
+    static constexpr std::chrono::milliseconds kDefaultInterval{100};
+
+    /**
+     * @brief Constructor
+     * @param callback Callback to report to (may be empty)
+     * @param progressStep Least change of the overall ratio that is reported between phase changes
+     * @param interval Time between samples
+     */
+    explicit ProgressReporter(std::function<void(const ProgressInfo&)> callback, double progressStep = 0.05,
+                              std::chrono::milliseconds interval = kDefaultInterval);
+
+    /**
+     * @brief Destructor; stops the reporter thread without a final report
+     */
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    /**
+     * @brief Check whether progress is reported at all
+     * @return bool True if there is a callback
+     */
+    bool active() const { return static_cast<bool>(callback_); }
+
+    /**
+     * @brief Start a phase and report its start now
+     *
+     * Work added from here on counts towards this phase. With an unknown
+     * total the phase ratio stays 0 and a sample is reported whenever more
+     * work was done. An exception the callback threw on the reporter thread
+     * is rethrown here, and by endPhase() and complete(), on the thread of
+     * the operation.
+     *
+     * @param phase Phase
+     * @param overallBegin Overall ratio at the start of the phase
+     * @param overallEnd Overall ratio at the end of the phase
+     * @param totalUnits Work of the phase in the units add() counts (0 = unknown)
+     * @param totalBytes Input bytes the work covers (0 = the units are bytes)
+     */
+    void beginPhase(ProgressInfo::Phase phase, double overallBegin, double overallEnd,
+                    uint64_t totalUnits = 0, uint64_t totalBytes = 0);
+
+    /**
+     * @brief Set the total of the current phase once it is known
+     * @param totalUnits Work of the phase in the units add() counts (0 = unknown)
+     * @param totalBytes Input bytes the work covers (0 = the units are bytes)
+     */
+    void setPhaseTotal(uint64_t totalUnits, uint64_t totalBytes = 0);
+
+    /**
+     * @brief Add finished work of the current phase; callable from any thread
+     * @param units Units of work
+     */
+    void add(uint64_t units) {
+        if (!callback_) {
+            return;
+        }
+        std::atomic<uint64_t>& counter = threadCounter();
+        counter.store(counter.load(std::memory_order_relaxed) + units, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Report the current phase as done now and stop sampling
+     */
+    void endPhase();
+
+    /**
+     * @brief Stop sampling without a report
+     *
+     * Afterwards the callback is no longer called by the reporter, so the
+     * caller may call it directly, from code that reports for itself.
+     */
+    void stop();
+
+    /**
+     * @brief Report the operation as complete now and stop sampling
+     */
+    void complete();
+
+private:
+    /// Work counter of one thread; padded so no two threads share a cache line
+    struct alignas(64) Counter {
+        std::atomic<uint64_t> units{0};
+        std::thread::id thread;
+    };
+
+    std::atomic<uint64_t>& threadCounter();
+    uint64_t totalUnits();
+    void run();
+    // Rethrow what the callback threw on the reporter thread; called with mutex_ held
+    void rethrowLocked();
+    // Build the info of the current phase and report it; called with mutex_ held
+    void reportLocked(uint64_t units, bool force);
+
+    std::function<void(const ProgressInfo&)> callback_;
+    double progressStep_;
+    std::chrono::milliseconds interval_;
+    uint64_t id_;
+
+    std::mutex countersMutex_;
+    std::deque<Counter> counters_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    bool stopping_;
+    bool sampling_;
+    std::exception_ptr error_;
+    ProgressInfo::Phase phase_;
+    double overallBegin_;
+    double overallEnd_;
+    uint64_t phaseUnits_;
+    uint64_t phaseBytes_;
+    uint64_t baseUnits_;
+    uint64_t reportedUnits_;
+    double reportedRatio_;
+    std::chrono::steady_clock::time_point start_;
+    std::chrono::steady_clock::time_point phaseStart_;
+    std::thread reporter_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_PROGRESS_REPORTER_H_
@@ -0,0 +1,249 @@
+/**
+ * @file sampling.cpp
+ * @brief Implementation of skip-ahead reservoir sampling
+ */
+
+#include "core/sampling.h"
+#include "core/auto_tune.h"
+#include "core/line_scan.h"
+#include "core/streaming_processor.h"
+#include "parallel/thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Smallest chunk worth a thread of its own
+constexpr size_t kMinChunkBytes = 1024 * 1024;
+
+/**
+ * @brief Reservoir of one chunk, with the number of lines it was drawn from
+ */
+struct ChunkReservoir {
+    std::vector<std::pair<const char*, std::string>> lines; ///< Line start and text
+    size_t lineCount = 0;
+};
+
+/**
+ * @brief Draw a uniform double in the open interval (0, 1)
+ */
+double openUnit(std::mt19937_64& gen) {
+    double u;
+    do {
+        u = std::generate_canonical<double, 64>(gen);
+    } while (u <= 0.0 || u >= 1.0);
+    return u;
+}
+
+/**
+ * @brief Advance past the next newline
+ * @return const char* Start of the following line
+ */
+inline const char* skipLine(const char* cursor, const char* end) {
+    const char* newline = findNewline(cursor, end);
+    return newline ? newline + 1 : end;
+}
+
+/**
+ * @brief Sample one chunk with Algorithm L
+ *
+ * @param begin Chunk start (at a line boundary)
+ * @param end Chunk end (at a line boundary)
+ * @param sampleSize Reservoir size
+ * @param seed Chunk seed
+ * @return ChunkReservoir Uniform sample of the chunk's lines
+ */
+ChunkReservoir sampleChunk(const char* begin, const char* end, size_t sampleSize, uint64_t seed) {
+    ChunkReservoir reservoir;
+    std::mt19937_64 gen(seed);
+
+    const char* cursor = begin;
+    while (cursor < end && reservoir.lines.size() < sampleSize) {
+        const char* next = skipLine(cursor, end);
+        size_t length = static_cast<size_t>(next - cursor) - (next[-1] == '\n' ? 1 : 0);
+        reservoir.lines.emplace_back(cursor, std::string(cursor, length));
+        cursor = next;
+    }
+    reservoir.lineCount = reservoir.lines.size();
+
+    if (cursor >= end) {
+        return reservoir;
+    }
+
+    std::uniform_int_distribution<size_t> slot(0, sampleSize - 1);
+    const double invSize = 1.0 / static_cast<double>(sampleSize);
+    double w = std::exp(std::log(openUnit(gen)) * invSize);
+
+    while (true) {
+        // Geometric number of lines passed over before the next replacement
+        double gap = std::floor(std::log(openUnit(gen)) / std::log1p(-w));
+        size_t skip = gap >= static_cast<double>(std::numeric_limits<size_t>::max() / 2)
+            ? std::numeric_limits<size_t>::max() / 2
+            : static_cast<size_t>(gap);
+        while (skip > 0 && cursor < end) {
+            cursor = skipLine(cursor, end);
+            reservoir.lineCount++;
+            skip--;
+        }
+        if (cursor >= end) {
+            break;
+        }
+
+        const char* next = skipLine(cursor, end);
+        size_t length = static_cast<size_t>(next - cursor) - (next[-1] == '\n' ? 1 : 0);
+        auto& entry = reservoir.lines[slot(gen)];
+        entry.first = cursor;
+        entry.second.assign(cursor, length);
+        reservoir.lineCount++;
+        cursor = next;
+
+        w *= std::exp(std::log(openUnit(gen)) * invSize);
+    }
+
+    return reservoir;
+}
+
+/**
+ * @brief Merge chunk reservoirs into one uniform sample
+ *
+ * Each draw picks a chunk with probability proportional to its lines not yet
+ * drawn, then takes a random unused entry from that chunk's reservoir.
+ */
+std::vector<std::pair<const char*, std::string>> mergeReservoirs(
+    std::vector<ChunkReservoir>& reservoirs,
+    size_t sampleSize,
+    std::mt19937_64& gen
+) {
+    size_t total = 0;
+    for (const auto& reservoir : reservoirs) {
+        total += reservoir.lineCount;
+    }
+
+    std::vector<size_t> remaining;
+    std::vector<size_t> taken(reservoirs.size(), 0);
+    remaining.reserve(reservoirs.size());
+    for (const auto& reservoir : reservoirs) {
+        remaining.push_back(reservoir.lineCount);
+    }
+
+    std::vector<std::pair<const char*, std::string>> merged;
+    size_t draws = std::min(sampleSize, total);
+    merged.reserve(draws);
+    for (size_t i = 0; i < draws; ++i) {
+        size_t pick = std::uniform_int_distribution<size_t>(0, total - 1)(gen);
+        size_t chunk = 0;
+        while (pick >= remaining[chunk]) {
+            pick -= remaining[chunk];
+            chunk++;
+        }
+
+        auto& pool = reservoirs[chunk].lines;
+        size_t index = std::uniform_int_distribution<size_t>(taken[chunk], pool.size() - 1)(gen);
+        std::swap(pool[taken[chunk]], pool[index]);
+        merged.push_back(std::move(pool[taken[chunk]]));
+        taken[chunk]++;
+        remaining[chunk]--;
+        total--;
+    }
+    return merged;
+}
+
+} // namespace
+
+std::vector<std::string> sampleLineBuffer(
+    const char* data,
+    size_t size,
+    size_t sampleSize,
+    unsigned int seed,
+    unsigned int numThreads
+) {
+    std::vector<std::string> result;
+    if (sampleSize == 0 || size == 0) {
+        return result;
+    }
+
+    std::mt19937_64 gen;
+    if (seed == 0) {
+        std::random_device rd;
+        gen.seed(rd());
+    } else {
+        gen.seed(seed);
+    }
+
+    numThreads = resolveThreads(numThreads);
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(numThreads, size / kMinChunkBytes));
+
+    // Chunk boundaries are moved forward to the next line start
+    const char* end = data + size;
+    std::vector<const char*> bounds;
+    bounds.push_back(data);
+    for (size_t i = 1; i < chunkCount; ++i) {
+        const char* nominal = data + size / chunkCount * i;
+        bounds.push_back(std::max(bounds.back(), nominal > data ? skipLine(nominal - 1, end) : data));
+    }
+    bounds.push_back(end);
+
+    std::vector<uint64_t> seeds(chunkCount);
+    for (auto& chunkSeed : seeds) {
+        chunkSeed = gen();
+    }
+
+    std::vector<ChunkReservoir> reservoirs(chunkCount);
+    if (chunkCount == 1) {
+        reservoirs[0] = sampleChunk(bounds[0], bounds[1], sampleSize, seeds[0]);
+    } else {
+        parallel::TaskGroup group("sample");
+        for (size_t i = 0; i < chunkCount; ++i) {
+            group.run([&, i]() {
+                reservoirs[i] = sampleChunk(bounds[i], bounds[i + 1], sampleSize, seeds[i]);
+            });
+        }
+        group.wait();
+    }
+
+    std::vector<std::pair<const char*, std::string>> sampled = chunkCount == 1
+        ? std::move(reservoirs[0].lines)
+        : mergeReservoirs(reservoirs, sampleSize, gen);
+
+    std::sort(sampled.begin(), sampled.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    result.reserve(sampled.size());
+    for (auto& entry : sampled) {
+        result.push_back(std::move(entry.second));
+    }
+    return result;
+}
+
+std::vector<std::string> sampleLinesMapped(
+    const std::string& inputPath,
+    size_t sampleSize,
+    unsigned int seed,
+    unsigned int numThreads
+) {
+    if (!std::filesystem::exists(inputPath)) {
+        throw std::runtime_error("File does not exist: " + inputPath);
+    }
+    if (sampleSize == 0 || std::filesystem::file_size(inputPath) == 0) {
+        return {};
+    }
+
+    MemoryMappedProcessor mapped(inputPath);
+    if (!mapped.isMapped()) {
+        throw std::runtime_error("Failed to memory map file: " + inputPath);
+    }
+    return sampleLineBuffer(mapped.data(), mapped.getFileSize(), sampleSize, seed, numThreads);
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,66 @@
+/**
+ * @file sampling.h
+ * @brief Skip-ahead reservoir sampling over memory-mapped input
+ */
+
+#ifndef SUZUME_CORE_SAMPLING_H_
+#define SUZUME_CORE_SAMPLING_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Sample N lines uniformly from a buffer
+ *
+ * Uses Algorithm L: after the reservoir is full, the number of lines to skip
+ * before the next replacement is drawn from a geometric distribution, so
+ * skipped lines are only scanned for their newline and never copied. Only
+ * selected lines are materialized.
+ *
+ * With more than one thread the buffer is split at line boundaries, each
+ * chunk keeps its own reservoir, and the reservoirs are merged by drawing
+ * from each chunk in proportion to its remaining line count. Results for a
+ * given seed are reproducible for the same thread count.
+ *
+ * Lines follow std::getline semantics and are returned in input order.
+ *
+ * @param data Buffer start
+ * @param size Buffer size in bytes
+ * @param sampleSize Number of lines to sample
+ * @param seed Random seed (0 for time-based seed)
+ * @param numThreads Number of chunks sampled in parallel (0 = auto-detect)
+ * @return std::vector<std::string> Sampled lines (all lines if fewer than sampleSize)
+ */
+std::vector<std::string> sampleLineBuffer(
+    const char* data,
+    size_t size,
+    size_t sampleSize,
+    unsigned int seed = 0,
+    unsigned int numThreads = 1
+);
+
+/**
+ * @brief Sample N lines uniformly from a memory-mapped file
+ *
+ * @param inputPath Path to input file
+ * @param sampleSize Number of lines to sample
+ * @param seed Random seed (0 for time-based seed)
+ * @param numThreads Number of chunks sampled in parallel (0 = auto-detect)
+ * @return std::vector<std::string> Sampled lines in input order
+ * @throws std::runtime_error If the file cannot be mapped
+ */
+std::vector<std::string> sampleLinesMapped(
+    const std::string& inputPath,
+    size_t sampleSize,
+    unsigned int seed = 0,
+    unsigned int numThreads = 1
+);
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_SAMPLING_H_
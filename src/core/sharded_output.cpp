@@ -0,0 +1,195 @@
+/**
+ * @file sharded_output.cpp
+ * @brief Implementation of sharded output
+ */
+
+#include "core/sharded_output.h"
+#include "core/output_writer.h"
+#include "xxhash.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/// Buffer of each shard; many shards are open at once
+constexpr size_t kShardBufferSize = 256 * 1024;
+
+/// Initial stream buffer, grown for longer lines
+constexpr size_t kStreamBufferSize = 64 * 1024;
+
+} // namespace
+
+std::string shardOutputPath(const std::string& path, uint32_t shard, uint32_t shardCount) {
+    std::filesystem::path filePath(path);
+    std::string name = filePath.filename().string();
+    size_t dot = name.find('.', 1);
+    if (dot == std::string::npos) {
+        dot = name.size();
+    }
+
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), "-%05u-of-%05u", shard, shardCount);
+    name.insert(dot, suffix);
+    return (filePath.parent_path() / name).string();
+}
+
+ShardedOutputWriter::ShardedOutputWriter(
+    const std::string& path, uint32_t shardCount, ShardRouting routing, bool compress)
+    : routing_(routing)
+    , turn_(0)
+    , start_(0)
+    , buffer_(kStreamBufferSize)
+{
+    if (shardCount < 1 || shardCount > kMaxShards) {
+        throw std::invalid_argument("Invalid output shard count: " + std::to_string(shardCount) +
+                                    " (must be between 1 and " + std::to_string(kMaxShards) + ")");
+    }
+    if (path == "-" || path == "null") {
+        throw std::invalid_argument("Sharded output needs an output file path, not '" + path + "'");
+    }
+
+    // Shards are written concurrently, so each compresses its own blocks one at a time
+    compress = compress || isCompressedOutputPath(path);
+    shards_.reserve(shardCount);
+    for (uint32_t i = 0; i < shardCount; ++i) {
+        std::string shardPath = shardOutputPath(path, i, shardCount);
+        prepareOutputPath(shardPath);
+        auto shard = std::make_unique<Shard>();
+        shard->writer = std::make_unique<OutputWriter>(shardPath, kShardBufferSize, compress, 1);
+        shards_.push_back(std::move(shard));
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+}
+
+ShardedOutputWriter::~ShardedOutputWriter() {
+    try {
+        close();
+    } catch (...) {
+        // Destructors must not throw
+    }
+}
+
+uint32_t ShardedOutputWriter::shardOf(std::string_view line) {
+    uint64_t count = shards_.size();
+    if (routing_ == ShardRouting::RoundRobin) {
+        return static_cast<uint32_t>(turn_.fetch_add(1, std::memory_order_relaxed) % count);
+    }
+    return static_cast<uint32_t>(XXH3_64bits(line.data(), line.size()) % count);
+}
+
+OutputWriter& ShardedOutputWriter::shard(uint32_t index) {
+    return *shards_.at(index)->writer;
+}
+
+void ShardedOutputWriter::writeLine(std::string_view line) {
+    Shard& shard = *shards_[shardOf(line)];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    shard.writer->writeLine(line);
+}
+
+void ShardedOutputWriter::writeLines(const std::vector<std::string>& lines) {
+    const uint32_t count = shardCount();
+    if (lines.empty()) {
+        return;
+    }
+
+    // Bucket the batch by shard (a counting sort that keeps the line order)
+    uint64_t first = 0;
+    if (routing_ == ShardRouting::RoundRobin) {
+        first = turn_.fetch_add(lines.size(), std::memory_order_relaxed);
+    }
+    std::vector<uint32_t> shardOfLine(lines.size());
+    std::vector<size_t> bucketEnd(count + 1, 0);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        shardOfLine[i] = routing_ == ShardRouting::RoundRobin
+            ? static_cast<uint32_t>((first + i) % count)
+            : static_cast<uint32_t>(XXH3_64bits(lines[i].data(), lines[i].size()) % count);
+        bucketEnd[shardOfLine[i] + 1]++;
+    }
+    for (uint32_t s = 0; s < count; ++s) {
+        bucketEnd[s + 1] += bucketEnd[s];
+    }
+    std::vector<const std::string*> ordered(lines.size());
+    std::vector<size_t> fill(bucketEnd.begin(), bucketEnd.end() - 1);
+    for (size_t i = 0; i < lines.size(); ++i) {
+        ordered[fill[shardOfLine[i]]++] = &lines[i];
+    }
+
+    // Batches start at different shards, so concurrent writers rarely queue on one lock
+    uint32_t start = start_.fetch_add(1, std::memory_order_relaxed) % count;
+    for (uint32_t step = 0; step < count; ++step) {
+        uint32_t s = (start + step) % count;
+        if (bucketEnd[s] == bucketEnd[s + 1]) {
+            continue;
+        }
+        Shard& shard = *shards_[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (size_t i = bucketEnd[s]; i < bucketEnd[s + 1]; ++i) {
+            shard.writer->writeLine(*ordered[i]);
+        }
+    }
+}
+
+void ShardedOutputWriter::close() {
+    routeBuffered();
+    if (pptr() != pbase()) {
+        writeLine(std::string_view(pbase(), static_cast<size_t>(pptr() - pbase())));
+        setp(buffer_.data(), buffer_.data() + buffer_.size());
+    }
+    for (auto& shard : shards_) {
+        std::lock_guard<std::mutex> lock(shard->mutex);
+        shard->writer->close();
+    }
+}
+
+ShardedOutputWriter::int_type ShardedOutputWriter::overflow(int_type c) {
+    try {
+        routeBuffered();
+    } catch (const std::exception&) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+int ShardedOutputWriter::sync() {
+    try {
+        routeBuffered();
+        for (auto& shard : shards_) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            shard->writer->flush();
+        }
+    } catch (const std::exception&) {
+        return -1;
+    }
+    return 0;
+}
+
+void ShardedOutputWriter::routeBuffered() {
+    const char* begin = pbase();
+    const char* end = pptr();
+    while (const char* newline = static_cast<const char*>(std::memchr(begin, '\n', end - begin))) {
+        writeLine(std::string_view(begin, static_cast<size_t>(newline - begin)));
+        begin = newline + 1;
+    }
+
+    // Keep the unterminated rest at the front; a line longer than the buffer grows it
+    size_t rest = static_cast<size_t>(end - begin);
+    std::memmove(buffer_.data(), begin, rest);
+    if (rest == buffer_.size()) {
+        buffer_.resize(buffer_.size() * 2);
+    }
+    setp(buffer_.data(), buffer_.data() + buffer_.size());
+    pbump(static_cast<int>(rest));
+}
+
+} // namespace core
+} // namespace suzume
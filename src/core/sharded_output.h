@@ -0,0 +1,149 @@
+/**
+ * @file sharded_output.h
+ * @brief Output split line by line into numbered shard files
+ */
+
+#ifndef SUZUME_CORE_SHARDED_OUTPUT_H_
+#define SUZUME_CORE_SHARDED_OUTPUT_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "suzume_feedmill.h"
+
+namespace suzume {
+namespace core {
+
+class OutputWriter;
+
+/**
+ * @brief Path of one shard of an output
+ *
+ * "out.txt" becomes "out-00003-of-00064.txt"; every extension after the
+ * first dot of the file name is kept, so "out.txt.zst" becomes
+ * "out-00003-of-00064.txt.zst".
+ *
+ * @param path Output path given by the caller
+ * @param shard Shard index
+ * @param shardCount Number of shards
+ * @return std::string Shard path
+ */
+std::string shardOutputPath(const std::string& path, uint32_t shard, uint32_t shardCount);
+
+/**
+ * @brief Writes lines into shardCount files instead of one
+ *
+ * Every shard is a buffered OutputWriter of its own behind its own lock, so
+ * workers hand their lines over directly and only contend when they hit the
+ * same shard at the same time. writeLines() buckets a batch by shard first
+ * and takes each lock once.
+ *
+ * With ShardRouting::Hash a line goes to the shard its XXH3 hash selects,
+ * so equal lines always land in the same shard, in this run and the next.
+ * ShardRouting::RoundRobin deals lines out in turn and keeps the shards
+ * within one line of each other in size. Within a shard, lines keep the
+ * order in which they were written.
+ *
+ * The writer is also a std::streambuf for code written against
+ * std::ostream; it cuts the bytes it receives into lines and routes them.
+ * That side is meant for a single producer.
+ */
+class ShardedOutputWriter : public std::streambuf {
+public:
+    /// Most shards an output can be split into (five digits in the file names)
+    static constexpr uint32_t kMaxShards = 99999;
+
+    /**
+     * @brief Create the shard files, truncating them
+     * @param path Output path the shard paths are derived from (see shardOutputPath())
+     * @param shardCount Number of shards (1 to kMaxShards)
+     * @param routing How lines are assigned to shards
+     * @param compress Write zstd frames (also chosen by a ".zst" path)
+     * @throws std::invalid_argument If the shard count is out of range or the path is stdout
+     * @throws std::runtime_error If a shard cannot be opened
+     */
+    ShardedOutputWriter(const std::string& path, uint32_t shardCount, ShardRouting routing, bool compress = false);
+
+    /**
+     * @brief Destructor; flushes the shards, ignoring errors (call close() to see them)
+     */
+    ~ShardedOutputWriter() override;
+
+    ShardedOutputWriter(const ShardedOutputWriter&) = delete;
+    ShardedOutputWriter& operator=(const ShardedOutputWriter&) = delete;
+
+    /**
+     * @brief Number of shards
+     * @return uint32_t Shard count
+     */
+    uint32_t shardCount() const { return static_cast<uint32_t>(shards_.size()); }
+
+    /**
+     * @brief Choose the shard of the next line (round robin advances the turn)
+     * @param line Line without terminator
+     * @return uint32_t Shard index
+     */
+    uint32_t shardOf(std::string_view line);
+
+    /**
+     * @brief Writer of one shard, for output with its own formatting
+     *
+     * The shard's lock is not taken; callers that write from several threads
+     * use writeLine() or writeLines() instead.
+     *
+     * @param index Shard index
+     * @return OutputWriter& Buffered writer of the shard
+     */
+    OutputWriter& shard(uint32_t index);
+
+    /**
+     * @brief Write a line and its newline to its shard (thread-safe)
+     * @param line Line without terminator
+     */
+    void writeLine(std::string_view line);
+
+    /**
+     * @brief Write a batch of lines, each to its shard (thread-safe)
+     * @param lines Lines without terminators
+     */
+    void writeLines(const std::vector<std::string>& lines);
+
+    /**
+     * @brief Write out every shard and close the files
+     *
+     * Bytes of an unterminated last line written through the stream buffer
+     * are written as a line of their own first.
+     *
+     * @throws std::runtime_error If a write or close fails
+     */
+    void close();
+
+protected:
+    int_type overflow(int_type c) override;
+    int sync() override;
+
+private:
+    struct Shard {
+        std::mutex mutex;
+        std::unique_ptr<OutputWriter> writer;
+    };
+
+    void routeBuffered();
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    ShardRouting routing_;
+    std::atomic<uint64_t> turn_;     ///< Lines dealt out so far (round robin)
+    std::atomic<uint32_t> start_;    ///< Shard the next batch starts at, so writers spread out
+    std::vector<char> buffer_;       ///< Stream bytes not yet cut into lines
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_SHARDED_OUTPUT_H_
@@ -0,0 +1,118 @@
+/**
+ * @file standard_streams.cpp
+ * @brief Implementation of direct stdin and stdout access
+ */
+
+#include "core/standard_streams.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Stream buffers std::cin and std::cout start out with; <iostream> above
+// guarantees the standard streams exist before these are initialized
+std::streambuf* const processStdinBuffer = std::cin.rdbuf();
+std::streambuf* const processStdoutBuffer = std::cout.rdbuf();
+
+} // namespace
+
+bool isProcessStdin() {
+    return std::cin.rdbuf() == processStdinBuffer;
+}
+
+bool isProcessStdout() {
+    return std::cout.rdbuf() == processStdoutBuffer;
+}
+
+void writeStdout(const char* data, size_t size) {
+    std::cout.flush();
+    while (size > 0) {
+        ssize_t written = ::write(STDOUT_FILENO, data, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::runtime_error(std::string("Failed to write to stdout: ") + std::strerror(errno));
+        }
+        data += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+DescriptorInputStream::DescriptorInputStream(int fd, size_t blockSize)
+    : std::istream(nullptr)
+    , buffer_(fd, blockSize)
+{
+    rdbuf(&buffer_);
+    // Let read errors propagate instead of just ending the input
+    exceptions(std::ios::badbit);
+}
+
+DescriptorInputStream::StreamBuf::StreamBuf(int fd, size_t blockSize)
+    : fd_(fd)
+    , buffer_(std::max<size_t>(blockSize, 1))
+{
+    setg(buffer_.data(), buffer_.data(), buffer_.data());
+}
+
+DescriptorInputStream::StreamBuf::int_type DescriptorInputStream::StreamBuf::underflow() {
+    if (gptr() < egptr()) {
+        return traits_type::to_int_type(*gptr());
+    }
+    size_t count = readSome(buffer_.data(), buffer_.size());
+    setg(buffer_.data(), buffer_.data(), buffer_.data() + count);
+    if (count == 0) {
+        return traits_type::eof();
+    }
+    return traits_type::to_int_type(*gptr());
+}
+
+std::streamsize DescriptorInputStream::StreamBuf::xsgetn(char* data, std::streamsize size) {
+    std::streamsize total = 0;
+    while (total < size) {
+        // Hand out what is buffered, then read large requests in place
+        std::streamsize available = egptr() - gptr();
+        if (available > 0) {
+            std::streamsize take = std::min(available, size - total);
+            std::memcpy(data + total, gptr(), static_cast<size_t>(take));
+            gbump(static_cast<int>(take));
+            total += take;
+            continue;
+        }
+        size_t wanted = static_cast<size_t>(size - total);
+        if (wanted < buffer_.size()) {
+            if (traits_type::eq_int_type(underflow(), traits_type::eof())) {
+                break;
+            }
+            continue;
+        }
+        size_t count = readSome(data + total, wanted);
+        if (count == 0) {
+            break;
+        }
+        total += static_cast<std::streamsize>(count);
+    }
+    return total;
+}
+
+size_t DescriptorInputStream::StreamBuf::readSome(char* data, size_t size) {
+    while (true) {
+        ssize_t count = ::read(fd_, data, size);
+        if (count >= 0) {
+            return static_cast<size_t>(count);
+        }
+        if (errno != EINTR) {
+            throw std::runtime_error(std::string("Failed to read input: ") + std::strerror(errno));
+        }
+    }
+}
+
+} // namespace core
+} // namespace suzume
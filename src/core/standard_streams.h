@@ -0,0 +1,87 @@
+/**
+ * @file standard_streams.h
+ * @brief Block reads from stdin and writes to stdout that bypass iostreams
+ */
+
+#ifndef SUZUME_CORE_STANDARD_STREAMS_H_
+#define SUZUME_CORE_STANDARD_STREAMS_H_
+
+#include <cstddef>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Check whether std::cin still reads the process's standard input
+ *
+ * False once std::cin has been redirected to another stream buffer (as
+ * tests do), in which case input has to go through std::cin.
+ *
+ * @return bool True if file descriptor 0 may be read directly
+ */
+bool isProcessStdin();
+
+/**
+ * @brief Check whether std::cout still writes the process's standard output
+ * @return bool True if file descriptor 1 may be written directly
+ */
+bool isProcessStdout();
+
+/**
+ * @brief Write bytes to standard output with write(2)
+ *
+ * Whatever std::cout still buffers is flushed first, so output written
+ * both ways stays in order.
+ *
+ * @param data Bytes to write
+ * @param size Number of bytes
+ * @throws std::runtime_error If the write fails
+ */
+void writeStdout(const char* data, size_t size);
+
+/**
+ * @brief Input stream reading a file descriptor with read(2) in large blocks
+ *
+ * Reads bigger than the block go straight into the caller's buffer, so a
+ * pipe is drained with one system call per block instead of passing
+ * through the synchronized stdio buffer of std::cin.
+ */
+class DescriptorInputStream : public std::istream {
+public:
+    /// Default bytes per read
+    static constexpr size_t kDefaultBlockSize = 1024 * 1024;
+
+    /**
+     * @brief Constructor
+     * @param fd Open file descriptor (not owned)
+     * @param blockSize Bytes per read (at least 1)
+     */
+    explicit DescriptorInputStream(int fd, size_t blockSize = kDefaultBlockSize);
+
+private:
+    class StreamBuf : public std::streambuf {
+    public:
+        StreamBuf(int fd, size_t blockSize);
+
+    protected:
+        int_type underflow() override;
+        std::streamsize xsgetn(char* data, std::streamsize size) override;
+
+    private:
+        size_t readSome(char* data, size_t size);
+
+        int fd_;
+        std::vector<char> buffer_;
+    };
+
+    StreamBuf buffer_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_STANDARD_STREAMS_H_
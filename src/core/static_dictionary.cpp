@@ -0,0 +1,193 @@
+/**
+ * @file static_dictionary.cpp
+ * @brief Implementation of the static dictionary
+ */
+
+#include "core/static_dictionary.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "core/output_writer.h"
+#include "xxhash.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+constexpr char kStaticDictionaryMagic[8] = {'S', 'Z', 'D', 'I', 'C', 'T', 'S', '1'};
+constexpr uint32_t kStaticDictionaryVersion = 1;
+
+void appendUint32(std::string& out, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+void appendUint64(std::string& out, uint64_t value) {
+    for (int i = 0; i < 8; ++i) {
+        out.push_back(static_cast<char>((value >> (8 * i)) & 0xFF));
+    }
+}
+
+uint64_t wordHash(std::string_view word) {
+    return XXH64(word.data(), word.size(), 0);
+}
+
+} // namespace
+
+size_t buildStaticDictionary(const std::string& inputPath, const std::string& outputPath) {
+    std::ifstream in(inputPath);
+    if (!in.is_open()) {
+        throw std::runtime_error("Failed to open dictionary word list: " + inputPath);
+    }
+    std::vector<std::string> words;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty()) {
+            words.push_back(std::move(line));
+        }
+    }
+
+    size_t buckets = 1;
+    while (buckets < words.size()) {
+        buckets <<= 1;
+    }
+    if (buckets > UINT32_MAX) {
+        throw std::runtime_error("Too many words for the static dictionary: " + inputPath);
+    }
+
+    // Group by bucket, ordering each bucket by word so duplicates sit together
+    std::vector<std::pair<uint32_t, size_t>> order;
+    order.reserve(words.size());
+    for (size_t i = 0; i < words.size(); ++i) {
+        order.emplace_back(static_cast<uint32_t>(wordHash(words[i]) & (buckets - 1)), i);
+    }
+    std::sort(order.begin(), order.end(), [&words](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first < b.first : words[a.second] < words[b.second];
+    });
+    order.erase(std::unique(order.begin(), order.end(), [&words](const auto& a, const auto& b) {
+        return words[a.second] == words[b.second];
+    }), order.end());
+
+    uint64_t poolSize = 0;
+    for (const auto& entry : order) {
+        poolSize += words[entry.second].size();
+    }
+    if (poolSize > UINT32_MAX) {
+        throw std::runtime_error("Dictionary too large for the static format: " + inputPath);
+    }
+
+    std::string header(kStaticDictionaryMagic, sizeof(kStaticDictionaryMagic));
+    appendUint32(header, kStaticDictionaryVersion);
+    appendUint32(header, static_cast<uint32_t>(buckets));
+    appendUint64(header, order.size());
+    appendUint64(header, poolSize);
+
+    std::string column;
+    column.reserve((buckets + order.size() + 2) * 4);
+    size_t entry = 0;
+    for (size_t bucket = 0; bucket <= buckets; ++bucket) {
+        while (entry < order.size() && order[entry].first < bucket) {
+            ++entry;
+        }
+        appendUint32(column, static_cast<uint32_t>(entry));
+    }
+    uint32_t offset = 0;
+    appendUint32(column, offset);
+    for (const auto& item : order) {
+        offset += static_cast<uint32_t>(words[item.second].size());
+        appendUint32(column, offset);
+    }
+
+    prepareOutputPath(outputPath);
+    OutputWriter output(outputPath);
+    output.write(header);
+    output.write(column);
+    for (const auto& item : order) {
+        output.write(words[item.second]);
+    }
+    output.close();
+    return order.size();
+}
+
+bool isStaticDictionaryFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[sizeof(kStaticDictionaryMagic)];
+    return in.read(magic, sizeof(magic)) && std::memcmp(magic, kStaticDictionaryMagic, sizeof(magic)) == 0;
+}
+
+StaticDictionary::StaticDictionary(const std::string& path)
+    : buckets_(0)
+    , entries_(0)
+    , offsetsOffset_(0)
+    , poolOffset_(0)
+{
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("Dictionary file does not exist: " + path);
+    }
+    mapping_ = std::make_unique<MemoryMappedProcessor>(path);
+    if (mapping_->isMapped()) {
+        data_ = std::string_view(mapping_->data(), mapping_->getFileSize());
+    } else {
+        mapping_.reset();
+        std::ifstream in(path, std::ios::binary);
+        buffer_.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        data_ = buffer_;
+    }
+
+    if (data_.size() < kStaticDictionaryHeaderSize ||
+        std::memcmp(data_.data(), kStaticDictionaryMagic, sizeof(kStaticDictionaryMagic)) != 0) {
+        throw std::runtime_error("Not a static dictionary: " + path);
+    }
+    if (readUint32(8) != kStaticDictionaryVersion) {
+        throw std::runtime_error("Unsupported static dictionary version in " + path);
+    }
+    uint64_t buckets = readUint32(12);
+    uint64_t entries = readUint64(16);
+    uint64_t poolSize = readUint64(24);
+
+    // Columns are fixed-width, so the size of the file follows from the header
+    if (buckets == 0 || (buckets & (buckets - 1)) != 0 || entries > data_.size() ||
+        kStaticDictionaryHeaderSize + (buckets + 1 + entries + 1) * 4 + poolSize != data_.size()) {
+        throw std::runtime_error("Corrupt static dictionary: " + path);
+    }
+    buckets_ = static_cast<size_t>(buckets);
+    entries_ = static_cast<size_t>(entries);
+    offsetsOffset_ = kStaticDictionaryHeaderSize + (buckets_ + 1) * 4;
+    poolOffset_ = offsetsOffset_ + (entries_ + 1) * 4;
+    if (readUint32(offsetsOffset_ - 4) != entries_ || readUint32(poolOffset_ - 4) != poolSize) {
+        throw std::runtime_error("Corrupt static dictionary: " + path);
+    }
+}
+
+bool StaticDictionary::contains(std::string_view word) const {
+    size_t bucket = static_cast<size_t>(wordHash(word) & (buckets_ - 1));
+    uint32_t first = readUint32(kStaticDictionaryHeaderSize + bucket * 4);
+    uint32_t last = std::min<uint32_t>(readUint32(kStaticDictionaryHeaderSize + (bucket + 1) * 4),
+                                       static_cast<uint32_t>(entries_));
+    for (uint32_t entry = first; entry < last; ++entry) {
+        uint32_t begin = readUint32(offsetsOffset_ + entry * 4);
+        uint32_t end = readUint32(offsetsOffset_ + (entry + 1) * 4);
+        if (data_.substr(poolOffset_ + begin, end - begin) == word) {
+            return true;
+        }
+    }
+    return false;
+}
+
+uint64_t StaticDictionary::readUint64(size_t offset) const {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; --i) {
+        value = (value << 8) | static_cast<uint8_t>(data_[offset + i]);
+    }
+    return value;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,100 @@
+/**
+ * @file static_dictionary.h
+ * @brief Prebuilt dictionary that is mapped and searched without loading
+ */
+
+#ifndef SUZUME_CORE_STATIC_DICTIONARY_H_
+#define SUZUME_CORE_STATIC_DICTIONARY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "core/streaming_processor.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * Dictionary layout (all integers little-endian):
+ *
+ *   header   "SZDICTS1", uint32 version, uint32 buckets, uint64 entries, uint64 pool bytes
+ *   buckets  uint32 per bucket plus one: first entry of each hash bucket
+ *   offsets  uint32 per entry plus one: start of each word in the pool
+ *   pool     UTF-8 words back to back, grouped by bucket, without separators
+ *
+ * The bucket count is a power of two no smaller than the entry count, and
+ * a word belongs to bucket XXH64(word) & (buckets - 1). A lookup reads two
+ * bucket bounds and compares the word with about one entry, touching only
+ * the pages it needs; the file is mapped read-only, so concurrent
+ * processes share its pages.
+ */
+constexpr size_t kStaticDictionaryHeaderSize = 32;
+
+/**
+ * @brief Build a static dictionary from a word list
+ *
+ * Each non-empty line of the input is one word, as in the text dictionary
+ * read by the verifier. Duplicate lines are stored once.
+ *
+ * @param inputPath Word list path, one word per line
+ * @param outputPath Output dictionary path
+ * @return size_t Number of distinct words written
+ * @throws std::runtime_error If the input cannot be read, the output cannot be written or the words exceed 4 GiB
+ */
+size_t buildStaticDictionary(const std::string& inputPath, const std::string& outputPath);
+
+/**
+ * @brief Check whether a file starts with the static dictionary magic
+ * @param path File path
+ * @return bool True for a static dictionary
+ */
+bool isStaticDictionaryFile(const std::string& path);
+
+/**
+ * @brief Looks words up in a static dictionary in place from a memory mapping
+ */
+class StaticDictionary {
+public:
+    /**
+     * @brief Constructor
+     * @param path Dictionary path
+     * @throws std::runtime_error If the file is missing, truncated or not a static dictionary
+     */
+    explicit StaticDictionary(const std::string& path);
+
+    /**
+     * @brief Get the number of words
+     * @return size_t Word count
+     */
+    size_t size() const { return entries_; }
+
+    /**
+     * @brief Check whether a word is in the dictionary
+     * @param word Word to look up
+     * @return bool True if the word is present
+     */
+    bool contains(std::string_view word) const;
+
+private:
+    uint32_t readUint32(size_t offset) const {
+        const auto* bytes = reinterpret_cast<const uint8_t*>(data_.data() + offset);
+        return static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+               static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24;
+    }
+    uint64_t readUint64(size_t offset) const;
+
+    std::unique_ptr<MemoryMappedProcessor> mapping_;
+    std::string buffer_;
+    std::string_view data_;
+    size_t buckets_;
+    size_t entries_;
+    size_t offsetsOffset_;
+    size_t poolOffset_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_STATIC_DICTIONARY_H_
@@ -4,14 +4,22 @@
  */
 
 #include "streaming_processor.h"
+#include "core/auto_tune.h"
+#include "core/memory_accounting.h"
+#include "core/numa_topology.h"
+#include "parallel/thread_pool.h"
 #include <chrono>
 #include <filesystem>
 #include <iostream>
 #include <thread>
 #include <queue>
+#include <map>
 #include <mutex>
 #include <condition_variable>
 #include <atomic>
+#include <algorithm>
+#include <exception>
+#include <optional>
 
 #ifdef __unix__
 #include <sys/mman.h>
@@ -261,6 +269,16 @@ size_t MemoryMappedProcessor::processChunks(
     return chunks;
 }
 
+void MemoryMappedProcessor::adviseSequential() {
+    if (!mapped_) {
+        return;
+    }
+    madvise(mappedData_, fileSize_, MADV_SEQUENTIAL);
+#ifdef MADV_HUGEPAGE
+    madvise(mappedData_, fileSize_, MADV_HUGEPAGE);
+#endif
+}
+
 void MemoryMappedProcessor::unmap() {
     if (mapped_ && mappedData_) {
         munmap(mappedData_, fileSize_);
@@ -297,6 +315,9 @@ size_t MemoryMappedProcessor::processChunks(
     throw std::runtime_error("Memory mapping not supported on this platform");
 }
 
+void MemoryMappedProcessor::adviseSequential() {
+}
+
 void MemoryMappedProcessor::unmap() {
 }
 #endif
@@ -307,12 +328,12 @@ ParallelStreamProcessor::ParallelStreamProcessor(size_t numThreads, const Stream
     : config_(config)
     , totalLines_(0)
     , processingTimeMs_(0)
+    , outputLines_(0)
+    , peakBufferedBytes_(0)
+    , peakReorderBatches_(0)
 {
     if (numThreads == 0) {
-        numThreads_ = std::thread::hardware_concurrency();
-        if (numThreads_ == 0) {
-            numThreads_ = 4; // Fallback
-        }
+        numThreads_ = resolveThreads(0);
     } else {
         numThreads_ = numThreads;
     }
@@ -324,27 +345,24 @@ size_t ParallelStreamProcessor::processFile(
     const StreamingLineProcessor::BatchProcessor& processor,
     const StreamingLineProcessor::ProgressCallback& progressCallback
 ) {
-    auto startTime = std::chrono::high_resolution_clock::now();
+    // Buffers must be installed before the streams are opened
+    std::vector<char> inputBuffer(config_.bufferSize);
+    std::vector<char> outputBuffer(config_.bufferSize);
     
-    std::ifstream input(inputPath, std::ios::binary);
+    std::ifstream input;
+    input.rdbuf()->pubsetbuf(inputBuffer.data(), inputBuffer.size());
+    input.open(inputPath, std::ios::binary);
     if (!input.is_open()) {
         throw std::runtime_error("Failed to open input file: " + inputPath);
     }
     
-    std::ofstream output(outputPath, std::ios::binary);
+    std::ofstream output;
+    output.rdbuf()->pubsetbuf(outputBuffer.data(), outputBuffer.size());
+    output.open(outputPath, std::ios::binary);
     if (!output.is_open()) {
         throw std::runtime_error("Failed to open output file: " + outputPath);
     }
     
-    // Producer-consumer pattern with work queue
-    std::queue<std::vector<std::string>> workQueue;
-    std::queue<std::vector<std::string>> resultQueue;
-    std::mutex workMutex, resultMutex;
-    std::condition_variable workCv, resultCv;
-    std::atomic<bool> inputFinished{false};
-    std::atomic<bool> processingFinished{false};
-    std::atomic<size_t> totalProcessed{0};
-    
     size_t fileSize = 0;
     try {
         fileSize = std::filesystem::file_size(inputPath);
@@ -352,68 +370,194 @@ size_t ParallelStreamProcessor::processFile(
         // Continue without file size for progress reporting
     }
     
+    return processStream(input, &output, processor, progressCallback, fileSize);
+}
+
+size_t ParallelStreamProcessor::processStream(
+    std::istream& input,
+    std::ostream* output,
+    const StreamingLineProcessor::BatchProcessor& processor,
+    const StreamingLineProcessor::ProgressCallback& progressCallback,
+    size_t totalBytes,
+    const StreamingLineProcessor::BatchProcessor& sequentialStage
+) {
+    // Batch functions see the lines as strings; empty results are not written
+    auto toBlocks = [](const StreamingLineProcessor::BatchProcessor& batchProcessor) -> BlockProcessor {
+        if (!batchProcessor) {
+            return nullptr;
+        }
+        return [&batchProcessor](const LineBlock& batch, LineBlock& result) {
+            std::vector<std::string> lines(batch.begin(), batch.end());
+            for (const std::string& line : batchProcessor(lines)) {
+                if (!line.empty()) {
+                    result.push_back(line);
+                }
+            }
+        };
+    };
+    return processStreamBlocks(input, output, toBlocks(processor), progressCallback, totalBytes,
+                               toBlocks(sequentialStage));
+}
+
+size_t ParallelStreamProcessor::processStreamBlocks(
+    std::istream& input,
+    std::ostream* output,
+    const BlockProcessor& processor,
+    const StreamingLineProcessor::ProgressCallback& progressCallback,
+    size_t totalBytes,
+    const BlockProcessor& sequentialStage
+) {
+    auto startTime = std::chrono::high_resolution_clock::now();
+    
+    // A batch is charged twice against the budget: once for its input lines
+    // and once for the processed lines waiting to be written.
+    const size_t memoryBudget = std::max<size_t>(config_.maxMemoryUsage, 1);
+    const size_t batchByteLimit = std::max<size_t>(1, memoryBudget / (2 * (numThreads_ + 2)));
+    const size_t batchLineLimit = std::max<size_t>(config_.batchSize, 1);
+    
+    // Ordered runs bound how far the reader may run ahead of the writer
+    const bool preserveOrder = config_.preserveOrder;
+    const size_t reorderWindow = std::max<size_t>(
+        config_.reorderWindow == 0 ? 4 * numThreads_ : config_.reorderWindow, numThreads_ + 1);
+    
+    struct Batch {
+        LineBlock lines;
+        size_t charge = 0;
+        size_t sequence = 0;
+    };
+    
+    // Producer-consumer pattern with work queue
+    std::queue<Batch> workQueue;
+    std::queue<Batch> resultQueue;
+    std::mutex workMutex, resultMutex, budgetMutex, errorMutex;
+    std::condition_variable workCv, resultCv, budgetCv;
+    bool inputFinished = false;
+    bool processingFinished = false;
+    size_t bufferedBytes = 0;
+    MemoryCharge lineMemory(MemorySubsystem::Lines);  // Follows bufferedBytes
+    size_t peakBufferedBytes = 0;
+    size_t submittedBatches = 0;
+    size_t writtenBatches = 0;
+    size_t peakReorderBatches = 0;
+    std::atomic<bool> aborted{false};
+    std::atomic<size_t> totalProcessed{0};
+    std::atomic<size_t> bytesConsumed{0};
+    std::exception_ptr error;
+    
+    auto fail = [&](std::exception_ptr e) {
+        {
+            std::lock_guard<std::mutex> lock(errorMutex);
+            if (!error) {
+                error = e;
+            }
+        }
+        aborted = true;
+        workCv.notify_all();
+        budgetCv.notify_all();
+    };
+    
     // Producer thread (reader)
     std::thread producer([&]() {
-        std::vector<char> buffer(config_.bufferSize);
-        input.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
-        
-        std::vector<std::string> batch;
-        batch.reserve(config_.batchSize);
-        
-        std::string line;
-        while (std::getline(input, line)) {
-            batch.push_back(std::move(line));
-            
-            if (batch.size() >= config_.batchSize) {
+        try {
+            // Blocks start at the size of the previous one, which batches rarely outgrow
+            size_t blockBytes = 0;
+            auto submit = [&](Batch& batch) {
+                blockBytes = batch.lines.text().size();
+                {
+                    std::unique_lock<std::mutex> lock(budgetMutex);
+                    budgetCv.wait(lock, [&]() {
+                        if (aborted) {
+                            return true;
+                        }
+                        if (preserveOrder && submittedBatches - writtenBatches >= reorderWindow) {
+                            return false;
+                        }
+                        return bufferedBytes == 0 ||
+                               bufferedBytes + batch.charge <= memoryBudget;
+                    });
+                    bufferedBytes += batch.charge;
+                    peakBufferedBytes = std::max(peakBufferedBytes, bufferedBytes);
+                    lineMemory.set(bufferedBytes);
+                    batch.sequence = submittedBatches++;
+                }
                 {
                     std::lock_guard<std::mutex> lock(workMutex);
                     workQueue.push(std::move(batch));
                 }
                 workCv.notify_one();
-                batch.clear();
-                batch.reserve(config_.batchSize);
+                batch = Batch();
+                batch.lines.reserve(blockBytes, batchLineLimit);
+            };
+            
+            Batch batch;
+            batch.lines.reserve(0, batchLineLimit);
+            size_t batchBytes = 0;
+            
+            // The line buffer keeps its capacity; lines are copied into the batch's block
+            std::string line;
+            while (!aborted && std::getline(input, line)) {
+                bytesConsumed += line.size() + 1; // +1 for newline
+                batchBytes += line.size() + 1 + sizeof(size_t);
+                batch.lines.push_back(line);
+                
+                if (batch.lines.size() >= batchLineLimit || batchBytes >= batchByteLimit) {
+                    batch.charge = batchBytes * 2;
+                    submit(batch);
+                    batchBytes = 0;
+                }
             }
-        }
-        
-        // Push remaining batch
-        if (!batch.empty()) {
-            {
-                std::lock_guard<std::mutex> lock(workMutex);
-                workQueue.push(std::move(batch));
+            
+            // Push remaining batch
+            if (!batch.lines.empty() && !aborted) {
+                batch.charge = batchBytes * 2;
+                submit(batch);
             }
-            workCv.notify_one();
+        } catch (...) {
+            fail(std::current_exception());
         }
         
-        inputFinished = true;
+        {
+            std::lock_guard<std::mutex> lock(workMutex);
+            inputFinished = true;
+        }
         workCv.notify_all();
     });
     
-    // Worker threads
-    std::vector<std::thread> workers;
+    // Workers run on the shared pool; the reader and writer keep their own threads
+    std::optional<WorkerPlacement> placement;
+    if (config_.numaAware) {
+        placement.emplace(NumaTopology::system(), numThreads_);
+    }
+    parallel::TaskGroup workers("normalize");
     for (size_t i = 0; i < numThreads_; ++i) {
-        workers.emplace_back([&]() {
+        workers.run([&, i]() {
+            ThreadPin pin(placement ? &*placement : nullptr, i);
             while (true) {
-                std::vector<std::string> batch;
+                Batch batch;
                 
                 // Get work
                 {
                     std::unique_lock<std::mutex> lock(workMutex);
-                    workCv.wait(lock, [&]() { return !workQueue.empty() || inputFinished; });
+                    workCv.wait(lock, [&]() { return !workQueue.empty() || inputFinished || aborted; });
                     
-                    if (workQueue.empty() && inputFinished) {
+                    if (aborted || (workQueue.empty() && inputFinished)) {
                         break;
                     }
                     
-                    if (!workQueue.empty()) {
-                        batch = std::move(workQueue.front());
-                        workQueue.pop();
-                    }
+                    batch = std::move(workQueue.front());
+                    workQueue.pop();
                 }
                 
-                if (!batch.empty()) {
+                try {
                     // Process batch
-                    auto result = processor(batch);
-                    totalProcessed += batch.size();
+                    Batch result;
+                    processor(batch.lines, result.lines);
+                    result.charge = batch.charge;
+                    result.sequence = batch.sequence;
+                    totalProcessed += batch.lines.size();
+                    
+                    // Release the input lines, all at once, before queueing the result
+                    batch.lines = LineBlock();
                     
                     // Put result
                     {
@@ -421,20 +565,50 @@ size_t ParallelStreamProcessor::processFile(
                         resultQueue.push(std::move(result));
                     }
                     resultCv.notify_one();
+                } catch (...) {
+                    fail(std::current_exception());
+                    break;
                 }
             }
         });
     }
     
     // Consumer thread (writer)
+    size_t writtenLines = 0;
     std::thread consumer([&]() {
-        std::vector<char> buffer(config_.bufferSize);
-        output.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+        double lastProgress = 0.0;
+        
+        // Finished batches waiting for an earlier sequence number
+        std::map<size_t, Batch> reorderBuffer;
+        size_t nextSequence = 0;
         
-        size_t writtenLines = 0;
+        auto writeBatch = [&](Batch& result) {
+            if (sequentialStage && !aborted) {
+                LineBlock staged;
+                sequentialStage(result.lines, staged);
+                result.lines = std::move(staged);
+            }
+            
+            // Write result; every line of the block is already followed by its newline
+            if (output && !aborted) {
+                std::string_view text = result.lines.text();
+                output->write(text.data(), static_cast<std::streamsize>(text.size()));
+            }
+            writtenLines += result.lines.size();
+            result.lines = LineBlock();
+            
+            // Return the batch's share of the memory budget
+            {
+                std::lock_guard<std::mutex> lock(budgetMutex);
+                bufferedBytes -= std::min(bufferedBytes, result.charge);
+                lineMemory.set(bufferedBytes);
+                writtenBatches++;
+            }
+            budgetCv.notify_all();
+        };
         
         while (true) {
-            std::vector<std::string> result;
+            Batch result;
             
             // Get result
             {
@@ -445,40 +619,66 @@ size_t ParallelStreamProcessor::processFile(
                     break;
                 }
                 
-                if (!resultQueue.empty()) {
-                    result = std::move(resultQueue.front());
-                    resultQueue.pop();
-                }
+                result = std::move(resultQueue.front());
+                resultQueue.pop();
             }
             
-            // Write result
-            for (const auto& line : result) {
-                if (!line.empty()) {
-                    output << line << '\n';
-                    writtenLines++;
+            try {
+                if (!preserveOrder) {
+                    writeBatch(result);
+                } else {
+                    // Hold the batch until every earlier one has been written
+                    size_t sequence = result.sequence;
+                    reorderBuffer.emplace(sequence, std::move(result));
+                    peakReorderBatches = std::max(peakReorderBatches, reorderBuffer.size());
+                    
+                    auto next = reorderBuffer.begin();
+                    while (next != reorderBuffer.end() && next->first == nextSequence) {
+                        writeBatch(next->second);
+                        next = reorderBuffer.erase(next);
+                        nextSequence++;
+                    }
                 }
+            } catch (...) {
+                fail(std::current_exception());
             }
             
             // Report progress
-            if (progressCallback && fileSize > 0 && writtenLines % 1000 == 0) {
-                double progress = static_cast<double>(totalProcessed.load()) / (fileSize / 50); // Rough estimate
-                progressCallback(std::min(progress, 0.95)); // Cap at 95% until completion
+            if (progressCallback && totalBytes > 0) {
+                double progress = static_cast<double>(bytesConsumed.load()) / totalBytes;
+                progress = std::min(progress, 0.99); // Hold back 100% until completion
+                if (progress > lastProgress) {
+                    progressCallback(progress);
+                    lastProgress = progress;
+                }
             }
         }
     });
     
-    // Wait for completion
+    // Wait for completion; waiting runs workers the pool has not started,
+    // which drain the queue until the producer is done
+    workers.wait();
     producer.join();
     
-    for (auto& worker : workers) {
-        worker.join();
+    {
+        std::lock_guard<std::mutex> lock(resultMutex);
+        processingFinished = true;
     }
-    
-    processingFinished = true;
     resultCv.notify_all();
     consumer.join();
     
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    
+    if (output) {
+        output->flush();
+    }
+    
     totalLines_ = totalProcessed;
+    outputLines_ = writtenLines;
+    peakBufferedBytes_ = peakBufferedBytes;
+    peakReorderBatches_ = peakReorderBatches;
     
     auto endTime = std::chrono::high_resolution_clock::now();
     processingTimeMs_ = std::chrono::duration_cast<std::chrono::milliseconds>(endTime - startTime).count();
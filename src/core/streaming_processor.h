@@ -6,10 +6,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
+#include <iterator>
 #include <memory>
 #include <fstream>
+#include <istream>
+#include <ostream>
 #include <deque>
 
 namespace suzume {
@@ -24,10 +28,93 @@ struct StreamingConfig {
     size_t maxMemoryUsage = 100 * 1024 * 1024; // 100MB max memory
     bool enableCompression = false;         // Enable compression for temporary files
     std::string tempDir = "/tmp";          // Temporary directory
+    bool preserveOrder = false;             // Write parallel results in input order
+    size_t reorderWindow = 0;               // Max batches in flight when preserving order (0 = 4 per thread)
+    bool numaAware = false;                 // Pin parallel workers to CPUs node by node
     
     StreamingConfig() = default;
 };
 
+/**
+ * @brief Lines of one batch stored back to back in a single buffer
+ *
+ * A batch of separately allocated strings costs one allocation per line,
+ * made by the thread that reads it and freed by the worker or writer that
+ * finishes it, which is where the allocator's arenas contend under many
+ * threads. A block needs a few allocations per batch, all released at once
+ * when the batch is done, and the writer writes it with one call.
+ */
+class LineBlock {
+public:
+    /**
+     * @brief Iterator over the lines, as views into the block
+     */
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = std::string_view;
+
+        const_iterator(const LineBlock* block, size_t index) : block_(block), index_(index) {}
+        std::string_view operator*() const { return (*block_)[index_]; }
+        const_iterator& operator++() { ++index_; return *this; }
+        const_iterator operator++(int) { const_iterator previous = *this; ++index_; return previous; }
+        bool operator==(const const_iterator& other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator& other) const { return index_ != other.index_; }
+
+    private:
+        const LineBlock* block_;
+        size_t index_;
+    };
+
+    /**
+     * @brief Reserve room for lines
+     * @param bytes Bytes of the lines, newlines included
+     * @param lines Number of lines
+     */
+    void reserve(size_t bytes, size_t lines) {
+        text_.reserve(bytes);
+        ends_.reserve(lines);
+    }
+
+    /**
+     * @brief Append a line
+     * @param line Line without its newline
+     */
+    void push_back(std::string_view line) {
+        text_.append(line);
+        ends_.push_back(text_.size());
+        text_.push_back('\n');
+    }
+
+    /**
+     * @brief Get a line
+     * @param index Line index
+     * @return std::string_view Line without its newline, valid until the block changes
+     */
+    std::string_view operator[](size_t index) const {
+        size_t begin = index == 0 ? 0 : ends_[index - 1] + 1;
+        return std::string_view(text_.data() + begin, ends_[index] - begin);
+    }
+
+    size_t size() const { return ends_.size(); }
+    bool empty() const { return ends_.empty(); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, ends_.size()); }
+
+    /**
+     * @brief Get the lines as written out
+     * @return std::string_view Every line followed by a newline
+     */
+    std::string_view text() const { return text_; }
+
+private:
+    std::string text_;
+    std::vector<size_t> ends_;  // End of each line in text_, before its newline
+};
+
 /**
  * @brief High-performance streaming line processor
  * 
@@ -155,6 +242,21 @@ public:
      * @return True if mapped
      */
     bool isMapped() const { return mapped_; }
+
+    /**
+     * @brief Get the mapped file contents
+     * @return Pointer to the first byte, or nullptr if not mapped
+     */
+    const char* data() const { return static_cast<const char*>(mappedData_); }
+
+    /**
+     * @brief Advise the kernel that the mapping is read front to back
+     *
+     * Asks for aggressive read-ahead and, where supported, transparent huge
+     * pages. Both are hints; the call does nothing if the file is not mapped
+     * or the kernel declines.
+     */
+    void adviseSequential();
     
 private:
     void unmap();
@@ -199,17 +301,101 @@ public:
         const StreamingLineProcessor::ProgressCallback& progressCallback = nullptr
     );
     
+    /**
+     * @brief Process an already opened stream with parallel workers
+     *
+     * Batches are cut at config.batchSize lines or at a byte limit derived
+     * from config.maxMemoryUsage, and the reader blocks while the batches in
+     * flight (queued, being processed or waiting to be written) would exceed
+     * that budget. Memory therefore stays bounded regardless of input size.
+     *
+     * With config.preserveOrder, every batch carries a sequence number and
+     * the writer holds finished batches in a reorder buffer until all earlier
+     * ones are written, so output follows input order. The reader never runs
+     * more than config.reorderWindow batches ahead of the writer.
+     *
+     * @param input Input stream
+     * @param output Output stream (nullptr discards the processed lines)
+     * @param processor Batch processing function (must be thread-safe)
+     * @param progressCallback Optional progress callback
+     * @param totalBytes Total input size for progress reporting (0 = unknown)
+     * @param sequentialStage Optional function applied by the writer thread to
+     *        each processed batch before it is written; with preserveOrder it
+     *        sees the batches in input order (need not be thread-safe)
+     * @return Number of lines processed
+     */
+    size_t processStream(
+        std::istream& input,
+        std::ostream* output,
+        const StreamingLineProcessor::BatchProcessor& processor,
+        const StreamingLineProcessor::ProgressCallback& progressCallback = nullptr,
+        size_t totalBytes = 0,
+        const StreamingLineProcessor::BatchProcessor& sequentialStage = nullptr
+    );
+
+    /**
+     * @brief Block processing function: appends the lines to write for a batch to the output block
+     */
+    using BlockProcessor = std::function<void(const LineBlock& batch, LineBlock& output)>;
+
+    /**
+     * @brief Process an already opened stream, batch by batch in line blocks
+     *
+     * Works like processStream(), but batches and their results are line
+     * blocks, so reading, processing and writing a batch allocate per batch
+     * rather than per line. processStream() runs on top of it.
+     *
+     * @param input Input stream
+     * @param output Output stream (nullptr discards the processed lines)
+     * @param processor Block processing function (must be thread-safe)
+     * @param progressCallback Optional progress callback
+     * @param totalBytes Total input size for progress reporting (0 = unknown)
+     * @param sequentialStage Optional function applied by the writer thread to
+     *        each processed block before it is written, in input order with
+     *        preserveOrder (need not be thread-safe)
+     * @return Number of lines processed
+     */
+    size_t processStreamBlocks(
+        std::istream& input,
+        std::ostream* output,
+        const BlockProcessor& processor,
+        const StreamingLineProcessor::ProgressCallback& progressCallback = nullptr,
+        size_t totalBytes = 0,
+        const BlockProcessor& sequentialStage = nullptr
+    );
+    
     /**
      * @brief Get processing statistics
      * @return Tuple of (total_lines, processing_time_ms, threads_used)
      */
     std::tuple<size_t, size_t, size_t> getStats() const;
     
+    /**
+     * @brief Get number of non-empty lines written by the last run
+     * @return Output line count
+     */
+    size_t getOutputLines() const { return outputLines_; }
+    
+    /**
+     * @brief Get the largest number of bytes held in flight by the last run
+     * @return Peak buffered bytes (estimated)
+     */
+    size_t getPeakBufferedBytes() const { return peakBufferedBytes_; }
+    
+    /**
+     * @brief Get the largest number of finished batches held for reordering by the last run
+     * @return Peak reorder buffer size in batches (0 unless preserveOrder is set)
+     */
+    size_t getPeakReorderBatches() const { return peakReorderBatches_; }
+    
 private:
     size_t numThreads_;
     StreamingConfig config_;
     size_t totalLines_;
     size_t processingTimeMs_;
+    size_t outputLines_;
+    size_t peakBufferedBytes_;
+    size_t peakReorderBatches_;
 };
 
 } // namespace core
@@ -0,0 +1,340 @@
+/**
+ * @file suffix_array.cpp
+ * @brief Implementation of the SA-IS suffix array
+ */
+
+#include "core/suffix_array.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <stdexcept>
+#include "core/output_writer.h"
+#include "xxhash.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/**
+ * @brief Sort short strings by comparing suffixes directly
+ */
+template <typename Index, typename Symbols>
+std::vector<Index> sortNaive(const Symbols& s, Index n) {
+    std::vector<Index> sa(static_cast<size_t>(n));
+    for (Index i = 0; i < n; ++i) {
+        sa[i] = i;
+    }
+    std::sort(sa.begin(), sa.end(), [&](Index a, Index b) {
+        while (a < n && b < n) {
+            if (s[a] != s[b]) {
+                return s[a] < s[b];
+            }
+            ++a;
+            ++b;
+        }
+        return a == n;
+    });
+    return sa;
+}
+
+/**
+ * @brief SA-IS suffix sorting
+ *
+ * Classifies suffixes as S or L, sorts the LMS substrings by induced
+ * sorting, names them, recurses on the reduced string when names are not
+ * unique, and induces the final order from the sorted LMS suffixes.
+ *
+ * @tparam Index Signed position type
+ * @tparam Symbols Random-access sequence of symbols in [0, upper]
+ * @param s Input symbols
+ * @param n Length of s
+ * @param upper Largest symbol value
+ * @return std::vector<Index> Suffix array
+ */
+template <typename Index, typename Symbols>
+std::vector<Index> sais(const Symbols& s, Index n, Index upper) {
+    if (n < 16) {
+        return sortNaive<Index>(s, n);
+    }
+
+    const size_t size = static_cast<size_t>(n);
+    const size_t buckets = static_cast<size_t>(upper) + 1;
+    std::vector<Index> sa(size);
+
+    // S-type: smaller than the next suffix
+    std::vector<bool> stype(size, false);
+    for (Index i = n - 2; i >= 0; --i) {
+        stype[i] = s[i] == s[i + 1] ? stype[i + 1] : s[i] < s[i + 1];
+    }
+
+    // Bucket starts: L-type suffixes first, then S-type, per symbol
+    std::vector<Index> sumL(buckets + 1, 0);
+    std::vector<Index> sumS(buckets + 1, 0);
+    for (Index i = 0; i < n; ++i) {
+        if (!stype[i]) {
+            sumS[s[i]]++;
+        } else {
+            sumL[s[i] + 1]++;
+        }
+    }
+    for (size_t c = 0; c < buckets; ++c) {
+        sumS[c] += sumL[c];
+        sumL[c + 1] += sumS[c];
+    }
+
+    auto induce = [&](const std::vector<Index>& lms) {
+        std::fill(sa.begin(), sa.end(), Index(-1));
+        std::vector<Index> head(buckets);
+        std::copy(sumS.begin(), sumS.begin() + buckets, head.begin());
+        for (Index d : lms) {
+            if (d != n) {
+                sa[head[s[d]]++] = d;
+            }
+        }
+        std::copy(sumL.begin(), sumL.begin() + buckets, head.begin());
+        sa[head[s[n - 1]]++] = n - 1;
+        for (size_t i = 0; i < size; ++i) {
+            Index v = sa[i];
+            if (v >= 1 && !stype[v - 1]) {
+                sa[head[s[v - 1]]++] = v - 1;
+            }
+        }
+        std::copy(sumL.begin(), sumL.begin() + buckets, head.begin());
+        for (size_t i = size; i-- > 0;) {
+            Index v = sa[i];
+            if (v >= 1 && stype[v - 1]) {
+                sa[--head[s[v - 1] + 1]] = v - 1;
+            }
+        }
+    };
+
+    std::vector<Index> lmsIndex(size + 1, Index(-1));
+    std::vector<Index> lms;
+    for (Index i = 1; i < n; ++i) {
+        if (!stype[i - 1] && stype[i]) {
+            lmsIndex[i] = static_cast<Index>(lms.size());
+            lms.push_back(i);
+        }
+    }
+    const Index m = static_cast<Index>(lms.size());
+
+    induce(lms);
+    if (m == 0) {
+        return sa;
+    }
+
+    // Name the LMS substrings in sorted order; equal substrings share a name
+    std::vector<Index> sortedLms;
+    sortedLms.reserve(lms.size());
+    for (Index v : sa) {
+        if (lmsIndex[v] != -1) {
+            sortedLms.push_back(v);
+        }
+    }
+    std::vector<Index> reduced(lms.size());
+    Index names = 0;
+    reduced[lmsIndex[sortedLms[0]]] = 0;
+    for (Index i = 1; i < m; ++i) {
+        Index l = sortedLms[i - 1];
+        Index r = sortedLms[i];
+        Index endL = lmsIndex[l] + 1 < m ? lms[lmsIndex[l] + 1] : n;
+        Index endR = lmsIndex[r] + 1 < m ? lms[lmsIndex[r] + 1] : n;
+        bool same = true;
+        if (endL - l != endR - r) {
+            same = false;
+        } else {
+            while (l < endL && s[l] == s[r]) {
+                ++l;
+                ++r;
+            }
+            if (l == n || s[l] != s[r]) {
+                same = false;
+            }
+        }
+        if (!same) {
+            ++names;
+        }
+        reduced[lmsIndex[sortedLms[i]]] = names;
+    }
+    lmsIndex = std::vector<Index>();
+
+    std::vector<Index> reducedSa = sais<Index>(reduced, m, names);
+    for (Index i = 0; i < m; ++i) {
+        sortedLms[i] = lms[reducedSa[i]];
+    }
+    induce(sortedLms);
+    return sa;
+}
+
+/// Bytes of a text as unsigned symbols
+struct ByteSymbols {
+    const unsigned char* data;
+    template <typename Index>
+    uint32_t operator[](Index i) const { return data[i]; }
+};
+
+} // namespace
+
+SuffixArray::SuffixArray(std::string_view text)
+    : text_(text)
+{
+    ByteSymbols symbols{reinterpret_cast<const unsigned char*>(text.data())};
+    if (text.size() < static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+        smallPositions_ = sais<int32_t>(symbols, static_cast<int32_t>(text.size()), 255);
+        small_ = smallPositions_.data();
+    } else {
+        largePositions_ = sais<int64_t>(symbols, static_cast<int64_t>(text.size()), 255);
+        large_ = largePositions_.data();
+    }
+    charge_.set(smallPositions_.capacity() * sizeof(int32_t) + largePositions_.capacity() * sizeof(int64_t));
+}
+
+namespace {
+
+constexpr char kSuffixArrayMagic[8] = {'S', 'Z', 'S', 'U', 'F', 'A', 'R', '1'};
+constexpr uint32_t kSuffixArrayVersion = 1;
+constexpr uint32_t kByteOrderMark = 0x01020304;
+
+/**
+ * @brief Header of a suffix array file, in host byte order
+ */
+struct SuffixArrayHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t width;
+    uint64_t textSize;
+    uint64_t textHash;
+    uint32_t byteOrder;
+    uint32_t reserved;
+};
+static_assert(sizeof(SuffixArrayHeader) == 40, "Suffix array header must be packed");
+
+} // namespace
+
+std::unique_ptr<SuffixArray> SuffixArray::open(std::string_view text, const std::string& path) {
+    std::error_code error;
+    if (!std::filesystem::is_regular_file(path, error)) {
+        return nullptr;
+    }
+    auto mapping = std::make_unique<MemoryMappedProcessor>(path);
+    if (!mapping->isMapped() || mapping->getFileSize() < sizeof(SuffixArrayHeader)) {
+        return nullptr;
+    }
+
+    SuffixArrayHeader header;
+    std::memcpy(&header, mapping->data(), sizeof(header));
+    uint32_t width = text.size() < static_cast<size_t>(std::numeric_limits<int32_t>::max()) ? 4 : 8;
+    if (std::memcmp(header.magic, kSuffixArrayMagic, sizeof(kSuffixArrayMagic)) != 0 ||
+        header.version != kSuffixArrayVersion || header.byteOrder != kByteOrderMark ||
+        header.width != width || header.textSize != text.size() ||
+        mapping->getFileSize() != sizeof(SuffixArrayHeader) + text.size() * width ||
+        header.textHash != XXH3_64bits(text.data(), text.size())) {
+        return nullptr;
+    }
+
+    // The positions follow the header at an 8-byte aligned offset of the mapping
+    std::unique_ptr<SuffixArray> array(new SuffixArray(text, nullptr));
+    const char* positions = mapping->data() + sizeof(SuffixArrayHeader);
+    if (width == 4) {
+        array->small_ = reinterpret_cast<const int32_t*>(positions);
+    } else {
+        array->large_ = reinterpret_cast<const int64_t*>(positions);
+    }
+    array->mapping_ = std::move(mapping);
+    return array;
+}
+
+void SuffixArray::write(const std::string& path) const {
+    SuffixArrayHeader header{};
+    std::memcpy(header.magic, kSuffixArrayMagic, sizeof(kSuffixArrayMagic));
+    header.version = kSuffixArrayVersion;
+    header.width = small_ || !large_ ? 4 : 8;
+    header.textSize = text_.size();
+    header.textHash = XXH3_64bits(text_.data(), text_.size());
+    header.byteOrder = kByteOrderMark;
+
+    std::string temporary = path + ".tmp";
+    prepareOutputPath(temporary);
+    {
+        OutputWriter output(temporary);
+        output.write(std::string_view(reinterpret_cast<const char*>(&header), sizeof(header)));
+        const char* positions = small_ ? reinterpret_cast<const char*>(small_)
+                                       : reinterpret_cast<const char*>(large_);
+        if (positions) {
+            output.write(std::string_view(positions, text_.size() * header.width));
+        }
+        output.close();
+    }
+    std::error_code error;
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+        throw std::runtime_error("Failed to write suffix array: " + path);
+    }
+}
+
+size_t SuffixArray::bound(std::string_view pattern, bool upper) const {
+    // Every suffix between lo - 1 and hi shares min(lcpLo, lcpHi) bytes with the pattern
+    size_t lo = 0;
+    size_t hi = text_.size();
+    size_t lcpLo = 0;
+    size_t lcpHi = 0;
+    const size_t m = pattern.size();
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        size_t start = position(mid);
+        size_t k = std::min(lcpLo, lcpHi);
+        size_t limit = std::min(m, text_.size() - start);
+        while (k < limit && text_[start + k] == pattern[k]) {
+            ++k;
+        }
+
+        // Suffix is below the pattern, or has it as a prefix when looking for the upper bound
+        bool below;
+        if (k == m) {
+            below = upper;
+        } else if (k == limit) {
+            below = true;
+        } else {
+            below = static_cast<unsigned char>(text_[start + k]) < static_cast<unsigned char>(pattern[k]);
+        }
+
+        if (below) {
+            lo = mid + 1;
+            lcpLo = k;
+        } else {
+            hi = mid;
+            lcpHi = k;
+        }
+    }
+    return lo;
+}
+
+std::pair<size_t, size_t> SuffixArray::range(std::string_view pattern) const {
+    if (pattern.empty()) {
+        return {0, text_.size()};
+    }
+    size_t first = bound(pattern, false);
+    return {first, std::max(first, bound(pattern, true))};
+}
+
+size_t SuffixArray::count(std::string_view pattern) const {
+    auto [first, last] = range(pattern);
+    return last - first;
+}
+
+std::vector<size_t> SuffixArray::positions(std::string_view pattern) const {
+    auto [first, last] = range(pattern);
+    std::vector<size_t> result;
+    result.reserve(last - first);
+    for (size_t rank = first; rank < last; ++rank) {
+        result.push_back(position(rank));
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+} // namespace core
+} // namespace suzume
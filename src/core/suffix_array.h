@@ -0,0 +1,127 @@
+/**
+ * @file suffix_array.h
+ * @brief Suffix array over a byte string, built with SA-IS
+ */
+
+#ifndef SUZUME_CORE_SUFFIX_ARRAY_H_
+#define SUZUME_CORE_SUFFIX_ARRAY_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+#include "core/memory_accounting.h"
+#include "core/streaming_processor.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Sorted suffixes of a text for substring queries
+ *
+ * Built in linear time with SA-IS (induced sorting). Texts under 2 GiB
+ * use 32-bit positions, larger ones 64-bit. A query finds the rank range
+ * of the suffixes starting with the pattern by binary search, skipping the
+ * prefix already known to match both bounds, so a lookup costs about
+ * O(m + log n) byte comparisons for a pattern of m bytes; listing the
+ * matches then costs O(occurrences).
+ *
+ * The text is not copied and must outlive the suffix array.
+ *
+ * A built array can be written to a file and mapped on later runs over
+ * the same text (see write() and open()):
+ *
+ *   header     "SZSUFAR1", uint32 version, uint32 position width (4 or 8),
+ *              uint64 text bytes, uint64 XXH3 hash of the text, uint32
+ *              byte-order mark, uint32 reserved
+ *   positions  one position of the position width per suffix, in rank order
+ *
+ * Positions are stored in host byte order so they are read in place; a
+ * file from a host of the other byte order is treated as stale.
+ */
+class SuffixArray {
+public:
+    /**
+     * @brief Build the suffix array of a text
+     * @param text Text to index
+     */
+    explicit SuffixArray(std::string_view text);
+
+    /**
+     * @brief Map a suffix array written by write() for the same text
+     *
+     * @param text Text the array was built over
+     * @param path Suffix array file
+     * @return std::unique_ptr<SuffixArray> The mapped array, or nullptr if the
+     *         file is missing, of another version or built over another text
+     */
+    static std::unique_ptr<SuffixArray> open(std::string_view text, const std::string& path);
+
+    /**
+     * @brief Write the suffix array to a file for open()
+     *
+     * The file is written next to its final path and renamed into place,
+     * so a concurrent open() sees either no file or a whole one.
+     *
+     * @param path Suffix array file
+     * @throws std::runtime_error If the file cannot be written
+     */
+    void write(const std::string& path) const;
+
+    /**
+     * @brief Get the rank range of the suffixes starting with a pattern
+     * @param pattern Pattern to search for (empty matches every suffix)
+     * @return std::pair<size_t, size_t> Ranks [first, second)
+     */
+    std::pair<size_t, size_t> range(std::string_view pattern) const;
+
+    /**
+     * @brief Count the (possibly overlapping) occurrences of a pattern
+     * @param pattern Pattern to search for
+     * @return size_t Occurrence count
+     */
+    size_t count(std::string_view pattern) const;
+
+    /**
+     * @brief Get the positions of a pattern in the text
+     * @param pattern Pattern to search for
+     * @return std::vector<size_t> Byte positions of every occurrence, ascending
+     */
+    std::vector<size_t> positions(std::string_view pattern) const;
+
+    /**
+     * @brief Get the text position of the suffix at a rank
+     * @param rank Rank in [0, size())
+     * @return size_t Byte position
+     */
+    size_t position(size_t rank) const {
+        return small_ ? static_cast<size_t>(small_[rank]) : static_cast<size_t>(large_[rank]);
+    }
+
+    /**
+     * @brief Get the number of suffixes
+     * @return size_t Text length in bytes
+     */
+    size_t size() const { return text_.size(); }
+
+private:
+    explicit SuffixArray(std::string_view text, std::nullptr_t) : text_(text) {}
+
+    size_t bound(std::string_view pattern, bool upper) const;
+
+    std::string_view text_;
+    const int32_t* small_ = nullptr;            // Positions of texts under 2 GiB
+    const int64_t* large_ = nullptr;            // Positions of larger texts
+    std::vector<int32_t> smallPositions_;       // Built positions, unless mapped
+    std::vector<int64_t> largePositions_;
+    std::unique_ptr<MemoryMappedProcessor> mapping_; // Mapped positions, if opened
+    MemoryCharge charge_{MemorySubsystem::TextIndex}; // Built positions only; mapped ones are page cache
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_SUFFIX_ARRAY_H_
@@ -4,6 +4,9 @@
  */
 
 #include "core/text_utils.h"
+#include "core/line_scan.h"
+#include "core/sampling.h"
+#include "core/streaming_processor.h"
 #include <algorithm>
 #include <iostream>
 #include <fstream>
@@ -19,6 +22,10 @@
 #include <unicode/unistr.h>
 #include <unicode/normalizer2.h>
 #include <unicode/uniset.h>
+#include <unicode/locid.h>
+#include <unicode/utf8.h>
+#include <unicode/utf16.h>
+#include <unicode/ustring.h>
 #ifndef EMSCRIPTEN
 #include <unicode/ustream.h>
 #include <unicode/ustdio.h>
@@ -119,14 +126,15 @@ namespace {
     }
 
     // Check if a string is emoji-only
-    bool isEmojiOnly(const std::string& text) {
+    bool isEmojiOnly(std::string_view text) {
         if (text.empty()) {
             return false;
         }
 
         try {
             // Convert to ICU UnicodeString
-            UnicodeString ustr = UnicodeString::fromUTF8(text);
+            UnicodeString ustr = UnicodeString::fromUTF8(
+                icu::StringPiece(text.data(), static_cast<int32_t>(text.size())));
             if (ustr.isBogus()) {
                 return false; // Invalid UTF-8
             }
@@ -169,273 +177,322 @@ namespace {
         }
     }
 
-    // Split a string by delimiter
-    std::vector<std::string> split(const std::string& str, char delimiter) {
-        std::vector<std::string> tokens;
-
-        if (str.empty()) {
-            // For empty strings, return an array containing an empty string
-            tokens.push_back("");
-            return tokens;
-        }
-
-        size_t start = 0;
-        size_t end = 0;
-
-        // Find each occurrence of the delimiter
-        while ((end = str.find(delimiter, start)) != std::string::npos) {
-            // Add the substring from start to end
-            tokens.push_back(str.substr(start, end - start));
-            start = end + 1;
+    // Get the ICU normalizer for a form (nullptr on failure)
+    const Normalizer2* getNormalizer(suzume::NormalizationForm form) {
+        UErrorCode status = U_ZERO_ERROR;
+        const Normalizer2* normalizer = (form == suzume::NormalizationForm::NFC)
+            ? Normalizer2::getNFCInstance(status)
+            : Normalizer2::getNFKCInstance(status);
+        if (U_FAILURE(status)) {
+#ifndef EMSCRIPTEN
+            std::cerr << "Failed to get normalizer: " << u_errorName(status) << std::endl;
+#endif
+            return nullptr;
         }
+        return normalizer;
+    }
 
-        // Add the last token (or empty string if the delimiter was the last character)
-        tokens.push_back(str.substr(start));
-
-        return tokens;
+    // Whether ICU lowercases ASCII letters to ASCII in the default locale
+    // (Turkish and Azerbaijani map 'I' to dotless i)
+    bool asciiLowercaseMatchesLocale() {
+        static const bool matches = []() {
+            const char* language = icu::Locale::getDefault().getLanguage();
+            return std::strcmp(language, "tr") != 0 && std::strcmp(language, "az") != 0;
+        }();
+        return matches;
     }
 
-    // Strip control and format characters
-    static std::string stripControl(const std::string& in) {
-        UnicodeString u = UnicodeString::fromUTF8(in);
-        UnicodeString out;
-        for (int32_t i = 0; i < u.length();) {
-            UChar32 cp = u.char32At(i);
-            // Skip Cc(Other,Control) and Cf(Other,Format) characters
-            if (u_charType(cp) != U_CONTROL_CHAR &&
-                u_charType(cp) != U_FORMAT_CHAR) {
-                out.append(cp);
+    // Check whether a byte range is pure ASCII
+    bool isAsciiRange(const char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            if (static_cast<unsigned char>(data[i]) >= 0x80) {
+                return false;
             }
-            i += U16_LENGTH(cp);
         }
-        std::string utf8;
-        out.toUTF8String(utf8);
-        return utf8;
+        return true;
     }
 
-    // Unicode normalization implementation
-    std::string normalizeText(const std::string& text, suzume::NormalizationForm form) {
-#ifdef EMSCRIPTEN
-        // Simplified implementation for WebAssembly
-        if (text.empty()) {
-            return text;
-        }
-
-        try {
-            // Convert to ICU UnicodeString
-            UnicodeString ustr = UnicodeString::fromUTF8(text);
-            if (ustr.isBogus()) {
-                return text; // Return original text if invalid UTF-8
-            }
-
-            // Get the appropriate normalizer
-            UErrorCode status = U_ZERO_ERROR;
-            const Normalizer2* normalizer = nullptr;
-
-            if (form == suzume::NormalizationForm::NFKC) {
-                normalizer = Normalizer2::getNFKCInstance(status);
-            } else if (form == suzume::NormalizationForm::NFC) {
-                normalizer = Normalizer2::getNFCInstance(status);
-            }
-
-            if (U_FAILURE(status) || normalizer == nullptr) {
-                return text;
-            }
+    // Count code points up to a limit without converting to UTF-16
+    int32_t countCodePoints(std::string_view text, int32_t limit) {
+        const uint8_t* data = reinterpret_cast<const uint8_t*>(text.data());
+        int32_t length = static_cast<int32_t>(text.size());
+        int32_t count = 0;
+        for (int32_t i = 0; i < length && count < limit; ++count) {
+            UChar32 c;
+            U8_NEXT(data, i, length, c);
+            (void)c;
+        }
+        return count;
+    }
 
-            // Perform normalization
-            UnicodeString normalized = normalizer->normalize(ustr, status);
-            if (U_FAILURE(status)) {
-                return text;
+    // Normalize a pure-ASCII field without ICU
+    // NFKC and NFC leave ASCII unchanged, the only ASCII control characters (Cc)
+    // are 0x00-0x1F and 0x7F, and there are no ASCII format characters (Cf)
+    void normalizeAsciiField(const char* data, size_t length,
+                             suzume::NormalizationForm form, std::string& out) {
+        size_t fieldStart = out.size();
+        bool hasDigit = false;
+        for (size_t i = 0; i < length; ++i) {
+            unsigned char c = static_cast<unsigned char>(data[i]);
+            if (c < 0x20 || c == 0x7F) {
+                continue;
             }
-
-            // Convert back to UTF-8
-            std::string result;
-            normalized.toUTF8String(result);
-            return result;
-        } catch (...) {
-            return text;
-        }
-#else
-        // Full implementation for native platforms
-        if (text.empty()) {
-            return text;
+            hasDigit = hasDigit || (c >= '0' && c <= '9');
+            out.push_back(static_cast<char>(c));
         }
 
-        try {
-            // Ensure initialization
-            ensureInitialized();
-
-            // Convert to ICU UnicodeString
-            UnicodeString ustr = UnicodeString::fromUTF8(text);
-            if (ustr.isBogus()) {
-                return text; // Return original text if invalid UTF-8
+        // Skip lowercase conversion for fields that contain numbers or when using NFC form
+        if (form != suzume::NormalizationForm::NFC && !hasDigit) {
+            for (size_t i = fieldStart; i < out.size(); ++i) {
+                if (out[i] >= 'A' && out[i] <= 'Z') {
+                    out[i] = static_cast<char>(out[i] + ('a' - 'A'));
+                }
             }
+        }
+    }
 
-            // Get the appropriate normalizer
-            UErrorCode status = U_ZERO_ERROR;
-            const Normalizer2* normalizer = nullptr;
-
-            if (form == suzume::NormalizationForm::NFKC) {
-                normalizer = Normalizer2::getNFKCInstance(status);
-            } else if (form == suzume::NormalizationForm::NFC) {
-                normalizer = Normalizer2::getNFCInstance(status);
-            }
+    // Per-thread UTF-16 buffers reused by every field the thread normalizes
+    struct NormalizationScratch {
+        UnicodeString text;
+        UnicodeString normalized;
+    };
 
-            if (U_FAILURE(status) || normalizer == nullptr) {
-                std::cerr << "Failed to get normalizer: " << u_errorName(status) << std::endl;
-                return text;
-            }
+    NormalizationScratch& getScratch() {
+        thread_local NormalizationScratch scratch;
+        return scratch;
+    }
 
-            // Perform normalization
-            UnicodeString normalized = normalizer->normalize(ustr, status);
-            if (U_FAILURE(status)) {
-                std::cerr << "Normalization failed: " << u_errorName(status) << std::endl;
-                return text;
+    // Fused normalization kernel for non-ASCII fields
+    // Decodes the field once into a reusable UTF-16 buffer, runs NFKC/NFC,
+    // control stripping and lowercasing over that buffer, and encodes once
+    // straight into the output line. Returns false if the field normalizes
+    // to nothing.
+    bool normalizeUnicodeField(const char* data, size_t length,
+                               suzume::NormalizationForm form, std::string& out) {
+        NormalizationScratch& scratch = getScratch();
+        UnicodeString& text = scratch.text;
+        UErrorCode status = U_ZERO_ERROR;
+
+        // Decode (a UTF-16 string never needs more units than UTF-8 bytes)
+        int32_t inputLength = static_cast<int32_t>(length);
+        UChar* decodeBuffer = text.getBuffer(inputLength);
+        if (decodeBuffer == nullptr) {
+            throw std::bad_alloc();
+        }
+        int32_t decodedLength = 0;
+        u_strFromUTF8WithSub(decodeBuffer, inputLength, &decodedLength,
+                             data, inputLength, 0xFFFD, nullptr, &status);
+        text.releaseBuffer(U_SUCCESS(status) ? decodedLength : 0);
+
+        // Unicode normalization, skipped for the prefix ICU's quick check
+        // already proves normalized (usually the whole field)
+        const Normalizer2* normalizer = getNormalizer(form);
+        if (normalizer != nullptr) {
+            status = U_ZERO_ERROR;
+            int32_t spanEnd = normalizer->spanQuickCheckYes(text, status);
+            if (U_SUCCESS(status) && spanEnd < text.length()) {
+                UnicodeString& normalized = scratch.normalized;
+                normalized.setTo(text, 0, spanEnd);
+                normalizer->normalizeSecondAndAppend(normalized, text.tempSubString(spanEnd), status);
+                if (U_SUCCESS(status)) {
+                    text.swap(normalized);
+                }
+#ifndef EMSCRIPTEN
+                else {
+                    std::cerr << "Normalization failed: " << u_errorName(status) << std::endl;
+                }
+#endif
             }
-
-            // Convert back to UTF-8
-            std::string result;
-            normalized.toUTF8String(result);
-            return result;
-        } catch (const std::exception& e) {
-            std::cerr << "Error in normalizeText: " << e.what() << std::endl;
-            return text;
-        } catch (...) {
-            std::cerr << "Unknown error in normalizeText" << std::endl;
-            return text;
         }
-#endif
-    }
 
-    // Convert text to lowercase
-    std::string toLower(const std::string& text) {
-        if (text.empty()) {
-            return text;
+        if (text.isEmpty()) {
+            return false;
         }
 
-        try {
-            // Convert to ICU UnicodeString
-            UnicodeString ustr = UnicodeString::fromUTF8(text);
-            if (ustr.isBogus()) {
-                return text; // Return original text if invalid UTF-8
+        // Strip Cc(Other,Control) and Cf(Other,Format) characters in place
+        int32_t textLength = text.length();
+        UChar* units = text.getBuffer(textLength);
+        if (units == nullptr) {
+            throw std::bad_alloc();
+        }
+        int32_t readPos = 0;
+        int32_t writePos = 0;
+        bool hasDigit = false;
+        while (readPos < textLength) {
+            int32_t cpStart = readPos;
+            UChar32 cp;
+            U16_NEXT(units, readPos, textLength, cp);
+            int8_t type = u_charType(cp);
+            if (type == U_CONTROL_CHAR || type == U_FORMAT_CHAR) {
+                continue;
+            }
+            hasDigit = hasDigit || (cp >= '0' && cp <= '9');
+            while (cpStart < readPos) {
+                units[writePos++] = units[cpStart++];
             }
+        }
+        text.releaseBuffer(writePos);
 
-            // Perform lowercase conversion
-            ustr.toLower();
+        // Skip lowercase conversion for fields that contain numbers or when using NFC form
+        if (form != suzume::NormalizationForm::NFC && !hasDigit) {
+            text.toLower();
+        }
 
-            // Convert back to UTF-8
-            std::string result;
-            ustr.toUTF8String(result);
-            return result;
-        } catch (const std::exception& e) {
-            std::cerr << "Error in toLower: " << e.what() << std::endl;
-            return text; // Return original text on error
-        } catch (...) {
-            std::cerr << "Unknown error in toLower" << std::endl;
-            return text; // Return original text on error
+        // Encode once, appending directly to the output line
+        int32_t unitCount = text.length();
+        if (unitCount == 0) {
+            return true;
         }
+        size_t base = out.size();
+        out.resize(base + static_cast<size_t>(unitCount) * 3);
+        int32_t encodedLength = 0;
+        status = U_ZERO_ERROR;
+        u_strToUTF8WithSub(&out[base], unitCount * 3, &encodedLength,
+                           text.getBuffer(), unitCount, 0xFFFD, nullptr, &status);
+        out.resize(base + (U_SUCCESS(status) ? static_cast<size_t>(encodedLength) : 0));
+        return true;
     }
 }
 
-std::string normalizeLine(const std::string& line, suzume::NormalizationForm form) {
+bool normalizeLineInto(std::string_view line, suzume::NormalizationForm form, std::string& out) {
+    static const std::vector<uint32_t> everyColumn;
+    return normalizeLineInto(line, form, out, everyColumn);
+}
+
+bool normalizeLineInto(std::string_view line, suzume::NormalizationForm form, std::string& out,
+                       const std::vector<uint32_t>& columns) {
+    out.clear();
     try {
 
+        // Classify the whole line in one vectorized pass before touching ICU
+        LineScan scan = scanLine(line);
+
         // Processing based on specification:
         // 1. Exclude whitespace-only lines
-        bool isWhitespaceOnly = true;
-        for (char c : line) {
-            if (!std::isspace(static_cast<unsigned char>(c))) {
-                isWhitespaceOnly = false;
-                break;
-            }
-        }
-
-        if (isWhitespaceOnly) {
-            return ""; // Exclude whitespace-only lines
+        if (scan.whitespaceOnly) {
+            return false; // Exclude whitespace-only lines
         }
 
         // 2. Exclude lines with length ≤1 (count Unicode code points, not bytes)
-        UnicodeString ustr = UnicodeString::fromUTF8(line);
-
-        // Skip empty or single-character lines
-        if (ustr.countChar32() <= 1) {
-            return ""; // Skip empty or single-character lines
+        int32_t codePoints = scan.validUtf8 ? static_cast<int32_t>(std::min<size_t>(scan.codePoints, 2))
+                                            : countCodePoints(line, 2);
+        if (codePoints <= 1) {
+            return false; // Skip empty or single-character lines
         }
 
         // Comment exclusion removed to handle hashtags properly
 
         // 4. Exclude emoji-only lines
-        if (line.find('\t') == std::string::npos) {
+        if (!scan.hasTab) {
             if (line.length() >= 4 && (unsigned char)line[0] >= 0xF0) {
                 // 4-byte UTF-8 sequence (likely emoji)
                 if (isEmojiOnly(line)) {
-                    return ""; // Skip emoji-only lines
+                    return false; // Skip emoji-only lines
                 }
             }
         }
 
-        // Split by tab to preserve TSV structure
-        std::vector<std::string> fields;
-        try {
-            fields = split(line, '\t');
-        } catch (const std::exception& e) {
-            return "";
-        } catch (...) {
-            return "";
-        }
-
-        if (fields.empty()) {
-            return ""; // Skip empty fields
-        }
-
-        // Process each field separately
-        for (auto& field : fields) {
-            // Unicode normalization using ICU (both NFC and NFKC)
-            field = normalizeText(field, form);
+#ifndef EMSCRIPTEN
+        ensureInitialized();
+#endif
 
-            // Skip if normalization failed
-            if (field.empty() && !line.empty()) {
-                return "";
+        // Process each tab-separated field separately to preserve TSV structure
+        size_t fieldStart = 0;
+        uint32_t column = 1;
+        while (true) {
+            size_t fieldEnd = line.find('\t', fieldStart);
+            if (fieldEnd == std::string_view::npos) {
+                fieldEnd = line.length();
             }
 
-            // Strip control characters using ICU (safe for all Unicode)
-            field = stripControl(field);
+            const char* fieldData = line.data() + fieldStart;
+            size_t fieldLength = fieldEnd - fieldStart;
 
-            // Skip lowercase conversion for fields that contain numbers or when using NFC form
-            if (form != suzume::NormalizationForm::NFC &&
-                std::none_of(field.begin(), field.end(), ::isdigit)) {
-                // Use toLower for proper UTF-8 lowercase conversion
-                field = toLower(field);
+            // Empty fields exclude the whole line
+            if (fieldLength == 0) {
+                out.clear();
+                return false;
             }
-        }
 
-        // Reconstruct the line with tab separators
-        std::string normalizedLine;
-        normalizedLine.reserve(line.length() * 2);  // Reserve space for safety
+            // Tier 0: columns not selected pass through byte for byte
+            // Tier 1: pure ASCII needs no ICU at all
+            // Tier 2: everything else goes through the fused UTF-16 kernel
+            if (!columns.empty() && std::find(columns.begin(), columns.end(), column) == columns.end()) {
+                out.append(fieldData, fieldLength);
+            } else if ((scan.ascii || isAsciiRange(fieldData, fieldLength)) &&
+                (form == suzume::NormalizationForm::NFC || asciiLowercaseMatchesLocale())) {
+                normalizeAsciiField(fieldData, fieldLength, form, out);
+            } else if (!normalizeUnicodeField(fieldData, fieldLength, form, out)) {
+                out.clear();
+                return false;
+            }
 
-        for (size_t i = 0; i < fields.size(); ++i) {
-            normalizedLine += fields[i];
-            if (i < fields.size() - 1) {
-                normalizedLine += '\t';
+            if (fieldEnd == line.length()) {
+                break;
             }
+            out += '\t';
+            fieldStart = fieldEnd + 1;
+            column++;
         }
 
-        return normalizedLine;
+        return !out.empty();
     } catch (const std::bad_alloc&) {
         // Memory allocation failed - re-throw critical errors
         throw;
     } catch (const std::exception& e) {
         // Log other exceptions before returning empty string
         std::cerr << "Warning: Exception in normalizeLine: " << e.what() << std::endl;
-        return "";
+        out.clear();
+        return false;
     } catch (...) {
         // Log unknown exceptions
         std::cerr << "Warning: Unknown exception in normalizeLine" << std::endl;
-        return "";
+        out.clear();
+        return false;
+    }
+}
+
+std::string normalizeLine(const std::string& line, suzume::NormalizationForm form) {
+    std::string normalized;
+    normalized.reserve(line.length() + 16);
+    normalizeLineInto(line, form, normalized);
+    return normalized;
+}
+
+std::string_view selectColumns(std::string_view line, const std::vector<uint32_t>& columns, std::string& scratch) {
+    if (columns.empty()) {
+        return line;
+    }
+
+    // Field boundaries of the line; columns past the last field are empty
+    auto field = [line](uint32_t column) {
+        size_t start = 0;
+        for (uint32_t i = 1; i < column; ++i) {
+            start = line.find('\t', start);
+            if (start == std::string_view::npos) {
+                return std::string_view();
+            }
+            start++;
+        }
+        size_t end = line.find('\t', start);
+        return line.substr(start, end == std::string_view::npos ? std::string_view::npos : end - start);
+    };
+    if (columns.size() == 1) {
+        return field(columns.front());
+    }
+
+    scratch.clear();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (i > 0) {
+            scratch += '\t';
+        }
+        std::string_view value = field(columns[i]);
+        scratch.append(value.data(), value.size());
     }
+    return scratch;
 }
 
-bool shouldExcludeLine(const std::string& line, uint32_t minLength, uint32_t maxLength) {
+bool shouldExcludeLine(std::string_view line, uint32_t minLength, uint32_t maxLength) {
     // Skip empty lines
     if (line.empty()) {
         return true;
@@ -448,13 +505,10 @@ bool shouldExcludeLine(const std::string& line, uint32_t minLength, uint32_t max
 
     // Comment exclusion removed to handle hashtags properly
 
-    // Check for emoji-only lines
-    if (line.find('\t') == std::string::npos) {
-        if (line.length() >= 4 && (unsigned char)line[0] >= 0xF0) {
-            // This is likely a 4-byte UTF-8 sequence (emoji)
-            if (isEmojiOnly(line)) {
-                return true;
-            }
+    // Check for emoji-only lines (a leading 4-byte sequence, no tab)
+    if (line.length() >= 4 && (unsigned char)line[0] >= 0xF0 && !scanLine(line).hasTab) {
+        if (isEmojiOnly(line)) {
+            return true;
         }
     }
 
@@ -471,10 +525,42 @@ bool shouldExcludeLine(const std::string& line, uint32_t minLength, uint32_t max
 }
 
 // Backward compatibility wrapper
-bool shouldExcludeLine(const std::string& line) {
+bool shouldExcludeLine(std::string_view line) {
     return shouldExcludeLine(line, 0, 0);
 }
 
+std::string_view utf8Context(std::string_view text, size_t position, size_t codePoints, bool withinLine) {
+    auto isContinuation = [&](size_t i) {
+        return (static_cast<unsigned char>(text[i]) & 0xC0) == 0x80;
+    };
+    auto isLineEnd = [&](size_t i) {
+        return withinLine && (text[i] == '\n' || text[i] == '\r');
+    };
+
+    size_t center = std::min(position, text.size());
+    while (center > 0 && center < text.size() && isContinuation(center)) {
+        --center;
+    }
+
+    size_t start = center;
+    for (size_t i = 0; i < codePoints && start > 0 && !isLineEnd(start - 1); ++i) {
+        --start;
+        while (start > 0 && isContinuation(start)) {
+            --start;
+        }
+    }
+
+    size_t end = center;
+    for (size_t i = 0; i < codePoints && end < text.size() && !isLineEnd(end); ++i) {
+        ++end;
+        while (end < text.size() && isContinuation(end)) {
+            ++end;
+        }
+    }
+
+    return text.substr(start, end - start);
+}
+
 std::vector<std::string> generateNgrams(const std::string& text, int n) {
     std::vector<std::string> ngrams;
 
@@ -526,16 +612,14 @@ std::vector<std::string> generateNgrams(const std::string& text, int n) {
     }
 }
 
-uint64_t calculateHash(const std::string& str) {
+uint64_t calculateHash(std::string_view str) {
     return XXH64(str.data(), str.size(), 0);
 }
 
 bool isDuplicate(const std::string& str,
                 std::unordered_set<std::string>& uniqueSet,
                 double bloomFalsePositiveRate) {
-    // Simple implementation without Bloom filter for now
-    // In a real implementation, we would use a Bloom filter for initial check
-    // with the specified false positive rate
+    // Exact set; the false positive rate only applies to DedupFilter
     (void)bloomFalsePositiveRate; // Suppress unused parameter warning
 
     // For empty strings, always consider as duplicate
@@ -553,10 +637,29 @@ bool isDuplicate(const std::string& str,
     return false;
 }
 
+bool isDuplicate(const std::string& str, DedupFilter& filter) {
+    // For empty strings, always consider as duplicate
+    if (str.empty()) {
+        return true;
+    }
+
+    return !filter.insert(str);
+}
+
+bool isDuplicate(std::string_view str, ConcurrentDedupFilter& filter) {
+    // For empty strings, always consider as duplicate
+    if (str.empty()) {
+        return true;
+    }
+
+    return !filter.insert(str);
+}
+
 std::vector<std::string> sampleLines(
     const std::string& inputPath,
     size_t sampleSize,
-    unsigned int seed
+    unsigned int seed,
+    unsigned int numThreads
 ) {
     // Initialize result vector
     std::vector<std::string> result;
@@ -572,6 +675,14 @@ std::vector<std::string> sampleLines(
     }
 
     try {
+        // Mapped files only materialize the lines that are selected
+        {
+            MemoryMappedProcessor mapped(inputPath);
+            if (mapped.isMapped()) {
+                return sampleLineBuffer(mapped.data(), mapped.getFileSize(), sampleSize, seed, numThreads);
+            }
+        }
+
         // Initialize random number generator
         std::mt19937 gen;
         if (seed == 0) {
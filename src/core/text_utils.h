@@ -7,10 +7,12 @@
 #define SUZUME_CORE_TEXT_UTILS_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 #include <random>
 #include "suzume_feedmill.h"
+#include "core/dedup.h"
 
 namespace suzume {
 namespace core {
@@ -24,13 +26,56 @@ namespace core {
  */
 std::string normalizeLine(const std::string& line, NormalizationForm form);
 
+/**
+ * @brief Normalize a line of text into a reusable output buffer
+ *
+ * Same rules as normalizeLine, but writes into the caller's buffer so a
+ * worker can reuse one allocation for every line. Non-ASCII fields are
+ * decoded once into thread-local UTF-16 scratch buffers, normalized,
+ * control-stripped and lowercased in place, and encoded once into @p out.
+ *
+ * @param line Input line
+ * @param form Normalization form
+ * @param out Output buffer (cleared first; empty if the line is excluded)
+ * @return bool True if the line produced a non-empty normalized result
+ */
+bool normalizeLineInto(std::string_view line, NormalizationForm form, std::string& out);
+
+/**
+ * @brief Normalize only some tab-separated columns of a line
+ *
+ * Same rules as normalizeLineInto, but fields outside @p columns are copied
+ * byte for byte, so ID, timestamp and URL columns skip ICU entirely. Their
+ * bytes still count towards the whole-line checks (whitespace-only, too
+ * short, empty fields).
+ *
+ * @param line Input line
+ * @param form Normalization form
+ * @param out Output buffer (cleared first; empty if the line is excluded)
+ * @param columns 1-based columns to normalize (empty = every column)
+ * @return bool True if the line produced a non-empty normalized result
+ */
+bool normalizeLineInto(std::string_view line, NormalizationForm form, std::string& out,
+                       const std::vector<uint32_t>& columns);
+
+/**
+ * @brief Get the part of a line that identifies it, for deduplication
+ *
+ * @param line Tab-separated line
+ * @param columns 1-based key columns (empty = the whole line)
+ * @param scratch Buffer that holds a key of several columns
+ * @return std::string_view The line, its one key column, or the key columns
+ *         joined by tabs in @p scratch; columns past the last field are empty
+ */
+std::string_view selectColumns(std::string_view line, const std::vector<uint32_t>& columns, std::string& scratch);
+
 /**
  * @brief Check if a line should be excluded
  *
  * @param line Input line
  * @return bool True if line should be excluded
  */
-bool shouldExcludeLine(const std::string& line);
+bool shouldExcludeLine(std::string_view line);
 
 /**
  * @brief Check if a line should be excluded with length filters
@@ -40,11 +85,29 @@ bool shouldExcludeLine(const std::string& line);
  * @param maxLength Maximum line length (0 = no maximum)
  * @return bool True if line should be excluded
  */
-bool shouldExcludeLine(const std::string& line, uint32_t minLength, uint32_t maxLength);
+bool shouldExcludeLine(std::string_view line, uint32_t minLength, uint32_t maxLength);
+
+/**
+ * @brief Get the code points around a byte position of UTF-8 text
+ *
+ * Walks the UTF-8 bytes from the position in both directions, so the cost
+ * depends on the window size only, not on the position or text length.
+ * A position inside a multi-byte sequence is moved back to its lead byte.
+ *
+ * @param text UTF-8 text
+ * @param position Byte position of the window center
+ * @param codePoints Code points to take before and after the position
+ * @param withinLine Stop at the line containing the position
+ * @return std::string_view Window into text
+ */
+std::string_view utf8Context(std::string_view text, size_t position, size_t codePoints, bool withinLine = false);
 
 /**
  * @brief Generate n-grams from text
  *
+ * Allocates every n-gram; counting loops should use forEachNgram() from
+ * ngram_window.h instead.
+ *
  * @param text Input text
  * @param n N-gram size
  * @return std::vector<std::string> Generated n-grams
@@ -57,32 +120,58 @@ std::vector<std::string> generateNgrams(const std::string& text, int n);
  * @param str Input string
  * @return uint64_t Hash value
  */
-uint64_t calculateHash(const std::string& str);
+uint64_t calculateHash(std::string_view str);
 
 /**
- * @brief Check if a string is a duplicate
+ * @brief Check if a string is a duplicate using an exact string set
+ *
+ * Keeps every unique string in the set; prefer the DedupFilter overload
+ * when the strings themselves are not needed afterwards.
  *
  * @param str Input string
  * @param uniqueSet Set of unique strings
- * @param bloomFalsePositiveRate Bloom filter false positive rate
+ * @param bloomFalsePositiveRate Unused, kept for API compatibility
  * @return bool True if string is a duplicate
  */
 bool isDuplicate(const std::string& str,
                 std::unordered_set<std::string>& uniqueSet,
                 double bloomFalsePositiveRate);
 
+/**
+ * @brief Check if a string is a duplicate using a Bloom filter and fingerprint table
+ *
+ * @param str Input string
+ * @param filter Dedup filter holding the fingerprints seen so far
+ * @return bool True if string is a duplicate
+ */
+bool isDuplicate(const std::string& str, DedupFilter& filter);
+
+/**
+ * @brief Check if a string is a duplicate using a filter shared between threads
+ *
+ * @param str Input string
+ * @param filter Concurrent dedup filter holding the fingerprints seen so far
+ * @return bool True if string is a duplicate
+ */
+bool isDuplicate(std::string_view str, ConcurrentDedupFilter& filter);
+
 /**
  * @brief Sample N lines from a file using Reservoir sampling
  *
+ * Files that can be memory-mapped are sampled with skip-ahead reservoirs
+ * (see sampleLinesMapped()); other files are read line by line.
+ *
  * @param inputPath Path to input file
  * @param sampleSize Number of lines to sample
  * @param seed Random seed (0 for time-based seed)
+ * @param numThreads Number of chunks sampled in parallel (0 = auto-detect)
  * @return std::vector<std::string> Sampled lines
  */
 std::vector<std::string> sampleLines(
     const std::string& inputPath,
     size_t sampleSize,
-    unsigned int seed = 0
+    unsigned int seed = 0,
+    unsigned int numThreads = 1
 );
 
 /**
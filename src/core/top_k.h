@@ -0,0 +1,103 @@
+/**
+ * @file top_k.h
+ * @brief Bounded selection of the best K items
+ */
+
+#ifndef SUZUME_CORE_TOP_K_H_
+#define SUZUME_CORE_TOP_K_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Keeps the K best items seen so far in a bounded heap
+ *
+ * The heap holds at most K items with the worst kept item on top, so each
+ * offered item costs one comparison when it does not make the cut and
+ * O(log K) when it does. Memory stays at K items however many are offered,
+ * and selectors filled on separate threads merge into one.
+ *
+ * @tparam T Item type
+ * @tparam Better Strict weak ordering; Better(a, b) is true if a ranks before b
+ */
+template <typename T, typename Better = std::less<T>>
+class TopKSelector {
+public:
+    /**
+     * @brief Constructor
+     * @param k Maximum number of items kept
+     * @param better Ranking of items
+     */
+    explicit TopKSelector(size_t k, Better better = Better())
+        : k_(k), better_(std::move(better)) {
+        heap_.reserve(std::min<size_t>(k, 1 << 16));
+    }
+
+    /**
+     * @brief Offer an item
+     * @param item Item to keep if it ranks among the best K
+     */
+    void push(T item) {
+        if (heap_.size() < k_) {
+            heap_.push_back(std::move(item));
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        } else if (k_ > 0 && better_(item, heap_.front())) {
+            std::pop_heap(heap_.begin(), heap_.end(), better_);
+            heap_.back() = std::move(item);
+            std::push_heap(heap_.begin(), heap_.end(), better_);
+        }
+    }
+
+    /**
+     * @brief Check whether an item would be kept, without offering it
+     * @param item Candidate item
+     * @return bool True if push() would keep the item
+     */
+    bool accepts(const T& item) const {
+        return heap_.size() < k_ || (k_ > 0 && better_(item, heap_.front()));
+    }
+
+    /**
+     * @brief Offer every item kept by another selector
+     * @param other Selector to merge (left empty)
+     */
+    void merge(TopKSelector&& other) {
+        for (auto& item : other.heap_) {
+            push(std::move(item));
+        }
+        other.heap_.clear();
+    }
+
+    /**
+     * @brief Take the kept items, best first
+     * @return std::vector<T> Up to K items (the selector is left empty)
+     */
+    std::vector<T> take() {
+        std::sort_heap(heap_.begin(), heap_.end(), better_);
+        std::vector<T> items = std::move(heap_);
+        heap_.clear();
+        return items;
+    }
+
+    /**
+     * @brief Get the number of items kept
+     * @return size_t Item count
+     */
+    size_t size() const { return heap_.size(); }
+
+private:
+    size_t k_;
+    Better better_;
+    std::vector<T> heap_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_TOP_K_H_
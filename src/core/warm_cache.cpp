@@ -0,0 +1,150 @@
+/**
+ * @file warm_cache.cpp
+ * @brief Implementation of the warm cache
+ */
+
+#include "core/warm_cache.h"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <list>
+#include <mutex>
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+// Size and modification time of a file; entries loaded from an older version are stale
+struct FileVersion {
+    uintmax_t size = 0;
+    std::filesystem::file_time_type modified;
+
+    bool operator==(const FileVersion& other) const {
+        return size == other.size && modified == other.modified;
+    }
+};
+
+bool currentVersion(const std::string& path, FileVersion& version) {
+    std::error_code error;
+    version.size = std::filesystem::file_size(path, error);
+    if (error) {
+        return false;
+    }
+    version.modified = std::filesystem::last_write_time(path, error);
+    return !error;
+}
+
+struct Entry {
+    std::string kind;
+    std::string path;
+    std::string variant;
+    FileVersion version;
+    std::shared_ptr<const void> value;
+};
+
+struct Cache {
+    std::mutex mutex;
+    std::list<Entry> entries;  ///< Most recently used first
+    size_t limit = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
+
+Cache& cache() {
+    static Cache instance;
+    return instance;
+}
+
+// Drop the least recently used entries of a kind over the limit; called with the lock held
+void trimLocked(Cache& state, const std::string& kind) {
+    size_t kept = 0;
+    for (auto it = state.entries.begin(); it != state.entries.end();) {
+        if (it->kind == kind && ++kept > state.limit) {
+            it = state.entries.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace
+
+void setWarmCacheLimit(size_t entriesPerKind) {
+    Cache& state = cache();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    state.limit = entriesPerKind;
+    std::vector<std::string> kinds;
+    for (const Entry& entry : state.entries) {
+        if (std::find(kinds.begin(), kinds.end(), entry.kind) == kinds.end()) {
+            kinds.push_back(entry.kind);
+        }
+    }
+    for (const std::string& kind : kinds) {
+        trimLocked(state, kind);
+    }
+}
+
+size_t warmCacheLimit() {
+    Cache& state = cache();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    return state.limit;
+}
+
+WarmCacheStats warmCacheStats() {
+    Cache& state = cache();
+    std::lock_guard<std::mutex> lock(state.mutex);
+    WarmCacheStats stats;
+    stats.entries = state.entries.size();
+    stats.hits = state.hits;
+    stats.misses = state.misses;
+    return stats;
+}
+
+std::shared_ptr<const void> cachedLoadErased(
+    const char* kind,
+    const std::string& path,
+    const std::string& variant,
+    const std::function<std::shared_ptr<const void>()>& load
+) {
+    Cache& state = cache();
+    FileVersion version;
+    {
+        std::lock_guard<std::mutex> lock(state.mutex);
+        if (state.limit == 0) {
+            return load();
+        }
+        // Files whose version cannot be read are loaded every time, and load() reports the error
+        if (currentVersion(path, version)) {
+            for (auto it = state.entries.begin(); it != state.entries.end(); ++it) {
+                if (it->kind == kind && it->path == path && it->variant == variant) {
+                    if (it->version == version) {
+                        state.hits++;
+                        state.entries.splice(state.entries.begin(), state.entries, it);
+                        return it->value;
+                    }
+                    state.entries.erase(it);
+                    break;
+                }
+            }
+        }
+        state.misses++;
+    }
+
+    std::shared_ptr<const void> value = load();
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    FileVersion loaded;
+    if (state.limit > 0 && currentVersion(path, loaded) && loaded == version) {
+        // Another operation may have loaded the same file meanwhile; the newer entry replaces it
+        state.entries.remove_if([&](const Entry& entry) {
+            return entry.kind == kind && entry.path == path && entry.variant == variant;
+        });
+        state.entries.push_front({kind, path, variant, version, value});
+        trimLocked(state, kind);
+    }
+    return value;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,93 @@
+/**
+ * @file warm_cache.h
+ * @brief Structures loaded from files, kept across operations in long-running processes
+ */
+
+#ifndef SUZUME_CORE_WARM_CACHE_H_
+#define SUZUME_CORE_WARM_CACHE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Keep loaded structures for later operations
+ *
+ * A process that runs many operations (the serve command) keeps the
+ * dictionaries and verifier text indexes it loaded, so the next job on
+ * the same files skips loading them. Each kind of structure keeps its
+ * most recently used entries, up to the limit; an entry is reloaded when
+ * its file changed size or modification time. Off (0) by default, where
+ * every operation loads what it needs and frees it afterwards. The
+ * setting is process-wide; lowering it drops the entries over the limit.
+ *
+ * @param entriesPerKind Entries kept per kind of structure (0 = off)
+ */
+void setWarmCacheLimit(size_t entriesPerKind);
+
+/**
+ * @brief Get the warm cache limit
+ * @return size_t Entries kept per kind, 0 if caching is off
+ */
+size_t warmCacheLimit();
+
+/**
+ * @brief Counters of the warm cache
+ */
+struct WarmCacheStats {
+    size_t entries = 0;   ///< Entries held now
+    uint64_t hits = 0;    ///< Loads served from the cache
+    uint64_t misses = 0;  ///< Loads that read the file
+};
+
+/**
+ * @brief Get the counters of the warm cache
+ * @return WarmCacheStats Entries, hits and misses since the process started
+ */
+WarmCacheStats warmCacheStats();
+
+/**
+ * @brief Load a structure through the cache, type-erased (see cachedLoad())
+ * @param kind Kind of structure; entries of different kinds never match
+ * @param path File the structure is loaded from
+ * @param variant Settings the structure was built with, part of the key
+ * @param load Loads the structure
+ * @return std::shared_ptr<const void> Cached or freshly loaded structure
+ */
+std::shared_ptr<const void> cachedLoadErased(
+    const char* kind,
+    const std::string& path,
+    const std::string& variant,
+    const std::function<std::shared_ptr<const void>()>& load
+);
+
+/**
+ * @brief Load a structure from a file, or reuse the one loaded before
+ *
+ * With caching off this just calls load(). Loading runs outside the
+ * cache's lock, so operations on other files are not held up; two
+ * operations missing on the same file at once may both load it.
+ *
+ * @tparam T Structure type; shared read-only, so it must be safe for concurrent const use
+ * @param kind Kind of structure; entries of different kinds never match
+ * @param path File the structure is loaded from
+ * @param variant Settings the structure was built with, part of the key
+ * @param load Callable returning std::shared_ptr<const T>
+ * @return std::shared_ptr<const T> Cached or freshly loaded structure
+ */
+template <typename T, typename Load>
+std::shared_ptr<const T> cachedLoad(const char* kind, const std::string& path, const std::string& variant, Load&& load) {
+    return std::static_pointer_cast<const T>(cachedLoadErased(kind, path, variant, [&load]() {
+        return std::static_pointer_cast<const void>(std::shared_ptr<const T>(load()));
+    }));
+}
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_WARM_CACHE_H_
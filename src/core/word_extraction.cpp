@@ -6,33 +6,36 @@
 #include "word_extraction.h"
 #include <chrono>
 #include <algorithm>
+#include <filesystem>
+#include <functional>
+#include <numeric>
+#include <queue>
 #include <stdexcept>
 #include <memory>
+#include <thread>
+#include "auto_tune.h"
+#include "memory_accounting.h"
+#include "memory_monitor.h"
+#include "compressed_input.h"
+#include "word_extraction/candidate_store.h"
 #include "word_extraction/generator.h"
 #include "word_extraction/verifier.h"
 #include "word_extraction/filter.h"
 #include "word_extraction/ranker.h"
-
-// Forward declarations
-namespace suzume {
-namespace core {
-    uint64_t estimateMemoryUsage(
-        const std::vector<WordCandidate>& candidates,
-        const std::vector<VerifiedCandidate>& verifiedCandidates,
-        const std::vector<VerifiedCandidate>& filteredCandidates,
-        const std::vector<RankedCandidate>& rankedCandidates
-    );
-}
-}
+#include "pmi.h"
+#include "parallel/trace.h"
 
 namespace suzume {
 namespace core {
 
 // Helper function to convert internal results to public API result
 WordExtractionResult convertToResult(
-    const std::vector<RankedCandidate>& rankedCandidates,
+    const CandidateStore& store,
+    const std::vector<RankedId>& rankedCandidates,
     uint64_t processingTimeMs,
-    uint64_t memoryUsageBytes
+    const MemoryStats& memory,
+    const OperationMetrics& metrics,
+    uint64_t reusedCandidates
 ) {
     WordExtractionResult result;
 
@@ -42,34 +45,44 @@ WordExtractionResult convertToResult(
     result.contexts.reserve(rankedCandidates.size());
 
     for (const auto& candidate : rankedCandidates) {
-        result.words.push_back(candidate.text);
+        result.words.emplace_back(store.text(candidate.id));
         result.scores.push_back(candidate.score);
-        result.frequencies.push_back(candidate.frequency);
-        result.contexts.push_back(candidate.context);
+        result.frequencies.push_back(store.frequency(candidate.id));
+        result.contexts.emplace_back(store.context(candidate.id));
     }
 
+    result.reusedCandidates = reusedCandidates;
     result.processingTimeMs = processingTimeMs;
-    result.memoryUsageBytes = memoryUsageBytes;
+    result.memoryUsageBytes = memory.peakBytes;
+    result.memory = memory;
+    result.metrics = metrics;
 
     return result;
 }
 
-// Main implementation of word extraction
-WordExtractionResult extractWords(
-    const std::string& pmiResultsPath,
-    const std::string& originalTextPath,
-    const WordExtractionOptions& options
-) {
-    // Validate input paths
-    if (pmiResultsPath.empty()) {
-        throw std::invalid_argument("PMI results file path cannot be empty");
-    }
+namespace {
 
-    if (originalTextPath.empty()) {
-        throw std::invalid_argument("Original text file path cannot be empty");
+// Input and threads of a run; the monitor measures the rest
+OperationMetrics runMetrics(uint64_t bytesIn, const WordExtractionOptions& options) {
+    OperationMetrics metrics;
+    metrics.bytesIn = bytesIn;
+    metrics.threads = resolveThreads(options.threads);
+    return metrics;
+}
+
+// Bytes of the PMI results and the text read from files (0 for a file without a size)
+uint64_t inputBytes(const std::string& pmiResultsPath, const std::string& originalTextPath) {
+    uint64_t bytes = 0;
+    for (const std::string* path : {&pmiResultsPath, &originalTextPath}) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(*path, error);
+        bytes += error ? 0 : static_cast<uint64_t>(size);
     }
+    return bytes;
+}
 
-    // Validate options
+// Helper function to reject invalid word extraction options
+void validateOptions(const WordExtractionOptions& options) {
     if (options.minPmiScore < 0) {
         throw std::invalid_argument("Minimum PMI score must be non-negative");
     }
@@ -94,8 +107,184 @@ WordExtractionResult extractWords(
         throw std::invalid_argument("Top K must be at least 1");
     }
 
+    if (options.streamingVerification && options.verificationBlockSize < 1) {
+        throw std::invalid_argument("Verification block size must be at least 1");
+    }
+
+    if (options.lazyEvaluation && (options.batchVerification || options.streamingVerification)) {
+        throw std::invalid_argument("Lazy evaluation looks candidates up one by one and cannot be combined with batch or streaming verification");
+    }
+
+    if (options.incrementalTolerance < 0) {
+        throw std::invalid_argument("Incremental tolerance must be non-negative");
+    }
+
+    if (!options.incrementalStatePath.empty() && options.lazyEvaluation) {
+        throw std::invalid_argument("Incremental state records every candidate and cannot be combined with lazy evaluation");
+    }
+
     // threads is uint32_t, so it can't be negative
     // No validation needed
+}
+
+/**
+ * @brief Options that keep verification within the memory limit (see setMemoryLimit())
+ *
+ * Verifying against the whole text builds a suffix array of 4 to 8 bytes
+ * per text byte (none in batch mode), and a text that cannot be mapped is
+ * read whole. When that would take more than half the limit, the text is
+ * verified block by block instead, in blocks of at most an eighth of it.
+ * Lazy evaluation needs the whole text and is left alone, and so are runs
+ * that look candidates up in PMI statistics instead of indexing the text.
+ *
+ * @param options Requested options
+ * @param originalTextPath Original text file path
+ * @return WordExtractionOptions Options to run with
+ */
+WordExtractionOptions withinMemoryLimit(const WordExtractionOptions& options, const std::string& originalTextPath) {
+    const uint64_t limit = memoryLimit();
+    if (limit == 0 || !options.verifyInOriginalText || options.streamingVerification || options.lazyEvaluation ||
+        !options.pmiStatsPath.empty()) {
+        return options;
+    }
+
+    std::error_code error;
+    uint64_t textBytes = std::filesystem::file_size(originalTextPath, error);
+    bool mapped = !error && detectFileCompression(originalTextPath) == Compression::None;
+    uint64_t held = options.batchVerification ? 0 : textBytes * (textBytes < (1ULL << 31) ? 4 : 8);
+    if (!mapped) {
+        held += textBytes;
+    }
+    if (mapped && held <= limit / 2) {
+        return options;
+    }
+
+    WordExtractionOptions planned = options;
+    planned.streamingVerification = true;
+    planned.verificationBlockSize = std::max<uint64_t>(1, std::min(options.verificationBlockSize, limit / 8));
+    return planned;
+}
+
+// Candidates verified between two checks of the stopping rule in lazy evaluation
+constexpr size_t kLazyBatchSize = 1024;
+
+// Verifies candidates batch by batch against one text index
+using BatchVerifier = std::function<void(
+    const std::vector<CandidateStore::Id>& ids,
+    size_t batchSize,
+    const CandidateVerifier::BatchCallback& onBatch
+)>;
+
+/**
+ * Verify, filter and rank candidates, evaluating only those that can still
+ * reach the top K. The result equals that of verifying and filtering every
+ * candidate and then ranking them.
+ *
+ * Candidates that substring or overlap removal compares with others are
+ * decided together, so they are all evaluated first. The other ones are
+ * kept or dropped on their own and are evaluated by descending upper bound;
+ * evaluation stops once the K-th best score kept so far is above the bound
+ * of every candidate left. A candidate left out could score at most its
+ * bound, so it could never have displaced one of the K, ties included.
+ */
+std::vector<RankedId> evaluateLazily(
+    CandidateStore& store,
+    std::vector<CandidateStore::Id> ids,
+    const BatchVerifier& verifyInBatches,
+    CandidateFilter& filter,
+    CandidateRanker& ranker,
+    size_t topK,
+    const std::function<void(double)>& progressCallback
+) {
+    // Positions in the generated order, which ties are ranked by
+    std::vector<uint32_t> position(store.size());
+    for (size_t k = 0; k < ids.size(); ++k) {
+        position[ids[k]] = static_cast<uint32_t>(k);
+    }
+
+    // A candidate dropped here is dropped by the filter before any comparison
+    filter.filterByLengthAndScore(store, ids);
+    std::vector<bool> compared = filter.findComparedCandidates(store, ids);
+    std::vector<double> bounds(ids.size());
+    for (size_t k = 0; k < ids.size(); ++k) {
+        bounds[k] = ranker.upperBound(store, ids[k]);
+    }
+
+    std::vector<size_t> order(ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return compared[a] != compared[b] ? compared[a] : bounds[a] > bounds[b];
+    });
+    std::vector<CandidateStore::Id> ordered;
+    std::vector<double> orderedBounds;
+    ordered.reserve(ids.size());
+    orderedBounds.reserve(ids.size());
+    for (size_t k : order) {
+        ordered.push_back(ids[k]);
+        orderedBounds.push_back(bounds[k]);
+    }
+    size_t comparedCount = static_cast<size_t>(std::count(compared.begin(), compared.end(), true));
+
+    // The best topK scores among the candidates kept so far
+    std::priority_queue<double, std::vector<double>, std::greater<double>> best;
+    std::vector<CandidateStore::Id> verified;
+    size_t scored = 0;
+    verifyInBatches(ordered, kLazyBatchSize, [&](size_t processed, const std::vector<CandidateStore::Id>& accepted) {
+        verified.insert(verified.end(), accepted.begin(), accepted.end());
+        if (progressCallback) {
+            progressCallback(0.9 * static_cast<double>(processed) / ordered.size());
+        }
+        // Until every compared candidate is verified, none of them is decided
+        if (processed < comparedCount) {
+            return true;
+        }
+
+        // New candidates are never compared with the earlier ones
+        std::vector<CandidateStore::Id> fresh(verified.begin() + scored, verified.end());
+        scored = verified.size();
+        filter.filterCandidates(store, fresh);
+        for (CandidateStore::Id id : fresh) {
+            best.push(ranker.scoreCandidate(store, id));
+            if (best.size() > topK) {
+                best.pop();
+            }
+        }
+        return !(best.size() >= topK && processed < ordered.size() && orderedBounds[processed] < best.top());
+    });
+
+    // Filter and rank what was evaluated exactly as the full run would
+    std::sort(verified.begin(), verified.end(), [&](CandidateStore::Id a, CandidateStore::Id b) {
+        return position[a] < position[b];
+    });
+    filter.filterCandidates(store, verified);
+    std::vector<RankedId> ranked = ranker.rankTopCandidates(store, verified, topK);
+    if (progressCallback) {
+        progressCallback(1.0);
+    }
+    return ranked;
+}
+
+} // namespace
+
+// Main implementation of word extraction
+WordExtractionResult extractWords(
+    const std::string& pmiResultsPath,
+    const std::string& originalTextPath,
+    const WordExtractionOptions& requestedOptions
+) {
+    parallel::TraceScope span("word-extract", "operation");
+
+    // Validate input paths
+    if (pmiResultsPath.empty()) {
+        throw std::invalid_argument("PMI results file path cannot be empty");
+    }
+
+    if (originalTextPath.empty()) {
+        throw std::invalid_argument("Original text file path cannot be empty");
+    }
+
+    validateOptions(requestedOptions);
+    const WordExtractionOptions options = withinMemoryLimit(requestedOptions, originalTextPath);
 
     // If progress callbacks are provided, use the appropriate version with progress reporting
     // Note: If both callbacks are provided, simple progress callback takes precedence
@@ -117,6 +306,7 @@ WordExtractionResult extractWords(
 
     // Start timing
     auto startTime = std::chrono::high_resolution_clock::now();
+    MemoryMonitor monitor;
 
     // Create components
     CandidateGenerator generator(options);
@@ -124,21 +314,30 @@ WordExtractionResult extractWords(
     CandidateFilter filter(options);
     CandidateRanker ranker(options);
 
-    // Step 1: Generate candidates
-    auto candidates = generator.generateCandidates(pmiResultsPath);
-
-    // Step 2: Verify candidates
-    auto verifiedCandidates = verifier.verifyCandidates(candidates, originalTextPath);
-
-    // Step 3: Filter candidates
-    auto filteredCandidates = filter.filterCandidates(verifiedCandidates);
-
-    // Step 4: Rank candidates
-    auto rankedCandidates = ranker.rankCandidates(filteredCandidates);
-
-    // Limit to top K results
-    if (rankedCandidates.size() > options.topK) {
-        rankedCandidates.resize(options.topK);
+    // Step 1: Generate candidates; every later step passes IDs into the store
+    monitor.beginPhase("generate");
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(generator.generateCandidates(pmiResultsPath));
+
+    std::vector<RankedId> rankedCandidates;
+    if (options.lazyEvaluation) {
+        // Steps 2-4 interleaved, over only the candidates that can still rank
+        monitor.beginPhase("evaluate");
+        rankedCandidates = evaluateLazily(store, std::move(ids), [&](const auto& ordered, size_t batchSize, const auto& onBatch) {
+            verifier.verifyCandidatesInBatches(store, ordered, originalTextPath, batchSize, onBatch);
+        }, filter, ranker, options.topK, nullptr);
+    } else {
+        // Step 2: Verify candidates
+        monitor.beginPhase("verify");
+        ids = verifier.verifyCandidates(store, ids, originalTextPath);
+
+        // Step 3: Filter candidates
+        monitor.beginPhase("filter");
+        filter.filterCandidates(store, ids);
+
+        // Step 4: Rank candidates
+        monitor.beginPhase("rank");
+        rankedCandidates = ranker.rankTopCandidates(store, ids, options.topK);
     }
 
     // Calculate processing time
@@ -147,13 +346,10 @@ WordExtractionResult extractWords(
         endTime - startTime
     ).count();
 
-    // Estimate memory usage
-    uint64_t memoryUsageBytes = estimateMemoryUsage(
-        candidates, verifiedCandidates, filteredCandidates, rankedCandidates
-    );
-
     // Convert to result
-    return convertToResult(rankedCandidates, processingTimeMs, memoryUsageBytes);
+    OperationMetrics metrics = runMetrics(inputBytes(pmiResultsPath, originalTextPath), options);
+    MemoryStats memory = monitor.finish(metrics);
+    return convertToResult(store, rankedCandidates, processingTimeMs, memory, metrics, verifier.reusedCandidates());
 }
 
 // Implementation with simple progress reporting
@@ -169,6 +365,7 @@ WordExtractionResult extractWordsWithProgress(
 
     // Start timing
     auto startTime = std::chrono::high_resolution_clock::now();
+    MemoryMonitor monitor;
 
     // Create components
     CandidateGenerator generator(optionsWithProgress);
@@ -177,41 +374,56 @@ WordExtractionResult extractWordsWithProgress(
     CandidateRanker ranker(optionsWithProgress);
 
     // Step 1: Generate candidates (25% of progress)
-    auto candidates = generator.generateCandidates(
+    monitor.beginPhase("generate");
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(generator.generateCandidates(
         pmiResultsPath,
         [&progressCallback](double ratio) {
             progressCallback(ratio * 0.25);
         }
-    );
-
-    // Step 2: Verify candidates (25% of progress)
-    auto verifiedCandidates = verifier.verifyCandidates(
-        candidates,
-        originalTextPath,
-        [&progressCallback](double ratio) {
-            progressCallback(0.25 + ratio * 0.25);
-        }
-    );
-
-    // Step 3: Filter candidates (25% of progress)
-    auto filteredCandidates = filter.filterCandidates(
-        verifiedCandidates,
-        [&progressCallback](double ratio) {
-            progressCallback(0.5 + ratio * 0.25);
-        }
-    );
+    ));
+
+    std::vector<RankedId> rankedCandidates;
+    if (options.lazyEvaluation) {
+        // Steps 2-4 interleaved (75% of progress)
+        monitor.beginPhase("evaluate");
+        rankedCandidates = evaluateLazily(store, std::move(ids), [&](const auto& ordered, size_t batchSize, const auto& onBatch) {
+            verifier.verifyCandidatesInBatches(store, ordered, originalTextPath, batchSize, onBatch);
+        }, filter, ranker, options.topK, [&progressCallback](double ratio) {
+            progressCallback(0.25 + ratio * 0.75);
+        });
+    } else {
+        // Step 2: Verify candidates (25% of progress)
+        monitor.beginPhase("verify");
+        ids = verifier.verifyCandidates(
+            store,
+            ids,
+            originalTextPath,
+            [&progressCallback](double ratio) {
+                progressCallback(0.25 + ratio * 0.25);
+            }
+        );
 
-    // Step 4: Rank candidates (25% of progress)
-    auto rankedCandidates = ranker.rankCandidates(
-        filteredCandidates,
-        [&progressCallback](double ratio) {
-            progressCallback(0.75 + ratio * 0.25);
-        }
-    );
+        // Step 3: Filter candidates (25% of progress)
+        monitor.beginPhase("filter");
+        filter.filterCandidates(
+            store,
+            ids,
+            [&progressCallback](double ratio) {
+                progressCallback(0.5 + ratio * 0.25);
+            }
+        );
 
-    // Limit to top K results
-    if (rankedCandidates.size() > options.topK) {
-        rankedCandidates.resize(options.topK);
+        // Step 4: Rank candidates (25% of progress)
+        monitor.beginPhase("rank");
+        rankedCandidates = ranker.rankTopCandidates(
+            store,
+            ids,
+            options.topK,
+            [&progressCallback](double ratio) {
+                progressCallback(0.75 + ratio * 0.25);
+            }
+        );
     }
 
     // Calculate processing time
@@ -220,16 +432,15 @@ WordExtractionResult extractWordsWithProgress(
         endTime - startTime
     ).count();
 
-    // Estimate memory usage
-    uint64_t memoryUsageBytes = estimateMemoryUsage(
-        candidates, verifiedCandidates, filteredCandidates, rankedCandidates
-    );
+    // Measure memory before the result is built
+    OperationMetrics metrics = runMetrics(inputBytes(pmiResultsPath, originalTextPath), options);
+    MemoryStats memory = monitor.finish(metrics);
 
     // Report completion
     progressCallback(1.0);
 
     // Convert to result
-    return convertToResult(rankedCandidates, processingTimeMs, memoryUsageBytes);
+    return convertToResult(store, rankedCandidates, processingTimeMs, memory, metrics, verifier.reusedCandidates());
 }
 
 // Implementation with structured progress reporting
@@ -245,6 +456,7 @@ WordExtractionResult extractWordsWithStructuredProgress(
 
     // Start timing
     auto startTime = std::chrono::high_resolution_clock::now();
+    MemoryMonitor monitor;
 
     // Create progress info
     ProgressInfo info;
@@ -265,64 +477,86 @@ WordExtractionResult extractWordsWithStructuredProgress(
     info.phase = ProgressInfo::Phase::Reading;
     progressCallback(info);
 
-    auto candidates = generator.generateCandidates(
+    monitor.beginPhase("generate");
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(generator.generateCandidates(
         pmiResultsPath,
         [&info, &progressCallback](double ratio) {
             info.phaseRatio = ratio;
             info.overallRatio = ratio * 0.25;
             progressCallback(info);
         }
-    );
-
-    // Step 2: Verify candidates
-    info.phase = ProgressInfo::Phase::Processing;
-    info.phaseRatio = 0.0;
-    info.overallRatio = 0.25;
-    progressCallback(info);
-
-    auto verifiedCandidates = verifier.verifyCandidates(
-        candidates,
-        originalTextPath,
-        [&info, &progressCallback](double ratio) {
-            info.phaseRatio = ratio;
-            info.overallRatio = 0.25 + ratio * 0.25;
-            progressCallback(info);
-        }
-    );
-
-    // Step 3: Filter candidates
-    info.phase = ProgressInfo::Phase::Calculating;
-    info.phaseRatio = 0.0;
-    info.overallRatio = 0.5;
-    progressCallback(info);
-
-    auto filteredCandidates = filter.filterCandidates(
-        verifiedCandidates,
-        [&info, &progressCallback](double ratio) {
+    ));
+
+    std::vector<RankedId> rankedCandidates;
+    if (options.lazyEvaluation) {
+        // Steps 2-4 interleaved, reported as processing
+        info.phase = ProgressInfo::Phase::Processing;
+        info.phaseRatio = 0.0;
+        info.overallRatio = 0.25;
+        progressCallback(info);
+
+        monitor.beginPhase("evaluate");
+        rankedCandidates = evaluateLazily(store, std::move(ids), [&](const auto& ordered, size_t batchSize, const auto& onBatch) {
+            verifier.verifyCandidatesInBatches(store, ordered, originalTextPath, batchSize, onBatch);
+        }, filter, ranker, options.topK, [&info, &progressCallback](double ratio) {
             info.phaseRatio = ratio;
-            info.overallRatio = 0.5 + ratio * 0.25;
+            info.overallRatio = 0.25 + ratio * 0.75;
             progressCallback(info);
-        }
-    );
-
-    // Step 4: Rank candidates
-    info.phase = ProgressInfo::Phase::Writing;
-    info.phaseRatio = 0.0;
-    info.overallRatio = 0.75;
-    progressCallback(info);
+        });
+    } else {
+        // Step 2: Verify candidates
+        info.phase = ProgressInfo::Phase::Processing;
+        info.phaseRatio = 0.0;
+        info.overallRatio = 0.25;
+        progressCallback(info);
+
+        monitor.beginPhase("verify");
+        ids = verifier.verifyCandidates(
+            store,
+            ids,
+            originalTextPath,
+            [&info, &progressCallback](double ratio) {
+                info.phaseRatio = ratio;
+                info.overallRatio = 0.25 + ratio * 0.25;
+                progressCallback(info);
+            }
+        );
 
-    auto rankedCandidates = ranker.rankCandidates(
-        filteredCandidates,
-        [&info, &progressCallback](double ratio) {
-            info.phaseRatio = ratio;
-            info.overallRatio = 0.75 + ratio * 0.25;
-            progressCallback(info);
-        }
-    );
+        // Step 3: Filter candidates
+        info.phase = ProgressInfo::Phase::Calculating;
+        info.phaseRatio = 0.0;
+        info.overallRatio = 0.5;
+        progressCallback(info);
+
+        monitor.beginPhase("filter");
+        filter.filterCandidates(
+            store,
+            ids,
+            [&info, &progressCallback](double ratio) {
+                info.phaseRatio = ratio;
+                info.overallRatio = 0.5 + ratio * 0.25;
+                progressCallback(info);
+            }
+        );
 
-    // Limit to top K results
-    if (rankedCandidates.size() > options.topK) {
-        rankedCandidates.resize(options.topK);
+        // Step 4: Rank candidates
+        info.phase = ProgressInfo::Phase::Writing;
+        info.phaseRatio = 0.0;
+        info.overallRatio = 0.75;
+        progressCallback(info);
+
+        monitor.beginPhase("rank");
+        rankedCandidates = ranker.rankTopCandidates(
+            store,
+            ids,
+            options.topK,
+            [&info, &progressCallback](double ratio) {
+                info.phaseRatio = ratio;
+                info.overallRatio = 0.75 + ratio * 0.25;
+                progressCallback(info);
+            }
+        );
     }
 
     // Calculate processing time
@@ -331,10 +565,9 @@ WordExtractionResult extractWordsWithStructuredProgress(
         endTime - startTime
     ).count();
 
-    // Estimate memory usage
-    uint64_t memoryUsageBytes = estimateMemoryUsage(
-        candidates, verifiedCandidates, filteredCandidates, rankedCandidates
-    );
+    // Measure memory before the result is built
+    OperationMetrics metrics = runMetrics(inputBytes(pmiResultsPath, originalTextPath), options);
+    MemoryStats memory = monitor.finish(metrics);
 
     // Report completion
     info.phase = ProgressInfo::Phase::Complete;
@@ -343,46 +576,114 @@ WordExtractionResult extractWordsWithStructuredProgress(
     progressCallback(info);
 
     // Convert to result
-    return convertToResult(rankedCandidates, processingTimeMs, memoryUsageBytes);
+    return convertToResult(store, rankedCandidates, processingTimeMs, memory, metrics, verifier.reusedCandidates());
 }
 
-// Helper function to estimate memory usage
-uint64_t estimateMemoryUsage(
-    const std::vector<WordCandidate>& candidates,
-    const std::vector<VerifiedCandidate>& verifiedCandidates,
-    const std::vector<VerifiedCandidate>& filteredCandidates,
-    const std::vector<RankedCandidate>& rankedCandidates
+namespace {
+
+// Candidates of an in-memory run, generated from wherever its PMI results are
+using GenerateCandidates = std::function<std::vector<WordCandidate>(
+    CandidateGenerator&, const std::function<void(double)>&)>;
+
+// Shared implementation over inputs already in memory
+WordExtractionResult extractInMemory(
+    const GenerateCandidates& generate,
+    std::string_view originalText,
+    const WordExtractionOptions& options,
+    const std::function<void(double)>& progressCallback
 ) {
-    uint64_t memoryUsageBytes = 0;
+    validateOptions(options);
 
-    // Estimate memory for candidates
-    memoryUsageBytes += sizeof(WordCandidate) * candidates.size();
-    for (const auto& candidate : candidates) {
-        memoryUsageBytes += candidate.text.capacity() * sizeof(char);
-    }
+    // Each stage is a quarter of the progress, as in extractWordsWithProgress()
+    auto stageProgress = [&progressCallback](double start) -> std::function<void(double)> {
+        if (!progressCallback) {
+            return nullptr;
+        }
+        return [&progressCallback, start](double ratio) {
+            progressCallback(start + ratio * 0.25);
+        };
+    };
 
-    // Estimate memory for verified candidates
-    memoryUsageBytes += sizeof(VerifiedCandidate) * verifiedCandidates.size();
-    for (const auto& candidate : verifiedCandidates) {
-        memoryUsageBytes += candidate.text.capacity() * sizeof(char);
-        memoryUsageBytes += candidate.context.capacity() * sizeof(char);
-    }
+    // Start timing
+    auto startTime = std::chrono::high_resolution_clock::now();
+    MemoryMonitor monitor;
+
+    // Create components
+    CandidateGenerator generator(options);
+    CandidateVerifier verifier(options);
+    CandidateFilter filter(options);
+    CandidateRanker ranker(options);
 
-    // Estimate memory for filtered candidates
-    memoryUsageBytes += sizeof(VerifiedCandidate) * filteredCandidates.size();
-    for (const auto& candidate : filteredCandidates) {
-        memoryUsageBytes += candidate.text.capacity() * sizeof(char);
-        memoryUsageBytes += candidate.context.capacity() * sizeof(char);
+    // Step 1: Generate candidates
+    monitor.beginPhase("generate");
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(generate(generator, stageProgress(0.0)));
+
+    std::vector<RankedId> rankedCandidates;
+    if (options.lazyEvaluation) {
+        // Steps 2-4 interleaved, verifying against the text in place
+        std::function<void(double)> evaluateProgress;
+        if (progressCallback) {
+            evaluateProgress = [&progressCallback](double ratio) {
+                progressCallback(0.25 + ratio * 0.75);
+            };
+        }
+        monitor.beginPhase("evaluate");
+        rankedCandidates = evaluateLazily(store, std::move(ids), [&](const auto& ordered, size_t batchSize, const auto& onBatch) {
+            verifier.verifyCandidatesInBatchesInText(store, ordered, originalText, batchSize, onBatch);
+        }, filter, ranker, options.topK, evaluateProgress);
+    } else {
+        // Step 2: Verify candidates against the text in place
+        monitor.beginPhase("verify");
+        ids = verifier.verifyCandidatesInText(store, ids, originalText, stageProgress(0.25));
+
+        // Step 3: Filter candidates
+        monitor.beginPhase("filter");
+        filter.filterCandidates(store, ids, stageProgress(0.5));
+
+        // Step 4: Rank candidates
+        monitor.beginPhase("rank");
+        rankedCandidates = ranker.rankTopCandidates(store, ids, options.topK, stageProgress(0.75));
     }
 
-    // Estimate memory for ranked candidates
-    memoryUsageBytes += sizeof(RankedCandidate) * rankedCandidates.size();
-    for (const auto& candidate : rankedCandidates) {
-        memoryUsageBytes += candidate.text.capacity() * sizeof(char);
-        memoryUsageBytes += candidate.context.capacity() * sizeof(char);
+    // Calculate processing time
+    auto endTime = std::chrono::high_resolution_clock::now();
+    uint64_t processingTimeMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+        endTime - startTime
+    ).count();
+
+    OperationMetrics metrics = runMetrics(originalText.size(), options);
+    MemoryStats memory = monitor.finish(metrics);
+
+    if (progressCallback) {
+        progressCallback(1.0);
     }
 
-    return memoryUsageBytes;
+    return convertToResult(store, rankedCandidates, processingTimeMs, memory, metrics, verifier.reusedCandidates());
+}
+
+} // namespace
+
+WordExtractionResult extractWordsFromMemory(
+    const std::vector<PmiItem>& pmiItems,
+    std::string_view originalText,
+    const WordExtractionOptions& options,
+    const std::function<void(double)>& progressCallback
+) {
+    return extractInMemory([&pmiItems](CandidateGenerator& generator, const std::function<void(double)>& progress) {
+        return generator.generateCandidates(pmiItems, progress);
+    }, originalText, options, progressCallback);
+}
+
+WordExtractionResult extractWordsFromText(
+    std::string_view pmiText,
+    std::string_view originalText,
+    const WordExtractionOptions& options,
+    const std::function<void(double)>& progressCallback
+) {
+    return extractInMemory([pmiText](CandidateGenerator& generator, const std::function<void(double)>& progress) {
+        return generator.generateCandidatesFromText(pmiText, progress);
+    }, originalText, options, progressCallback);
 }
 
 } // namespace core
@@ -7,6 +7,8 @@
 #define SUZUME_CORE_WORD_EXTRACTION_H_
 
 #include <string>
+#include <string_view>
+#include <vector>
 #include <functional>
 #include "suzume_feedmill.h"
 #include "word_extraction/common.h"
@@ -64,6 +66,47 @@ WordExtractionResult extractWordsWithStructuredProgress(
     const WordExtractionOptions& options = WordExtractionOptions()
 );
 
+/**
+ * @brief Extract unknown words from PMI results and a text held in memory
+ *
+ * Runs the same stages as extractWords() without reading either input
+ * from a file; the verifier indexes the caller's text in place.
+ *
+ * @param pmiItems PMI results, as calculated
+ * @param originalText Original text
+ * @param options Word extraction options
+ * @param progressCallback Progress callback function (optional)
+ * @return WordExtractionResult Results of the word extraction operation
+ * @throws std::invalid_argument If the options are invalid
+ */
+WordExtractionResult extractWordsFromMemory(
+    const std::vector<PmiItem>& pmiItems,
+    std::string_view originalText,
+    const WordExtractionOptions& options = WordExtractionOptions(),
+    const std::function<void(double)>& progressCallback = nullptr
+);
+
+/**
+ * @brief Extract unknown words from PMI results TSV and a text held in memory
+ *
+ * Like extractWordsFromMemory(), with the PMI results given as the text of
+ * a results file and parsed in place.
+ *
+ * @param pmiText PMI results as "ngram<TAB>pmi<TAB>frequency" lines (header optional)
+ * @param originalText Original text
+ * @param options Word extraction options
+ * @param progressCallback Progress callback function (optional)
+ * @return WordExtractionResult Results of the word extraction operation
+ * @throws std::invalid_argument If the options are invalid
+ * @throws std::runtime_error If the PMI results are empty or hold no valid line
+ */
+WordExtractionResult extractWordsFromText(
+    std::string_view pmiText,
+    std::string_view originalText,
+    const WordExtractionOptions& options = WordExtractionOptions(),
+    const std::function<void(double)>& progressCallback = nullptr
+);
+
 } // namespace core
 } // namespace suzume
 
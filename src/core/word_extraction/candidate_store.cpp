@@ -0,0 +1,83 @@
+/**
+ * @file candidate_store.cpp
+ * @brief Implementation of the word candidate column store
+ */
+
+#include "candidate_store.h"
+#include <limits>
+#include <stdexcept>
+
+namespace suzume {
+namespace core {
+
+CandidateStore::Span CandidateStore::append(std::string_view text) {
+    if (text.size() > std::numeric_limits<uint32_t>::max()) {
+        throw std::length_error("Candidate text too long for the candidate store");
+    }
+    Span span{pool_.size(), static_cast<uint32_t>(text.size())};
+    pool_.append(text);
+    return span;
+}
+
+CandidateStore::Id CandidateStore::add(std::string_view text, double score, uint32_t frequency) {
+    if (size() >= std::numeric_limits<Id>::max()) {
+        throw std::length_error("Too many candidates for the candidate store");
+    }
+    Id id = static_cast<Id>(size());
+    textSpans_.push_back(append(text));
+    contextSpans_.emplace_back();
+    scores_.push_back(score);
+    frequencies_.push_back(frequency);
+    contextScores_.push_back(0.0);
+    statisticalScores_.push_back(0.0);
+    return id;
+}
+
+std::vector<CandidateStore::Id> CandidateStore::addAll(const std::vector<WordCandidate>& candidates) {
+    std::vector<Id> ids;
+    ids.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        ids.push_back(add(candidate.text, candidate.score, candidate.frequency));
+    }
+    return ids;
+}
+
+std::vector<CandidateStore::Id> CandidateStore::addAll(const std::vector<VerifiedCandidate>& candidates) {
+    std::vector<Id> ids;
+    ids.reserve(candidates.size());
+    for (const auto& candidate : candidates) {
+        Id id = add(candidate.text, candidate.score, candidate.frequency);
+        if (!candidate.context.empty()) {
+            setContext(id, candidate.context);
+        }
+        contextScores_[id] = candidate.contextScore;
+        statisticalScores_[id] = candidate.statisticalScore;
+        ids.push_back(id);
+    }
+    return ids;
+}
+
+void CandidateStore::setContext(Id id, std::string_view context) {
+    contextSpans_[id] = append(context);
+}
+
+VerifiedCandidate CandidateStore::toVerified(Id id) const {
+    VerifiedCandidate candidate;
+    candidate.text = std::string(text(id));
+    candidate.score = scores_[id];
+    candidate.frequency = frequencies_[id];
+    candidate.context = std::string(context(id));
+    candidate.contextScore = contextScores_[id];
+    candidate.statisticalScore = statisticalScores_[id];
+    return candidate;
+}
+
+size_t CandidateStore::memoryUsage() const {
+    return pool_.capacity() +
+           (textSpans_.capacity() + contextSpans_.capacity()) * sizeof(Span) +
+           (scores_.capacity() + contextScores_.capacity() + statisticalScores_.capacity()) * sizeof(double) +
+           frequencies_.capacity() * sizeof(uint32_t);
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,140 @@
+/**
+ * @file candidate_store.h
+ * @brief Column store of word candidates shared by the extraction stages
+ */
+
+#ifndef SUZUME_CORE_WORD_EXTRACTION_CANDIDATE_STORE_H_
+#define SUZUME_CORE_WORD_EXTRACTION_CANDIDATE_STORE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "common.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Candidates as parallel columns with their texts in one string pool
+ *
+ * The pipeline adds every generated candidate once and then passes
+ * candidate IDs between stages; texts and contexts are never copied again
+ * until the final result is built. Texts are appended to a single buffer
+ * and addressed by offset, so a candidate costs its bytes plus a few
+ * column entries instead of a heap string per stage.
+ *
+ * Adding candidates or contexts is not thread-safe; stages that run in
+ * parallel write only the numeric columns of distinct IDs.
+ */
+class CandidateStore {
+public:
+    using Id = uint32_t;
+
+    /**
+     * @brief Add a candidate
+     *
+     * @param text Candidate text
+     * @param score PMI score
+     * @param frequency Frequency
+     * @return Id ID of the new candidate
+     */
+    Id add(std::string_view text, double score, uint32_t frequency);
+
+    /**
+     * @brief Add generated candidates
+     *
+     * @param candidates Candidates to add, in order
+     * @return std::vector<Id> Their IDs
+     */
+    std::vector<Id> addAll(const std::vector<WordCandidate>& candidates);
+
+    /**
+     * @brief Add verified candidates, keeping their verification results
+     *
+     * @param candidates Candidates to add, in order
+     * @return std::vector<Id> Their IDs
+     */
+    std::vector<Id> addAll(const std::vector<VerifiedCandidate>& candidates);
+
+    /**
+     * @brief Get the number of candidates
+     * @return size_t Candidate count
+     */
+    size_t size() const { return scores_.size(); }
+
+    /**
+     * @brief Get the text of a candidate
+     * @param id Candidate ID
+     * @return std::string_view Text, valid until the next add
+     */
+    std::string_view text(Id id) const { return view(textSpans_[id]); }
+
+    /**
+     * @brief Get the context of a candidate
+     * @param id Candidate ID
+     * @return std::string_view Context (empty if none), valid until the next add
+     */
+    std::string_view context(Id id) const { return view(contextSpans_[id]); }
+
+    /**
+     * @brief Set the context of a candidate
+     * @param id Candidate ID
+     * @param context Context text
+     */
+    void setContext(Id id, std::string_view context);
+
+    double score(Id id) const { return scores_[id]; }                           ///< PMI score
+    uint32_t frequency(Id id) const { return frequencies_[id]; }                ///< Frequency
+    double contextScore(Id id) const { return contextScores_[id]; }             ///< Context score
+    double statisticalScore(Id id) const { return statisticalScores_[id]; }     ///< Statistical score
+    void setContextScore(Id id, double score) { contextScores_[id] = score; }   ///< Set the context score
+    void setStatisticalScore(Id id, double score) { statisticalScores_[id] = score; } ///< Set the statistical score
+
+    /**
+     * @brief Copy a candidate out as a verified candidate
+     * @param id Candidate ID
+     * @return VerifiedCandidate Candidate with its text and context
+     */
+    VerifiedCandidate toVerified(Id id) const;
+
+    /**
+     * @brief Get the bytes held by the store
+     * @return size_t Reserved bytes of the pool and columns
+     */
+    size_t memoryUsage() const;
+
+private:
+    struct Span {
+        uint64_t offset = 0;
+        uint32_t length = 0;
+    };
+
+    std::string_view view(const Span& span) const {
+        return std::string_view(pool_.data() + span.offset, span.length);
+    }
+
+    Span append(std::string_view text);
+
+    std::string pool_;
+    std::vector<Span> textSpans_;
+    std::vector<Span> contextSpans_;
+    std::vector<double> scores_;
+    std::vector<uint32_t> frequencies_;
+    std::vector<double> contextScores_;
+    std::vector<double> statisticalScores_;
+};
+
+/**
+ * @brief A candidate ID with its final ranking score
+ */
+struct RankedId {
+    CandidateStore::Id id;  // Candidate ID
+    double score;           // Final score
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_WORD_EXTRACTION_CANDIDATE_STORE_H_
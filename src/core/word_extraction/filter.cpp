@@ -5,14 +5,17 @@
 
 #include "filter.h"
 #include <algorithm>
-#include <unordered_set>
+#include <limits>
 #include <numeric>
+#include "core/aho_corasick.h"
+#include "robin_hood.h"
 
 namespace suzume {
 namespace core {
 
 CandidateFilter::CandidateFilter(const WordExtractionOptions& options)
-    : options_(options)
+    : options_(options),
+      rules_(options.languageCode)
 {
 }
 
@@ -20,35 +23,36 @@ std::vector<VerifiedCandidate> CandidateFilter::filterCandidates(
     const std::vector<VerifiedCandidate>& candidates,
     const std::function<void(double)>& progressCallback
 ) {
-    // Filter by length
-    std::vector<VerifiedCandidate> lengthFiltered;
-    for (const auto& candidate : candidates) {
-        if (candidate.text.length() >= options_.minLength &&
-            candidate.text.length() <= options_.maxLength) {
-            lengthFiltered.push_back(candidate);
-        }
-    }
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(candidates);
+    filterCandidates(store, ids, progressCallback);
 
-    if (progressCallback) {
-        progressCallback(0.25);
+    std::vector<VerifiedCandidate> filtered;
+    filtered.reserve(ids.size());
+    for (CandidateStore::Id id : ids) {
+        filtered.push_back(store.toVerified(id));
     }
+    return filtered;
+}
 
-    // Filter by score
-    std::vector<VerifiedCandidate> scoreFiltered;
-    for (const auto& candidate : lengthFiltered) {
-        if (candidate.score >= options_.minScore) {
-            scoreFiltered.push_back(candidate);
-        }
-    }
+void CandidateFilter::filterCandidates(
+    const CandidateStore& store,
+    std::vector<CandidateStore::Id>& ids,
+    const std::function<void(double)>& progressCallback
+) {
+    // Every stage narrows the one list of IDs; no candidate is copied
+
+    // Filter by length and score in one pass
+    filterByLengthAndScore(store, ids);
 
     if (progressCallback) {
+        progressCallback(0.25);
         progressCallback(0.5);
     }
 
     // Remove substrings if required
-    std::vector<VerifiedCandidate> substringFiltered = scoreFiltered;
     if (options_.removeSubstrings) {
-        substringFiltered = removeSubstringCandidates(scoreFiltered);
+        removeSubstringCandidates(store, ids);
     }
 
     if (progressCallback) {
@@ -56,280 +60,286 @@ std::vector<VerifiedCandidate> CandidateFilter::filterCandidates(
     }
 
     // Remove overlapping if required
-    std::vector<VerifiedCandidate> overlapFiltered = substringFiltered;
     if (options_.removeOverlapping) {
-        overlapFiltered = removeOverlappingCandidates(substringFiltered);
+        removeOverlappingCandidates(store, ids);
     }
 
     // Apply language-specific filters if required
-    std::vector<VerifiedCandidate> languageFiltered = overlapFiltered;
     if (options_.useLanguageSpecificRules) {
-        languageFiltered = applyLanguageSpecificFilters(overlapFiltered);
+        applyLanguageSpecificFilters(store, ids);
     }
 
     if (progressCallback) {
         progressCallback(1.0);
     }
+}
 
-    return languageFiltered;
+void CandidateFilter::filterByLengthAndScore(
+    const CandidateStore& store,
+    std::vector<CandidateStore::Id>& ids
+) const {
+    ids.erase(std::remove_if(ids.begin(), ids.end(), [&](CandidateStore::Id id) {
+        size_t length = store.text(id).length();
+        return length < options_.minLength || length > options_.maxLength ||
+               store.score(id) < options_.minScore;
+    }), ids.end());
 }
 
-std::vector<VerifiedCandidate> CandidateFilter::removeSubstringCandidates(
-    const std::vector<VerifiedCandidate>& candidates
-) {
-    // Sort by length (descending)
-    std::vector<VerifiedCandidate> sorted = candidates;
-    std::sort(sorted.begin(), sorted.end(),
-        [](const VerifiedCandidate& a, const VerifiedCandidate& b) {
-            return a.text.length() > b.text.length();
+std::vector<bool> CandidateFilter::findComparedCandidates(
+    const CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids
+) const {
+    std::vector<bool> compared(ids.size(), false);
+    if (ids.empty() || (!options_.removeSubstrings && !options_.removeOverlapping)) {
+        return compared;
+    }
+
+    // Distinct texts; one shared by several candidates marks all of them
+    std::vector<std::string_view> texts;
+    std::vector<uint32_t> sharing;
+    std::vector<uint32_t> textOf(ids.size());
+    robin_hood::unordered_flat_map<std::string_view, uint32_t> textIds;
+    for (size_t k = 0; k < ids.size(); ++k) {
+        auto [it, inserted] = textIds.try_emplace(store.text(ids[k]), static_cast<uint32_t>(texts.size()));
+        if (inserted) {
+            texts.push_back(store.text(ids[k]));
+            sharing.push_back(0);
+        }
+        textOf[k] = it->second;
+        sharing[it->second]++;
+    }
+
+    // Containment both ways, found as the removals find it
+    std::vector<bool> related(texts.size(), false);
+    AhoCorasick automaton(texts);
+    for (uint32_t t = 0; t < texts.size(); ++t) {
+        automaton.scan(texts[t], [&](size_t pattern, size_t) {
+            if (pattern != t) {
+                related[t] = true;
+                related[pattern] = true;
+            }
         });
+    }
 
-    // Keep track of candidates to remove - use efficient set for O(log n) lookups
-    std::unordered_set<std::string> toRemove;
-    
-    // Create a map for faster substring checking - group by length
-    std::unordered_map<size_t, std::vector<std::pair<std::string, double>>> lengthGroups;
-    for (const auto& candidate : sorted) {
-        lengthGroups[candidate.text.length()].emplace_back(candidate.text, candidate.score);
+    for (size_t k = 0; k < ids.size(); ++k) {
+        compared[k] = related[textOf[k]] || sharing[textOf[k]] > 1;
     }
-    
-    // Check each candidate against potentially containing candidates only
-    for (const auto& candidate : sorted) {
-        if (toRemove.count(candidate.text)) continue;
-        
-        // Only check against longer candidates (potential containers)
-        for (auto& [length, group] : lengthGroups) {
-            if (length <= candidate.text.length()) continue;
-            
-            for (const auto& [longerText, longerScore] : group) {
-                if (toRemove.count(longerText)) continue;
-                
-                // Check if current candidate is substring of longer candidate
-                if (longerText.find(candidate.text) != std::string::npos) {
-                    // Mark current candidate for removal if its score is much lower
-                    if (candidate.score < longerScore * 0.8) {
-                        toRemove.insert(candidate.text);
-                        break; // No need to check more containers for this candidate
-                    }
-                }
+    return compared;
+}
+
+void CandidateFilter::removeSubstringCandidates(
+    const CandidateStore& store,
+    std::vector<CandidateStore::Id>& selection
+) {
+    // A candidate is removed when a longer candidate that is kept contains it
+    // and scores well above it. Duplicate texts are decided together: the
+    // lowest-scoring copy decides removal, the highest-scoring one counts as
+    // a container.
+    struct Entry {
+        std::string_view text;
+        double minScore;
+        double maxScore;
+        double bestContainer = -std::numeric_limits<double>::infinity();
+        bool removed = false;
+    };
+    std::vector<Entry> entries;
+    std::vector<uint32_t> entryOf(selection.size());
+    robin_hood::unordered_flat_map<std::string_view, uint32_t> entryIds;
+    for (size_t k = 0; k < selection.size(); ++k) {
+        std::string_view text = store.text(selection[k]);
+        double score = store.score(selection[k]);
+        auto [it, inserted] = entryIds.try_emplace(text, static_cast<uint32_t>(entries.size()));
+        if (inserted) {
+            entries.push_back({text, score, score});
+        } else {
+            Entry& entry = entries[it->second];
+            entry.minScore = std::min(entry.minScore, score);
+            entry.maxScore = std::max(entry.maxScore, score);
+        }
+        entryOf[k] = it->second;
+    }
+
+    // One automaton over every text finds all candidates inside a candidate
+    // in a single scan of it, instead of a find() per pair
+    std::vector<std::string_view> patterns;
+    patterns.reserve(entries.size());
+    for (const auto& entry : entries) {
+        patterns.push_back(entry.text);
+    }
+    AhoCorasick automaton(patterns);
+
+    // Longest first, so every container is decided before what it contains
+    std::vector<size_t> order(entries.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entries[a].text.length() > entries[b].text.length();
+    });
+
+    for (size_t begin = 0; begin < order.size();) {
+        size_t length = entries[order[begin]].text.length();
+        size_t end = begin;
+        while (end < order.size() && entries[order[end]].text.length() == length) {
+            ++end;
+        }
+
+        for (size_t k = begin; k < end; ++k) {
+            Entry& entry = entries[order[k]];
+            entry.removed = entry.minScore < entry.bestContainer * 0.8;
+        }
+        for (size_t k = begin; k < end; ++k) {
+            const Entry& container = entries[order[k]];
+            if (container.removed) {
+                continue;
             }
-            
-            if (toRemove.count(candidate.text)) break;
+            automaton.scan(container.text, [&](size_t pattern, size_t) {
+                Entry& contained = entries[pattern];
+                if (contained.text.length() < length) {
+                    contained.bestContainer = std::max(contained.bestContainer, container.maxScore);
+                }
+            });
         }
+        begin = end;
     }
 
     // Filter out removed candidates
-    std::vector<VerifiedCandidate> filtered;
-    for (const auto& candidate : candidates) {
-        if (toRemove.find(candidate.text) == toRemove.end()) {
-            filtered.push_back(candidate);
+    size_t kept = 0;
+    for (size_t k = 0; k < selection.size(); ++k) {
+        if (!entries[entryOf[k]].removed) {
+            selection[kept++] = selection[k];
         }
     }
-
-    return filtered;
+    selection.resize(kept);
 }
 
-std::vector<VerifiedCandidate> CandidateFilter::removeOverlappingCandidates(
-    const std::vector<VerifiedCandidate>& candidates
+void CandidateFilter::removeOverlappingCandidates(
+    const CandidateStore& store,
+    std::vector<CandidateStore::Id>& selection
 ) {
-    if (candidates.empty()) {
-        return candidates;
+    if (selection.empty()) {
+        return;
     }
 
-    std::vector<VerifiedCandidate> result;
-    std::vector<bool> removed(candidates.size(), false);
+    // Distinct texts and the selected candidates sharing each; k below is a
+    // position in selection
+    std::vector<std::string_view> texts;
+    std::vector<std::vector<uint32_t>> members;
+    std::vector<uint32_t> textOf(selection.size());
+    robin_hood::unordered_flat_map<std::string_view, uint32_t> textIds;
+    for (size_t k = 0; k < selection.size(); ++k) {
+        std::string_view text = store.text(selection[k]);
+        auto [it, inserted] = textIds.try_emplace(text, static_cast<uint32_t>(texts.size()));
+        if (inserted) {
+            texts.push_back(text);
+            members.emplace_back();
+        }
+        textOf[k] = it->second;
+        members[it->second].push_back(static_cast<uint32_t>(k));
+    }
 
-    // Sort candidates by score (descending) to prioritize higher-scoring candidates
-    std::vector<size_t> indices(candidates.size());
-    std::iota(indices.begin(), indices.end(), 0);
-    std::sort(indices.begin(), indices.end(), 
-        [&candidates](size_t a, size_t b) {
-            return candidates[a].score > candidates[b].score;
+    // Candidates overlap when their texts are equal or one contains the
+    // other. The related texts are found by scanning every text once with
+    // an automaton over all of them, so only overlapping pairs are visited
+    std::vector<std::vector<uint32_t>> related(texts.size());
+    AhoCorasick automaton(texts);
+    for (uint32_t t = 0; t < texts.size(); ++t) {
+        automaton.scan(texts[t], [&](size_t pattern, size_t) {
+            if (pattern != t) {
+                related[t].push_back(static_cast<uint32_t>(pattern));
+                related[pattern].push_back(t);
+            }
         });
+    }
+    for (auto& list : related) {
+        std::sort(list.begin(), list.end());
+        list.erase(std::unique(list.begin(), list.end()), list.end());
+    }
 
-    // Check each candidate against all others
-    for (size_t i = 0; i < indices.size(); ++i) {
-        if (removed[indices[i]]) continue;
-        
-        const auto& current = candidates[indices[i]];
-        bool shouldKeep = true;
-
-        // Check against all other candidates
-        for (size_t j = 0; j < indices.size(); ++j) {
-            if (i == j || removed[indices[j]]) continue;
-            
-            const auto& other = candidates[indices[j]];
-            
-            // Check for substring relationship or exact duplicates
-            if (isOverlapping(current.text, other.text)) {
-                // If current candidate has lower score, mark it for removal
-                if (current.score <= other.score) {
-                    shouldKeep = false;
-                    break;
-                } else {
-                    // Mark the other candidate for removal
-                    removed[indices[j]] = true;
-                }
+    auto forEachOverlapping = [&](size_t k, auto&& visit) {
+        for (uint32_t other : members[textOf[k]]) {
+            if (other != k) {
+                visit(other);
+            }
+        }
+        for (uint32_t text : related[textOf[k]]) {
+            for (uint32_t other : members[text]) {
+                visit(other);
             }
         }
+    };
+    auto scoreOf = [&](size_t k) { return store.score(selection[k]); };
+
+    std::vector<CandidateStore::Id> result;
+    std::vector<bool> removed(selection.size(), false);
+
+    // Sort candidates by score (descending) to prioritize higher-scoring candidates
+    std::vector<size_t> order(selection.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return scoreOf(a) > scoreOf(b);
+    });
+
+    // A candidate is kept unless an overlapping candidate that is still in
+    // scores at least as high; a kept candidate removes the ones it overlaps
+    for (size_t k : order) {
+        if (removed[k]) continue;
+
+        bool shouldKeep = true;
+        forEachOverlapping(k, [&](size_t other) {
+            if (!removed[other] && scoreOf(k) <= scoreOf(other)) {
+                shouldKeep = false;
+            }
+        });
 
         if (shouldKeep) {
-            result.push_back(current);
+            forEachOverlapping(k, [&](size_t other) {
+                removed[other] = true;
+            });
+            result.push_back(selection[k]);
         } else {
-            removed[indices[i]] = true;
+            removed[k] = true;
         }
     }
 
-    return result;
-}
-
-bool CandidateFilter::isOverlapping(const std::string& text1, const std::string& text2) {
-    // Exact match
-    if (text1 == text2) {
-        return true;
-    }
-    
-    // Check if one is a substring of the other
-    if (text1.find(text2) != std::string::npos || text2.find(text1) != std::string::npos) {
-        return true;
-    }
-    
-    return false;
+    // Kept candidates come out in score order
+    selection = std::move(result);
 }
 
-std::vector<VerifiedCandidate> CandidateFilter::applyLanguageSpecificFilters(
-    const std::vector<VerifiedCandidate>& candidates
+void CandidateFilter::applyLanguageSpecificFilters(
+    const CandidateStore& store,
+    std::vector<CandidateStore::Id>& selection
 ) {
-    if (!options_.useLanguageSpecificRules) {
-        return candidates;
-    }
-
-    std::vector<VerifiedCandidate> filtered;
-    
-    for (const auto& candidate : candidates) {
-        // For new word discovery, we should be PERMISSIVE, not restrictive
-        // Only filter out clearly invalid candidates that are likely noise
-        if (isLikelyValidWordCandidate(candidate.text)) {
-            filtered.push_back(candidate);
-        }
-    }
-
-    return filtered;
+    // For new word discovery, we should be PERMISSIVE, not restrictive
+    // Only filter out clearly invalid candidates that are likely noise
+    selection.erase(std::remove_if(selection.begin(), selection.end(), [&](CandidateStore::Id id) {
+        std::string_view text = store.text(id);
+        return !isLikelyValidWordCandidate(text, profileText(text));
+    }), selection.end());
 }
 
-bool CandidateFilter::isLikelyValidWordCandidate(const std::string& text) {
+bool CandidateFilter::isLikelyValidWordCandidate(std::string_view text, const TextProfile& profile) const {
     if (text.empty()) {
         return false;
     }
 
     // For new word discovery, be VERY permissive
     // Only filter out obvious noise patterns
-    
-    // Filter out single punctuation or symbols
-    if (text.length() <= 3) {
-        const char* ptr = text.c_str();
-        unsigned char c = *ptr;
-        
-        // Single ASCII punctuation/symbols
-        if (text.length() == 1 && (c < 0x30 || (c > 0x39 && c < 0x41) || 
-                                   (c > 0x5A && c < 0x61) || c > 0x7A)) {
-            return false;
-        }
-    }
-    
-    // Filter out strings that are clearly broken encoding
-    // Check for valid UTF-8 sequences
-    const char* ptr = text.c_str();
-    const char* end = ptr + text.length();
-    bool hasValidChars = false;
-    
-    while (ptr < end) {
-        unsigned char c = *ptr;
-        int bytes = 0;
-        
-        if (c < 0x80) {
-            // ASCII
-            bytes = 1;
-            hasValidChars = true;
-        } else if ((c & 0xE0) == 0xC0) {
-            // 2-byte UTF-8
-            bytes = 2;
-            hasValidChars = true;
-        } else if ((c & 0xF0) == 0xE0) {
-            // 3-byte UTF-8 (Japanese characters)
-            bytes = 3;
-            hasValidChars = true;
-        } else if ((c & 0xF8) == 0xF0) {
-            // 4-byte UTF-8
-            bytes = 4;
-            hasValidChars = true;
-        } else {
-            // Invalid UTF-8 sequence
-            return false;
-        }
-        
-        // Verify continuation bytes
-        for (int i = 1; i < bytes && ptr + i < end; i++) {
-            if ((ptr[i] & 0xC0) != 0x80) {
-                return false;  // Invalid continuation byte
-            }
-        }
-        
-        ptr += bytes;
+
+    // Filter out single ASCII punctuation or symbols
+    if (text.length() == 1 && !profile.only(CharClass::Latin) && !profile.only(CharClass::Digit)) {
+        return false;
     }
-    
-    // Only filter out whitespace-only or empty content
-    if (!hasValidChars) {
+
+    // Filter out strings that are clearly broken encoding, and whitespace-only content
+    if (!profile.validUtf8 || profile.only(CharClass::Space)) {
         return false;
     }
-    
+
     // Allow everything else - new words could be anything!
     return true;
 }
 
-bool CandidateFilter::isLikelyFunctionalWord(const std::string& text, int hiraganaCount, int totalChars) {
-    // Length-based heuristics: very short words are often particles
-    if (totalChars == 1) {
-        // Single character hiragana are almost always particles
-        return true;
-    }
-    
-    if (totalChars <= 2) {
-        // Two-character hiragana need more sophisticated checking
-        // Common two-character particles: から, まで, など, だけ, etc.
-        // For now, be conservative and allow them unless they match specific patterns
-        return text.find("から") != std::string::npos ||
-               text.find("まで") != std::string::npos ||
-               text.find("など") != std::string::npos ||
-               text.find("だけ") != std::string::npos;
-    }
-    
-    // Pattern-based checks for functional expressions
-    if (text.find("ということ") != std::string::npos ||
-        text.find("というの") != std::string::npos ||
-        text.find("ではない") != std::string::npos ||
-        text.find("かもしれ") != std::string::npos ||
-        text.find("だろう") != std::string::npos ||
-        text.find("である") != std::string::npos) {
-        return true;
-    }
-    
-    // Polite form endings
-    if (text.length() >= 6) {
-        if (text.find("です") == text.length() - 6 ||
-            text.find("ます") == text.length() - 6 ||
-            text.find("でしょう") == text.length() - 12) {
-            return true;
-        }
-    }
-    
-    // If none of the above patterns match, assume it's a content word
-    return false;
-}
-
-bool CandidateFilter::isCommonParticleOrExpression(const std::string& text) {
-    // This method is kept for backward compatibility but now delegates to the more sophisticated approach
-    return isLikelyFunctionalWord(text, 0, 0);  // We don't have char counts here, so use pattern-only approach
+bool CandidateFilter::isLikelyFunctionalWord(std::string_view text, const TextProfile& profile) const {
+    return rules_.isLikelyFunctional(text, profile);
 }
 
 } // namespace core
@@ -7,9 +7,12 @@
 #define SUZUME_CORE_WORD_EXTRACTION_FILTER_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
+#include "candidate_store.h"
 #include "common.h"
+#include "language_rules.h"
 #include "suzume_feedmill.h"
 
 namespace suzume {
@@ -41,73 +44,105 @@ public:
         const std::function<void(double)>& progressCallback = nullptr
     );
 
-private:
     /**
-     * @brief Remove substring candidates
+     * @brief Filter candidates held in a candidate store
      *
-     * @param candidates Candidates to filter
-     * @return std::vector<VerifiedCandidate> Filtered candidates
+     * @param store Candidate store
+     * @param ids Candidates to filter; narrowed in place, in the same order
+     *        filterCandidates() returns them
+     * @param progressCallback Progress callback function (optional)
      */
-    std::vector<VerifiedCandidate> removeSubstringCandidates(
-        const std::vector<VerifiedCandidate>& candidates
+    void filterCandidates(
+        const CandidateStore& store,
+        std::vector<CandidateStore::Id>& ids,
+        const std::function<void(double)>& progressCallback = nullptr
     );
 
     /**
-     * @brief Remove overlapping candidates
+     * @brief Keep only candidates within the length limits and at or above the minimum score
      *
-     * @param candidates Candidates to filter
-     * @return std::vector<VerifiedCandidate> Filtered candidates
+     * The first step of filterCandidates(); it looks at each candidate on its own.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to filter; narrowed in place, order kept
      */
-    std::vector<VerifiedCandidate> removeOverlappingCandidates(
-        const std::vector<VerifiedCandidate>& candidates
-    );
+    void filterByLengthAndScore(
+        const CandidateStore& store,
+        std::vector<CandidateStore::Id>& ids
+    ) const;
 
     /**
-     * @brief Apply language-specific filters
+     * @brief Mark the candidates that substring or overlap removal compares with another one
      *
-     * @param candidates Candidates to filter
-     * @return std::vector<VerifiedCandidate> Filtered candidates
+     * A candidate is marked when another candidate has the same text,
+     * contains it or is contained in it. Unmarked candidates are kept or
+     * dropped by filterCandidates() on their own, whatever else is selected.
+     * Nothing is marked when both removals are disabled.
+     *
+     * @param store Candidate store
+     * @param ids Candidates that pass filterByLengthAndScore()
+     * @return std::vector<bool> Mark of each position in ids
      */
-    std::vector<VerifiedCandidate> applyLanguageSpecificFilters(
-        const std::vector<VerifiedCandidate>& candidates
+    std::vector<bool> findComparedCandidates(
+        const CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids
+    ) const;
+
+private:
+    /**
+     * @brief Remove substring candidates
+     *
+     * @param store Candidate store
+     * @param selection Candidates still selected; narrowed in place
+     */
+    void removeSubstringCandidates(
+        const CandidateStore& store,
+        std::vector<CandidateStore::Id>& selection
     );
 
     /**
-     * @brief Check if two candidate texts are overlapping
+     * @brief Remove overlapping candidates
      *
-     * @param text1 First candidate text
-     * @param text2 Second candidate text
-     * @return bool True if texts overlap (substring or exact match)
+     * @param store Candidate store
+     * @param selection Candidates still selected; narrowed in
+     *        place and left in descending score order
      */
-    bool isOverlapping(const std::string& text1, const std::string& text2);
+    void removeOverlappingCandidates(
+        const CandidateStore& store,
+        std::vector<CandidateStore::Id>& selection
+    );
 
     /**
-     * @brief Check if text is a likely valid word candidate for discovery
+     * @brief Apply language-specific filters
      *
-     * @param text Text to validate
-     * @return bool True if text could be a valid word (permissive for new word discovery)
+     * @param store Candidate store
+     * @param selection Candidates still selected; narrowed in place
      */
-    bool isLikelyValidWordCandidate(const std::string& text);
+    void applyLanguageSpecificFilters(
+        const CandidateStore& store,
+        std::vector<CandidateStore::Id>& selection
+    );
 
     /**
-     * @brief Check if text is a common Japanese particle or expression
+     * @brief Check if text is a likely valid word candidate for discovery
      *
-     * @param text Text to check
-     * @return bool True if text is a common particle/expression to filter out
+     * @param text Text to validate
+     * @param profile Profile of text from profileText()
+     * @return bool True if text could be a valid word (permissive for new word discovery)
      */
-    bool isCommonParticleOrExpression(const std::string& text);
+    bool isLikelyValidWordCandidate(std::string_view text, const TextProfile& profile) const;
 
     /**
-     * @brief Check if text is likely a functional word using heuristics
+     * @brief Check if text is likely a functional word with the rules of the language
      *
      * @param text Text to check
-     * @param hiraganaCount Number of hiragana characters
-     * @param totalChars Total character count
+     * @param profile Profile of text from profileText()
      * @return bool True if text is likely a functional word to filter out
      */
-    bool isLikelyFunctionalWord(const std::string& text, int hiraganaCount, int totalChars);
+    bool isLikelyFunctionalWord(std::string_view text, const TextProfile& profile) const;
 
     WordExtractionOptions options_;
+    LanguageRules rules_;    // Compiled from options_.languageCode
 };
 
 } // namespace core
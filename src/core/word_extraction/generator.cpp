@@ -4,97 +4,240 @@
  */
 
 #include "generator.h"
+#include "core/pmi.h"
+#include "core/auto_tune.h"
+#include "core/pmi_results.h"
+#include "core/mapped_text.h"
+#include "parallel/executor.h"
 #include <algorithm>
+#include <cctype>
+#include <charconv>
 #include <fstream>
-#include <sstream>
+#include <mutex>
+#include <string_view>
 #include <thread>
-#include <future>
+#include <iterator>
 #include <iostream>
 
 namespace suzume {
 namespace core {
 
-// Helper function to read PMI results from file
-std::vector<std::tuple<std::string, double, uint32_t>> readPmiResults(
+// Helper function to read binary PMI results in place from their mapping
+std::vector<std::tuple<std::string, double, uint32_t>> readBinaryPmiResults(
     const std::string& pmiResultsPath,
     double minPmiScore,
-    const std::function<void(double)>& progressCallback = nullptr
+    const std::function<void(double)>& progressCallback
 ) {
-    std::vector<std::tuple<std::string, double, uint32_t>> results;
-    std::ifstream file(pmiResultsPath);
+    PmiResultsReader reader(pmiResultsPath);
+    if (reader.size() == 0) {
+        throw std::runtime_error("No valid data found in PMI results file: " + pmiResultsPath);
+    }
 
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open PMI results file: " + pmiResultsPath);
+    // Fixed-width columns: no line splitting or number parsing
+    std::vector<std::tuple<std::string, double, uint32_t>> results;
+    for (size_t i = 0; i < reader.size(); ++i) {
+        double score = reader.score(i);
+        if (score >= minPmiScore) {
+            results.emplace_back(std::string(reader.ngram(i)), score, reader.frequency(i));
+        }
+    }
+    if (progressCallback) {
+        progressCallback(0.25); // Reading is 25% of total progress
     }
 
-    // Validate minPmiScore
-    if (minPmiScore < 0) {
-        throw std::invalid_argument("Minimum PMI score must be non-negative");
+    if (results.empty()) {
+        std::cerr << "Warning: No n-grams with PMI score >= " << minPmiScore << " found in " << pmiResultsPath << std::endl;
     }
+    return results;
+}
 
-    // Get file size for progress reporting
-    file.seekg(0, std::ios::end);
-    size_t fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
+namespace {
 
-    // Check if file is empty
-    if (fileSize == 0) {
-        throw std::runtime_error("PMI results file is empty: " + pmiResultsPath);
-    }
+using PmiRow = std::tuple<std::string, double, uint32_t>;
 
-    std::string line;
-    size_t processedBytes = 0;
-    size_t lineCount = 0;
+// Below this many bytes per chunk, threads cost more than they save
+constexpr size_t kMinParseChunkBytes = 1 << 20;
 
-    // Skip header if present
-    if (std::getline(file, line) && line.find("ngram") != std::string::npos) {
-        processedBytes += line.size() + 1; // +1 for newline
-    } else {
-        // If no header, reset file position
-        file.seekg(0, std::ios::beg);
+// Fewest n-grams a selection worker is started for
+constexpr uint64_t kMinNgramsPerThread = 1000;
+
+// Skip the blanks operator>> would skip before a number
+const char* skipSpace(const char* cursor, const char* end) {
+    while (cursor < end && std::isspace(static_cast<unsigned char>(*cursor))) {
+        ++cursor;
     }
+    return cursor;
+}
 
-    // Read PMI results
-    while (std::getline(file, line)) {
-        processedBytes += line.size() + 1; // +1 for newline
-        lineCount++;
+/**
+ * Parse one "ngram<TAB>score<TAB>freq" line as the stream extraction did:
+ * the n-gram ends at the first tab, blanks before each number are skipped
+ * and anything after the frequency is ignored.
+ */
+bool parsePmiLine(std::string_view line, std::string_view& ngram, double& score, uint32_t& freq) {
+    size_t tab = line.find('\t');
+    if (tab == std::string_view::npos) {
+        return false;
+    }
+    ngram = line.substr(0, tab);
+    const char* end = line.data() + line.size();
+    const char* cursor = skipSpace(line.data() + tab + 1, end);
+    if (cursor < end && *cursor == '+') {
+        ++cursor;
+    }
+    auto parsedScore = std::from_chars(cursor, end, score);
+    if (parsedScore.ec != std::errc()) {
+        return false;
+    }
+    cursor = skipSpace(parsedScore.ptr, end);
+    if (cursor < end && *cursor == '+') {
+        ++cursor;
+    }
+    return std::from_chars(cursor, end, freq).ec == std::errc();
+}
 
-        std::istringstream iss(line);
-        std::string ngram;
-        double score;
-        uint32_t freq;
+// Rows of one chunk, kept apart so chunks can be parsed in any order
+struct ParsedChunk {
+    std::vector<PmiRow> rows;
+    std::vector<std::string> malformed;
+    size_t lines = 0;
+};
 
-        if (std::getline(iss, ngram, '\t') &&
-            iss >> score &&
-            iss >> freq) {
+void parsePmiChunk(std::string_view chunk, double minPmiScore, ParsedChunk& parsed) {
+    for (std::string_view line : LineRange(chunk)) {
+        parsed.lines++;
 
+        std::string_view ngram;
+        double score;
+        uint32_t freq;
+        if (parsePmiLine(line, ngram, score, freq)) {
             if (score >= minPmiScore) {
-                results.emplace_back(ngram, score, freq);
+                parsed.rows.emplace_back(std::string(ngram), score, freq);
             }
         } else {
-            // Log malformed line but continue processing
-            std::cerr << "Warning: Malformed line in PMI results file: " << line << std::endl;
+            parsed.malformed.emplace_back(line);
         }
+    }
+}
+
+} // namespace
+
+// Helper function to parse PMI results TSV held in memory
+std::vector<std::tuple<std::string, double, uint32_t>> parsePmiText(
+    std::string_view text,
+    double minPmiScore,
+    unsigned int threads,
+    const std::function<void(double)>& progressCallback,
+    const std::string& source
+) {
+    const size_t fileSize = text.size();
 
-        // Report progress
-        if (progressCallback && fileSize > 0) {
-            progressCallback(static_cast<double>(processedBytes) / fileSize * 0.25); // Reading is 25% of total progress
+    // Skip header if present
+    size_t headerEnd = text.find('\n');
+    std::string_view header = text.substr(0, headerEnd);
+    if (header.find("ngram") != std::string_view::npos) {
+        text.remove_prefix(headerEnd == std::string_view::npos ? text.size() : headerEnd + 1);
+    }
+    size_t headerBytes = fileSize - text.size();
+
+    // Split at newlines into chunks that are parsed independently
+    threads = resolveThreads(threads);
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(size_t{4} * threads, text.size() / kMinParseChunkBytes));
+    std::vector<size_t> bounds{0};
+    for (size_t c = 1; c < chunkCount; ++c) {
+        size_t cut = text.find('\n', std::max(bounds.back(), text.size() / chunkCount * c));
+        if (cut == std::string_view::npos || cut + 1 >= text.size()) {
+            break;
         }
+        bounds.push_back(cut + 1);
+    }
+    bounds.push_back(text.size());
+    chunkCount = bounds.size() - 1;
+
+    // Progress moves once per parsed chunk
+    std::vector<ParsedChunk> chunks(chunkCount);
+    std::mutex progressMutex;
+    size_t parsedBytes = headerBytes;
+    auto parseRange = [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            parsePmiChunk(text.substr(bounds[c], bounds[c + 1] - bounds[c]), minPmiScore, chunks[c]);
+            if (progressCallback) {
+                std::lock_guard<std::mutex> lock(progressMutex);
+                parsedBytes += bounds[c + 1] - bounds[c];
+                progressCallback(static_cast<double>(parsedBytes) / fileSize * 0.25); // Reading is 25% of total progress
+            }
+        }
+    };
+    if (chunkCount > 1) {
+        parallel::ParallelExecutor::parallelFor(chunkCount, parseRange, static_cast<unsigned int>(std::min<size_t>(threads, chunkCount)), 1);
+    } else {
+        parseRange(0, 1);
+    }
+
+    // Join the chunks in file order
+    size_t lineCount = 0;
+    size_t rowCount = 0;
+    for (const auto& chunk : chunks) {
+        lineCount += chunk.lines;
+        rowCount += chunk.rows.size();
+    }
+    std::vector<PmiRow> results;
+    results.reserve(rowCount);
+    for (auto& chunk : chunks) {
+        for (const auto& line : chunk.malformed) {
+            // Log malformed line but continue processing
+            std::cerr << "Warning: Malformed line in PMI results file: " << line << std::endl;
+        }
+        std::move(chunk.rows.begin(), chunk.rows.end(), std::back_inserter(results));
     }
 
     // Check if we read any valid lines
     if (lineCount == 0) {
-        throw std::runtime_error("No valid data found in PMI results file: " + pmiResultsPath);
+        throw std::runtime_error("No valid data found in PMI results file: " + source);
     }
 
     // Check if we found any results
     if (results.empty()) {
-        std::cerr << "Warning: No n-grams with PMI score >= " << minPmiScore << " found in " << pmiResultsPath << std::endl;
+        std::cerr << "Warning: No n-grams with PMI score >= " << minPmiScore << " found in " << source << std::endl;
     }
 
     return results;
 }
 
+// Helper function to read PMI results from file
+std::vector<std::tuple<std::string, double, uint32_t>> readPmiResults(
+    const std::string& pmiResultsPath,
+    double minPmiScore,
+    unsigned int threads,
+    const std::function<void(double)>& progressCallback = nullptr
+) {
+    std::ifstream file(pmiResultsPath, std::ios::binary);
+
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open PMI results file: " + pmiResultsPath);
+    }
+
+    // Validate minPmiScore
+    if (minPmiScore < 0) {
+        throw std::invalid_argument("Minimum PMI score must be non-negative");
+    }
+
+    // Results written with PmiOptions::binaryOutputPath are read without parsing
+    if (isPmiResultsFile(pmiResultsPath)) {
+        return readBinaryPmiResults(pmiResultsPath, minPmiScore, progressCallback);
+    }
+
+    // Parse the mapped file in place; it is read only where it cannot be mapped
+    file.close();
+    MappedText contents(pmiResultsPath);
+
+    // Check if file is empty
+    if (contents.text().empty()) {
+        throw std::runtime_error("PMI results file is empty: " + pmiResultsPath);
+    }
+    return parsePmiText(contents.text(), minPmiScore, threads, progressCallback, pmiResultsPath);
+}
+
 CandidateGenerator::CandidateGenerator(const WordExtractionOptions& options)
     : options_(options)
 {
@@ -105,8 +248,45 @@ std::vector<WordCandidate> CandidateGenerator::generateCandidates(
     const std::function<void(double)>& progressCallback
 ) {
     // Read PMI results
-    auto ngrams = readPmiResults(pmiResultsPath, options_.minPmiScore, progressCallback);
+    unsigned int threads = options_.useParallelProcessing ? options_.threads : 1;
+    auto ngrams = readPmiResults(pmiResultsPath, options_.minPmiScore, threads, progressCallback);
+    return generateFromNgrams(ngrams);
+}
+
+std::vector<WordCandidate> CandidateGenerator::generateCandidatesFromText(
+    std::string_view pmiText,
+    const std::function<void(double)>& progressCallback
+) {
+    if (options_.minPmiScore < 0) {
+        throw std::invalid_argument("Minimum PMI score must be non-negative");
+    }
+    if (pmiText.empty()) {
+        throw std::runtime_error("PMI results buffer is empty");
+    }
+    unsigned int threads = options_.useParallelProcessing ? options_.threads : 1;
+    auto ngrams = parsePmiText(pmiText, options_.minPmiScore, threads, progressCallback, "buffer");
+    return generateFromNgrams(ngrams);
+}
 
+std::vector<WordCandidate> CandidateGenerator::generateCandidates(
+    const std::vector<PmiItem>& pmiItems,
+    const std::function<void(double)>& progressCallback
+) {
+    std::vector<std::tuple<std::string, double, uint32_t>> ngrams;
+    for (const auto& item : pmiItems) {
+        if (item.score >= options_.minPmiScore) {
+            ngrams.emplace_back(item.ngram, item.score, item.frequency);
+        }
+    }
+    if (progressCallback) {
+        progressCallback(0.25); // Reading is 25% of total progress
+    }
+    return generateFromNgrams(ngrams);
+}
+
+std::vector<WordCandidate> CandidateGenerator::generateFromNgrams(
+    const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams
+) {
     // Build tries
     for (const auto& [ngram, score, freq] : ngrams) {
         forwardTrie_.add(ngram, score, freq);
@@ -124,103 +304,78 @@ std::vector<WordCandidate> CandidateGenerator::generateCandidates(
 std::vector<WordCandidate> CandidateGenerator::generateCandidatesParallel(
     const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams
 ) {
-    // Determine number of threads to use
-    unsigned int numThreads = options_.threads;
-    if (numThreads == 0) {
-        // Auto-detect number of threads
-        numThreads = std::thread::hardware_concurrency();
-        if (numThreads == 0) {
-            // Fallback if hardware_concurrency returns 0
-            numThreads = 4;
-        }
-    }
-
-    // If only 1 thread or very few ngrams, use sequential processing
-    if (numThreads == 1 || ngrams.size() < 1000) {
+    // Workers are sized for the n-grams; few n-grams are selected on this thread
+    WorkloadShape shape;
+    shape.items = ngrams.size();
+    shape.minItemsPerThread = kMinNgramsPerThread;
+    unsigned int numThreads = tuneWorkers(options_.threads, shape).threads;
+    if (numThreads == 1) {
         return generateCandidatesSequential(ngrams);
     }
 
-    // Divide ngrams into chunks for parallel processing
-    std::vector<std::vector<std::tuple<std::string, double, uint32_t>>> chunks(numThreads);
-    size_t chunkSize = ngrams.size() / numThreads;
-    size_t remainder = ngrams.size() % numThreads;
-
-    size_t currentIndex = 0;
-    for (unsigned int i = 0; i < numThreads; ++i) {
-        size_t currentChunkSize = chunkSize + (i < remainder ? 1 : 0);
-        chunks[i].reserve(currentChunkSize);
-
-        for (size_t j = 0; j < currentChunkSize && currentIndex < ngrams.size(); ++j) {
-            chunks[i].push_back(ngrams[currentIndex++]);
-        }
-    }
-
-    // Process each chunk in a separate thread
-    std::vector<std::future<std::vector<WordCandidate>>> futures;
-    for (const auto& chunk : chunks) {
-        futures.push_back(std::async(std::launch::async, [this, &chunk]() {
-            return this->generateCandidatesSequential(chunk);
-        }));
-    }
-
-    // Collect results
-    std::vector<WordCandidate> candidates;
-    for (auto& future : futures) {
-        auto chunkResults = future.get();
-        candidates.insert(candidates.end(), chunkResults.begin(), chunkResults.end());
-    }
-
-    // Limit number of candidates if needed
-    if (candidates.size() > options_.maxCandidates) {
-        // Sort by score
-        std::sort(candidates.begin(), candidates.end(),
-            [](const WordCandidate& a, const WordCandidate& b) {
-                return a.score > b.score;
-            });
-
-        // Keep only top candidates
-        candidates.resize(options_.maxCandidates);
-    }
-
-    return candidates;
+    // Workers claim index ranges of the shared n-grams and keep each range's
+    // best in a bounded heap; the heaps merge into the final selection
+    NgramSelection identity{NgramSelector(options_.maxCandidates), 0};
+    NgramSelection selection = parallel::ParallelExecutor::parallelReduce<NgramSelection>(
+        ngrams.size(), identity,
+        [&](size_t begin, size_t end) {
+            return selectNgrams(ngrams, begin, end);
+        },
+        [](NgramSelection all, NgramSelection part) {
+            all.selector.merge(std::move(part.selector));
+            all.eligible += part.eligible;
+            return all;
+        },
+        numThreads);
+
+    return makeCandidates(ngrams, std::move(selection));
 }
 
 std::vector<WordCandidate> CandidateGenerator::generateCandidatesSequential(
     const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams
 ) {
-    std::vector<WordCandidate> candidates;
-    
-    // Pre-allocate vector for better performance
-    candidates.reserve(std::min(ngrams.size(), static_cast<size_t>(options_.maxCandidates)));
+    return makeCandidates(ngrams, selectNgrams(ngrams, 0, ngrams.size()));
+}
 
-    // Simple implementation for now - just convert n-grams to candidates
-    // This will be expanded with more sophisticated candidate generation logic
-    for (const auto& [ngram, score, freq] : ngrams) {
+CandidateGenerator::NgramSelection CandidateGenerator::selectNgrams(
+    const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams,
+    size_t begin,
+    size_t end
+) const {
+    NgramSelection selection{NgramSelector(options_.maxCandidates), 0};
+    for (size_t index = begin; index < end; ++index) {
+        const auto& [ngram, score, freq] = ngrams[index];
         if (ngram.length() <= options_.maxCandidateLength) {
-            WordCandidate candidate;
-            candidate.text = ngram;
-            candidate.score = score;
-            candidate.frequency = freq;
-            candidate.verified = false;
-
-            candidates.emplace_back(std::move(candidate)); // Use emplace_back for efficiency
+            selection.selector.push({score, index});
+            selection.eligible++;
         }
     }
+    return selection;
+}
 
-    // Limit number of candidates if needed
-    if (candidates.size() > options_.maxCandidates) {
-        // Use partial_sort for better performance when we only need top K elements
-        std::partial_sort(candidates.begin(), 
-                         candidates.begin() + options_.maxCandidates,
-                         candidates.end(),
-                         [](const WordCandidate& a, const WordCandidate& b) {
-                             return a.score > b.score;
-                         });
-
-        // Keep only top candidates
-        candidates.resize(options_.maxCandidates);
+std::vector<WordCandidate> CandidateGenerator::makeCandidates(
+    const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams,
+    NgramSelection selection
+) const {
+    // Best first when candidates were dropped; in input order when all fit
+    std::vector<SelectedNgram> selected = selection.selector.take();
+    if (selection.eligible <= options_.maxCandidates) {
+        std::sort(selected.begin(), selected.end(), [](const SelectedNgram& a, const SelectedNgram& b) {
+            return a.index < b.index;
+        });
     }
 
+    std::vector<WordCandidate> candidates;
+    candidates.reserve(selected.size());
+    for (const SelectedNgram& entry : selected) {
+        const auto& [ngram, score, freq] = ngrams[entry.index];
+        WordCandidate candidate;
+        candidate.text = ngram;
+        candidate.score = score;
+        candidate.frequency = freq;
+        candidate.verified = false;
+        candidates.emplace_back(std::move(candidate));
+    }
     return candidates;
 }
 
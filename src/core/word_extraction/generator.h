@@ -7,16 +7,20 @@
 #define SUZUME_CORE_WORD_EXTRACTION_GENERATOR_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <tuple>
 #include <functional>
 #include "common.h"
 #include "trie.h"
+#include "core/top_k.h"
 #include "suzume_feedmill.h"
 
 namespace suzume {
 namespace core {
 
+struct PmiItem;
+
 /**
  * @brief Candidate generator class
  *
@@ -43,7 +47,72 @@ public:
         const std::function<void(double)>& progressCallback = nullptr
     );
 
+    /**
+     * @brief Generate candidates from PMI results held in memory
+     *
+     * @param pmiItems PMI results, as calculated
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<WordCandidate> Generated candidates
+     */
+    std::vector<WordCandidate> generateCandidates(
+        const std::vector<PmiItem>& pmiItems,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
+    /**
+     * @brief Generate candidates from PMI results TSV held in memory
+     *
+     * The text is parsed in place as a results file would be, with an
+     * optional header line.
+     *
+     * @param pmiText PMI results as "ngram<TAB>pmi<TAB>frequency" lines
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<WordCandidate> Generated candidates
+     * @throws std::runtime_error If the text is empty or holds no valid line
+     */
+    std::vector<WordCandidate> generateCandidatesFromText(
+        std::string_view pmiText,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
 private:
+    /**
+     * @brief Position of a kept n-gram in the input and its score
+     */
+    struct SelectedNgram {
+        double score;
+        size_t index;
+    };
+
+    /**
+     * @brief Higher score first, then earlier in the input
+     */
+    struct BetterNgram {
+        bool operator()(const SelectedNgram& a, const SelectedNgram& b) const {
+            return a.score != b.score ? a.score > b.score : a.index < b.index;
+        }
+    };
+
+    using NgramSelector = TopKSelector<SelectedNgram, BetterNgram>;
+
+    /**
+     * @brief Best maxCandidates n-grams of a range and how many were eligible
+     */
+    struct NgramSelection {
+        NgramSelector selector;
+        size_t eligible;
+    };
+
+    /**
+     * @brief Build the tries and generate candidates from n-grams
+     *
+     * @param ngrams N-grams at or above the minimum PMI score
+     * @return std::vector<WordCandidate> Generated candidates
+     */
+    std::vector<WordCandidate> generateFromNgrams(
+        const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams
+    );
+
     /**
      * @brief Generate candidates in parallel
      *
@@ -64,9 +133,36 @@ private:
         const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams
     );
 
+    /**
+     * @brief Keep the best n-grams of an index range that fit maxCandidateLength
+     *
+     * @param ngrams Input n-grams (read in place)
+     * @param begin First index of the range
+     * @param end One past the last index of the range
+     * @return NgramSelection Up to maxCandidates n-grams and the eligible count
+     */
+    NgramSelection selectNgrams(
+        const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams,
+        size_t begin,
+        size_t end
+    ) const;
+
+    /**
+     * @brief Copy the selected n-grams into candidates
+     *
+     * @param ngrams Input n-grams
+     * @param selection Selection over ngrams
+     * @return std::vector<WordCandidate> Candidates in input order if none was
+     *         dropped, by descending score (ties in input order) otherwise
+     */
+    std::vector<WordCandidate> makeCandidates(
+        const std::vector<std::tuple<std::string, double, uint32_t>>& ngrams,
+        NgramSelection selection
+    ) const;
+
     WordExtractionOptions options_;
     NGramTrie forwardTrie_;  // For prefix matching
-    NGramTrie backwardTrie_; // For suffix matching
+    NGramTrie backwardTrie_{NGramTrie::KeyOrder::Reversed}; // For suffix matching
 };
 
 } // namespace core
@@ -0,0 +1,196 @@
+/**
+ * @file incremental_state.cpp
+ * @brief Implementation of the candidate evidence kept between runs
+ */
+
+#include "incremental_state.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "core/output_writer.h"
+#include "xxhash.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+constexpr char kStateHeader[] = "# suzume-feedmill word-extract state v1 text_hash=";
+constexpr char kEvidenceField[] = " evidence=";
+constexpr char kStateColumns[] = "text\tscore\tfrequency\tcount\tfirst\tdistinct_contexts\tcontext";
+
+template <typename T>
+T parseField(std::string_view field, const std::string& path, int base = 10) {
+    T value{};
+    auto parsed = std::from_chars(field.data(), field.data() + field.size(), value, base);
+    if (field.empty() || parsed.ec != std::errc() || parsed.ptr != field.data() + field.size()) {
+        throw std::runtime_error("Malformed word extraction state file: " + path);
+    }
+    return value;
+}
+
+double parseScore(std::string_view field, const std::string& path) {
+    double value = 0.0;
+    auto parsed = std::from_chars(field.data(), field.data() + field.size(), value);
+    if (field.empty() || parsed.ec != std::errc() || parsed.ptr != field.data() + field.size()) {
+        throw std::runtime_error("Malformed word extraction state file: " + path);
+    }
+    return value;
+}
+
+bool withinTolerance(double current, double previous, double tolerance) {
+    return std::fabs(current - previous) <= tolerance * std::max(1.0, std::fabs(previous));
+}
+
+} // namespace
+
+IncrementalState::IncrementalState(const std::string& path, uint64_t textHash, unsigned int evidenceLevel, double tolerance)
+    : path_(path), textHash_(textHash), evidenceLevel_(evidenceLevel), tolerance_(tolerance) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return;
+    }
+
+    // Header: the text hash, then what evidence was gathered
+    std::string line;
+    const std::string_view header(kStateHeader);
+    if (!std::getline(input, line) || line.compare(0, header.size(), header) != 0) {
+        throw std::runtime_error("Not a word extraction state file: " + path);
+    }
+    std::string_view rest = std::string_view(line).substr(header.size());
+    const std::string_view evidenceField(kEvidenceField);
+    size_t space = rest.find(evidenceField);
+    if (space == std::string_view::npos) {
+        throw std::runtime_error("Malformed word extraction state file: " + path);
+    }
+    uint64_t previousHash = parseField<uint64_t>(rest.substr(0, space), path, 16);
+    unsigned int previousLevel = parseField<unsigned int>(rest.substr(space + evidenceField.size()), path);
+    if (!std::getline(input, line) || line != kStateColumns) {
+        throw std::runtime_error("Not a word extraction state file: " + path);
+    }
+    if (previousLevel != evidenceLevel_) {
+        return;
+    }
+    sameText_ = previousHash == textHash_;
+
+    while (std::getline(input, line)) {
+        // Six tab-separated fields, then the context with any tabs it holds
+        std::string_view row(line);
+        std::string_view fields[6];
+        for (auto& field : fields) {
+            size_t tab = row.find('\t');
+            if (tab == std::string_view::npos) {
+                throw std::runtime_error("Malformed word extraction state file: " + path);
+            }
+            field = row.substr(0, tab);
+            row.remove_prefix(tab + 1);
+        }
+        CachedEvidence evidence;
+        evidence.score = parseScore(fields[1], path);
+        evidence.frequency = parseField<uint32_t>(fields[2], path);
+        evidence.count = parseField<uint64_t>(fields[3], path);
+        evidence.first = parseField<uint64_t>(fields[4], path);
+        evidence.distinctContexts = parseField<uint64_t>(fields[5], path);
+        evidence.context = std::string(row);
+        previous_.emplace(std::string(fields[0]), std::move(evidence));
+    }
+    if (input.bad()) {
+        throw std::runtime_error("Failed to read word extraction state file: " + path);
+    }
+}
+
+uint64_t IncrementalState::hashFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Failed to open original text file: " + path);
+    }
+    std::unique_ptr<XXH3_state_t, decltype(&XXH3_freeState)> state(XXH3_createState(), &XXH3_freeState);
+    XXH3_64bits_reset(state.get());
+    std::vector<char> block(1 << 20);
+    while (input) {
+        input.read(block.data(), static_cast<std::streamsize>(block.size()));
+        XXH3_64bits_update(state.get(), block.data(), static_cast<size_t>(input.gcount()));
+    }
+    if (input.bad()) {
+        throw std::runtime_error("Failed to read original text file: " + path);
+    }
+    return XXH3_64bits_digest(state.get());
+}
+
+const CachedEvidence* IncrementalState::reusable(std::string_view text, double score, uint32_t frequency) const {
+    auto it = previous_.find(text);
+    if (it == previous_.end()) {
+        return nullptr;
+    }
+    const CachedEvidence& evidence = it->second;
+    if (sameText_) {
+        return &evidence;
+    }
+    if (!withinTolerance(score, evidence.score, tolerance_) ||
+        !withinTolerance(static_cast<double>(frequency), static_cast<double>(evidence.frequency), tolerance_)) {
+        return nullptr;
+    }
+    return &evidence;
+}
+
+void IncrementalState::record(std::string_view text, CachedEvidence evidence) {
+    // A tab or newline in the text would break its row
+    if (text.empty() || text.find_first_of("\t\n") != std::string_view::npos) {
+        return;
+    }
+    current_.insert_or_assign(std::string(text), std::move(evidence));
+}
+
+void IncrementalState::save() const {
+    static constexpr char kHexDigits[] = "0123456789abcdef";
+    char hash[16];
+    for (int i = 0; i < 16; ++i) {
+        hash[i] = kHexDigits[(textHash_ >> (60 - 4 * i)) & 0xF];
+    }
+
+    // Written aside and renamed, so an interrupted run keeps the previous state
+    std::string tempPath = path_ + ".tmp";
+    prepareOutputPath(path_);
+    {
+        OutputWriter output(tempPath);
+        output.write(kStateHeader);
+        output.write(std::string_view(hash, sizeof(hash)));
+        output.write(kEvidenceField);
+        output.writeNumber(static_cast<uint64_t>(evidenceLevel_));
+        output.put('\n');
+        output.write(kStateColumns);
+        output.put('\n');
+        for (const auto& entry : current_) {
+            const CachedEvidence& evidence = entry.second;
+            output.write(entry.first);
+            output.put('\t');
+            output.writeNumber(evidence.score);
+            output.put('\t');
+            output.writeNumber(static_cast<uint64_t>(evidence.frequency));
+            output.put('\t');
+            output.writeNumber(evidence.count);
+            output.put('\t');
+            output.writeNumber(evidence.first);
+            output.put('\t');
+            output.writeNumber(evidence.distinctContexts);
+            output.put('\t');
+            output.write(evidence.context);
+            output.put('\n');
+        }
+        output.close();
+    }
+    std::error_code error;
+    std::filesystem::rename(tempPath, path_, error);
+    if (error) {
+        std::filesystem::remove(tempPath, error);
+        throw std::runtime_error("Failed to write word extraction state file: " + path_);
+    }
+}
+
+} // namespace core
+} // namespace suzume
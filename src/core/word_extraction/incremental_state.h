@@ -0,0 +1,132 @@
+/**
+ * @file incremental_state.h
+ * @brief Candidate evidence kept between word extraction runs
+ */
+
+#ifndef SUZUME_CORE_WORD_EXTRACTION_INCREMENTAL_STATE_H_
+#define SUZUME_CORE_WORD_EXTRACTION_INCREMENTAL_STATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "core/counting_map.h"
+#include "robin_hood.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief What the original text said about one candidate in an earlier run
+ */
+struct CachedEvidence {
+    double score = 0.0;             ///< PMI score of the candidate when the evidence was gathered
+    uint32_t frequency = 0;         ///< Frequency of the candidate when the evidence was gathered
+    uint64_t count = 0;             ///< Non-overlapping occurrences in the text
+    uint64_t first = 0;             ///< Byte position of the first occurrence
+    uint64_t distinctContexts = 0;  ///< Lower bound on the distinct contexts (0 = unknown)
+    std::string context;            ///< Context of the first occurrence (empty without contextual analysis)
+};
+
+/**
+ * @brief Evidence of the candidates of the previous run, and of this one
+ *
+ * Searching the original text is the expensive part of verification; the
+ * other steps (thresholds, scores, the dictionary) are cheap and run again
+ * on every candidate. The state file keeps, per candidate, the occurrences
+ * and context found in the text, the PMI score and frequency they were
+ * found for, and the XXH3 hash of the text.
+ *
+ * Over the same text the evidence of a candidate is exact and always
+ * reused. Over a changed text it is reused while the candidate's PMI score
+ * and frequency stay within the tolerance of the recorded ones, relative
+ * to them (and to at least 1); the others are searched again. Every
+ * candidate of this run is recorded and save() replaces the file, so
+ * candidates that no longer appear are dropped.
+ *
+ * The evidence level says what was gathered: 0 nothing, 1 occurrences,
+ * 2 occurrences and contexts. A state of another level is not used.
+ *
+ * State file layout (UTF-8 text, '\n'-terminated lines):
+ *
+ *   # suzume-feedmill word-extract state v1 text_hash=<16 hex digits> evidence=<level>
+ *   text  score  frequency  count  first  distinct_contexts  context
+ *   one tab-separated row per candidate; the context may hold tabs
+ */
+class IncrementalState {
+public:
+    /**
+     * @brief Load the state of the previous run, if there is a usable one
+     *
+     * A missing file starts an empty state, and so does a state of another
+     * evidence level.
+     *
+     * @param path State file path
+     * @param textHash XXH3 hash of the original text of this run
+     * @param evidenceLevel What this run gathers (0 nothing, 1 occurrences, 2 occurrences and contexts)
+     * @param tolerance Relative change of PMI score and frequency that keeps evidence over a changed text
+     * @throws std::runtime_error If the file exists but is not a state file
+     */
+    IncrementalState(const std::string& path, uint64_t textHash, unsigned int evidenceLevel, double tolerance);
+
+    /**
+     * @brief Find the recorded evidence of a candidate, if it can be reused
+     *
+     * @param text Candidate text
+     * @param score Current PMI score
+     * @param frequency Current frequency
+     * @return const CachedEvidence* Evidence to reuse, or nullptr to search the text
+     */
+    const CachedEvidence* reusable(std::string_view text, double score, uint32_t frequency) const;
+
+    /**
+     * @brief Record the evidence of a candidate of this run
+     *
+     * @param text Candidate text (texts holding a tab or newline are not kept)
+     * @param evidence Evidence with the current PMI score and frequency
+     */
+    void record(std::string_view text, CachedEvidence evidence);
+
+    /**
+     * @brief Replace the state file with the candidates recorded in this run
+     * @throws std::runtime_error If the file cannot be written
+     */
+    void save() const;
+
+    /**
+     * @brief Hash a text file as it is stored, block by block
+     *
+     * @param path Text file path
+     * @return uint64_t XXH3 hash of the file bytes
+     * @throws std::runtime_error If the file cannot be read
+     */
+    static uint64_t hashFile(const std::string& path);
+
+    /**
+     * @brief Check whether the previous run saw the same text
+     * @return bool True if the recorded text hash matches
+     */
+    bool sameText() const { return sameText_; }
+
+    /**
+     * @brief Get the number of candidates loaded from the previous run
+     * @return size_t Candidate count
+     */
+    size_t previousSize() const { return previous_.size(); }
+
+private:
+    using Entries = robin_hood::unordered_node_map<std::string, CachedEvidence, Utf8KeyHash, Utf8KeyEqual>;
+
+    std::string path_;
+    uint64_t textHash_;
+    unsigned int evidenceLevel_;
+    double tolerance_;
+    bool sameText_ = false;
+    Entries previous_;
+    Entries current_;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_WORD_EXTRACTION_INCREMENTAL_STATE_H_
@@ -0,0 +1,209 @@
+/**
+ * @file language_rules.cpp
+ * @brief Implementation of code point classes and per-language rules
+ */
+
+#include "language_rules.h"
+
+namespace suzume {
+namespace core {
+
+namespace {
+
+/**
+ * @brief Expression rule as written in a language table
+ */
+struct RuleSpec {
+    const char* expression;
+    bool suffixOnly;
+    size_t maxCodePoints;
+};
+
+// Japanese particles, auxiliaries and polite endings
+const RuleSpec kJapaneseRules[] = {
+    // Two-character particles, as the whole candidate
+    {"から", false, 2},
+    {"まで", false, 2},
+    {"など", false, 2},
+    {"だけ", false, 2},
+    // Functional expressions
+    {"ということ", false, 0},
+    {"というの", false, 0},
+    {"ではない", false, 0},
+    {"かもしれ", false, 0},
+    {"だろう", false, 0},
+    {"である", false, 0},
+    // Polite form endings
+    {"です", true, 0},
+    {"ます", true, 0},
+    {"でしょう", true, 0},
+};
+
+// Class of every code point of the Basic Multilingual Plane
+struct BmpTable {
+    std::array<CharClass, 0x10000> classes;
+
+    BmpTable() {
+        classes.fill(CharClass::Other);
+        auto set = [this](char32_t first, char32_t last, CharClass charClass) {
+            for (char32_t c = first; c <= last; ++c) {
+                classes[c] = charClass;
+            }
+        };
+
+        // ASCII: printable non-alphanumerics are symbols
+        set(0x21, 0x7E, CharClass::Symbol);
+        set('0', '9', CharClass::Digit);
+        set('A', 'Z', CharClass::Latin);
+        set('a', 'z', CharClass::Latin);
+        set(0x09, 0x0D, CharClass::Space);
+        set(0x20, 0x20, CharClass::Space);
+
+        // Latin-1 and Latin extended letters
+        set(0xA0, 0xA0, CharClass::Space);
+        set(0xA1, 0xBF, CharClass::Symbol);
+        set(0xC0, 0x24F, CharClass::Latin);
+        set(0xD7, 0xD7, CharClass::Symbol);
+        set(0xF7, 0xF7, CharClass::Symbol);
+
+        // General punctuation, letterlike symbols, arrows, math, boxes, dingbats
+        set(0x2000, 0x200A, CharClass::Space);
+        set(0x2010, 0x2BFF, CharClass::Symbol);
+
+        // CJK symbols and punctuation; iteration and closing marks are Kanji
+        set(0x3000, 0x3000, CharClass::Space);
+        set(0x3001, 0x303F, CharClass::Symbol);
+        set(0x3005, 0x3007, CharClass::Kanji);
+
+        // Kana
+        set(0x3041, 0x309F, CharClass::Hiragana);
+        set(0x30A0, 0x30FF, CharClass::Katakana);
+        set(0x31F0, 0x31FF, CharClass::Katakana);
+
+        // CJK ideographs: extension A, unified, compatibility
+        set(0x3400, 0x4DBF, CharClass::Kanji);
+        set(0x4E00, 0x9FFF, CharClass::Kanji);
+        set(0xF900, 0xFAFF, CharClass::Kanji);
+
+        // Full-width forms and half-width katakana
+        set(0xFF01, 0xFF65, CharClass::Symbol);
+        set(0xFF10, 0xFF19, CharClass::Digit);
+        set(0xFF21, 0xFF3A, CharClass::Latin);
+        set(0xFF41, 0xFF5A, CharClass::Latin);
+        set(0xFF66, 0xFF9F, CharClass::Katakana);
+        set(0xFFE0, 0xFFEE, CharClass::Symbol);
+    }
+};
+
+const BmpTable& bmpTable() {
+    static const BmpTable table;
+    return table;
+}
+
+// Language part of a code such as "ja-JP" or "ja_JP"
+std::string_view primaryLanguage(std::string_view languageCode) {
+    size_t separator = languageCode.find_first_of("-_");
+    return languageCode.substr(0, separator);
+}
+
+} // namespace
+
+CharClass classifyCodePoint(char32_t codePoint) {
+    if (codePoint < 0x10000) {
+        return bmpTable().classes[codePoint];
+    }
+    // CJK extensions B and later, and compatibility supplement
+    if (codePoint >= 0x20000 && codePoint <= 0x3FFFF) {
+        return CharClass::Kanji;
+    }
+    return CharClass::Other;
+}
+
+TextProfile profileText(std::string_view text) {
+    TextProfile profile;
+    const BmpTable& table = bmpTable();
+    const unsigned char* p = reinterpret_cast<const unsigned char*>(text.data());
+    const unsigned char* end = p + text.size();
+
+    while (p < end) {
+        unsigned char lead = *p;
+        char32_t codePoint;
+        size_t length;
+        if (lead < 0x80) {
+            codePoint = lead;
+            length = 1;
+        } else if (lead >= 0xC2 && lead <= 0xDF) {
+            codePoint = lead & 0x1F;
+            length = 2;
+        } else if (lead >= 0xE0 && lead <= 0xEF) {
+            codePoint = lead & 0x0F;
+            length = 3;
+        } else if (lead >= 0xF0 && lead <= 0xF4) {
+            codePoint = lead & 0x07;
+            length = 4;
+        } else {
+            profile.validUtf8 = false;
+            return profile;
+        }
+        if (static_cast<size_t>(end - p) < length) {
+            profile.validUtf8 = false;
+            return profile;
+        }
+        for (size_t i = 1; i < length; ++i) {
+            if ((p[i] & 0xC0) != 0x80) {
+                profile.validUtf8 = false;
+                return profile;
+            }
+            codePoint = (codePoint << 6) | (p[i] & 0x3F);
+        }
+        // Overlong forms, surrogates and code points past U+10FFFF
+        if ((length == 3 && (codePoint < 0x800 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))) ||
+            (length == 4 && (codePoint < 0x10000 || codePoint > 0x10FFFF))) {
+            profile.validUtf8 = false;
+            return profile;
+        }
+
+        CharClass charClass = codePoint < 0x10000 ? table.classes[codePoint] : classifyCodePoint(codePoint);
+        profile.counts[static_cast<size_t>(charClass)]++;
+        profile.codePoints++;
+        p += length;
+    }
+    return profile;
+}
+
+LanguageRules::LanguageRules(const std::string& languageCode) {
+    if (primaryLanguage(languageCode) != "ja") {
+        return;
+    }
+
+    std::vector<std::string_view> expressions;
+    for (const RuleSpec& spec : kJapaneseRules) {
+        expressions.emplace_back(spec.expression);
+        rules_.push_back({expressions.back().size(), spec.suffixOnly, spec.maxCodePoints});
+    }
+    automaton_ = AhoCorasick(expressions);
+    singleHiraganaIsFunctional_ = true;
+}
+
+bool LanguageRules::isLikelyFunctional(std::string_view text, const TextProfile& profile) const {
+    // Single-character hiragana are almost always particles
+    if (singleHiraganaIsFunctional_ && profile.codePoints == 1 && profile.only(CharClass::Hiragana)) {
+        return true;
+    }
+
+    bool matched = false;
+    automaton_.scan(text, [&](size_t pattern, size_t start) {
+        const Rule& rule = rules_[pattern];
+        if (rule.suffixOnly && start + rule.length != text.size()) {
+            return;
+        }
+        if (rule.maxCodePoints > 0 && profile.codePoints > rule.maxCodePoints) {
+            return;
+        }
+        matched = true;
+    });
+    return matched;
+}
+
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,132 @@
+/**
+ * @file language_rules.h
+ * @brief Code point classes and per-language rules for candidate filtering
+ */
+
+#ifndef SUZUME_CORE_WORD_EXTRACTION_LANGUAGE_RULES_H_
+#define SUZUME_CORE_WORD_EXTRACTION_LANGUAGE_RULES_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/aho_corasick.h"
+
+namespace suzume {
+namespace core {
+
+/**
+ * @brief Script class of a code point
+ */
+enum class CharClass : uint8_t {
+    Hiragana,
+    Katakana,
+    Kanji,
+    Latin,
+    Digit,
+    Symbol,
+    Space,
+    Other
+};
+
+/// Number of CharClass values
+constexpr size_t kCharClassCount = 8;
+
+/**
+ * @brief Classify a code point
+ *
+ * The Basic Multilingual Plane is looked up in a table built once; the
+ * supplementary planes only hold Kanji (CJK extensions) and Other.
+ *
+ * @param codePoint Unicode code point
+ * @return CharClass Class of the code point
+ */
+CharClass classifyCodePoint(char32_t codePoint);
+
+/**
+ * @brief Classes of the code points of a text, gathered in one pass
+ */
+struct TextProfile {
+    bool validUtf8 = true;   ///< Text is well-formed UTF-8 (no truncated, overlong or surrogate sequences)
+    size_t codePoints = 0;   ///< Number of code points (only exact when validUtf8)
+    std::array<uint32_t, kCharClassCount> counts{}; ///< Code points per class
+
+    /**
+     * @brief Get the number of code points of a class
+     * @param charClass Class to count
+     * @return size_t Code points of that class
+     */
+    size_t count(CharClass charClass) const { return counts[static_cast<size_t>(charClass)]; }
+
+    /**
+     * @brief Check whether every code point is of one class
+     * @param charClass Class to check
+     * @return bool True if the text is non-empty and only of that class
+     */
+    bool only(CharClass charClass) const { return codePoints > 0 && count(charClass) == codePoints; }
+};
+
+/**
+ * @brief Decode a text once, validating it and counting its code point classes
+ *
+ * Decoding stops at the first malformed sequence, which clears validUtf8.
+ *
+ * @param text UTF-8 text
+ * @return TextProfile Profile of the text
+ */
+TextProfile profileText(std::string_view text);
+
+/**
+ * @brief Functional expression rules of one language, compiled once
+ *
+ * Every expression of the language is matched by a single automaton, so a
+ * candidate is checked in one scan however many expressions there are. A
+ * rule matches anywhere in the candidate or only as its suffix, and may be
+ * limited to short candidates. Languages without rules never report a
+ * functional expression.
+ */
+class LanguageRules {
+public:
+    /**
+     * @brief Compile the rules of a language
+     * @param languageCode Language code ("ja", "ja-JP", ...); unknown codes get no rules
+     */
+    explicit LanguageRules(const std::string& languageCode);
+
+    /**
+     * @brief Check whether a candidate looks like a functional word or expression
+     *        (particle, auxiliary, polite ending) rather than a content word
+     *
+     * @param text Candidate text
+     * @param profile Profile of text from profileText()
+     * @return bool True if a rule matches
+     */
+    bool isLikelyFunctional(std::string_view text, const TextProfile& profile) const;
+
+    /**
+     * @brief Get the number of expression rules
+     * @return size_t Rule count
+     */
+    size_t ruleCount() const { return rules_.size(); }
+
+private:
+    /**
+     * @brief Where an expression must occur and in which candidates
+     */
+    struct Rule {
+        size_t length;          ///< Bytes of the expression
+        bool suffixOnly;        ///< Match only at the end of the candidate
+        size_t maxCodePoints;   ///< Longest candidate the rule applies to (0 = any)
+    };
+
+    std::vector<Rule> rules_;
+    AhoCorasick automaton_{std::vector<std::string_view>()};
+    bool singleHiraganaIsFunctional_ = false;
+};
+
+} // namespace core
+} // namespace suzume
+
+#endif // SUZUME_CORE_WORD_EXTRACTION_LANGUAGE_RULES_H_
@@ -5,10 +5,14 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
+#include <deque>
 #include <memory>
 #include <vector>
 #include <cstddef>
 #include <mutex>
+#include <thread>
 
 namespace suzume {
 namespace core {
@@ -18,25 +22,33 @@ namespace core {
  * 
  * This class provides efficient allocation for small objects of the same size,
  * reducing memory fragmentation and improving cache locality.
+ *
+ * Every thread allocates from a cache of its own: its free list and the
+ * chunks it carved, reached without a lock once the thread has used the
+ * pool. Objects freed on another thread join that thread's free list. All
+ * chunks live until the pool is destroyed.
  */
 template<typename T, size_t ChunkSize = 1024>
 class MemoryPool {
 public:
-    MemoryPool() = default;
+    MemoryPool() : id_(nextPoolId()) {}
+    
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
     
     /**
      * @brief Allocate memory for one object
      * @return Pointer to allocated memory
      */
     T* allocate() {
-        std::lock_guard<std::mutex> lock(mutex_);
+        ThreadCache& cache = threadCache();
         
-        if (freeList_.empty()) {
-            allocateChunk();
+        if (cache.freeList.empty()) {
+            allocateChunk(cache);
         }
         
-        T* ptr = freeList_.back();
-        freeList_.pop_back();
+        T* ptr = cache.freeList.back();
+        cache.freeList.pop_back();
         return ptr;
     }
     
@@ -47,8 +59,7 @@ public:
     void deallocate(T* ptr) {
         if (!ptr) return;
         
-        std::lock_guard<std::mutex> lock(mutex_);
-        freeList_.push_back(ptr);
+        threadCache().freeList.push_back(ptr);
     }
     
     /**
@@ -56,8 +67,7 @@ public:
      * @return Number of chunks
      */
     size_t getChunkCount() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return chunks_.size();
+        return chunkCount_.load(std::memory_order_relaxed);
     }
     
     /**
@@ -65,31 +75,76 @@ public:
      * @return Memory usage
      */
     size_t getMemoryUsage() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return chunks_.size() * ChunkSize * sizeof(T);
+        return getChunkCount() * ChunkSize * sizeof(T);
     }
     
 private:
+    /// Free list and chunks of one thread
+    struct ThreadCache {
+        std::thread::id thread;
+        std::vector<T*> freeList;
+        std::vector<std::unique_ptr<T[]>> chunks;
+    };
+    
+    // Ids tell pools apart in the thread-local cache, even at a reused address
+    static uint64_t nextPoolId() {
+        static std::atomic<uint64_t> nextId{1};
+        return nextId.fetch_add(1);
+    }
+    
+    /**
+     * @brief Get the calling thread's cache, registering it on first use
+     */
+    ThreadCache& threadCache() {
+        // Cache of the pool this thread used last
+        thread_local uint64_t cachedId = 0;
+        thread_local ThreadCache* cached = nullptr;
+        if (cachedId == id_) {
+            return *cached;
+        }
+        
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::thread::id self = std::this_thread::get_id();
+        ThreadCache* found = nullptr;
+        for (ThreadCache& cache : caches_) {
+            if (cache.thread == self) {
+                found = &cache;
+                break;
+            }
+        }
+        if (!found) {
+            caches_.emplace_back();
+            found = &caches_.back();
+            found->thread = self;
+        }
+        cachedId = id_;
+        cached = found;
+        return *found;
+    }
+    
     /**
      * @brief Allocate a new chunk of memory
+     * @param cache Cache of the calling thread
      */
-    void allocateChunk() {
+    void allocateChunk(ThreadCache& cache) {
         // Allocate a new chunk
         auto chunk = std::make_unique<T[]>(ChunkSize);
         T* chunkPtr = chunk.get();
         
         // Add all objects in the chunk to the free list
         for (size_t i = 0; i < ChunkSize; ++i) {
-            freeList_.push_back(chunkPtr + i);
+            cache.freeList.push_back(chunkPtr + i);
         }
         
         // Store the chunk to keep it alive
-        chunks_.push_back(std::move(chunk));
+        cache.chunks.push_back(std::move(chunk));
+        chunkCount_.fetch_add(1, std::memory_order_relaxed);
     }
     
-    mutable std::mutex mutex_;
-    std::vector<std::unique_ptr<T[]>> chunks_;
-    std::vector<T*> freeList_;
+    uint64_t id_;
+    std::mutex mutex_;                 // Guards caches_ when a thread registers
+    std::deque<ThreadCache> caches_;   // Deque: caches never move once registered
+    std::atomic<size_t> chunkCount_{0};
 };
 
 /**
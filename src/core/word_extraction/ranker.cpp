@@ -6,10 +6,19 @@
 #include "ranker.h"
 #include <algorithm>
 #include <cmath>
+#include <numeric>
+#include "parallel/executor.h"
 
 namespace suzume {
 namespace core {
 
+namespace {
+
+// Scoring is cheap; below this many candidates threads cost more than they save
+constexpr size_t kParallelThreshold = 10000;
+
+} // namespace
+
 CandidateRanker::CandidateRanker(const WordExtractionOptions& options)
     : options_(options)
 {
@@ -19,82 +28,135 @@ std::vector<RankedCandidate> CandidateRanker::rankCandidates(
     const std::vector<VerifiedCandidate>& candidates,
     const std::function<void(double)>& progressCallback
 ) {
-    std::vector<RankedCandidate> rankedCandidates;
-    rankedCandidates.reserve(candidates.size());
-
-    // Process each candidate
-    size_t total = candidates.size();
-    size_t processed = 0;
+    return rankTopCandidates(candidates, candidates.size(), progressCallback);
+}
 
-    for (const auto& candidate : candidates) {
-        // Calculate combined score
-        double score = calculateCombinedScore(candidate);
+std::vector<RankedCandidate> CandidateRanker::rankTopCandidates(
+    const std::vector<VerifiedCandidate>& candidates,
+    size_t limit,
+    const std::function<void(double)>& progressCallback
+) {
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(candidates);
 
-        // Create ranked candidate
+    std::vector<RankedCandidate> rankedCandidates;
+    for (const RankedId& ranked : rankTopCandidates(store, ids, limit, progressCallback)) {
         RankedCandidate rankedCandidate;
-        rankedCandidate.text = candidate.text;
-        rankedCandidate.score = score;
-        rankedCandidate.frequency = candidate.frequency;
-        rankedCandidate.context = candidate.context;
-
+        rankedCandidate.text = std::string(store.text(ranked.id));
+        rankedCandidate.score = ranked.score;
+        rankedCandidate.frequency = store.frequency(ranked.id);
+        rankedCandidate.context = std::string(store.context(ranked.id));
         rankedCandidates.emplace_back(std::move(rankedCandidate));
+    }
+    return rankedCandidates;
+}
 
-        // Report progress
-        processed++;
-        if (progressCallback) {
-            progressCallback(static_cast<double>(processed) / total * 0.5);
+std::vector<RankedId> CandidateRanker::rankTopCandidates(
+    const CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    size_t limit,
+    const std::function<void(double)>& progressCallback
+) {
+    // Score every candidate with the model resolved once
+    const Scorer scorer = resolveScorer();
+    std::vector<double> scores(ids.size());
+    auto scoreRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            scores[i] = (this->*scorer)(store, ids[i]);
         }
+    };
+    if (options_.useParallelProcessing && options_.threads != 1 && ids.size() >= kParallelThreshold) {
+        parallel::ParallelExecutor::parallelFor(ids.size(), scoreRange, options_.threads);
+    } else {
+        scoreRange(0, ids.size());
     }
 
-    // Sort by score (descending) - use stable_sort for consistent ordering
-    std::stable_sort(rankedCandidates.begin(), rankedCandidates.end(),
-        [](const RankedCandidate& a, const RankedCandidate& b) {
-            return a.score > b.score;
-        });
+    if (progressCallback) {
+        progressCallback(0.5);
+    }
+
+    // Select and sort only the entries that are kept; ties keep the input order
+    std::vector<size_t> order(ids.size());
+    std::iota(order.begin(), order.end(), 0);
+    auto better = [&](size_t a, size_t b) {
+        return scores[a] != scores[b] ? scores[a] > scores[b] : a < b;
+    };
+    limit = std::min(limit, order.size());
+    std::partial_sort(order.begin(), order.begin() + limit, order.end(), better);
+
+    std::vector<RankedId> ranked;
+    ranked.reserve(limit);
+    for (size_t k = 0; k < limit; ++k) {
+        ranked.push_back({ids[order[k]], scores[order[k]]});
+    }
 
     if (progressCallback) {
         progressCallback(1.0);
     }
 
-    return rankedCandidates;
+    return ranked;
+}
+
+double CandidateRanker::scoreCandidate(const CandidateStore& store, CandidateStore::Id id) const {
+    return (this->*resolveScorer())(store, id);
+}
+
+double CandidateRanker::upperBound(const CandidateStore& store, CandidateStore::Id id) const {
+    if (resolveScorer() != &CandidateRanker::calculateCombinedScore) {
+        return calculateRawScore(store, id);
+    }
+    // Scores that verification leaves at 0 stay at 0
+    double contextMax = options_.useContextualAnalysis ? 1.0 : 0.0;
+    double statisticalMax = options_.useStatisticalValidation ? 1.0 : 0.0;
+    return options_.pmiWeight * calculatePmiScore(store, id) +
+           options_.lengthWeight * calculateLengthScore(store, id) +
+           std::max(0.0, options_.contextWeight) * contextMax +
+           std::max(0.0, options_.statisticalWeight) * statisticalMax;
 }
 
-double CandidateRanker::calculateCombinedScore(const VerifiedCandidate& candidate) {
+CandidateRanker::Scorer CandidateRanker::resolveScorer() const {
     if (options_.rankingModel == "combined") {
-        double pmiScore = calculatePmiScore(candidate);
-        double lengthScore = calculateLengthScore(candidate);
-        double contextScore = calculateContextScore(candidate);
-        double statisticalScore = calculateStatisticalScore(candidate);
-
-        return options_.pmiWeight * pmiScore +
-               options_.lengthWeight * lengthScore +
-               options_.contextWeight * contextScore +
-               options_.statisticalWeight * statisticalScore;
-    } else {
-        // Default to PMI score
-        return candidate.score;
+        return &CandidateRanker::calculateCombinedScore;
     }
+    // Default to PMI score
+    return &CandidateRanker::calculateRawScore;
+}
+
+double CandidateRanker::calculateCombinedScore(const CandidateStore& store, CandidateStore::Id id) const {
+    double pmiScore = calculatePmiScore(store, id);
+    double lengthScore = calculateLengthScore(store, id);
+    double contextScore = calculateContextScore(store, id);
+    double statisticalScore = calculateStatisticalScore(store, id);
+
+    return options_.pmiWeight * pmiScore +
+           options_.lengthWeight * lengthScore +
+           options_.contextWeight * contextScore +
+           options_.statisticalWeight * statisticalScore;
+}
+
+double CandidateRanker::calculateRawScore(const CandidateStore& store, CandidateStore::Id id) const {
+    return store.score(id);
 }
 
-double CandidateRanker::calculatePmiScore(const VerifiedCandidate& candidate) {
+double CandidateRanker::calculatePmiScore(const CandidateStore& store, CandidateStore::Id id) const {
     // Normalize PMI score to 0-1 range
-    return std::min(1.0, candidate.score / 10.0);
+    return std::min(1.0, store.score(id) / 10.0);
 }
 
-double CandidateRanker::calculateLengthScore(const VerifiedCandidate& candidate) {
+double CandidateRanker::calculateLengthScore(const CandidateStore& store, CandidateStore::Id id) const {
     // Prefer longer candidates, but not too long
-    double length = candidate.text.length();
+    double length = store.text(id).length();
     double optimalLength = 4.0; // Optimal length is around 4 characters
 
     return std::exp(-(length - optimalLength) * (length - optimalLength) / 8.0);
 }
 
-double CandidateRanker::calculateContextScore(const VerifiedCandidate& candidate) {
-    return candidate.contextScore;
+double CandidateRanker::calculateContextScore(const CandidateStore& store, CandidateStore::Id id) const {
+    return store.contextScore(id);
 }
 
-double CandidateRanker::calculateStatisticalScore(const VerifiedCandidate& candidate) {
-    return candidate.statisticalScore;
+double CandidateRanker::calculateStatisticalScore(const CandidateStore& store, CandidateStore::Id id) const {
+    return store.statisticalScore(id);
 }
 
 } // namespace core
@@ -9,6 +9,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include "candidate_store.h"
 #include "common.h"
 #include "suzume_feedmill.h"
 
@@ -41,46 +42,130 @@ public:
         const std::function<void(double)>& progressCallback = nullptr
     );
 
+    /**
+     * @brief Rank candidates and keep only the best ones
+     *
+     * The ranking model is resolved once, candidates are scored in parallel
+     * when parallel processing is enabled, and only the top entries are
+     * selected and sorted. Equal scores keep the input order, so the result
+     * is the first limit entries of rankCandidates().
+     *
+     * @param candidates Filtered candidates
+     * @param limit Number of candidates to keep
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<RankedCandidate> The best limit candidates, by descending score
+     */
+    std::vector<RankedCandidate> rankTopCandidates(
+        const std::vector<VerifiedCandidate>& candidates,
+        size_t limit,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
+    /**
+     * @brief Rank candidates held in a candidate store and keep the best ones
+     *
+     * Same ranking as rankTopCandidates() over vectors; equal scores keep
+     * the order of ids.
+     *
+     * @param store Candidate store
+     * @param ids Filtered candidates
+     * @param limit Number of candidates to keep
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<RankedId> The best limit candidates, by descending score
+     */
+    std::vector<RankedId> rankTopCandidates(
+        const CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        size_t limit,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
+    /**
+     * @brief Score one candidate with the configured ranking model
+     *
+     * @param store Candidate store
+     * @param id Candidate to score
+     * @return double Score rankTopCandidates() gives the candidate
+     */
+    double scoreCandidate(const CandidateStore& store, CandidateStore::Id id) const;
+
+    /**
+     * @brief Highest score a candidate can get once it is verified
+     *
+     * The PMI and length components are known before verification; the
+     * context and statistical scores lie in 0-1 and are taken at whichever
+     * end their weight favours. Computed in the same order as the score,
+     * so it is never below it, rounding included.
+     *
+     * @param store Candidate store
+     * @param id Candidate, before or after verification
+     * @return double Upper bound of scoreCandidate()
+     */
+    double upperBound(const CandidateStore& store, CandidateStore::Id id) const;
+
 private:
+    using Scorer = double (CandidateRanker::*)(const CandidateStore&, CandidateStore::Id) const;
+
+    /**
+     * @brief Pick the scoring function of the configured ranking model
+     *
+     * @return Scorer Combined score for "combined", the PMI score otherwise
+     */
+    Scorer resolveScorer() const;
+
     /**
      * @brief Calculate combined score
      *
-     * @param candidate Candidate to score
+     * @param store Candidate store
+     * @param id Candidate to score
      * @return double Combined score
      */
-    double calculateCombinedScore(const VerifiedCandidate& candidate);
+    double calculateCombinedScore(const CandidateStore& store, CandidateStore::Id id) const;
+
+    /**
+     * @brief Use the candidate's PMI score as is
+     *
+     * @param store Candidate store
+     * @param id Candidate to score
+     * @return double PMI score
+     */
+    double calculateRawScore(const CandidateStore& store, CandidateStore::Id id) const;
 
     /**
      * @brief Calculate PMI score
      *
-     * @param candidate Candidate to score
+     * @param store Candidate store
+     * @param id Candidate to score
      * @return double PMI score
      */
-    double calculatePmiScore(const VerifiedCandidate& candidate);
+    double calculatePmiScore(const CandidateStore& store, CandidateStore::Id id) const;
 
     /**
      * @brief Calculate length score
      *
-     * @param candidate Candidate to score
+     * @param store Candidate store
+     * @param id Candidate to score
      * @return double Length score
      */
-    double calculateLengthScore(const VerifiedCandidate& candidate);
+    double calculateLengthScore(const CandidateStore& store, CandidateStore::Id id) const;
 
     /**
      * @brief Calculate context score
      *
-     * @param candidate Candidate to score
+     * @param store Candidate store
+     * @param id Candidate to score
      * @return double Context score
      */
-    double calculateContextScore(const VerifiedCandidate& candidate);
+    double calculateContextScore(const CandidateStore& store, CandidateStore::Id id) const;
 
     /**
      * @brief Calculate statistical score
      *
-     * @param candidate Candidate to score
+     * @param store Candidate store
+     * @param id Candidate to score
      * @return double Statistical score
      */
-    double calculateStatisticalScore(const VerifiedCandidate& candidate);
+    double calculateStatisticalScore(const CandidateStore& store, CandidateStore::Id id) const;
 
     WordExtractionOptions options_;
 };
@@ -4,122 +4,191 @@
  */
 
 #include "trie.h"
+#include <algorithm>
 
 namespace suzume {
 namespace core {
 
-NGramTrie::NGramTrie() : root_(std::make_unique<Node>()), nodeCount_(1) {}
+namespace {
+
+/**
+ * @brief Reverse a string by UTF-8 code point, keeping each sequence intact
+ */
+std::string reverseCodePoints(const std::string& text) {
+    std::string reversed(text.size(), '\0');
+    size_t out = text.size();
+    size_t i = 0;
+    while (i < text.size()) {
+        size_t length = 1;
+        while (i + length < text.size() && (static_cast<unsigned char>(text[i + length]) & 0xC0) == 0x80) {
+            ++length;
+        }
+        out -= length;
+        text.copy(&reversed[out], length, i);
+        i += length;
+    }
+    return reversed;
+}
+
+} // namespace
+
+NGramTrie::NGramTrie(KeyOrder order) : order_(order), nodes_(1) {}
 
 void NGramTrie::add(
     const std::string& ngram,
     double score,
     uint32_t frequency
 ) {
-    Node* current = root_.get();
+    const std::string key = order_ == KeyOrder::Reversed ? reverseCodePoints(ngram) : ngram;
+    uint32_t current = 0;
 
-    // Forward trie insertion
-    for (char c : ngram) {
-        if (!current->children[c]) {
-            current->children[c] = std::make_unique<Node>();
-            nodeCount_++;
-        }
-        current = current->children[c].get();
+    // Trie insertion in stored key order
+    for (char c : key) {
+        current = findOrAddChild(current, static_cast<unsigned char>(c));
     }
 
     // Mark end of word and store score and frequency
-    current->isEndOfWord = true;
-    current->score = score;
-    current->frequency = frequency;
-    current->ngram = ngram;
+    if (nodes_[current].payload == kNone) {
+        nodes_[current].payload = static_cast<uint32_t>(payloads_.size());
+        payloads_.push_back({score, frequency});
+    } else {
+        payloads_[nodes_[current].payload] = {score, frequency};
+    }
+    charge_.set(getMemoryUsage());
 }
 
 std::vector<std::tuple<std::string, double, uint32_t>> NGramTrie::findByPrefix(
     const std::string& prefix
+) const {
+    if (order_ == KeyOrder::Forward) {
+        return walkPrefix(prefix);
+    }
+    return scanAll([&](const std::string& ngram) {
+        return ngram.compare(0, prefix.length(), prefix) == 0;
+    });
+}
+
+std::vector<std::tuple<std::string, double, uint32_t>> NGramTrie::findBySuffix(
+    const std::string& suffix
+) const {
+    auto endsWithSuffix = [&](const std::string& ngram) {
+        return ngram.length() >= suffix.length() &&
+               ngram.compare(ngram.length() - suffix.length(), suffix.length(), suffix) == 0;
+    };
+
+    // A suffix starting inside a code point has no code-point reversal to walk
+    if (order_ != KeyOrder::Reversed ||
+        (!suffix.empty() && (static_cast<unsigned char>(suffix[0]) & 0xC0) == 0x80)) {
+        return scanAll(endsWithSuffix);
+    }
+
+    // Truncated sequences in the suffix can match a longer code point, so
+    // the walk's results are checked byte-wise
+    auto results = walkPrefix(reverseCodePoints(suffix));
+    results.erase(std::remove_if(results.begin(), results.end(), [&](const auto& entry) {
+        return !endsWithSuffix(std::get<0>(entry));
+    }), results.end());
+    return results;
+}
+
+std::vector<std::tuple<std::string, double, uint32_t>> NGramTrie::walkPrefix(
+    const std::string& storedPrefix
 ) const {
     std::vector<std::tuple<std::string, double, uint32_t>> results;
 
     // Find the node corresponding to the prefix
-    const Node* current = root_.get();
-    for (char c : prefix) {
-        auto it = current->children.find(c);
-        if (it == current->children.end()) {
+    uint32_t current = 0;
+    for (char c : storedPrefix) {
+        current = findChild(current, static_cast<unsigned char>(c));
+        if (current == kNone) {
             // Prefix not found
             return results;
         }
-        current = it->second.get();
     }
 
     // Collect all words with the given prefix
-    collectWords(current, results);
+    std::string key = storedPrefix;
+    collectWords(current, key, results);
     return results;
 }
 
-std::vector<std::tuple<std::string, double, uint32_t>> NGramTrie::findBySuffix(
-    const std::string& suffix
-) const {
-    // For suffix search, we need to check all nodes
-    // This is less efficient than prefix search but necessary for suffix matching
+template <typename Predicate>
+std::vector<std::tuple<std::string, double, uint32_t>> NGramTrie::scanAll(Predicate accept) const {
     std::vector<std::tuple<std::string, double, uint32_t>> results;
-    collectWordsBySuffix(root_.get(), suffix, results);
+    std::string key;
+    collectWords(0, key, results);
+
+    size_t kept = 0;
+    for (auto& entry : results) {
+        if (accept(std::get<0>(entry))) {
+            results[kept++] = std::move(entry);
+        }
+    }
+    results.resize(kept);
     return results;
 }
 
-void NGramTrie::collectWords(
-    const Node* node,
-    std::vector<std::tuple<std::string, double, uint32_t>>& results
-) const {
-    if (!node) return;
+uint32_t NGramTrie::findChild(uint32_t node, unsigned char label) const {
+    // Siblings are sorted, so the scan stops at the first larger label
+    for (uint32_t child = nodes_[node].firstChild; child != kNone; child = nodes_[child].nextSibling) {
+        if (nodes_[child].label >= label) {
+            return nodes_[child].label == label ? child : kNone;
+        }
+    }
+    return kNone;
+}
 
-    // Add this node if it's an end of word
-    if (node->isEndOfWord) {
-        results.emplace_back(node->ngram, node->score, node->frequency);
+uint32_t NGramTrie::findOrAddChild(uint32_t node, unsigned char label) {
+    uint32_t previous = kNone;
+    uint32_t child = nodes_[node].firstChild;
+    while (child != kNone && nodes_[child].label < label) {
+        previous = child;
+        child = nodes_[child].nextSibling;
+    }
+    if (child != kNone && nodes_[child].label == label) {
+        return child;
     }
 
-    // Recursively collect words from all children
-    for (const auto& [_, child] : node->children) {
-        collectWords(child.get(), results);
+    uint32_t added = static_cast<uint32_t>(nodes_.size());
+    Node entry;
+    entry.label = label;
+    entry.nextSibling = child;
+    nodes_.push_back(entry);
+    if (previous == kNone) {
+        nodes_[node].firstChild = added;
+    } else {
+        nodes_[previous].nextSibling = added;
     }
+    return added;
 }
 
-void NGramTrie::collectWordsBySuffix(
-    const Node* node,
-    const std::string& suffix,
+void NGramTrie::collectWords(
+    uint32_t node,
+    std::string& key,
     std::vector<std::tuple<std::string, double, uint32_t>>& results
 ) const {
-    if (!node) return;
-
-    // Add this node if it's an end of word and ends with the suffix
-    if (node->isEndOfWord) {
-        const std::string& ngram = node->ngram;
-        if (ngram.length() >= suffix.length() &&
-            ngram.substr(ngram.length() - suffix.length()) == suffix) {
-            results.emplace_back(ngram, node->score, node->frequency);
-        }
+    // Add this node if it's an end of word
+    const Node& current = nodes_[node];
+    if (current.payload != kNone) {
+        const Payload& payload = payloads_[current.payload];
+        results.emplace_back(order_ == KeyOrder::Reversed ? reverseCodePoints(key) : key,
+                             payload.score, payload.frequency);
     }
 
-    // Recursively collect words from all children
-    for (const auto& [_, child] : node->children) {
-        collectWordsBySuffix(child.get(), suffix, results);
+    // Recursively collect words from all children, in label order
+    for (uint32_t child = current.firstChild; child != kNone; child = nodes_[child].nextSibling) {
+        key.push_back(static_cast<char>(nodes_[child].label));
+        collectWords(child, key, results);
+        key.pop_back();
     }
 }
 
 size_t NGramTrie::getMemoryUsage() {
-    // Estimate memory usage based on node count
-    return nodeCount_ * (sizeof(Node) + 32); // Rough estimate including overhead
+    return nodes_.capacity() * sizeof(Node) + payloads_.capacity() * sizeof(Payload);
 }
 
 size_t NGramTrie::getNodeCount() {
-    return nodeCount_;
-}
-
-size_t NGramTrie::countNodes(const Node* node) const {
-    if (!node) return 0;
-    
-    size_t count = 1; // Count this node
-    for (const auto& [_, child] : node->children) {
-        count += countNodes(child.get());
-    }
-    return count;
+    return nodes_.size();
 }
 
 } // namespace core
@@ -6,25 +6,47 @@
 #ifndef SUZUME_CORE_WORD_EXTRACTION_TRIE_H_
 #define SUZUME_CORE_WORD_EXTRACTION_TRIE_H_
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include <tuple>
-#include <memory>
-#include <unordered_map>
-#include "memory_pool.h"
+#include "core/memory_accounting.h"
 
 namespace suzume {
 namespace core {
 
 /**
- * @brief N-gram trie for efficient prefix/suffix matching with memory pool optimization
+ * @brief N-gram trie for efficient prefix/suffix matching
+ *
+ * Nodes live in one contiguous array and refer to each other by index:
+ * each node holds its byte label, its first child and its next sibling,
+ * with siblings kept sorted by label. Scores and frequencies are stored in
+ * a separate payload array indexed from the terminal nodes, and n-gram
+ * texts are rebuilt from the path during traversal instead of being
+ * copied into every node. A node costs 16 bytes and there is no
+ * allocation per key byte.
+ *
+ * A trie with reversed keys stores every n-gram reversed by code point
+ * (so the stored bytes stay valid UTF-8), which turns suffix queries into
+ * prefix walks; prefix queries on it fall back to a full traversal, as
+ * suffix queries do on a forward trie.
  */
 class NGramTrie {
 public:
+    /**
+     * @brief Order of the stored keys
+     */
+    enum class KeyOrder {
+        Forward,    ///< Keys as given; fast prefix queries
+        Reversed    ///< Keys reversed by code point; fast suffix queries
+    };
+
     /**
      * @brief Constructor
+     *
+     * @param order Order of the stored keys
      */
-    NGramTrie();
+    explicit NGramTrie(KeyOrder order = KeyOrder::Forward);
 
     /**
      * @brief Add n-gram to trie
@@ -52,8 +74,8 @@ public:
     std::vector<std::tuple<std::string, double, uint32_t>> findBySuffix(const std::string& suffix) const;
 
     /**
-     * @brief Get memory usage statistics (simplified)
-     * @return Estimated memory usage in bytes
+     * @brief Get memory usage statistics
+     * @return Bytes reserved for nodes and payloads
      */
     size_t getMemoryUsage();
 
@@ -64,42 +86,68 @@ public:
     size_t getNodeCount();
 
 private:
-    // Trie node structure using standard smart pointers
-    class Node {
-    public:
-        std::unordered_map<char, std::unique_ptr<Node>> children;
-        bool isEndOfWord = false;
-        double score = 0.0;
-        uint32_t frequency = 0;
-        std::string ngram;
+    static constexpr uint32_t kNone = UINT32_MAX;
+
+    struct Node {
+        uint32_t firstChild = kNone;
+        uint32_t nextSibling = kNone;
+        uint32_t payload = kNone;   // Index into payloads_ for the end of an n-gram
+        unsigned char label = 0;
+    };
+
+    struct Payload {
+        double score;
+        uint32_t frequency;
     };
 
+    /**
+     * @brief Get the child of a node with a label
+     *
+     * @param node Parent node index
+     * @param label Byte label
+     * @return uint32_t Child index, or kNone
+     */
+    uint32_t findChild(uint32_t node, unsigned char label) const;
+
+    /**
+     * @brief Get the child of a node with a label, inserting it in sorted position
+     *
+     * @param node Parent node index
+     * @param label Byte label
+     * @return uint32_t Child index
+     */
+    uint32_t findOrAddChild(uint32_t node, unsigned char label);
+
     /**
      * @brief Collect all words from a node and its children
      *
      * @param node Starting node
+     * @param key Key of the starting node; restored on return
      * @param results Vector to store results
      */
-    void collectWords(const Node* node, std::vector<std::tuple<std::string, double, uint32_t>>& results) const;
+    void collectWords(uint32_t node, std::string& key, std::vector<std::tuple<std::string, double, uint32_t>>& results) const;
 
     /**
-     * @brief Collect all words ending with a suffix
+     * @brief Collect the words under the node reached by a stored-order key prefix
      *
-     * @param node Starting node
-     * @param suffix Suffix to match
-     * @param results Vector to store results
+     * @param storedPrefix Prefix in stored key order
+     * @return std::vector<std::tuple<std::string, double, uint32_t>> Matches with keys as given to add()
      */
-    void collectWordsBySuffix(const Node* node, const std::string& suffix, std::vector<std::tuple<std::string, double, uint32_t>>& results) const;
+    std::vector<std::tuple<std::string, double, uint32_t>> walkPrefix(const std::string& storedPrefix) const;
 
     /**
-     * @brief Count nodes recursively for statistics
-     * @param node Starting node
-     * @return Number of nodes in subtree
+     * @brief Collect every word and keep those a predicate accepts
+     *
+     * @param accept Predicate on the n-gram as given to add()
+     * @return std::vector<std::tuple<std::string, double, uint32_t>> Accepted words
      */
-    size_t countNodes(const Node* node) const;
+    template <typename Predicate>
+    std::vector<std::tuple<std::string, double, uint32_t>> scanAll(Predicate accept) const;
 
-    std::unique_ptr<Node> root_;  // Root of the trie (use unique_ptr for simple management)
-    size_t nodeCount_;   // Track number of nodes for statistics
+    KeyOrder order_;
+    std::vector<Node> nodes_;       // nodes_[0] is the root
+    std::vector<Payload> payloads_;
+    MemoryCharge charge_{MemorySubsystem::Tries};
 };
 
 } // namespace core
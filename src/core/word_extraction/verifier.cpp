@@ -4,30 +4,90 @@
  */
 
 #include "verifier.h"
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 #include <algorithm>
-#include <unicode/uchar.h>
-#include <unicode/unistr.h>
-#include <unicode/normalizer2.h>
-
-using icu::UnicodeString;
+#include <thread>
+#include "core/aho_corasick.h"
+#include "core/auto_tune.h"
+#include "core/mapped_text.h"
+#include "core/progress_reporter.h"
+#include "core/text_utils.h"
+#include "core/warm_cache.h"
+#include "parallel/executor.h"
+#include "robin_hood.h"
+#include "xxhash.h"
 
 namespace suzume {
 namespace core {
 
+namespace {
+
+// Contexts span this many code points on each side of an occurrence
+constexpr size_t kContextCodePoints = 20;
+
+// A context reaches at most this many bytes from its occurrence
+constexpr size_t kContextBytes = kContextCodePoints * 4;
+
+// PMI statistics carry the contexts verification would cut from the text
+static_assert(NgramStatsTable::kContextCodePoints == kContextCodePoints, "statistics contexts differ in size");
+
+std::unique_ptr<MappedText> openText(const std::string& textPath) {
+    try {
+        return std::make_unique<MappedText>(textPath);
+    } catch (const std::runtime_error&) {
+        throw std::runtime_error("Failed to open original text file: " + textPath);
+    }
+}
+
+// Evidence an incremental state records: 0 nothing, 1 occurrences, 2 occurrences and contexts
+unsigned int evidenceLevel(const WordExtractionOptions& options) {
+    if (options.useContextualAnalysis) {
+        return 2;
+    }
+    return options.verifyInOriginalText || options.useStatisticalValidation ? 1 : 0;
+}
+
+uint64_t textFileBytes(const std::string& textPath) {
+    std::error_code error;
+    uint64_t bytes = std::filesystem::file_size(textPath, error);
+    if (error) {
+        throw std::runtime_error("Failed to open original text file: " + textPath);
+    }
+    return bytes;
+}
+
+} // namespace
+
+struct CandidateVerifier::IndexedText {
+    std::unique_ptr<MappedText> text;
+    std::unique_ptr<TextIndex> index;  // References text
+};
+
 CandidateVerifier::CandidateVerifier(const WordExtractionOptions& options)
     : options_(options)
 {
     // Load dictionary if needed
     if (options_.useDictionaryLookup && !options_.dictionaryPath.empty()) {
-        std::ifstream dictFile(options_.dictionaryPath);
-        if (dictFile.is_open()) {
-            std::string word;
-            while (std::getline(dictFile, word)) {
-                dictionary_.insert(word);
-            }
+        // A prebuilt dictionary is mapped as it is; a word list is read line by line
+        if (isStaticDictionaryFile(options_.dictionaryPath)) {
+            staticDictionary_ = cachedLoad<StaticDictionary>("static_dictionary", options_.dictionaryPath, "", [&]() {
+                return std::make_shared<const StaticDictionary>(options_.dictionaryPath);
+            });
+            return;
         }
+        dictionary_ = cachedLoad<std::unordered_set<std::string>>("word_list", options_.dictionaryPath, "", [&]() {
+            auto words = std::make_shared<std::unordered_set<std::string>>();
+            std::ifstream dictFile(options_.dictionaryPath);
+            if (dictFile.is_open()) {
+                std::string word;
+                while (std::getline(dictFile, word)) {
+                    words->insert(word);
+                }
+            }
+            return words;
+        });
     }
 }
 
@@ -36,180 +96,749 @@ std::vector<VerifiedCandidate> CandidateVerifier::verifyCandidates(
     const std::string& originalTextPath,
     const std::function<void(double)>& progressCallback
 ) {
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(candidates);
+
     std::vector<VerifiedCandidate> verifiedCandidates;
+    for (CandidateStore::Id id : verifyCandidates(store, ids, originalTextPath, progressCallback)) {
+        verifiedCandidates.push_back(store.toVerified(id));
+    }
+    return verifiedCandidates;
+}
+
+std::vector<CandidateStore::Id> CandidateVerifier::verifyCandidates(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    const std::string& originalTextPath,
+    const std::function<void(double)>& progressCallback
+) {
+    // Only the candidates the previous run cannot vouch for come back here
+    if (!options_.incrementalStatePath.empty() && !incremental_) {
+        return verifyIncrementally(store, ids, IncrementalState::hashFile(originalTextPath),
+                                   [&](const std::vector<CandidateStore::Id>& fresh) {
+            return verifyCandidates(store, fresh, originalTextPath, progressCallback);
+        }, progressCallback);
+    }
+
+    // Statistics from the PMI run replace the search; the text is mapped only if they fall short
+    if (!options_.pmiStatsPath.empty()) {
+        std::unique_ptr<MappedText> originalText;
+        return verifyCandidatesFromStats(store, ids, textFileBytes(originalTextPath), [&]() {
+            originalText = openText(originalTextPath);
+            return originalText->text();
+        }, progressCallback);
+    }
+
+    if (options_.streamingVerification) {
+        return verifyCandidatesStreaming(store, ids, originalTextPath, progressCallback);
+    }
+
+    // Per-pattern queries index the whole file, which later jobs may reuse
+    if (!options_.batchVerification) {
+        std::shared_ptr<const IndexedText> indexed = indexedText(originalTextPath);
+        return verifyAll(store, ids, [&](size_t, std::string_view text) {
+            return indexedEvidence(*indexed->index, text);
+        }, progressCallback);
+    }
+
+    // Index the mapped file in place; it is read only where it cannot be mapped
+    std::unique_ptr<MappedText> originalText = openText(originalTextPath);
+    return verifyCandidatesInText(store, ids, originalText->text(), progressCallback);
+}
+
+std::vector<CandidateStore::Id> CandidateVerifier::verifyCandidatesInText(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    std::string_view originalText,
+    const std::function<void(double)>& progressCallback
+) {
+    if (!options_.incrementalStatePath.empty() && !incremental_) {
+        return verifyIncrementally(store, ids, XXH3_64bits(originalText.data(), originalText.size()),
+                                   [&](const std::vector<CandidateStore::Id>& fresh) {
+            return verifyCandidatesInText(store, fresh, originalText, progressCallback);
+        }, progressCallback);
+    }
+
+    if (!options_.pmiStatsPath.empty()) {
+        return verifyCandidatesFromStats(store, ids, originalText.size(), [originalText]() {
+            return originalText;
+        }, progressCallback);
+    }
 
     // Create text index
-    TextIndex textIndex(originalTextPath);
+    TextIndex textIndex(originalText, !options_.batchVerification, options_.textIndexPath);
+
+    // Batch mode counts every candidate up front in one pass over the text
+    std::vector<TextIndex::Occurrences> batchOccurrences;
+    if (options_.batchVerification) {
+        std::vector<std::string_view> patterns;
+        patterns.reserve(ids.size());
+        for (CandidateStore::Id id : ids) {
+            patterns.push_back(store.text(id));
+        }
+        unsigned int threads = options_.useParallelProcessing ? options_.threads : 1;
+        batchOccurrences = textIndex.countAll(patterns, threads);
+    }
+
+    return verifyAll(store, ids, [&](size_t index, std::string_view text) {
+        if (batchOccurrences.empty()) {
+            return indexedEvidence(textIndex, text);
+        }
+        Evidence evidence;
+        evidence.occurrences = batchOccurrences[index];
+        if (options_.useContextualAnalysis && evidence.occurrences.count > 0) {
+            evidence.context = textIndex.getContext(evidence.occurrences.first, kContextCodePoints);
+        }
+        return evidence;
+    }, progressCallback);
+}
 
-    // Process each candidate
-    size_t total = candidates.size();
-    size_t processed = 0;
+void CandidateVerifier::verifyCandidatesInBatches(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    const std::string& originalTextPath,
+    size_t batchSize,
+    const BatchCallback& onBatch
+) {
+    batchSize = std::max<size_t>(batchSize, 1);
+
+    // Batches are looked up in the statistics; the text is mapped once, the first time one falls short
+    if (!options_.pmiStatsPath.empty()) {
+        uint64_t textBytes = textFileBytes(originalTextPath);
+        std::unique_ptr<MappedText> originalText;
+        auto openOnce = [&]() {
+            if (!originalText) {
+                originalText = openText(originalTextPath);
+            }
+            return originalText->text();
+        };
+        for (size_t begin = 0; begin < ids.size(); begin += batchSize) {
+            size_t end = std::min(ids.size(), begin + batchSize);
+            std::vector<CandidateStore::Id> batch(ids.begin() + begin, ids.begin() + end);
+            if (!onBatch(end, verifyCandidatesFromStats(store, batch, textBytes, openOnce, nullptr))) {
+                return;
+            }
+        }
+        return;
+    }
 
-    for (const auto& candidate : candidates) {
-        // Verify in original text if required
-        bool verified = true;
-        if (options_.verifyInOriginalText) {
-            verified = verifyInText(candidate, textIndex);
+    std::shared_ptr<const IndexedText> indexed = indexedText(originalTextPath);
+    const TextIndex& textIndex = *indexed->index;
+
+    for (size_t begin = 0; begin < ids.size(); begin += batchSize) {
+        size_t end = std::min(ids.size(), begin + batchSize);
+        std::vector<CandidateStore::Id> batch(ids.begin() + begin, ids.begin() + end);
+        std::vector<CandidateStore::Id> accepted = verifyAll(store, batch, [&](size_t, std::string_view text) {
+            return indexedEvidence(textIndex, text);
+        }, nullptr);
+        if (!onBatch(end, accepted)) {
+            return;
         }
+    }
+}
 
-        // Skip if not verified
-        if (!verified) {
-            processed++;
-            if (progressCallback) {
-                progressCallback(static_cast<double>(processed) / total);
+std::shared_ptr<const CandidateVerifier::IndexedText> CandidateVerifier::indexedText(const std::string& textPath) const {
+    // The suffix array file only changes how the index is built, not what it holds
+    return cachedLoad<IndexedText>("text_index", textPath, "", [&]() {
+        auto indexed = std::make_shared<IndexedText>();
+        indexed->text = openText(textPath);
+        indexed->index = std::make_unique<TextIndex>(indexed->text->text(), true, options_.textIndexPath);
+        return indexed;
+    });
+}
+
+void CandidateVerifier::verifyCandidatesInBatchesInText(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    std::string_view originalText,
+    size_t batchSize,
+    const BatchCallback& onBatch
+) {
+    batchSize = std::max<size_t>(batchSize, 1);
+    if (!options_.pmiStatsPath.empty()) {
+        for (size_t begin = 0; begin < ids.size(); begin += batchSize) {
+            size_t end = std::min(ids.size(), begin + batchSize);
+            std::vector<CandidateStore::Id> batch(ids.begin() + begin, ids.begin() + end);
+            std::vector<CandidateStore::Id> accepted = verifyCandidatesFromStats(
+                store, batch, originalText.size(), [originalText]() { return originalText; }, nullptr);
+            if (!onBatch(end, accepted)) {
+                return;
             }
-            continue;
         }
+        return;
+    }
+
+    TextIndex textIndex(originalText, true, options_.textIndexPath);
 
-        // Analyze context if required
-        std::string context;
-        double contextScore = 0.0;
-        if (options_.useContextualAnalysis) {
-            auto [ctx, score] = analyzeContext(candidate, textIndex);
-            context = ctx;
-            contextScore = score;
+    for (size_t begin = 0; begin < ids.size(); begin += batchSize) {
+        size_t end = std::min(ids.size(), begin + batchSize);
+        std::vector<CandidateStore::Id> batch(ids.begin() + begin, ids.begin() + end);
+        std::vector<CandidateStore::Id> accepted = verifyAll(store, batch, [&](size_t, std::string_view text) {
+            return indexedEvidence(textIndex, text);
+        }, nullptr);
+        if (!onBatch(end, accepted)) {
+            return;
         }
+    }
+}
 
-        // Validate statistically if required
-        double statisticalScore = 0.0;
-        if (options_.useStatisticalValidation) {
-            statisticalScore = validateStatistically(candidate, textIndex);
+CandidateVerifier::Evidence CandidateVerifier::indexedEvidence(const TextIndex& textIndex, std::string_view text) const {
+    Evidence evidence;
+    if (options_.verifyInOriginalText || options_.useContextualAnalysis || options_.useStatisticalValidation) {
+        evidence.occurrences = textIndex.occurrences(text);
+    }
+    if (options_.useContextualAnalysis && evidence.occurrences.count > 0) {
+        evidence.context = textIndex.getContext(evidence.occurrences.first, kContextCodePoints);
+    }
+    return evidence;
+}
+
+std::vector<CandidateStore::Id> CandidateVerifier::verifyCandidatesFromStats(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    uint64_t textBytes,
+    const std::function<std::string_view()>& originalText,
+    const std::function<void(double)>& progressCallback
+) {
+    std::shared_ptr<const NgramStatsTable> stats = cachedLoad<NgramStatsTable>("pmi_stats", options_.pmiStatsPath, "",
+                                                                               [&]() {
+        return std::make_shared<const NgramStatsTable>(options_.pmiStatsPath);
+    });
+    if (stats->textBytes() != textBytes) {
+        throw std::runtime_error("PMI statistics " + options_.pmiStatsPath + " were gathered over another text (" +
+                                 std::to_string(stats->textBytes()) + " bytes, not " + std::to_string(textBytes) + ")");
+    }
+
+    // Candidates left out of the statistics are counted in one pass, in the order found
+    std::vector<const NgramStats*> rows(ids.size());
+    std::vector<size_t> slots(ids.size(), 0);
+    std::vector<std::string_view> missing;
+    for (size_t index = 0; index < ids.size(); ++index) {
+        std::string_view text = store.text(ids[index]);
+        rows[index] = stats->find(text);
+        if (!rows[index]) {
+            slots[index] = missing.size();
+            missing.push_back(text);
+        }
+    }
+    std::vector<Evidence> counted(missing.size());
+    if (!missing.empty()) {
+        TextIndex textIndex(originalText(), false);
+        unsigned int threads = options_.useParallelProcessing ? options_.threads : 1;
+        std::vector<TextIndex::Occurrences> occurrences = textIndex.countAll(missing, threads);
+        for (size_t m = 0; m < missing.size(); ++m) {
+            counted[m].occurrences = occurrences[m];
+            if (options_.useContextualAnalysis && occurrences[m].count > 0) {
+                counted[m].context = textIndex.getContext(occurrences[m].first, kContextCodePoints);
+            }
         }
+    }
+
+    return verifyAll(store, ids, [&](size_t index, std::string_view) {
+        const NgramStats* row = rows[index];
+        if (!row) {
+            return counted[slots[index]];
+        }
+        Evidence evidence;
+        evidence.occurrences.count = row->count;
+        evidence.occurrences.first = static_cast<size_t>(row->firstOffset);
+        // Every distinct neighbour on one side is at least one distinct context
+        evidence.distinctContexts = std::min<size_t>(row->count, std::max(row->leftVariety, row->rightVariety));
+        if (options_.useContextualAnalysis && row->count > 0) {
+            evidence.context = row->context;
+        }
+        return evidence;
+    }, progressCallback);
+}
 
-        // Check dictionary if required
-        if (options_.useDictionaryLookup && !dictionary_.empty()) {
-            if (lookupInDictionary(candidate)) {
-                // Skip words that are already in the dictionary
-                processed++;
-                if (progressCallback) {
-                    progressCallback(static_cast<double>(processed) / total);
+std::vector<CandidateStore::Id> CandidateVerifier::verifyCandidatesStreaming(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    const std::string& originalTextPath,
+    const std::function<void(double)>& progressCallback
+) {
+    std::ifstream file(originalTextPath, std::ios::binary);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open original text file: " + originalTextPath);
+    }
+    uint64_t fileSize = 0;
+    try {
+        fileSize = std::filesystem::file_size(originalTextPath);
+    } catch (const std::exception&) {
+        // Continue without a size for progress reporting
+    }
+
+    std::vector<std::string_view> patterns;
+    patterns.reserve(ids.size());
+    size_t longest = 0;
+    for (CandidateStore::Id id : ids) {
+        patterns.push_back(store.text(id));
+        longest = std::max(longest, patterns.back().size());
+    }
+    AhoCorasick automaton(patterns);
+
+    // Bytes kept from one block to the next: the overlap that straddling
+    // matches need, plus room for the contexts on either side of a match
+    size_t overlap = longest > 0 ? longest - 1 : 0;
+    size_t keep = overlap + 2 * kContextBytes;
+    size_t blockSize = static_cast<size_t>(options_.verificationBlockSize);
+    bool wantContexts = options_.useContextualAnalysis;
+
+    // Greedy leftmost non-overlapping count per pattern, as findAll() keeps
+    struct Tally {
+        size_t count = 0;
+        uint64_t first = 0;
+        uint64_t next = 0;
+    };
+    robin_hood::unordered_flat_map<size_t, Tally> tallies;
+    robin_hood::unordered_flat_map<size_t, std::string> contexts;
+    std::vector<size_t> pending; // First occurrences still waiting for context bytes
+
+    std::string buffer;
+    uint64_t bufferStart = 0; // File offset of buffer[0]
+    uint64_t scanned = 0;     // Every match ending at or before this offset is counted
+    uint64_t total = 0;
+    bool last = false;
+    while (!last) {
+        size_t kept = buffer.size();
+        buffer.resize(kept + blockSize);
+        file.read(&buffer[kept], static_cast<std::streamsize>(blockSize));
+        size_t got = static_cast<size_t>(file.gcount());
+        buffer.resize(kept + got);
+        total += got;
+        last = got < blockSize;
+        std::string_view view(buffer);
+
+        uint64_t bufferEnd = bufferStart + buffer.size();
+        auto contextAt = [&](uint64_t position) {
+            return std::string(utf8Context(view, static_cast<size_t>(position - bufferStart), kContextCodePoints, true));
+        };
+        auto hasContext = [&](uint64_t position) {
+            return last || position + kContextBytes <= bufferEnd;
+        };
+        // The bytes before a pending occurrence stay in the kept tail until it has its context
+        pending.erase(std::remove_if(pending.begin(), pending.end(), [&](size_t pattern) {
+            uint64_t first = tallies[pattern].first;
+            if (!hasContext(first)) {
+                return false;
+            }
+            contexts[pattern] = contextAt(first);
+            return true;
+        }), pending.end());
+
+        size_t scanFrom = static_cast<size_t>(std::max(bufferStart, scanned > overlap ? scanned - overlap : 0) - bufferStart);
+        automaton.scan(view.substr(scanFrom), [&](size_t pattern, size_t start) {
+            uint64_t position = bufferStart + scanFrom + start;
+            uint64_t end = position + patterns[pattern].size();
+            if (end <= scanned) {
+                return; // Counted by the previous scan
+            }
+            auto [it, inserted] = tallies.try_emplace(pattern);
+            Tally& entry = it->second;
+            if (inserted) {
+                entry.first = position;
+                if (wantContexts) {
+                    if (hasContext(position)) {
+                        contexts[pattern] = contextAt(position);
+                    } else {
+                        pending.push_back(pattern);
+                    }
                 }
-                continue;
+            } else if (position < entry.next) {
+                return;
             }
+            entry.count++;
+            entry.next = end;
+        });
+        scanned = bufferEnd;
+
+        // Keep the tail the next scan and pending contexts need
+        if (buffer.size() > keep) {
+            buffer.erase(0, buffer.size() - keep);
+            bufferStart = bufferEnd - keep;
         }
 
-        // Create verified candidate
-        VerifiedCandidate verifiedCandidate;
-        verifiedCandidate.text = candidate.text;
-        verifiedCandidate.score = candidate.score;
-        verifiedCandidate.frequency = candidate.frequency;
-        verifiedCandidate.context = context;
-        verifiedCandidate.contextScore = contextScore;
-        verifiedCandidate.statisticalScore = statisticalScore;
+        // Scanning is the first half of the progress
+        if (progressCallback && fileSize > 0 && !last) {
+            progressCallback(std::min(0.5, 0.5 * static_cast<double>(scanned) / fileSize));
+        }
+    }
 
-        verifiedCandidates.push_back(verifiedCandidate);
+    std::vector<Evidence> evidence(patterns.size());
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        if (patterns[p].empty()) {
+            evidence[p].occurrences.count = static_cast<size_t>(total);
+            continue;
+        }
+        size_t key = automaton.canonical(p);
+        auto it = tallies.find(key);
+        if (it == tallies.end()) {
+            continue;
+        }
+        evidence[p].occurrences.count = it->second.count;
+        evidence[p].occurrences.first = static_cast<size_t>(it->second.first);
+        if (wantContexts) {
+            evidence[p].context = contexts[key];
+        }
+    }
 
-        // Report progress
-        processed++;
+    return verifyAll(store, ids, [&evidence](size_t index, std::string_view) {
+        return evidence[index];
+    }, [&progressCallback](double ratio) {
         if (progressCallback) {
-            progressCallback(static_cast<double>(processed) / total);
+            progressCallback(0.5 + ratio * 0.5);
+        }
+    });
+}
+
+std::vector<CandidateStore::Id> CandidateVerifier::verifyAll(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    const EvidenceSource& evidence,
+    const std::function<void(double)>& progressCallback
+) {
+    // Candidates are independent and the evidence is read-only, so they can be
+    // verified in any order; results are kept by index to preserve the input order
+    size_t total = ids.size();
+    std::vector<std::optional<Verification>> results(total);
+
+    // An incremental verification keeps the evidence of every candidate, accepted or not
+    std::vector<Evidence> gathered(incremental_ ? total : 0);
+
+    // Ranges only count the candidates they verified; the reporter thread reports the share done
+    std::function<void(const ProgressInfo&)> reportRatio;
+    if (progressCallback && total > 0) {
+        reportRatio = [&progressCallback](const ProgressInfo& info) { progressCallback(info.phaseRatio); };
+    }
+    ProgressReporter progress(reportRatio, options_.progressStep);
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 1.0, total);
+
+    auto verifyRange = [&](size_t begin, size_t end) {
+        for (size_t index = begin; index < end; ++index) {
+            CandidateStore::Id id = ids[index];
+            std::string_view text = store.text(id);
+            Evidence found = evidence(index, text);
+            results[index] = verifyCandidate(text, store.frequency(id), found);
+            if (incremental_) {
+                gathered[index] = found;
+            }
+        }
+        progress.add(end - begin);
+    };
+
+    if (options_.useParallelProcessing && options_.threads != 1) {
+        parallel::ParallelExecutor::parallelFor(total, verifyRange, options_.threads);
+    } else {
+        for (size_t index = 0; index < total; ++index) {
+            verifyRange(index, index + 1);
+        }
+    }
+    progress.endPhase();
+
+    if (incremental_) {
+        for (size_t index = 0; index < total; ++index) {
+            CandidateStore::Id id = ids[index];
+            const Evidence& found = gathered[index];
+            incremental_->record(store.text(id), {store.score(id), store.frequency(id), found.occurrences.count,
+                                                  found.occurrences.first, found.distinctContexts,
+                                                  std::string(found.context)});
         }
     }
 
-    return verifiedCandidates;
+    // Contexts still point into the text or the streamed contexts; they are
+    // copied into the store here, after the parallel part, as the store is single-writer
+    std::vector<CandidateStore::Id> verified;
+    for (size_t index = 0; index < total; ++index) {
+        if (!results[index]) {
+            continue;
+        }
+        CandidateStore::Id id = ids[index];
+        const Verification& verification = *results[index];
+        if (!verification.context.empty()) {
+            store.setContext(id, verification.context);
+        }
+        store.setContextScore(id, verification.contextScore);
+        store.setStatisticalScore(id, verification.statisticalScore);
+        verified.push_back(id);
+    }
+
+    return verified;
 }
 
-CandidateVerifier::TextIndex::TextIndex(const std::string& textPath) {
-    // Read text file
-    std::ifstream file(textPath);
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open original text file: " + textPath);
+std::vector<CandidateStore::Id> CandidateVerifier::verifyIncrementally(
+    CandidateStore& store,
+    const std::vector<CandidateStore::Id>& ids,
+    uint64_t textHash,
+    const std::function<std::vector<CandidateStore::Id>(const std::vector<CandidateStore::Id>&)>& verifyFresh,
+    const std::function<void(double)>& progressCallback
+) {
+    IncrementalState state(options_.incrementalStatePath, textHash, evidenceLevel(options_),
+                           options_.incrementalTolerance);
+
+    std::vector<CandidateStore::Id> fresh;
+    std::vector<CandidateStore::Id> cached;
+    std::vector<const CachedEvidence*> recorded;
+    for (CandidateStore::Id id : ids) {
+        const CachedEvidence* evidence = state.reusable(store.text(id), store.score(id), store.frequency(id));
+        if (evidence) {
+            cached.push_back(id);
+            recorded.push_back(evidence);
+        } else {
+            fresh.push_back(id);
+        }
     }
 
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    text_ = buffer.str();
-}
+    // The fresh candidates take the usual route, which records their evidence on the way
+    std::vector<CandidateStore::Id> accepted;
+    std::vector<CandidateStore::Id> reused;
+    incremental_ = &state;
+    try {
+        if (!fresh.empty()) {
+            accepted = verifyFresh(fresh);
+        }
+        reused = verifyAll(store, cached, [&](size_t index, std::string_view) {
+            const CachedEvidence& entry = *recorded[index];
+            Evidence evidence;
+            evidence.occurrences.count = static_cast<size_t>(entry.count);
+            evidence.occurrences.first = static_cast<size_t>(entry.first);
+            evidence.distinctContexts = static_cast<size_t>(entry.distinctContexts);
+            evidence.context = entry.context;
+            return evidence;
+        }, nullptr);
+    } catch (...) {
+        incremental_ = nullptr;
+        throw;
+    }
+    incremental_ = nullptr;
+    reusedCandidates_ += cached.size();
+    if (fresh.empty() && progressCallback) {
+        progressCallback(1.0);
+    }
+    state.save();
 
-bool CandidateVerifier::TextIndex::contains(const std::string& pattern) const {
-    return text_.find(pattern) != std::string::npos;
+    // Both lists keep the input order; merge them back into it
+    if (reused.empty()) {
+        return accepted;
+    }
+    std::vector<char> isAccepted(store.size(), 0);
+    for (CandidateStore::Id id : accepted) {
+        isAccepted[id] = 1;
+    }
+    for (CandidateStore::Id id : reused) {
+        isAccepted[id] = 1;
+    }
+    std::vector<CandidateStore::Id> verified;
+    verified.reserve(accepted.size() + reused.size());
+    for (CandidateStore::Id id : ids) {
+        if (isAccepted[id]) {
+            verified.push_back(id);
+        }
+    }
+    return verified;
 }
 
-std::vector<size_t> CandidateVerifier::TextIndex::findAll(const std::string& pattern) const {
-    std::vector<size_t> positions;
-    size_t pos = 0;
+std::optional<CandidateVerifier::Verification> CandidateVerifier::verifyCandidate(
+    std::string_view text,
+    uint32_t frequency,
+    const Evidence& evidence
+) const {
+    const TextIndex::Occurrences& occurrences = evidence.occurrences;
 
-    while ((pos = text_.find(pattern, pos)) != std::string::npos) {
-        positions.push_back(pos);
-        pos += pattern.length();
+    // Verify in original text if required
+    if (options_.verifyInOriginalText && !verifyInText(occurrences)) {
+        return std::nullopt;
     }
 
-    return positions;
-}
+    Verification verification;
 
-std::string CandidateVerifier::TextIndex::getContext(size_t position, size_t contextSize) const {
-    // Convert to ICU UnicodeString for proper UTF-8 handling
-    UnicodeString ustr = UnicodeString::fromUTF8(text_);
+    // Analyze context if required
+    if (options_.useContextualAnalysis) {
+        auto [context, score] = analyzeContext(evidence);
+        verification.context = context;
+        verification.contextScore = score;
+    }
 
-    // Find the code point index for the byte position
-    int32_t cpIndex = 0;
-    int32_t bytePos = 0;
+    // Validate statistically if required
+    if (options_.useStatisticalValidation) {
+        verification.statisticalScore = validateStatistically(text, frequency, evidence);
+    }
 
-    while (bytePos < static_cast<int32_t>(position) && cpIndex < ustr.length()) {
-        UChar32 c = ustr.char32At(cpIndex);
-        cpIndex += U16_LENGTH(c);
+    // Skip words that are already in the dictionary
+    if (options_.useDictionaryLookup && (staticDictionary_ || (dictionary_ && !dictionary_->empty())) && lookupInDictionary(text)) {
+        return std::nullopt;
+    }
 
-        // Calculate UTF-8 bytes for this code point
-        int32_t len = U8_LENGTH(c);
-        bytePos += len;
+    return verification;
+}
+
+CandidateVerifier::TextIndex::TextIndex(std::string_view text, bool buildIndex, const std::string& indexPath)
+    : text_(text)
+{
+    if (!buildIndex) {
+        return;
     }
+    if (!indexPath.empty()) {
+        index_ = SuffixArray::open(text_, indexPath);
+        if (index_) {
+            return;
+        }
+    }
+    index_ = std::make_unique<SuffixArray>(text_);
+    if (!indexPath.empty()) {
+        try {
+            index_->write(indexPath);
+        } catch (const std::exception&) {
+            // The file is only a cache; this run has its index either way
+        }
+    }
+}
 
-    // Calculate start and end code point indices
-    int32_t startCp = std::max(0, cpIndex - static_cast<int32_t>(contextSize));
-    int32_t endCp = std::min(ustr.length(), cpIndex + static_cast<int32_t>(contextSize));
+bool CandidateVerifier::TextIndex::contains(std::string_view pattern) const {
+    return index_->count(pattern) > 0;
+}
 
-    // Extract the context substring
-    UnicodeString contextStr = UnicodeString(ustr, startCp, endCp - startCp);
+std::vector<size_t> CandidateVerifier::TextIndex::findAll(std::string_view pattern) const {
+    std::vector<size_t> all = index_->positions(pattern);
+    if (pattern.empty()) {
+        return all;
+    }
 
-    // Convert back to UTF-8
-    std::string result;
-    contextStr.toUTF8String(result);
+    // Keep the non-overlapping occurrences, leftmost first
+    std::vector<size_t> positions;
+    size_t next = 0;
+    for (size_t pos : all) {
+        if (pos >= next) {
+            positions.push_back(pos);
+            next = pos + pattern.length();
+        }
+    }
+    return positions;
+}
+
+CandidateVerifier::TextIndex::Occurrences CandidateVerifier::TextIndex::occurrences(std::string_view pattern) const {
+    return occurrenceCache_.getOrCompute(std::string(pattern), [&]() {
+        Occurrences result;
+        std::vector<size_t> positions = findAll(pattern);
+        result.count = positions.size();
+        result.first = positions.empty() ? 0 : positions.front();
+        return result;
+    });
+}
 
+std::vector<CandidateVerifier::TextIndex::Occurrences> CandidateVerifier::TextIndex::countAll(
+    const std::vector<std::string_view>& patterns,
+    unsigned int threads
+) const {
+    AhoCorasick automaton(patterns);
+
+    // Chunks may only be cut at newlines if no match can span one
+    bool lineSafe = std::none_of(patterns.begin(), patterns.end(), [](std::string_view pattern) {
+        return pattern.find('\n') != std::string_view::npos;
+    });
+    threads = resolveThreads(threads);
+    size_t chunkCount = lineSafe ? std::max<size_t>(1, std::min<size_t>(threads, text_.size() / (1 << 20))) : 1;
+
+    std::vector<size_t> bounds{0};
+    for (size_t c = 1; c < chunkCount; ++c) {
+        size_t cut = text_.find('\n', std::max(bounds.back(), text_.size() * c / chunkCount));
+        if (cut == std::string::npos) {
+            break;
+        }
+        bounds.push_back(cut + 1);
+    }
+    bounds.push_back(text_.size());
+    chunkCount = bounds.size() - 1;
+
+    // Greedy leftmost non-overlapping count per pattern, as findAll() keeps
+    struct Tally {
+        size_t count = 0;
+        size_t first = 0;
+        size_t next = 0;
+    };
+    std::vector<robin_hood::unordered_flat_map<size_t, Tally>> tallies(chunkCount);
+    parallel::ParallelExecutor::parallelFor(chunkCount, [&](size_t begin, size_t end) {
+        for (size_t c = begin; c < end; ++c) {
+            auto& tally = tallies[c];
+            size_t offset = bounds[c];
+            automaton.scan(std::string_view(text_).substr(offset, bounds[c + 1] - offset),
+                           [&](size_t pattern, size_t start) {
+                auto [it, inserted] = tally.try_emplace(pattern);
+                Tally& entry = it->second;
+                if (inserted) {
+                    entry.first = offset + start;
+                } else if (offset + start < entry.next) {
+                    return;
+                }
+                entry.count++;
+                entry.next = offset + start + patterns[pattern].size();
+            });
+        }
+    }, static_cast<unsigned int>(chunkCount), 1);
+
+    std::vector<Occurrences> result(patterns.size());
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        Occurrences& occurrence = result[p];
+        if (patterns[p].empty()) {
+            occurrence.count = text_.size();
+            continue;
+        }
+        size_t key = automaton.canonical(p);
+        for (const auto& tally : tallies) {
+            auto it = tally.find(key);
+            if (it == tally.end()) {
+                continue;
+            }
+            if (occurrence.count == 0) {
+                occurrence.first = it->second.first;
+            }
+            occurrence.count += it->second.count;
+        }
+    }
     return result;
 }
 
-bool CandidateVerifier::verifyInText(const WordCandidate& candidate, const TextIndex& textIndex) {
-    return textIndex.contains(candidate.text);
+std::string_view CandidateVerifier::TextIndex::getContext(size_t position, size_t contextSize) const {
+    // Contexts stay on the candidate's line; lines are independent documents
+    return utf8Context(text_, position, contextSize, true);
 }
 
-std::pair<std::string, double> CandidateVerifier::analyzeContext(
-    const WordCandidate& candidate,
-    const TextIndex& textIndex
-) {
-    // Find all occurrences
-    auto positions = textIndex.findAll(candidate.text);
+bool CandidateVerifier::verifyInText(const TextIndex::Occurrences& occurrences) const {
+    return occurrences.count > 0;
+}
+
+std::pair<std::string_view, double> CandidateVerifier::analyzeContext(const Evidence& evidence) const {
+    const TextIndex::Occurrences& occurrences = evidence.occurrences;
 
     // If no occurrences, return empty context
-    if (positions.empty()) {
-        return {"", 0.0};
+    if (occurrences.count == 0) {
+        return {std::string_view(), 0.0};
     }
 
-    // Get context of first occurrence
-    std::string context = textIndex.getContext(positions[0]);
-
     // Simple context score based on number of occurrences
-    double contextScore = std::min(1.0, positions.size() / 10.0);
+    double contextScore = std::min(1.0, occurrences.count / 10.0);
 
-    return {context, contextScore};
+    // Context of the first occurrence
+    return {evidence.context, contextScore};
 }
 
 double CandidateVerifier::validateStatistically(
-    const WordCandidate& candidate,
-    const TextIndex& textIndex
-) {
+    std::string_view text,
+    uint32_t frequency,
+    const Evidence& evidence
+) const {
     // Zero frequency gets zero score
-    if (candidate.frequency == 0) {
+    if (frequency == 0) {
         return 0.0;
     }
 
     // Base score from frequency (normalized)
-    double frequencyScore = std::min(1.0, candidate.frequency / 20.0);
+    double frequencyScore = std::min(1.0, frequency / 20.0);
     
     // Length bonus: longer words are generally more informative
     // Bonus scales with character count (UTF-8 aware)
     size_t charCount = 0;
-    const char* ptr = candidate.text.c_str();
-    const char* end = ptr + candidate.text.length();
+    const char* ptr = text.data();
+    const char* end = ptr + text.length();
     
     // Count UTF-8 characters properly
     while (ptr < end) {
@@ -239,11 +868,11 @@ double CandidateVerifier::validateStatistically(
     // Apply length bonus to frequency score
     double statisticalScore = frequencyScore * lengthBonus;
     
-    // Consider context diversity if available
-    auto positions = textIndex.findAll(candidate.text);
-    if (positions.size() > 1) {
+    // Consider context diversity if available; occurrences stand in for it otherwise
+    size_t contexts = evidence.distinctContexts > 0 ? evidence.distinctContexts : evidence.occurrences.count;
+    if (contexts > 1) {
         // Multiple occurrences in different contexts boost the score
-        double contextDiversityBonus = 1.0 + std::min(0.2, (positions.size() - 1) * 0.05);
+        double contextDiversityBonus = 1.0 + std::min(0.2, (contexts - 1) * 0.05);
         statisticalScore *= contextDiversityBonus;
     }
     
@@ -251,8 +880,11 @@ double CandidateVerifier::validateStatistically(
     return std::min(1.0, statisticalScore);
 }
 
-bool CandidateVerifier::lookupInDictionary(const WordCandidate& candidate) {
-    return dictionary_.find(candidate.text) != dictionary_.end();
+bool CandidateVerifier::lookupInDictionary(std::string_view text) const {
+    if (staticDictionary_) {
+        return staticDictionary_->contains(text);
+    }
+    return dictionary_ && dictionary_->count(std::string(text)) > 0;
 }
 
 } // namespace core
@@ -6,11 +6,20 @@
 #ifndef SUZUME_CORE_WORD_EXTRACTION_VERIFIER_H_
 #define SUZUME_CORE_WORD_EXTRACTION_VERIFIER_H_
 
+#include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <unordered_set>
+#include "candidate_store.h"
 #include "common.h"
+#include "core/ngram_cache.h"
+#include "core/ngram_stats.h"
+#include "core/static_dictionary.h"
+#include "core/suffix_array.h"
+#include "incremental_state.h"
 #include "suzume_feedmill.h"
 
 namespace suzume {
@@ -33,9 +42,12 @@ public:
     /**
      * @brief Verify candidates
      *
+     * Candidates are verified in parallel on the shared executor when
+     * parallel processing is enabled; the output keeps the input order.
+     *
      * @param candidates Input candidates
      * @param originalTextPath Path to original text
-     * @param progressCallback Progress callback function (optional)
+     * @param progressCallback Progress callback function (optional; called from one thread at a time, increasing)
      * @return std::vector<VerifiedCandidate> Verified candidates
      */
     std::vector<VerifiedCandidate> verifyCandidates(
@@ -44,18 +56,139 @@ public:
         const std::function<void(double)>& progressCallback = nullptr
     );
 
+    /**
+     * @brief Verify candidates held in a candidate store
+     *
+     * Contexts and verification scores of the accepted candidates are
+     * written to the store; texts are read in place and never copied.
+     * The original text is memory-mapped, not read into the heap. With
+     * streaming verification it is scanned block by block instead, so it
+     * can be larger than memory or the address space. With PMI statistics
+     * the candidates are looked up there and the text is only read for
+     * those the statistics leave out.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param originalTextPath Path to original text
+     * @param progressCallback Progress callback function (optional; called from one thread at a time, increasing)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     */
+    std::vector<CandidateStore::Id> verifyCandidates(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        const std::string& originalTextPath,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
+    /**
+     * @brief Verify candidates held in a candidate store against a text in memory
+     *
+     * Same as verifyCandidates(), with the index built over the caller's
+     * text instead of a copy read from a file.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param originalText Original text (must outlive the call)
+     * @param progressCallback Progress callback function (optional; called from one thread at a time, increasing)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     */
+    std::vector<CandidateStore::Id> verifyCandidatesInText(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        std::string_view originalText,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
+    /**
+     * @brief Receives the candidates accepted in one batch
+     *
+     * processed counts the candidates verified so far, from the start of
+     * the ID list; returning false stops before the next batch.
+     */
+    using BatchCallback = std::function<bool(size_t processed, const std::vector<CandidateStore::Id>& accepted)>;
+
+    /**
+     * @brief Verify candidates in the given order, one batch at a time, until told to stop
+     *
+     * The text is indexed once and every batch is verified against it as
+     * verifyCandidates() would verify it, so a caller can stop as soon as
+     * the candidates left cannot matter. Candidates are looked up in the
+     * suffix array, or in the PMI statistics when there are any; batch and
+     * streaming verification do not apply.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify, in the order to verify them
+     * @param originalTextPath Path to original text
+     * @param batchSize Number of candidates per batch
+     * @param onBatch Called after every batch with the candidates it accepted, in input order
+     * @throws std::runtime_error If the text cannot be read
+     */
+    void verifyCandidatesInBatches(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        const std::string& originalTextPath,
+        size_t batchSize,
+        const BatchCallback& onBatch
+    );
+
+    /**
+     * @brief Verify candidates in batches against a text in memory
+     *
+     * Same as verifyCandidatesInBatches(), with the index built over the
+     * caller's text.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify, in the order to verify them
+     * @param originalText Original text (must outlive the call)
+     * @param batchSize Number of candidates per batch
+     * @param onBatch Called after every batch with the candidates it accepted, in input order
+     */
+    void verifyCandidatesInBatchesInText(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        std::string_view originalText,
+        size_t batchSize,
+        const BatchCallback& onBatch
+    );
+
+    /**
+     * @brief Get the number of candidates verified from the incremental state
+     * @return size_t Candidates whose evidence was reused, over every call so far
+     */
+    size_t reusedCandidates() const { return reusedCandidates_; }
+
 private:
     /**
      * @brief Text index for efficient search
+     *
+     * Holds a suffix array of the original text, which it references and
+     * does not own, so a pattern lookup costs
+     * O(pattern length + log text length) instead of a scan of the text.
+     * Batch verification skips the suffix array and counts every candidate
+     * in one pass with countAll().
      */
     class TextIndex {
     public:
+        /**
+         * @brief Occurrence summary of a pattern
+         */
+        struct Occurrences {
+            size_t count = 0;   ///< Non-overlapping occurrences
+            size_t first = 0;   ///< Byte position of the first occurrence
+        };
+
         /**
          * @brief Constructor
          *
-         * @param textPath Path to text file
+         * A suffix array file that matches the text is mapped instead of
+         * building the array; otherwise the built array is written there
+         * for the next run. Failing to write it only loses the reuse.
+         *
+         * @param text Text to index (must outlive the index)
+         * @param buildIndex Build the suffix array for per-pattern queries
+         * @param indexPath Suffix array file to reuse, or empty
          */
-        TextIndex(const std::string& textPath);
+        TextIndex(std::string_view text, bool buildIndex = true, const std::string& indexPath = "");
 
         /**
          * @brief Check if text contains pattern
@@ -63,7 +196,7 @@ private:
          * @param pattern Pattern to search for
          * @return bool True if pattern is found
          */
-        bool contains(const std::string& pattern) const;
+        bool contains(std::string_view pattern) const;
 
         /**
          * @brief Find all occurrences of pattern
@@ -71,59 +204,237 @@ private:
          * @param pattern Pattern to search for
          * @return std::vector<size_t> Positions of pattern occurrences
          */
-        std::vector<size_t> findAll(const std::string& pattern) const;
+        std::vector<size_t> findAll(std::string_view pattern) const;
+
+        /**
+         * @brief Count the occurrences of pattern
+         *
+         * Context analysis and statistical validation both need the
+         * occurrences of a candidate; the summary of recent patterns is
+         * cached so the index is searched once instead of once per step.
+         *
+         * @param pattern Pattern to search for
+         * @return Occurrences Count and first position
+         */
+        Occurrences occurrences(std::string_view pattern) const;
+
+        /**
+         * @brief Count many patterns in one Aho-Corasick pass over the text
+         *
+         * When no pattern spans a newline the text is split into
+         * line-aligned chunks scanned in parallel; no match can cross a
+         * chunk boundary, so the results equal a sequential scan.
+         *
+         * @param patterns Patterns to count
+         * @param threads Number of threads (0 = auto)
+         * @return std::vector<Occurrences> Occurrences of each pattern, as occurrences() would report
+         */
+        std::vector<Occurrences> countAll(const std::vector<std::string_view>& patterns, unsigned int threads) const;
 
         /**
          * @brief Get context around position
          *
          * @param position Position in text
-         * @param contextSize Context size (characters before and after)
-         * @return std::string Context string
+         * @param contextSize Context size (characters before and after, within the line)
+         * @return std::string_view Context, a view into the indexed text
          */
-        std::string getContext(size_t position, size_t contextSize = 20) const;
+        std::string_view getContext(size_t position, size_t contextSize = 20) const;
 
     private:
-        std::string text_;
-        // Additional index structures (e.g., suffix array, bloom filter)
+        std::string_view text_;
+        std::unique_ptr<SuffixArray> index_;    // References text_
+        mutable ShardedLruCache<std::string, Occurrences> occurrenceCache_{4096};
     };
 
+    /**
+     * @brief Mapped original text together with its full text index
+     */
+    struct IndexedText;
+
+    /**
+     * @brief Open and index an original text, or reuse the warm cached one
+     *
+     * @param textPath Path to the original text
+     * @return std::shared_ptr<const IndexedText> Text and its suffix array index
+     * @throws std::runtime_error If the text cannot be opened
+     */
+    std::shared_ptr<const IndexedText> indexedText(const std::string& textPath) const;
+
+    /**
+     * @brief What the original text says about one candidate
+     */
+    struct Evidence {
+        TextIndex::Occurrences occurrences;
+        std::string_view context;       // Context of the first occurrence, if wanted
+        size_t distinctContexts = 0;    // Lower bound on the distinct contexts (0 = unknown)
+    };
+
+    /**
+     * @brief Verification results of an accepted candidate
+     */
+    struct Verification {
+        std::string_view context;       // View into the text index or streamed contexts
+        double contextScore = 0.0;
+        double statisticalScore = 0.0;
+    };
+
+    /**
+     * @brief Collects the evidence of the candidate at an index of the ID list
+     */
+    using EvidenceSource = std::function<Evidence(size_t index, std::string_view text)>;
+
+    /**
+     * @brief Look up the evidence of a candidate in the text index
+     *
+     * @param textIndex Index of the original text
+     * @param text Candidate text
+     * @return Evidence Occurrences, and the first context if contextual analysis is on
+     */
+    Evidence indexedEvidence(const TextIndex& textIndex, std::string_view text) const;
+
+    /**
+     * @brief Verify every candidate from its evidence and store the results
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param evidence Evidence of each candidate (called concurrently)
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     */
+    std::vector<CandidateStore::Id> verifyAll(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        const EvidenceSource& evidence,
+        const std::function<void(double)>& progressCallback
+    );
+
+    /**
+     * @brief Verify candidates with one block-by-block scan of the original text
+     *
+     * Blocks of verificationBlockSize bytes are scanned with one
+     * Aho-Corasick automaton of all candidates. Each scan starts the
+     * longest candidate minus one byte before the end of the previous
+     * block, so matches that straddle a boundary are found, and counts
+     * only matches that end past it, so none is counted twice. Contexts
+     * are copied out of the block as first occurrences are found; the
+     * result equals that of batch verification over the whole text.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param originalTextPath Path to original text
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     * @throws std::runtime_error If the text cannot be read
+     */
+    std::vector<CandidateStore::Id> verifyCandidatesStreaming(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        const std::string& originalTextPath,
+        const std::function<void(double)>& progressCallback
+    );
+
+    /**
+     * @brief Verify candidates from PMI statistics instead of searching the text
+     *
+     * Candidates the statistics cover are verified from their rows, their
+     * neighbour diversity standing in for the distinct contexts. The rest
+     * are counted in one Aho-Corasick pass over the text, which is only
+     * opened for them.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param textBytes Size of the original text, checked against the statistics
+     * @param originalText Opens the original text and returns it (called at most once)
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     * @throws std::runtime_error If the statistics cannot be read or were gathered over another text
+     */
+    std::vector<CandidateStore::Id> verifyCandidatesFromStats(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        uint64_t textBytes,
+        const std::function<std::string_view()>& originalText,
+        const std::function<void(double)>& progressCallback
+    );
+
+    /**
+     * @brief Verify candidates, reusing the evidence of the previous run where it holds
+     *
+     * Candidates the incremental state can vouch for are verified from
+     * their recorded evidence, the rest through verifyFresh; every
+     * verification step still runs, so only the search of the text is
+     * skipped. The evidence of all of them is recorded by verifyAll() and
+     * the state file is rewritten.
+     *
+     * @param store Candidate store
+     * @param ids Candidates to verify
+     * @param textHash XXH3 hash of the original text
+     * @param verifyFresh Verifies the candidates the state cannot vouch for
+     * @param progressCallback Progress callback function (optional)
+     * @return std::vector<CandidateStore::Id> Verified candidates, in input order
+     * @throws std::runtime_error If the state file cannot be read or written
+     */
+    std::vector<CandidateStore::Id> verifyIncrementally(
+        CandidateStore& store,
+        const std::vector<CandidateStore::Id>& ids,
+        uint64_t textHash,
+        const std::function<std::vector<CandidateStore::Id>(const std::vector<CandidateStore::Id>&)>& verifyFresh,
+        const std::function<void(double)>& progressCallback
+    );
+
+    /**
+     * @brief Run every enabled verification step on one candidate
+     *
+     * @param text Candidate text
+     * @param frequency Candidate frequency
+     * @param evidence Occurrences and first context of the candidate
+     * @return std::optional<Verification> Verification results, or nullopt if rejected
+     */
+    std::optional<Verification> verifyCandidate(
+        std::string_view text,
+        uint32_t frequency,
+        const Evidence& evidence
+    ) const;
+
     /**
      * @brief Verify candidate in text
      *
-     * @param candidate Candidate to verify
-     * @param textIndex Text index
+     * @param occurrences Occurrences of the candidate
      * @return bool True if candidate is verified
      */
-    bool verifyInText(const WordCandidate& candidate, const TextIndex& textIndex);
+    bool verifyInText(const TextIndex::Occurrences& occurrences) const;
 
     /**
      * @brief Analyze context
      *
-     * @param candidate Candidate to analyze
-     * @param textIndex Text index
-     * @return std::pair<std::string, double> Context and context score
+     * @param evidence Occurrences and first context of the candidate
+     * @return std::pair<std::string_view, double> Context and context score
      */
-    std::pair<std::string, double> analyzeContext(const WordCandidate& candidate, const TextIndex& textIndex);
+    std::pair<std::string_view, double> analyzeContext(const Evidence& evidence) const;
 
     /**
      * @brief Validate statistically
      *
-     * @param candidate Candidate to validate
-     * @param textIndex Text index
+     * @param text Candidate text
+     * @param frequency Candidate frequency
+     * @param evidence Occurrences and distinct contexts of the candidate
      * @return double Statistical score
      */
-    double validateStatistically(const WordCandidate& candidate, const TextIndex& textIndex);
+    double validateStatistically(std::string_view text, uint32_t frequency, const Evidence& evidence) const;
 
     /**
      * @brief Lookup in dictionary
      *
-     * @param candidate Candidate to lookup
+     * @param text Candidate text
      * @return bool True if candidate is in dictionary
      */
-    bool lookupInDictionary(const WordCandidate& candidate);
+    bool lookupInDictionary(std::string_view text) const;
 
     WordExtractionOptions options_;
-    std::unordered_set<std::string> dictionary_; // Dictionary (if used)
+    std::shared_ptr<const std::unordered_set<std::string>> dictionary_; // Dictionary (if used)
+    std::shared_ptr<const StaticDictionary> staticDictionary_; // Prebuilt dictionary (if used)
+    IncrementalState* incremental_ = nullptr;   // Records evidence while an incremental verification runs
+    size_t reusedCandidates_ = 0;
 };
 
 } // namespace core
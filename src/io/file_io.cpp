@@ -4,14 +4,52 @@
  */
 
 #include "io/file_io.h"
+#include "core/compressed_input.h"
+#include "core/mapped_text.h"
+#include "core/output_writer.h"
 #include <fstream>
 #include <iostream>
 #include <filesystem>
+#include <memory>
 #include <stdexcept>
 
 namespace suzume {
 namespace io {
 
+namespace {
+
+/**
+ * @brief Open an input file, decompressing gzip/zstd input transparently
+ *
+ * @param path File path
+ * @param fileSize Set to the file size, or 0 for compressed files
+ * @return std::unique_ptr<std::istream> Stream of the file's text
+ */
+std::unique_ptr<std::istream> openTextInput(const std::string& path, size_t& fileSize) {
+    // Get file size for progress reporting
+    fileSize = 0;
+    try {
+        fileSize = std::filesystem::file_size(path);
+    } catch (const std::exception& e) {
+        // Continue without progress reporting
+    }
+
+    core::Compression compression = core::detectFileCompression(path);
+    if (compression == core::Compression::None) {
+        auto file = std::make_unique<std::ifstream>(path, std::ios::binary);
+        if (!*file) {
+            throw std::runtime_error("Failed to open file: " + path);
+        }
+        return file;
+    }
+
+    // Compressed size does not track progress through the text
+    fileSize = 0;
+    return core::openInputStream(path);
+}
+
+} // namespace
+
 bool TextFileReader::isStdin(const std::string& path) {
     return path == "-";
 }
@@ -24,131 +62,61 @@ std::vector<std::string> TextFileReader::readAllLines(
     const std::string& path,
     const std::function<void(double)>& progressCallback
 ) {
-    // Check if reading from stdin
-    if (isStdin(path)) {
-        // Read from stdin
-        std::vector<std::string> lines;
-        std::string line;
-
-        while (std::getline(std::cin, line)) {
-            lines.push_back(line);
-
-            // No progress reporting for stdin (unknown size)
-        }
-
-        // Final progress update
-        if (progressCallback) {
-            progressCallback(1.0);
-        }
-
-        return lines;
-    } else {
-        // Check if file exists
-        if (!std::filesystem::exists(path)) {
-            throw std::runtime_error("File does not exist: " + path);
-        }
-
-        // Get file size for progress reporting
-        size_t fileSize = 0;
-        try {
-            fileSize = std::filesystem::file_size(path);
-        } catch (const std::exception& e) {
-            // Continue without progress reporting
-        }
-
-        // Open file
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open file: " + path);
-        }
-
-        // Read lines
-        std::vector<std::string> lines;
-        std::string line;
-        size_t bytesRead = 0;
-
-        while (std::getline(file, line)) {
-            // Remove carriage return if present (for Windows CRLF handling)
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            lines.push_back(line);
-
-            bytesRead += line.size() + 1; // +1 for newline
-
-            // Report progress
-            if (progressCallback && fileSize > 0) {
-                double progress = static_cast<double>(bytesRead) / fileSize;
-                progressCallback(progress);
-            }
-        }
-
-        // Final progress update
-        if (progressCallback && fileSize > 0) {
-            progressCallback(1.0);
-        }
-
-        return lines;
-    }
+    std::vector<std::string> lines;
+    processLineViews(path, [&lines](std::string_view line) {
+        lines.emplace_back(line);
+    }, progressCallback);
+    return lines;
 }
 
 void TextFileReader::processLineByLine(
     const std::string& path,
     const std::function<void(const std::string&)>& lineProcessor,
     const std::function<void(double)>& progressCallback
+) {
+    // One string is reused for every line, so its capacity is allocated once
+    std::string line;
+    processLineViews(path, [&](std::string_view view) {
+        line.assign(view);
+        lineProcessor(line);
+    }, progressCallback);
+}
+
+void TextFileReader::processLineViews(
+    const std::string& path,
+    const std::function<void(std::string_view)>& lineProcessor,
+    const std::function<void(double)>& progressCallback
 ) {
     // Check if reading from stdin
     if (isStdin(path)) {
-        // Process lines from stdin
-        std::string line;
-
-        while (std::getline(std::cin, line)) {
-            lineProcessor(line);
-
-            // No progress reporting for stdin (unknown size)
-        }
+        // Stdin is read in large blocks and split like a mapped file;
+        // there is no progress reporting for stdin (unknown size)
+        std::unique_ptr<std::istream> input = core::openInputStream("-");
+        core::forEachLine(*input, lineProcessor, true);
 
         // Final progress update
         if (progressCallback) {
             progressCallback(1.0);
         }
-    } else {
-        // Check if file exists
-        if (!std::filesystem::exists(path)) {
-            throw std::runtime_error("File does not exist: " + path);
-        }
-
-        // Get file size for progress reporting
-        size_t fileSize = 0;
-        try {
-            fileSize = std::filesystem::file_size(path);
-        } catch (const std::exception& e) {
-            // Continue without progress reporting
-        }
-
-        // Open file
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open file: " + path);
-        }
-
-        // Process lines
-        std::string line;
-        size_t bytesRead = 0;
+        return;
+    }
 
-        while (std::getline(file, line)) {
-            // Remove carriage return if present (for Windows CRLF handling)
-            if (!line.empty() && line.back() == '\r') {
-                line.pop_back();
-            }
-            lineProcessor(line);
+    // Check if file exists
+    if (!std::filesystem::exists(path)) {
+        throw std::runtime_error("File does not exist: " + path);
+    }
 
-            bytesRead += line.size() + 1; // +1 for newline
+    // Uncompressed files are mapped and split in place, without a copy per line
+    if (core::detectFileCompression(path) == core::Compression::None) {
+        core::MappedText mapped(path);
+        size_t fileSize = mapped.text().size();
+        core::LineRange lines = mapped.lines(true);
+        for (auto it = lines.begin(); it != lines.end(); ++it) {
+            lineProcessor(*it);
 
             // Report progress
             if (progressCallback && fileSize > 0) {
-                double progress = static_cast<double>(bytesRead) / fileSize;
-                progressCallback(progress);
+                progressCallback(static_cast<double>(it.offset()) / fileSize);
             }
         }
 
@@ -156,6 +124,17 @@ void TextFileReader::processLineByLine(
         if (progressCallback && fileSize > 0) {
             progressCallback(1.0);
         }
+        return;
+    }
+
+    // Compressed files are decompressed as a stream
+    size_t fileSize = 0;
+    std::unique_ptr<std::istream> input = openTextInput(path, fileSize);
+    core::forEachLine(*input, lineProcessor, true);
+
+    // Final progress update
+    if (progressCallback) {
+        progressCallback(1.0);
     }
 }
 
@@ -167,13 +146,11 @@ std::string TextFileReader::readFileContent(
     if (isStdin(path)) {
         // Read from stdin
         std::string content;
-        std::string line;
-
-        while (std::getline(std::cin, line)) {
-            content += line + '\n';
-
-            // No progress reporting for stdin (unknown size)
-        }
+        std::unique_ptr<std::istream> input = core::openInputStream("-");
+        core::forEachLine(*input, [&content](std::string_view line) {
+            content.append(line);
+            content += '\n';
+        });
 
         // Final progress update
         if (progressCallback) {
@@ -187,19 +164,10 @@ std::string TextFileReader::readFileContent(
             throw std::runtime_error("File does not exist: " + path);
         }
 
-        // Get file size for progress reporting
-        size_t fileSize = 0;
-        try {
-            fileSize = std::filesystem::file_size(path);
-        } catch (const std::exception& e) {
-            // Continue without progress reporting
-        }
-
         // Open file
-        std::ifstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open file: " + path);
-        }
+        size_t fileSize = 0;
+        std::unique_ptr<std::istream> input = openTextInput(path, fileSize);
+        std::istream& file = *input;
 
         // Read file content
         std::string content;
@@ -254,54 +222,31 @@ void TextFileWriter::writeLines(
     const std::vector<std::string>& lines,
     const std::function<void(double)>& progressCallback
 ) {
-    // Check if writing to stdout
-    if (isStdout(path)) {
-        // Write to stdout
-        size_t totalLines = lines.size();
-        for (size_t i = 0; i < totalLines; ++i) {
-            std::cout << lines[i] << '\n';
-
-            // Report progress
-            if (progressCallback && totalLines > 0) {
-                double progress = static_cast<double>(i + 1) / totalLines;
-                progressCallback(progress);
-            }
-        }
-
-        // Flush stdout
-        std::cout.flush();
-
-        // Final progress update
-        if (progressCallback) {
-            progressCallback(1.0);
-        }
-    } else {
-        // Create directory if it doesn't exist
+    // Create directory if it doesn't exist
+    if (!isStdout(path)) {
         std::filesystem::path filePath(path);
         std::filesystem::create_directories(filePath.parent_path());
+    }
 
-        // Open file
-        std::ofstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open file for writing: " + path);
-        }
+    // Open file or stdout
+    core::OutputWriter output(path);
 
-        // Write lines
-        size_t totalLines = lines.size();
-        for (size_t i = 0; i < totalLines; ++i) {
-            file << lines[i] << '\n';
+    // Write lines
+    size_t totalLines = lines.size();
+    for (size_t i = 0; i < totalLines; ++i) {
+        output.writeLine(lines[i]);
 
-            // Report progress
-            if (progressCallback && totalLines > 0) {
-                double progress = static_cast<double>(i + 1) / totalLines;
-                progressCallback(progress);
-            }
+        // Report progress
+        if (progressCallback && totalLines > 0) {
+            double progress = static_cast<double>(i + 1) / totalLines;
+            progressCallback(progress);
         }
+    }
+    output.close();
 
-        // Final progress update
-        if (progressCallback) {
-            progressCallback(1.0);
-        }
+    // Final progress update
+    if (progressCallback) {
+        progressCallback(1.0);
     }
 }
 
@@ -309,25 +254,16 @@ void TextFileWriter::writeContent(
     const std::string& path,
     const std::string& content
 ) {
-    // Check if writing to stdout
-    if (isStdout(path)) {
-        // Write to stdout
-        std::cout << content;
-        std::cout.flush();
-    } else {
-        // Create directory if it doesn't exist
+    // Create directory if it doesn't exist
+    if (!isStdout(path)) {
         std::filesystem::path filePath(path);
         std::filesystem::create_directories(filePath.parent_path());
-
-        // Open file
-        std::ofstream file(path, std::ios::binary);
-        if (!file) {
-            throw std::runtime_error("Failed to open file for writing: " + path);
-        }
-
-        // Write content
-        file << content;
     }
+
+    // Write content to the file or stdout
+    core::OutputWriter output(path);
+    output.write(content);
+    output.close();
 }
 
 } // namespace io
@@ -7,6 +7,7 @@
 #define SUZUME_IO_FILE_IO_H_
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include <iostream>
@@ -53,6 +54,22 @@ public:
         const std::function<void(double)>& progressCallback = nullptr
     );
 
+    /**
+     * @brief Process a file or stdin line by line, as views
+     *
+     * Uncompressed files are memory-mapped and each line is a view into the
+     * mapping, so no line is copied. Stdin and compressed files are streamed.
+     *
+     * @param path File path or "-" for stdin
+     * @param lineProcessor Function to process each line (the view is only valid during the call)
+     * @param progressCallback Progress callback function
+     */
+    static void processLineViews(
+        const std::string& path,
+        const std::function<void(std::string_view)>& lineProcessor,
+        const std::function<void(double)>& progressCallback = nullptr
+    );
+
     /**
      * @brief Read entire file or stdin content as a string
      *
@@ -5,6 +5,7 @@
 
 #include "suzume_feedmill.h"
 #include "core/normalize.h"
+#include "core/pipeline.h"
 #include "core/pmi.h"
 #include "core/word_extraction.h"
 
@@ -18,6 +19,14 @@ NormalizeResult normalize(
     return core::normalize(inputPath, outputPath, options);
 }
 
+NormalizeResult normalizeFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const NormalizeOptions& options
+) {
+    return core::normalizeFiles(inputPaths, outputPath, options);
+}
+
 PmiResult calculatePmi(
     const std::string& inputPath,
     const std::string& outputPath,
@@ -26,6 +35,31 @@ PmiResult calculatePmi(
     return core::calculatePmi(inputPath, outputPath, options);
 }
 
+PmiResult calculatePmiFiles(
+    const std::vector<std::string>& inputPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    return core::calculatePmiFiles(inputPaths, outputPath, options);
+}
+
+PmiResult calculatePmiFromSnapshots(
+    const std::vector<std::string>& snapshotPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    return core::calculatePmiFromSnapshots(snapshotPaths, outputPath, options);
+}
+
+PmiResult calculatePmiFromPartitions(
+    const std::vector<std::string>& partitionPaths,
+    const std::vector<std::string>& marginalPaths,
+    const std::string& outputPath,
+    const PmiOptions& options
+) {
+    return core::calculatePmiFromPartitions(partitionPaths, marginalPaths, outputPath, options);
+}
+
 WordExtractionResult extractWords(
     const std::string& pmiResultsPath,
     const std::string& originalTextPath,
@@ -34,4 +68,11 @@ WordExtractionResult extractWords(
     return core::extractWords(pmiResultsPath, originalTextPath, options);
 }
 
+PipelineResult runPipeline(
+    const std::string& inputPath,
+    const PipelineOptions& options
+) {
+    return core::runPipeline(inputPath, options);
+}
+
 } // namespace suzume
@@ -2,19 +2,60 @@
  * @file executor.cpp
  * @brief Implementation of parallel execution utilities
  *
- * This file contains a dummy function to ensure the library has at least one
- * global symbol, while the main ParallelExecutor class is implemented as
- * template functions in the header file.
+ * The typed operations are templates in the header; they all go through
+ * parallelFor(), which claims ranges on the shared pool.
  */
 
 #include "parallel/executor.h"
+#include <algorithm>
 
 namespace suzume {
 namespace parallel {
 
-// Dummy function to ensure the library has at least one global symbol
 void ParallelExecutor::initializeExecutor() {
-    // This function does nothing but ensures the library has a global symbol
+    ThreadPool::global();
+}
+
+size_t ParallelExecutor::defaultGrain(size_t count, unsigned int threadCount) {
+    return std::max<size_t>(1, count / (size_t{8} * std::max(1u, threadCount)));
+}
+
+void ParallelExecutor::parallelFor(
+    size_t count,
+    const std::function<void(size_t, size_t)>& body,
+    unsigned int threadCount,
+    size_t grain
+) {
+    if (threadCount == 0) {
+        threadCount = std::thread::hardware_concurrency();
+    }
+    if (grain == 0) {
+        grain = defaultGrain(count, threadCount);
+    }
+    const size_t ranges = (count + grain - 1) / grain;
+    const size_t workers = std::min<size_t>(std::max(1u, threadCount), ranges);
+    if (workers <= 1) {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+
+    // Each task keeps claiming ranges until none are left
+    std::atomic<size_t> next(0);
+    TaskGroup group("parallel_for");
+    for (size_t i = 0; i < workers; ++i) {
+        group.run([&]() {
+            while (!group.failed()) {
+                size_t begin = next.fetch_add(grain);
+                if (begin >= count) {
+                    return;
+                }
+                body(begin, std::min(count, begin + grain));
+            }
+        });
+    }
+    group.wait();
 }
 
 } // namespace parallel
@@ -6,25 +6,48 @@
 #ifndef SUZUME_PARALLEL_EXECUTOR_H_
 #define SUZUME_PARALLEL_EXECUTOR_H_
 
+#include <algorithm>
 #include <vector>
 #include <functional>
 #include <thread>
 #include <mutex>
 #include <atomic>
+#include "parallel/thread_pool.h"
 
 namespace suzume {
 namespace parallel {
 
 /**
  * @brief Parallel executor for batch processing
+ *
+ * All operations run on the shared ThreadPool. Work is split into chunks of
+ * a few items that workers claim one at a time, so uneven items balance
+ * out, and the first exception thrown by any item is rethrown on the
+ * calling thread once the running chunks have finished.
  */
 class ParallelExecutor {
 public:
     /**
-     * @brief Initialize the executor (dummy function to ensure library has a global symbol)
+     * @brief Initialize the executor (starts the shared pool)
      */
     static void initializeExecutor();
 
+    /**
+     * @brief Run a function over index ranges that workers claim dynamically
+     *
+     * @param count Number of indices
+     * @param body Called with [begin, end) ranges covering 0..count once each
+     * @param threadCount Number of threads (0 = auto)
+     * @param grain Indices per claimed range (0 = about 8 ranges per thread)
+     * @throws Any exception thrown by body (the first one)
+     */
+    static void parallelFor(
+        size_t count,
+        const std::function<void(size_t, size_t)>& body,
+        unsigned int threadCount = 0,
+        size_t grain = 0
+    );
+
     /**
      * @brief Parallel map operation
      *
@@ -34,6 +57,7 @@ public:
      * @param mapper Mapping function
      * @param threadCount Number of threads (0 = auto)
      * @return std::vector<R> Result vector
+     * @throws Any exception thrown by mapper
      */
     template<typename T, typename R>
     static std::vector<R> parallelMap(
@@ -58,41 +82,12 @@ public:
             return result;
         }
 
-        // Calculate chunk size
-        size_t chunkSize = input.size() / threadCount;
-        if (chunkSize == 0) chunkSize = 1;
-
-        // Prepare result vector
         std::vector<R> result(input.size());
-
-        // Create threads
-        std::vector<std::thread> threads;
-
-        // Launch threads
-        for (unsigned int i = 0; i < threadCount; ++i) {
-            size_t start = i * chunkSize;
-            size_t end = (i == threadCount - 1) ? input.size() : (i + 1) * chunkSize;
-
-            threads.emplace_back([&, start, end]() {
-                try {
-                    for (size_t j = start; j < end; ++j) {
-                        result[j] = mapper(input[j]);
-                    }
-                } catch (...) {
-                    // Store exception for re-throwing in main thread
-                    // In this simple implementation, we just let the exception
-                    // terminate the thread. For production use, consider
-                    // std::exception_ptr for proper exception propagation.
-                    throw;
-                }
-            });
-        }
-
-        // Wait for all threads to complete
-        for (auto& thread : threads) {
-            thread.join();
-        }
-
+        parallelFor(input.size(), [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                result[j] = mapper(input[j]);
+            }
+        }, threadCount);
         return result;
     }
 
@@ -104,6 +99,7 @@ public:
      * @param processor Processing function
      * @param threadCount Number of threads (0 = auto)
      * @param progressCallback Progress callback function
+     * @throws Any exception thrown by processor
      */
     template<typename T>
     static void parallelForEach(
@@ -132,41 +128,23 @@ public:
             return;
         }
 
-        // Calculate chunk size
-        size_t chunkSize = input.size() / threadCount;
-        if (chunkSize == 0) chunkSize = 1;
-
-        // Create threads
-        std::vector<std::thread> threads;
         std::mutex progressMutex;
         std::atomic<size_t> processedItems(0);
+        parallelFor(input.size(), [&](size_t begin, size_t end) {
+            for (size_t j = begin; j < end; ++j) {
+                processor(input[j]);
 
-        // Launch threads
-        for (unsigned int i = 0; i < threadCount; ++i) {
-            size_t start = i * chunkSize;
-            size_t end = (i == threadCount - 1) ? input.size() : (i + 1) * chunkSize;
-
-            threads.emplace_back([&, start, end]() {
-                for (size_t j = start; j < end; ++j) {
-                    processor(input[j]);
+                // Update processed items count
+                size_t processed = processedItems.fetch_add(1, std::memory_order_relaxed) + 1;
 
-                    // Update processed items count
-                    size_t processed = processedItems.fetch_add(1, std::memory_order_relaxed) + 1;
-
-                    // Report progress
-                    if (progressCallback && (processed % 100 == 0 || processed == input.size())) {
-                        std::lock_guard<std::mutex> lock(progressMutex);
-                        double progress = static_cast<double>(processed) / input.size();
-                        progressCallback(progress);
-                    }
+                // Report progress
+                if (progressCallback && (processed % 100 == 0 || processed == input.size())) {
+                    std::lock_guard<std::mutex> lock(progressMutex);
+                    double progress = static_cast<double>(processed) / input.size();
+                    progressCallback(progress);
                 }
-            });
-        }
-
-        // Wait for all threads to complete
-        for (auto& thread : threads) {
-            thread.join();
-        }
+            }
+        }, threadCount);
 
         // Final progress update
         if (progressCallback) {
@@ -174,16 +152,65 @@ public:
         }
     }
 
+    /**
+     * @brief Parallel reduce over index ranges
+     *
+     * Each claimed range is reduced on its own, then the partial results
+     * are combined in index order, so the result is deterministic for any
+     * associative combine, commutative or not.
+     *
+     * @tparam R Result type
+     * @param count Number of indices
+     * @param identity Identity of combine
+     * @param reduceRange Reduces the indices [begin, end)
+     * @param combine Combines two partial results
+     * @param threadCount Number of threads (0 = auto)
+     * @return R Reduced result
+     * @throws Any exception thrown by reduceRange
+     */
+    template<typename R>
+    static R parallelReduce(
+        size_t count,
+        R identity,
+        std::function<R(size_t, size_t)> reduceRange,
+        std::function<R(R, R)> combine,
+        unsigned int threadCount = 0
+    ) {
+        if (threadCount == 0) {
+            threadCount = std::thread::hardware_concurrency();
+        }
+        if (count == 0) {
+            return identity;
+        }
+
+        const size_t grain = defaultGrain(count, threadCount);
+        const size_t ranges = (count + grain - 1) / grain;
+        std::vector<R> partialResults(ranges, identity);
+        parallelFor(ranges, [&](size_t begin, size_t end) {
+            for (size_t range = begin; range < end; ++range) {
+                size_t first = range * grain;
+                partialResults[range] = reduceRange(first, std::min(count, first + grain));
+            }
+        }, threadCount, 1);
+
+        R result = std::move(identity);
+        for (auto& partialResult : partialResults) {
+            result = combine(std::move(result), std::move(partialResult));
+        }
+        return result;
+    }
+
     /**
      * @brief Parallel reduce operation
      *
      * @tparam T Input type
      * @tparam R Result type
      * @param input Input vector
-     * @param reducer Reduction function
+     * @param reducer Reduction function, also used to combine partial results
      * @param initialValue Initial value
      * @param threadCount Number of threads (0 = auto)
      * @return R Reduced result
+     * @throws Any exception thrown by reducer
      */
     template<typename T, typename R>
     static R parallelReduce(
@@ -208,43 +235,21 @@ public:
             return result;
         }
 
-        // Calculate chunk size
-        size_t chunkSize = input.size() / threadCount;
-        if (chunkSize == 0) chunkSize = 1;
-
-        // Create threads
-        std::vector<std::thread> threads;
-        std::vector<R> partialResults(threadCount, initialValue);
-
-        // Launch threads
-        for (unsigned int i = 0; i < threadCount; ++i) {
-            size_t start = i * chunkSize;
-            size_t end = (i == threadCount - 1) ? input.size() : (i + 1) * chunkSize;
-
-            threads.emplace_back([&, i, start, end]() {
+        return parallelReduce<R>(
+            input.size(), initialValue,
+            [&](size_t begin, size_t end) {
                 R localResult = initialValue;
-
-                for (size_t j = start; j < end; ++j) {
+                for (size_t j = begin; j < end; ++j) {
                     localResult = reducer(localResult, input[j]);
                 }
-
-                partialResults[i] = localResult;
-            });
-        }
-
-        // Wait for all threads to complete
-        for (auto& thread : threads) {
-            thread.join();
-        }
-
-        // Combine partial results
-        R finalResult = initialValue;
-        for (const auto& partialResult : partialResults) {
-            finalResult = reducer(finalResult, partialResult);
-        }
-
-        return finalResult;
+                return localResult;
+            },
+            [&](R finalResult, R partialResult) { return reducer(finalResult, partialResult); },
+            threadCount);
     }
+
+private:
+    static size_t defaultGrain(size_t count, unsigned int threadCount);
 };
 
 } // namespace parallel
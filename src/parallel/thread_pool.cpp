@@ -0,0 +1,201 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Implementation of the work-stealing thread pool
+ */
+
+#include "parallel/thread_pool.h"
+#include "parallel/trace.h"
+#include <algorithm>
+#include <string>
+
+namespace suzume {
+namespace parallel {
+
+namespace {
+
+// Pool and deque of the calling worker thread, if it is one
+thread_local const ThreadPool* currentPool = nullptr;
+thread_local size_t currentQueue = 0;
+
+} // namespace
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    threads = std::max(1u, threads);
+    for (unsigned int i = 0; i < threads; ++i) {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // WebAssembly builds without pthreads cannot start a thread; the pool has
+    // no workers and threads waiting on a group run all of its tasks
+#else
+    for (unsigned int i = 0; i < threads; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+#endif
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+ThreadPool& ThreadPool::global() {
+    static ThreadPool pool(std::thread::hardware_concurrency());
+    return pool;
+}
+
+void ThreadPool::push(TaskPtr task) {
+    // Counted first so a worker never sees a queued task it cannot account for
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        queued_.fetch_add(1);
+    }
+    size_t index = currentPool == this
+        ? currentQueue
+        : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+        queues_[index]->tasks.push_back(std::move(task));
+    }
+    wake_.notify_one();
+}
+
+bool ThreadPool::pop(size_t self, TaskPtr& task) {
+    // Own deque from the back, then the others from the front
+    for (size_t i = 0; i < queues_.size(); ++i) {
+        Queue& queue = *queues_[(self + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.tasks.empty()) {
+            continue;
+        }
+        if (i == 0) {
+            task = std::move(queue.tasks.back());
+            queue.tasks.pop_back();
+        } else {
+            task = std::move(queue.tasks.front());
+            queue.tasks.pop_front();
+        }
+        queued_.fetch_sub(1);
+        return true;
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    currentPool = this;
+    currentQueue = index;
+    setTraceThreadName("worker " + std::to_string(index));
+    while (true) {
+        TaskPtr task;
+        if (pop(index, task)) {
+            // Tasks already run by a waiting thread are dropped here
+            if (!task->claimed.exchange(true)) {
+                task->group->execute(*task);
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        wake_.wait(lock, [&]() { return stopping_ || queued_.load() > 0; });
+        if (stopping_ && queued_.load() == 0) {
+            return;
+        }
+    }
+}
+
+TaskGroup::TaskGroup(ThreadPool& pool)
+    : TaskGroup("task", pool)
+{
+}
+
+TaskGroup::TaskGroup(const char* traceName, ThreadPool& pool)
+    : pool_(pool)
+    , traceName_(traceName)
+{
+}
+
+TaskGroup::~TaskGroup() {
+    waitAll();
+}
+
+void TaskGroup::run(std::function<void()> task) {
+    auto entry = std::make_shared<detail::PoolTask>();
+    entry->function = std::move(task);
+    entry->group = this;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        tasks_.push_back(entry);
+        ++pending_;
+    }
+    pool_.push(std::move(entry));
+}
+
+bool TaskGroup::runPending() {
+    while (true) {
+        TaskPtr task;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (nextPending_ == tasks_.size()) {
+                return false;
+            }
+            task = tasks_[nextPending_++];
+        }
+        if (!task->claimed.exchange(true)) {
+            execute(*task);
+            return true;
+        }
+    }
+}
+
+void TaskGroup::wait() {
+    waitAll();
+    std::exception_ptr failure;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::swap(failure, failure_);
+        failed_.store(false);
+    }
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
+
+void TaskGroup::execute(detail::PoolTask& task) {
+    if (!failed()) {
+        TraceScope span(traceName_);
+        try {
+            task.function();
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (!failure_) {
+                failure_ = std::current_exception();
+            }
+            failed_.store(true);
+        }
+    }
+    // Release captured state before the owner can return from wait()
+    task.function = nullptr;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (--pending_ == 0) {
+        done_.notify_all();
+    }
+}
+
+void TaskGroup::waitAll() {
+    while (runPending()) {
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_.wait(lock, [&]() { return pending_ == 0; });
+    tasks_.clear();
+    nextPending_ = 0;
+}
+
+} // namespace parallel
+} // namespace suzume
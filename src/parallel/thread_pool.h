@@ -0,0 +1,176 @@
+/**
+ * @file thread_pool.h
+ * @brief Persistent work-stealing thread pool
+ */
+
+#ifndef SUZUME_PARALLEL_THREAD_POOL_H_
+#define SUZUME_PARALLEL_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace suzume {
+namespace parallel {
+
+class TaskGroup;
+
+namespace detail {
+
+/// A queued task; claimed once by whichever thread runs it first
+struct PoolTask {
+    std::function<void()> function;
+    TaskGroup* group = nullptr;
+    std::atomic<bool> claimed{false};
+};
+
+} // namespace detail
+
+/**
+ * @brief Persistent pool of worker threads with work stealing
+ *
+ * Every worker owns a deque. Tasks submitted from a worker go to the back
+ * of its own deque and are taken from there (newest first, while their
+ * data is still in cache); tasks submitted from other threads are spread
+ * over the deques. An idle worker steals from the front of the other
+ * deques (oldest first) before going to sleep.
+ *
+ * Tasks are submitted through a TaskGroup, which also collects their
+ * exceptions. Threads waiting on a group run the group's unstarted tasks
+ * themselves, so nested groups never deadlock and a busy pool still makes
+ * progress on the waiting thread. WebAssembly builds without pthreads rely
+ * on that alone: their pools start no workers (size() is 0).
+ */
+class ThreadPool {
+public:
+    /**
+     * @brief Constructor
+     * @param threads Number of worker threads (at least 1)
+     */
+    explicit ThreadPool(unsigned int threads);
+
+    /**
+     * @brief Destructor; finishes the queued tasks and joins the workers
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /**
+     * @brief Get the process-wide pool, with one worker per hardware thread
+     * @return ThreadPool& Shared pool, started on first use
+     */
+    static ThreadPool& global();
+
+    /**
+     * @brief Get the number of worker threads
+     * @return unsigned int Worker count
+     */
+    unsigned int size() const { return static_cast<unsigned int>(workers_.size()); }
+
+private:
+    friend class TaskGroup;
+    using TaskPtr = std::shared_ptr<detail::PoolTask>;
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<TaskPtr> tasks;
+    };
+
+    void push(TaskPtr task);
+    bool pop(size_t self, TaskPtr& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread> workers_;
+    std::mutex sleepMutex_;
+    std::condition_variable wake_;
+    std::atomic<size_t> queued_{0};
+    std::atomic<size_t> nextQueue_{0};
+    bool stopping_ = false;
+};
+
+/**
+ * @brief A set of tasks run on a pool and waited for together
+ *
+ * The first exception thrown by a task is kept and rethrown by wait();
+ * tasks that have not started by then are skipped. The destructor waits
+ * for tasks still running, so tasks may reference locals of the scope that
+ * owns the group.
+ */
+class TaskGroup {
+public:
+    /**
+     * @brief Constructor
+     * @param pool Pool to run the tasks on
+     */
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Constructor for a group whose tasks appear in traces under a name
+     * @param traceName Span name of every task (a string literal)
+     * @param pool Pool to run the tasks on
+     */
+    explicit TaskGroup(const char* traceName, ThreadPool& pool = ThreadPool::global());
+
+    /**
+     * @brief Destructor; waits for the tasks and drops their exceptions
+     */
+    ~TaskGroup();
+
+    TaskGroup(const TaskGroup&) = delete;
+    TaskGroup& operator=(const TaskGroup&) = delete;
+
+    /**
+     * @brief Queue a task
+     * @param task Function to run
+     */
+    void run(std::function<void()> task);
+
+    /**
+     * @brief Run one task of this group that has not started, on the calling thread
+     * @return bool True if a task was run
+     */
+    bool runPending();
+
+    /**
+     * @brief Wait for every task, running unstarted ones on the calling thread
+     * @throws Any exception thrown by a task (the first one)
+     */
+    void wait();
+
+    /**
+     * @brief Check whether a task has thrown, so long tasks can stop early
+     * @return bool True after the first exception
+     */
+    bool failed() const { return failed_.load(std::memory_order_relaxed); }
+
+private:
+    friend class ThreadPool;
+    using TaskPtr = std::shared_ptr<detail::PoolTask>;
+
+    void execute(detail::PoolTask& task);
+    void waitAll();
+
+    ThreadPool& pool_;
+    const char* traceName_;
+    std::mutex mutex_;
+    std::condition_variable done_;
+    std::vector<TaskPtr> tasks_;
+    size_t nextPending_ = 0;
+    size_t pending_ = 0;
+    std::exception_ptr failure_;
+    std::atomic<bool> failed_{false};
+};
+
+} // namespace parallel
+} // namespace suzume
+
+#endif // SUZUME_PARALLEL_THREAD_POOL_H_
@@ -0,0 +1,185 @@
+/**
+ * @file trace.cpp
+ * @brief Implementation of Chrome trace event recording
+ */
+
+#include "parallel/trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace suzume {
+namespace parallel {
+
+namespace detail {
+
+std::atomic<bool> traceActive{false};
+
+} // namespace detail
+
+namespace {
+
+/// Track id of the phases; threads are numbered from 1
+constexpr uint32_t kPhaseTrack = 0;
+
+struct TraceEvent {
+    std::string name;
+    const char* category;
+    int64_t beginNanos;
+    int64_t endNanos;
+    bool phaseTrack;
+};
+
+/// Events of one thread; its own lock is only contended while a trace is written
+struct ThreadTrace {
+    uint32_t id = 0;
+    std::string name;
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+};
+
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::shared_ptr<ThreadTrace>> threads;
+    uint32_t nextId = 1;
+    std::atomic<int64_t> originNanos{0};
+};
+
+TraceRegistry& registry() {
+    static TraceRegistry instance;
+    return instance;
+}
+
+int64_t nanosOf(TraceClock::time_point time) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+// Buffer of the calling thread, registered on first use
+ThreadTrace& threadTrace() {
+    thread_local std::shared_ptr<ThreadTrace> trace;
+    if (!trace) {
+        trace = std::make_shared<ThreadTrace>();
+        TraceRegistry& traces = registry();
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        trace->id = traces.nextId++;
+        traces.threads.push_back(trace);
+    }
+    return *trace;
+}
+
+void writeJsonString(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (unsigned char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if (c < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            out << escaped;
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+void writeThreadName(std::ostream& out, uint32_t tid, const std::string& name, int sortIndex) {
+    out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":";
+    writeJsonString(out, name);
+    out << "}}";
+    out << ",\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+        << ",\"args\":{\"sort_index\":" << sortIndex << "}}";
+}
+
+} // namespace
+
+void startTrace() {
+    TraceRegistry& traces = registry();
+    ThreadTrace& self = threadTrace();
+    {
+        std::lock_guard<std::mutex> lock(traces.mutex);
+        // Buffers only the registry still holds belong to threads that have exited
+        traces.threads.erase(
+            std::remove_if(traces.threads.begin(), traces.threads.end(),
+                           [](const std::shared_ptr<ThreadTrace>& trace) { return trace.use_count() == 1; }),
+            traces.threads.end());
+        for (auto& trace : traces.threads) {
+            std::lock_guard<std::mutex> threadLock(trace->mutex);
+            trace->events.clear();
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(self.mutex);
+        if (self.name.empty()) {
+            self.name = "main";
+        }
+    }
+    traces.originNanos.store(nanosOf(TraceClock::now()));
+    detail::traceActive.store(true);
+}
+
+void stopTrace(const std::string& path) {
+    if (!detail::traceActive.exchange(false)) {
+        throw std::runtime_error("No trace is being recorded");
+    }
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Failed to open trace file: " + path);
+    }
+
+    TraceRegistry& traces = registry();
+    const int64_t origin = traces.originNanos.load();
+    out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"suzume-feedmill\"}}";
+    writeThreadName(out, kPhaseTrack, "phases", 0);
+
+    std::lock_guard<std::mutex> lock(traces.mutex);
+    for (auto& trace : traces.threads) {
+        std::lock_guard<std::mutex> threadLock(trace->mutex);
+        std::string name = trace->name.empty() ? "thread " + std::to_string(trace->id) : trace->name;
+        writeThreadName(out, trace->id, name, static_cast<int>(trace->id));
+
+        for (const TraceEvent& event : trace->events) {
+            int64_t begin = std::max(event.beginNanos, origin) - origin;
+            int64_t duration = std::max<int64_t>(0, event.endNanos - origin - begin);
+            char times[64];
+            std::snprintf(times, sizeof(times), ",\"ts\":%.3f,\"dur\":%.3f",
+                          static_cast<double>(begin) / 1000.0, static_cast<double>(duration) / 1000.0);
+            out << ",\n{\"name\":";
+            writeJsonString(out, event.name);
+            out << ",\"cat\":\"" << event.category << "\",\"ph\":\"X\"" << times
+                << ",\"pid\":1,\"tid\":" << (event.phaseTrack ? kPhaseTrack : trace->id) << "}";
+        }
+        trace->events.clear();
+    }
+    out << "\n]}\n";
+
+    out.flush();
+    if (!out) {
+        throw std::runtime_error("Failed to write trace file: " + path);
+    }
+}
+
+void setTraceThreadName(const std::string& name) {
+    ThreadTrace& self = threadTrace();
+    std::lock_guard<std::mutex> lock(self.mutex);
+    self.name = name;
+}
+
+void traceSpan(const std::string& name, const char* category,
+               TraceClock::time_point begin, TraceClock::time_point end, bool phaseTrack) {
+    if (!tracing()) {
+        return;
+    }
+    ThreadTrace& self = threadTrace();
+    std::lock_guard<std::mutex> lock(self.mutex);
+    self.events.push_back(TraceEvent{name, category, nanosOf(begin), nanosOf(end), phaseTrack});
+}
+
+} // namespace parallel
+} // namespace suzume
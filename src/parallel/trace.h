@@ -0,0 +1,124 @@
+/**
+ * @file trace.h
+ * @brief Chrome trace event recording for phases and worker tasks
+ */
+
+#ifndef SUZUME_PARALLEL_TRACE_H_
+#define SUZUME_PARALLEL_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace suzume {
+namespace parallel {
+
+namespace detail {
+
+/// Set between startTrace() and stopTrace()
+extern std::atomic<bool> traceActive;
+
+} // namespace detail
+
+/// Clock of the trace timestamps
+using TraceClock = std::chrono::steady_clock;
+
+/**
+ * @brief Check whether a trace is being recorded
+ *
+ * A relaxed load, so disabled instrumentation costs one branch.
+ *
+ * @return bool True between startTrace() and stopTrace()
+ */
+inline bool tracing() {
+    return detail::traceActive.load(std::memory_order_relaxed);
+}
+
+/**
+ * @brief Start recording trace events, dropping those of an earlier trace
+ *
+ * Events are kept in memory, one buffer per thread, until stopTrace()
+ * writes them out. Timestamps count from this call.
+ */
+void startTrace();
+
+/**
+ * @brief Stop recording and write the events as a Chrome trace
+ *
+ * The file is the JSON object format of the Trace Event Format
+ * ({"traceEvents": [...]}) that chrome://tracing and ui.perfetto.dev
+ * open: one complete ("X") event per span and thread_name metadata for
+ * the main thread, the pool workers and the phases track.
+ *
+ * @param path Output file path
+ * @throws std::runtime_error If no trace is running or the file cannot be written
+ */
+void stopTrace(const std::string& path);
+
+/**
+ * @brief Name the calling thread in traces ("worker 3"); threads default to "thread N"
+ * @param name Thread name
+ */
+void setTraceThreadName(const std::string& name);
+
+/**
+ * @brief Record a span that has already ended
+ *
+ * Does nothing unless tracing(). Spans that began before startTrace() are
+ * clipped to the start of the trace.
+ *
+ * @param name Span name
+ * @param category Span category ("task", "phase", "operation")
+ * @param begin When the span began
+ * @param end When the span ended
+ * @param phaseTrack Put the span on the shared phases track instead of the calling thread's
+ */
+void traceSpan(const std::string& name, const char* category,
+               TraceClock::time_point begin, TraceClock::time_point end, bool phaseTrack = false);
+
+/**
+ * @brief Records the lifetime of a scope as a span of the calling thread
+ *
+ * Whether to record is decided on construction; a scope opened while
+ * tracing is off records nothing and never reads the clock.
+ */
+class TraceScope {
+public:
+    /**
+     * @brief Constructor
+     * @param name Span name (a string literal; it must outlive the scope)
+     * @param category Span category
+     */
+    explicit TraceScope(const char* name, const char* category = "task")
+        : name_(name)
+        , category_(category)
+        , active_(tracing())
+    {
+        if (active_) {
+            begin_ = TraceClock::now();
+        }
+    }
+
+    /**
+     * @brief Destructor; records the span
+     */
+    ~TraceScope() {
+        if (active_) {
+            traceSpan(name_, category_, begin_, TraceClock::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    bool active_;
+    TraceClock::time_point begin_;
+};
+
+} // namespace parallel
+} // namespace suzume
+
+#endif // SUZUME_PARALLEL_TRACE_H_
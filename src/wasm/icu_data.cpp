@@ -0,0 +1,73 @@
+/**
+ * @file icu_data.cpp
+ * @brief Implementation of runtime-loaded ICU data
+ */
+
+#include "icu_data.h"
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+#ifdef SUZUME_ICU_DATA_FILE
+#include <unicode/udata.h>
+#include <unicode/utypes.h>
+#endif
+
+namespace suzume {
+namespace wasm {
+
+namespace {
+
+std::mutex g_icuDataMutex;
+std::atomic<bool> g_icuDataLoaded{false};
+
+} // namespace
+
+bool usesIcuDataFile() {
+#ifdef SUZUME_ICU_DATA_FILE
+    return true;
+#else
+    return false;
+#endif
+}
+
+void setIcuData(const uint8_t* data, size_t length) {
+#ifdef SUZUME_ICU_DATA_FILE
+    std::lock_guard<std::mutex> lock(g_icuDataMutex);
+    if (g_icuDataLoaded.load(std::memory_order_acquire)) {
+        return;
+    }
+
+    // ICU reads the data in place from now on; it is never freed
+    size_t size = (length + 15) & ~static_cast<size_t>(15);
+    void* copy = std::aligned_alloc(16, size > 0 ? size : 16);
+    if (!copy) {
+        throw std::bad_alloc();
+    }
+    std::memcpy(copy, data, length);
+
+    UErrorCode status = U_ZERO_ERROR;
+    udata_setCommonData(copy, &status);
+    if (U_FAILURE(status)) {
+        std::free(copy);
+        throw std::runtime_error("Invalid ICU data file: " + std::string(u_errorName(status)));
+    }
+    g_icuDataLoaded.store(true, std::memory_order_release);
+#else
+    (void)data;
+    (void)length;
+    throw std::runtime_error("This build embeds its ICU data");
+#endif
+}
+
+void requireIcuData() {
+    if (usesIcuDataFile() && !g_icuDataLoaded.load(std::memory_order_acquire)) {
+        throw std::runtime_error("ICU data is not loaded yet; call loadIcuData() first");
+    }
+}
+
+} // namespace wasm
+} // namespace suzume
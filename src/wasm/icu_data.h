@@ -0,0 +1,45 @@
+/**
+ * @file icu_data.h
+ * @brief ICU data loaded at runtime by WASM_ICU_DATA_FILE builds
+ */
+
+#ifndef SUZUME_WASM_ICU_DATA_H_
+#define SUZUME_WASM_ICU_DATA_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace suzume {
+namespace wasm {
+
+/**
+ * @brief Whether this build fetches its ICU data instead of embedding it
+ * @return bool True in WASM_ICU_DATA_FILE builds
+ */
+bool usesIcuDataFile();
+
+/**
+ * @brief Hand ICU its common data (suzume-feedmill-icu.dat)
+ *
+ * The bytes are copied into memory that stays allocated for the life of the
+ * module, as ICU requires. Only the first call takes effect.
+ *
+ * @param data Data file contents
+ * @param length Data file length
+ * @throws std::runtime_error If ICU rejects the data or the build embeds its data
+ */
+void setIcuData(const uint8_t* data, size_t length);
+
+/**
+ * @brief Fail unless ICU has its data
+ *
+ * Builds that embed ICU data always pass.
+ *
+ * @throws std::runtime_error If the data file has not been loaded yet
+ */
+void requireIcuData();
+
+} // namespace wasm
+} // namespace suzume
+
+#endif // SUZUME_WASM_ICU_DATA_H_
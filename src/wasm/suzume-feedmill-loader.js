@@ -0,0 +1,178 @@
+/**
+ * Loader for the suzume-feedmill WebAssembly module
+ *
+ * Loads suzume-feedmill-simd.js on engines that support WebAssembly SIMD
+ * (128-bit) and the scalar suzume-feedmill.js everywhere else. All builds
+ * have the same API and give the same results; the SIMD build validates
+ * UTF-8 and finds newlines 16 bytes at a time.
+ *
+ * Where threads can run as well (Node.js, or a cross-origin isolated page
+ * served with "Cross-Origin-Opener-Policy: same-origin" and
+ * "Cross-Origin-Embedder-Policy: require-corp"), suzume-feedmill-simd-threads.js
+ * is loaded instead: its workers are a Web Worker pool sharing the module's
+ * memory, and the `threads` option of normalize, calculatePmi and
+ * extractWords takes effect. Other pages run single-threaded.
+ *
+ * Builds made with `build-wasm.sh --icu-data-file` leave the ICU data out of
+ * the modules and fetch suzume-feedmill-icu.dat (normalization data only)
+ * the first time it is needed: `normalize` and `createNormalizeSession`
+ * then return Promises. `await` them to run the same code on every build.
+ *
+ * Node.js:
+ *   const loadSuzumeFeedmill = require("./suzume-feedmill-loader.js");
+ *   const module = await loadSuzumeFeedmill();
+ *
+ * Browser:
+ *   <script src="suzume-feedmill-loader.js"></script>
+ *   const module = await loadSuzumeFeedmill({ baseUrl: "/wasm/" });
+ */
+(function (root, factory) {
+  if (typeof module === "object" && module.exports) {
+    module.exports = factory();
+  } else {
+    root.loadSuzumeFeedmill = factory();
+  }
+})(typeof self !== "undefined" ? self : this, function () {
+  "use strict";
+
+  // Smallest module using SIMD: (func (result v128) i32.const 0 i8x16.splat i8x16.popcnt)
+  const SIMD_PROBE = new Uint8Array([
+    0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1, 8, 0, 65, 0, 253, 15,
+    253, 98, 11,
+  ]);
+
+  /**
+   * Check whether the engine validates WebAssembly SIMD code
+   *
+   * @returns {boolean} True if the SIMD build can run
+   */
+  function supportsSimd() {
+    try {
+      return typeof WebAssembly === "object" && WebAssembly.validate(SIMD_PROBE);
+    } catch (e) {
+      return false;
+    }
+  }
+
+  /**
+   * Check whether the engine can run the threaded build
+   *
+   * Threads need shared WebAssembly memory, which browsers only grant to
+   * cross-origin isolated pages.
+   *
+   * @returns {boolean} True if the threaded build can run
+   */
+  function supportsThreads() {
+    if (typeof SharedArrayBuffer === "undefined" || typeof WebAssembly !== "object") {
+      return false;
+    }
+    const isNode = typeof process === "object" && process.versions && process.versions.node;
+    if (!isNode && self.crossOriginIsolated !== true) {
+      return false;
+    }
+    try {
+      return new WebAssembly.Memory({ initial: 1, maximum: 1, shared: true }).buffer instanceof SharedArrayBuffer;
+    } catch (e) {
+      return false;
+    }
+  }
+
+  function fetchBytes(url) {
+    if (typeof window === "undefined" && typeof require === "function") {
+      return require("fs").promises.readFile(require("path").join(__dirname, url)).then((b) => new Uint8Array(b));
+    }
+    return fetch(url).then((response) => {
+      if (!response.ok) {
+        throw new Error(`Failed to load ${url}: ${response.status}`);
+      }
+      return response.arrayBuffer();
+    }).then((buffer) => new Uint8Array(buffer));
+  }
+
+  /**
+   * Make the functions that normalize load the ICU data file on first use
+   *
+   * @param {object} instance Module built with WASM_ICU_DATA_FILE
+   * @param {string} url Location of suzume-feedmill-icu.dat
+   */
+  function lazyIcuData(instance, url) {
+    let loading = null;
+    instance.loadIcuData = () => {
+      if (!loading) {
+        loading = fetchBytes(url).then((bytes) => {
+          const result = instance.setIcuData(bytes);
+          if (result.error) {
+            throw new Error(result.error);
+          }
+        });
+        // A failed fetch can be retried by the next call
+        loading.catch(() => {
+          loading = null;
+        });
+      }
+      return loading;
+    };
+
+    const normalize = instance.normalize;
+    const createNormalizeSession = instance.createNormalizeSession;
+    instance.normalize = (text, options) => instance.loadIcuData().then(() => normalize(text, options));
+    instance.createNormalizeSession = (options) =>
+      instance.loadIcuData().then(() => createNormalizeSession(options));
+  }
+
+  function loadScript(url) {
+    return new Promise((resolve, reject) => {
+      const script = document.createElement("script");
+      script.src = url;
+      script.onload = resolve;
+      script.onerror = () => reject(new Error(`Failed to load ${url}`));
+      document.head.appendChild(script);
+    });
+  }
+
+  /**
+   * Load the fastest build the engine runs
+   *
+   * @param {object} [options] Loader options
+   * @param {string} [options.baseUrl] Directory of the module files in browsers (default: "")
+   * @param {boolean} [options.simd] Force (true) or forbid (false) the SIMD builds
+   * @param {boolean} [options.threads] Force (true) or forbid (false) the threaded build
+   * @param {object} [options.moduleArgs] Arguments for the Emscripten module factory
+   * @param {boolean} [options.preloadIcuData] Fetch the ICU data file before resolving (data-file builds)
+   * @returns {Promise<object>} Module; its `simd` and `threads` properties tell which build was loaded
+   */
+  function loadSuzumeFeedmill(options = {}) {
+    const simd = options.simd !== undefined ? options.simd : supportsSimd();
+    // The threaded build is also a SIMD build; engines with threads but without
+    // SIMD (Safari before 16.4) run the scalar build single-threaded
+    const threads = simd && (options.threads !== undefined ? options.threads : supportsThreads());
+    const file = threads
+      ? "suzume-feedmill-simd-threads.js"
+      : simd
+        ? "suzume-feedmill-simd.js"
+        : "suzume-feedmill.js";
+
+    let factory;
+    if (typeof window === "undefined" && typeof require === "function") {
+      factory = Promise.resolve(require(require("path").join(__dirname, file)));
+    } else {
+      factory = loadScript((options.baseUrl || "") + file).then(() => self.SuzumeFeedmill);
+    }
+
+    return factory
+      .then((create) => create(options.moduleArgs || {}))
+      .then((instance) => {
+        instance.simd = simd;
+        instance.threads = threads;
+        if (!instance.icuDataFile) {
+          return instance;
+        }
+        lazyIcuData(instance, (options.baseUrl || "") + "suzume-feedmill-icu.dat");
+        return options.preloadIcuData ? instance.loadIcuData().then(() => instance) : instance;
+      });
+  }
+
+  loadSuzumeFeedmill.supportsSimd = supportsSimd;
+  loadSuzumeFeedmill.supportsThreads = supportsThreads;
+  return loadSuzumeFeedmill;
+});
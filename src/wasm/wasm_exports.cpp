@@ -6,6 +6,7 @@
 #include <suzume_feedmill.h>
 #include <emscripten.h>
 #include <string>
+#include "icu_data.h"
 
 // C-style exports for WebAssembly
 extern "C" {
@@ -15,6 +16,7 @@ EMSCRIPTEN_KEEPALIVE
 const char* normalize(const char* inputPath, const char* outputPath) {
     static std::string result;
     try {
+        suzume::wasm::requireIcuData();
         suzume::NormalizeOptions options;
         suzume::NormalizeResult normalizeResult = suzume::normalize(inputPath, outputPath, options);
 
@@ -9,39 +9,153 @@
 #include <vector>
 #include <memory>
 #include <sstream>
-#include <fstream>
 #include "suzume_feedmill.h"
 #include "core/buffer_api.h"
+#include "icu_data.h"
 
 using namespace emscripten;
 
 /**
- * Normalize text using Suzume Feedmill
+ * Progress words the engine updates while a call runs
+ *
+ * The three words (phase, current, total) live in WebAssembly memory and are
+ * stored with atomics. In the threaded build that memory is a
+ * SharedArrayBuffer: post view().buffer and view().byteOffset to another
+ * thread once and it can watch the run with Atomics.load() without any
+ * message or call into the module. Pass the channel as the `progress`
+ * option of normalize, calculatePmi, calculatePmiColumns or extractWords.
  */
-val normalize(const std::string& text, val options) {
-    try {
-        // Create options
-        suzume::NormalizeOptions normOpt;
+class ProgressChannel {
+public:
+    ProgressChannel() = default;
+
+    /**
+     * Uint32Array view of the words: [phase, current, total]
+     */
+    val view() {
+        return val(typed_memory_view(3, words_));
+    }
 
-        // Form option
-        if (options.hasOwnProperty("form")) {
-            std::string form = options["form"].as<std::string>();
-            if (form == "NFC") {
-                normOpt.form = suzume::NormalizationForm::NFC;
-            } else {
-                normOpt.form = suzume::NormalizationForm::NFKC;
-            }
-        }
+    void reset() {
+        suzume::core::updateProgress(words_, 0, 0, 0);
+    }
 
-        // Threads option
-        if (options.hasOwnProperty("threads")) {
-            normOpt.threads = options["threads"].as<uint32_t>();
-        }
+    uint32_t* data() { return words_; }
+
+private:
+    uint32_t words_[3] = {0, 0, 0};
+};
+
+namespace {
+
+// Progress words named by the `progress` option, if any
+uint32_t* progressOf(val options) {
+    if (!options.hasOwnProperty("progress")) {
+        return nullptr;
+    }
+    return options["progress"].as<ProgressChannel*>(allow_raw_pointers())->data();
+}
+
+suzume::NormalizeOptions toNormalizeOptions(val options) {
+    suzume::NormalizeOptions normOpt;
 
-        // Bloom filter false positive rate
-        if (options.hasOwnProperty("bloomFp")) {
-            normOpt.bloomFalsePositiveRate = options["bloomFp"].as<double>();
+    // Form option
+    if (options.hasOwnProperty("form")) {
+        std::string form = options["form"].as<std::string>();
+        if (form == "NFC") {
+            normOpt.form = suzume::NormalizationForm::NFC;
+        } else {
+            normOpt.form = suzume::NormalizationForm::NFKC;
         }
+    }
+
+    // Threads option
+    if (options.hasOwnProperty("threads")) {
+        normOpt.threads = options["threads"].as<uint32_t>();
+    }
+
+    // Bloom filter false positive rate
+    if (options.hasOwnProperty("bloomFp")) {
+        normOpt.bloomFalsePositiveRate = options["bloomFp"].as<double>();
+    }
+
+    return normOpt;
+}
+
+suzume::PmiOptions toPmiOptions(val options) {
+    suzume::PmiOptions pmiOpt;
+
+    // N-gram size
+    if (options.hasOwnProperty("n")) {
+        pmiOpt.n = options["n"].as<uint32_t>();
+    }
+
+    // Top K
+    if (options.hasOwnProperty("topK")) {
+        pmiOpt.topK = options["topK"].as<uint32_t>();
+    }
+
+    // Min frequency
+    if (options.hasOwnProperty("minFreq")) {
+        pmiOpt.minFreq = options["minFreq"].as<uint32_t>();
+    }
+
+    // Threads
+    if (options.hasOwnProperty("threads")) {
+        pmiOpt.threads = options["threads"].as<uint32_t>();
+    }
+
+    return pmiOpt;
+}
+
+// Build a JavaScript array of {ngram, score, frequency} objects from PMI columns
+val pmiColumnsToArray(const suzume::core::PmiColumns& columns) {
+    val results = val::array();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        val item = val::object();
+        item.set("ngram", columns.ngrams.substr(columns.offsets[i], columns.offsets[i + 1] - columns.offsets[i]));
+        item.set("score", columns.scores[i]);
+        item.set("frequency", columns.frequencies[i]);
+        results.call<void>("push", item);
+    }
+    return results;
+}
+
+val pmiResultToObject(val results, const suzume::PmiResult& result) {
+    val returnVal = val::object();
+    returnVal.set("results", results);
+    returnVal.set("grams", result.grams);
+    returnVal.set("distinctNgrams", result.distinctNgrams);
+    returnVal.set("elapsedMs", result.elapsedMs);
+    returnVal.set("mbPerSec", result.mbPerSec);
+    return returnVal;
+}
+
+// Take over a buffer allocated by the buffer API as a string
+std::string takeOutput(uint8_t* outputData, size_t outputLength) {
+    std::string outputText;
+    if (outputData && outputLength > 0) {
+        outputText = std::string(reinterpret_cast<char*>(outputData), outputLength);
+    }
+    delete[] outputData;
+    return outputText;
+}
+
+val errorResult(const std::exception& e) {
+    val returnVal = val::object();
+    returnVal.set("error", e.what());
+    return returnVal;
+}
+
+} // namespace
+
+/**
+ * Normalize text using Suzume Feedmill
+ */
+val normalize(const std::string& text, val options) {
+    try {
+        suzume::wasm::requireIcuData();
+        suzume::NormalizeOptions normOpt = toNormalizeOptions(options);
 
         // Convert input string to buffer
         const uint8_t* inputData = reinterpret_cast<const uint8_t*>(text.c_str());
@@ -57,7 +171,8 @@ val normalize(const std::string& text, val options) {
             inputLength,
             &outputData,
             &outputLength,
-            normOpt
+            normOpt,
+            progressOf(options)
         );
 
         // Convert output buffer to string
@@ -90,87 +205,93 @@ val normalize(const std::string& text, val options) {
  */
 val calculatePmi(const std::string& text, val options) {
     try {
-        // Create options
-        suzume::PmiOptions pmiOpt;
-
-        // N-gram size
-        if (options.hasOwnProperty("n")) {
-            pmiOpt.n = options["n"].as<uint32_t>();
-        }
-
-        // Top K
-        if (options.hasOwnProperty("topK")) {
-            pmiOpt.topK = options["topK"].as<uint32_t>();
-        }
+        suzume::PmiOptions pmiOpt = toPmiOptions(options);
 
-        // Min frequency
-        if (options.hasOwnProperty("minFreq")) {
-            pmiOpt.minFreq = options["minFreq"].as<uint32_t>();
-        }
+        // Use buffer API for PMI calculation; the columns need no parsing
+        suzume::core::PmiColumns columns;
+        auto result = suzume::core::calculatePmiFromBuffer(
+            reinterpret_cast<const uint8_t*>(text.data()),
+            text.size(),
+            columns,
+            pmiOpt,
+            progressOf(options)
+        );
 
-        // Threads
-        if (options.hasOwnProperty("threads")) {
-            pmiOpt.threads = options["threads"].as<uint32_t>();
-        }
+        return pmiResultToObject(pmiColumnsToArray(columns), result);
+    } catch (const std::exception& e) {
+        val returnVal = val::object();
+        returnVal.set("error", e.what());
+        return returnVal;
+    }
+}
 
-        // Convert input string to buffer
-        const uint8_t* inputData = reinterpret_cast<const uint8_t*>(text.c_str());
-        size_t inputLength = text.length();
+/**
+ * PMI results kept in WebAssembly memory as columns
+ *
+ * scores(), frequencies(), ngramOffsets() and ngramBytes() are typed-array
+ * views of the columns, not copies, so large results cross into JavaScript
+ * in four calls instead of one object per row. The n-gram of row i is
+ * ngramBytes() from ngramOffsets()[i] to ngramOffsets()[i + 1]; ngram(i)
+ * decodes one. Views stay valid until delete(), but only until the next
+ * call into the module when the memory can grow.
+ */
+class PmiResults {
+public:
+    PmiResults(suzume::core::PmiColumns&& columns, const suzume::PmiResult& result)
+        : columns_(std::move(columns)), result_(result) {}
+
+    uint32_t length() const { return static_cast<uint32_t>(columns_.size()); }
+    double grams() const { return static_cast<double>(result_.grams); }
+    double distinctNgrams() const { return static_cast<double>(result_.distinctNgrams); }
+    double elapsedMs() const { return static_cast<double>(result_.elapsedMs); }
+    double mbPerSec() const { return result_.mbPerSec; }
+
+    val scores() const {
+        return val(typed_memory_view(columns_.scores.size(), columns_.scores.data()));
+    }
 
-        // Prepare output buffer
-        uint8_t* outputData = nullptr;
-        size_t outputLength = 0;
+    val frequencies() const {
+        return val(typed_memory_view(columns_.frequencies.size(), columns_.frequencies.data()));
+    }
 
-        // Use buffer API for PMI calculation
-        auto result = suzume::core::calculatePmiFromBuffer(
-            inputData,
-            inputLength,
-            &outputData,
-            &outputLength,
-            pmiOpt
-        );
+    val ngramOffsets() const {
+        return val(typed_memory_view(columns_.offsets.size(), columns_.offsets.data()));
+    }
 
-        // Convert output buffer to string
-        std::string outputText;
-        if (outputData && outputLength > 0) {
-            outputText = std::string(reinterpret_cast<char*>(outputData), outputLength);
-            // Free the buffer allocated by calculatePmiFromBuffer
-            free(outputData);
-        }
+    val ngramBytes() const {
+        return val(typed_memory_view(columns_.ngrams.size(),
+                                     reinterpret_cast<const uint8_t*>(columns_.ngrams.data())));
+    }
 
-        // Parse the output to create a JavaScript array of objects
-        std::istringstream resultStream(outputText);
-        std::string line;
-        val results = val::array();
-
-        while (std::getline(resultStream, line)) {
-            std::istringstream lineStream(line);
-            std::string ngram;
-            double score;
-            uint32_t frequency;
-
-            if (lineStream >> ngram >> score >> frequency) {
-                val item = val::object();
-                item.set("ngram", ngram);
-                item.set("score", score);
-                item.set("frequency", frequency);
-                results.call<void>("push", item);
-            }
+    std::string ngram(uint32_t index) const {
+        if (index >= columns_.size()) {
+            return std::string();
         }
+        return columns_.ngrams.substr(columns_.offsets[index], columns_.offsets[index + 1] - columns_.offsets[index]);
+    }
 
-        // Create return object
-        val returnVal = val::object();
-        returnVal.set("results", results);
-        returnVal.set("grams", result.grams);
-        returnVal.set("distinctNgrams", result.distinctNgrams);
-        returnVal.set("elapsedMs", result.elapsedMs);
-        returnVal.set("mbPerSec", result.mbPerSec);
+private:
+    suzume::core::PmiColumns columns_;
+    suzume::PmiResult result_;
+};
 
-        return returnVal;
+/**
+ * Calculate PMI, returning the results as columns in WebAssembly memory
+ */
+val calculatePmiColumns(const std::string& text, val options) {
+    try {
+        suzume::PmiOptions pmiOpt = toPmiOptions(options);
+        suzume::core::PmiColumns columns;
+        auto result = suzume::core::calculatePmiFromBuffer(
+            reinterpret_cast<const uint8_t*>(text.data()),
+            text.size(),
+            columns,
+            pmiOpt,
+            progressOf(options)
+        );
+        return val(PmiResults(std::move(columns), result));
     } catch (const std::exception& e) {
-        val returnVal = val::object();
-        returnVal.set("error", e.what());
-        return returnVal;
+        return errorResult(e);
     }
 }
 
@@ -205,24 +326,15 @@ val extractWords(const std::string& pmiText, const std::string& originalText, va
             extractOpt.threads = options["threads"].as<uint32_t>();
         }
 
-        // For extractWords, we need to use temporary files since there's no buffer API
-        // In WebAssembly, we can use memory paths
-        std::string pmiPath = "/tmp/pmi_results.tsv";
-        std::string textPath = "/tmp/original_text.txt";
-
-        // Write the input data to temporary files
-        {
-            std::ofstream pmiFile(pmiPath);
-            pmiFile << pmiText;
-            pmiFile.close();
-
-            std::ofstream textFile(textPath);
-            textFile << originalText;
-            textFile.close();
-        }
-
-        // Extract words using file paths
-        auto result = suzume::extractWords(pmiPath, textPath, extractOpt);
+        // Extract words straight from the JavaScript strings
+        auto result = suzume::core::extractWordsFromBuffer(
+            reinterpret_cast<const uint8_t*>(pmiText.data()),
+            pmiText.size(),
+            reinterpret_cast<const uint8_t*>(originalText.data()),
+            originalText.size(),
+            extractOpt,
+            progressOf(options)
+        );
 
         // Create return arrays
         val words = val::array();
@@ -261,9 +373,189 @@ val extractWords(const std::string& pmiText, const std::string& originalText, va
     }
 }
 
+/**
+ * Copies each JavaScript chunk into one reused heap buffer
+ *
+ * A chunk has to be copied into WebAssembly memory once to be read at all;
+ * reusing the buffer keeps that to the size of the largest chunk.
+ */
+class ChunkBuffer {
+public:
+    const uint8_t* load(const val& chunk) {
+        size_t length = chunk["length"].as<size_t>();
+        data_.resize(length);
+        val(typed_memory_view(length, data_.data())).call<void>("set", chunk);
+        return data_.data();
+    }
+
+    size_t size() const { return data_.size(); }
+
+private:
+    std::vector<uint8_t> data_;
+};
+
+/**
+ * Normalization of a text fed in chunks, such as those of File.stream()
+ */
+class NormalizeSession {
+public:
+    explicit NormalizeSession(val options)
+        : session_(toNormalizeOptions(options)) {}
+
+    /**
+     * Normalize a Uint8Array chunk; returns the unique lines it completed
+     */
+    val feed(val chunk) {
+        try {
+            suzume::wasm::requireIcuData();
+            const uint8_t* data = chunk_.load(chunk);
+            uint8_t* outputData = nullptr;
+            size_t outputLength = 0;
+            session_.feed(data, chunk_.size(), &outputData, &outputLength);
+
+            val returnVal = val::object();
+            returnVal.set("text", takeOutput(outputData, outputLength));
+            return returnVal;
+        } catch (const std::exception& e) {
+            return errorResult(e);
+        }
+    }
+
+    /**
+     * Normalize the last line; returns it with the statistics of the session
+     */
+    val finish() {
+        try {
+            suzume::wasm::requireIcuData();
+            uint8_t* outputData = nullptr;
+            size_t outputLength = 0;
+            auto result = session_.finish(&outputData, &outputLength);
+
+            val returnVal = val::object();
+            returnVal.set("text", takeOutput(outputData, outputLength));
+            returnVal.set("rows", result.rows);
+            returnVal.set("uniques", result.uniques);
+            returnVal.set("duplicates", result.duplicates);
+            returnVal.set("elapsedMs", result.elapsedMs);
+            returnVal.set("mbPerSec", result.mbPerSec);
+            return returnVal;
+        } catch (const std::exception& e) {
+            return errorResult(e);
+        }
+    }
+
+private:
+    suzume::core::NormalizeSession session_;
+    ChunkBuffer chunk_;
+};
+
+/**
+ * PMI calculation over a text fed in chunks, such as those of File.stream()
+ */
+class PmiSession {
+public:
+    explicit PmiSession(val options)
+        : session_(toPmiOptions(options)) {}
+
+    /**
+     * Count the n-grams of a Uint8Array chunk
+     */
+    val feed(val chunk) {
+        try {
+            const uint8_t* data = chunk_.load(chunk);
+            session_.feed(data, chunk_.size());
+            return val::object();
+        } catch (const std::exception& e) {
+            return errorResult(e);
+        }
+    }
+
+    /**
+     * Score the n-grams of every chunk fed
+     */
+    val finish() {
+        try {
+            suzume::core::PmiColumns columns;
+            auto result = session_.finish(columns);
+            return pmiResultToObject(pmiColumnsToArray(columns), result);
+        } catch (const std::exception& e) {
+            return errorResult(e);
+        }
+    }
+
+    /**
+     * Score the n-grams of every chunk fed into a PmiResults
+     */
+    val finishColumns() {
+        try {
+            suzume::core::PmiColumns columns;
+            auto result = session_.finish(columns);
+            return val(PmiResults(std::move(columns), result));
+        } catch (const std::exception& e) {
+            return errorResult(e);
+        }
+    }
+
+private:
+    suzume::core::PmiSession session_;
+    ChunkBuffer chunk_;
+};
+
+std::unique_ptr<NormalizeSession> createNormalizeSession(val options) {
+    return std::make_unique<NormalizeSession>(options);
+}
+
+std::unique_ptr<PmiSession> createPmiSession(val options) {
+    return std::make_unique<PmiSession>(options);
+}
+
+/**
+ * Hand ICU the contents of suzume-feedmill-icu.dat (WASM_ICU_DATA_FILE builds)
+ */
+val setIcuData(val bytes) {
+    try {
+        ChunkBuffer buffer;
+        const uint8_t* data = buffer.load(bytes);
+        suzume::wasm::setIcuData(data, buffer.size());
+        return val::object();
+    } catch (const std::exception& e) {
+        return errorResult(e);
+    }
+}
+
 // Bind C++ functions to JavaScript
 EMSCRIPTEN_BINDINGS(suzume_feedmill) {
     function("normalize", &normalize);
     function("calculatePmi", &calculatePmi);
     function("extractWords", &extractWords);
+    function("calculatePmiColumns", &calculatePmiColumns);
+    function("setIcuData", &setIcuData);
+
+    class_<ProgressChannel>("ProgressChannel")
+        .constructor<>()
+        .function("view", &ProgressChannel::view)
+        .function("reset", &ProgressChannel::reset);
+    constant("icuDataFile", suzume::wasm::usesIcuDataFile());
+
+    class_<PmiResults>("PmiResults")
+        .property("length", &PmiResults::length)
+        .property("grams", &PmiResults::grams)
+        .property("distinctNgrams", &PmiResults::distinctNgrams)
+        .property("elapsedMs", &PmiResults::elapsedMs)
+        .property("mbPerSec", &PmiResults::mbPerSec)
+        .function("scores", &PmiResults::scores)
+        .function("frequencies", &PmiResults::frequencies)
+        .function("ngramOffsets", &PmiResults::ngramOffsets)
+        .function("ngramBytes", &PmiResults::ngramBytes)
+        .function("ngram", &PmiResults::ngram);
+
+    class_<NormalizeSession>("NormalizeSession")
+        .function("feed", &NormalizeSession::feed)
+        .function("finish", &NormalizeSession::finish);
+    class_<PmiSession>("PmiSession")
+        .function("feed", &PmiSession::feed)
+        .function("finish", &PmiSession::finish)
+        .function("finishColumns", &PmiSession::finishColumns);
+    function("createNormalizeSession", &createNormalizeSession);
+    function("createPmiSession", &createPmiSession);
 }
@@ -373,6 +373,46 @@ TEST_F(OptionsTest, NormalizeWithLengthFilters) {
     freeArgv(argc, argv);
 }
 
+// Test checkpoint options of normalize and pmi
+TEST_F(OptionsTest, CheckpointOptions) {
+    std::vector<std::string> args = {
+        "suzume-feedmill",
+        "normalize",
+        inputTsvPath,
+        outputTsvPath,
+        "--checkpoint", tempDir + "/run.ckpt",
+        "--checkpoint-interval", "64",
+        "--resume"
+    };
+
+    auto [argc, argv] = makeArgv(args);
+
+    suzume::cli::OptionsParser options;
+    EXPECT_EQ(options.parse(argc, argv), 0);
+    const auto& normalizeOptions = options.getNormalizeOptions();
+    EXPECT_EQ(normalizeOptions.checkpointPath, tempDir + "/run.ckpt");
+    EXPECT_EQ(normalizeOptions.checkpointInterval, 64ull * 1024 * 1024);
+    EXPECT_TRUE(normalizeOptions.resume);
+    freeArgv(argc, argv);
+
+    std::vector<std::string> pmiArgs = {
+        "suzume-feedmill",
+        "pmi",
+        inputTxtPath,
+        outputTsvPath,
+        "--checkpoint", tempDir + "/pmi.ckpt"
+    };
+
+    auto [pmiArgc, pmiArgv] = makeArgv(pmiArgs);
+
+    suzume::cli::OptionsParser pmiParser;
+    EXPECT_EQ(pmiParser.parse(pmiArgc, pmiArgv), 0);
+    EXPECT_EQ(pmiParser.getPmiOptions().checkpointPath, tempDir + "/pmi.ckpt");
+    EXPECT_EQ(pmiParser.getPmiOptions().checkpointInterval, 256ull * 1024 * 1024);
+    EXPECT_FALSE(pmiParser.getPmiOptions().resume);
+    freeArgv(pmiArgc, pmiArgv);
+}
+
 // Test normalize with sample option
 TEST_F(OptionsTest, NormalizeWithSample) {
     std::vector<std::string> args = {
@@ -499,3 +539,103 @@ TEST_F(OptionsTest, InvalidOptionValues) {
 
     freeArgv(argc, argv);
 }
+
+// Test serve command parsing
+TEST_F(OptionsTest, ServeCommand) {
+    std::string socketPath = (std::filesystem::path(tempDir) / "feedmill.sock").string();
+    std::vector<std::string> args = {
+        "suzume-feedmill",
+        "serve",
+        "--socket", socketPath,
+        "--max-jobs", "4",
+        "--queue", "8",
+        "--cache-entries", "0"
+    };
+
+    auto [argc, argv] = makeArgv(args);
+
+    suzume::cli::OptionsParser options;
+    int result = options.parse(argc, argv);
+
+    EXPECT_EQ(result, 0);
+    EXPECT_TRUE(options.isServeCommand());
+    EXPECT_EQ(options.getServeOptions().socketPath, socketPath);
+    EXPECT_EQ(options.getServeOptions().maxJobs, 4u);
+    EXPECT_EQ(options.getServeOptions().queueLimit, 8u);
+    EXPECT_EQ(options.getServeOptions().cacheEntries, 0u);
+
+    freeArgv(argc, argv);
+}
+
+// Test batch command parsing
+TEST_F(OptionsTest, BatchCommand) {
+    std::string manifestPath = (std::filesystem::path(tempDir) / "jobs.json").string();
+    std::ofstream(manifestPath) << "[]";
+    std::vector<std::string> args = {
+        "suzume-feedmill",
+        "batch",
+        manifestPath,
+        "--max-jobs", "3",
+        "--cache-entries", "2",
+        "--stats-json"
+    };
+
+    auto [argc, argv] = makeArgv(args);
+
+    suzume::cli::OptionsParser options;
+    int result = options.parse(argc, argv);
+
+    EXPECT_EQ(result, 0);
+    EXPECT_TRUE(options.isBatchCommand());
+    EXPECT_EQ(options.getBatchOptions().manifestPath, manifestPath);
+    EXPECT_EQ(options.getBatchOptions().maxJobs, 3u);
+    EXPECT_EQ(options.getBatchOptions().cacheEntries, 2u);
+    EXPECT_TRUE(options.getBatchOptions().statsJson);
+
+    freeArgv(argc, argv);
+}
+
+// Test that batch jobs left on auto take the threads the batch gives them
+TEST_F(OptionsTest, SetDefaultThreadsKeepsExplicitCounts) {
+    suzume::cli::OptionsParser automatic;
+    automatic.parseJob({"pipeline", inputTxtPath, outputTsvPath});
+    automatic.setDefaultThreads(2);
+    EXPECT_EQ(automatic.getPipelineOptions().normalize.threads, 2u);
+    EXPECT_EQ(automatic.getPipelineOptions().pmi.threads, 2u);
+    EXPECT_EQ(automatic.getPipelineOptions().wordExtraction.threads, 2u);
+
+    suzume::cli::OptionsParser explicitThreads;
+    explicitThreads.parseJob({"pmi", inputTxtPath, outputTsvPath, "--threads", "6"});
+    explicitThreads.setDefaultThreads(2);
+    EXPECT_EQ(explicitThreads.getPmiOptions().threads, 6u);
+}
+
+// Test parsing of jobs sent to the serve daemon
+TEST_F(OptionsTest, ParseJob) {
+    suzume::cli::OptionsParser options;
+    options.parseJob({"pmi", inputTxtPath, outputTsvPath, "--n", "3", "--progress", "tty"});
+
+    EXPECT_TRUE(options.isPmiCommand());
+    EXPECT_EQ(options.getInputPath(), inputTxtPath);
+    EXPECT_EQ(options.getPmiOptions().n, 3u);
+    // Jobs never report progress to the daemon's terminal
+    EXPECT_FALSE(options.getPmiOptions().progressCallback);
+}
+
+TEST_F(OptionsTest, ParseJobRejectsProcessWideAndInvalidArguments) {
+    std::vector<std::vector<std::string>> rejected = {
+        {"normalize", inputTsvPath, outputTsvPath, "--memory-limit", "64"},
+        {"normalize", inputTsvPath, outputTsvPath, "--trace=trace.json"},
+        {"normalize", inputTsvPath, outputTsvPath, "--io-uring"},
+        {"pmi", "-", outputTsvPath},
+        {"--version"},
+        {"serve", "--socket", "other.sock"},
+        {"batch", inputTxtPath},
+        {"normalize", inputTsvPath, outputTsvPath, "--form", "INVALID"},
+        {}
+    };
+    for (const auto& args : rejected) {
+        suzume::cli::OptionsParser options;
+        EXPECT_THROW(options.parseJob(args), std::invalid_argument);
+    }
+}
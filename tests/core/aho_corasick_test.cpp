@@ -0,0 +1,73 @@
+/**
+ * @file aho_corasick_test.cpp
+ * @brief Tests for the Aho-Corasick automaton
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "core/aho_corasick.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that a scan reports exactly the matches of a brute-force search
+TEST(AhoCorasickTest, MatchesBruteForceSearch) {
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> symbol(0, 2);
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text.push_back(static_cast<char>('a' + symbol(rng)));
+    }
+    text += "人工知能と機械学習";
+
+    std::vector<std::string> patterns = {"a", "ab", "bab", "abcabc", "cccc", "知能", "機械学習", "d", "学習"};
+    std::uniform_int_distribution<size_t> start(0, 2990);
+    std::uniform_int_distribution<size_t> length(1, 6);
+    for (int i = 0; i < 40; ++i) {
+        patterns.push_back(text.substr(start(rng), length(rng)));
+    }
+
+    AhoCorasick automaton(patterns);
+    std::vector<std::pair<size_t, size_t>> actual;
+    automaton.scan(text, [&](size_t pattern, size_t position) {
+        actual.emplace_back(pattern, position);
+    });
+
+    std::vector<std::pair<size_t, size_t>> expected;
+    for (size_t p = 0; p < patterns.size(); ++p) {
+        if (automaton.canonical(p) != p) {
+            continue;
+        }
+        for (size_t pos = text.find(patterns[p]); pos != std::string::npos; pos = text.find(patterns[p], pos + 1)) {
+            expected.emplace_back(p, pos);
+        }
+    }
+
+    std::sort(actual.begin(), actual.end());
+    std::sort(expected.begin(), expected.end());
+    EXPECT_EQ(actual, expected);
+}
+
+// Test duplicate and empty patterns and the order of matches
+TEST(AhoCorasickTest, HandlesDuplicatesAndEmptyPatterns) {
+    AhoCorasick automaton(std::vector<std::string>{"he", "", "she", "he", "hers"});
+    EXPECT_EQ(automaton.canonical(3), 0u);
+    EXPECT_EQ(automaton.canonical(2), 2u);
+
+    std::vector<std::pair<size_t, size_t>> matches;
+    automaton.scan("ushers", [&](size_t pattern, size_t position) {
+        matches.emplace_back(pattern, position);
+    });
+    // Ordered by end position, longest first at the same end
+    std::vector<std::pair<size_t, size_t>> expected = {{2, 1}, {0, 2}, {4, 2}};
+    EXPECT_EQ(matches, expected);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,124 @@
+/**
+ * @file approximate_counter_test.cpp
+ * @brief Tests for fixed-memory approximate n-gram counting
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/approximate_counter.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that sketch estimates never undercount and stay within the bound
+TEST(ApproximateCounterTest, SketchBoundsEstimates) {
+    CountMinSketch sketch(1000, 4);
+    EXPECT_EQ(1024u, sketch.width());
+
+    std::mt19937 rng(3);
+    std::unordered_map<uint64_t, uint32_t> exact;
+    for (int i = 0; i < 50000; ++i) {
+        // Skewed keys: small keys are far more frequent
+        uint64_t key = rng() % (1 + rng() % 5000);
+        exact[key]++;
+        sketch.add(key);
+    }
+    EXPECT_EQ(50000u, sketch.total());
+
+    size_t overBound = 0;
+    for (const auto& [key, count] : exact) {
+        uint32_t estimate = sketch.estimate(key);
+        EXPECT_GE(estimate, count);
+        if (estimate > count + sketch.errorBound()) {
+            overBound++;
+        }
+    }
+    EXPECT_LE(overBound, static_cast<size_t>(exact.size() * sketch.delta()) + 1);
+
+    CountMinSketch other(1000, 4);
+    other.add(7, 5);
+    uint32_t before = sketch.estimate(7);
+    sketch.merge(other);
+    EXPECT_GE(sketch.estimate(7), before + 5);
+
+    EXPECT_THROW(CountMinSketch(0, 4), std::invalid_argument);
+    EXPECT_THROW(CountMinSketch(16, 0), std::invalid_argument);
+    EXPECT_THROW(CountMinSketch(16, 17), std::invalid_argument);
+    EXPECT_THROW(sketch.merge(CountMinSketch(16, 4)), std::invalid_argument);
+}
+
+// Test that the heavy-hitter table keeps the most frequent keys
+TEST(ApproximateCounterTest, KeepsHeavyHitters) {
+    HeavyHitterTable table(3);
+    std::unordered_map<uint64_t, uint32_t> counts;
+    // Keys 1-3 are frequent, the rest appear once each interleaved
+    for (int round = 0; round < 50; ++round) {
+        for (uint64_t key = 1; key <= 3; ++key) {
+            table.offer(key, ++counts[key]);
+        }
+        uint64_t rare = 100 + round;
+        table.offer(rare, ++counts[rare]);
+    }
+
+    EXPECT_EQ(3u, table.size());
+    std::unordered_map<uint64_t, uint32_t> kept;
+    table.forEach([&](uint64_t key, uint32_t count) { kept[key] = count; });
+    for (uint64_t key = 1; key <= 3; ++key) {
+        EXPECT_EQ(50u, kept[key]) << key;
+    }
+    EXPECT_EQ(50u, table.minCount());
+
+    HeavyHitterTable none(0);
+    none.offer(1, 10);
+    EXPECT_EQ(0u, none.size());
+}
+
+// Test that approximate PMI finds the exact top n-grams when they fit
+TEST(ApproximateCounterTest, MatchesExactScoresOnSmallInput) {
+    std::string text;
+    for (int i = 0; i < 400; ++i) {
+        text += "東京" + std::to_string(i % 13) + "の天気と大阪 " + std::to_string(i % 5) + "\n";
+    }
+
+    MultiOrderNgramCounter exact(1, 2, 1);
+    exact.addText(text);
+    std::vector<PmiItem> expected = calculatePmiScores(exact.order(2), exact.order(1), 2, 20);
+
+    // Two workers merged, with room for every distinct bigram
+    std::vector<ApproximateNgramCounter> workers;
+    size_t half = text.find('\n', text.size() / 2) + 1;
+    workers.emplace_back(2, 1 << 16, 4, 1000);
+    workers.emplace_back(2, 1 << 16, 4, 1000);
+    workers[0].addText(std::string_view(text).substr(0, half));
+    workers[1].addText(std::string_view(text).substr(half));
+    ApproximateNgramCounter approximate = ApproximateNgramCounter::mergeAll(std::move(workers), 2);
+
+    std::vector<PmiItem> actual = calculatePmiScores(approximate, 2, 20);
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].ngram, actual[i].ngram);
+        EXPECT_EQ(expected[i].frequency, actual[i].frequency);
+        EXPECT_DOUBLE_EQ(expected[i].score, actual[i].score);
+    }
+    EXPECT_EQ(exact.order(2).size(), approximate.heavyHitters().size());
+    EXPECT_GT(approximate.errorBound(), 0u);
+    EXPECT_GT(approximate.errorProbability(), 0.0);
+
+    // Unigram runs are exact
+    ApproximateNgramCounter unigrams(1, 1 << 16, 4, 1000);
+    unigrams.addText(text);
+    EXPECT_EQ(0u, unigrams.errorBound());
+    EXPECT_EQ(exact.order(1).size(), calculatePmiScores(unigrams, 1, 100000).size());
+
+    EXPECT_THROW(ApproximateNgramCounter(4, 16, 4, 10), std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,187 @@
+/**
+ * @file arrow_ipc_test.cpp
+ * @brief Tests for Arrow IPC file output
+ */
+
+#include <gtest/gtest.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "core/arrow_ipc.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+template<typename T>
+T load(const char* p) {
+    T value;
+    std::memcpy(&value, p, sizeof(T));
+    return value;
+}
+
+// Just enough of a FlatBuffers reader to walk the metadata
+const char* deref(const char* p) {
+    return p + load<uint32_t>(p);
+}
+
+const char* field(const char* table, uint16_t id) {
+    const char* vtable = table - load<int32_t>(table);
+    uint16_t vtableSize = load<uint16_t>(vtable);
+    if (sizeof(uint16_t) * (2 + id) >= vtableSize) {
+        return nullptr;
+    }
+    uint16_t offset = load<uint16_t>(vtable + sizeof(uint16_t) * (2 + id));
+    return offset ? table + offset : nullptr;
+}
+
+std::string flatString(const char* p) {
+    return std::string(p + 4, load<uint32_t>(p));
+}
+
+struct Batch {
+    int64_t rows;
+    std::vector<std::string> names;
+    std::vector<double> scores;
+    std::vector<uint32_t> counts;
+};
+
+// Decode a record batch of (utf8, float64, uint32) columns
+Batch readBatch(const std::string& file, int64_t offset, int32_t metadataLength) {
+    const char* message = file.data() + offset;
+    EXPECT_EQ(0xFFFFFFFFu, load<uint32_t>(message));
+    EXPECT_EQ(metadataLength, load<int32_t>(message + 4) + 8);
+    const char* root = deref(message + 8);
+    EXPECT_EQ(3, static_cast<int>(load<uint8_t>(field(root, 1))));
+    const char* header = deref(field(root, 2));
+    const char* body = message + metadataLength;
+
+    Batch batch;
+    batch.rows = load<int64_t>(field(header, 0));
+    const char* buffers = deref(field(header, 2));
+    EXPECT_EQ(7u, load<uint32_t>(buffers));
+    auto buffer = [&](size_t index) {
+        const char* entry = buffers + 4 + index * 16;
+        EXPECT_EQ(0, load<int64_t>(entry) % 8);
+        return std::make_pair(body + load<int64_t>(entry), static_cast<size_t>(load<int64_t>(entry + 8)));
+    };
+
+    auto offsets = buffer(1);
+    auto data = buffer(2);
+    for (int64_t i = 0; i < batch.rows; ++i) {
+        int32_t begin = load<int32_t>(offsets.first + 4 * i);
+        int32_t end = load<int32_t>(offsets.first + 4 * (i + 1));
+        batch.names.emplace_back(data.first + begin, static_cast<size_t>(end - begin));
+        batch.scores.push_back(load<double>(buffer(4).first + 8 * i));
+        batch.counts.push_back(load<uint32_t>(buffer(6).first + 4 * i));
+    }
+    return batch;
+}
+
+} // namespace
+
+// Test that rows land in record batches and the footer with the schema locates them
+TEST(ArrowIpcTest, WritesBatchesAndFooter) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/arrow_ipc.arrow";
+    EXPECT_TRUE(isArrowOutputPath(path));
+    EXPECT_FALSE(isArrowOutputPath("test_data/arrow_ipc.tsv"));
+    {
+        ArrowFileWriter writer(path, {{"ngram", ArrowType::Utf8},
+                                      {"pmi", ArrowType::Float64},
+                                      {"frequency", ArrowType::UInt32}}, 2);
+        const char* names[] = {"東京", "", "abc"};
+        for (uint32_t i = 0; i < 3; ++i) {
+            writer.append(0, std::string_view(names[i]));
+            writer.append(1, 1.0 / (i + 3));
+            writer.append(2, i * 1000000u);
+            writer.endRow();
+        }
+        EXPECT_THROW(writer.append(0, 1.0), std::invalid_argument);
+        writer.close();
+    }
+
+    std::string file = readFile(path);
+    ASSERT_GT(file.size(), 20u);
+    EXPECT_EQ(0, std::memcmp(file.data(), "ARROW1\0\0", 8));
+    EXPECT_EQ("ARROW1", file.substr(file.size() - 6));
+
+    int32_t footerLength = load<int32_t>(file.data() + file.size() - 10);
+    const char* footer = deref(file.data() + file.size() - 10 - footerLength);
+
+    // Schema: three non-nullable columns with their names and types
+    const char* schema = deref(field(footer, 1));
+    const char* fields = deref(field(schema, 1));
+    ASSERT_EQ(3u, load<uint32_t>(fields));
+    const char* types[] = {"\x05", "\x03", "\x02"};
+    const char* expectedNames[] = {"ngram", "pmi", "frequency"};
+    for (size_t i = 0; i < 3; ++i) {
+        const char* column = deref(fields + 4 + 4 * i);
+        EXPECT_EQ(expectedNames[i], flatString(deref(field(column, 0))));
+        EXPECT_EQ(types[i][0], load<char>(field(column, 2)));
+        ASSERT_NE(nullptr, field(column, 5));
+        EXPECT_EQ(0u, load<uint32_t>(deref(field(column, 5))));
+    }
+
+    // Two batches of two and one rows
+    const char* blocks = deref(field(footer, 3));
+    ASSERT_EQ(2u, load<uint32_t>(blocks));
+    std::vector<std::string> names;
+    std::vector<double> scores;
+    std::vector<uint32_t> counts;
+    for (size_t i = 0; i < 2; ++i) {
+        const char* block = blocks + 4 + 24 * i;
+        int64_t offset = load<int64_t>(block);
+        int32_t metadataLength = load<int32_t>(block + 8);
+        EXPECT_EQ(0, offset % 8);
+        EXPECT_EQ(0, metadataLength % 8);
+        Batch batch = readBatch(file, offset, metadataLength);
+        EXPECT_EQ(i == 0 ? 2 : 1, batch.rows);
+        names.insert(names.end(), batch.names.begin(), batch.names.end());
+        scores.insert(scores.end(), batch.scores.begin(), batch.scores.end());
+        counts.insert(counts.end(), batch.counts.begin(), batch.counts.end());
+    }
+    EXPECT_EQ(names, (std::vector<std::string>{"東京", "", "abc"}));
+    EXPECT_EQ(scores, (std::vector<double>{1.0 / 3, 1.0 / 4, 1.0 / 5}));
+    EXPECT_EQ(counts, (std::vector<uint32_t>{0, 1000000, 2000000}));
+}
+
+// Test that PMI results go to Arrow when the output path asks for it
+TEST(ArrowIpcTest, WritesPmiResults) {
+    std::filesystem::create_directories("test_data");
+    const std::string input = "test_data/arrow_pmi_input.txt";
+    const std::string output = "test_data/arrow_pmi_output.arrow";
+    {
+        std::ofstream file(input);
+        for (int i = 0; i < 20; ++i) {
+            file << "東京都に行く\n大阪府に行く\n";
+        }
+    }
+
+    PmiOptions options;
+    options.n = 2;
+    options.minFreq = 1;
+    options.progressFormat = ProgressFormat::NONE;
+    PmiResult result = core::calculatePmi(input, output, options);
+    ASSERT_GT(result.grams, 0u);
+
+    std::string file = readFile(output);
+    EXPECT_EQ(0, std::memcmp(file.data(), "ARROW1\0\0", 8));
+    EXPECT_EQ("ARROW1", file.substr(file.size() - 6));
+    EXPECT_EQ(std::string::npos, file.find("ngram\tpmi"));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,117 @@
+/**
+ * @file async_io_test.cpp
+ * @brief Tests for asynchronous file reads and writes
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+#include "core/async_io.h"
+#include "core/compressed_input.h"
+#include "core/output_writer.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class AsyncIoTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "suzume_async_io_test";
+        std::filesystem::create_directories(dir_);
+        for (int i = 0; i < 20000; ++i) {
+            content_ += "行" + std::to_string(i * 7919 % 100003) + "\n";
+        }
+    }
+
+    void TearDown() override {
+        setIoBackend(IoBackend::Sync);
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::string path(const char* name) const {
+        return (dir_ / name).string();
+    }
+
+    std::string readFile(const std::string& filePath) const {
+        std::ifstream file(filePath, std::ios::binary);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    }
+
+    std::filesystem::path dir_;
+    std::string content_;
+};
+
+// Test that blocks come back in file order with reads in flight or not
+TEST_F(AsyncIoTest, ReaderReturnsBlocksInOrder) {
+    std::string input = path("input.txt");
+    std::ofstream(input, std::ios::binary) << content_;
+
+    for (IoBackend backend : {IoBackend::Sync, IoBackend::IoUring}) {
+        AsyncFileReader reader(input, backend, 4099, 3);
+        EXPECT_EQ(reader.usesIoUring(), backend == IoBackend::IoUring && isIoUringAvailable());
+
+        std::string read;
+        std::string_view block;
+        while (reader.next(block)) {
+            EXPECT_LE(block.size(), 4099u);
+            read.append(block);
+        }
+        EXPECT_EQ(read, content_);
+        EXPECT_FALSE(reader.next(block));
+    }
+
+    std::string empty = path("empty.txt");
+    std::ofstream(empty, std::ios::binary).close();
+    AsyncFileReader emptyReader(empty, IoBackend::IoUring);
+    std::string_view block;
+    EXPECT_FALSE(emptyReader.next(block));
+
+    EXPECT_THROW(AsyncFileReader(path("missing.txt"), IoBackend::IoUring), std::runtime_error);
+}
+
+// Test that blocks written while earlier ones are in flight land at their offsets
+TEST_F(AsyncIoTest, WriterWritesInOrder) {
+    for (IoBackend backend : {IoBackend::Sync, IoBackend::IoUring}) {
+        std::string output = path("output.txt");
+        int fd = ::open(output.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        ASSERT_GE(fd, 0);
+        {
+            AsyncFileWriter writer(fd, output, backend, 1000, 2);
+            EXPECT_EQ(writer.usesIoUring(), backend == IoBackend::IoUring && isIoUringAvailable());
+            for (size_t offset = 0; offset < content_.size(); offset += 777) {
+                writer.write(content_.data() + offset, std::min<size_t>(777, content_.size() - offset));
+            }
+            writer.finish();
+        }
+        ::close(fd);
+        EXPECT_EQ(readFile(output), content_);
+    }
+}
+
+// Test that the selected backend carries input streams and output writers
+TEST_F(AsyncIoTest, BackendCarriesStreamsAndWriters) {
+    setIoBackend(IoBackend::IoUring);
+    EXPECT_EQ(ioBackend(), IoBackend::IoUring);
+
+    std::string output = path("written.txt");
+    {
+        OutputWriter writer(output, 4096);
+        for (size_t offset = 0; offset < content_.size(); offset += 1000) {
+            writer.write(std::string_view(content_).substr(offset, 1000));
+        }
+        writer.close();
+    }
+    EXPECT_EQ(readFile(output), content_);
+
+    std::unique_ptr<std::istream> input = openInputStream(output);
+    std::string read((std::istreambuf_iterator<char>(*input)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(read, content_);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
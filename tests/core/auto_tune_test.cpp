@@ -0,0 +1,105 @@
+/**
+ * @file auto_tune_test.cpp
+ * @brief Tests for input-aware tuning of workers and chunks
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "core/auto_tune.h"
+#include "core/normalize.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+TEST(AutoTuneTest, ParsesCgroupCpuQuota) {
+    EXPECT_EQ(cgroupCpuLimit("200000", "100000"), 2u);
+    EXPECT_EQ(cgroupCpuLimit("150000", "100000"), 2u);
+    EXPECT_EQ(cgroupCpuLimit("50000", "100000"), 1u);
+    EXPECT_EQ(cgroupCpuLimit("max", "100000"), 0u);
+    EXPECT_EQ(cgroupCpuLimit("-1", "100000"), 0u);
+    EXPECT_EQ(cgroupCpuLimit("", ""), 0u);
+    EXPECT_EQ(cgroupCpuLimit("garbage", "100000"), 0u);
+}
+
+TEST(AutoTuneTest, AvailableCpusIsPositive) {
+    EXPECT_GE(availableCpus(), 1u);
+    EXPECT_EQ(resolveThreads(0), availableCpus());
+    EXPECT_EQ(resolveThreads(3), 3u);
+}
+
+TEST(AutoTuneTest, KeepsRequestedThreads) {
+    WorkloadShape shape;
+    shape.inputBytes = 10;
+    shape.minBytesPerThread = 1 << 20;
+    TuningChoice choice = tuneWorkers(5, shape);
+    EXPECT_EQ(choice.threads, 5u);
+    EXPECT_EQ(choice.reason, "requested");
+    EXPECT_EQ(choice.variant, "parallel");
+}
+
+TEST(AutoTuneTest, SmallInputRunsSerially) {
+    WorkloadShape shape;
+    shape.inputBytes = 1000;
+    shape.minBytesPerThread = 1 << 20;
+    TuningChoice choice = tuneWorkers(0, shape);
+    EXPECT_EQ(choice.threads, 1u);
+    EXPECT_EQ(choice.variant, "serial");
+    if (availableCpus() > 1) {
+        EXPECT_EQ(choice.reason, "input size");
+    }
+}
+
+TEST(AutoTuneTest, ItemsLimitWorkers) {
+    WorkloadShape shape;
+    shape.items = 2500;
+    shape.minItemsPerThread = 1000;
+    TuningChoice choice = tuneWorkers(0, shape);
+    EXPECT_LE(choice.threads, 2u);
+    EXPECT_GE(choice.threads, 1u);
+}
+
+TEST(AutoTuneTest, ChunksStayWithinBounds) {
+    WorkloadShape small;
+    small.inputBytes = 100;
+    EXPECT_EQ(tuneWorkers(1, small).chunkBytes, 16u * 1024);
+
+    WorkloadShape large;
+    large.inputBytes = uint64_t{64} << 30;
+    EXPECT_EQ(tuneWorkers(1, large).chunkBytes, 64u * 1024 * 1024);
+
+    WorkloadShape middle;
+    middle.inputBytes = 64u << 20;
+    EXPECT_EQ(tuneWorkers(4, middle).chunkBytes, 4u << 20);
+
+    EXPECT_EQ(tuneWorkers(4, WorkloadShape{}).chunkBytes, 0u);
+}
+
+TEST(AutoTuneTest, OperationsReportTheirChoice) {
+    auto dir = std::filesystem::temp_directory_path() / "suzume_auto_tune_test";
+    std::filesystem::create_directories(dir);
+    std::string input = (dir / "input.txt").string();
+    std::ofstream(input) << "こんにちは 世界\nテスト データ\nこんにちは 世界\n";
+
+    NormalizeResult normalized = core::normalize(input, (dir / "out.txt").string(), NormalizeOptions());
+    EXPECT_EQ(normalized.metrics.tuning.variant, "serial");
+    EXPECT_EQ(normalized.metrics.tuning.threads, 1u);
+    EXPECT_EQ(normalized.metrics.tuning.availableCpus, availableCpus());
+
+    PmiOptions options;
+    options.threads = 2;
+    options.minFreq = 1;
+    PmiResult pmi = core::calculatePmi(input, (dir / "out.tsv").string(), options);
+    EXPECT_EQ(pmi.metrics.tuning.threads, 2u);
+    EXPECT_EQ(pmi.metrics.tuning.reason, "requested");
+    EXPECT_FALSE(pmi.metrics.tuning.variant.empty());
+
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
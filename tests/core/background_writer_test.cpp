@@ -0,0 +1,95 @@
+/**
+ * @file background_writer_test.cpp
+ * @brief Tests for the background writer thread
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "core/background_writer.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that jobs run in submission order, off the submitting thread
+TEST(BackgroundWriterTest, RunsJobsInOrder) {
+    std::vector<int> written;
+    std::thread::id caller = std::this_thread::get_id();
+    std::atomic<bool> offThread(true);
+    {
+        BackgroundWriter writer(2);
+        for (int i = 0; i < 100; ++i) {
+            writer.submit([&written, &offThread, caller, i]() {
+                if (std::this_thread::get_id() == caller) {
+                    offThread = false;
+                }
+                written.push_back(i);
+            });
+        }
+        writer.finish();
+    }
+    ASSERT_EQ(written.size(), 100u);
+    for (int i = 0; i < 100; ++i) {
+        EXPECT_EQ(written[i], i);
+    }
+    EXPECT_TRUE(offThread.load());
+}
+
+// Test that a producer ahead of the writer waits instead of queueing without bound
+TEST(BackgroundWriterTest, BoundsQueuedJobs) {
+    std::atomic<int> started(0);
+    std::atomic<bool> release(false);
+    BackgroundWriter writer(1);
+    writer.submit([&]() {
+        started++;
+        while (!release.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+    writer.submit([&]() { started++; });
+
+    // One job runs and one waits; the third submit must block until the first ends
+    std::atomic<bool> submitted(false);
+    std::thread producer([&]() {
+        writer.submit([&]() { started++; });
+        submitted = true;
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    EXPECT_FALSE(submitted.load());
+
+    release = true;
+    producer.join();
+    writer.finish();
+    EXPECT_EQ(started.load(), 3);
+}
+
+// Test that a failing job stops the writer and its error reaches the producer
+TEST(BackgroundWriterTest, RethrowsJobErrors) {
+    std::atomic<int> ran(0);
+    std::atomic<bool> queued(false);
+    BackgroundWriter writer(4);
+    writer.submit([&queued]() {
+        while (!queued.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        throw std::runtime_error("disk full");
+    });
+    writer.submit([&ran]() { ran++; });
+    queued = true;
+    try {
+        writer.finish();
+        FAIL() << "finish() should rethrow the job's error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "disk full");
+    }
+    EXPECT_EQ(ran.load(), 0);
+    EXPECT_THROW(writer.submit([]() {}), std::runtime_error);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -5,8 +5,15 @@
 
 #include <gtest/gtest.h>
 #include "core/buffer_api.h"
+#include "core/word_extraction.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstring>
+#include <fstream>
+#include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 namespace suzume {
@@ -212,6 +219,246 @@ TEST(BufferApiTest, ProgressReporting) {
   delete[] outputData;
 }
 
+// Test that duplicates are dropped across batches and a last line without newline is kept
+TEST(BufferApiTest, NormalizeBufferDedupsAcrossBatches) {
+  std::string input;
+  for (int round = 0; round < 3; ++round) {
+    for (int i = 0; i < 1500; ++i) {
+      input += "line" + std::to_string(i) + "\n";
+    }
+  }
+  input += "last";
+
+  uint8_t* outputData = nullptr;
+  size_t outputLength = 0;
+  NormalizeOptions options;
+  NormalizeResult result = normalizeBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()),
+    input.size(),
+    &outputData,
+    &outputLength,
+    options
+  );
+
+  EXPECT_EQ(4501, result.rows);
+  EXPECT_EQ(1501, result.uniques);
+  std::string output(reinterpret_cast<char*>(outputData), outputLength);
+  EXPECT_NE(std::string::npos, output.find("last\n"));
+
+  delete[] outputData;
+}
+
+// Test that words extracted from buffers match those extracted from files
+TEST(BufferApiTest, ExtractWordsFromBuffer) {
+  const std::string pmiText =
+    "ngram\tpmi\tfrequency\n"
+    "人工知能\t5.2\t10\n"
+    "機械学習\t4.8\t8\n"
+    "深層学習\t4.5\t7\n"
+    "自然言語\t4.2\t6\n"
+    "人工知\t3.8\t4\n";
+  const std::string originalText =
+    "人工知能と機械学習の研究が進んでいます。\n"
+    "深層学習を用いた自然言語処理技術の開発が行われています。\n"
+    "人工知能研究開発者が集まるカンファレンスが開催されました。\n";
+  {
+    std::ofstream("buffer_api_pmi.tsv") << pmiText;
+    std::ofstream("buffer_api_text.txt") << originalText;
+  }
+
+  WordExtractionOptions options;
+  options.minScore = 0.0;
+  WordExtractionResult fromFiles = core::extractWords("buffer_api_pmi.tsv", "buffer_api_text.txt", options);
+
+  uint32_t progressBuffer[3] = {0, 0, 0};
+  WordExtractionResult fromBuffers = extractWordsFromBuffer(
+    reinterpret_cast<const uint8_t*>(pmiText.data()),
+    pmiText.size(),
+    reinterpret_cast<const uint8_t*>(originalText.data()),
+    originalText.size(),
+    options,
+    progressBuffer
+  );
+
+  EXPECT_FALSE(fromBuffers.words.empty());
+  EXPECT_EQ(fromFiles.words, fromBuffers.words);
+  EXPECT_EQ(fromFiles.scores, fromBuffers.scores);
+  EXPECT_EQ(fromFiles.frequencies, fromBuffers.frequencies);
+  EXPECT_EQ(4, progressBuffer[0]);
+
+  EXPECT_THROW(extractWordsFromBuffer(nullptr, 0,
+                                      reinterpret_cast<const uint8_t*>(originalText.data()),
+                                      originalText.size(), options),
+               std::runtime_error);
+
+  std::remove("buffer_api_pmi.tsv");
+  std::remove("buffer_api_text.txt");
+}
+
+// Test that PMI counted in progress slices gives the results of one pass, watched from another thread
+TEST(BufferApiTest, PmiProgressSlicesMatchOnePass) {
+  std::string input;
+  while (input.size() < 9 * 1024 * 1024) {
+    input += "東京都に行く日" + std::to_string(input.size() % 997) + "\n";
+  }
+
+  PmiOptions options;
+  options.n = 2;
+  options.minFreq = 1;
+  options.topK = 50;
+  uint8_t* outputData = nullptr;
+  size_t outputLength = 0;
+  calculatePmiFromBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), &outputData, &outputLength, options);
+  std::string onePass(reinterpret_cast<char*>(outputData), outputLength);
+  delete[] outputData;
+
+  uint32_t progressBuffer[3] = {0, 0, 0};
+  std::atomic<bool> done{false};
+  uint32_t lastPhase = 0;
+  bool monotonic = true;
+  std::thread watcher([&]() {
+    while (!done.load()) {
+      uint32_t phase = __atomic_load_n(&progressBuffer[0], __ATOMIC_ACQUIRE);
+      monotonic = monotonic && phase >= lastPhase;
+      lastPhase = phase;
+    }
+  });
+  calculatePmiFromBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), &outputData, &outputLength, options, progressBuffer);
+  done = true;
+  watcher.join();
+  std::string sliced(reinterpret_cast<char*>(outputData), outputLength);
+  delete[] outputData;
+
+  EXPECT_EQ(onePass, sliced);
+  EXPECT_TRUE(monotonic);
+  EXPECT_EQ(4u, progressBuffer[0]);
+  EXPECT_EQ(100u, progressBuffer[1]);
+}
+
+// Test that a normalize session fed in chunks split anywhere matches normalizeBuffer
+TEST(BufferApiTest, NormalizeSessionMatchesBuffer) {
+  std::string input;
+  for (int i = 0; i < 3000; ++i) {
+    input += "行 " + std::to_string(i % 1700) + "\n";
+  }
+  input += "最後";
+
+  NormalizeOptions options;
+  uint8_t* outputData = nullptr;
+  size_t outputLength = 0;
+  NormalizeResult expected = normalizeBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), &outputData, &outputLength, options);
+  std::string expectedText(reinterpret_cast<char*>(outputData), outputLength);
+  delete[] outputData;
+
+  for (size_t chunkSize : {1, 7, 4096, 1 << 20}) {
+    NormalizeSession session(options);
+    std::string text;
+    for (size_t offset = 0; offset < input.size(); offset += chunkSize) {
+      size_t length = std::min(chunkSize, input.size() - offset);
+      session.feed(reinterpret_cast<const uint8_t*>(input.data()) + offset, length, &outputData, &outputLength);
+      if (outputData) {
+        text.append(reinterpret_cast<char*>(outputData), outputLength);
+        delete[] outputData;
+      }
+    }
+    NormalizeResult result = session.finish(&outputData, &outputLength);
+    if (outputData) {
+      text.append(reinterpret_cast<char*>(outputData), outputLength);
+      delete[] outputData;
+    }
+
+    EXPECT_EQ(expectedText, text) << chunkSize;
+    EXPECT_EQ(expected.rows, result.rows);
+    EXPECT_EQ(expected.uniques, result.uniques);
+    EXPECT_EQ(expected.duplicates, result.duplicates);
+    EXPECT_THROW(session.finish(&outputData, &outputLength), std::logic_error);
+  }
+}
+
+// Test that a PMI session fed in chunks split anywhere matches calculatePmiFromBuffer
+TEST(BufferApiTest, PmiSessionMatchesBuffer) {
+  std::string input;
+  for (int i = 0; i < 50; ++i) {
+    input += "東京都に行く\n大阪府に行く\n京都府に住む\n";
+  }
+  input += "東京に住む";
+
+  PmiOptions options;
+  options.n = 2;
+  options.minFreq = 1;
+  uint8_t* outputData = nullptr;
+  size_t outputLength = 0;
+  PmiResult expected = calculatePmiFromBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), &outputData, &outputLength, options);
+  std::string expectedText(reinterpret_cast<char*>(outputData), outputLength);
+  delete[] outputData;
+  ASSERT_FALSE(expectedText.empty());
+
+  for (size_t chunkSize : {1, 5, 100, 1 << 20}) {
+    PmiSession session(options);
+    for (size_t offset = 0; offset < input.size(); offset += chunkSize) {
+      session.feed(reinterpret_cast<const uint8_t*>(input.data()) + offset,
+                   std::min(chunkSize, input.size() - offset));
+    }
+    PmiResult result = session.finish(&outputData, &outputLength);
+    std::string text(reinterpret_cast<char*>(outputData), outputLength);
+    delete[] outputData;
+
+    EXPECT_EQ(expectedText, text) << chunkSize;
+    EXPECT_EQ(expected.grams, result.grams);
+    EXPECT_EQ(expected.distinctNgrams, result.distinctNgrams);
+    EXPECT_THROW(session.feed(nullptr, 0), std::logic_error);
+  }
+}
+
+// Test that PMI columns hold the rows of the TSV output
+TEST(BufferApiTest, CalculatePmiIntoColumns) {
+  std::string input;
+  for (int i = 0; i < 20; ++i) {
+    input += "東京都に行く\n大阪府に行く\n京都府に住む\n";
+  }
+
+  PmiOptions options;
+  options.n = 2;
+  options.minFreq = 1;
+  uint8_t* outputData = nullptr;
+  size_t outputLength = 0;
+  calculatePmiFromBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), &outputData, &outputLength, options);
+  std::string tsv(reinterpret_cast<char*>(outputData), outputLength);
+  delete[] outputData;
+
+  PmiColumns columns;
+  PmiResult result = calculatePmiFromBuffer(
+    reinterpret_cast<const uint8_t*>(input.data()), input.size(), columns, options);
+  ASSERT_GT(columns.size(), 2u);
+  EXPECT_EQ(result.distinctNgrams, columns.size());
+  ASSERT_EQ(columns.size() + 1, columns.offsets.size());
+  ASSERT_EQ(columns.size(), columns.frequencies.size());
+  EXPECT_EQ(columns.ngrams.size(), columns.offsets.back());
+
+  std::ostringstream rows;
+  for (size_t i = 0; i < columns.size(); ++i) {
+    EXPECT_LT(columns.offsets[i], columns.offsets[i + 1]);
+    if (i > 0) {
+      EXPECT_GE(columns.scores[i - 1], columns.scores[i]);
+    }
+    rows << columns.ngrams.substr(columns.offsets[i], columns.offsets[i + 1] - columns.offsets[i])
+         << "\t" << columns.scores[i] << "\t" << columns.frequencies[i] << "\n";
+  }
+  EXPECT_EQ(tsv, rows.str());
+
+  PmiSession session(options);
+  session.feed(reinterpret_cast<const uint8_t*>(input.data()), input.size());
+  PmiColumns streamed;
+  session.finish(streamed);
+  EXPECT_EQ(columns.ngrams, streamed.ngrams);
+  EXPECT_EQ(columns.scores, streamed.scores);
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
@@ -0,0 +1,185 @@
+/**
+ * @file checkpoint_test.cpp
+ * @brief Tests for checkpointed normalize and PMI runs and their resumption
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include "core/checkpoint.h"
+#include "core/normalize.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class CheckpointTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "suzume_checkpoint_test";
+        std::filesystem::remove_all(dir_);
+        std::filesystem::create_directories(dir_);
+
+        // Repeated lines, so later segments drop lines first seen in earlier ones
+        std::ostringstream text;
+        for (int i = 0; i < 400; ++i) {
+            text << "行" << (i % 150) << " の テキスト サンプル " << (i % 7) << "\n";
+        }
+        input_ = path("input.txt");
+        std::ofstream(input_) << text.str();
+        text_ = text.str();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::string path(const std::string& name) const {
+        return (dir_ / name).string();
+    }
+
+    static std::string readFile(const std::string& file) {
+        std::ifstream in(file);
+        return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    }
+
+    // Input offset where the given segment (0-based) ends
+    size_t segmentEnd(size_t segment, uint64_t interval) const {
+        size_t end = 0;
+        for (size_t i = 0; i <= segment; ++i) {
+            end = checkpointSegmentEnd(text_, end, interval);
+        }
+        return end;
+    }
+
+    std::filesystem::path dir_;
+    std::string input_;
+    std::string text_;
+};
+
+TEST_F(CheckpointTest, SegmentsEndAtLineBoundaries) {
+    std::string text = "aaaa\nbb\ncccccc\n";
+    EXPECT_EQ(checkpointSegmentEnd(text, 0, 3), 5u);
+    EXPECT_EQ(checkpointSegmentEnd(text, 0, 5), 5u);
+    EXPECT_EQ(checkpointSegmentEnd(text, 0, 6), 8u);
+    EXPECT_EQ(checkpointSegmentEnd(text, 5, 1), 8u);
+    EXPECT_EQ(checkpointSegmentEnd(text, 8, 100), text.size());
+    EXPECT_EQ(checkpointSegmentEnd("no newline", 0, 2), 10u);
+}
+
+TEST_F(CheckpointTest, NormalizeRunMatchesPlainRun) {
+    NormalizeOptions options;
+    options.threads = 1;
+    NormalizeResult plain = core::normalize(input_, path("plain.txt"), options);
+
+    options.checkpointPath = path("run.ckpt");
+    options.checkpointInterval = 500;
+    NormalizeResult checkpointed = core::normalize(input_, path("checkpointed.txt"), options);
+
+    EXPECT_EQ(readFile(path("checkpointed.txt")), readFile(path("plain.txt")));
+    EXPECT_EQ(checkpointed.rows, plain.rows);
+    EXPECT_EQ(checkpointed.uniques, plain.uniques);
+    // A finished run leaves no checkpoint behind
+    EXPECT_FALSE(std::filesystem::exists(options.checkpointPath));
+}
+
+TEST_F(CheckpointTest, NormalizeResumesAfterInterruption) {
+    NormalizeOptions options;
+    options.threads = 1;
+    options.checkpointPath = path("run.ckpt");
+    options.checkpointInterval = 500;
+    core::normalize(input_, path("expected.txt"), options);
+
+    // A directory in place of the third segment's dedup index stops the run
+    // after that segment's lines were written, before it is checkpointed
+    std::string blocker = options.checkpointPath + ".dedup." + std::to_string(segmentEnd(2, 500));
+    std::filesystem::create_directories(blocker + ".tmp");
+    EXPECT_ANY_THROW(core::normalize(input_, path("resumed.txt"), options));
+    ASSERT_TRUE(std::filesystem::exists(options.checkpointPath));
+    std::filesystem::remove_all(blocker + ".tmp");
+
+    options.resume = true;
+    NormalizeResult resumed = core::normalize(input_, path("resumed.txt"), options);
+    EXPECT_EQ(readFile(path("resumed.txt")), readFile(path("expected.txt")));
+    EXPECT_EQ(resumed.rows, 400u);
+    EXPECT_FALSE(std::filesystem::exists(options.checkpointPath));
+}
+
+TEST_F(CheckpointTest, ResumeRejectsOtherSettings) {
+    NormalizeOptions options;
+    options.threads = 1;
+    options.checkpointPath = path("run.ckpt");
+    options.checkpointInterval = 500;
+    std::string blocker = options.checkpointPath + ".dedup." + std::to_string(segmentEnd(1, 500));
+    std::filesystem::create_directories(blocker + ".tmp");
+    EXPECT_ANY_THROW(core::normalize(input_, path("out.txt"), options));
+    std::filesystem::remove_all(blocker + ".tmp");
+
+    options.resume = true;
+    options.minLength = 5;
+    EXPECT_THROW(core::normalize(input_, path("out.txt"), options), std::runtime_error);
+}
+
+TEST_F(CheckpointTest, NormalizeRejectsUnsupportedModes) {
+    NormalizeOptions options;
+    options.checkpointPath = path("run.ckpt");
+    options.externalDedup = true;
+    EXPECT_THROW(core::normalize(input_, path("out.txt"), options), std::invalid_argument);
+
+    options.externalDedup = false;
+    EXPECT_THROW(core::normalize(input_, "-", options), std::invalid_argument);
+}
+
+TEST_F(CheckpointTest, PmiResumesAfterInterruption) {
+    PmiOptions options;
+    options.threads = 1;
+    options.minFreq = 1;
+    options.topK = 50;
+    PmiResult plain = core::calculatePmi(input_, path("plain.tsv"), options);
+
+    options.checkpointPath = path("pmi.ckpt");
+    options.checkpointInterval = 500;
+    PmiResult checkpointed = core::calculatePmi(input_, path("expected.tsv"), options);
+    EXPECT_EQ(checkpointed.distinctNgrams, plain.distinctNgrams);
+    EXPECT_FALSE(std::filesystem::exists(options.checkpointPath));
+
+    // A directory in place of the third segment's snapshot stops counting there
+    std::string blocker = options.checkpointPath + ".2.snap";
+    std::filesystem::create_directories(blocker);
+    EXPECT_ANY_THROW(core::calculatePmi(input_, path("resumed.tsv"), options));
+    ASSERT_TRUE(std::filesystem::exists(options.checkpointPath));
+    std::filesystem::remove_all(blocker);
+
+    options.resume = true;
+    core::calculatePmi(input_, path("resumed.tsv"), options);
+    EXPECT_EQ(readFile(path("resumed.tsv")), readFile(path("expected.tsv")));
+    EXPECT_FALSE(std::filesystem::exists(options.checkpointPath));
+}
+
+TEST_F(CheckpointTest, PmiResumeRejectsOtherOrder) {
+    PmiOptions options;
+    options.threads = 1;
+    options.checkpointPath = path("pmi.ckpt");
+    options.checkpointInterval = 500;
+    std::filesystem::create_directories(options.checkpointPath + ".1.snap");
+    EXPECT_ANY_THROW(core::calculatePmi(input_, path("out.tsv"), options));
+    std::filesystem::remove_all(options.checkpointPath + ".1.snap");
+
+    options.resume = true;
+    options.n = 3;
+    EXPECT_THROW(core::calculatePmi(input_, path("out.tsv"), options), std::runtime_error);
+}
+
+TEST_F(CheckpointTest, PmiRejectsApproximateCounting) {
+    PmiOptions options;
+    options.checkpointPath = path("pmi.ckpt");
+    options.approximate = true;
+    EXPECT_THROW(core::calculatePmi(input_, path("out.tsv"), options), std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,201 @@
+/**
+ * @file compressed_input_test.cpp
+ * @brief Tests for transparent gzip/zstd input decompression
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include "core/compressed_input.h"
+#include "core/pmi.h"
+
+#ifdef SUZUME_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef SUZUME_HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::string makeText(size_t lines, size_t first = 0) {
+    std::string text;
+    for (size_t i = first; i < first + lines; ++i) {
+        text += "compressed line " + std::to_string(i) + "\n";
+    }
+    return text;
+}
+
+std::string readAll(std::istream& input) {
+    return std::string(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+}
+
+std::string decode(const std::string& data, unsigned int threads = 1) {
+    std::istringstream source(data);
+    DecompressingStreamBuf buffer(source, detectCompression(data.data(), data.size()), std::string(), threads);
+    std::istream input(&buffer);
+    input.exceptions(std::ios::badbit);
+    return readAll(input);
+}
+
+void writeFile(const std::string& path, const std::string& data) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+#ifdef SUZUME_HAVE_ZLIB
+std::string gzipCompress(const std::string& text) {
+    z_stream stream{};
+    // 15 window bits + 16: write a gzip header
+    deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, text.size()) + 32, '\0');
+    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(text.data()));
+    stream.avail_in = static_cast<uInt>(text.size());
+    stream.next_out = reinterpret_cast<Bytef*>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+#endif
+
+#ifdef SUZUME_HAVE_ZSTD
+std::string zstdCompress(const std::string& text) {
+    std::string output(ZSTD_compressBound(text.size()), '\0');
+    size_t size = ZSTD_compress(&output[0], output.size(), text.data(), text.size(), 3);
+    output.resize(size);
+    return output;
+}
+#endif
+
+} // namespace
+
+// Test format detection by magic bytes
+TEST(CompressedInputTest, DetectsFormats) {
+    EXPECT_EQ(Compression::Gzip, detectCompression("\x1F\x8B\x08\x00", 4));
+    EXPECT_EQ(Compression::Zstd, detectCompression("\x28\xB5\x2F\xFD", 4));
+    EXPECT_EQ(Compression::None, detectCompression("text", 4));
+    EXPECT_EQ(Compression::None, detectCompression("\x1F", 1));
+    EXPECT_EQ(Compression::None, detectCompression("", 0));
+    EXPECT_STREQ("gzip", compressionName(Compression::Gzip));
+    EXPECT_STREQ("zstd", compressionName(Compression::Zstd));
+    EXPECT_TRUE(isCompressionSupported(Compression::None));
+}
+
+// Test that plain input passes through unchanged
+TEST(CompressedInputTest, PassesPlainInputThrough) {
+    std::string text = makeText(100000);
+    EXPECT_EQ(text, decode(text));
+
+    std::filesystem::create_directories("test_data");
+    writeFile("test_data/compressed_plain.txt", text);
+    EXPECT_EQ(Compression::None, detectFileCompression("test_data/compressed_plain.txt"));
+    auto input = openInputStream("test_data/compressed_plain.txt");
+    EXPECT_EQ(text, readAll(*input));
+
+    EXPECT_THROW(openInputStream("test_data/compressed_missing.txt"), std::runtime_error);
+}
+
+// Test gzip decoding, including concatenated members and truncation
+TEST(CompressedInputTest, DecodesGzip) {
+    if (!isCompressionSupported(Compression::Gzip)) {
+        GTEST_SKIP() << "Built without zlib";
+    }
+#ifdef SUZUME_HAVE_ZLIB
+    std::string first = makeText(200000);
+    std::string second = makeText(1000, 200000);
+    std::string compressed = gzipCompress(first);
+
+    EXPECT_EQ(first, decode(compressed));
+    EXPECT_EQ(first + second, decode(compressed + gzipCompress(second)));
+    EXPECT_THROW(decode(compressed.substr(0, compressed.size() / 2)), std::runtime_error);
+
+    std::string corrupt = compressed;
+    corrupt[corrupt.size() / 2] ^= 0x55;
+    corrupt[corrupt.size() / 2 + 1] ^= 0x55;
+    EXPECT_THROW(decode(corrupt), std::runtime_error);
+
+    std::filesystem::create_directories("test_data");
+    writeFile("test_data/compressed_input.txt.gz", compressed);
+    EXPECT_EQ(Compression::Gzip, detectFileCompression("test_data/compressed_input.txt.gz"));
+    auto input = openInputStream("test_data/compressed_input.txt.gz");
+    EXPECT_EQ(first, readAll(*input));
+#endif
+}
+
+// Test that a compressed PMI input is streamed to the same counts as the plain file
+TEST(CompressedInputTest, PmiStreamsCompressedInput) {
+    if (!isCompressionSupported(Compression::Gzip)) {
+        GTEST_SKIP() << "Built without zlib";
+    }
+#ifdef SUZUME_HAVE_ZLIB
+    std::string text;
+    for (int i = 0; i < 20000; ++i) {
+        text += "東京都" + std::to_string(i % 37) + "の天気\n";
+    }
+    std::filesystem::create_directories("test_data");
+    writeFile("test_data/compressed_pmi.txt", text);
+    writeFile("test_data/compressed_pmi.txt.gz", gzipCompress(text));
+
+    for (unsigned int threads : {1u, 4u}) {
+        PmiOptions options;
+        options.n = 2;
+        options.topK = 50;
+        options.threads = threads;
+        PmiResult plain = core::calculatePmi("test_data/compressed_pmi.txt", "null", options);
+        PmiResult streamed = core::calculatePmi("test_data/compressed_pmi.txt.gz", "null", options);
+        EXPECT_EQ(plain.grams, streamed.grams) << threads << " threads";
+        EXPECT_EQ(plain.distinctNgrams, streamed.distinctNgrams) << threads << " threads";
+    }
+#endif
+}
+
+// Test zstd decoding of multi-frame input, streamed and in parallel
+TEST(CompressedInputTest, DecodesZstdFrames) {
+    if (!isCompressionSupported(Compression::Zstd)) {
+        GTEST_SKIP() << "Built without libzstd";
+    }
+#ifdef SUZUME_HAVE_ZSTD
+    std::string expected;
+    std::string compressed;
+    for (size_t frame = 0; frame < 7; ++frame) {
+        std::string text = makeText(20000, frame * 20000);
+        expected += text;
+        compressed += zstdCompress(text);
+    }
+
+    EXPECT_EQ(expected, decode(compressed, 1));
+    EXPECT_EQ(expected, decode(compressed, 4));
+    EXPECT_THROW(decode(compressed.substr(0, compressed.size() - 10), 1), std::runtime_error);
+    EXPECT_THROW(decode(compressed.substr(0, compressed.size() - 10), 4), std::runtime_error);
+
+    // A streamed frame without a content size falls back to the streaming decoder
+    std::string text = makeText(50000);
+    std::string streamed(ZSTD_compressBound(text.size()), '\0');
+    ZSTD_CCtx* context = ZSTD_createCCtx();
+    ZSTD_inBuffer in = {text.data(), text.size(), 0};
+    ZSTD_outBuffer out = {&streamed[0], streamed.size(), 0};
+    ZSTD_compressStream2(context, &out, &in, ZSTD_e_continue);
+    ZSTD_inBuffer end = {nullptr, 0, 0};
+    while (ZSTD_compressStream2(context, &out, &end, ZSTD_e_end) != 0) {
+    }
+    ZSTD_freeCCtx(context);
+    ASSERT_EQ(ZSTD_CONTENTSIZE_UNKNOWN, ZSTD_getFrameContentSize(streamed.data(), out.pos));
+    streamed.resize(out.pos);
+    EXPECT_EQ(text + expected, decode(streamed + compressed, 4));
+#endif
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,179 @@
+/**
+ * @file cooccurrence_test.cpp
+ * @brief Tests for co-occurrence counting and scoring
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/cooccurrence.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Pair counts of a table, keyed by the two units joined by a space
+std::map<std::string, uint32_t> pairsOf(const CooccurrenceCounter& counts) {
+    std::unordered_map<uint32_t, std::string> names;
+    counts.unitCounts().forEach([&names](uint64_t id, uint32_t) {
+        names.emplace(static_cast<uint32_t>(id), std::string());
+    });
+    counts.unitNames(names);
+    std::map<std::string, uint32_t> pairs;
+    counts.forEachPair([&](uint32_t first, uint32_t second, uint32_t count) {
+        pairs[names[first] + " " + names[second]] += count;
+    });
+    return pairs;
+}
+
+std::string randomTokens(size_t lines) {
+    const std::vector<std::string> words = {"new", "york", "city", "tokyo", "station", "東京", "駅", "の", "近く"};
+    std::mt19937 rng(7);
+    std::string text;
+    for (size_t i = 0; i < lines; ++i) {
+        size_t length = 1 + rng() % 12;
+        for (size_t j = 0; j < length; ++j) {
+            text += (j > 0 ? " " : "") + words[rng() % words.size()];
+        }
+        text += "\n";
+    }
+    return text;
+}
+
+} // namespace
+
+// Test that characters pair with the following window characters on the same line
+TEST(CooccurrenceTest, CountsCharacterPairsWithinWindow) {
+    auto pairs = countCooccurrences("abc d\nab", 2, CooccurrenceUnit::Character);
+    EXPECT_EQ(2u, pairs["a b"]);
+    EXPECT_EQ(1u, pairs["a c"]);
+    EXPECT_EQ(1u, pairs["b c"]);
+    EXPECT_EQ(1u, pairs["b d"]);
+    EXPECT_EQ(1u, pairs["c d"]);
+    // Too far apart, or ordered the other way
+    EXPECT_EQ(0u, pairs.count("a d"));
+    EXPECT_EQ(0u, pairs.count("b a"));
+    // Pairs never cross lines
+    EXPECT_EQ(0u, pairs.count("d a"));
+    EXPECT_EQ(5u, pairs.size());
+}
+
+// Test that tokens are split on spaces and tabs
+TEST(CooccurrenceTest, CountsTokenPairs) {
+    auto pairs = countCooccurrences("new york  city\nnew\tyork\n", 1, CooccurrenceUnit::Token);
+    EXPECT_EQ(2u, pairs["new york"]);
+    EXPECT_EQ(1u, pairs["york city"]);
+    EXPECT_EQ(2u, pairs.size());
+
+    CooccurrenceCounter counts(3, CooccurrenceUnit::Token, 1);
+    counts.addText("a b c d\n");
+    EXPECT_EQ(4u, counts.unitTotal());
+    EXPECT_EQ(6u, counts.pairTotal());
+
+    EXPECT_THROW(CooccurrenceCounter(0, CooccurrenceUnit::Token, 1), std::invalid_argument);
+    EXPECT_THROW(CooccurrenceCounter(CooccurrenceCounter::kMaxWindow + 1, CooccurrenceUnit::Token, 1),
+                 std::invalid_argument);
+}
+
+// Test that tables counted apart merge to the counts of one table over everything
+TEST(CooccurrenceTest, MergedTablesMatchOneTable) {
+    std::string text = randomTokens(2000);
+    for (CooccurrenceUnit unit : {CooccurrenceUnit::Character, CooccurrenceUnit::Token}) {
+        CooccurrenceCounter whole(4, unit, 8);
+        whole.addText(text);
+
+        // Every table sees its own vocabulary in its own order
+        std::vector<CooccurrenceCounter> tables;
+        for (int t = 0; t < 3; ++t) {
+            tables.emplace_back(4, unit, 8);
+        }
+        size_t line = 0;
+        forEachLine(text, [&](std::string_view piece) { tables[line++ % 3].addText(piece); });
+        CooccurrenceCounter merged = CooccurrenceCounter::mergeAll(std::move(tables), 4);
+
+        EXPECT_EQ(whole.unitTotal(), merged.unitTotal());
+        EXPECT_EQ(whole.pairTotal(), merged.pairTotal());
+        EXPECT_EQ(whole.size(), merged.size());
+        EXPECT_EQ(pairsOf(whole), pairsOf(merged));
+    }
+}
+
+// Test that scores follow log2(P(a, b) / (P(a) P(b)))
+TEST(CooccurrenceTest, ScoresPairsAgainstUnitMarginals) {
+    CooccurrenceCounter counts(2, CooccurrenceUnit::Token, 4);
+    counts.addText("new york city\nnew york\nold york city\nnew city\n");
+
+    std::vector<PmiItem> items = calculateCooccurrenceScores(counts, 1, 100);
+    ASSERT_FALSE(items.empty());
+    for (size_t i = 1; i < items.size(); ++i) {
+        EXPECT_GE(items[i - 1].score, items[i].score);
+    }
+
+    // 10 units and 8 pairs; "new york" twice, "new" 3 times, "york" 3 times
+    auto it = std::find_if(items.begin(), items.end(), [](const PmiItem& item) { return item.ngram == "new york"; });
+    ASSERT_NE(items.end(), it);
+    EXPECT_EQ(2u, it->frequency);
+    EXPECT_NEAR(std::log2((2.0 / 8) / ((3.0 / 10) * (3.0 / 10))), it->score, 1e-12);
+
+    // The minimum frequency applies to pairs
+    for (const auto& item : calculateCooccurrenceScores(counts, 2, 100)) {
+        EXPECT_GE(item.frequency, 2u);
+    }
+    EXPECT_EQ(1u, calculateCooccurrenceScores(counts, 1, 1).size());
+}
+
+// Test that calculatePmi in co-occurrence mode gives the same output at any thread count
+TEST(CooccurrenceTest, CalculatePmiWithWindow) {
+    std::filesystem::create_directories("test_data");
+    {
+        std::ofstream input("test_data/cooccurrence_input.txt");
+        input << randomTokens(20000);
+    }
+
+    PmiOptions options;
+    options.window = 3;
+    options.cooccurrenceUnit = CooccurrenceUnit::Token;
+    options.minFreq = 2;
+    options.topK = 50;
+    options.threads = 1;
+    PmiResult serial = core::calculatePmi("test_data/cooccurrence_input.txt", "test_data/cooccurrence_1.tsv", options);
+    options.threads = 4;
+    PmiResult parallel = core::calculatePmi("test_data/cooccurrence_input.txt", "test_data/cooccurrence_4.tsv",
+                                            options);
+
+    EXPECT_GT(serial.grams, 0u);
+    EXPECT_EQ(serial.grams, parallel.grams);
+    EXPECT_EQ(50u, parallel.distinctNgrams);
+    auto read = [](const std::string& path) {
+        std::ifstream file(path);
+        return std::string((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    };
+    std::string output = read("test_data/cooccurrence_1.tsv");
+    EXPECT_EQ(0u, output.find("ngram\tpmi\tfrequency\n"));
+    EXPECT_EQ(output, read("test_data/cooccurrence_4.tsv"));
+
+    // Pairs are counted exactly and written as text only
+    options.approximate = true;
+    EXPECT_THROW(core::calculatePmi("test_data/cooccurrence_input.txt", "null", options), std::invalid_argument);
+    options.approximate = false;
+    options.snapshotPath = "test_data/cooccurrence.snap";
+    EXPECT_THROW(core::calculatePmi("test_data/cooccurrence_input.txt", "null", options), std::invalid_argument);
+    options.snapshotPath.clear();
+    options.window = CooccurrenceCounter::kMaxWindow + 1;
+    EXPECT_THROW(core::calculatePmi("test_data/cooccurrence_input.txt", "null", options), std::invalid_argument);
+
+    std::filesystem::remove_all("test_data");
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,112 @@
+/**
+ * @file count_budget_test.cpp
+ * @brief Tests for the counting memory budget
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include "core/count_budget.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// A few frequent lines on top of a long tail of distinct bigrams
+std::string longTailText() {
+    std::string text;
+    uint32_t state = 12345;
+    for (int i = 0; i < 60000; ++i) {
+        if (i % 4 == 0) {
+            text += "東京都の天気\n";
+            continue;
+        }
+        for (int j = 0; j < 8; ++j) {
+            state = state * 1103515245u + 12345u;
+            uint32_t codePoint = 0x4E00 + (state >> 16) % 6000;
+            text += static_cast<char>(0xE0 | (codePoint >> 12));
+            text += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            text += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        text += '\n';
+    }
+    return text;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// Test that pruning keeps the table within its share and frequent counts within the bound
+TEST(CountBudgetTest, PrunesWithinErrorBound) {
+    const std::string text = longTailText();
+    MultiOrderNgramCounter exact(2, 2, 1);
+    exact.addText(text);
+    ASSERT_GT(exact.memoryUsage(), size_t{256} * 1024);
+
+    CountBudget budget(256 * 1024, 1, MemoryBudgetStrategy::Prune, "");
+    MultiOrderNgramCounter pruned(2, 2, 1);
+    budget.addText(pruned, text);
+
+    EXPECT_EQ(MemoryBudgetStrategy::Prune, budget.used());
+    EXPECT_GT(budget.errorBound(), 0u);
+    EXPECT_LE(pruned.memoryUsage(), budget.share());
+    EXPECT_LT(pruned.size(), exact.size());
+
+    exact.order(2).forEach([&](uint64_t key, uint32_t count) {
+        uint32_t kept = pruned.order(2).count(key);
+        EXPECT_LE(kept, count);
+        EXPECT_LE(count - kept, budget.errorBound());
+    });
+    uint64_t frequent = 0;
+    ASSERT_TRUE(PackedNgramCounter::pack("東京", 2, frequent));
+    EXPECT_GE(pruned.order(2).count(frequent) + budget.errorBound(), 15000u);
+}
+
+// Test that a spilling run scores exactly like an unlimited one and cleans up its runs
+TEST(CountBudgetTest, SpillMatchesUnlimitedRun) {
+    std::filesystem::create_directories("test_data/budget_runs");
+    std::ofstream("test_data/budget_input.txt", std::ios::binary) << longTailText();
+
+    for (unsigned int threads : {1u, 3u}) {
+        PmiOptions options;
+        options.n = 2;
+        options.topK = 200;
+        options.minFreq = 2;
+        options.threads = threads;
+        PmiResult unlimited = core::calculatePmi("test_data/budget_input.txt", "test_data/budget_unlimited.tsv", options);
+        EXPECT_EQ(MemoryBudgetStrategy::None, unlimited.budgetStrategy);
+
+        options.memoryBudget = 256 * 1024;
+        options.budgetStrategy = MemoryBudgetStrategy::Spill;
+        options.tempDir = "test_data/budget_runs";
+        PmiResult spilled = core::calculatePmi("test_data/budget_input.txt", "test_data/budget_spilled.tsv", options);
+        EXPECT_EQ(MemoryBudgetStrategy::Spill, spilled.budgetStrategy);
+        EXPECT_EQ(unlimited.grams, spilled.grams);
+        EXPECT_EQ(readFile("test_data/budget_unlimited.tsv"), readFile("test_data/budget_spilled.tsv"));
+        EXPECT_TRUE(std::filesystem::is_empty("test_data/budget_runs"));
+
+        options.budgetStrategy = MemoryBudgetStrategy::Prune;
+        PmiResult pruned = core::calculatePmi("test_data/budget_input.txt", "null", options);
+        EXPECT_EQ(MemoryBudgetStrategy::Prune, pruned.budgetStrategy);
+        EXPECT_GT(pruned.countErrorBound, 0u);
+    }
+
+    PmiOptions invalid;
+    invalid.memoryBudget = 1024 * 1024;
+    invalid.budgetStrategy = MemoryBudgetStrategy::Spill;
+    invalid.allOrders = true;
+    EXPECT_THROW(core::calculatePmi("test_data/budget_input.txt", "null", invalid), std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,80 @@
+/**
+ * @file counting_map_test.cpp
+ * @brief Tests for the flat counting map
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include "core/counting_map.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test counting with string and string_view keys
+TEST(CountingMapTest, CountsStringKeys) {
+    CountingMap<std::string> counts(16);
+    counts.add(std::string("東京"));
+    counts.add(std::string_view("東京"), 2);
+    counts.add(std::string("a much longer n-gram key"));
+    counts.add(std::string_view("a much longer n-gram key"));
+
+    EXPECT_EQ(2u, counts.size());
+    EXPECT_EQ(3u, counts.get(std::string_view("東京")));
+    EXPECT_EQ(2u, counts.get(std::string("a much longer n-gram key")));
+    EXPECT_EQ(0u, counts.get(std::string_view("大阪")));
+
+    auto copy = counts.toUnorderedMap();
+    EXPECT_EQ(2u, copy.size());
+    EXPECT_EQ(3u, copy["東京"]);
+}
+
+// Test that short keys differing only in length or trailing NULs hash apart
+TEST(CountingMapTest, HashesShortKeys) {
+    Utf8KeyHash hash;
+    EXPECT_NE(hash(std::string_view("a", 1)), hash(std::string_view("a\0", 2)));
+    EXPECT_NE(hash(std::string_view("", 0)), hash(std::string_view("\0", 1)));
+    EXPECT_NE(hash("ab"), hash("ba"));
+    EXPECT_EQ(hash(std::string("東京都の天気")), hash(std::string_view("東京都の天気")));
+
+    CountingMap<std::string> counts;
+    counts.add(std::string("a", 1));
+    counts.add(std::string("a\0", 2));
+    EXPECT_EQ(2u, counts.size());
+}
+
+// Test merging, including reuse of the larger table
+TEST(CountingMapTest, Merges) {
+    CountingMap<uint32_t, uint64_t> small;
+    CountingMap<uint32_t, uint64_t> large;
+    small.add(1u, 5);
+    for (uint32_t key = 0; key < 1000; ++key) {
+        large.add(key);
+    }
+
+    CountingMap<uint32_t, uint64_t> copy = small;
+    copy.merge(large);
+    EXPECT_EQ(1000u, copy.size());
+    EXPECT_EQ(6u, copy.get(1u));
+
+    small.merge(std::move(large));
+    EXPECT_EQ(1000u, small.size());
+    EXPECT_EQ(6u, small.get(1u));
+    EXPECT_EQ(1u, small.get(999u));
+    EXPECT_TRUE(large.empty());
+}
+
+// Test the pre-sizing estimate
+TEST(CountingMapTest, EstimatesDistinctNgrams) {
+    EXPECT_EQ(0u, estimateDistinctNgrams(0, 2));
+    EXPECT_LE(estimateDistinctNgrams(30, 2), 10u);
+    EXPECT_LT(estimateDistinctNgrams(1 << 20, 2), estimateDistinctNgrams(1 << 30, 2));
+    EXPECT_LT(estimateDistinctNgrams(1 << 30, 2), (size_t{1} << 30) / 3 / 10);
+    EXPECT_LE(estimateDistinctNgrams(size_t{1} << 40, 1), 65536u);
+    EXPECT_LE(estimateDistinctNgrams(size_t{1} << 40, 3), 16u * 1024 * 1024);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
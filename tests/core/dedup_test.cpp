@@ -0,0 +1,184 @@
+/**
+ * @file dedup_test.cpp
+ * @brief Tests for Bloom filter and fingerprint based deduplication
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include "core/dedup.h"
+#include "core/text_utils.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that inserted hashes are always reported as possibly present
+TEST(DedupTest, BloomFilterNoFalseNegatives) {
+    BlockedBloomFilter bloom(10000, 0.001);
+    for (uint64_t i = 0; i < 10000; ++i) {
+        bloom.insert(calculateHash("key" + std::to_string(i)));
+    }
+    for (uint64_t i = 0; i < 10000; ++i) {
+        EXPECT_TRUE(bloom.mayContain(calculateHash("key" + std::to_string(i))));
+    }
+}
+
+// Test that the false positive rate roughly follows the configured value
+TEST(DedupTest, BloomFilterFalsePositiveRate) {
+    const size_t count = 20000;
+    BlockedBloomFilter loose(count, 0.05);
+    BlockedBloomFilter tight(count, 0.0001);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t hash = calculateHash("present" + std::to_string(i));
+        loose.insert(hash);
+        tight.insert(hash);
+    }
+
+    size_t looseHits = 0;
+    size_t tightHits = 0;
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t hash = calculateHash("absent" + std::to_string(i));
+        looseHits += loose.mayContain(hash) ? 1 : 0;
+        tightHits += tight.mayContain(hash) ? 1 : 0;
+    }
+
+    EXPECT_LT(static_cast<double>(looseHits) / count, 0.1);
+    EXPECT_LT(static_cast<double>(tightHits) / count, 0.002);
+    EXPECT_LT(loose.memoryUsage(), tight.memoryUsage());
+}
+
+// Test invalid false positive rates
+TEST(DedupTest, BloomFilterInvalidRate) {
+    EXPECT_THROW(BlockedBloomFilter(100, 0.0), std::invalid_argument);
+    EXPECT_THROW(BlockedBloomFilter(100, 1.0), std::invalid_argument);
+}
+
+// Test fingerprint set insertion, lookup and growth
+TEST(DedupTest, FingerprintSet) {
+    FingerprintSet set(4);
+    EXPECT_TRUE(set.insert(0));
+    EXPECT_FALSE(set.insert(0));
+    EXPECT_TRUE(set.contains(0));
+
+    for (uint64_t i = 1; i <= 50000; ++i) {
+        EXPECT_TRUE(set.insert(i * 0x9E3779B97F4A7C15ULL));
+    }
+    EXPECT_EQ(50001u, set.size());
+    EXPECT_TRUE(set.contains(1234 * 0x9E3779B97F4A7C15ULL));
+    EXPECT_FALSE(set.contains(7));
+
+    size_t visited = 0;
+    set.forEach([&visited](uint64_t) { visited++; });
+    EXPECT_EQ(set.size(), visited);
+}
+
+// Test dedup filter semantics match an exact set
+TEST(DedupTest, DedupFilterMatchesExactSet) {
+    DedupFilter filter(0.01);
+    std::unordered_set<std::string> exact;
+
+    size_t filterUniques = 0;
+    size_t exactUniques = 0;
+    for (int i = 0; i < 30000; ++i) {
+        std::string line = "line " + std::to_string(i % 7000);
+        filterUniques += isDuplicate(line, filter) ? 0 : 1;
+        exactUniques += isDuplicate(line, exact, 0.01) ? 0 : 1;
+    }
+
+    EXPECT_EQ(7000u, exactUniques);
+    EXPECT_EQ(exactUniques, filterUniques);
+    EXPECT_EQ(7000u, filter.size());
+    EXPECT_TRUE(isDuplicate("", filter));
+
+    // Fingerprints are far smaller than the strings they replace
+    EXPECT_LT(filter.memoryUsage(), 7000u * 64);
+}
+
+// Test concurrent inserts from several threads
+TEST(DedupTest, ConcurrentDedupFilter) {
+    ConcurrentDedupFilter filter(0.001, 0, 16);
+    EXPECT_EQ(16u, filter.shardCount());
+
+    const int numThreads = 4;
+    const int perThread = 20000;
+    std::atomic<size_t> inserted{0};
+
+    // Every thread inserts the same key range, so each key wins exactly once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < numThreads; ++t) {
+        threads.emplace_back([&filter, &inserted]() {
+            for (int i = 0; i < perThread; ++i) {
+                if (filter.insert("shared key " + std::to_string(i))) {
+                    inserted++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(static_cast<size_t>(perThread), inserted.load());
+    EXPECT_EQ(static_cast<size_t>(perThread), filter.size());
+    EXPECT_TRUE(filter.containsFingerprint(calculateHash("shared key 42")));
+    EXPECT_FALSE(filter.containsFingerprint(calculateHash("missing key")));
+}
+
+// Test saving and loading a dedup index
+TEST(DedupTest, DedupIndexRoundTrip) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/dedup_index_test.idx";
+    std::filesystem::remove(path);
+
+    // A missing index is an empty history
+    ConcurrentDedupFilter empty;
+    EXPECT_EQ(0u, loadDedupIndex(path, empty));
+
+    ConcurrentDedupFilter original(0.001, 0, 8);
+    for (int i = 0; i < 5000; ++i) {
+        original.insert("indexed " + std::to_string(i));
+    }
+    original.insertFingerprint(0);
+    saveDedupIndex(path, original);
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+    ConcurrentDedupFilter loaded;
+    EXPECT_EQ(5001u, loadDedupIndex(path, loaded));
+    EXPECT_EQ(5001u, loaded.size());
+    EXPECT_TRUE(loaded.containsFingerprint(0));
+    EXPECT_FALSE(loaded.insert("indexed 4999"));
+    EXPECT_TRUE(loaded.insert("not indexed"));
+
+    std::filesystem::remove(path);
+}
+
+// Test that corrupt index files are rejected
+TEST(DedupTest, DedupIndexRejectsInvalidFiles) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/dedup_index_invalid.idx";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << "not an index at all";
+    }
+    ConcurrentDedupFilter filter;
+    EXPECT_THROW(loadDedupIndex(path, filter), std::runtime_error);
+
+    // Valid header claiming more fingerprints than the file holds
+    ConcurrentDedupFilter source;
+    source.insert("a");
+    source.insert("b");
+    saveDedupIndex(path, source);
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 4);
+    EXPECT_THROW(loadDedupIndex(path, filter), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
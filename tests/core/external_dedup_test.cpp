@@ -0,0 +1,95 @@
+/**
+ * @file external_dedup_test.cpp
+ * @brief Tests for spill-to-disk deduplication
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
+#include <vector>
+#include "core/external_dedup.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that every duplicate is removed and spill files are cleaned up
+TEST(ExternalDedupTest, RemovesDuplicates) {
+    std::string spillDir;
+    std::ostringstream output;
+    {
+        ExternalDedup dedup("", 1024 * 1024, 0, 0.001);
+        spillDir = dedup.spillDirectory();
+        EXPECT_TRUE(std::filesystem::is_directory(spillDir));
+
+        std::vector<std::string> batch;
+        for (int round = 0; round < 3; ++round) {
+            for (int i = 0; i < 1000; ++i) {
+                batch.push_back("line " + std::to_string(i));
+            }
+            dedup.add(batch);
+            batch.clear();
+        }
+
+        EXPECT_EQ(1000u, dedup.finish(&output));
+    }
+    EXPECT_FALSE(std::filesystem::exists(spillDir));
+
+    std::unordered_set<std::string> seen;
+    std::istringstream lines(output.str());
+    std::string line;
+    while (std::getline(lines, line)) {
+        EXPECT_TRUE(seen.insert(line).second) << "duplicate output: " << line;
+    }
+    EXPECT_EQ(1000u, seen.size());
+    EXPECT_EQ(1u, seen.count("line 999"));
+}
+
+// Test that partitions larger than the budget are split again
+TEST(ExternalDedupTest, SplitsOversizedPartitions) {
+    const int uniqueCount = 120000;
+    ExternalDedup dedup("", 64 * 1024, 0, 0.001);
+
+    // Concurrent producers, each adding every line once
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 2; ++t) {
+        threads.emplace_back([&dedup]() {
+            std::vector<std::string> batch;
+            for (int i = 0; i < uniqueCount; ++i) {
+                batch.push_back("spilled line " + std::to_string(i));
+                if (batch.size() == 500) {
+                    dedup.add(batch);
+                    batch.clear();
+                }
+            }
+            dedup.add(batch);
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    uint64_t firstPass = 0;
+    for (int i = 0; i < uniqueCount; ++i) {
+        firstPass += ("spilled line " + std::to_string(i)).size() + 1;
+    }
+    firstPass *= 2;
+
+    EXPECT_EQ(static_cast<size_t>(uniqueCount), dedup.finish(nullptr));
+
+    // Re-partitioning writes the oversized partitions a second time
+    EXPECT_GT(dedup.spilledBytes(), firstPass);
+}
+
+// Test that a missing temporary directory is reported
+TEST(ExternalDedupTest, MissingTempDir) {
+    EXPECT_THROW(ExternalDedup("test_data/does/not/exist", 1024 * 1024, 0, 0.001), std::runtime_error);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,115 @@
+/**
+ * @file external_sort_test.cpp
+ * @brief Tests for spill-to-disk sort-unique
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <set>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/external_sort.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Lines "key N" for N in [0, count), shuffled deterministically and repeated `copies` times
+std::vector<std::string> makeLines(int count, int copies) {
+    std::vector<std::string> lines;
+    for (int copy = 0; copy < copies; ++copy) {
+        for (int i = 0; i < count; ++i) {
+            lines.push_back("key " + std::to_string((i * 7919) % count));
+        }
+    }
+    return lines;
+}
+
+std::string expectedOutput(const std::vector<std::string>& lines) {
+    std::set<std::string> unique(lines.begin(), lines.end());
+    std::string text;
+    for (const auto& line : unique) {
+        text += line + "\n";
+    }
+    return text;
+}
+
+} // namespace
+
+// Test that the output is sorted by bytes and free of duplicates
+TEST(ExternalSortTest, WritesSortedUniqueLines) {
+    std::string spillDir;
+    std::ostringstream output;
+    {
+        ExternalSort sorter("", 1024 * 1024);
+        spillDir = sorter.spillDirectory();
+        EXPECT_TRUE(std::filesystem::is_directory(spillDir));
+
+        sorter.add({"b", "a", "b", "\xE3\x81\x82", "A"});
+        sorter.add({"a", "c", "A"});
+        EXPECT_EQ(5u, sorter.finish(&output));
+        EXPECT_EQ(0u, sorter.spilledRuns());
+    }
+    EXPECT_EQ("A\na\nb\nc\n\xE3\x81\x82\n", output.str());
+    EXPECT_FALSE(std::filesystem::exists(spillDir));
+}
+
+// Test that spilling runs to disk gives the same output as sorting in memory
+TEST(ExternalSortTest, SpilledRunsMergeToSameOutput) {
+    std::vector<std::string> lines = makeLines(20000, 2);
+
+    std::ostringstream output;
+    ExternalSort sorter("", 64 * 1024);
+    for (size_t start = 0; start < lines.size(); start += 500) {
+        size_t end = std::min(lines.size(), start + 500);
+        sorter.add(std::vector<std::string>(lines.begin() + start, lines.begin() + end));
+    }
+    EXPECT_EQ(20000u, sorter.finish(&output));
+    EXPECT_GT(sorter.spilledRuns(), 1u);
+    EXPECT_GT(sorter.spilledBytes(), 0u);
+    EXPECT_EQ(expectedOutput(lines), output.str());
+}
+
+// Test that batches added from several threads are merged correctly
+TEST(ExternalSortTest, ConcurrentAdd) {
+    std::vector<std::string> lines = makeLines(8000, 3);
+
+    std::ostringstream output;
+    ExternalSort sorter("", 64 * 1024);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < 4; ++t) {
+        workers.emplace_back([&, t]() {
+            for (size_t start = t * 250; start < lines.size(); start += 1000) {
+                size_t end = std::min(lines.size(), start + 250);
+                sorter.add(std::vector<std::string>(lines.begin() + start, lines.begin() + end));
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_EQ(8000u, sorter.finish(&output));
+    EXPECT_EQ(expectedOutput(lines), output.str());
+}
+
+// Test that finish without an output still counts the unique lines
+TEST(ExternalSortTest, CountOnly) {
+    ExternalSort sorter("", 1024 * 1024);
+    sorter.add({"x", "y", "x"});
+    sorter.add({"y", "z"});
+    EXPECT_EQ(3u, sorter.finish(nullptr));
+}
+
+// Test that a missing temporary directory is reported
+TEST(ExternalSortTest, MissingTempDir) {
+    EXPECT_THROW(ExternalSort("/nonexistent/suzume-sort-test", 1024), std::runtime_error);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
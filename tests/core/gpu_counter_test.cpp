@@ -0,0 +1,73 @@
+/**
+ * @file gpu_counter_test.cpp
+ * @brief Tests for exact n-gram counting on a CUDA device
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/gpu_counter.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Expect two counters to hold the same n-grams of every order
+void expectSameCounts(const MultiOrderNgramCounter& expected, const MultiOrderNgramCounter& actual) {
+    ASSERT_EQ(expected.size(), actual.size());
+    for (uint32_t n = expected.minOrder(); n <= expected.maxOrder(); ++n) {
+        expected.order(n).forEach([&](uint64_t key, uint32_t count) {
+            EXPECT_EQ(count, actual.order(n).count(key)) << PackedNgramCounter::decode(key, n);
+        });
+    }
+}
+
+} // namespace
+
+// Test that builds without the CUDA backend, or hosts without a device, refuse GPU counting
+TEST(GpuCounterTest, RefusedWithoutDevice) {
+    if (gpuCountingAvailable()) {
+        GTEST_SKIP() << "A CUDA device is available";
+    }
+    MultiOrderNgramCounter counts(1, 2, 1);
+    EXPECT_THROW(countNgramsOnGpu("東京の天気\n", counts), std::runtime_error);
+    EXPECT_EQ(0u, counts.size());
+}
+
+// Test that device counts equal CPU counts, ill-formed UTF-8 included
+TEST(GpuCounterTest, MatchesCpuCounts) {
+    if (!gpuCountingAvailable()) {
+        GTEST_SKIP() << "No CUDA device";
+    }
+    const std::vector<std::string> words = {"東京", "大阪", "の", "天気", "は", "晴れ", "ab", " ", "😀", "\r"};
+    std::mt19937 rng(5);
+    std::string text;
+    while (text.size() < (3u << 20)) {
+        size_t length = 1 + rng() % 20;
+        for (size_t i = 0; i < length; ++i) {
+            text += words[rng() % words.size()];
+        }
+        text += "\n";
+    }
+
+    MultiOrderNgramCounter expected(1, 3, 1);
+    expected.addText(text);
+    MultiOrderNgramCounter actual(1, 3, 1);
+    countNgramsOnGpu(text, actual);
+    expectSameCounts(expected, actual);
+
+    // Ill-formed sequences decode to U+FFFD as on the CPU
+    const std::string illFormed = "東京\xE6\x9D\n\x80" "ab\xF0\x9F\x98\n大阪\xC0\xAF\n";
+    MultiOrderNgramCounter expectedIllFormed(2, 3, 1);
+    expectedIllFormed.addText(illFormed);
+    MultiOrderNgramCounter actualIllFormed(2, 3, 1);
+    countNgramsOnGpu(illFormed, actualIllFormed);
+    expectSameCounts(expectedIllFormed, actualIllFormed);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
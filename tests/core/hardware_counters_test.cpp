@@ -0,0 +1,111 @@
+/**
+ * @file hardware_counters_test.cpp
+ * @brief Tests for hardware performance counters
+ */
+
+#include <gtest/gtest.h>
+#include <cstdint>
+#include <thread>
+#include "core/hardware_counters.h"
+#include "core/memory_monitor.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Work the compiler cannot drop
+uint64_t busyWork(uint64_t iterations) {
+    volatile uint64_t sum = 0;
+    for (uint64_t i = 0; i < iterations; ++i) {
+        sum = sum + (i ^ (i >> 3));
+    }
+    return sum;
+}
+
+// Turns the process-wide setting on for one test
+class ScopedHardwareCounters {
+public:
+    ScopedHardwareCounters() { setHardwareCounters(true); }
+    ~ScopedHardwareCounters() { setHardwareCounters(false); }
+};
+
+} // namespace
+
+// Test that differences and ratios are derived from two readings
+TEST(HardwareCountersTest, BetweenDerivesRatios) {
+    HardwareCounters begin;
+    begin.available = true;
+    begin.cycles = 100;
+    begin.instructions = 50;
+    HardwareCounters end = begin;
+    end.cycles = 1100;
+    end.instructions = 2050;
+    end.cacheReferences = 200;
+    end.cacheMisses = 50;
+    end.branches = 400;
+    end.branchMisses = 4;
+
+    HardwareCounters counters = hardwareCountersBetween(begin, end);
+    EXPECT_TRUE(counters.available);
+    EXPECT_EQ(counters.cycles, 1000u);
+    EXPECT_EQ(counters.instructions, 2000u);
+    EXPECT_DOUBLE_EQ(counters.ipc, 2.0);
+    EXPECT_DOUBLE_EQ(counters.cacheMissRate, 0.25);
+    EXPECT_DOUBLE_EQ(counters.branchMissRate, 0.01);
+
+    // A reading without counters gives nothing
+    begin.available = false;
+    EXPECT_FALSE(hardwareCountersBetween(begin, end).available);
+}
+
+// Test that threads started after the counters opened are counted
+TEST(HardwareCountersTest, CountsLaterThreads) {
+    HardwareCounterSet counters;
+    if (!counters.available()) {
+        GTEST_SKIP() << "perf_event_open is not permitted here";
+    }
+    HardwareCounters before = counters.read();
+    std::thread worker([]() { busyWork(20000000); });
+    worker.join();
+    HardwareCounters after = hardwareCountersBetween(before, counters.read());
+
+    EXPECT_TRUE(after.available);
+    if (after.instructions > 0) {
+        EXPECT_GE(after.instructions, 20000000u);
+    }
+}
+
+// Test that operations only count when the setting is on
+TEST(HardwareCountersTest, MonitorCountsWhenEnabled) {
+    {
+        MemoryMonitor monitor;
+        monitor.beginPhase("work");
+        busyWork(1000000);
+        OperationMetrics metrics;
+        monitor.finish(metrics);
+        EXPECT_FALSE(metrics.counters.available);
+    }
+
+    ScopedHardwareCounters enabled;
+    bool available = HardwareCounterSet().available();
+    MemoryMonitor monitor;
+    monitor.beginPhase("work");
+    busyWork(5000000);
+    OperationMetrics metrics;
+    monitor.finish(metrics);
+
+    EXPECT_EQ(metrics.counters.available, available);
+    ASSERT_EQ(metrics.phases.size(), 1u);
+    EXPECT_EQ(metrics.phases[0].counters.available, available);
+    if (available && metrics.counters.cycles > 0) {
+        EXPECT_GT(metrics.phases[0].counters.instructions, 0u);
+        EXPECT_GT(metrics.phases[0].counters.ipc, 0.0);
+        EXPECT_LE(metrics.phases[0].counters.cycles, metrics.counters.cycles);
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
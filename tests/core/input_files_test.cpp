@@ -0,0 +1,95 @@
+/**
+ * @file input_files_test.cpp
+ * @brief Tests for input file expansion
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "core/input_files.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class InputFilesTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::filesystem::create_directories("test_input_files/nested");
+        writeFile("test_input_files/a.tsv", 10);
+        writeFile("test_input_files/b.tsv", 300);
+        writeFile("test_input_files/c.txt", 50);
+        writeFile("test_input_files/nested/d.tsv", 200);
+        writeFile("test_input_files/.hidden", 1000);
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all("test_input_files");
+    }
+
+    static void writeFile(const std::string& path, size_t size) {
+        std::ofstream file(path, std::ios::binary);
+        file << std::string(size, 'x');
+    }
+
+    static std::vector<std::string> names(const std::vector<InputFile>& files) {
+        std::vector<std::string> result;
+        for (const auto& file : files) {
+            result.push_back(std::filesystem::path(file.path).filename().string());
+        }
+        return result;
+    }
+};
+
+// Test glob matching
+TEST_F(InputFilesTest, MatchesGlobs) {
+    EXPECT_TRUE(matchGlob("*.tsv", "shard-001.tsv"));
+    EXPECT_TRUE(matchGlob("shard-???.tsv", "shard-001.tsv"));
+    EXPECT_TRUE(matchGlob("*", ""));
+    EXPECT_TRUE(matchGlob("a*b*c", "aXXbYYbc"));
+    EXPECT_FALSE(matchGlob("*.tsv", "shard.txt"));
+    EXPECT_FALSE(matchGlob("shard-??.tsv", "shard-001.tsv"));
+    EXPECT_FALSE(matchGlob("a*b", "a"));
+}
+
+// Test directory expansion, scheduling and expansion order
+TEST_F(InputFilesTest, ExpandsDirectoriesLargestFirst) {
+    EXPECT_TRUE(isInputPattern("test_input_files"));
+    EXPECT_TRUE(isInputPattern("test_input_files/*.tsv"));
+    EXPECT_FALSE(isInputPattern("test_input_files/a.tsv"));
+    EXPECT_FALSE(isInputPattern("-"));
+
+    auto files = expandInputPaths({"test_input_files"});
+    EXPECT_EQ((std::vector<std::string>{"b.tsv", "d.tsv", "c.txt", "a.tsv"}), names(files));
+    EXPECT_EQ(300u, files[0].size);
+
+    // Expansion order is path order: a, b, c, nested/d
+    EXPECT_EQ(1u, files[0].order);
+    EXPECT_EQ(3u, files[1].order);
+    EXPECT_EQ(0u, files[3].order);
+}
+
+// Test globs, explicit files and duplicates
+TEST_F(InputFilesTest, ExpandsGlobsAndLists) {
+    auto globbed = expandInputPaths({"test_input_files/*.tsv"});
+    EXPECT_EQ((std::vector<std::string>{"b.tsv", "a.tsv"}), names(globbed));
+
+    auto listed = expandInputPaths({"test_input_files/c.txt", "test_input_files/*.tsv", "test_input_files/a.tsv"});
+    EXPECT_EQ((std::vector<std::string>{"b.tsv", "c.txt", "a.tsv"}), names(listed));
+    EXPECT_EQ(0u, listed[1].order);
+}
+
+// Test errors for missing inputs
+TEST_F(InputFilesTest, RejectsMissingInputs) {
+    EXPECT_THROW(expandInputPaths({"test_input_files/missing.tsv"}), std::runtime_error);
+    EXPECT_THROW(expandInputPaths({"test_input_files/*.json"}), std::runtime_error);
+    EXPECT_THROW(expandInputPaths({"missing_dir/*.tsv"}), std::runtime_error);
+    EXPECT_THROW(expandInputPaths({"-", "test_input_files/a.tsv"}), std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
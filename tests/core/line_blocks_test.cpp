@@ -0,0 +1,66 @@
+/**
+ * @file line_blocks_test.cpp
+ * @brief Tests for line-aligned block reading
+ */
+
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "core/line_blocks.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::vector<std::string> readBlocks(const std::string& text, size_t blockSize) {
+    std::istringstream input(text);
+    LineBlockReader reader(input, blockSize);
+    std::vector<std::string> blocks;
+    std::string block;
+    while (reader.next(block)) {
+        blocks.push_back(block);
+    }
+    EXPECT_EQ(text.size(), reader.bytesRead());
+    return blocks;
+}
+
+} // namespace
+
+// Test that blocks end on line boundaries and add up to the input
+TEST(LineBlockReaderTest, SplitsAtLineBoundaries) {
+    std::string text;
+    for (int i = 0; i < 500; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+
+    for (size_t blockSize : {1, 7, 64, 1000, 100000}) {
+        std::vector<std::string> blocks = readBlocks(text, blockSize);
+        std::string joined;
+        for (const auto& block : blocks) {
+            ASSERT_FALSE(block.empty());
+            EXPECT_EQ('\n', block.back()) << "block size " << blockSize;
+            joined += block;
+        }
+        EXPECT_EQ(text, joined) << "block size " << blockSize;
+    }
+}
+
+// Test that long lines grow a block and a final line without newline is kept
+TEST(LineBlockReaderTest, HandlesLongAndUnterminatedLines) {
+    std::string longLine(1000, 'x');
+    std::vector<std::string> blocks = readBlocks("a\n" + longLine + "\nlast", 16);
+    ASSERT_EQ(3u, blocks.size());
+    EXPECT_EQ("a\n", blocks[0]);
+    EXPECT_EQ(longLine + "\n", blocks[1]);
+    EXPECT_EQ("last", blocks[2]);
+
+    EXPECT_TRUE(readBlocks("", 16).empty());
+    EXPECT_EQ(std::vector<std::string>{"no newline"}, readBlocks("no newline", 4));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,99 @@
+/**
+ * @file line_scan_test.cpp
+ * @brief Tests for vectorized line classification
+ */
+
+#include <gtest/gtest.h>
+#include <random>
+#include <string>
+#include "core/line_scan.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test classification of simple lines
+TEST(LineScanTest, ClassifiesLines) {
+    LineScan empty = scanLine("");
+    EXPECT_TRUE(empty.validUtf8);
+    EXPECT_TRUE(empty.ascii);
+    EXPECT_TRUE(empty.whitespaceOnly);
+    EXPECT_EQ(0u, empty.codePoints);
+
+    LineScan spaces = scanLine(std::string(40, ' ') + "\t\r\v\f");
+    EXPECT_TRUE(spaces.whitespaceOnly);
+    EXPECT_TRUE(spaces.hasTab);
+
+    LineScan ascii = scanLine("hello world, this line is longer than one block\tfield");
+    EXPECT_TRUE(ascii.ascii);
+    EXPECT_FALSE(ascii.whitespaceOnly);
+    EXPECT_TRUE(ascii.hasTab);
+    EXPECT_EQ(53u, ascii.codePoints);
+
+    LineScan japanese = scanLine("東京ラーメンとカレーライスと😀と本日のおすすめ");
+    EXPECT_TRUE(japanese.validUtf8);
+    EXPECT_FALSE(japanese.ascii);
+    EXPECT_FALSE(japanese.hasTab);
+    EXPECT_EQ(23u, japanese.codePoints);
+}
+
+// Test that malformed UTF-8 is detected anywhere in a line
+TEST(LineScanTest, RejectsMalformedUtf8) {
+    const std::string prefix(37, 'x');
+    EXPECT_FALSE(scanLine(prefix + "\x80").validUtf8);               // Lone continuation
+    EXPECT_FALSE(scanLine(prefix + "\xC0\xAF").validUtf8);           // Overlong
+    EXPECT_FALSE(scanLine(prefix + "\xED\xA0\x80").validUtf8);       // Surrogate
+    EXPECT_FALSE(scanLine(prefix + "\xF4\x90\x80\x80").validUtf8);   // Above U+10FFFF
+    EXPECT_FALSE(scanLine(prefix + "\xE6\x9D").validUtf8);           // Truncated at end
+    EXPECT_FALSE(scanLine(std::string(31, 'x') + "\xF0").validUtf8); // Truncated at block end
+    EXPECT_FALSE(scanLine("\xE6\x9Dx" + prefix).validUtf8);          // Truncated mid-line
+    EXPECT_TRUE(scanLine(std::string(30, 'x') + "\xE6\x9D\xB1" + prefix).validUtf8); // Straddles blocks
+}
+
+// Test that the dispatched kernel agrees with the scalar kernel
+TEST(LineScanTest, MatchesScalarKernel) {
+    const char* pieces[] = {
+        "a", "Z", " ", "\t", "\r", "\n", "é", "東", "😀", "\xEF\xBF\xBF",
+        "\x80", "\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE0\x80", "\xF0\x9F"
+    };
+    const size_t pieceCount = sizeof(pieces) / sizeof(pieces[0]);
+
+    std::mt19937 rng(12345);
+    for (int trial = 0; trial < 20000; ++trial) {
+        std::string line;
+        if (rng() % 3 == 0) {
+            line.assign(rng() % 70, ' ');
+        }
+        size_t count = rng() % 40;
+        for (size_t i = 0; i < count; ++i) {
+            line += pieces[rng() % pieceCount];
+        }
+
+        LineScan fast = scanLine(line);
+        LineScan reference = scanLineScalar(line);
+        ASSERT_EQ(reference.validUtf8, fast.validUtf8) << lineScanKernel() << " trial " << trial;
+        ASSERT_EQ(reference.ascii, fast.ascii) << lineScanKernel() << " trial " << trial;
+        ASSERT_EQ(reference.whitespaceOnly, fast.whitespaceOnly) << lineScanKernel() << " trial " << trial;
+        ASSERT_EQ(reference.hasTab, fast.hasTab) << lineScanKernel() << " trial " << trial;
+        if (reference.validUtf8) {
+            ASSERT_EQ(reference.codePoints, fast.codePoints) << lineScanKernel() << " trial " << trial;
+        }
+    }
+}
+
+// Test that newlines are found at every offset, in and past whole blocks
+TEST(LineScanTest, FindsNewlines) {
+    std::string text(100, 'x');
+    EXPECT_EQ(nullptr, findNewline(text.data(), text.data() + text.size()));
+    EXPECT_EQ(nullptr, findNewline(text.data(), text.data()));
+    for (size_t pos = 0; pos < text.size(); ++pos) {
+        text[pos] = '\n';
+        EXPECT_EQ(text.data() + pos, findNewline(text.data(), text.data() + text.size())) << pos;
+        EXPECT_EQ(nullptr, findNewline(text.data(), text.data() + pos)) << pos;
+        text[pos] = '\xE3';
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,120 @@
+/**
+ * @file mapped_text_test.cpp
+ * @brief Tests for mapped text files and their line ranges
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "core/mapped_text.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::vector<std::string> splitLines(const std::string& text, bool stripCarriageReturn = false) {
+    std::vector<std::string> lines;
+    for (std::string_view line : LineRange(text, stripCarriageReturn)) {
+        lines.emplace_back(line);
+    }
+    return lines;
+}
+
+std::vector<std::string> getlineLines(const std::string& text) {
+    std::istringstream input(text);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(input, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+} // namespace
+
+// Test that lines split as std::getline splits them
+TEST(LineRangeTest, MatchesGetline) {
+    const char* texts[] = {"", "\n", "a", "a\n", "a\nb", "a\n\nb\n", "\n\n", "長い行\n短\n"};
+    for (const char* text : texts) {
+        EXPECT_EQ(splitLines(text), getlineLines(text)) << "text: " << text;
+    }
+}
+
+// Test that a carriage return ending a line is dropped only on request
+TEST(LineRangeTest, StripsCarriageReturns) {
+    EXPECT_EQ(splitLines("a\r\nb\r", true), (std::vector<std::string>{"a", "b"}));
+    EXPECT_EQ(splitLines("a\r\nb\r"), (std::vector<std::string>{"a\r", "b\r"}));
+    EXPECT_EQ(splitLines("\r\n", true), (std::vector<std::string>{""}));
+}
+
+// Test that the offset tracks the bytes consumed by each line
+TEST(LineRangeTest, ReportsOffsets) {
+    std::string text = "ab\ncde\nf";
+    LineRange range(text);
+    std::vector<size_t> offsets;
+    for (auto it = range.begin(); it != range.end(); ++it) {
+        offsets.push_back(it.offset());
+    }
+    EXPECT_EQ(offsets, (std::vector<size_t>{3, 7, 8}));
+}
+
+// Test that streams split into the same lines, including lines across read blocks
+TEST(LineRangeTest, SplitsStreams) {
+    auto streamLines = [](const std::string& text, bool stripCarriageReturn) {
+        std::istringstream input(text);
+        std::vector<std::string> lines;
+        forEachLine(input, [&lines](std::string_view line) { lines.emplace_back(line); }, stripCarriageReturn);
+        return lines;
+    };
+
+    const char* texts[] = {"", "\n", "a", "a\n", "a\nb", "a\n\nb\n", "a\r\nb\r"};
+    for (const char* text : texts) {
+        EXPECT_EQ(streamLines(text, false), splitLines(text)) << "text: " << text;
+        EXPECT_EQ(streamLines(text, true), splitLines(text, true)) << "text: " << text;
+    }
+
+    // Longer than one read block, with a line spanning the boundary and one spanning two
+    std::string text;
+    for (size_t i = 0; text.size() < 5 * 1024 * 1024; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+    text += std::string(9 * 1024 * 1024, 'x') + "\nend";
+    EXPECT_EQ(streamLines(text, false), splitLines(text));
+}
+
+// Test that files are mapped, and that empty files fall back to a buffer
+TEST(MappedTextTest, MapsAndFallsBack) {
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "suzume_mapped_text_test";
+    std::filesystem::create_directories(dir);
+    std::string path = (dir / "input.txt").string();
+    std::string emptyPath = (dir / "empty.txt").string();
+    std::ofstream(path, std::ios::binary) << "一行目\n二行目\r\n";
+    std::ofstream(emptyPath, std::ios::binary).close();
+
+    {
+        MappedText text(path);
+        EXPECT_EQ(text.text(), "一行目\n二行目\r\n");
+        std::vector<std::string_view> lines;
+        for (std::string_view line : text.lines(true)) {
+            lines.push_back(line);
+        }
+        EXPECT_EQ(lines, (std::vector<std::string_view>{"一行目", "二行目"}));
+
+        MappedText empty(emptyPath);
+        EXPECT_FALSE(empty.isMapped());
+        EXPECT_TRUE(empty.text().empty());
+        EXPECT_EQ(empty.lines().begin(), empty.lines().end());
+    }
+
+    EXPECT_THROW(MappedText((dir / "missing.txt").string()), std::runtime_error);
+    std::filesystem::remove_all(dir);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
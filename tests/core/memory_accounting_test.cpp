@@ -0,0 +1,174 @@
+/**
+ * @file memory_accounting_test.cpp
+ * @brief Tests for per-subsystem memory accounting and the memory limit
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <utility>
+#include "core/dedup.h"
+#include "core/memory_accounting.h"
+#include "core/normalize.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Sets a memory limit for the scope of a test
+class ScopedMemoryLimit {
+public:
+    explicit ScopedMemoryLimit(uint64_t bytes) { setMemoryLimit(bytes); }
+    ~ScopedMemoryLimit() { setMemoryLimit(0); }
+};
+
+uint64_t dedupBytes() {
+    return chargedMemory()[static_cast<size_t>(MemorySubsystem::Dedup)];
+}
+
+uint64_t subsystemPeak(const MemoryStats& memory, const std::string& name) {
+    for (const auto& subsystem : memory.subsystems) {
+        if (subsystem.subsystem == name) {
+            return subsystem.peakBytes;
+        }
+    }
+    ADD_FAILURE() << "No subsystem " << name;
+    return 0;
+}
+
+std::set<std::string> readLineSet(const std::string& path) {
+    std::ifstream file(path);
+    std::set<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.insert(line);
+    }
+    return lines;
+}
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+// Distinct bigrams enough for tables of a few MB
+void writeLongTail(const std::string& path) {
+    std::ofstream file(path, std::ios::binary);
+    uint32_t state = 12345;
+    for (int i = 0; i < 60000; ++i) {
+        if (i % 4 == 0) {
+            file << "東京都の天気\n";
+            continue;
+        }
+        std::string line;
+        for (int j = 0; j < 8; ++j) {
+            state = state * 1103515245u + 12345u;
+            uint32_t codePoint = 0x4E00 + (state >> 16) % 6000;
+            line += static_cast<char>(0xE0 | (codePoint >> 12));
+            line += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+            line += static_cast<char>(0x80 | (codePoint & 0x3F));
+        }
+        file << line << '\n';
+    }
+}
+
+} // namespace
+
+// Test that charges follow copies and moves, are released, and raise the peaks of trackers
+TEST(MemoryAccountingTest, ChargesFollowStructures) {
+    const uint64_t before = dedupBytes();
+    MemoryPeakTracker tracker;
+    uint64_t grown = 0;
+    {
+        FingerprintSet set;
+        for (uint64_t i = 1; i <= 100000; ++i) {
+            set.insert(i * 0x9E3779B97F4A7C15ull);
+        }
+        grown = dedupBytes() - before;
+        EXPECT_EQ(set.memoryUsage(), grown);
+
+        FingerprintSet copy = set;
+        EXPECT_EQ(before + 2 * grown, dedupBytes());
+        FingerprintSet moved = std::move(copy);
+        EXPECT_EQ(before + 2 * grown, dedupBytes());
+    }
+    EXPECT_EQ(before, dedupBytes());
+
+    // The last rehash held the old and the new slot arrays at once
+    uint64_t peak = tracker.peaks()[static_cast<size_t>(MemorySubsystem::Dedup)];
+    EXPECT_GE(peak, before + 2 * grown);
+    EXPECT_STREQ("ngram_tables", memorySubsystemName(MemorySubsystem::NgramTables));
+
+    MemoryCharge charge(MemorySubsystem::TextIndex, 1000);
+    charge.set(10);
+    EXPECT_EQ(10u, charge.bytes());
+}
+
+// Test that operations report the peak of every subsystem
+TEST(MemoryAccountingTest, OperationsReportSubsystemPeaks) {
+    std::filesystem::create_directories("test_data");
+    const std::string input = "test_data/accounting_input.txt";
+    writeLongTail(input);
+
+    NormalizeOptions options;
+    options.progressFormat = ProgressFormat::NONE;
+    NormalizeResult result = core::normalize(input, "null", options);
+    ASSERT_EQ(kMemorySubsystems, result.memory.subsystems.size());
+    EXPECT_GT(subsystemPeak(result.memory, "lines"), 0u);
+    EXPECT_GT(subsystemPeak(result.memory, "dedup"), 0u);
+    EXPECT_EQ(0u, result.memory.limitBytes);
+
+    PmiOptions pmiOptions;
+    pmiOptions.n = 2;
+    pmiOptions.progressFormat = ProgressFormat::NONE;
+    PmiResult pmi = core::calculatePmi(input, "null", pmiOptions);
+    EXPECT_GT(subsystemPeak(pmi.memory, "ngram_tables"), 256u * 1024);
+}
+
+// Test that a memory limit streams normalize, budgets PMI tables and keeps the results
+TEST(MemoryAccountingTest, LimitSwitchesToBoundedModes) {
+    std::filesystem::create_directories("test_data/accounting_runs");
+    const std::string input = "test_data/accounting_input.txt";
+    writeLongTail(input);
+
+    NormalizeOptions options;
+    options.threads = 2;
+    options.progressFormat = ProgressFormat::NONE;
+    NormalizeResult unlimited = core::normalize(input, "test_data/accounting_unlimited.txt", options);
+
+    PmiOptions pmiOptions;
+    pmiOptions.n = 2;
+    pmiOptions.topK = 200;
+    pmiOptions.minFreq = 2;
+    pmiOptions.progressFormat = ProgressFormat::NONE;
+    pmiOptions.tempDir = "test_data/accounting_runs";
+    core::calculatePmi(input, "test_data/accounting_pmi_unlimited.tsv", pmiOptions);
+
+    ScopedMemoryLimit limit(1024 * 1024);
+    options.tempDir = "test_data/accounting_runs";
+    NormalizeResult limited = core::normalize(input, "test_data/accounting_limited.txt", options);
+    EXPECT_EQ(1024u * 1024, limited.memory.limitBytes);
+    EXPECT_EQ(unlimited.uniques, limited.uniques);
+    EXPECT_EQ(readLineSet("test_data/accounting_unlimited.txt"), readLineSet("test_data/accounting_limited.txt"));
+    EXPECT_LT(subsystemPeak(limited.memory, "lines"), subsystemPeak(unlimited.memory, "lines"));
+
+    PmiResult pruned = core::calculatePmi(input, "null", pmiOptions);
+    EXPECT_EQ(MemoryBudgetStrategy::Prune, pruned.budgetStrategy);
+    EXPECT_GT(pruned.countErrorBound, 0u);
+
+    pmiOptions.budgetStrategy = MemoryBudgetStrategy::Spill;
+    PmiResult spilled = core::calculatePmi(input, "test_data/accounting_pmi_spilled.tsv", pmiOptions);
+    EXPECT_EQ(MemoryBudgetStrategy::Spill, spilled.budgetStrategy);
+    EXPECT_EQ(readFile("test_data/accounting_pmi_unlimited.tsv"), readFile("test_data/accounting_pmi_spilled.tsv"));
+    EXPECT_TRUE(std::filesystem::is_empty("test_data/accounting_runs"));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,224 @@
+/**
+ * @file memory_monitor_test.cpp
+ * @brief Tests for memory measurement
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/memory_monitor.h"
+#include "core/normalize.h"
+#include "core/output_writer.h"
+#include "core/pmi.h"
+#include "parallel/trace.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that allocations show up in the phase that made them
+TEST(MemoryMonitorTest, PhasesRecordAllocations) {
+    if (heapBytesInUse() == 0) {
+        GTEST_SKIP() << "No allocator statistics on this platform";
+    }
+    constexpr size_t kSmall = 1 << 20;
+    constexpr size_t kLarge = 64 << 20;
+
+    MemoryMonitor monitor;
+    monitor.beginPhase("small");
+    std::unique_ptr<char[]> small(new char[kSmall]);
+    std::memset(small.get(), 1, kSmall);
+    monitor.beginPhase("large");
+    std::unique_ptr<char[]> large(new char[kLarge]);
+    std::memset(large.get(), 1, kLarge);
+    MemoryStats stats = monitor.finish();
+
+    ASSERT_EQ(stats.phases.size(), 2u);
+    EXPECT_EQ(stats.phases[0].phase, "small");
+    EXPECT_EQ(stats.phases[1].phase, "large");
+    EXPECT_GE(stats.phases[0].peakBytes, kSmall);
+    EXPECT_LT(stats.phases[0].peakBytes, kLarge);
+    EXPECT_GE(stats.phases[1].peakBytes, kSmall + kLarge);
+    EXPECT_EQ(stats.peakBytes, stats.phases[1].peakBytes);
+    EXPECT_GE(stats.peakResidentBytes, stats.phases[0].peakResidentBytes);
+    if (residentBytes() > 0) {
+        EXPECT_GE(stats.phases[1].peakResidentBytes, kLarge);
+    }
+}
+
+// Test that tracked progress starts phases in order and is forwarded
+TEST(MemoryMonitorTest, TrackFollowsProgressPhases) {
+    int forwarded = 0;
+    MemoryMonitor monitor;
+    auto callback = monitor.track([&forwarded](const ProgressInfo&) {
+        ++forwarded;
+    });
+
+    ProgressInfo info;
+    for (auto phase : {ProgressInfo::Phase::Reading, ProgressInfo::Phase::Processing,
+                       ProgressInfo::Phase::Reading, ProgressInfo::Phase::Writing,
+                       ProgressInfo::Phase::Complete}) {
+        info.phase = phase;
+        callback(info);
+    }
+    MemoryStats stats = monitor.finish();
+
+    EXPECT_EQ(forwarded, 5);
+    ASSERT_EQ(stats.phases.size(), 3u);
+    EXPECT_EQ(stats.phases[0].phase, "reading");
+    EXPECT_EQ(stats.phases[1].phase, "processing");
+    EXPECT_EQ(stats.phases[2].phase, "writing");
+}
+
+// Test that an operation reports its measured memory
+TEST(MemoryMonitorTest, NormalizeReportsMemory) {
+    auto dir = std::filesystem::temp_directory_path() / "suzume_memory_monitor_test";
+    std::filesystem::create_directories(dir);
+    std::string inputPath = (dir / "input.txt").string();
+    {
+        std::ofstream file(inputPath);
+        for (int i = 0; i < 2000; ++i) {
+            file << "テスト行" << i << "\n";
+        }
+    }
+
+    NormalizeOptions options;
+    NormalizeResult result = core::normalize(inputPath, (dir / "output.tsv").string(), options);
+    std::filesystem::remove_all(dir);
+
+    EXPECT_EQ(result.uniques, 2000u);
+    ASSERT_FALSE(result.memory.phases.empty());
+    EXPECT_EQ(result.memory.phases.front().phase, "reading");
+    for (const auto& phase : result.memory.phases) {
+        EXPECT_LE(phase.peakBytes, result.memory.peakBytes);
+    }
+}
+
+// Test that phases are timed and count the output written during them
+TEST(MemoryMonitorTest, PhasesRecordTimeAndOutput) {
+    auto dir = std::filesystem::temp_directory_path() / "suzume_memory_monitor_test";
+    std::filesystem::create_directories(dir);
+
+    OperationMetrics metrics;
+    metrics.bytesIn = 1024 * 1024;
+    metrics.lines = 1000;
+    metrics.threads = 2;
+    MemoryMonitor monitor;
+    monitor.beginPhase("busy");
+    volatile uint64_t sum = 0;
+    auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(30);
+    while (std::chrono::steady_clock::now() < until) {
+        sum = sum + 1;
+    }
+    monitor.beginPhase("write");
+    {
+        OutputWriter output((dir / "metrics.txt").string());
+        output.write(std::string(5000, 'x'));
+        output.close();
+    }
+    MemoryStats stats = monitor.finish(metrics);
+    std::filesystem::remove_all(dir);
+
+    ASSERT_EQ(metrics.phases.size(), 2u);
+    ASSERT_EQ(stats.phases.size(), 2u);
+    EXPECT_EQ(metrics.phases[0].phase, "busy");
+    EXPECT_EQ(metrics.phases[1].phase, "write");
+    EXPECT_GE(metrics.phases[0].elapsedMs, 30u);
+    EXPECT_EQ(metrics.phases[0].bytesOut, 0u);
+    EXPECT_EQ(metrics.phases[1].bytesOut, 5000u);
+    EXPECT_GE(metrics.elapsedMs, metrics.phases[0].elapsedMs);
+    EXPECT_EQ(metrics.bytesOut, 5000u);
+    EXPECT_GT(metrics.linesPerSec, 0.0);
+    EXPECT_GT(metrics.mbPerSec, 0.0);
+    if (processCpuMicros() > 0) {
+        // One of the two threads was spinning
+        EXPECT_GT(metrics.phases[0].cpuMs, 0u);
+        EXPECT_GT(metrics.phases[0].threadUtilization, 0.2);
+        EXPECT_LE(metrics.phases[0].threadUtilization, 1.0);
+    }
+}
+
+// Test that normalize and PMI fill in their metrics and totals
+TEST(MemoryMonitorTest, OperationsReportMetrics) {
+    auto dir = std::filesystem::temp_directory_path() / "suzume_memory_monitor_test";
+    std::filesystem::create_directories(dir);
+    std::string inputPath = (dir / "input.txt").string();
+    {
+        std::ofstream file(inputPath);
+        for (int i = 0; i < 3000; ++i) {
+            file << "テスト行" << (i % 1000) << "\n";
+        }
+    }
+    const uint64_t inputSize = std::filesystem::file_size(inputPath);
+
+    NormalizeOptions options;
+    options.threads = 2;
+    options.progressFormat = ProgressFormat::NONE;
+    const std::string outputPath = (dir / "output.txt").string();
+    NormalizeResult result = core::normalize(inputPath, outputPath, options);
+    EXPECT_EQ(result.rows, 3000u);
+    EXPECT_EQ(result.duplicates, 2000u);
+    EXPECT_EQ(result.elapsedMs, result.metrics.elapsedMs);
+    EXPECT_EQ(result.metrics.bytesIn, inputSize);
+    EXPECT_EQ(result.metrics.bytesOut, std::filesystem::file_size(outputPath));
+    EXPECT_EQ(result.metrics.lines, 3000u);
+    EXPECT_EQ(result.metrics.threads, 2u);
+    ASSERT_EQ(result.metrics.phases.size(), result.memory.phases.size());
+    for (size_t i = 0; i < result.metrics.phases.size(); ++i) {
+        EXPECT_EQ(result.metrics.phases[i].phase, result.memory.phases[i].phase);
+    }
+
+    PmiOptions pmiOptions;
+    pmiOptions.n = 2;
+    pmiOptions.threads = 2;
+    pmiOptions.progressFormat = ProgressFormat::NONE;
+    const std::string pmiPath = (dir / "pmi.tsv").string();
+    PmiResult pmi = core::calculatePmi(inputPath, pmiPath, pmiOptions);
+    EXPECT_EQ(pmi.metrics.bytesIn, inputSize);
+    EXPECT_EQ(pmi.metrics.bytesOut, std::filesystem::file_size(pmiPath));
+    EXPECT_EQ(pmi.metrics.threads, 2u);
+    ASSERT_FALSE(pmi.metrics.phases.empty());
+    EXPECT_EQ(pmi.metrics.phases.back().phase, "writing");
+    std::filesystem::remove_all(dir);
+}
+
+// Test that a traced run shows the operation, its phases and its worker tasks
+TEST(MemoryMonitorTest, TracesPhasesAndTasks) {
+    auto dir = std::filesystem::temp_directory_path() / "suzume_memory_monitor_test";
+    std::filesystem::create_directories(dir);
+    std::string inputPath = (dir / "input.txt").string();
+    {
+        std::ofstream file(inputPath);
+        for (int i = 0; i < 3000; ++i) {
+            file << "東京都に行く" << (i % 100) << "\n";
+        }
+    }
+
+    PmiOptions options;
+    options.n = 2;
+    options.threads = 2;
+    options.progressFormat = ProgressFormat::NONE;
+    const std::string tracePath = (dir / "trace.json").string();
+    parallel::startTrace();
+    core::calculatePmi(inputPath, (dir / "pmi.tsv").string(), options);
+    parallel::stopTrace(tracePath);
+
+    std::ifstream file(tracePath);
+    std::string trace((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::filesystem::remove_all(dir);
+    EXPECT_NE(trace.find("{\"name\":\"pmi\",\"cat\":\"operation\""), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"writing\",\"cat\":\"phase\""), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"count\",\"cat\":\"task\""), std::string::npos);
+    EXPECT_NE(trace.find("{\"name\":\"merge tables\",\"cat\":\"task\""), std::string::npos);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -206,6 +206,32 @@ TEST(MemoryPoolTest, ThreadSafetyTest) {
     std::cout << "Failed allocations: " << failedAllocations.load() << std::endl;
 }
 
+// Objects freed on another thread are reused by that thread
+TEST(MemoryPoolTest, CrossThreadDeallocation) {
+    MemoryPool<int, 8> pool;
+
+    std::vector<int*> ptrs;
+    for (int i = 0; i < 8; ++i) {
+        ptrs.push_back(pool.allocate());
+    }
+    EXPECT_EQ(1u, pool.getChunkCount());
+
+    std::thread([&]() {
+        for (int* ptr : ptrs) {
+            pool.deallocate(ptr);
+        }
+        // The freed objects are in this thread's cache; no new chunk is needed
+        std::vector<int*> reused;
+        for (int i = 0; i < 8; ++i) {
+            reused.push_back(pool.allocate());
+        }
+        EXPECT_EQ(1u, pool.getChunkCount());
+        for (int* ptr : reused) {
+            pool.deallocate(ptr);
+        }
+    }).join();
+}
+
 // Test to verify memory pool memory usage tracking
 TEST(MemoryPoolTest, MemoryUsageTracking) {
     MemoryPool<int, 10> pool; // Small chunk size for testing
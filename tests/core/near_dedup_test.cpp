@@ -0,0 +1,110 @@
+/**
+ * @file near_dedup_test.cpp
+ * @brief Tests for SimHash near-duplicate detection
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <bitset>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/near_dedup.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+size_t bitDistance(uint64_t a, uint64_t b) {
+    return std::bitset<64>(a ^ b).count();
+}
+
+} // namespace
+
+// Test that similar lines get close signatures and unrelated lines do not
+TEST(NearDedupTest, SimHashSimilarity) {
+    const std::string base = "今日は新しいカフェに行ってきました。ケーキがとても美味しかったです";
+    uint64_t original = computeSimHash(base);
+
+    EXPECT_EQ(original, computeSimHash(base));
+    EXPECT_LE(bitDistance(original, computeSimHash(base + "！")), 6u);
+    EXPECT_GT(bitDistance(original, computeSimHash("The quick brown fox jumps over the lazy dog")), 10u);
+
+    // Lines shorter than a shingle still hash
+    EXPECT_NE(computeSimHash("a"), computeSimHash("b"));
+    computeSimHash("");
+}
+
+// Test that the filter rejects lines within the distance
+TEST(NearDedupTest, RejectsNearDuplicates) {
+    NearDuplicateFilter filter(3);
+
+    uint64_t signature = 0x0123456789ABCDEFULL;
+    EXPECT_TRUE(filter.insertSignature(signature));
+    EXPECT_FALSE(filter.insertSignature(signature));
+    EXPECT_FALSE(filter.insertSignature(signature ^ 0x8000000000000001ULL));
+    EXPECT_FALSE(filter.insertSignature(signature ^ 0x0000010000100001ULL));
+
+    // Four flipped bits are beyond the distance
+    EXPECT_TRUE(filter.insertSignature(signature ^ 0x0100010000100001ULL));
+
+    EXPECT_EQ(2u, filter.size());
+    EXPECT_EQ(3u, filter.rejected());
+    EXPECT_GT(filter.memoryUsage(), 0u);
+
+    EXPECT_FALSE(filter.isNearDuplicate("ユニークな行"));
+    EXPECT_TRUE(filter.isNearDuplicate("ユニークな行"));
+}
+
+// Test that the index stops growing at the entry cap
+TEST(NearDedupTest, RespectsEntryCap) {
+    NearDuplicateFilter filter(2, 100);
+
+    for (uint64_t i = 0; i < 5000; ++i) {
+        filter.insertSignature(i * 0x9E3779B97F4A7C15ULL);
+    }
+    EXPECT_EQ(100u, filter.size());
+
+    // Indexed lines are still matched after the cap
+    EXPECT_FALSE(filter.insertSignature(0x9E3779B97F4A7C15ULL));
+}
+
+// Test that concurrent inserts keep exactly one of each group
+TEST(NearDedupTest, ConcurrentInserts) {
+    NearDuplicateFilter filter(3);
+    std::atomic<size_t> kept(0);
+
+    // 2000 distinct bases, each inserted by every thread with one flipped bit
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            for (uint64_t i = 0; i < 2000; ++i) {
+                uint64_t base = (i + 1) * 0xD6E8FEB86659FD93ULL;
+                if (filter.insertSignature(base ^ (uint64_t{1} << (t * 8)))) {
+                    kept++;
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    EXPECT_EQ(filter.size(), kept.load());
+    EXPECT_GE(kept.load(), 2000u * 9 / 10);
+    EXPECT_LE(kept.load(), 2000u);
+}
+
+// Test that an invalid distance is rejected
+TEST(NearDedupTest, InvalidDistance) {
+    EXPECT_THROW(NearDuplicateFilter(0), std::invalid_argument);
+    EXPECT_THROW(NearDuplicateFilter(32), std::invalid_argument);
+    EXPECT_NO_THROW(NearDuplicateFilter(31));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -13,6 +13,9 @@
 #include <fstream>
 #include <random>
 #include <thread>
+#include <sstream>
+#include <atomic>
+#include <algorithm>
 
 namespace suzume {
 namespace core {
@@ -301,6 +304,157 @@ TEST(NGramOptimizationTest, ParallelStreamingPerformance) {
     std::remove(outputFile.c_str());
 }
 
+// Test that parallel streaming keeps buffered lines within the memory budget
+TEST(NGramOptimizationTest, ParallelStreamingMemoryBudget) {
+    StreamingConfig config;
+    config.batchSize = 1000;
+    config.maxMemoryUsage = 64 * 1024;
+
+    std::stringstream input;
+    const size_t numLines = 20000;
+    for (size_t i = 0; i < numLines; ++i) {
+        input << "Streaming budget line " << i << "\n";
+    }
+
+    ParallelStreamProcessor processor(3, config);
+
+    std::atomic<size_t> maxBatch{0};
+    auto batchProcessor = [&maxBatch](const std::vector<std::string>& batch) {
+        size_t current = maxBatch.load();
+        while (batch.size() > current && !maxBatch.compare_exchange_weak(current, batch.size())) {
+        }
+        return batch;
+    };
+
+    std::stringstream output;
+    size_t linesProcessed = processor.processStream(input, &output, batchProcessor);
+
+    EXPECT_EQ(numLines, linesProcessed);
+    EXPECT_EQ(numLines, processor.getOutputLines());
+    EXPECT_LE(processor.getPeakBufferedBytes(), config.maxMemoryUsage);
+    EXPECT_LT(maxBatch.load(), config.batchSize);
+
+    size_t outputLines = 0;
+    std::string line;
+    while (std::getline(output, line)) {
+        outputLines++;
+    }
+    EXPECT_EQ(numLines, outputLines);
+}
+
+// Test that worker exceptions are propagated to the caller
+TEST(NGramOptimizationTest, ParallelStreamingPropagatesErrors) {
+    std::stringstream input;
+    for (int i = 0; i < 100; ++i) {
+        input << "line " << i << "\n";
+    }
+
+    StreamingConfig config;
+    config.batchSize = 10;
+    ParallelStreamProcessor processor(2, config);
+
+    auto failingProcessor = [](const std::vector<std::string>&) -> std::vector<std::string> {
+        throw std::runtime_error("batch failed");
+    };
+
+    EXPECT_THROW(processor.processStream(input, nullptr, failingProcessor), std::runtime_error);
+}
+
+// Test that preserveOrder writes batches in input order with a bounded window
+TEST(NGramOptimizationTest, ParallelStreamingPreservesOrder) {
+    std::stringstream input;
+    std::string expected;
+    for (int i = 0; i < 2000; ++i) {
+        input << "line " << i << "\n";
+        expected += "LINE " + std::to_string(i) + "\n";
+    }
+
+    StreamingConfig config;
+    config.batchSize = 7;
+    config.preserveOrder = true;
+    config.reorderWindow = 8;
+    ParallelStreamProcessor processor(4, config);
+
+    // Uneven batch costs make workers finish out of order
+    std::atomic<int> calls{0};
+    auto upperProcessor = [&calls](const std::vector<std::string>& batch) {
+        if (calls++ % 3 == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        std::vector<std::string> result;
+        for (const auto& line : batch) {
+            std::string upper = line;
+            std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+            result.push_back(upper);
+        }
+        return result;
+    };
+
+    // The sequential stage sees batches in order as well
+    size_t lastSeen = 0;
+    bool stageOrdered = true;
+    auto checkOrder = [&](const std::vector<std::string>& batch) {
+        for (const auto& line : batch) {
+            size_t number = std::stoul(line.substr(5));
+            stageOrdered = stageOrdered && (number == 0 || number == lastSeen + 1);
+            lastSeen = number;
+        }
+        return batch;
+    };
+
+    std::ostringstream output;
+    EXPECT_EQ(2000u, processor.processStream(input, &output, upperProcessor, nullptr, 0, checkOrder));
+    EXPECT_EQ(expected, output.str());
+    EXPECT_TRUE(stageOrdered);
+    EXPECT_LE(processor.getPeakReorderBatches(), 8u);
+}
+
+// Test that line blocks hold their lines back to back, newline-terminated
+TEST(NGramOptimizationTest, LineBlockStoresLines) {
+    LineBlock block;
+    block.push_back("first");
+    block.push_back("");
+    block.push_back("third line");
+
+    ASSERT_EQ(3u, block.size());
+    EXPECT_EQ("first", block[0]);
+    EXPECT_EQ("", block[1]);
+    EXPECT_EQ("third line", block[2]);
+    EXPECT_EQ("first\n\nthird line\n", block.text());
+    EXPECT_EQ(std::vector<std::string_view>({"first", "", "third line"}),
+              std::vector<std::string_view>(block.begin(), block.end()));
+}
+
+// Test that block processing writes what each batch appends, in order with preserveOrder
+TEST(NGramOptimizationTest, ParallelStreamingBlocks) {
+    std::stringstream input;
+    std::string expected;
+    for (int i = 0; i < 1000; ++i) {
+        input << "line " << i << "\n";
+        if (i % 2 == 0) {
+            expected += "line " + std::to_string(i) + "!\n";
+        }
+    }
+
+    StreamingConfig config;
+    config.batchSize = 16;
+    config.preserveOrder = true;
+    ParallelStreamProcessor processor(3, config);
+
+    auto evenLines = [](const LineBlock& batch, LineBlock& result) {
+        for (std::string_view line : batch) {
+            if (std::stoi(std::string(line.substr(5))) % 2 == 0) {
+                result.push_back(std::string(line) + "!");
+            }
+        }
+    };
+
+    std::ostringstream output;
+    EXPECT_EQ(1000u, processor.processStreamBlocks(input, &output, evenLines));
+    EXPECT_EQ(expected, output.str());
+    EXPECT_EQ(500u, processor.getOutputLines());
+}
+
 // Test to verify cache cleanup functionality
 TEST(NGramOptimizationTest, CacheCleanupTest) {
     NGramCache cache(10, 1); // 10 entries, 1 minute TTL
@@ -328,6 +482,82 @@ TEST(NGramOptimizationTest, CacheCleanupTest) {
     EXPECT_EQ(5u, size2);
 }
 
+// Test that a full cache evicts the least recently used entry
+TEST(NGramOptimizationTest, CacheEvictsLeastRecentlyUsed) {
+    NGramCache cache(3, 5);
+    cache.put("a", 1.0, 1);
+    cache.put("b", 2.0, 2);
+    cache.put("c", 3.0, 3);
+
+    // Touch "a" so that "b" becomes the oldest
+    ASSERT_TRUE(cache.get("a").has_value());
+    cache.put("d", 4.0, 4);
+    EXPECT_FALSE(cache.get("b").has_value());
+    EXPECT_TRUE(cache.get("a").has_value());
+    EXPECT_TRUE(cache.get("c").has_value());
+    EXPECT_TRUE(cache.get("d").has_value());
+
+    // Replacing a value keeps the size
+    cache.put("c", 5.0, 5);
+    auto [hits, misses, size] = cache.getStats();
+    EXPECT_EQ(3u, size);
+    EXPECT_DOUBLE_EQ(5.0, cache.get("c")->score);
+}
+
+// Test that a sharded cache stays within capacity under concurrent use
+TEST(NGramOptimizationTest, ShardedCacheConcurrentAccess) {
+    ShardedLruCache<std::string, int> cache(4096);
+    EXPECT_GT(cache.shardCount(), 1u);
+
+    std::vector<std::thread> workers;
+    for (int t = 0; t < 4; ++t) {
+        workers.emplace_back([&cache, t]() {
+            for (int i = 0; i < 20000; ++i) {
+                std::string key = "ngram_" + std::to_string((i * 7 + t) % 6000);
+                int value = cache.getOrCompute(key, [i]() { return i; });
+                (void)value;
+            }
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    EXPECT_LE(cache.size(), 4096u);
+    EXPECT_EQ(80000u, cache.hits() + cache.misses());
+    EXPECT_GT(cache.hits(), 0u);
+
+    size_t before = cache.size();
+    size_t removed = cache.removeIf([](int value) { return value % 2 == 0; });
+    EXPECT_GT(removed, 0u);
+    EXPECT_EQ(before - removed, cache.size());
+    cache.clear();
+    EXPECT_EQ(0u, cache.size());
+}
+
+// Test that PMICache computes each value once while it stays cached
+TEST(NGramOptimizationTest, PmiCacheComputesOnce) {
+    PMICache cache(100);
+    int computed = 0;
+    for (int i = 0; i < 10; ++i) {
+        double pmi = cache.getOrCompute("東京", [&]() {
+            computed++;
+            return 4.5;
+        });
+        EXPECT_DOUBLE_EQ(4.5, pmi);
+    }
+    EXPECT_EQ(1, computed);
+
+    cache.preload({"東京", "大阪"}, [&](const std::string&) {
+        computed++;
+        return 1.0;
+    });
+    EXPECT_EQ(2, computed);
+    auto [hits, misses, size] = cache.getStats();
+    EXPECT_EQ(9u, hits);
+    EXPECT_EQ(1u, misses);
+    EXPECT_EQ(2u, size);
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
\ No newline at end of file
@@ -0,0 +1,248 @@
+/**
+ * @file ngram_snapshot_test.cpp
+ * @brief Tests for binary n-gram count snapshots
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "core/ngram_snapshot.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class NgramSnapshotTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        std::filesystem::create_directories("test_data/snapshots");
+        // Enough distinct bigrams for several index blocks
+        for (int day = 0; day < 2; ++day) {
+            std::string& text = days[day];
+            for (int i = 0; i < 1500; ++i) {
+                text += "東京";
+                appendUtf8(text, 0x4E00 + (i * 31 + day * 7) % 2003);
+                appendUtf8(text, 0x4E00 + (i * 17) % 1009);
+                text += "の天気\n";
+            }
+        }
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all("test_data");
+    }
+
+    static std::string readFile(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+
+    std::string days[2];
+};
+
+// Test that a snapshot holds every count of the table, in key order
+TEST_F(NgramSnapshotTest, RoundTrips) {
+    PartitionedNgramCounter counts(2, 3);
+    counts.addText(days[0]);
+    writeSnapshot("test_data/snapshots/day0.snap", counts);
+
+    ASSERT_TRUE(isSnapshotFile("test_data/snapshots/day0.snap"));
+    SnapshotReader reader("test_data/snapshots/day0.snap");
+    EXPECT_EQ(2u, reader.n());
+    EXPECT_EQ(counts.size(), reader.entries());
+    ASSERT_GT(reader.entries(), 2 * kSnapshotIndexInterval);
+
+    uint64_t key = 0;
+    uint64_t count = 0;
+    uint64_t previous = 0;
+    uint64_t entries = 0;
+    uint64_t total = 0;
+    while (reader.next(key, count)) {
+        EXPECT_TRUE(entries == 0 || key > previous);
+        EXPECT_EQ(counts.count(key), count);
+        previous = key;
+        entries++;
+        total += count;
+    }
+    EXPECT_EQ(reader.entries(), entries);
+    EXPECT_EQ(reader.total(), total);
+
+    // Point lookups through the index
+    counts.forEach([&](uint64_t k, uint32_t c) { EXPECT_EQ(c, reader.count(k)); });
+    uint64_t absent = 0;
+    ASSERT_TRUE(PackedNgramCounter::pack("xy", 2, absent));
+    EXPECT_EQ(0u, reader.count(absent));
+    EXPECT_EQ(0u, reader.count(0));
+
+    reader.rewind();
+    EXPECT_TRUE(reader.next(key, count));
+}
+
+// Test that invalid snapshots are rejected
+TEST_F(NgramSnapshotTest, RejectsInvalidFiles) {
+    std::ofstream("test_data/snapshots/text.txt") << "東京の天気\n";
+    EXPECT_FALSE(isSnapshotFile("test_data/snapshots/text.txt"));
+    EXPECT_THROW(SnapshotReader("test_data/snapshots/text.txt"), std::runtime_error);
+    EXPECT_THROW(SnapshotReader("test_data/snapshots/missing.snap"), std::runtime_error);
+
+    {
+        SnapshotWriter writer("test_data/snapshots/unfinished.snap", 2);
+        writer.add(5, 1);
+        EXPECT_THROW(writer.add(5, 1), std::invalid_argument);
+        EXPECT_THROW(writer.add(4, 1), std::invalid_argument);
+    }
+    EXPECT_THROW(SnapshotReader("test_data/snapshots/unfinished.snap"), std::runtime_error);
+
+    // Truncated data
+    PartitionedNgramCounter counts(2, 1);
+    counts.addText(days[0]);
+    writeSnapshot("test_data/snapshots/full.snap", counts);
+    std::string bytes = readFile("test_data/snapshots/full.snap");
+    std::ofstream("test_data/snapshots/truncated.snap", std::ios::binary) << bytes.substr(0, bytes.size() / 2);
+    EXPECT_THROW(SnapshotReader("test_data/snapshots/truncated.snap"), std::runtime_error);
+}
+
+// Test that merged snapshots equal counting the texts together
+TEST_F(NgramSnapshotTest, MergesSnapshots) {
+    for (int day = 0; day < 2; ++day) {
+        PartitionedNgramCounter counts(2, 2);
+        counts.addText(days[day]);
+        writeSnapshot("test_data/snapshots/day" + std::to_string(day) + ".snap", counts);
+    }
+    uint64_t entries = mergeSnapshots(
+        {"test_data/snapshots/day0.snap", "test_data/snapshots/day1.snap"}, "test_data/snapshots/merged.snap");
+
+    PartitionedNgramCounter combined(2, 1);
+    combined.addText(days[0] + days[1]);
+    EXPECT_EQ(combined.size(), entries);
+
+    SnapshotReader merged("test_data/snapshots/merged.snap");
+    uint64_t key = 0;
+    uint64_t count = 0;
+    while (merged.next(key, count)) {
+        EXPECT_EQ(combined.count(key), count);
+    }
+
+    PartitionedNgramCounter trigrams(3, 1);
+    trigrams.addText(days[0]);
+    writeSnapshot("test_data/snapshots/trigrams.snap", trigrams);
+    EXPECT_THROW(mergeSnapshots({"test_data/snapshots/day0.snap", "test_data/snapshots/trigrams.snap"},
+                                "test_data/snapshots/bad.snap"),
+                 std::invalid_argument);
+    EXPECT_THROW(mergeSnapshots({}, "test_data/snapshots/bad.snap"), std::invalid_argument);
+}
+
+// Test PMI over snapshots of daily shards against PMI over the raw text
+TEST_F(NgramSnapshotTest, ScoresMergedSnapshots) {
+    std::ofstream("test_data/all.txt") << days[0] << days[1];
+
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 200;
+    options.minFreq = 2;
+    options.threads = 2;
+    PmiResult direct = core::calculatePmi("test_data/all.txt", "test_data/direct.tsv", options);
+
+    // Count each day once, keeping its snapshot
+    for (int day = 0; day < 2; ++day) {
+        std::string name = "test_data/day" + std::to_string(day);
+        std::ofstream(name + ".txt") << days[day];
+        options.snapshotPath = "test_data/snapshots/day" + std::to_string(day) + ".snap";
+        core::calculatePmi(name + ".txt", "null", options);
+        EXPECT_TRUE(isSnapshotFile(options.snapshotPath));
+    }
+
+    options.snapshotPath = "test_data/window.snap";
+    PmiResult merged = core::calculatePmiFromSnapshots(
+        {"test_data/snapshots/day0.snap", "test_data/snapshots/day1.snap"}, "test_data/merged.tsv", options);
+    EXPECT_EQ(direct.grams, merged.grams);
+    EXPECT_EQ(direct.distinctNgrams, merged.distinctNgrams);
+    EXPECT_EQ(readFile("test_data/direct.tsv"), readFile("test_data/merged.tsv"));
+    EXPECT_EQ(direct.grams, SnapshotReader("test_data/window.snap").entries());
+
+    // A directory of snapshots goes through the same path
+    options.snapshotPath.clear();
+    PmiResult fromDirectory = core::calculatePmi("test_data/snapshots", "test_data/dir.tsv", options);
+    EXPECT_EQ(readFile("test_data/direct.tsv"), readFile("test_data/dir.tsv"));
+    EXPECT_EQ(direct.grams, fromDirectory.grams);
+
+    // The merged window snapshot alone scores the same
+    core::calculatePmi("test_data/window.snap", "test_data/window.tsv", options);
+    EXPECT_EQ(readFile("test_data/direct.tsv"), readFile("test_data/window.tsv"));
+
+    options.allOrders = true;
+    EXPECT_THROW(core::calculatePmiFromSnapshots({"test_data/window.snap"}, "null", options), std::invalid_argument);
+    options.allOrders = false;
+    EXPECT_THROW(core::calculatePmiFiles({"test_data/window.snap", "test_data/all.txt"}, "null", options),
+                 std::invalid_argument);
+}
+
+// Test reducing hash partitions counted on two machines against one run over both shards
+TEST_F(NgramSnapshotTest, ReducesPartitionsAcrossMachines) {
+    std::ofstream("test_data/all.txt") << days[0] << days[1];
+
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 200;
+    options.minFreq = 2;
+    options.threads = 2;
+    options.allOrders = true;
+    core::calculatePmi("test_data/all.txt", "test_data/direct.tsv", options);
+    options.allOrders = false;
+
+    // Each "machine" counts its own day into three partitions
+    const uint32_t partitions = 3;
+    std::vector<std::string> marginals;
+    std::vector<std::string> allPartitions;
+    for (int day = 0; day < 2; ++day) {
+        std::string name = "test_data/node" + std::to_string(day);
+        std::ofstream("test_data/day" + std::to_string(day) + ".txt") << days[day];
+        options.snapshotPath = name + "/counts.snap";
+        options.snapshotPartitions = partitions;
+        core::calculatePmi("test_data/day" + std::to_string(day) + ".txt", "null", options);
+
+        marginals.push_back(marginalSnapshotPath(options.snapshotPath));
+        EXPECT_EQ(name + "/counts.marginals.snap", marginals.back());
+        SnapshotReader marginal(marginals.back());
+        EXPECT_EQ(1u, marginal.n());
+        for (uint32_t i = 0; i < partitions; ++i) {
+            allPartitions.push_back(partitionSnapshotPath(options.snapshotPath, i, partitions));
+            SnapshotReader reader(allPartitions.back());
+            EXPECT_EQ(i, reader.partition());
+            EXPECT_EQ(partitions, reader.partitionCount());
+            EXPECT_EQ(marginal.orderTotal(), reader.orderTotal());
+        }
+    }
+    EXPECT_EQ("test_data/node0/counts.part-1-of-3.snap", allPartitions[1]);
+    options.snapshotPath.clear();
+    options.snapshotPartitions = 1;
+
+    // Reducing every partition at once matches the single run
+    core::calculatePmiFromPartitions(allPartitions, marginals, "test_data/reduced.tsv", options);
+    EXPECT_EQ(readFile("test_data/direct.2gram.tsv"), readFile("test_data/reduced.tsv"));
+
+    // Partitions reduced one by one split the same n-grams between them
+    options.topK = 100000;
+    PmiResult everything = core::calculatePmiFromPartitions(allPartitions, marginals, "null", options);
+    size_t perPartition = 0;
+    for (uint32_t i = 0; i < partitions; ++i) {
+        PmiResult result = core::calculatePmiFromPartitions(
+            {allPartitions[i], allPartitions[partitions + i]}, marginals, "null", options);
+        EXPECT_GT(result.distinctNgrams, 0u);
+        perPartition += result.distinctNgrams;
+    }
+    EXPECT_EQ(everything.distinctNgrams, perPartition);
+
+    EXPECT_THROW(core::calculatePmiFromPartitions(allPartitions, {}, "null", options), std::invalid_argument);
+    EXPECT_THROW(core::calculatePmiFromPartitions(allPartitions, {allPartitions[0]}, "null", options),
+                 std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,114 @@
+/**
+ * @file ngram_stats_test.cpp
+ * @brief Tests for n-gram occurrence statistics
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/ngram_stats.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that counts, neighbour varieties and first occurrences come from one scan
+TEST(NgramStatsTest, GathersCountsNeighboursAndContexts) {
+    const std::string text = "xaby\nab\nzabab\naaa\n";
+    auto stats = gatherNgramStats(text, {"ab", "ba", "zz", "", "aa", "ab"}, 20, 1);
+    ASSERT_EQ(6u, stats.size());
+
+    // ab: after x, a line start, z and b; before y, a line end, a and a line end
+    EXPECT_EQ(4u, stats[0].count);
+    EXPECT_EQ(4u, stats[0].leftVariety);
+    EXPECT_EQ(3u, stats[0].rightVariety);
+    EXPECT_EQ(1u, stats[0].firstOffset);
+    EXPECT_EQ("xaby", stats[0].context);
+
+    EXPECT_EQ(1u, stats[1].count);
+    EXPECT_EQ(10u, stats[1].firstOffset);
+    EXPECT_EQ(0u, stats[2].count);
+    EXPECT_TRUE(stats[2].context.empty());
+    EXPECT_EQ(0u, stats[3].count);
+
+    // Overlapping occurrences count once, leftmost first, but all their neighbours are seen
+    EXPECT_EQ(1u, stats[4].count);
+    EXPECT_EQ(2u, stats[4].leftVariety);
+    EXPECT_EQ(2u, stats[4].rightVariety);
+    EXPECT_EQ(14u, stats[4].firstOffset);
+
+    // Duplicates get the statistics of their first copy
+    EXPECT_EQ(stats[0].count, stats[5].count);
+    EXPECT_EQ(stats[0].context, stats[5].context);
+}
+
+// Test that statistics gathered over parallel chunks match a sequential scan
+TEST(NgramStatsTest, ParallelChunksMatchSequential) {
+    const std::vector<std::string> words = {"東京", "大阪", "の", "天気", "は", "晴れ", "ab", " "};
+    std::mt19937 rng(11);
+    std::string text;
+    while (text.size() < (5u << 20)) {
+        size_t length = 1 + rng() % 20;
+        for (size_t i = 0; i < length; ++i) {
+            text += words[rng() % words.size()];
+        }
+        text += "\n";
+    }
+    std::vector<std::string_view> ngrams = {"東京", "の天", "晴れ\n", "b ", "はは", "大阪の天気"};
+
+    auto sequential = gatherNgramStats(text, ngrams, 20, 1);
+    auto parallel = gatherNgramStats(text, ngrams, 20, 4);
+    ASSERT_EQ(sequential.size(), parallel.size());
+    for (size_t i = 0; i < ngrams.size(); ++i) {
+        EXPECT_EQ(sequential[i].count, parallel[i].count) << ngrams[i];
+        EXPECT_EQ(sequential[i].leftVariety, parallel[i].leftVariety) << ngrams[i];
+        EXPECT_EQ(sequential[i].rightVariety, parallel[i].rightVariety) << ngrams[i];
+        EXPECT_EQ(sequential[i].firstOffset, parallel[i].firstOffset) << ngrams[i];
+        EXPECT_EQ(sequential[i].context, parallel[i].context) << ngrams[i];
+    }
+    EXPECT_GT(sequential[0].count, 0u);
+    // N-grams never span a newline
+    EXPECT_EQ(0u, sequential[2].count);
+}
+
+// Test that a statistics file loads back, without the rows it cannot hold
+TEST(NgramStatsTest, WritesAndLoadsStatisticsFile) {
+    const std::string path = "test_ngram_stats.tsv";
+    const std::string text = "東京\tの天気\n東京は晴れ\n";
+    std::vector<PmiItem> items = {{"東京", 3.0, 2}, {"\tの", 2.0, 1}, {"晴れ", 1.0, 1}, {"大阪", 0.5, 1}};
+    writeNgramStats(path, text, items, 2);
+
+    NgramStatsTable table(path);
+    EXPECT_EQ(text.size(), table.textBytes());
+    EXPECT_EQ(3u, table.size());
+    EXPECT_EQ(nullptr, table.find("\tの"));
+    EXPECT_EQ(nullptr, table.find("天気"));
+
+    const NgramStats* tokyo = table.find("東京");
+    ASSERT_NE(nullptr, tokyo);
+    EXPECT_EQ(2u, tokyo->count);
+    EXPECT_EQ(1u, tokyo->leftVariety);
+    EXPECT_EQ(2u, tokyo->rightVariety);
+    EXPECT_EQ(0u, tokyo->firstOffset);
+    // Contexts keep their tabs
+    EXPECT_EQ("東京\tの天気", tokyo->context);
+
+    const NgramStats* osaka = table.find("大阪");
+    ASSERT_NE(nullptr, osaka);
+    EXPECT_EQ(0u, osaka->count);
+
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "ngram\tpmi\tfrequency\n";
+    }
+    EXPECT_THROW(NgramStatsTable table(path), std::runtime_error);
+    EXPECT_THROW(NgramStatsTable table("non_existent_stats.tsv"), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,85 @@
+/**
+ * @file ngram_window_test.cpp
+ * @brief Tests for allocation-free UTF-8 decoding and n-gram windows
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/ngram_window.h"
+#include "core/text_utils.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::vector<std::string> windows(std::string_view line, uint32_t n) {
+    std::vector<std::string> result;
+    forEachNgram(line, n, [&](std::string_view window) { result.emplace_back(window); });
+    return result;
+}
+
+} // namespace
+
+// Test that decoding matches ICU, including ill-formed sequences
+TEST(NgramWindowTest, DecodesLikeIcu) {
+    const std::vector<std::string> samples = {
+        "plain ascii",
+        "東京都の天気は晴れ",
+        "emoji 😀 and é",
+        "\xFF\xFE lone bytes",
+        "truncated \xE3\x81",
+        "overlong \xC0\xAF and \xE0\x80\xAF",
+        "surrogate \xED\xA0\x80",
+        "too large \xF4\x90\x80\x80",
+        "cut four \xF0\x9F\x98",
+        "\x80\x80 continuation first",
+    };
+
+    for (const auto& sample : samples) {
+        std::string decoded;
+        forEachCodePoint(sample, [&](uint32_t cp) { appendUtf8(decoded, cp); });
+
+        std::string expected;
+        for (const auto& unigram : generateNgrams(sample, 1)) {
+            expected += unigram;
+        }
+        EXPECT_EQ(expected, decoded) << sample;
+    }
+}
+
+// Test that windows match generateNgrams() on valid text
+TEST(NgramWindowTest, MatchesGenerateNgrams) {
+    const std::string line = "東京と大阪 and 😀 京都";
+    for (uint32_t n = 1; n <= 5; ++n) {
+        EXPECT_EQ(generateNgrams(line, static_cast<int>(n)), windows(line, n)) << "n = " << n;
+    }
+
+    EXPECT_TRUE(windows("ab", 3).empty());
+    EXPECT_TRUE(windows("", 1).empty());
+    EXPECT_TRUE(windows("abc", 0).empty());
+
+    // Windows wider than the inline ring
+    std::string longLine(40, 'x');
+    auto wide = windows(longLine, 20);
+    ASSERT_EQ(21u, wide.size());
+    EXPECT_EQ(std::string(20, 'x'), wide.front());
+}
+
+// Test line splitting with std::getline semantics
+TEST(NgramWindowTest, SplitsLines) {
+    std::vector<std::string> lines;
+    forEachLine("one\n\ntwo\r\nthree\n", [&](std::string_view line) { lines.emplace_back(line); });
+    EXPECT_EQ((std::vector<std::string>{"one", "", "two\r", "three"}), lines);
+
+    lines.clear();
+    forEachLine("no newline", [&](std::string_view line) { lines.emplace_back(line); });
+    EXPECT_EQ((std::vector<std::string>{"no newline"}), lines);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -4,10 +4,17 @@
  */
 
 #include <gtest/gtest.h>
+#include <algorithm>
 #include <fstream>
 #include <filesystem>
+#include <random>
+#include <unordered_set>
 #include "core/normalize.h"
 
+#ifdef SUZUME_HAVE_ZLIB
+#include <zlib.h>
+#endif
+
 namespace suzume {
 namespace core {
 namespace test {
@@ -155,6 +162,481 @@ TEST_F(NormalizeTest, BatchProcessing) {
     EXPECT_EQ("hello world", result[1]);
 }
 
+// Test batch processing over views into one shared buffer
+TEST_F(NormalizeTest, BatchProcessingLineViews) {
+    const std::string buffer = "Hello World\nhello world\nＨｅｌｌｏ　Ｗｏｒｌｄ\n#comment line\na\n\nNew Line";
+    std::vector<std::string_view> views;
+    size_t start = 0;
+    while (start <= buffer.size()) {
+        size_t end = std::min(buffer.find('\n', start), buffer.size());
+        views.emplace_back(buffer.data() + start, end - start);
+        start = end + 1;
+    }
+    ASSERT_EQ(7, views.size());
+
+    // Two halves share one filter, so duplicates across them are dropped too
+    NormalizeOptions options;
+    ConcurrentDedupFilter uniqueFilter(options.bloomFalsePositiveRate);
+    std::vector<std::string> first = processBatch(views.data(), 3, options, uniqueFilter);
+    std::vector<std::string> second = processBatch(views.data() + 3, views.size() - 3, options, uniqueFilter);
+
+    ASSERT_EQ(1, first.size());
+    EXPECT_EQ("hello world", first[0]);
+    ASSERT_EQ(2, second.size());
+    EXPECT_EQ("#comment line", second[0]);
+    EXPECT_EQ("new line", second[1]);
+}
+
+// Test streaming normalization produces the same unique lines
+TEST_F(NormalizeTest, StreamingNormalization) {
+    NormalizeOptions options;
+    options.form = NormalizationForm::NFKC;
+    options.streaming = true;
+    options.threads = 2;
+
+    NormalizeResult result = core::normalize(
+        "test_data/normalize_test_input.tsv",
+        "test_data/normalize_test_output.tsv",
+        options
+    );
+
+    EXPECT_EQ(7, result.rows);
+    EXPECT_EQ(2, result.uniques);
+
+    std::ifstream outputFile("test_data/normalize_test_output.tsv");
+    std::string line;
+    std::vector<std::string> lines;
+    while (std::getline(outputFile, line)) {
+        lines.push_back(line);
+    }
+
+    ASSERT_EQ(2, lines.size());
+    EXPECT_TRUE(std::find(lines.begin(), lines.end(), "hello world") != lines.end());
+    EXPECT_TRUE(std::find(lines.begin(), lines.end(), "#comment line") != lines.end());
+}
+
+// Test streaming normalization with a tiny memory budget
+TEST_F(NormalizeTest, StreamingSmallMemoryBudget) {
+    {
+        std::ofstream inputFile("test_data/normalize_stream_input.tsv");
+        for (int i = 0; i < 5000; ++i) {
+            inputFile << "Line number " << (i % 1000) << "\n";
+        }
+    }
+
+    NormalizeOptions options;
+    options.streaming = true;
+    options.threads = 4;
+    options.maxMemoryUsage = 4096;
+
+    NormalizeResult result = core::normalize(
+        "test_data/normalize_stream_input.tsv",
+        "null",
+        options
+    );
+
+    EXPECT_EQ(5000, result.rows);
+    EXPECT_EQ(1000, result.uniques);
+}
+
+// Test that preserveOrder matches a single-threaded run line for line
+TEST_F(NormalizeTest, PreserveOrderMatchesSerial) {
+    {
+        std::ofstream inputFile("test_data/normalize_order_input.tsv");
+        for (int i = 0; i < 6000; ++i) {
+            // Repeats reach back across batch and chunk boundaries
+            inputFile << "Ordered Line " << ((i * 7919) % 2500) << "\n";
+        }
+    }
+
+    auto readLines = [](const std::string& path) {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    };
+
+    NormalizeOptions serial;
+    serial.threads = 1;
+    core::normalize("test_data/normalize_order_input.tsv", "test_data/normalize_order_serial.tsv", serial);
+    std::vector<std::string> expected = readLines("test_data/normalize_order_serial.tsv");
+    ASSERT_EQ(2500, expected.size());
+
+    for (bool streaming : {false, true}) {
+        NormalizeOptions options;
+        options.threads = 4;
+        options.streaming = streaming;
+        options.preserveOrder = true;
+        options.maxMemoryUsage = 16 * 1024;
+
+        NormalizeResult result = core::normalize(
+            "test_data/normalize_order_input.tsv", "test_data/normalize_order_parallel.tsv", options);
+        EXPECT_EQ(2500, result.uniques);
+        EXPECT_EQ(expected, readLines("test_data/normalize_order_parallel.tsv"));
+    }
+}
+
+// Test external dedup matches the in-memory result with a tiny budget
+TEST_F(NormalizeTest, ExternalDedupNormalization) {
+    {
+        std::ofstream inputFile("test_data/normalize_external_input.tsv");
+        for (int i = 0; i < 20000; ++i) {
+            inputFile << "External Line " << (i % 7000) << "\n";
+        }
+    }
+
+    NormalizeOptions options;
+    options.externalDedup = true;
+    options.threads = 4;
+    options.maxMemoryUsage = 64 * 1024;
+    options.tempDir = "test_data";
+
+    NormalizeResult result = core::normalize(
+        "test_data/normalize_external_input.tsv",
+        "test_data/normalize_external_output.tsv",
+        options
+    );
+
+    EXPECT_EQ(20000, result.rows);
+    EXPECT_EQ(7000, result.uniques);
+
+    std::ifstream outputFile("test_data/normalize_external_output.tsv");
+    std::unordered_set<std::string> lines;
+    std::string line;
+    while (std::getline(outputFile, line)) {
+        lines.insert(line);
+    }
+    EXPECT_EQ(7000, lines.size());
+    EXPECT_EQ(1, lines.count("External Line 6999"));
+
+    // The spill directory is removed once the run finishes
+    for (const auto& entry : std::filesystem::directory_iterator("test_data")) {
+        EXPECT_EQ(std::string::npos, entry.path().filename().string().find("suzume-dedup-"));
+    }
+
+    // A dedup index is an in-memory filter and cannot be combined
+    options.dedupIndexPath = "test_data/normalize_external.idx";
+    EXPECT_THROW(core::normalize("test_data/normalize_external_input.tsv", "null", options),
+                 std::invalid_argument);
+}
+
+// Test sorted output matches the default output sorted by bytes
+TEST_F(NormalizeTest, SortedOutputNormalization) {
+    {
+        std::ofstream inputFile("test_data/normalize_sorted_input.tsv");
+        for (int i = 0; i < 20000; ++i) {
+            inputFile << "Sorted Ｌｉｎｅ " << ((i * 7919) % 7000) << "\n";
+        }
+    }
+
+    auto readLines = [](const std::string& path) {
+        std::ifstream file(path);
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(file, line)) {
+            lines.push_back(line);
+        }
+        return lines;
+    };
+
+    NormalizeOptions options;
+    options.threads = 4;
+    core::normalize("test_data/normalize_sorted_input.tsv", "test_data/normalize_sorted_expected.tsv", options);
+    std::vector<std::string> expected = readLines("test_data/normalize_sorted_expected.tsv");
+    std::sort(expected.begin(), expected.end());
+
+    options.sortedOutput = true;
+    options.maxMemoryUsage = 64 * 1024;
+    options.tempDir = "test_data";
+    NormalizeResult result = core::normalize(
+        "test_data/normalize_sorted_input.tsv", "test_data/normalize_sorted_output.tsv", options);
+
+    EXPECT_EQ(20000, result.rows);
+    EXPECT_EQ(7000, result.uniques);
+    EXPECT_EQ(expected, readLines("test_data/normalize_sorted_output.tsv"));
+    for (const auto& entry : std::filesystem::directory_iterator("test_data")) {
+        EXPECT_EQ(std::string::npos, entry.path().filename().string().find("suzume-sort-"));
+    }
+
+    // Input order cannot be kept in sorted output
+    options.preserveOrder = true;
+    EXPECT_THROW(core::normalize("test_data/normalize_sorted_input.tsv", "null", options),
+                 std::invalid_argument);
+}
+
+// Test that near-duplicate detection drops lightly edited repeats
+TEST_F(NormalizeTest, NearDuplicateNormalization) {
+    {
+        std::ofstream inputFile("test_data/normalize_near_input.tsv");
+        // Distinct random posts, each followed by a copy with an extra character
+        std::mt19937 rng(42);
+        std::uniform_int_distribution<int> letter('a', 'z');
+        for (int i = 0; i < 200; ++i) {
+            std::string text;
+            for (int c = 0; c < 60; ++c) {
+                text += (c % 6 == 5) ? ' ' : static_cast<char>(letter(rng));
+            }
+            inputFile << text << "\n";
+            inputFile << text << "!\n";
+        }
+    }
+
+    for (bool streaming : {false, true}) {
+        NormalizeOptions options;
+        options.streaming = streaming;
+        options.threads = 2;
+
+        NormalizeResult exact = core::normalize("test_data/normalize_near_input.tsv", "null", options);
+        EXPECT_EQ(400, exact.uniques);
+
+        options.nearDupDistance = 6;
+        NormalizeResult near = core::normalize("test_data/normalize_near_input.tsv", "null", options);
+        EXPECT_EQ(400, near.rows);
+        EXPECT_LT(near.uniques, 300);
+        EXPECT_GE(near.uniques, 200);
+    }
+
+    NormalizeOptions options;
+    options.nearDupDistance = 32;
+    EXPECT_THROW(core::normalize("test_data/normalize_near_input.tsv", "null", options),
+                 std::invalid_argument);
+
+    options.nearDupDistance = 3;
+    options.externalDedup = true;
+    EXPECT_THROW(core::normalize("test_data/normalize_near_input.tsv", "null", options),
+                 std::invalid_argument);
+}
+
+// Test that sampled lines are fed straight into normalization
+TEST_F(NormalizeTest, SampledNormalization) {
+    {
+        std::ofstream inputFile("test_data/normalize_sample_input.tsv");
+        for (int i = 0; i < 1000; ++i) {
+            inputFile << "Sampled Line " << (i % 500) << "\n";
+        }
+    }
+
+    for (bool streaming : {false, true}) {
+        NormalizeOptions options;
+        options.streaming = streaming;
+        options.threads = 2;
+        options.sampleSize = 100;
+        options.sampleSeed = 7;
+
+        NormalizeResult result = core::normalize(
+            "test_data/normalize_sample_input.tsv",
+            "test_data/normalize_sample_output.tsv",
+            options
+        );
+        EXPECT_EQ(100, result.rows);
+        EXPECT_LE(result.uniques, 100);
+        EXPECT_GT(result.uniques, 80);
+
+        std::ifstream outputFile("test_data/normalize_sample_output.tsv");
+        std::string line;
+        size_t count = 0;
+        while (std::getline(outputFile, line)) {
+            EXPECT_EQ(0u, line.find("Sampled Line "));
+            count++;
+        }
+        EXPECT_EQ(result.uniques, count);
+    }
+
+    // A sample larger than the input keeps every line
+    NormalizeOptions options;
+    options.sampleSize = 5000;
+    NormalizeResult result = core::normalize("test_data/normalize_sample_input.tsv", "null", options);
+    EXPECT_EQ(1000, result.rows);
+    EXPECT_EQ(500, result.uniques);
+}
+
+// Test that several shard files share one dedup state
+TEST_F(NormalizeTest, MultiFileInput) {
+    std::filesystem::create_directories("test_data/shards");
+    for (int shard = 0; shard < 6; ++shard) {
+        std::ofstream shardFile("test_data/shards/part-" + std::to_string(shard) + ".tsv");
+        // Later shards are larger; each overlaps with the previous one
+        for (int i = shard * 100; i < shard * 100 + 100 + shard * 50; ++i) {
+            shardFile << "Shard Line " << i << "\n";
+        }
+    }
+
+    for (bool preserveOrder : {false, true}) {
+        NormalizeOptions options;
+        options.threads = 3;
+        options.preserveOrder = preserveOrder;
+
+        NormalizeResult result = core::normalize(
+            "test_data/shards", "test_data/shards_output.tsv", options);
+        EXPECT_EQ(1350, result.rows);
+        EXPECT_EQ(850, result.uniques);
+
+        std::ifstream outputFile("test_data/shards_output.tsv");
+        std::vector<std::string> lines;
+        std::string line;
+        while (std::getline(outputFile, line)) {
+            lines.push_back(line);
+        }
+        ASSERT_EQ(850, lines.size());
+        EXPECT_EQ(850, std::unordered_set<std::string>(lines.begin(), lines.end()).size());
+        if (preserveOrder) {
+            // Shards are written in path order, first occurrence first
+            for (size_t i = 0; i < lines.size(); ++i) {
+                EXPECT_EQ("Shard Line " + std::to_string(i), lines[i]);
+            }
+        }
+    }
+
+    // Globs and explicit lists give the same counts
+    NormalizeResult globbed = core::normalize("test_data/shards/part-*.tsv", "null");
+    EXPECT_EQ(850, globbed.uniques);
+
+    NormalizeResult listed = core::normalizeFiles(
+        {"test_data/shards/part-1.tsv", "test_data/shards/part-2.tsv"}, "null");
+    EXPECT_EQ(350, listed.rows);
+    EXPECT_EQ(300, listed.uniques);
+
+    EXPECT_THROW(core::normalizeFiles({"test_data/shards/part-0.tsv", "test_data/missing.tsv"}, "null"),
+                 std::runtime_error);
+}
+
+// Test that gzip input is decompressed transparently
+TEST_F(NormalizeTest, CompressedInput) {
+#ifdef SUZUME_HAVE_ZLIB
+    {
+        gzFile file = gzopen("test_data/normalize_compressed.tsv.gz", "wb");
+        ASSERT_NE(nullptr, file);
+        for (int i = 0; i < 2000; ++i) {
+            std::string line = "Compressed Line " + std::to_string(i % 1500) + "\n";
+            gzwrite(file, line.data(), static_cast<unsigned>(line.size()));
+        }
+        gzclose(file);
+    }
+
+    for (bool streaming : {false, true}) {
+        NormalizeOptions options;
+        options.streaming = streaming;
+        options.threads = 2;
+
+        NormalizeResult result = core::normalize(
+            "test_data/normalize_compressed.tsv.gz", "test_data/normalize_compressed_output.tsv", options);
+        EXPECT_EQ(2000, result.rows);
+        EXPECT_EQ(1500, result.uniques);
+
+        std::ifstream outputFile("test_data/normalize_compressed_output.tsv");
+        std::string line;
+        ASSERT_TRUE(std::getline(outputFile, line));
+        EXPECT_EQ(0u, line.find("Compressed Line "));
+    }
+
+    NormalizeOptions options;
+    options.sampleSize = 100;
+    NormalizeResult sampled = core::normalize("test_data/normalize_compressed.tsv.gz", "null", options);
+    EXPECT_EQ(100, sampled.rows);
+#else
+    GTEST_SKIP() << "Built without zlib";
+#endif
+}
+
+// Test that a persisted dedup index skips lines from earlier runs
+TEST_F(NormalizeTest, IncrementalDedupIndex) {
+    const std::string indexPath = "test_data/normalize_dedup.idx";
+    std::filesystem::remove(indexPath);
+
+    {
+        std::ofstream day1("test_data/normalize_day1.tsv");
+        for (int i = 0; i < 300; ++i) {
+            day1 << "Line number " << i << "\n";
+        }
+        std::ofstream day2("test_data/normalize_day2.tsv");
+        for (int i = 200; i < 500; ++i) {
+            day2 << "Line number " << i << "\n";
+        }
+    }
+
+    for (bool streaming : {false, true}) {
+        std::filesystem::remove(indexPath);
+
+        NormalizeOptions options;
+        options.streaming = streaming;
+        options.threads = 2;
+        options.dedupIndexPath = indexPath;
+
+        NormalizeResult first = core::normalize("test_data/normalize_day1.tsv", "null", options);
+        EXPECT_EQ(300, first.uniques);
+        EXPECT_TRUE(std::filesystem::exists(indexPath));
+        EXPECT_FALSE(std::filesystem::exists(indexPath + ".tmp"));
+
+        // Only the 200 lines not seen on day 1 are new
+        NormalizeResult second = core::normalize(
+            "test_data/normalize_day2.tsv", "test_data/normalize_day2_output.tsv", options);
+        EXPECT_EQ(300, second.rows);
+        EXPECT_EQ(200, second.uniques);
+
+        std::ifstream outputFile("test_data/normalize_day2_output.tsv");
+        std::string line;
+        std::vector<std::string> lines;
+        while (std::getline(outputFile, line)) {
+            lines.push_back(line);
+        }
+        EXPECT_EQ(200, lines.size());
+        EXPECT_TRUE(std::find(lines.begin(), lines.end(), "Line number 250") == lines.end());
+        EXPECT_TRUE(std::find(lines.begin(), lines.end(), "Line number 350") != lines.end());
+
+        // Re-running the same input adds nothing
+        NormalizeResult third = core::normalize("test_data/normalize_day2.tsv", "null", options);
+        EXPECT_EQ(0, third.uniques);
+    }
+
+    std::filesystem::remove(indexPath);
+}
+
+// Test normalizing selected columns and deduplicating on a key column
+TEST_F(NormalizeTest, ColumnsAndDedupKey) {
+    {
+        std::ofstream input("test_data/columns_input.tsv");
+        input << "ID-1\tＨｅｌｌｏ\thttps://Example.com/A\n";
+        input << "ID-2\thello\thttps://Example.com/B\n";
+        input << "ID-1\tOther text\thttps://Example.com/C\n";
+        input << "ID-3\tWorld\thttps://Example.com/D\n";
+    }
+
+    NormalizeOptions options;
+    options.threads = 1;
+    options.preserveOrder = true;
+    options.normalizeColumns = {2};
+    options.dedupColumns = {1};
+    NormalizeResult result = core::normalize("test_data/columns_input.tsv", "test_data/columns_output.tsv", options);
+    EXPECT_EQ(result.uniques, 3u);
+
+    std::ifstream output("test_data/columns_output.tsv");
+    std::vector<std::string> lines;
+    for (std::string line; std::getline(output, line);) {
+        lines.push_back(line);
+    }
+    ASSERT_EQ(lines.size(), 3u);
+    EXPECT_EQ(lines[0], "ID-1\thello\thttps://Example.com/A");
+    EXPECT_EQ(lines[1], "ID-2\thello\thttps://Example.com/B");
+    EXPECT_EQ(lines[2], "ID-3\tworld\thttps://Example.com/D");
+
+    // A key of several columns: ID-1 lines differ in column 2
+    options.dedupColumns = {1, 2};
+    result = core::normalize("test_data/columns_input.tsv", "test_data/columns_output.tsv", options);
+    EXPECT_EQ(result.uniques, 4u);
+
+    options.dedupColumns = {0};
+    EXPECT_THROW(core::normalize("test_data/columns_input.tsv", "test_data/columns_output.tsv", options),
+                 std::invalid_argument);
+    options.dedupColumns = {1};
+    options.preserveOrder = false;
+    options.externalDedup = true;
+    EXPECT_THROW(core::normalize("test_data/columns_input.tsv", "test_data/columns_output.tsv", options),
+                 std::invalid_argument);
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
@@ -0,0 +1,97 @@
+/**
+ * @file numa_topology_test.cpp
+ * @brief Tests for NUMA topology discovery and worker placement
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "core/numa_topology.h"
+#include "core/normalize.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// Test that kernel CPU lists expand ranges and reject malformed input
+TEST(NumaTopologyTest, ParsesCpuLists) {
+    EXPECT_EQ((std::vector<int>{0, 1, 2, 3, 8, 10, 11}), NumaTopology::parseCpuList("0-3,8,10-11\n"));
+    EXPECT_EQ((std::vector<int>{5}), NumaTopology::parseCpuList("5"));
+    EXPECT_TRUE(NumaTopology::parseCpuList("").empty());
+    EXPECT_THROW(NumaTopology::parseCpuList("3-1"), std::invalid_argument);
+    EXPECT_THROW(NumaTopology::parseCpuList("0,,2"), std::invalid_argument);
+    EXPECT_THROW(NumaTopology::parseCpuList("0-"), std::invalid_argument);
+
+    // Empty nodes are dropped; the system always has at least one node
+    NumaTopology topology({{}, {4, 5}});
+    EXPECT_EQ(1u, topology.nodeCount());
+    EXPECT_EQ((std::vector<int>{4, 5}), topology.cpus(0));
+    EXPECT_GE(NumaTopology::system().nodeCount(), 1u);
+    EXPECT_FALSE(NumaTopology::system().cpus(0).empty());
+}
+
+// Test that workers fill nodes in consecutive blocks and wrap around each node's CPUs
+TEST(NumaTopologyTest, PlacesWorkersInBlocks) {
+    NumaTopology topology({{0, 1, 2}, {64, 65, 66}});
+    WorkerPlacement placement(topology, 8);
+    ASSERT_EQ(2u, placement.groups().size());
+    EXPECT_EQ((std::vector<size_t>{0, 1, 2, 3}), placement.groups()[0]);
+    EXPECT_EQ((std::vector<size_t>{4, 5, 6, 7}), placement.groups()[1]);
+    EXPECT_EQ(0u, placement.nodeOf(3));
+    EXPECT_EQ(1u, placement.nodeOf(4));
+    EXPECT_EQ(0, placement.cpuOf(0));
+    EXPECT_EQ(0, placement.cpuOf(3));
+    EXPECT_EQ(64, placement.cpuOf(4));
+    EXPECT_EQ(66, placement.cpuOf(6));
+
+    // Fewer workers than nodes leaves the extra nodes without a group
+    WorkerPlacement single(topology, 1);
+    ASSERT_EQ(1u, single.groups().size());
+    EXPECT_EQ(0u, single.nodeOf(0));
+}
+
+// Test that NUMA-aware runs produce the same results as default runs
+TEST(NumaTopologyTest, NumaAwareRunsMatchDefault) {
+    std::string text;
+    for (int i = 0; i < 3000; ++i) {
+        text += "東京都の天気は晴れ\n大阪府の天気は雨\n京都府" + std::to_string(i % 37) + "\n";
+    }
+    std::filesystem::create_directories("test_data");
+    std::ofstream("test_data/numa_input.txt", std::ios::binary) << text;
+
+    PmiOptions pmiOptions;
+    pmiOptions.n = 2;
+    pmiOptions.topK = 100;
+    pmiOptions.minFreq = 1;
+    pmiOptions.threads = 4;
+    core::calculatePmi("test_data/numa_input.txt", "test_data/numa_default.tsv", pmiOptions);
+    pmiOptions.numaAware = true;
+    core::calculatePmi("test_data/numa_input.txt", "test_data/numa_aware.tsv", pmiOptions);
+    EXPECT_EQ(readFile("test_data/numa_default.tsv"), readFile("test_data/numa_aware.tsv"));
+
+    NormalizeOptions normalizeOptions;
+    normalizeOptions.threads = 4;
+    normalizeOptions.preserveOrder = true;
+    core::normalize("test_data/numa_input.txt", "test_data/numa_default_norm.tsv", normalizeOptions);
+    normalizeOptions.numaAware = true;
+    core::normalize("test_data/numa_input.txt", "test_data/numa_aware_norm.tsv", normalizeOptions);
+    EXPECT_EQ(readFile("test_data/numa_default_norm.tsv"), readFile("test_data/numa_aware_norm.tsv"));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,149 @@
+/**
+ * @file output_writer_test.cpp
+ * @brief Tests for buffered output
+ */
+
+#include <gtest/gtest.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include "core/compressed_input.h"
+#include "core/output_writer.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+} // namespace
+
+// Test that text, numbers and stream output land in order across buffer flushes
+TEST(OutputWriterTest, WritesAcrossBuffers) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/output_writer.txt";
+    std::string expected;
+    {
+        OutputWriter output(path, 64);
+        std::ostream stream(&output);
+        for (uint64_t i = 0; i < 1000; ++i) {
+            output.write("line\t");
+            output.writeNumber(i);
+            output.put('\t');
+            stream << "s" << i;
+            output.writeLine("");
+            expected += "line\t" + std::to_string(i) + "\ts" + std::to_string(i) + "\n";
+        }
+        std::string large(1000, 'x');
+        output.writeLine(large);
+        expected += large + "\n";
+        output.close();
+    }
+    EXPECT_EQ(expected, readFile(path));
+
+    EXPECT_THROW(OutputWriter("test_data/output_writer_missing/out.txt"), std::runtime_error);
+}
+
+// Test that a continued file keeps its first bytes and drops the rest
+TEST(OutputWriterTest, ContinuesAfterOffset) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/output_writer_continued.txt";
+    std::ofstream(path) << "kept\ndropped\n";
+    {
+        std::unique_ptr<OutputWriter> output = OutputWriter::continueAt(path, 5);
+        output->writeLine("added");
+        output->syncToDisk();
+        output->close();
+    }
+    EXPECT_EQ("kept\nadded\n", readFile(path));
+
+    EXPECT_THROW(OutputWriter::continueAt(path, 100), std::runtime_error);
+}
+
+// Test that doubles are written in a form that reads back exactly
+TEST(OutputWriterTest, DoublesRoundTrip) {
+    const std::string path = "test_data/output_writer_numbers.txt";
+    const double values[] = {0.0, 1.0, -2.5, 0.1, 1.0 / 3.0, 3.321928094887362, 1e-300, 123456789.125,
+                             std::numeric_limits<double>::max(), std::numeric_limits<double>::min()};
+    {
+        OutputWriter output(path, 64);
+        for (double value : values) {
+            output.writeNumber(value);
+            output.put('\n');
+        }
+        output.writeNumber(std::numeric_limits<uint64_t>::max());
+        output.put('\n');
+    }
+
+    std::istringstream lines(readFile(path));
+    std::string line;
+    for (double value : values) {
+        ASSERT_TRUE(std::getline(lines, line));
+        EXPECT_EQ(value, std::strtod(line.c_str(), nullptr)) << line;
+    }
+    ASSERT_TRUE(std::getline(lines, line));
+    EXPECT_EQ("18446744073709551615", line);
+}
+
+// Test that stdout output follows redirections of std::cout
+TEST(OutputWriterTest, WritesStdoutThroughCout) {
+    std::ostringstream captured;
+    std::streambuf* original = std::cout.rdbuf(captured.rdbuf());
+    {
+        OutputWriter output("-");
+        output.writeLine("hello");
+        output.writeNumber(0.5);
+        output.close();
+    }
+    std::cout.rdbuf(original);
+    EXPECT_EQ("hello\n0.5", captured.str());
+}
+
+#ifdef SUZUME_HAVE_ZSTD
+// Test that compressed output is written as several frames that read back as the text
+TEST(OutputWriterTest, WritesZstdFrames) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/output_writer.txt.zst";
+    EXPECT_TRUE(isCompressedOutputPath(path));
+    EXPECT_FALSE(isCompressedOutputPath("test_data/output_writer.txt"));
+
+    std::string expected;
+    {
+        OutputWriter output(path, 4096, true);
+        for (uint64_t i = 0; expected.size() < 2 * OutputWriter::kFrameSize + 1000; ++i) {
+            output.write("line\t");
+            output.writeNumber(i);
+            output.put('\n');
+            expected += "line\t" + std::to_string(i) + "\n";
+        }
+        output.close();
+    }
+
+    std::string compressed = readFile(path);
+    const std::string magic("\x28\xb5\x2f\xfd", 4);
+    size_t frames = 0;
+    for (size_t pos = compressed.find(magic); pos != std::string::npos; pos = compressed.find(magic, pos + 1)) {
+        frames++;
+    }
+    EXPECT_GE(frames, 3u);
+    EXPECT_LT(compressed.size(), expected.size());
+
+    EXPECT_EQ(Compression::Zstd, detectFileCompression(path));
+    std::unique_ptr<std::istream> input = openInputStream(path, 4);
+    EXPECT_EQ(expected, std::string(std::istreambuf_iterator<char>(*input), std::istreambuf_iterator<char>()));
+}
+#endif
+
+} // namespace test
+} // namespace core
+} // namespace suzume
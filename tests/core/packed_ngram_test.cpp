@@ -0,0 +1,251 @@
+/**
+ * @file packed_ngram_test.cpp
+ * @brief Tests for packed-key n-gram counting
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "core/pmi.h"
+#include "core/text_utils.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+// Reference counts through the ICU-based generateNgrams()
+std::unordered_map<std::string, uint32_t> referenceCounts(const std::string& text, int n) {
+    std::unordered_map<std::string, uint32_t> counts;
+    size_t start = 0;
+    while (start < text.size()) {
+        size_t end = text.find('\n', start);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        for (const auto& ngram : generateNgrams(text.substr(start, end - start), n)) {
+            counts[ngram]++;
+        }
+        start = end + 1;
+    }
+    return counts;
+}
+
+} // namespace
+
+// Test that packed counts match string-keyed counting
+TEST(PackedNgramTest, MatchesStringCounting) {
+    std::string text =
+        "東京都の天気は晴れ\n"
+        "Hello, world! 😀😀\r\n"
+        "\n"
+        "a\n"
+        "ab\n"
+        "bad \xFF bytes \xE3\x81 here\n"
+        "東京と大阪と東京";
+
+    for (uint32_t n = 1; n <= PackedNgramCounter::kMaxN; ++n) {
+        PackedNgramCounter counter(n);
+        counter.addText(text);
+        EXPECT_EQ(referenceCounts(text, static_cast<int>(n)), counter.toStringCounts()) << "n = " << n;
+    }
+}
+
+// Test that the fixed-size kernels give the packed windows of every line, including short ones
+TEST(PackedNgramTest, FixedSizeKernelsMatchWindows) {
+    const std::vector<std::string> lines = {"", "a", "ab", "東京都の天気", "x\xFFy\xE3\x81z", "😀😀😀😀"};
+    for (const std::string& line : lines) {
+        for (uint32_t n = 1; n <= PackedNgramCounter::kMaxN; ++n) {
+            std::vector<uint64_t> expected;
+            forEachNgram(line, n, [&](std::string_view window) {
+                uint64_t key = 0;
+                ASSERT_TRUE(PackedNgramCounter::pack(window, n, key));
+                expected.push_back(key);
+            });
+            std::vector<uint64_t> actual;
+            dispatchNgramSize(n, [&](auto size) {
+                PackedNgramCounter::forEachKey<decltype(size)::value>(line, [&](uint64_t key) {
+                    actual.push_back(key);
+                });
+            });
+            EXPECT_EQ(expected, actual) << "n = " << n << ", line = " << line;
+        }
+    }
+
+    EXPECT_THROW(dispatchNgramSize(0, [](auto) {}), std::invalid_argument);
+    EXPECT_THROW(dispatchNgramSize(4, [](auto) {}), std::invalid_argument);
+}
+
+// Test packing, decoding and lookups
+TEST(PackedNgramTest, PacksAndDecodes) {
+    uint64_t key = 0;
+    ASSERT_TRUE(PackedNgramCounter::pack("東京😀", 3, key));
+    EXPECT_EQ("東京😀", PackedNgramCounter::decode(key, 3));
+    EXPECT_EQ(0x6771u, PackedNgramCounter::codePoint(key, 3, 0));
+    EXPECT_EQ(0x4EACu, PackedNgramCounter::codePoint(key, 3, 1));
+    EXPECT_EQ(0x1F600u, PackedNgramCounter::codePoint(key, 3, 2));
+
+    EXPECT_FALSE(PackedNgramCounter::pack("東京", 3, key));
+    EXPECT_FALSE(PackedNgramCounter::pack("abcd", 3, key));
+
+    PackedNgramCounter counter(2);
+    counter.addText("abab\nab");
+    ASSERT_TRUE(PackedNgramCounter::pack("ab", 2, key));
+    EXPECT_EQ(3u, counter.count(key));
+    ASSERT_TRUE(PackedNgramCounter::pack("ba", 2, key));
+    EXPECT_EQ(1u, counter.count(key));
+    ASSERT_TRUE(PackedNgramCounter::pack("bb", 2, key));
+    EXPECT_EQ(0u, counter.count(key));
+
+    EXPECT_THROW(PackedNgramCounter(0), std::invalid_argument);
+    EXPECT_THROW(PackedNgramCounter(4), std::invalid_argument);
+}
+
+// Test table growth and merging
+TEST(PackedNgramTest, GrowsAndMerges) {
+    PackedNgramCounter first(1);
+    PackedNgramCounter second(1);
+    // Enough distinct code points to force several rehashes
+    for (uint32_t c = 0x4E00; c < 0x4E00 + 20000; ++c) {
+        first.add(c, 1);
+        if (c % 2 == 0) {
+            second.add(c, 2);
+        }
+    }
+    EXPECT_EQ(20000u, first.size());
+
+    first.merge(second);
+    EXPECT_EQ(20000u, first.size());
+    EXPECT_EQ(3u, first.count(0x4E00));
+    EXPECT_EQ(1u, first.count(0x4E01));
+    EXPECT_GE(first.memoryUsage(), first.size() * 12);
+
+    PackedNgramCounter bigrams(2);
+    EXPECT_THROW(bigrams.merge(first), std::invalid_argument);
+}
+
+// Test that partitioned worker tables merge to the same counts
+TEST(PackedNgramTest, MergesPartitionedTables) {
+    std::vector<std::string> chunks;
+    for (int t = 0; t < 4; ++t) {
+        std::string chunk;
+        for (int i = 0; i < 500; ++i) {
+            chunk += "東京" + std::to_string((i * 7 + t) % 113) + "の天気と大阪\n";
+        }
+        chunks.push_back(chunk);
+    }
+
+    PackedNgramCounter reference(2);
+    std::vector<PartitionedNgramCounter> tables;
+    for (const auto& chunk : chunks) {
+        reference.addText(chunk);
+        tables.emplace_back(2, 3);
+        tables.back().addText(chunk);
+    }
+
+    PartitionedNgramCounter merged = PartitionedNgramCounter::mergeAll(std::move(tables), 3);
+    ASSERT_EQ(3u, merged.partitionCount());
+    EXPECT_EQ(reference.size(), merged.size());
+    reference.forEach([&](uint64_t key, uint32_t count) { EXPECT_EQ(count, merged.count(key)); });
+
+    // Partitions hold disjoint keys
+    size_t total = 0;
+    for (size_t i = 0; i < merged.partitionCount(); ++i) {
+        total += merged.partition(i).size();
+        EXPECT_GT(merged.partition(i).size(), 0u);
+    }
+    EXPECT_EQ(reference.size(), total);
+
+    std::vector<PmiItem> fromMerged = calculatePmiScores(merged, 1, 10);
+    std::vector<PmiItem> fromReference = calculatePmiScores(reference, 1, 10);
+    ASSERT_EQ(fromReference.size(), fromMerged.size());
+    for (size_t i = 0; i < fromMerged.size(); ++i) {
+        EXPECT_EQ(fromReference[i].ngram, fromMerged[i].ngram);
+        EXPECT_DOUBLE_EQ(fromReference[i].score, fromMerged[i].score);
+    }
+
+    std::vector<PartitionedNgramCounter> mismatched;
+    mismatched.emplace_back(2, 3);
+    mismatched.emplace_back(2, 4);
+    EXPECT_THROW(PartitionedNgramCounter::mergeAll(std::move(mismatched), 2), std::invalid_argument);
+    EXPECT_THROW(PartitionedNgramCounter::mergeAll({}, 2), std::invalid_argument);
+    EXPECT_THROW(PartitionedNgramCounter(2, 0), std::invalid_argument);
+}
+
+// Test that one multi-order pass counts every order like separate passes
+TEST(PackedNgramTest, CountsAllOrdersInOnePass) {
+    std::string text;
+    for (int i = 0; i < 300; ++i) {
+        text += "東京" + std::to_string(i % 17) + "の天気 😀\n";
+    }
+    text += "a\nab\n";
+
+    std::vector<MultiOrderNgramCounter> workers;
+    size_t half = text.find('\n', text.size() / 2) + 1;
+    workers.emplace_back(1, 3, 2, text.size());
+    workers.emplace_back(1, 3, 2, text.size());
+    workers[0].addText(std::string_view(text).substr(0, half));
+    workers[1].addText(std::string_view(text).substr(half));
+    MultiOrderNgramCounter merged = MultiOrderNgramCounter::mergeAll(std::move(workers), 2);
+
+    ASSERT_EQ(1u, merged.minOrder());
+    ASSERT_EQ(3u, merged.maxOrder());
+    for (uint32_t n = 1; n <= 3; ++n) {
+        PackedNgramCounter reference(n);
+        reference.addText(text);
+        EXPECT_EQ(reference.size(), merged.order(n).size()) << "n = " << n;
+        reference.forEach([&](uint64_t key, uint32_t count) { EXPECT_EQ(count, merged.order(n).count(key)); });
+    }
+
+    // Unigram marginals: P(ab) = 2/3, P(a) = 3/6, P(b) = 2/6
+    MultiOrderNgramCounter small(1, 2, 1);
+    small.addText("ab\nab\nac\n");
+    std::vector<PmiItem> scores = calculatePmiScores(small.order(2), small.order(1), 1, 10);
+    ASSERT_EQ(2u, scores.size());
+    EXPECT_EQ("ab", scores[0].ngram);
+    EXPECT_DOUBLE_EQ(2.0, scores[0].score);
+    EXPECT_THROW(calculatePmiScores(small.order(2), small.order(2), 1, 10), std::invalid_argument);
+
+    EXPECT_THROW(MultiOrderNgramCounter(0, 2, 1), std::invalid_argument);
+    EXPECT_THROW(MultiOrderNgramCounter(3, 2, 1), std::invalid_argument);
+    EXPECT_THROW(MultiOrderNgramCounter(1, 4, 1), std::invalid_argument);
+
+    std::vector<MultiOrderNgramCounter> mismatched;
+    mismatched.emplace_back(1, 2, 1);
+    mismatched.emplace_back(2, 2, 1);
+    EXPECT_THROW(MultiOrderNgramCounter::mergeAll(std::move(mismatched), 1), std::invalid_argument);
+}
+
+// Test that packed PMI scoring matches the string-keyed scores
+TEST(PackedNgramTest, ScoresMatchStringScoring) {
+    std::string text;
+    for (int i = 0; i < 200; ++i) {
+        text += "東京都の天気は晴れ " + std::to_string(i % 13) + " 大阪と京都\n";
+    }
+
+    PackedNgramCounter counter(2);
+    counter.addText(text);
+    std::vector<PmiItem> packed = calculatePmiScores(counter, 3, 20);
+    ASSERT_EQ(20u, packed.size());
+
+    std::unordered_map<std::string, double> expected;
+    for (const auto& item : calculatePmiScores(countNgrams(text, 2), 2, 3)) {
+        expected[item.ngram] = item.score;
+    }
+    for (size_t i = 0; i < packed.size(); ++i) {
+        ASSERT_EQ(1u, expected.count(packed[i].ngram)) << packed[i].ngram;
+        EXPECT_NEAR(expected[packed[i].ngram], packed[i].score, 1e-9);
+        if (i > 0) {
+            EXPECT_GE(packed[i - 1].score, packed[i].score);
+        }
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,116 @@
+/**
+ * @file pipeline_test.cpp
+ * @brief Tests for the in-memory pipeline
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "core/normalize.h"
+#include "core/pipeline.h"
+#include "core/pmi.h"
+#include "core/word_extraction.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class PipelineTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "suzume_pipeline_test";
+        std::filesystem::create_directories(dir_);
+        inputPath_ = (dir_ / "input.txt").string();
+
+        // Repeated phrases, with duplicate lines and full-width forms for normalization
+        const char* phrases[] = {"人工知能", "機械学習", "深層学習", "自然言語処理", "ＡＩ研究"};
+        std::ofstream file(inputPath_);
+        for (int i = 0; i < 300; ++i) {
+            file << phrases[i % 5] << "の" << phrases[(i * 3 + 1) % 5] << "について" << (i % 40) << "\n";
+        }
+        file << "人工知能の機械学習について0\n";
+        file.close();
+
+        options_.normalize.threads = 1;
+        options_.pmi.n = 2;
+        options_.pmi.minFreq = 2;
+        options_.pmi.topK = 500;
+        options_.wordExtraction.minPmiScore = 0.5;
+        options_.wordExtraction.topK = 50;
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::filesystem::path dir_;
+    std::string inputPath_;
+    PipelineOptions options_;
+};
+
+// Test that the pipeline gives the same words as the three file-based stages
+TEST_F(PipelineTest, MatchesFileBasedStages) {
+    std::string normalizedPath = (dir_ / "normalized.tsv").string();
+    std::string pmiPath = (dir_ / "pmi.tsv").string();
+    NormalizeResult normalized = core::normalize(inputPath_, normalizedPath, options_.normalize);
+    PmiResult pmi = core::calculatePmi(normalizedPath, pmiPath, options_.pmi);
+    WordExtractionResult expected = core::extractWords(pmiPath, normalizedPath, options_.wordExtraction);
+    ASSERT_FALSE(expected.words.empty());
+
+    PipelineResult result = core::runPipeline(inputPath_, options_);
+    EXPECT_EQ(result.normalize.rows, normalized.rows);
+    EXPECT_EQ(result.normalize.uniques, normalized.uniques);
+    EXPECT_EQ(result.pmi.grams, pmi.grams);
+    EXPECT_EQ(result.pmi.distinctNgrams, pmi.distinctNgrams);
+    EXPECT_EQ(result.words.words, expected.words);
+    EXPECT_EQ(result.words.frequencies, expected.frequencies);
+    EXPECT_EQ(result.words.contexts, expected.contexts);
+    ASSERT_EQ(result.words.scores.size(), expected.scores.size());
+    for (size_t i = 0; i < expected.scores.size(); ++i) {
+        EXPECT_DOUBLE_EQ(result.words.scores[i], expected.scores[i]);
+    }
+}
+
+// Test that progress rises to 1.0 and that file-based options are rejected
+TEST_F(PipelineTest, ReportsProgressAndRejectsFileOptions) {
+    std::vector<double> ratios;
+    options_.progressCallback = [&ratios](double ratio) {
+        ratios.push_back(ratio);
+    };
+    core::runPipeline(inputPath_, options_);
+    ASSERT_FALSE(ratios.empty());
+    for (size_t i = 1; i < ratios.size(); ++i) {
+        EXPECT_GE(ratios[i], ratios[i - 1]);
+    }
+    EXPECT_DOUBLE_EQ(ratios.back(), 1.0);
+
+    PipelineOptions streaming = options_;
+    streaming.normalize.streaming = true;
+    EXPECT_THROW(core::runPipeline(inputPath_, streaming), std::invalid_argument);
+
+    PipelineOptions allOrders = options_;
+    allOrders.pmi.allOrders = true;
+    EXPECT_THROW(core::runPipeline(inputPath_, allOrders), std::invalid_argument);
+}
+
+// Test that the word list is written as TSV
+TEST_F(PipelineTest, WritesWordList) {
+    WordExtractionResult words;
+    words.words = {"人工知能", "機械学習"};
+    words.scores = {1.5, 0.25};
+    words.frequencies = {10, 3};
+    words.contexts = {"", ""};
+
+    std::string outputPath = (dir_ / "words.tsv").string();
+    writeWordList(words, outputPath);
+
+    std::ifstream file(outputPath);
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(content, "人工知能\t1.5\t10\n機械学習\t0.25\t3\n");
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
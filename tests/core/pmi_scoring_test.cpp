@@ -0,0 +1,118 @@
+/**
+ * @file pmi_scoring_test.cpp
+ * @brief Tests for columnar PMI scoring
+ */
+
+#include <gtest/gtest.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "core/pmi_scoring.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+uint64_t bigram(uint32_t first, uint32_t second) {
+    return (static_cast<uint64_t>(first) << 21) | second;
+}
+
+} // namespace
+
+// Test that code points get dense IDs and flat probabilities
+TEST(MarginalTableTest, AssignsDenseIds) {
+    MarginalTable marginals;
+    marginals.add(0x6771, 3);
+    marginals.add(0x20B9F, 1);  // outside the BMP
+    marginals.add(0x6771, 1);
+    marginals.finish(marginals.sum());
+
+    EXPECT_EQ(2u, marginals.size());
+    EXPECT_EQ(5u, marginals.sum());
+    EXPECT_EQ(1u, marginals.id(0x6771));
+    EXPECT_EQ(2u, marginals.id(0x20B9F));
+    EXPECT_EQ(0u, marginals.id(0x4EAC));
+    EXPECT_EQ(4u, marginals.count(0x6771));
+    EXPECT_EQ(0u, marginals.count(0x4EAC));
+
+    const double* probabilities = marginals.probabilities();
+    EXPECT_DOUBLE_EQ(0.0, probabilities[0]);
+    EXPECT_DOUBLE_EQ(0.8, probabilities[1]);
+    EXPECT_DOUBLE_EQ(0.2, probabilities[2]);
+}
+
+// Test that block scoring matches scoring one n-gram at a time across blocks
+TEST(PmiBlockScorerTest, MatchesScalarScoring) {
+    MarginalTable marginals;
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    uint64_t total = 0;
+    for (uint32_t i = 0; i < 3 * PmiBlockScorer<2>::kBlockSize + 7; ++i) {
+        uint32_t first = 0x4E00 + i % 97;
+        uint32_t second = 0x4E00 + (i * 7) % 89;
+        uint64_t count = 1 + i % 13;
+        entries.emplace_back(bigram(first, second), count);
+        marginals.add(first, count);
+        marginals.add(second, count);
+        total += count;
+    }
+    marginals.finish(total);
+
+    const size_t k = entries.size();
+    ScoredKeySelector selector(k);
+    PmiBlockScorer<2> scorer(marginals, total, selector);
+    for (const auto& [key, count] : entries) {
+        scorer.add(key, count);
+    }
+    scorer.finish();
+    std::vector<ScoredKey> actual = selector.take();
+    ASSERT_EQ(k, actual.size());
+
+    ScoredKeySelector reference(k);
+    for (const auto& [key, count] : entries) {
+        double jointProb = static_cast<double>(count) / total;
+        double product = 1.0;
+        for (uint32_t i = 0; i < 2; ++i) {
+            product *= static_cast<double>(marginals.count(PackedNgramCounter::codePoint(key, 2, i))) / total;
+        }
+        reference.push({key, std::log2(jointProb / product), static_cast<uint32_t>(count)});
+    }
+    std::vector<ScoredKey> expected = reference.take();
+    for (size_t i = 0; i < k; ++i) {
+        EXPECT_EQ(expected[i].key, actual[i].key);
+        EXPECT_EQ(expected[i].score, actual[i].score);
+        EXPECT_EQ(expected[i].frequency, actual[i].frequency);
+    }
+}
+
+// Test that n-grams with an unknown component are skipped and unigrams score by frequency
+TEST(PmiBlockScorerTest, SkipsUnknownComponents) {
+    MarginalTable marginals;
+    marginals.add(0x6771, 2);
+    marginals.add(0x4EAC, 2);
+    marginals.finish(4);
+
+    ScoredKeySelector selector(10);
+    PmiBlockScorer<2> scorer(marginals, 4, selector);
+    scorer.add(bigram(0x6771, 0x4EAC), 2);
+    scorer.add(bigram(0x6771, 0x90FD), 2);
+    scorer.finish();
+    std::vector<ScoredKey> scored = selector.take();
+    ASSERT_EQ(1u, scored.size());
+    EXPECT_EQ(bigram(0x6771, 0x4EAC), scored[0].key);
+    EXPECT_DOUBLE_EQ(1.0, scored[0].score);
+
+    ScoredKeySelector unigrams(10);
+    PmiBlockScorer<1> unigramScorer(marginals, 4, unigrams);
+    unigramScorer.add(0x6771, 7);
+    unigramScorer.finish();
+    scored = unigrams.take();
+    ASSERT_EQ(1u, scored.size());
+    EXPECT_DOUBLE_EQ(7.0, scored[0].score);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
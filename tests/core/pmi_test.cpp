@@ -4,10 +4,14 @@
  */
 
 #include <gtest/gtest.h>
+#include <cstdlib>
 #include <fstream>
 #include <filesystem>
 #include <iostream>
 #include "core/pmi.h"
+#include "core/gpu_counter.h"
+#include "core/ngram_stats.h"
+#include "core/pmi_results.h"
 
 namespace suzume {
 namespace core {
@@ -312,6 +316,231 @@ TEST_F(PmiTest, NgramCounting) {
     EXPECT_TRUE(!counts.empty());
 }
 
+// Test that PMI over several files matches PMI over their concatenation
+TEST_F(PmiTest, MultiFileInput) {
+    std::filesystem::create_directories("test_data/pmi_shards");
+    std::ofstream combined("test_data/pmi_combined.txt");
+    for (int shard = 0; shard < 4; ++shard) {
+        std::ofstream shardFile("test_data/pmi_shards/part-" + std::to_string(shard) + ".txt");
+        for (int i = 0; i < 50 + shard * 20; ++i) {
+            std::string line = "東京都の天気は晴れ " + std::to_string(i % 7) + " 大阪";
+            shardFile << line << "\n";
+            combined << line << "\n";
+        }
+    }
+    combined.close();
+
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 50;
+    options.minFreq = 2;
+
+    options.threads = 3;
+    PmiResult single = core::calculatePmi("test_data/pmi_combined.txt", "test_data/pmi_single.tsv", options);
+    PmiResult sharded = core::calculatePmi("test_data/pmi_shards", "test_data/pmi_sharded.tsv", options);
+
+    EXPECT_GT(single.grams, 0);
+    EXPECT_EQ(single.grams, sharded.grams);
+    EXPECT_EQ(single.distinctNgrams, sharded.distinctNgrams);
+
+    PmiResult listed = core::calculatePmiFiles(
+        {"test_data/pmi_shards/part-0.txt", "test_data/pmi_shards/part-*.txt"}, "null", options);
+    EXPECT_EQ(single.grams, listed.grams);
+}
+
+// Test that mapped input counts the same on any number of threads
+TEST_F(PmiTest, MappedInputSplitsAtLines) {
+    // Large enough for parallel counting, with no trailing newline
+    {
+        std::ofstream inputFile("test_data/pmi_mapped.txt", std::ios::binary);
+        for (int i = 0; i < 2000; ++i) {
+            inputFile << "東京都の天気は晴れ " << (i % 11) << " 大阪と京都";
+            if (i + 1 < 2000) {
+                inputFile << "\n";
+            }
+        }
+    }
+    std::ofstream("test_data/pmi_empty.txt").close();
+
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 100;
+    options.minFreq = 1;
+
+    auto readFile = [](const std::string& path) {
+        std::ifstream file(path);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+
+    options.threads = 1;
+    PmiResult serial = core::calculatePmi("test_data/pmi_mapped.txt", "test_data/pmi_mapped_1.tsv", options);
+    for (uint32_t threads : {2u, 3u, 7u}) {
+        options.threads = threads;
+        std::string outputPath = "test_data/pmi_mapped_" + std::to_string(threads) + ".tsv";
+        PmiResult parallel = core::calculatePmi("test_data/pmi_mapped.txt", outputPath, options);
+        EXPECT_EQ(serial.grams, parallel.grams) << threads << " threads";
+        EXPECT_EQ(readFile("test_data/pmi_mapped_1.tsv"), readFile(outputPath)) << threads << " threads";
+    }
+
+    // Empty files cannot be mapped and fall back to reading
+    PmiResult empty = core::calculatePmi("test_data/pmi_empty.txt", "null", options);
+    EXPECT_EQ(0u, empty.grams);
+}
+
+// Test counting every order in one pass
+TEST_F(PmiTest, AllOrdersInOnePass) {
+    PmiOptions options;
+    options.n = 3;
+    options.topK = 50;
+    options.minFreq = 1;
+    options.threads = 2;
+    options.allOrders = true;
+
+    PmiResult result = core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_orders.tsv", options);
+    ASSERT_EQ(3u, result.orders.size());
+    for (uint32_t n = 1; n <= 3; ++n) {
+        const PmiOrderResult& order = result.orders[n - 1];
+        EXPECT_EQ(n, order.n);
+        EXPECT_GT(order.grams, 0u);
+        EXPECT_EQ("test_data/pmi_orders." + std::to_string(n) + "gram.tsv", order.outputPath);
+        EXPECT_TRUE(std::filesystem::exists(order.outputPath));
+    }
+    EXPECT_EQ(result.orders.back().grams, result.grams);
+    EXPECT_FALSE(std::filesystem::exists("test_data/pmi_orders.tsv"));
+
+    // Unigrams and the n-gram tables match single-order runs
+    auto readFile = [](const std::string& path) {
+        std::ifstream file(path);
+        return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    };
+    options.allOrders = false;
+    for (uint32_t n = 1; n <= 3; ++n) {
+        options.n = n;
+        PmiResult single = core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_single_order.tsv", options);
+        EXPECT_EQ(single.grams, result.orders[n - 1].grams);
+        EXPECT_TRUE(single.orders.empty());
+        if (n == 1) {
+            EXPECT_EQ(readFile("test_data/pmi_single_order.tsv"), readFile(result.orders[0].outputPath));
+        }
+    }
+}
+
+// Test approximate counting through the file API
+TEST_F(PmiTest, ApproximateCounting) {
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 10;
+    options.minFreq = 1;
+    options.approximate = true;
+    options.sketchWidth = 4096;
+
+    PmiResult result = core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_approx.tsv", options);
+    EXPECT_GT(result.grams, 0u);
+    EXPECT_GT(result.distinctNgrams, 0u);
+    EXPECT_LE(result.distinctNgrams, 10u);
+    EXPECT_GT(result.countErrorBound, 0u);
+    EXPECT_GT(result.errorProbability, 0.0);
+    EXPECT_TRUE(std::filesystem::exists("test_data/pmi_approx.tsv"));
+
+    options.allOrders = true;
+    EXPECT_THROW(core::calculatePmi("test_data/pmi_test_input.txt", "null", options), std::invalid_argument);
+    options.allOrders = false;
+    options.sketchDepth = 0;
+    EXPECT_THROW(core::calculatePmi("test_data/pmi_test_input.txt", "null", options), std::invalid_argument);
+}
+
+// Test that binary results hold exactly what the TSV output holds
+TEST_F(PmiTest, WritesBinaryResults) {
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 50;
+    options.minFreq = 1;
+    options.binaryOutputPath = "test_data/pmi_binary.pmi";
+
+    PmiResult result = core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_binary.tsv", options);
+    PmiResultsReader reader(options.binaryOutputPath);
+    EXPECT_EQ(2u, reader.n());
+    ASSERT_EQ(result.distinctNgrams, reader.size());
+
+    std::ifstream tsv("test_data/pmi_binary.tsv");
+    std::string line;
+    std::getline(tsv, line);
+    for (size_t i = 0; i < reader.size(); ++i) {
+        ASSERT_TRUE(std::getline(tsv, line));
+        size_t first = line.find('\t');
+        size_t second = line.find('\t', first + 1);
+        EXPECT_EQ(line.substr(0, first), reader.ngram(i));
+        // TSV scores are written in round-trip form, so they match bit for bit
+        EXPECT_EQ(std::strtod(line.c_str() + first + 1, nullptr), reader.score(i));
+        EXPECT_EQ(std::stoul(line.substr(second + 1)), reader.frequency(i));
+    }
+}
+
+// Test that the statistics file covers every result, counted in the input
+TEST_F(PmiTest, WritesNgramStats) {
+    PmiOptions options;
+    options.n = 2;
+    options.topK = 50;
+    options.minFreq = 1;
+    options.statsOutputPath = "test_data/pmi_stats.tsv";
+
+    core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_stats_results.tsv", options);
+    NgramStatsTable table(options.statsOutputPath);
+    EXPECT_EQ(std::filesystem::file_size("test_data/pmi_test_input.txt"), table.textBytes());
+
+    std::ifstream tsv("test_data/pmi_stats_results.tsv");
+    std::string line;
+    std::getline(tsv, line);
+    size_t rows = 0;
+    while (std::getline(tsv, line)) {
+        std::string ngram = line.substr(0, line.find('\t'));
+        const NgramStats* stats = table.find(ngram);
+        ASSERT_NE(nullptr, stats) << ngram;
+        EXPECT_GT(stats->count, 0u) << ngram;
+        EXPECT_NE(std::string::npos, stats->context.find(ngram)) << ngram;
+        rows++;
+    }
+    EXPECT_EQ(rows, table.size());
+
+    // Statistics need the input text and one order of n-grams
+    options.allOrders = true;
+    EXPECT_THROW(core::calculatePmi("test_data/pmi_test_input.txt", "null", options), std::invalid_argument);
+    options.allOrders = false;
+    EXPECT_THROW(core::calculatePmi("-", "null", options), std::invalid_argument);
+}
+
+// Test that GPU counting gives the CPU results, or is refused where it is not available
+TEST_F(PmiTest, GpuCountingMatchesCpu) {
+    PmiOptions options;
+    options.n = 3;
+    options.topK = 50;
+    options.minFreq = 1;
+    options.countingBackend = CountingBackend::Gpu;
+
+    // The device counts exactly, so sketches and budgets do not apply
+    options.approximate = true;
+    EXPECT_THROW(core::calculatePmi("test_data/pmi_test_input.txt", "null", options), std::invalid_argument);
+    options.approximate = false;
+
+    if (!core::gpuCountingAvailable()) {
+        EXPECT_THROW(core::calculatePmi("test_data/pmi_test_input.txt", "null", options), std::runtime_error);
+        GTEST_SKIP() << "No CUDA device";
+    }
+    core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_gpu_results.tsv", options);
+    options.countingBackend = CountingBackend::Cpu;
+    core::calculatePmi("test_data/pmi_test_input.txt", "test_data/pmi_cpu_results.tsv", options);
+
+    std::ifstream gpu("test_data/pmi_gpu_results.tsv");
+    std::ifstream cpu("test_data/pmi_cpu_results.tsv");
+    std::string gpuLine;
+    std::string cpuLine;
+    while (std::getline(cpu, cpuLine)) {
+        ASSERT_TRUE(std::getline(gpu, gpuLine));
+        EXPECT_EQ(cpuLine, gpuLine);
+    }
+    EXPECT_FALSE(std::getline(gpu, gpuLine));
+}
+
 // Test PMI score calculation
 TEST_F(PmiTest, PmiScoreCalculation) {
     // Create n-gram counts
@@ -0,0 +1,138 @@
+/**
+ * @file progress_reporter_test.cpp
+ * @brief Tests for the progress reporter
+ */
+
+#include <gtest/gtest.h>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "core/progress_reporter.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+constexpr std::chrono::milliseconds kInterval{5};
+
+} // namespace
+
+// Samples between phase changes never go backwards and carry speed and time left
+TEST(ProgressReporterTest, ReportsMonotonicProgress) {
+    std::vector<ProgressInfo> reports;
+    {
+        ProgressReporter progress([&reports](const ProgressInfo& info) { reports.push_back(info); }, 0.01, kInterval);
+        progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 1.0, 100);
+        for (int i = 0; i < 100; ++i) {
+            progress.add(1);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        progress.endPhase();
+        progress.complete();
+    }
+
+    ASSERT_GE(reports.size(), 3u);
+    EXPECT_EQ(reports.front().phaseRatio, 0.0);
+    for (size_t i = 1; i < reports.size(); ++i) {
+        EXPECT_GE(reports[i].overallRatio, reports[i - 1].overallRatio);
+    }
+    EXPECT_EQ(reports.back().phase, ProgressInfo::Phase::Complete);
+    EXPECT_EQ(reports.back().overallRatio, 1.0);
+
+    bool sampled = false;
+    for (const ProgressInfo& info : reports) {
+        if (info.overallRatio > 0.0 && info.overallRatio < 1.0) {
+            sampled = true;
+            EXPECT_GT(info.processingSpeed, 0.0);
+            EXPECT_GE(info.estimatedTimeLeft, 0.0);
+        }
+    }
+    EXPECT_TRUE(sampled);
+}
+
+// Phases map onto their share of the overall ratio
+TEST(ProgressReporterTest, MapsPhasesOntoOverallRatio) {
+    std::vector<ProgressInfo> reports;
+    {
+        // No samples in between, only the phase changes
+        ProgressReporter progress([&reports](const ProgressInfo& info) { reports.push_back(info); }, 0.05,
+                                  std::chrono::hours(1));
+        progress.beginPhase(ProgressInfo::Phase::Reading, 0.0, 0.5, 1000, 4000);
+        progress.add(1000);
+        progress.endPhase();
+        progress.beginPhase(ProgressInfo::Phase::Processing, 0.5, 1.0, 10);
+        progress.add(10);
+        progress.endPhase();
+    }
+
+    ASSERT_EQ(reports.size(), 4u);
+    EXPECT_EQ(reports[1].phase, ProgressInfo::Phase::Reading);
+    EXPECT_DOUBLE_EQ(reports[1].overallRatio, 0.5);
+    EXPECT_EQ(reports[1].processedBytes, 4000u);
+    EXPECT_EQ(reports[1].totalBytes, 4000u);
+    EXPECT_EQ(reports[2].phase, ProgressInfo::Phase::Processing);
+    EXPECT_EQ(reports[2].phaseRatio, 0.0);
+    EXPECT_DOUBLE_EQ(reports[2].overallRatio, 0.5);
+    EXPECT_DOUBLE_EQ(reports[3].overallRatio, 1.0);
+}
+
+// Work added from many threads adds up
+TEST(ProgressReporterTest, SumsWorkOfAllThreads) {
+    std::vector<ProgressInfo> reports;
+    const size_t threads = 8;
+    const size_t perThread = 10000;
+    {
+        ProgressReporter progress([&reports](const ProgressInfo& info) { reports.push_back(info); }, 0.05, kInterval);
+        progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 1.0);
+        std::vector<std::thread> workers;
+        for (size_t t = 0; t < threads; ++t) {
+            workers.emplace_back([&progress]() {
+                for (size_t i = 0; i < perThread; ++i) {
+                    progress.add(1);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        progress.endPhase();
+    }
+
+    ASSERT_FALSE(reports.empty());
+    // An unknown total becomes the work that was done
+    EXPECT_EQ(reports.back().processedBytes, threads * perThread);
+    EXPECT_EQ(reports.back().totalBytes, threads * perThread);
+    EXPECT_EQ(reports.back().phaseRatio, 1.0);
+}
+
+// What the callback throws on the reporter thread reaches the operation
+TEST(ProgressReporterTest, RethrowsCallbackExceptions) {
+    bool started = false;
+    ProgressReporter progress([&started](const ProgressInfo&) {
+        if (started) {
+            throw std::runtime_error("cancelled");
+        }
+        started = true;
+    }, 0.01, kInterval);
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 1.0, 100);
+    progress.add(50);
+    std::this_thread::sleep_for(kInterval * 20);
+    EXPECT_THROW(progress.endPhase(), std::runtime_error);
+}
+
+// Without a callback nothing is reported and adding is a no-op
+TEST(ProgressReporterTest, InactiveWithoutCallback) {
+    ProgressReporter progress(nullptr);
+    EXPECT_FALSE(progress.active());
+    progress.beginPhase(ProgressInfo::Phase::Processing, 0.0, 1.0, 10);
+    progress.add(10);
+    progress.endPhase();
+    progress.complete();
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,123 @@
+/**
+ * @file sampling_test.cpp
+ * @brief Tests for skip-ahead reservoir sampling
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "core/sampling.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::string makeLines(size_t count) {
+    std::string buffer;
+    for (size_t i = 0; i < count; ++i) {
+        buffer += "sample line " + std::to_string(i) + "\n";
+    }
+    return buffer;
+}
+
+size_t lineNumber(const std::string& line) {
+    return std::stoul(line.substr(line.rfind(' ') + 1));
+}
+
+} // namespace
+
+// Test sample sizes, order and line boundaries
+TEST(SamplingTest, SamplesDistinctLinesInOrder) {
+    std::string buffer = makeLines(1000);
+
+    auto sample = sampleLineBuffer(buffer.data(), buffer.size(), 50, 42);
+    ASSERT_EQ(50u, sample.size());
+    std::set<size_t> seen;
+    for (size_t i = 0; i < sample.size(); ++i) {
+        EXPECT_EQ(0u, sample[i].find("sample line "));
+        seen.insert(lineNumber(sample[i]));
+        if (i > 0) {
+            EXPECT_LT(lineNumber(sample[i - 1]), lineNumber(sample[i]));
+        }
+    }
+    EXPECT_EQ(50u, seen.size());
+
+    // Same seed, same sample
+    EXPECT_EQ(sample, sampleLineBuffer(buffer.data(), buffer.size(), 50, 42));
+
+    // Asking for more lines than exist returns them all; the last line needs no newline
+    std::string shortBuffer = "a\nb\n\nc";
+    auto all = sampleLineBuffer(shortBuffer.data(), shortBuffer.size(), 10, 7);
+    EXPECT_EQ((std::vector<std::string>{"a", "b", "", "c"}), all);
+
+    EXPECT_TRUE(sampleLineBuffer(buffer.data(), buffer.size(), 0, 42).empty());
+    EXPECT_TRUE(sampleLineBuffer(buffer.data(), 0, 10, 42).empty());
+}
+
+// Test that every line is selected with roughly equal probability
+TEST(SamplingTest, SamplesUniformly) {
+    std::string buffer = makeLines(100);
+
+    std::vector<size_t> hits(100, 0);
+    for (unsigned int seed = 1; seed <= 2000; ++seed) {
+        for (const auto& line : sampleLineBuffer(buffer.data(), buffer.size(), 10, seed)) {
+            hits[lineNumber(line)]++;
+        }
+    }
+
+    // Expected 200 hits per line
+    for (size_t count : hits) {
+        EXPECT_GT(count, 130u);
+        EXPECT_LT(count, 270u);
+    }
+}
+
+// Test that per-chunk reservoirs merge into a uniform sample
+TEST(SamplingTest, MergesParallelReservoirs) {
+    // About 4.5MB, enough for four chunks
+    std::string buffer = makeLines(250000);
+
+    auto sample = sampleLineBuffer(buffer.data(), buffer.size(), 2000, 99, 4);
+    ASSERT_EQ(2000u, sample.size());
+
+    std::set<size_t> seen;
+    std::vector<size_t> quarters(4, 0);
+    for (const auto& line : sample) {
+        size_t number = lineNumber(line);
+        seen.insert(number);
+        quarters[number * 4 / 250000]++;
+    }
+    EXPECT_EQ(2000u, seen.size());
+    for (size_t count : quarters) {
+        EXPECT_GT(count, 400u);
+        EXPECT_LT(count, 600u);
+    }
+
+    EXPECT_EQ(sample, sampleLineBuffer(buffer.data(), buffer.size(), 2000, 99, 4));
+}
+
+// Test sampling a memory-mapped file
+TEST(SamplingTest, SamplesMappedFile) {
+    const std::string path = "test_sampling_mapped.txt";
+    std::string buffer = makeLines(500);
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << buffer;
+    }
+
+    EXPECT_EQ(sampleLineBuffer(buffer.data(), buffer.size(), 20, 5),
+              sampleLinesMapped(path, 20, 5));
+    EXPECT_THROW(sampleLinesMapped("non_existent_sample.txt", 10), std::runtime_error);
+
+    std::filesystem::remove(path);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
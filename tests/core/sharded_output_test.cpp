@@ -0,0 +1,180 @@
+/**
+ * @file sharded_output_test.cpp
+ * @brief Tests for sharded output
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <ostream>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/sharded_output.h"
+#include "core/normalize.h"
+#include "core/pmi.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::vector<std::string> readLines(const std::string& path) {
+    std::ifstream file(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(file, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+} // namespace
+
+// Test that shard paths are numbered before the extensions
+TEST(ShardedOutputTest, NamesShards) {
+    EXPECT_EQ("dir/out-00003-of-00064.txt", shardOutputPath("dir/out.txt", 3, 64));
+    EXPECT_EQ("out-00000-of-00002.txt.zst", shardOutputPath("out.txt.zst", 0, 2));
+    EXPECT_EQ("out-00001-of-00002", shardOutputPath("out", 1, 2));
+    EXPECT_EQ(".hidden-00000-of-00001", shardOutputPath(".hidden", 0, 1));
+    EXPECT_THROW(ShardedOutputWriter("-", 4, ShardRouting::Hash), std::invalid_argument);
+    EXPECT_THROW(ShardedOutputWriter("test_data/shards/out.txt", 0, ShardRouting::Hash),
+                 std::invalid_argument);
+}
+
+// Test that hash routing keeps equal lines together and every line once
+TEST(ShardedOutputTest, RoutesByHashFromManyThreads) {
+    const std::string path = "test_data/shards/hash.txt";
+    std::filesystem::remove_all("test_data/shards");
+    {
+        ShardedOutputWriter output(path, 4, ShardRouting::Hash);
+        std::vector<std::thread> workers;
+        for (int t = 0; t < 4; ++t) {
+            workers.emplace_back([&output, t]() {
+                std::vector<std::string> batch;
+                for (int i = 0; i < 500; ++i) {
+                    batch.push_back("line " + std::to_string(t * 500 + i));
+                }
+                output.writeLines(batch);
+                output.writeLine("shared");
+            });
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        output.close();
+    }
+
+    std::multiset<std::string> all;
+    size_t sharedShards = 0;
+    for (uint32_t i = 0; i < 4; ++i) {
+        std::vector<std::string> lines = readLines(shardOutputPath(path, i, 4));
+        EXPECT_GT(lines.size(), 300u);
+        sharedShards += std::count(lines.begin(), lines.end(), "shared") > 0;
+        all.insert(lines.begin(), lines.end());
+    }
+    EXPECT_EQ(2004u, all.size());
+    EXPECT_EQ(4u, all.count("shared"));
+    EXPECT_EQ(1u, sharedShards);
+    EXPECT_EQ(1u, all.count("line 1999"));
+}
+
+// Test that round robin deals lines out evenly, in order within a shard, through a stream too
+TEST(ShardedOutputTest, RoundRobinThroughStream) {
+    const std::string path = "test_data/shards/rr.txt";
+    {
+        ShardedOutputWriter output(path, 3, ShardRouting::RoundRobin);
+        std::ostream stream(&output);
+        for (int i = 0; i < 9; ++i) {
+            stream << "row" << i << '\n';
+        }
+        stream << std::string(100000, 'x') << '\n' << "tail";
+        stream.flush();
+        output.close();
+    }
+
+    EXPECT_EQ((std::vector<std::string>{"row0", "row3", "row6", std::string(100000, 'x')}),
+              readLines(shardOutputPath(path, 0, 3)));
+    EXPECT_EQ((std::vector<std::string>{"row1", "row4", "row7", "tail"}), readLines(shardOutputPath(path, 1, 3)));
+    EXPECT_EQ((std::vector<std::string>{"row2", "row5", "row8"}), readLines(shardOutputPath(path, 2, 3)));
+}
+
+// Test that normalize writes the same unique lines into shards on every path
+TEST(ShardedOutputTest, NormalizeWritesShards) {
+    std::filesystem::create_directories("test_data");
+    const std::string input = "test_data/shards_input.txt";
+    {
+        std::ofstream file(input);
+        for (int i = 0; i < 5000; ++i) {
+            file << "line " << (i % 1500) << "\n";
+        }
+    }
+
+    for (bool streaming : {false, true}) {
+        for (uint32_t threads : {1u, 4u}) {
+            const std::string output = "test_data/shards/normalized.txt";
+            std::filesystem::remove_all("test_data/shards");
+            NormalizeOptions options;
+            options.threads = threads;
+            options.streaming = streaming;
+            options.outputShards = 8;
+            options.progressFormat = ProgressFormat::NONE;
+            NormalizeResult result = core::normalize(input, output, options);
+            EXPECT_EQ(1500u, result.uniques);
+
+            std::set<std::string> all;
+            for (uint32_t i = 0; i < 8; ++i) {
+                for (const auto& line : readLines(shardOutputPath(output, i, 8))) {
+                    EXPECT_TRUE(all.insert(line).second) << line;
+                }
+            }
+            EXPECT_EQ(1500u, all.size());
+            EXPECT_FALSE(std::filesystem::exists(output));
+        }
+    }
+}
+
+// Test that every PMI shard has the header and the rows are split among them
+TEST(ShardedOutputTest, PmiWritesShards) {
+    std::filesystem::create_directories("test_data");
+    const std::string input = "test_data/shards_pmi_input.txt";
+    {
+        std::ofstream file(input);
+        for (int i = 0; i < 20; ++i) {
+            file << "東京都に行く\n大阪府に行く\n京都府に住む\n";
+        }
+    }
+
+    PmiOptions options;
+    options.n = 2;
+    options.minFreq = 1;
+    options.outputShards = 2;
+    options.shardRouting = ShardRouting::RoundRobin;
+    options.progressFormat = ProgressFormat::NONE;
+    const std::string output = "test_data/shards/pmi.tsv";
+    core::calculatePmi(input, output, options);
+
+    PmiOptions single = options;
+    single.outputShards = 0;
+    core::calculatePmi(input, "test_data/shards/pmi_single.tsv", single);
+    size_t expectedRows = readLines("test_data/shards/pmi_single.tsv").size() - 1;
+    ASSERT_GT(expectedRows, 2u);
+
+    size_t rows = 0;
+    for (uint32_t i = 0; i < 2; ++i) {
+        std::vector<std::string> lines = readLines(shardOutputPath(output, i, 2));
+        ASSERT_FALSE(lines.empty());
+        EXPECT_EQ("ngram\tpmi\tfrequency", lines[0]);
+        rows += lines.size() - 1;
+    }
+    EXPECT_EQ(expectedRows, rows);
+
+    EXPECT_THROW(core::calculatePmi(input, "test_data/shards/pmi.arrow", options), std::invalid_argument);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,77 @@
+/**
+ * @file standard_streams_test.cpp
+ * @brief Tests for direct stdin and stdout access
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include "core/standard_streams.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that a pipe reads back whole through small and large reads
+TEST(StandardStreamsTest, ReadsPipesInBlocks) {
+    std::string text;
+    for (size_t i = 0; text.size() < 3 * 1024 * 1024; ++i) {
+        text += "line " + std::to_string(i) + "\n";
+    }
+
+    int fds[2];
+    ASSERT_EQ(0, ::pipe(fds));
+    std::thread writer([&]() {
+        const char* data = text.data();
+        size_t size = text.size();
+        while (size > 0) {
+            ssize_t written = ::write(fds[1], data, std::min<size_t>(size, 65536));
+            ASSERT_GT(written, 0);
+            data += written;
+            size -= static_cast<size_t>(written);
+        }
+        ::close(fds[1]);
+    });
+
+    std::string result;
+    {
+        DescriptorInputStream input(fds[0], 4096);
+        std::string line;
+        ASSERT_TRUE(std::getline(input, line));
+        result = line + "\n";
+        std::string block(1024 * 1024, '\0');
+        while (input.read(&block[0], static_cast<std::streamsize>(block.size())) || input.gcount() > 0) {
+            result.append(block.data(), static_cast<size_t>(input.gcount()));
+        }
+    }
+    writer.join();
+    ::close(fds[0]);
+    EXPECT_EQ(text, result);
+}
+
+// Test that a redirected std::cin or std::cout is no longer read or written directly
+TEST(StandardStreamsTest, DetectsRedirection) {
+    EXPECT_TRUE(isProcessStdin());
+    EXPECT_TRUE(isProcessStdout());
+
+    std::istringstream input("text");
+    std::ostringstream output;
+    std::streambuf* originalCin = std::cin.rdbuf(input.rdbuf());
+    std::streambuf* originalCout = std::cout.rdbuf(output.rdbuf());
+    bool redirectedStdin = isProcessStdin();
+    bool redirectedStdout = isProcessStdout();
+    std::cin.rdbuf(originalCin);
+    std::cout.rdbuf(originalCout);
+
+    EXPECT_FALSE(redirectedStdin);
+    EXPECT_FALSE(redirectedStdout);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,127 @@
+/**
+ * @file static_dictionary_test.cpp
+ * @brief Tests for the static dictionary
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "core/static_dictionary.h"
+#include "../../src/core/word_extraction/verifier.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class StaticDictionaryTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "suzume_static_dictionary_test";
+        std::filesystem::create_directories(dir_);
+        wordsPath_ = (dir_ / "words.txt").string();
+        dictionaryPath_ = (dir_ / "words.dict").string();
+    }
+
+    void TearDown() override {
+        std::filesystem::remove_all(dir_);
+    }
+
+    void writeWords(const std::vector<std::string>& words) {
+        std::ofstream file(wordsPath_);
+        for (const auto& word : words) {
+            file << word << "\n";
+        }
+    }
+
+    std::filesystem::path dir_;
+    std::string wordsPath_;
+    std::string dictionaryPath_;
+};
+
+// Test that every word is found and other words are not
+TEST_F(StaticDictionaryTest, FindsBuiltWords) {
+    std::vector<std::string> words;
+    for (int i = 0; i < 1000; ++i) {
+        words.push_back("単語" + std::to_string(i));
+    }
+    words.push_back("人工知能");
+    words.push_back("人工知能");
+    words.push_back("");
+    writeWords(words);
+
+    EXPECT_EQ(buildStaticDictionary(wordsPath_, dictionaryPath_), 1001u);
+    EXPECT_TRUE(isStaticDictionaryFile(dictionaryPath_));
+    EXPECT_FALSE(isStaticDictionaryFile(wordsPath_));
+
+    StaticDictionary dictionary(dictionaryPath_);
+    EXPECT_EQ(dictionary.size(), 1001u);
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_TRUE(dictionary.contains("単語" + std::to_string(i)));
+    }
+    EXPECT_TRUE(dictionary.contains("人工知能"));
+    EXPECT_FALSE(dictionary.contains("人工"));
+    EXPECT_FALSE(dictionary.contains("単語1000"));
+    EXPECT_FALSE(dictionary.contains(""));
+}
+
+// Test that an empty word list gives an empty dictionary
+TEST_F(StaticDictionaryTest, EmptyWordList) {
+    writeWords({});
+    EXPECT_EQ(buildStaticDictionary(wordsPath_, dictionaryPath_), 0u);
+
+    StaticDictionary dictionary(dictionaryPath_);
+    EXPECT_EQ(dictionary.size(), 0u);
+    EXPECT_FALSE(dictionary.contains("人工知能"));
+}
+
+// Test that missing, foreign and truncated files are rejected
+TEST_F(StaticDictionaryTest, RejectsInvalidFiles) {
+    EXPECT_THROW(StaticDictionary((dir_ / "missing.dict").string()), std::runtime_error);
+    EXPECT_THROW(buildStaticDictionary((dir_ / "missing.txt").string(), dictionaryPath_), std::runtime_error);
+
+    writeWords({"人工知能", "機械学習"});
+    EXPECT_THROW(StaticDictionary{wordsPath_}, std::runtime_error);
+
+    buildStaticDictionary(wordsPath_, dictionaryPath_);
+    std::filesystem::resize_file(dictionaryPath_, std::filesystem::file_size(dictionaryPath_) - 1);
+    EXPECT_THROW(StaticDictionary{dictionaryPath_}, std::runtime_error);
+}
+
+// Test that the verifier skips words of a static dictionary as of a word list
+TEST_F(StaticDictionaryTest, VerifierUsesStaticDictionary) {
+    std::string textPath = (dir_ / "text.txt").string();
+    {
+        std::ofstream file(textPath);
+        file << "人工知能と機械学習の研究が進んでいます。\n";
+        file << "深層学習を用いた自然言語処理技術の開発が行われています。\n";
+    }
+    writeWords({"人工知能", "辞書単語"});
+
+    std::vector<WordCandidate> candidates = {
+        {"機械学習", 4.8, 8, false},
+        {"人工知能", 5.2, 10, false},
+        {"深層学習", 3.5, 3, false}
+    };
+
+    WordExtractionOptions options;
+    options.useDictionaryLookup = true;
+    options.dictionaryPath = wordsPath_;
+    auto expected = CandidateVerifier(options).verifyCandidates(candidates, textPath);
+
+    buildStaticDictionary(wordsPath_, dictionaryPath_);
+    options.dictionaryPath = dictionaryPath_;
+    auto actual = CandidateVerifier(options).verifyCandidates(candidates, textPath);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    ASSERT_EQ(actual.size(), 2u);
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(actual[i].text, expected[i].text);
+        EXPECT_NE(actual[i].text, "人工知能");
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,144 @@
+/**
+ * @file suffix_array_test.cpp
+ * @brief Tests for the SA-IS suffix array
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/suffix_array.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+namespace {
+
+std::vector<size_t> findAllOverlapping(const std::string& text, const std::string& pattern) {
+    std::vector<size_t> positions;
+    for (size_t pos = text.find(pattern); pos != std::string::npos; pos = text.find(pattern, pos + 1)) {
+        positions.push_back(pos);
+    }
+    return positions;
+}
+
+void expectSorted(const std::string& text) {
+    SuffixArray sa(text);
+    ASSERT_EQ(sa.size(), text.size());
+    for (size_t rank = 1; rank < sa.size(); ++rank) {
+        ASSERT_LT(text.compare(sa.position(rank - 1), std::string::npos,
+                               text, sa.position(rank), std::string::npos), 0)
+            << "rank " << rank << " of \"" << text << "\"";
+    }
+}
+
+} // namespace
+
+// Test that suffixes come out sorted for short, repetitive and random texts
+TEST(SuffixArrayTest, SortsSuffixes) {
+    expectSorted("");
+    expectSorted("a");
+    expectSorted("banana");
+    expectSorted(std::string(1000, 'a'));
+    expectSorted("abracadabra abracadabra abracadabra mississippi mississippi");
+
+    std::string periodic;
+    for (int i = 0; i < 300; ++i) {
+        periodic += "abcab";
+    }
+    expectSorted(periodic);
+
+    std::mt19937 rng(42);
+    for (int alphabet : {2, 4, 256}) {
+        std::uniform_int_distribution<int> symbol(0, alphabet - 1);
+        std::string text;
+        for (int i = 0; i < 5000; ++i) {
+            text.push_back(static_cast<char>(alphabet == 256 ? symbol(rng) : 'a' + symbol(rng)));
+        }
+        expectSorted(text);
+    }
+}
+
+// Test that counts and positions match a brute-force search
+TEST(SuffixArrayTest, MatchesBruteForceSearch) {
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> symbol(0, 2);
+    std::string text;
+    for (int i = 0; i < 4000; ++i) {
+        text.push_back(static_cast<char>('a' + symbol(rng)));
+    }
+    text += "機械学習と深層学習の機械学習";
+
+    SuffixArray sa(text);
+    std::vector<std::string> patterns = {"a", "ab", "abc", "ccc", "aaaaaa", "abcabcabcabc",
+                                         "学習", "機械学習", "深層学習の機械", "d", "学習と深層学習ab"};
+    std::uniform_int_distribution<size_t> start(0, text.size() - 8);
+    std::uniform_int_distribution<size_t> length(1, 8);
+    for (int i = 0; i < 50; ++i) {
+        patterns.push_back(text.substr(start(rng), length(rng)));
+    }
+
+    for (const auto& pattern : patterns) {
+        std::vector<size_t> expected = findAllOverlapping(text, pattern);
+        EXPECT_EQ(sa.count(pattern), expected.size()) << pattern;
+        EXPECT_EQ(sa.positions(pattern), expected) << pattern;
+    }
+}
+
+// Test edge cases of the query bounds
+TEST(SuffixArrayTest, HandlesBoundaryPatterns) {
+    std::string text = "abcabc";
+    SuffixArray sa(text);
+
+    EXPECT_EQ(sa.count(""), text.size());
+    EXPECT_EQ(sa.count("abcabc"), 1u);
+    EXPECT_EQ(sa.count("abcabcd"), 0u);
+    EXPECT_EQ(sa.count("c"), 2u);
+    EXPECT_EQ(sa.positions("bc"), (std::vector<size_t>{1, 4}));
+    EXPECT_TRUE(sa.positions("zz").empty());
+
+    SuffixArray empty("");
+    EXPECT_EQ(empty.count("a"), 0u);
+    EXPECT_TRUE(empty.positions("a").empty());
+}
+
+// Test that a written array is mapped for the same text and rejected for another
+TEST(SuffixArrayTest, WritesAndOpensFile) {
+    std::string path = (std::filesystem::temp_directory_path() / "suzume_suffix_array_test.sfx").string();
+    std::string text;
+    for (int i = 0; i < 500; ++i) {
+        text += "人工知能と機械学習 " + std::to_string(i % 37) + "\n";
+    }
+    SuffixArray built(text);
+    built.write(path);
+
+    std::unique_ptr<SuffixArray> opened = SuffixArray::open(text, path);
+    ASSERT_NE(opened, nullptr);
+    ASSERT_EQ(opened->size(), built.size());
+    for (size_t rank = 0; rank < built.size(); ++rank) {
+        ASSERT_EQ(opened->position(rank), built.position(rank));
+    }
+    EXPECT_EQ(opened->positions("機械学習 3"), built.positions("機械学習 3"));
+
+    // Another text of the same size, a missing file and a foreign file are stale
+    std::string changed = text;
+    changed[0] = 'x';
+    changed[1] = 'y';
+    changed[2] = 'z';
+    EXPECT_EQ(SuffixArray::open(changed, path), nullptr);
+    EXPECT_EQ(SuffixArray::open(text, path + ".missing"), nullptr);
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "not a suffix array";
+    }
+    EXPECT_EQ(SuffixArray::open(text, path), nullptr);
+    std::filesystem::remove(path);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -33,6 +33,87 @@ TEST(TextUtilsTest, NormalizeLine) {
     EXPECT_EQ("#comment", normalizeLine("#comment", NormalizationForm::NFKC));
 }
 
+// Test the ASCII and already-normalized fast paths
+TEST(TextUtilsTest, NormalizeLineFastPaths) {
+    // Pure ASCII: lowercase and control stripping without ICU
+    EXPECT_EQ("hello world", normalizeLine("HeLLo\x01 World\x7f", NormalizationForm::NFKC));
+
+    // Fields with digits keep their case
+    EXPECT_EQ("ABC123\tdef", normalizeLine("ABC123\tDEF", NormalizationForm::NFKC));
+
+    // NFC keeps case for ASCII as well
+    EXPECT_EQ("ABC def", normalizeLine("ABC def", NormalizationForm::NFC));
+
+    // Mixed ASCII and non-ASCII fields in one line
+    EXPECT_EQ("hello\tworld", normalizeLine("Ｈｅｌｌｏ\tWORLD", NormalizationForm::NFKC));
+
+    // Already normalized non-ASCII text is passed through unchanged
+    EXPECT_EQ("東京ラーメン", normalizeLine("東京ラーメン", NormalizationForm::NFKC));
+
+    // Text that only needs normalization after an ASCII prefix
+    EXPECT_EQ("abc file", normalizeLine("ABC ﬁle", NormalizationForm::NFKC));
+
+    // Format characters are stripped from non-ASCII fields
+    EXPECT_EQ("東京", normalizeLine("東\u200b京", NormalizationForm::NFKC));
+
+    // Empty fields exclude the line
+    EXPECT_EQ("", normalizeLine("abc\t\tdef", NormalizationForm::NFKC));
+    EXPECT_EQ("", normalizeLine("abc\t", NormalizationForm::NFKC));
+}
+
+// Test normalizing into a reused output buffer
+TEST(TextUtilsTest, NormalizeLineInto) {
+    const std::vector<std::string> lines = {
+        "Ｈｅｌｌｏ\tWORLD",
+        "東京ラーメン",
+        "ABC ﬁle",
+        "a",
+        "Café Ｃａｆé",
+        "abc\t\tdef",
+        "plain ascii line"
+    };
+
+    std::string out;
+    out.reserve(256);
+    const char* buffer = out.data();
+    for (const auto& line : lines) {
+        std::string expected = normalizeLine(line, NormalizationForm::NFKC);
+        EXPECT_EQ(!expected.empty(), normalizeLineInto(line, NormalizationForm::NFKC, out));
+        EXPECT_EQ(expected, out);
+    }
+
+    // Short lines never outgrow the reserved capacity
+    EXPECT_EQ(buffer, out.data());
+}
+
+// Test that only the selected columns are normalized
+TEST(TextUtilsTest, NormalizeSelectedColumns) {
+    std::string out;
+    EXPECT_TRUE(normalizeLineInto("ID-7\tＨｅｌｌｏ\thttps://Ex.com/A", NormalizationForm::NFKC, out, {2}));
+    EXPECT_EQ("ID-7\thello\thttps://Ex.com/A", out);
+
+    EXPECT_TRUE(normalizeLineInto("ID\tＨｅｌｌｏ\tＷＯＲＬＤ", NormalizationForm::NFKC, out, {1, 3}));
+    EXPECT_EQ("id\tＨｅｌｌｏ\tworld", out);
+
+    // No columns means every column, as normalizeLine
+    EXPECT_TRUE(normalizeLineInto("ID-7\tＨｅｌｌｏ", NormalizationForm::NFKC, out, {}));
+    EXPECT_EQ(normalizeLine("ID-7\tＨｅｌｌｏ", NormalizationForm::NFKC), out);
+
+    // Passed-through fields are still subject to the whole-line rules
+    EXPECT_FALSE(normalizeLineInto("a\t\tb", NormalizationForm::NFKC, out, {1}));
+}
+
+// Test dedup key selection
+TEST(TextUtilsTest, SelectColumns) {
+    std::string scratch;
+    EXPECT_EQ("a\tb\tc", selectColumns("a\tb\tc", {}, scratch));
+    EXPECT_EQ("b", selectColumns("a\tb\tc", {2}, scratch));
+    EXPECT_EQ("c", selectColumns("a\tb\tc", {3}, scratch));
+    EXPECT_EQ("c\ta", selectColumns("a\tb\tc", {3, 1}, scratch));
+    EXPECT_EQ("", selectColumns("a\tb", {4}, scratch));
+    EXPECT_EQ("a\t", selectColumns("a\tb", {1, 4}, scratch));
+}
+
 // Test exclusion rules
 TEST(TextUtilsTest, ShouldExcludeLine) {
     // Test empty line
@@ -256,6 +337,21 @@ TEST(TextUtilsTest, SampleLinesErrors) {
     }
 }
 
+// Test UTF-8 context windows around a byte position
+TEST(TextUtilsTest, Utf8Context) {
+    std::string text = "一行目です\n人工知能の研究\nabc";
+    size_t position = text.find("知能");
+
+    EXPECT_EQ(utf8Context(text, position, 2), "人工知能");
+    EXPECT_EQ(utf8Context(text, position + 1, 2), "人工知能");
+    EXPECT_EQ(utf8Context(text, position, 4), "す\n人工知能の研");
+    EXPECT_EQ(utf8Context(text, position, 3, true), "人工知能の");
+    EXPECT_EQ(utf8Context(text, position, 100, true), "人工知能の研究");
+    EXPECT_EQ(utf8Context(text, text.size(), 2), "bc");
+    EXPECT_EQ(utf8Context(text, 0, 0), "");
+    EXPECT_EQ(utf8Context("", 5, 3), "");
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
@@ -0,0 +1,95 @@
+/**
+ * @file top_k_test.cpp
+ * @brief Tests for bounded top-K selection
+ */
+
+#include <gtest/gtest.h>
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+#include "core/packed_ngram.h"
+#include "core/pmi.h"
+#include "core/top_k.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that the selector keeps the K best items, best first
+TEST(TopKSelectorTest, KeepsBestItems) {
+    std::mt19937 rng(42);
+    std::vector<int> values(10000);
+    for (auto& value : values) {
+        value = static_cast<int>(rng() % 100000);
+    }
+
+    TopKSelector<int, std::greater<int>> selector(25);
+    for (int value : values) {
+        selector.push(value);
+    }
+    EXPECT_EQ(25u, selector.size());
+
+    std::vector<int> expected = values;
+    std::sort(expected.begin(), expected.end(), std::greater<int>());
+    expected.resize(25);
+    EXPECT_EQ(expected, selector.take());
+    EXPECT_EQ(0u, selector.size());
+
+    TopKSelector<int> none(0);
+    none.push(1);
+    EXPECT_FALSE(none.accepts(1));
+    EXPECT_TRUE(none.take().empty());
+}
+
+// Test that merged selectors equal one selector over all items
+TEST(TopKSelectorTest, Merges) {
+    TopKSelector<int> all(10);
+    TopKSelector<int> first(10);
+    TopKSelector<int> second(10);
+    for (int i = 0; i < 100; ++i) {
+        int value = (i * 37) % 101;
+        all.push(value);
+        (i % 3 == 0 ? first : second).push(value);
+    }
+    EXPECT_TRUE(first.accepts(-1));
+    EXPECT_FALSE(first.accepts(1000));
+
+    first.merge(std::move(second));
+    EXPECT_EQ(0u, second.size());
+    EXPECT_EQ(all.take(), first.take());
+}
+
+// Test that scoring large partitioned tables in parallel keeps the same top K
+TEST(TopKSelectorTest, ParallelScoringMatchesSerial) {
+    // Random lines over 300 CJK characters, enough distinct bigrams to score in parallel
+    std::mt19937 rng(7);
+    std::string text;
+    for (int line = 0; line < 20000; ++line) {
+        for (int i = 0; i < 20; ++i) {
+            appendUtf8(text, 0x4E00 + rng() % 300);
+        }
+        text += '\n';
+    }
+
+    PackedNgramCounter serial(2);
+    serial.addText(text);
+    PartitionedNgramCounter partitioned(2, 4);
+    partitioned.addText(text);
+    ASSERT_GE(partitioned.size(), 65536u);
+
+    std::vector<PmiItem> expected = calculatePmiScores(serial, 1, 300);
+    std::vector<PmiItem> actual = calculatePmiScores(partitioned, 1, 300);
+    ASSERT_EQ(300u, expected.size());
+    ASSERT_EQ(expected.size(), actual.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        EXPECT_EQ(expected[i].ngram, actual[i].ngram);
+        EXPECT_EQ(expected[i].frequency, actual[i].frequency);
+        EXPECT_DOUBLE_EQ(expected[i].score, actual[i].score);
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
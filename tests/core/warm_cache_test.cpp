@@ -0,0 +1,111 @@
+/**
+ * @file warm_cache_test.cpp
+ * @brief Tests for the warm cache
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include "core/warm_cache.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+class WarmCacheTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        dir_ = std::filesystem::temp_directory_path() / "suzume_warm_cache_test";
+        std::filesystem::create_directories(dir_);
+        setWarmCacheLimit(0);
+    }
+
+    void TearDown() override {
+        setWarmCacheLimit(0);
+        std::filesystem::remove_all(dir_);
+    }
+
+    std::string writeFile(const std::string& name, const std::string& content) {
+        std::string path = (dir_ / name).string();
+        std::ofstream(path) << content;
+        return path;
+    }
+
+    // Load the file's content, counting the loads
+    std::shared_ptr<const std::string> load(const std::string& path, const std::string& variant = "") {
+        return cachedLoad<std::string>("test", path, variant, [&]() {
+            loads_++;
+            std::ifstream in(path);
+            return std::make_shared<const std::string>(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        });
+    }
+
+    std::filesystem::path dir_;
+    int loads_ = 0;
+};
+
+TEST_F(WarmCacheTest, LoadsEveryTimeWhenOff) {
+    std::string path = writeFile("a.txt", "alpha");
+    EXPECT_EQ(*load(path), "alpha");
+    EXPECT_EQ(*load(path), "alpha");
+    EXPECT_EQ(loads_, 2);
+    EXPECT_EQ(warmCacheStats().entries, 0u);
+}
+
+TEST_F(WarmCacheTest, ReusesLoadedStructure) {
+    setWarmCacheLimit(2);
+    std::string path = writeFile("a.txt", "alpha");
+    WarmCacheStats before = warmCacheStats();
+
+    auto first = load(path);
+    auto second = load(path);
+    EXPECT_EQ(first.get(), second.get());
+    EXPECT_EQ(loads_, 1);
+
+    WarmCacheStats after = warmCacheStats();
+    EXPECT_EQ(after.entries, 1u);
+    EXPECT_EQ(after.hits - before.hits, 1u);
+    EXPECT_EQ(after.misses - before.misses, 1u);
+
+    // Settings the structure was built with are part of the key
+    load(path, "other");
+    EXPECT_EQ(loads_, 2);
+}
+
+TEST_F(WarmCacheTest, ReloadsChangedFile) {
+    setWarmCacheLimit(2);
+    std::string path = writeFile("a.txt", "alpha");
+    EXPECT_EQ(*load(path), "alpha");
+
+    writeFile("a.txt", "alphabet");
+    EXPECT_EQ(*load(path), "alphabet");
+    EXPECT_EQ(loads_, 2);
+    EXPECT_EQ(warmCacheStats().entries, 1u);
+}
+
+TEST_F(WarmCacheTest, EvictsLeastRecentlyUsed) {
+    setWarmCacheLimit(2);
+    std::string a = writeFile("a.txt", "a");
+    std::string b = writeFile("b.txt", "b");
+    std::string c = writeFile("c.txt", "c");
+
+    load(a);
+    load(b);
+    load(a);
+    load(c);  // Evicts b, used less recently than a
+    EXPECT_EQ(loads_, 3);
+    load(a);
+    EXPECT_EQ(loads_, 3);
+    load(b);
+    EXPECT_EQ(loads_, 4);
+
+    // Lowering the limit drops the entries over it
+    setWarmCacheLimit(1);
+    EXPECT_EQ(warmCacheStats().entries, 1u);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
@@ -0,0 +1,90 @@
+/**
+ * @file word_extraction_candidate_store_test.cpp
+ * @brief Tests for CandidateStore class
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+#include "../../src/core/word_extraction/candidate_store.h"
+#include "../../src/core/word_extraction/filter.h"
+#include "../../src/core/word_extraction/ranker.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that candidates round-trip through the store
+TEST(CandidateStoreTest, StoresCandidateColumns) {
+    std::vector<WordCandidate> candidates = {
+        {"人工知能", 5.2, 10, false},
+        {"機械学習", 4.8, 8, false},
+        {"", 1.0, 1, false}
+    };
+
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(candidates);
+    ASSERT_EQ(ids.size(), 3u);
+    EXPECT_EQ(store.size(), 3u);
+
+    store.setContext(ids[1], "深層学習と機械学習の違い");
+    store.setContextScore(ids[1], 0.4);
+    store.setStatisticalScore(ids[1], 0.6);
+
+    EXPECT_EQ(store.text(ids[0]), "人工知能");
+    EXPECT_EQ(store.text(ids[1]), "機械学習");
+    EXPECT_EQ(store.text(ids[2]), "");
+    EXPECT_DOUBLE_EQ(store.score(ids[0]), 5.2);
+    EXPECT_EQ(store.frequency(ids[1]), 8u);
+    EXPECT_EQ(store.context(ids[0]), "");
+
+    VerifiedCandidate verified = store.toVerified(ids[1]);
+    EXPECT_EQ(verified.text, "機械学習");
+    EXPECT_EQ(verified.context, "深層学習と機械学習の違い");
+    EXPECT_DOUBLE_EQ(verified.contextScore, 0.4);
+    EXPECT_DOUBLE_EQ(verified.statisticalScore, 0.6);
+    EXPECT_GT(store.memoryUsage(), 0u);
+}
+
+// Test that the store-based stages give the same results as the vector-based ones
+TEST(CandidateStoreTest, StoreStagesMatchVectorStages) {
+    WordExtractionOptions options;
+    options.rankingModel = "combined";
+    options.removeSubstrings = true;
+    options.removeOverlapping = false;
+    options.minLength = 1;
+
+    std::vector<VerifiedCandidate> candidates;
+    const char* texts[] = {"人工知能", "知能", "機械学習", "学習", "深層学習", "自然言語", "言語"};
+    for (size_t i = 0; i < 7; ++i) {
+        VerifiedCandidate candidate;
+        candidate.text = texts[i];
+        candidate.score = 1.0 + (i * 7 % 5);
+        candidate.frequency = static_cast<uint32_t>(i + 1);
+        candidate.context = std::string("文脈") + texts[i];
+        candidate.contextScore = 0.1 * i;
+        candidate.statisticalScore = 0.05 * i;
+        candidates.push_back(candidate);
+    }
+
+    CandidateFilter filter(options);
+    CandidateRanker ranker(options);
+    auto expected = ranker.rankTopCandidates(filter.filterCandidates(candidates), 4);
+
+    CandidateStore store;
+    std::vector<CandidateStore::Id> ids = store.addAll(candidates);
+    filter.filterCandidates(store, ids);
+    auto actual = ranker.rankTopCandidates(store, ids, 4);
+
+    ASSERT_EQ(actual.size(), expected.size());
+    for (size_t i = 0; i < actual.size(); ++i) {
+        EXPECT_EQ(store.text(actual[i].id), expected[i].text);
+        EXPECT_DOUBLE_EQ(actual[i].score, expected[i].score);
+        EXPECT_EQ(store.frequency(actual[i].id), expected[i].frequency);
+        EXPECT_EQ(store.context(actual[i].id), expected[i].context);
+    }
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
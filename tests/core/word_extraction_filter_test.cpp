@@ -7,6 +7,9 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <numeric>
+#include <random>
+#include <set>
 #include "../../src/core/word_extraction/filter.h"
 
 namespace suzume {
@@ -494,6 +497,131 @@ TEST_F(CandidateFilterTest, LanguageSpecificFilters) {
     EXPECT_TRUE(found_ml || found_rd || found_english) << "At least some content words should be kept";
 }
 
+// Test substring removal against the pairwise rule on many candidates
+TEST_F(CandidateFilterTest, SubstringRemovalMatchesPairwiseRule) {
+    options.minLength = 1;
+    options.maxLength = 100;
+    options.minScore = 0.0;
+    options.removeOverlapping = false;
+    options.useLanguageSpecificRules = false;
+    filter = std::make_unique<CandidateFilter>(options);
+
+    const std::vector<std::string> alphabet = {"学", "a", "b"};
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> symbol(0, 2);
+    std::uniform_int_distribution<int> length(1, 6);
+    std::uniform_real_distribution<double> score(0.5, 10.0);
+    std::vector<VerifiedCandidate> many;
+    for (int i = 0; i < 400; ++i) {
+        VerifiedCandidate candidate;
+        int n = length(rng);
+        for (int k = 0; k < n; ++k) {
+            candidate.text += alphabet[symbol(rng)];
+        }
+        if (i % 10 == 0) {
+            candidate.text = "学習" + candidate.text;
+        }
+        candidate.score = score(rng);
+        many.push_back(candidate);
+    }
+
+    // Reference: removed if a strictly longer, kept candidate contains it
+    // and the lowest-scoring copy of the text is below 0.8 of its score
+    std::vector<size_t> order(many.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return many[a].text.length() > many[b].text.length();
+    });
+    std::set<std::string> removed;
+    for (size_t i : order) {
+        for (size_t j : order) {
+            if (many[j].text.length() <= many[i].text.length() || removed.count(many[j].text)) {
+                continue;
+            }
+            if (many[j].text.find(many[i].text) != std::string::npos && many[i].score < many[j].score * 0.8) {
+                removed.insert(many[i].text);
+                break;
+            }
+        }
+    }
+    std::vector<std::string> expected;
+    for (const auto& candidate : many) {
+        if (!removed.count(candidate.text)) {
+            expected.push_back(candidate.text);
+        }
+    }
+
+    std::vector<std::string> actual;
+    for (const auto& candidate : filter->filterCandidates(many)) {
+        actual.push_back(candidate.text);
+    }
+    EXPECT_FALSE(removed.empty());
+    EXPECT_EQ(actual, expected);
+}
+
+// Test overlap removal against the pairwise rule on many candidates
+TEST_F(CandidateFilterTest, OverlapRemovalMatchesPairwiseRule) {
+    options.minLength = 1;
+    options.maxLength = 100;
+    options.minScore = 0.0;
+    options.removeSubstrings = false;
+    options.useLanguageSpecificRules = false;
+    filter = std::make_unique<CandidateFilter>(options);
+
+    const std::vector<std::string> alphabet = {"学", "a", "b", "c"};
+    std::mt19937 rng(5);
+    std::uniform_int_distribution<int> symbol(0, 3);
+    std::uniform_int_distribution<int> length(1, 5);
+    std::uniform_int_distribution<int> score(1, 20);
+    std::vector<VerifiedCandidate> many;
+    for (int i = 0; i < 300; ++i) {
+        VerifiedCandidate candidate;
+        int n = length(rng);
+        for (int k = 0; k < n; ++k) {
+            candidate.text += alphabet[symbol(rng)];
+        }
+        candidate.score = score(rng);
+        many.push_back(candidate);
+    }
+
+    // Reference: by score, keep a candidate unless an overlapping candidate
+    // still in scores at least as high; a kept one removes what it overlaps
+    auto overlaps = [](const std::string& a, const std::string& b) {
+        return a.find(b) != std::string::npos || b.find(a) != std::string::npos;
+    };
+    std::vector<size_t> order(many.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return many[a].score > many[b].score;
+    });
+    std::vector<bool> removed(many.size(), false);
+    std::vector<std::string> expected;
+    for (size_t i : order) {
+        if (removed[i]) continue;
+        bool keep = true;
+        for (size_t j = 0; j < many.size(); ++j) {
+            if (j != i && !removed[j] && overlaps(many[i].text, many[j].text) && many[i].score <= many[j].score) {
+                keep = false;
+            }
+        }
+        if (keep) {
+            for (size_t j = 0; j < many.size(); ++j) {
+                if (j != i && overlaps(many[i].text, many[j].text)) {
+                    removed[j] = true;
+                }
+            }
+            expected.push_back(many[i].text);
+        }
+        removed[i] = true;
+    }
+
+    std::vector<std::string> actual;
+    for (const auto& candidate : filter->filterCandidates(many)) {
+        actual.push_back(candidate.text);
+    }
+    EXPECT_EQ(actual, expected);
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
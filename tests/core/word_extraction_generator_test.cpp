@@ -5,10 +5,12 @@
 
 #include <gtest/gtest.h>
 #include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 #include <algorithm>
 #include "../../src/core/word_extraction/generator.h"
+#include "core/pmi_results.h"
 
 namespace suzume {
 namespace core {
@@ -140,6 +142,40 @@ TEST_F(CandidateGeneratorTest, MaxCandidates) {
     }
 }
 
+// Test that parallel selection of the best candidates matches sequential selection, ties included
+TEST_F(CandidateGeneratorTest, ParallelSelectionMatchesSequential) {
+    {
+        std::ofstream file(pmiResultsPath_, std::ios::trunc);
+        file << "ngram\tscore\tfreq\n";
+        for (int i = 0; i < 20000; ++i) {
+            file << "語" << i << "\t" << (3.0 + (i * 37 % 101) / 10.0) << "\t" << (i % 9 + 1) << "\n";
+        }
+    }
+    options.threads = 4;
+    for (uint32_t maxCandidates : {1u, 250u, 19999u, 20000u, 50000u}) {
+        options.maxCandidates = maxCandidates;
+        options.useParallelProcessing = true;
+        auto parallelCandidates = CandidateGenerator(options).generateCandidates(pmiResultsPath_);
+        options.useParallelProcessing = false;
+        auto sequentialCandidates = CandidateGenerator(options).generateCandidates(pmiResultsPath_);
+
+        ASSERT_EQ(parallelCandidates.size(), std::min<size_t>(maxCandidates, 20000));
+        ASSERT_EQ(parallelCandidates.size(), sequentialCandidates.size());
+        for (size_t i = 0; i < parallelCandidates.size(); ++i) {
+            EXPECT_EQ(parallelCandidates[i].text, sequentialCandidates[i].text);
+            EXPECT_EQ(parallelCandidates[i].score, sequentialCandidates[i].score);
+        }
+        // Kept in input order when nothing is dropped, best first otherwise
+        if (maxCandidates >= 20000) {
+            EXPECT_EQ(parallelCandidates.front().text, "語0");
+        } else {
+            for (size_t i = 1; i < parallelCandidates.size(); ++i) {
+                EXPECT_GE(parallelCandidates[i - 1].score, parallelCandidates[i].score);
+            }
+        }
+    }
+}
+
 // Test with progress callback
 TEST_F(CandidateGeneratorTest, ProgressCallback) {
     // Progress tracking
@@ -189,6 +225,93 @@ TEST_F(CandidateGeneratorTest, InvalidInput) {
     );
 }
 
+// Test that a file parsed in parallel chunks gives the same candidates as one parsed whole
+TEST_F(CandidateGeneratorTest, ParallelParsingMatchesSequential) {
+    {
+        std::ofstream file(pmiResultsPath_, std::ios::binary | std::ios::trunc);
+        file << "ngram\tscore\tfreq\n";
+        for (int i = 0; i < 200000; ++i) {
+            file << "語" << i << "\t" << (2.0 + (i % 997) / 100.0) << "\t" << (i % 50 + 1);
+            file << (i % 3 == 0 ? "\r\n" : "\n");
+            if (i % 50000 == 7) {
+                file << "malformed line\n\n";
+            }
+        }
+    }
+    options.maxCandidates = 1000000;
+    options.threads = 4;
+    std::vector<double> progressValues;
+    auto parallelCandidates = CandidateGenerator(options).generateCandidates(pmiResultsPath_, [&](double progress) {
+        progressValues.push_back(progress);
+    });
+
+    options.useParallelProcessing = false;
+    auto sequentialCandidates = CandidateGenerator(options).generateCandidates(pmiResultsPath_);
+
+    ASSERT_FALSE(sequentialCandidates.empty());
+    ASSERT_EQ(parallelCandidates.size(), sequentialCandidates.size());
+    for (size_t i = 0; i < sequentialCandidates.size(); ++i) {
+        EXPECT_EQ(parallelCandidates[i].text, sequentialCandidates[i].text);
+        EXPECT_EQ(parallelCandidates[i].score, sequentialCandidates[i].score);
+        EXPECT_EQ(parallelCandidates[i].frequency, sequentialCandidates[i].frequency);
+    }
+    auto found = std::find_if(sequentialCandidates.begin(), sequentialCandidates.end(), [](const WordCandidate& candidate) {
+        return candidate.text == "語1100";
+    });
+    ASSERT_NE(found, sequentialCandidates.end());
+    EXPECT_DOUBLE_EQ(found->score, 3.03);
+    EXPECT_EQ(found->frequency, 1u);
+
+    // Progress moves once per chunk, not once per line
+    ASSERT_FALSE(progressValues.empty());
+    EXPECT_LT(progressValues.size(), 1000u);
+    for (size_t i = 1; i < progressValues.size(); i++) {
+        EXPECT_GE(progressValues[i], progressValues[i-1]);
+    }
+}
+
+// Test that binary PMI results are read in place and give the same candidates as TSV
+TEST_F(CandidateGeneratorTest, BinaryResults) {
+    const std::string binaryPath = "test_pmi_results.pmi";
+    std::vector<PmiItem> items = {
+        {"人工知能", 5.2, 10}, {"機械学習", 4.8, 8}, {"深層学習", 4.5, 7}, {"自然言語", 4.2, 6},
+        {"処理技術", 4.0, 5}, {"人工知", 3.8, 4}, {"知能研", 3.5, 3}, {"研究開", 3.2, 2},
+        {"開発者", 3.0, 1}, {"低スコア", 2.5, 1},
+    };
+    writePmiResults(binaryPath, 4, items);
+    ASSERT_TRUE(isPmiResultsFile(binaryPath));
+    EXPECT_FALSE(isPmiResultsFile(pmiResultsPath_));
+
+    PmiResultsReader reader(binaryPath);
+    ASSERT_EQ(items.size(), reader.size());
+    EXPECT_EQ(4u, reader.n());
+    for (size_t i = 0; i < items.size(); ++i) {
+        EXPECT_EQ(items[i].ngram, reader.ngram(i));
+        EXPECT_EQ(items[i].score, reader.score(i));
+        EXPECT_EQ(items[i].frequency, reader.frequency(i));
+    }
+
+    auto fromTsv = generator->generateCandidates(pmiResultsPath_);
+    CandidateGenerator binaryGenerator(options);
+    auto fromBinary = binaryGenerator.generateCandidates(binaryPath);
+    ASSERT_EQ(fromTsv.size(), fromBinary.size());
+    for (size_t i = 0; i < fromTsv.size(); ++i) {
+        EXPECT_EQ(fromTsv[i].text, fromBinary[i].text);
+        EXPECT_EQ(fromTsv[i].score, fromBinary[i].score);
+        EXPECT_EQ(fromTsv[i].frequency, fromBinary[i].frequency);
+    }
+
+    // A truncated file is rejected rather than read past its end
+    {
+        std::ifstream in(binaryPath, std::ios::binary);
+        std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out(binaryPath, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), static_cast<std::streamsize>(data.size() - 3));
+    }
+    EXPECT_THROW(PmiResultsReader{binaryPath}, std::runtime_error);
+    std::remove(binaryPath.c_str());
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
@@ -0,0 +1,117 @@
+/**
+ * @file word_extraction_incremental_state_test.cpp
+ * @brief Tests for the candidate evidence kept between word extraction runs
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include "../../src/core/word_extraction/incremental_state.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that recorded evidence loads back as it was saved
+TEST(IncrementalStateTest, SavesAndLoadsEvidence) {
+    const std::string path = "test_incremental_state.tsv";
+    std::filesystem::remove(path);
+    {
+        IncrementalState state(path, 0x0123456789abcdefULL, 2, 0.05);
+        EXPECT_EQ(0u, state.previousSize());
+        state.record("東京", {3.25, 12, 10, 4, 6, "東京\tの天気"});
+        state.record("晴\tれ", {1.0, 1, 1, 0, 0, ""});
+        state.record("大阪", {-0.5, 2, 0, 0, 0, ""});
+        state.save();
+    }
+    EXPECT_FALSE(std::filesystem::exists(path + ".tmp"));
+
+    IncrementalState state(path, 0x0123456789abcdefULL, 2, 0.05);
+    EXPECT_TRUE(state.sameText());
+    EXPECT_EQ(2u, state.previousSize());
+    EXPECT_EQ(nullptr, state.reusable("晴\tれ", 1.0, 1));
+    EXPECT_EQ(nullptr, state.reusable("天気", 1.0, 1));
+
+    // Over the same text, evidence holds whatever the scores
+    const CachedEvidence* tokyo = state.reusable("東京", 100.0, 1);
+    ASSERT_NE(nullptr, tokyo);
+    EXPECT_DOUBLE_EQ(3.25, tokyo->score);
+    EXPECT_EQ(12u, tokyo->frequency);
+    EXPECT_EQ(10u, tokyo->count);
+    EXPECT_EQ(4u, tokyo->first);
+    EXPECT_EQ(6u, tokyo->distinctContexts);
+    EXPECT_EQ("東京\tの天気", tokyo->context);
+    const CachedEvidence* osaka = state.reusable("大阪", -0.5, 2);
+    ASSERT_NE(nullptr, osaka);
+    EXPECT_DOUBLE_EQ(-0.5, osaka->score);
+    std::filesystem::remove(path);
+}
+
+// Test that over a changed text evidence holds only within the tolerance
+TEST(IncrementalStateTest, ChangedTextKeepsEvidenceWithinTolerance) {
+    const std::string path = "test_incremental_tolerance.tsv";
+    {
+        IncrementalState state(path, 1, 1, 0.1);
+        state.record("東京", {4.0, 100, 100, 0, 0, ""});
+        state.record("大阪", {0.2, 2, 2, 0, 0, ""});
+        state.save();
+    }
+
+    IncrementalState state(path, 2, 1, 0.1);
+    EXPECT_FALSE(state.sameText());
+    EXPECT_NE(nullptr, state.reusable("東京", 4.3, 109));
+    EXPECT_EQ(nullptr, state.reusable("東京", 4.5, 100));
+    EXPECT_EQ(nullptr, state.reusable("東京", 4.0, 111));
+    // Small values move by at least the tolerance itself
+    EXPECT_NE(nullptr, state.reusable("大阪", 0.25, 2));
+    EXPECT_EQ(nullptr, state.reusable("大阪", 0.2, 3));
+
+    // A state of another evidence level is not used
+    IncrementalState other(path, 1, 2, 0.1);
+    EXPECT_EQ(0u, other.previousSize());
+    std::filesystem::remove(path);
+}
+
+// Test that a file that is not a state file is refused
+TEST(IncrementalStateTest, RejectsMalformedFile) {
+    const std::string path = "test_incremental_malformed.tsv";
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "ngram\tpmi\tfrequency\n";
+    }
+    EXPECT_THROW(IncrementalState(path, 0, 1, 0.05), std::runtime_error);
+    {
+        std::ofstream file(path, std::ios::trunc);
+        file << "# suzume-feedmill word-extract state v1 text_hash=00000000000000ff evidence=1\n"
+             << "text\tscore\tfrequency\tcount\tfirst\tdistinct_contexts\tcontext\n"
+             << "東京\tx\t1\t1\t0\t0\t\n";
+    }
+    EXPECT_THROW(IncrementalState(path, 0xff, 1, 0.05), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+// Test that a file hash equals the hash of its contents in memory
+TEST(IncrementalStateTest, HashesFileBlockByBlock) {
+    const std::string path = "test_incremental_hash.txt";
+    std::string text;
+    for (int i = 0; i < 200000; ++i) {
+        text += "東京の天気は晴れ\n";
+    }
+    {
+        std::ofstream file(path, std::ios::binary);
+        file << text;
+    }
+    uint64_t hash = IncrementalState::hashFile(path);
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::app);
+        file << "!";
+    }
+    EXPECT_NE(hash, IncrementalState::hashFile(path));
+    EXPECT_THROW(IncrementalState::hashFile("non_existent_text.txt"), std::runtime_error);
+    std::filesystem::remove(path);
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
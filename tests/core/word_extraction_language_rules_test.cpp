@@ -0,0 +1,87 @@
+/**
+ * @file word_extraction_language_rules_test.cpp
+ * @brief Tests for code point classes and language rules
+ */
+
+#include <gtest/gtest.h>
+#include <string>
+#include "../../src/core/word_extraction/language_rules.h"
+
+namespace suzume {
+namespace core {
+namespace test {
+
+// Test that code points fall into the expected classes
+TEST(LanguageRulesTest, ClassifiesCodePoints) {
+    EXPECT_EQ(classifyCodePoint(U'あ'), CharClass::Hiragana);
+    EXPECT_EQ(classifyCodePoint(U'ア'), CharClass::Katakana);
+    EXPECT_EQ(classifyCodePoint(U'ー'), CharClass::Katakana);
+    EXPECT_EQ(classifyCodePoint(U'ｱ'), CharClass::Katakana);
+    EXPECT_EQ(classifyCodePoint(U'学'), CharClass::Kanji);
+    EXPECT_EQ(classifyCodePoint(U'々'), CharClass::Kanji);
+    EXPECT_EQ(classifyCodePoint(U'𠮷'), CharClass::Kanji);
+    EXPECT_EQ(classifyCodePoint(U'A'), CharClass::Latin);
+    EXPECT_EQ(classifyCodePoint(U'é'), CharClass::Latin);
+    EXPECT_EQ(classifyCodePoint(U'Ｚ'), CharClass::Latin);
+    EXPECT_EQ(classifyCodePoint(U'7'), CharClass::Digit);
+    EXPECT_EQ(classifyCodePoint(U'７'), CharClass::Digit);
+    EXPECT_EQ(classifyCodePoint(U'!'), CharClass::Symbol);
+    EXPECT_EQ(classifyCodePoint(U'、'), CharClass::Symbol);
+    EXPECT_EQ(classifyCodePoint(U'×'), CharClass::Symbol);
+    EXPECT_EQ(classifyCodePoint(U' '), CharClass::Space);
+    EXPECT_EQ(classifyCodePoint(U'　'), CharClass::Space);
+    EXPECT_EQ(classifyCodePoint(U'한'), CharClass::Other);
+}
+
+// Test that a text is validated and counted per class in one pass
+TEST(LanguageRulesTest, ProfilesText) {
+    TextProfile profile = profileText("AI研究のデータ2024");
+    EXPECT_TRUE(profile.validUtf8);
+    EXPECT_EQ(profile.codePoints, 12u);
+    EXPECT_EQ(profile.count(CharClass::Latin), 2u);
+    EXPECT_EQ(profile.count(CharClass::Kanji), 2u);
+    EXPECT_EQ(profile.count(CharClass::Hiragana), 1u);
+    EXPECT_EQ(profile.count(CharClass::Katakana), 3u);
+    EXPECT_EQ(profile.count(CharClass::Digit), 4u);
+    EXPECT_TRUE(profileText("ひらがな").only(CharClass::Hiragana));
+    EXPECT_FALSE(profileText("").only(CharClass::Hiragana));
+
+    // Truncated, overlong, surrogate and stray continuation bytes
+    EXPECT_FALSE(profileText(std::string("学", 2)).validUtf8);
+    EXPECT_FALSE(profileText("\xC0\xAF").validUtf8);
+    EXPECT_FALSE(profileText("\xED\xA0\x80").validUtf8);
+    EXPECT_FALSE(profileText("a\x80").validUtf8);
+    EXPECT_TRUE(profileText("\xF0\xA0\xAE\xB7").validUtf8);
+}
+
+// Test that the Japanese rules find functional words and leave content words
+TEST(LanguageRulesTest, JapaneseFunctionalWords) {
+    LanguageRules rules("ja");
+    EXPECT_GT(rules.ruleCount(), 0u);
+    auto functional = [&rules](const std::string& text) {
+        return rules.isLikelyFunctional(text, profileText(text));
+    };
+
+    EXPECT_TRUE(functional("の"));
+    EXPECT_TRUE(functional("から"));
+    EXPECT_TRUE(functional("ということ"));
+    EXPECT_TRUE(functional("問題ではない"));
+    EXPECT_TRUE(functional("行きます"));
+    EXPECT_TRUE(functional("そうでしょう"));
+
+    EXPECT_FALSE(functional("学"));
+    EXPECT_FALSE(functional("機械学習"));
+    EXPECT_FALSE(functional("東京から大阪"));  // Particle rule applies to short candidates only
+    EXPECT_FALSE(functional("ですます調の文"));  // Endings count only at the end
+
+    // Regional codes share the rules of their language; other languages have none
+    LanguageRules regional("ja-JP");
+    EXPECT_EQ(regional.ruleCount(), rules.ruleCount());
+    LanguageRules english("en");
+    EXPECT_EQ(english.ruleCount(), 0u);
+    EXPECT_FALSE(english.isLikelyFunctional("から", profileText("から")));
+}
+
+} // namespace test
+} // namespace core
+} // namespace suzume
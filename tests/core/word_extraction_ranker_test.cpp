@@ -230,6 +230,39 @@ TEST_F(CandidateRankerTest, ScoreCalculation) {
     EXPECT_LT(rankedCandidates[0].score, 1.0);
 }
 
+// Test that the top-K ranking is the prefix of the full ranking
+TEST_F(CandidateRankerTest, TopCandidatesMatchFullRanking) {
+    // Enough candidates for parallel scoring, with many ties
+    std::vector<VerifiedCandidate> many;
+    for (int i = 0; i < 12000; ++i) {
+        VerifiedCandidate candidate;
+        candidate.text = "w" + std::to_string(i % 50);
+        candidate.score = (i * 7) % 13;
+        candidate.frequency = i;
+        candidate.contextScore = (i % 3) * 0.5;
+        candidate.statisticalScore = 0.25;
+        many.push_back(candidate);
+    }
+
+    for (const char* model : {"combined", ""}) {
+        options.rankingModel = model;
+        options.useParallelProcessing = false;
+        auto full = CandidateRanker(options).rankCandidates(many);
+        ASSERT_EQ(full.size(), many.size());
+
+        options.useParallelProcessing = true;
+        options.threads = 4;
+        auto top = CandidateRanker(options).rankTopCandidates(many, 100);
+        ASSERT_EQ(top.size(), 100u);
+        for (size_t i = 0; i < top.size(); ++i) {
+            EXPECT_EQ(top[i].frequency, full[i].frequency) << model << " rank " << i;
+            EXPECT_DOUBLE_EQ(top[i].score, full[i].score);
+        }
+
+        EXPECT_EQ(CandidateRanker(options).rankTopCandidates(many, 20000).size(), many.size());
+    }
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
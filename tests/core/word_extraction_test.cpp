@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <algorithm>
+#include <random>
 #include "core/word_extraction.h"
 
 namespace {
@@ -372,4 +373,78 @@ TEST_F(WordExtractionTest, BothCallbacksSet) {
     EXPECT_TRUE(!simpleProgressValues.empty() || !structuredProgressInfos.empty());
 }
 
+// Test that lazy evaluation gives the same words as evaluating every candidate
+TEST_F(WordExtractionTest, LazyEvaluationMatchesFullEvaluation) {
+    // Many candidates with spread scores, some of which are not in the text
+    const char* syllables[] = {"あ", "か", "さ", "た", "な", "は", "ま", "や", "ら", "わ", "ん", "き"};
+    std::mt19937 random(7);
+    std::string text;
+    {
+        std::ofstream file(originalTextPath_);
+        for (int line = 0; line < 200; ++line) {
+            std::string row;
+            for (int i = 0; i < 30; ++i) {
+                row += syllables[random() % 12];
+            }
+            file << row << "\n";
+            text += row;
+        }
+    }
+    {
+        std::ofstream file(pmiResultsPath_);
+        file << "ngram\tscore\tfreq\n";
+        for (int i = 0; i < 3000; ++i) {
+            std::string gram;
+            size_t length = 2 + random() % 4;
+            if (i % 4 == 0) {
+                for (size_t k = 0; k < length; ++k) {
+                    gram += syllables[random() % 12];
+                }
+            } else {
+                size_t start = (random() % (text.size() / 3 - length)) * 3;
+                gram = text.substr(start, length * 3);
+            }
+            file << gram << "\t" << (1.0 + (random() % 1500) / 100.0) << "\t" << (1 + random() % 40) << "\n";
+        }
+    }
+
+    suzume::WordExtractionOptions base;
+    base.minPmiScore = 1.0;
+    base.minScore = 0.0;
+    base.maxLength = 20;
+    base.threads = 2;
+
+    std::vector<suzume::WordExtractionOptions> variants;
+    for (uint32_t topK : {1u, 10u, 200u, 5000u}) {
+        suzume::WordExtractionOptions options = base;
+        options.topK = topK;
+        variants.push_back(options);
+        options.removeSubstrings = false;
+        options.removeOverlapping = false;
+        variants.push_back(options);
+        options.rankingModel = "pmi";
+        variants.push_back(options);
+        options.rankingModel = "combined";
+        options.useContextualAnalysis = false;
+        options.contextWeight = -0.5;
+        variants.push_back(options);
+    }
+
+    for (size_t v = 0; v < variants.size(); ++v) {
+        suzume::WordExtractionOptions lazy = variants[v];
+        lazy.lazyEvaluation = true;
+        auto expected = suzume::core::extractWords(pmiResultsPath_, originalTextPath_, variants[v]);
+        auto actual = suzume::core::extractWords(pmiResultsPath_, originalTextPath_, lazy);
+        EXPECT_EQ(actual.words, expected.words) << "variant " << v;
+        EXPECT_EQ(actual.scores, expected.scores) << "variant " << v;
+        EXPECT_EQ(actual.frequencies, expected.frequencies) << "variant " << v;
+        EXPECT_EQ(actual.contexts, expected.contexts) << "variant " << v;
+    }
+
+    suzume::WordExtractionOptions streaming = base;
+    streaming.lazyEvaluation = true;
+    streaming.streamingVerification = true;
+    EXPECT_THROW(suzume::core::extractWords(pmiResultsPath_, originalTextPath_, streaming), std::invalid_argument);
+}
+
 } // namespace
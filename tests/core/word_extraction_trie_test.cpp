@@ -164,6 +164,60 @@ TEST_F(NGramTrieTest, JapaneseText) {
     ASSERT_EQ(results.size(), 2);
 }
 
+// Test that shared prefixes share nodes and re-adding replaces the payload
+TEST_F(NGramTrieTest, CompactStorage) {
+    NGramTrie compact;
+    compact.add("abc", 1.0, 1);
+    compact.add("abd", 2.0, 2);
+    compact.add("ab", 3.0, 3);
+    compact.add("abc", 4.0, 4);
+
+    // Root + a + b + c + d
+    EXPECT_EQ(compact.getNodeCount(), 5u);
+
+    // Results come back in byte order of the keys
+    auto results = compact.findByPrefix("a");
+    ASSERT_EQ(results.size(), 3u);
+    EXPECT_EQ(std::get<0>(results[0]), "ab");
+    EXPECT_EQ(std::get<0>(results[1]), "abc");
+    EXPECT_DOUBLE_EQ(std::get<1>(results[1]), 4.0);
+    EXPECT_EQ(std::get<2>(results[1]), 4u);
+    EXPECT_EQ(std::get<0>(results[2]), "abd");
+
+    EXPECT_TRUE(compact.findByPrefix("abcd").empty());
+    EXPECT_EQ(compact.findByPrefix("").size(), 3u);
+}
+
+// Test a trie with reversed keys answering suffix queries
+TEST_F(NGramTrieTest, ReversedKeys) {
+    NGramTrie reversed(NGramTrie::KeyOrder::Reversed);
+    reversed.add("機械学習", 5.0, 10);
+    reversed.add("深層学習", 4.0, 8);
+    reversed.add("学習者", 3.0, 5);
+    reversed.add("world", 6.0, 12);
+
+    auto results = reversed.findBySuffix("学習");
+    ASSERT_EQ(results.size(), 2u);
+    for (const auto& [text, score, freq] : results) {
+        EXPECT_TRUE(text == "機械学習" || text == "深層学習") << text;
+        EXPECT_DOUBLE_EQ(score, text == "機械学習" ? 5.0 : 4.0);
+    }
+
+    EXPECT_EQ(reversed.findBySuffix("ld").size(), 1u);
+    EXPECT_EQ(reversed.findBySuffix("").size(), 4u);
+    EXPECT_TRUE(reversed.findBySuffix("機械").empty());
+
+    // Byte suffixes that cut a code point still match byte-wise
+    std::string tail = std::string("習").substr(1);
+    EXPECT_EQ(reversed.findBySuffix(tail).size(), 2u);
+    EXPECT_TRUE(reversed.findBySuffix(std::string("習").substr(0, 1)).empty());
+
+    // Prefix queries still work, by traversal
+    results = reversed.findByPrefix("学習");
+    ASSERT_EQ(results.size(), 1u);
+    EXPECT_EQ(std::get<0>(results[0]), "学習者");
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
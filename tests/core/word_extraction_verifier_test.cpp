@@ -4,6 +4,7 @@
  */
 
 #include <gtest/gtest.h>
+#include <filesystem>
 #include <fstream>
 #include <string>
 #include <vector>
@@ -443,6 +444,274 @@ TEST_F(CandidateVerifierTest, UTF8ContextExtraction) {
     std::remove(utf8TestPath.c_str());
 }
 
+// Test that the single-pass batch mode matches per-candidate lookups
+TEST_F(CandidateVerifierTest, BatchVerificationMatchesIndexedLookup) {
+    // Several MiB so the batch scan is split into chunks
+    std::string batchTextPath = "test_batch_verification.txt";
+    {
+        std::ofstream file(batchTextPath);
+        for (int i = 0; i < 40000; ++i) {
+            file << "人工知能と機械学習の研究が進んでいます。abababab " << i << "\n";
+            if (i % 7 == 0) {
+                file << "深層学習を用いた自然言語処理技術の開発。\n";
+            }
+        }
+    }
+
+    std::vector<WordCandidate> batchCandidates = candidates;
+    for (const char* text : {"abab", "学習", "深層学習", "処理技術の開発。\n深層", "9\n", "研究"}) {
+        WordCandidate candidate;
+        candidate.text = text;
+        candidate.score = 3.0;
+        candidate.frequency = 5;
+        batchCandidates.push_back(candidate);
+    }
+    batchCandidates.push_back(batchCandidates[3]);
+
+    options.threads = 4;
+    CandidateVerifier indexed(options);
+    auto expected = indexed.verifyCandidates(batchCandidates, batchTextPath);
+
+    // Without multi-line patterns the scan runs on line-aligned chunks
+    options.batchVerification = true;
+    for (bool multiLine : {true, false}) {
+        std::vector<WordCandidate> input = batchCandidates;
+        if (!multiLine) {
+            input.erase(std::remove_if(input.begin(), input.end(), [](const WordCandidate& c) {
+                return c.text.find('\n') != std::string::npos;
+            }), input.end());
+        }
+        auto reference = multiLine ? expected : indexed.verifyCandidates(input, batchTextPath);
+        CandidateVerifier batch(options);
+        auto actual = batch.verifyCandidates(input, batchTextPath);
+
+        ASSERT_EQ(actual.size(), reference.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].text, reference[i].text);
+            EXPECT_EQ(actual[i].context, reference[i].context);
+            EXPECT_DOUBLE_EQ(actual[i].contextScore, reference[i].contextScore);
+            EXPECT_DOUBLE_EQ(actual[i].statisticalScore, reference[i].statisticalScore);
+        }
+    }
+
+    std::remove(batchTextPath.c_str());
+}
+
+// Test that block-by-block verification matches the whole-text index
+TEST_F(CandidateVerifierTest, StreamingVerificationMatchesIndexedLookup) {
+    std::string streamTextPath = "test_streaming_verification.txt";
+    {
+        std::ofstream file(streamTextPath);
+        for (int i = 0; i < 300; ++i) {
+            file << "人工知能と機械学習の研究が進んでいます。abababab " << i << "\n";
+            if (i % 7 == 0) {
+                file << "深層学習を用いた自然言語処理技術の開発。\n";
+            }
+        }
+    }
+
+    std::vector<WordCandidate> streamCandidates = candidates;
+    for (const char* text : {"abab", "学習", "深層学習", "処理技術の開発。\n深層", "9\n", "研究", "299\n"}) {
+        WordCandidate candidate;
+        candidate.text = text;
+        candidate.score = 3.0;
+        candidate.frequency = 5;
+        streamCandidates.push_back(candidate);
+    }
+    streamCandidates.push_back(streamCandidates[3]);
+    auto expected = CandidateVerifier(options).verifyCandidates(streamCandidates, streamTextPath);
+
+    // Blocks shorter than a candidate or a context still give the same results
+    options.streamingVerification = true;
+    for (uint64_t blockSize : {1, 7, 100, 4096, 1 << 20}) {
+        options.verificationBlockSize = blockSize;
+        auto actual = CandidateVerifier(options).verifyCandidates(streamCandidates, streamTextPath);
+
+        ASSERT_EQ(actual.size(), expected.size()) << "block size " << blockSize;
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].text, expected[i].text);
+            EXPECT_EQ(actual[i].context, expected[i].context) << "block size " << blockSize;
+            EXPECT_DOUBLE_EQ(actual[i].contextScore, expected[i].contextScore);
+            EXPECT_DOUBLE_EQ(actual[i].statisticalScore, expected[i].statisticalScore);
+        }
+    }
+
+    EXPECT_THROW(CandidateVerifier(options).verifyCandidates(streamCandidates, "non_existent_file.txt"),
+                 std::runtime_error);
+    std::remove(streamTextPath.c_str());
+}
+
+// Test that a kept suffix array file gives the same results and is reused
+TEST_F(CandidateVerifierTest, TextIndexFileIsReused) {
+    std::string indexPath = originalTextPath_ + ".sfx";
+    std::remove(indexPath.c_str());
+    auto expected = verifier->verifyCandidates(candidates, originalTextPath_);
+
+    options.textIndexPath = indexPath;
+    auto first = CandidateVerifier(options).verifyCandidates(candidates, originalTextPath_);
+    ASSERT_TRUE(std::filesystem::exists(indexPath));
+    auto written = std::filesystem::last_write_time(indexPath);
+    auto second = CandidateVerifier(options).verifyCandidates(candidates, originalTextPath_);
+    EXPECT_EQ(std::filesystem::last_write_time(indexPath), written);
+
+    for (const auto* actual : {&first, &second}) {
+        ASSERT_EQ(actual->size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ((*actual)[i].text, expected[i].text);
+            EXPECT_EQ((*actual)[i].context, expected[i].context);
+            EXPECT_DOUBLE_EQ((*actual)[i].contextScore, expected[i].contextScore);
+        }
+    }
+    std::remove(indexPath.c_str());
+}
+
+// Test that parallel verification keeps the sequential order and results
+TEST_F(CandidateVerifierTest, ParallelVerificationMatchesSequential) {
+    std::vector<WordCandidate> many;
+    const std::vector<std::string> words = {"機械学習", "人工知能", "深層学習", "存在しない", "研究", "開発者"};
+    for (int i = 0; i < 500; ++i) {
+        WordCandidate candidate;
+        candidate.text = words[i % words.size()];
+        candidate.score = i;
+        candidate.frequency = i % 30;
+        many.push_back(candidate);
+    }
+
+    options.useParallelProcessing = false;
+    auto sequential = CandidateVerifier(options).verifyCandidates(many, originalTextPath_);
+
+    options.useParallelProcessing = true;
+    options.threads = 4;
+    std::vector<double> progressValues;
+    auto parallel = CandidateVerifier(options).verifyCandidates(many, originalTextPath_, [&](double progress) {
+        progressValues.push_back(progress);
+    });
+
+    ASSERT_EQ(parallel.size(), sequential.size());
+    for (size_t i = 0; i < parallel.size(); ++i) {
+        EXPECT_EQ(parallel[i].text, sequential[i].text);
+        EXPECT_DOUBLE_EQ(parallel[i].score, sequential[i].score);
+        EXPECT_EQ(parallel[i].context, sequential[i].context);
+        EXPECT_DOUBLE_EQ(parallel[i].statisticalScore, sequential[i].statisticalScore);
+    }
+    ASSERT_FALSE(progressValues.empty());
+    EXPECT_TRUE(std::is_sorted(progressValues.begin(), progressValues.end()));
+    EXPECT_DOUBLE_EQ(progressValues.back(), 1.0);
+}
+
+// Test that PMI statistics verify candidates as a search of the text would
+TEST_F(CandidateVerifierTest, PmiStatsMatchIndexedLookup) {
+    std::vector<WordCandidate> statsCandidates = candidates;
+    for (const char* text : {"研究", "学習", "開発者", "ています。"}) {
+        WordCandidate candidate;
+        candidate.text = text;
+        candidate.score = 3.0;
+        candidate.frequency = 5;
+        statsCandidates.push_back(candidate);
+    }
+    auto expected = verifier->verifyCandidates(statsCandidates, originalTextPath_);
+
+    // "開発者" is left out of the statistics and counted in the text instead
+    std::vector<PmiItem> items;
+    for (const auto& candidate : statsCandidates) {
+        if (candidate.text != "開発者") {
+            items.push_back({candidate.text, candidate.score, candidate.frequency});
+        }
+    }
+    std::ifstream file(originalTextPath_, std::ios::binary);
+    std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::string statsPath = "test_pmi_stats.tsv";
+    writeNgramStats(statsPath, text, items, 1);
+
+    options.pmiStatsPath = statsPath;
+    for (bool parallel : {false, true}) {
+        options.useParallelProcessing = parallel;
+        auto actual = CandidateVerifier(options).verifyCandidates(statsCandidates, originalTextPath_);
+        ASSERT_EQ(actual.size(), expected.size());
+        for (size_t i = 0; i < actual.size(); ++i) {
+            EXPECT_EQ(actual[i].text, expected[i].text);
+            EXPECT_EQ(actual[i].context, expected[i].context);
+            EXPECT_DOUBLE_EQ(actual[i].contextScore, expected[i].contextScore);
+        }
+    }
+
+    // Statistics of another text are refused
+    std::string otherTextPath = "test_pmi_stats_other.txt";
+    {
+        std::ofstream other(otherTextPath);
+        other << text << "追加の行\n";
+    }
+    EXPECT_THROW(CandidateVerifier(options).verifyCandidates(statsCandidates, otherTextPath), std::runtime_error);
+    std::remove(otherTextPath.c_str());
+    std::remove(statsPath.c_str());
+}
+
+// Test that an incremental state reuses the evidence of unchanged candidates only
+TEST_F(CandidateVerifierTest, IncrementalStateReusesEvidence) {
+    std::string statePath = "test_incremental.state";
+    std::remove(statePath.c_str());
+    auto expected = verifier->verifyCandidates(candidates, originalTextPath_);
+
+    options.incrementalStatePath = statePath;
+    CandidateVerifier first(options);
+    auto initial = first.verifyCandidates(candidates, originalTextPath_);
+    EXPECT_EQ(0u, first.reusedCandidates());
+    ASSERT_TRUE(std::filesystem::exists(statePath));
+
+    // Over the same text every candidate is reused, with the same results
+    CandidateVerifier second(options);
+    auto rerun = second.verifyCandidates(candidates, originalTextPath_);
+    EXPECT_EQ(candidates.size(), second.reusedCandidates());
+    for (const auto* actual : {&initial, &rerun}) {
+        ASSERT_EQ(actual->size(), expected.size());
+        for (size_t i = 0; i < expected.size(); ++i) {
+            EXPECT_EQ((*actual)[i].text, expected[i].text);
+            EXPECT_EQ((*actual)[i].context, expected[i].context);
+            EXPECT_DOUBLE_EQ((*actual)[i].contextScore, expected[i].contextScore);
+            EXPECT_DOUBLE_EQ((*actual)[i].statisticalScore, expected[i].statisticalScore);
+        }
+    }
+
+    // Over a changed text only candidates whose score and frequency held are reused
+    std::string changedTextPath = "test_incremental_changed.txt";
+    {
+        std::ifstream file(originalTextPath_, std::ios::binary);
+        std::ofstream changed(changedTextPath, std::ios::binary);
+        changed << file.rdbuf() << "追加の行\n";
+    }
+    std::vector<WordCandidate> changed = candidates;
+    changed[0].frequency *= 2;
+    WordCandidate added;
+    added.text = "研究";
+    added.score = 3.0;
+    added.frequency = 5;
+    changed.push_back(added);
+
+    CandidateVerifier third(options);
+    third.verifyCandidates(changed, changedTextPath);
+    EXPECT_EQ(candidates.size() - 1, third.reusedCandidates());
+
+    // The rewritten state covers this run's candidates
+    CandidateVerifier fourth(options);
+    fourth.verifyCandidates(changed, changedTextPath);
+    EXPECT_EQ(changed.size(), fourth.reusedCandidates());
+
+    options.incrementalTolerance = 2.0;
+    changed[1].score *= 2;
+    CandidateVerifier tolerant(options);
+    tolerant.verifyCandidates(changed, originalTextPath_);
+    EXPECT_EQ(changed.size(), tolerant.reusedCandidates());
+
+    // A state gathered with contexts is not reused without them
+    options.useContextualAnalysis = false;
+    CandidateVerifier noContexts(options);
+    noContexts.verifyCandidates(changed, originalTextPath_);
+    EXPECT_EQ(0u, noContexts.reusedCandidates());
+
+    std::remove(changedTextPath.c_str());
+    std::remove(statePath.c_str());
+}
+
 } // namespace test
 } // namespace core
 } // namespace suzume
@@ -116,6 +116,30 @@ TEST_F(FileIOTest, ProcessLineByLineWithProgress) {
     ASSERT_EQ(3, lines.size());
 }
 
+// Test processing lines as views, with CRLF endings stripped
+TEST_F(FileIOTest, ProcessLineViews) {
+    std::ofstream crlfFile("test_data/file_io_test_crlf.txt", std::ios::binary);
+    crlfFile << "Line 1\r\nLine 2\r\n\r\nLine 4";
+    crlfFile.close();
+
+    std::vector<std::string> lines;
+    double lastProgress = 0.0;
+    TextFileReader::processLineViews(
+        "test_data/file_io_test_crlf.txt",
+        [&lines](std::string_view line) {
+            lines.emplace_back(line);
+        },
+        [&lastProgress](double progress) {
+            EXPECT_GE(progress, lastProgress);
+            lastProgress = progress;
+        }
+    );
+
+    EXPECT_EQ(1.0, lastProgress);
+    EXPECT_EQ(lines, (std::vector<std::string>{"Line 1", "Line 2", "", "Line 4"}));
+    EXPECT_EQ(lines, TextFileReader::readAllLines("test_data/file_io_test_crlf.txt"));
+}
+
 // Test reading file content
 TEST_F(FileIOTest, ReadFileContent) {
     // Read file content
@@ -0,0 +1,120 @@
+/**
+ * @file thread_pool_test.cpp
+ * @brief Tests for the work-stealing thread pool
+ */
+
+#include <gtest/gtest.h>
+#include <atomic>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "parallel/executor.h"
+#include "parallel/thread_pool.h"
+
+namespace suzume {
+namespace parallel {
+namespace test {
+
+// Test that every task of a group runs exactly once
+TEST(ThreadPoolTest, RunsEveryTask) {
+    ThreadPool pool(3);
+    std::vector<std::atomic<int>> runs(1000);
+    TaskGroup group(pool);
+    for (size_t i = 0; i < runs.size(); ++i) {
+        group.run([&runs, i]() { runs[i]++; });
+    }
+    group.wait();
+    for (const auto& count : runs) {
+        EXPECT_EQ(1, count.load());
+    }
+}
+
+// Test that the first exception reaches wait() and unstarted tasks are skipped
+TEST(ThreadPoolTest, PropagatesExceptions) {
+    ThreadPool pool(1);
+    std::atomic<int> ran(0);
+    TaskGroup group(pool);
+    group.run([]() { throw std::runtime_error("task failed"); });
+    while (!group.failed()) {
+        group.runPending();
+    }
+    for (int i = 0; i < 100; ++i) {
+        group.run([&ran]() { ran++; });
+    }
+    try {
+        group.wait();
+        FAIL() << "Exception should have been thrown";
+    } catch (const std::runtime_error& e) {
+        EXPECT_EQ(std::string("task failed"), e.what());
+    }
+    EXPECT_EQ(0, ran.load());
+
+    // The group is reusable once the failure has been reported
+    group.run([&ran]() { ran = -1; });
+    EXPECT_NO_THROW(group.wait());
+    EXPECT_EQ(-1, ran.load());
+}
+
+// Test that groups nested deeper than the pool is wide still finish
+TEST(ThreadPoolTest, NestedGroupsDoNotDeadlock) {
+    ThreadPool pool(1);
+    std::atomic<int> leaves(0);
+    TaskGroup outer(pool);
+    for (int i = 0; i < 4; ++i) {
+        outer.run([&]() {
+            TaskGroup inner(pool);
+            for (int j = 0; j < 8; ++j) {
+                inner.run([&]() { leaves++; });
+            }
+            inner.wait();
+        });
+    }
+    outer.wait();
+    EXPECT_EQ(32, leaves.load());
+}
+
+// Test that parallelFor covers every index once with dynamic ranges
+TEST(ThreadPoolTest, ParallelForCoversRange) {
+    std::vector<int> hits(10007, 0);
+    ParallelExecutor::parallelFor(hits.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            hits[i]++;
+        }
+    }, 4, 13);
+    for (int hit : hits) {
+        EXPECT_EQ(1, hit);
+    }
+
+    EXPECT_THROW(ParallelExecutor::parallelFor(100, [](size_t begin, size_t) {
+        if (begin >= 50) {
+            throw std::invalid_argument("bad range");
+        }
+    }, 4, 1), std::invalid_argument);
+}
+
+// Test that range reduction combines partial results in index order
+TEST(ThreadPoolTest, ParallelReduceKeepsOrder) {
+    std::string expected;
+    for (int i = 0; i < 5000; ++i) {
+        expected += static_cast<char>('a' + i % 26);
+    }
+    std::string joined = ParallelExecutor::parallelReduce<std::string>(
+        expected.size(), std::string(),
+        [&](size_t begin, size_t end) { return expected.substr(begin, end - begin); },
+        [](std::string a, std::string b) { return a + b; },
+        4);
+    EXPECT_EQ(expected, joined);
+
+    std::vector<long> values(100000);
+    std::iota(values.begin(), values.end(), 1);
+    long sum = ParallelExecutor::parallelReduce<long>(
+        values.size(), 0,
+        [&](size_t begin, size_t end) { return std::accumulate(values.begin() + begin, values.begin() + end, 0L); },
+        [](long a, long b) { return a + b; });
+    EXPECT_EQ(5000050000L, sum);
+}
+
+} // namespace test
+} // namespace parallel
+} // namespace suzume
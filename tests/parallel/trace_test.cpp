@@ -0,0 +1,95 @@
+/**
+ * @file trace_test.cpp
+ * @brief Tests for Chrome trace recording
+ */
+
+#include <gtest/gtest.h>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include "parallel/thread_pool.h"
+#include "parallel/trace.h"
+
+namespace suzume {
+namespace parallel {
+namespace test {
+
+namespace {
+
+std::string readFile(const std::string& path) {
+    std::ifstream file(path);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t count = 0;
+    for (size_t at = text.find(needle); at != std::string::npos; at = text.find(needle, at + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+// Test that tasks, scopes and phases become complete events on named tracks
+TEST(TraceTest, RecordsTasksScopesAndPhases) {
+    std::filesystem::create_directories("test_data");
+    const std::string path = "test_data/trace.json";
+
+    ThreadPool pool(2);
+    startTrace();
+    EXPECT_TRUE(tracing());
+    {
+        TraceScope scope("outer \"op\"", "operation");
+        TaskGroup group("unit", pool);
+        for (int i = 0; i < 8; ++i) {
+            group.run([]() {});
+        }
+        group.wait();
+    }
+    TraceClock::time_point now = TraceClock::now();
+    traceSpan("counting", "phase", now - std::chrono::milliseconds(2), now, true);
+    stopTrace(path);
+    EXPECT_FALSE(tracing());
+
+    std::string trace = readFile(path);
+    EXPECT_EQ(0u, trace.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["));
+    EXPECT_EQ(8u, countOf(trace, "{\"name\":\"unit\",\"cat\":\"task\",\"ph\":\"X\""));
+    EXPECT_EQ(1u, countOf(trace, "{\"name\":\"outer \\\"op\\\"\",\"cat\":\"operation\""));
+    size_t phase = trace.find("{\"name\":\"counting\",\"cat\":\"phase\",\"ph\":\"X\"");
+    ASSERT_NE(std::string::npos, phase);
+    EXPECT_EQ(trace.find(",\"tid\":0}", phase), trace.find('}', phase) - 8);
+    EXPECT_NE(std::string::npos, trace.find("\"tid\":0,\"args\":{\"name\":\"phases\"}"));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"main\"}"));
+    EXPECT_NE(std::string::npos, trace.find("\"args\":{\"name\":\"worker 0\"}"));
+    EXPECT_EQ(countOf(trace, "{"), countOf(trace, "}"));
+    EXPECT_EQ("]}\n", trace.substr(trace.size() - 3));
+
+    EXPECT_THROW(stopTrace(path), std::runtime_error);
+}
+
+// Test that nothing is kept while tracing is off and a new trace starts empty
+TEST(TraceTest, RecordsNothingWhenDisabled) {
+    const std::string path = "test_data/trace_disabled.json";
+
+    ThreadPool pool(2);
+    {
+        TraceScope scope("before");
+        TaskGroup group("untraced", pool);
+        group.run([]() {});
+        group.wait();
+    }
+    startTrace();
+    stopTrace(path);
+
+    std::string trace = readFile(path);
+    EXPECT_EQ(std::string::npos, trace.find("\"before\""));
+    EXPECT_EQ(std::string::npos, trace.find("\"untraced\""));
+    EXPECT_EQ(std::string::npos, trace.find("\"ph\":\"X\""));
+}
+
+} // namespace test
+} // namespace parallel
+} // namespace suzume